@@ -18,8 +18,11 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <math.h>
+#include <fenv.h>
 #include <bitset>
 #include <chrono>
+#include <atomic>
+#include <vector>
 
 #ifdef _WIN32
 #include <intrin.h>
@@ -27,6 +30,7 @@
 
 #include <djl_128.hxx>
 #include <djltrace.hxx>
+#include <djl_hash.hxx>
 
 #include "arm64.hxx"
 
@@ -41,3874 +45,6566 @@ using namespace std::chrono;
 static const uint64_t g_ui64_NAN = 0x7ff8000000000000;
 #define MY_NAN ( * (double *) & g_ui64_NAN )
 
-static uint64_t g_State = 0;
+// Host SIMD kernels for the most common Advanced SIMD integer operations. glibc's string functions live on
+// these. x64 hosts use SSE2, Arm64 hosts use NEON, and other little-endian hosts use 64-bit SWAR arithmetic.
+// Each returns false for element sizes it doesn't handle so the caller falls back to its per-element loop.
+// Q is 0 for 64-bit vectors; the upper half of the result is then zeroed like the instructions require.
+// Build with -DARM64_NO_HOST_SIMD to get the portable versions on any host.
+
+#if !defined( TARGET_BIG_ENDIAN ) && !defined( ARM64_NO_HOST_SIMD ) && ( defined( __SSE2__ ) || defined( _M_X64 ) )
+    #define ARM64_SIMD_SSE2
+    #include <emmintrin.h>
+#elif !defined( TARGET_BIG_ENDIAN ) && !defined( ARM64_NO_HOST_SIMD ) && ( defined( __ARM_NEON ) || defined( _M_ARM64 ) )
+    #define ARM64_SIMD_NEON
+    #include <arm_neon.h>
+#endif
 
-const uint64_t stateTraceInstructions = 1;
-const uint64_t stateEndEmulation = 2;
+enum VectorCompare { vc_eq, vc_hi, vc_hs }; // CMEQ, CMHI, CMHS
 
-bool Arm64::trace_instructions( bool t )
+#if defined( ARM64_SIMD_SSE2 )
+
+static inline __m128i vec_load( const vec16_t & v ) { return _mm_loadu_si128( (const __m128i *) & v ); }
+static inline void vec_store( vec16_t & v, __m128i x, uint64_t Q ) { _mm_storeu_si128( (__m128i *) & v, Q ? x : _mm_move_epi64( x ) ); }
+
+static bool vec_add( vec16_t & d, const vec16_t & n, const vec16_t & m, uint64_t ebytes, uint64_t Q, bool subtract )
 {
-    bool prev = ( 0 != ( g_State & stateTraceInstructions ) );
-    if ( t )
-        g_State |= stateTraceInstructions;
+    __m128i a = vec_load( n );
+    __m128i b = vec_load( m );
+    __m128i r;
+
+    if ( 1 == ebytes )
+        r = subtract ? _mm_sub_epi8( a, b ) : _mm_add_epi8( a, b );
+    else if ( 2 == ebytes )
+        r = subtract ? _mm_sub_epi16( a, b ) : _mm_add_epi16( a, b );
+    else if ( 4 == ebytes )
+        r = subtract ? _mm_sub_epi32( a, b ) : _mm_add_epi32( a, b );
     else
-        g_State &= ~stateTraceInstructions;
-    return prev;
-} //trace_instructions
+        r = subtract ? _mm_sub_epi64( a, b ) : _mm_add_epi64( a, b );
 
-void Arm64::end_emulation() { g_State |= stateEndEmulation; }
+    vec_store( d, r, Q );
+    return true;
+} //vec_add
 
-template <class T> T do_abs( T x )
+static bool vec_compare( vec16_t & d, const vec16_t & n, const vec16_t & m, uint64_t ebytes, uint64_t Q, VectorCompare kind )
 {
-    return ( x < 0 ) ? -x : x;
-} //do_abs
+    if ( 8 == ebytes ) // 64-bit compares need SSE4
+        return false;
 
-void Arm64::set_flags_from_nzcv( uint64_t nzcv )
-{
-    fN = ( 0 != ( nzcv & 8 ) );
-    fZ = ( 0 != ( nzcv & 4 ) );
-    fC = ( 0 != ( nzcv & 2 ) );
-    fV = ( 0 != ( nzcv & 1 ) );
-} //set_flags_from_nzcv
+    __m128i a = vec_load( n );
+    __m128i b = vec_load( m );
+    __m128i r;
 
-uint16_t consider_endian16( uint16_t x )
-{
-#ifdef TARGET_BIG_ENDIAN
-    return flip_endian16( x );
-#endif
-    return x;
-} //consider_endian16
+    if ( vc_eq == kind )
+        r = ( 1 == ebytes ) ? _mm_cmpeq_epi8( a, b ) : ( 2 == ebytes ) ? _mm_cmpeq_epi16( a, b ) : _mm_cmpeq_epi32( a, b );
+    else
+    {
+        // SSE2 only has signed compares. flipping the sign bits makes them unsigned. hs is !( b > a )
 
-uint32_t consider_endian32( uint32_t x )
-{
-#ifdef TARGET_BIG_ENDIAN
-    return flip_endian32( x );
-#endif
-    return x;
-} //consider_endian32
+        __m128i bias = ( 1 == ebytes ) ? _mm_set1_epi8( (char) 0x80 ) : ( 2 == ebytes ) ? _mm_set1_epi16( (short) 0x8000 ) : _mm_set1_epi32( (int) 0x80000000 );
+        a = _mm_xor_si128( a, bias );
+        b = _mm_xor_si128( b, bias );
+        if ( vc_hs == kind )
+        {
+            __m128i t = a;
+            a = b;
+            b = t;
+        }
 
-uint64_t consider_endian64( uint64_t x )
-{
-#ifdef TARGET_BIG_ENDIAN
-    return flip_endian64( x );
-#endif
-    return x;
-} //consider_endian64
+        r = ( 1 == ebytes ) ? _mm_cmpgt_epi8( a, b ) : ( 2 == ebytes ) ? _mm_cmpgt_epi16( a, b ) : _mm_cmpgt_epi32( a, b );
+        if ( vc_hs == kind )
+            r = _mm_xor_si128( r, _mm_set1_epi32( -1 ) );
+    }
 
-static __inline_perf void mcpy( void * d, const void * s, const size_t c ) // memcpy but optimized for small sizes
+    vec_store( d, r, Q );
+    return true;
+} //vec_compare
+
+static bool vec_minmaxv8( uint8_t & result, const vec16_t & n, uint64_t Q, bool is_min )
 {
-    assert( 1 == c || 2 == c || 4 == c || 8 == c || 16 == c );
+    __m128i v = vec_load( n );
+    if ( !Q )
+        v = _mm_unpacklo_epi64( v, v ); // duplicating the lower half doesn't change the answer
 
-    // I tried various permutations and this was fastest for msft c++, clang, and g++. loops fail with the latter two
-    if ( 1 == c )
-        * ( (uint8_t *) d ) = * ( (uint8_t *) s );
-    else if ( 2 == c )
-        * ( (uint16_t *) d ) = * ( (uint16_t *) s );
-    else if ( 4 == c )
-        * ( (uint32_t *) d ) = * ( (uint32_t *) s );
+    if ( is_min )
+    {
+        v = _mm_min_epu8( v, _mm_srli_si128( v, 8 ) );
+        v = _mm_min_epu8( v, _mm_srli_si128( v, 4 ) );
+        v = _mm_min_epu8( v, _mm_srli_si128( v, 2 ) );
+        v = _mm_min_epu8( v, _mm_srli_si128( v, 1 ) );
+    }
     else
     {
-        * ( (uint64_t *) d ) = * ( (uint64_t *) s );
-        if ( 16 == c )
-            * ( (uint64_t *) d + 1 ) = * ( (uint64_t *) s + 1 );
+        v = _mm_max_epu8( v, _mm_srli_si128( v, 8 ) );
+        v = _mm_max_epu8( v, _mm_srli_si128( v, 4 ) );
+        v = _mm_max_epu8( v, _mm_srli_si128( v, 2 ) );
+        v = _mm_max_epu8( v, _mm_srli_si128( v, 1 ) );
     }
-} //mcpy
 
-static uint64_t count_bits( uint64_t x )
+    result = (uint8_t) _mm_cvtsi128_si32( v );
+    return true;
+} //vec_minmaxv8
+
+static bool vec_minmaxp8( vec16_t & d, const vec16_t & n, const vec16_t & m, uint64_t Q, bool is_min )
 {
-#ifdef _M_AMD64
-        return __popcnt64( x ); // less portable, but faster. Not on Q9650 CPU and other older Intel CPUs. use code below instead if needed.
-#elif defined( __aarch64__ )
-        return std::bitset<64>( x ).count();
-#else
-    uint64_t count = 0;
-    while ( 0 != x )
+    __m128i a = vec_load( n );
+    __m128i b = vec_load( m );
+    if ( !Q )
     {
-        if ( x & 1 )
-            count++;
-        x >>= 1;
+        a = _mm_unpacklo_epi64( a, b ); // the 8 results come from the lower halves of n then m
+        b = _mm_setzero_si128();
     }
-    return count;
-#endif
-} //count_bits
 
-static uint32_t count_leading_zeroes32( uint32_t x )
-{
-#ifdef _WIN32 // if targeting older CPUs you may need to rebuild with the manual code below
-    DWORD lz = 0;
-    if ( _BitScanReverse( &lz, x ) )
-        return 31 - lz;
-    return 32;
-#elif defined( __GNUC__ ) || defined( __clang__ )
-    return __builtin_clz( x );
-#else
-    uint32_t count = 0;
-    while ( x )
+    // each 16-bit lane gets the min or max of its byte pair in its low byte, then the low bytes are packed
+
+    __m128i lowbytes = _mm_set1_epi16( 0xff );
+    if ( is_min )
     {
-        count++;
-        x >>= 1;
+        a = _mm_min_epu8( a, _mm_srli_epi16( a, 8 ) );
+        b = _mm_min_epu8( b, _mm_srli_epi16( b, 8 ) );
+    }
+    else
+    {
+        a = _mm_max_epu8( a, _mm_srli_epi16( a, 8 ) );
+        b = _mm_max_epu8( b, _mm_srli_epi16( b, 8 ) );
     }
 
-    return 32 - count;
-#endif
-} //count_leading_zeroes32
+    vec_store( d, _mm_packus_epi16( _mm_and_si128( a, lowbytes ), _mm_and_si128( b, lowbytes ) ), Q );
+    return true;
+} //vec_minmaxp8
 
-#ifdef _WIN32
-__declspec(noinline)
-#endif
-void Arm64::unhandled()
+#elif defined( ARM64_SIMD_NEON )
+
+static inline uint8x16_t vec_load( const vec16_t & v ) { return vld1q_u8( (const uint8_t *) & v ); }
+
+static inline void vec_store( vec16_t & v, uint8x16_t x, uint64_t Q )
 {
-    emulator_hard_termination( *this, "opcode not handled:", op );
-} //unhandled
+    if ( !Q )
+        x = vcombine_u8( vget_low_u8( x ), vdup_n_u8( 0 ) );
+    vst1q_u8( (uint8_t *) & v, x );
+} //vec_store
 
-Arm64::FPRounding Arm64::fp_decode_rm( uint64_t rm )
+static bool vec_add( vec16_t & d, const vec16_t & n, const vec16_t & m, uint64_t ebytes, uint64_t Q, bool subtract )
 {
-    if ( 0 == rm )
-        return FPRounding_TIEAWAY;
-    if ( 1 == rm )
-        return FPRounding_TIEEVEN;
-    if ( 2 == rm )
-        return FPRounding_POSINF;
-    if ( 3 == rm )
-        return FPRounding_NEGINF;
-    unhandled();
-    return FPRounding_TIEEVEN; // keep the compiler happy
-} //fp_decode_rm
+    uint8x16_t a = vec_load( n );
+    uint8x16_t b = vec_load( m );
+    uint8x16_t r;
+
+    if ( 1 == ebytes )
+        r = subtract ? vsubq_u8( a, b ) : vaddq_u8( a, b );
+    else if ( 2 == ebytes )
+        r = vreinterpretq_u8_u16( subtract ? vsubq_u16( vreinterpretq_u16_u8( a ), vreinterpretq_u16_u8( b ) ) :
+                                             vaddq_u16( vreinterpretq_u16_u8( a ), vreinterpretq_u16_u8( b ) ) );
+    else if ( 4 == ebytes )
+        r = vreinterpretq_u8_u32( subtract ? vsubq_u32( vreinterpretq_u32_u8( a ), vreinterpretq_u32_u8( b ) ) :
+                                             vaddq_u32( vreinterpretq_u32_u8( a ), vreinterpretq_u32_u8( b ) ) );
+    else
+        r = vreinterpretq_u8_u64( subtract ? vsubq_u64( vreinterpretq_u64_u8( a ), vreinterpretq_u64_u8( b ) ) :
+                                             vaddq_u64( vreinterpretq_u64_u8( a ), vreinterpretq_u64_u8( b ) ) );
 
-Arm64::FPRounding Arm64::fp_decode_rmode( uint64_t rmode ) // rmode is what is stored in 23:22 of fpcr
+    vec_store( d, r, Q );
+    return true;
+} //vec_add
+
+static bool vec_compare( vec16_t & d, const vec16_t & n, const vec16_t & m, uint64_t ebytes, uint64_t Q, VectorCompare kind )
 {
-    if ( 0 == rmode )
-        return FPRounding_TIEEVEN;
-    if ( 1 == rmode )
-        return FPRounding_POSINF;
-    if ( 2 == rmode )
-        return FPRounding_NEGINF;
-    if ( 3 == rmode )
-        return FPRounding_ZERO;
-    unhandled();
-    return FPRounding_TIEEVEN; // keep the compiler happy
-} //fp_decode_rmode
+    uint8x16_t a = vec_load( n );
+    uint8x16_t b = vec_load( m );
+    uint8x16_t r;
 
-static const char * get_rmode_text( uint64_t rmode )
+    if ( 1 == ebytes )
+        r = ( vc_eq == kind ) ? vceqq_u8( a, b ) : ( vc_hi == kind ) ? vcgtq_u8( a, b ) : vcgeq_u8( a, b );
+    else if ( 2 == ebytes )
+    {
+        uint16x8_t x = vreinterpretq_u16_u8( a ), y = vreinterpretq_u16_u8( b );
+        r = vreinterpretq_u8_u16( ( vc_eq == kind ) ? vceqq_u16( x, y ) : ( vc_hi == kind ) ? vcgtq_u16( x, y ) : vcgeq_u16( x, y ) );
+    }
+    else if ( 4 == ebytes )
+    {
+        uint32x4_t x = vreinterpretq_u32_u8( a ), y = vreinterpretq_u32_u8( b );
+        r = vreinterpretq_u8_u32( ( vc_eq == kind ) ? vceqq_u32( x, y ) : ( vc_hi == kind ) ? vcgtq_u32( x, y ) : vcgeq_u32( x, y ) );
+    }
+    else
+    {
+        uint64x2_t x = vreinterpretq_u64_u8( a ), y = vreinterpretq_u64_u8( b );
+        r = vreinterpretq_u8_u64( ( vc_eq == kind ) ? vceqq_u64( x, y ) : ( vc_hi == kind ) ? vcgtq_u64( x, y ) : vcgeq_u64( x, y ) );
+    }
+
+    vec_store( d, r, Q );
+    return true;
+} //vec_compare
+
+static bool vec_minmaxv8( uint8_t & result, const vec16_t & n, uint64_t Q, bool is_min )
 {
-    if ( 0 == rmode )
-        return "FPRounding_TIEEVEN";
-    if ( 1 == rmode )
-        return "FPRounding_POSINF";
-    if ( 2 == rmode )
-        return "FPRounding_NEGINF";
-    if ( 3 == rmode )
-        return "FPRounding_ZERO";
-    return "unknown";
-} //get_rmode_text
+    uint8x16_t v = vec_load( n );
+    if ( Q )
+        result = is_min ? vminvq_u8( v ) : vmaxvq_u8( v );
+    else
+        result = is_min ? vminv_u8( vget_low_u8( v ) ) : vmaxv_u8( vget_low_u8( v ) );
+    return true;
+} //vec_minmaxv8
 
-double Arm64::round_double( double d, FPRounding rounding )
+static bool vec_minmaxp8( vec16_t & d, const vec16_t & n, const vec16_t & m, uint64_t Q, bool is_min )
 {
-    if ( FPRounding_NEGINF == rounding )
-        return floor( d );
-    if ( FPRounding_POSINF == rounding )
-        return ceil( d );
-    if ( FPRounding_TIEEVEN == rounding || FPRounding_TIEAWAY == rounding )
-        return round( d );
-    if ( FPRounding_ODD == rounding )
-    {
-        double rounded = d;
-        if ( ( 0 == fmod( rounded, 2 ) ) && ( 0.5 == fabs( d - rounded ) ) )
-            rounded += ( d > 0.0 ) ? 1.0 : -1.0;
+    uint8x16_t a = vec_load( n );
+    uint8x16_t b = vec_load( m );
+    uint8x16_t r;
 
-        return rounded;
+    if ( Q )
+        r = is_min ? vpminq_u8( a, b ) : vpmaxq_u8( a, b );
+    else
+    {
+        uint8x8_t lo = is_min ? vpmin_u8( vget_low_u8( a ), vget_low_u8( b ) ) : vpmax_u8( vget_low_u8( a ), vget_low_u8( b ) );
+        r = vcombine_u8( lo, vdup_n_u8( 0 ) );
     }
-    if ( FPRounding_ZERO == rounding )
-        return (double) (int64_t) d;
 
-    unhandled();
-    return d; // keep the compiler happy
-} //round_double
+    vec_store( d, r, Q );
+    return true;
+} //vec_minmaxp8
 
-int32_t Arm64::double_to_fixed_int32( double d, uint64_t fracbits, FPRounding rounding )
+#else // portable SWAR using 64-bit integers. H has the high bit of each lane set
+
+static uint64_t lane_high_bits( uint64_t ebytes )
 {
-    if ( d >= INT32_MAX )
-        return INT32_MAX;
+    return ( 1 == ebytes ) ? 0x8080808080808080ull : ( 2 == ebytes ) ? 0x8000800080008000ull : ( 4 == ebytes ) ? 0x8000000080000000ull : 0x8000000000000000ull;
+} //lane_high_bits
 
-    if ( d <= INT32_MIN )
-        return INT32_MIN;
+static bool vec_add( vec16_t & d, vec16_t & n, vec16_t & m, uint64_t ebytes, uint64_t Q, bool subtract )
+{
+    uint64_t H = lane_high_bits( ebytes );
+    uint64_t r[ 2 ] = { 0, 0 };
 
-    return (int32_t) round_double( d * ( 1ull << fracbits ), rounding );
-} //double_to_fixed_int32
+    for ( uint64_t e = 0; e <= Q; e++ )
+    {
+        uint64_t a = n.get64( e );
+        uint64_t b = m.get64( e );
+        if ( subtract )
+            r[ e ] = ( ( a | H ) - ( b & ~H ) ) ^ ( ( a ^ ~b ) & H );
+        else
+            r[ e ] = ( ( a & ~H ) + ( b & ~H ) ) ^ ( ( a ^ b ) & H );
+    }
 
-uint32_t Arm64::double_to_fixed_uint32( double d, uint64_t fracbits, FPRounding rounding )
+    d.set64( 0, r[ 0 ] );
+    d.set64( 1, r[ 1 ] );
+    return true;
+} //vec_add
+
+static bool vec_compare( vec16_t & d, vec16_t & n, vec16_t & m, uint64_t ebytes, uint64_t Q, VectorCompare kind )
 {
-    if ( d >= UINT32_MAX )
-        return UINT32_MAX;
+    if ( vc_eq != kind )
+        return false;
 
-    double val = round_double( d * ( 1ull << fracbits ), rounding );
-    if ( val < 0.0 )
-        val = 0.0;
-    return (uint32_t) val;
-} //double_to_fixed_uint32
+    uint64_t H = lane_high_bits( ebytes );
+    uint64_t bits = ebytes * 8;
+    uint64_t r[ 2 ] = { 0, 0 };
 
-int64_t Arm64::double_to_fixed_int64( double d, uint64_t fracbits, FPRounding rounding )
-{
-    if ( d >= (double) INT64_MAX )
-        return INT64_MAX;
+    for ( uint64_t e = 0; e <= Q; e++ )
+    {
+        uint64_t x = n.get64( e ) ^ m.get64( e );
+        uint64_t nonzero = ( ( ( x & ~H ) + ~H ) | x ) & H; // high bit of each lane set if any bit in the lane is set
+        uint64_t eq = nonzero ^ H;
+        r[ e ] = ( eq - ( eq >> ( bits - 1 ) ) ) | eq;     // spread each lane's high bit across the lane
+    }
 
-    if ( d <= (double) INT64_MIN )
-        return INT64_MIN;
+    d.set64( 0, r[ 0 ] );
+    d.set64( 1, r[ 1 ] );
+    return true;
+} //vec_compare
 
-    return (int64_t) round_double( d * ( 1ull << fracbits ), rounding );
-} //double_to_fixed_int64
+static bool vec_minmaxv8( uint8_t & result, vec16_t & n, uint64_t Q, bool is_min ) { return false; }
+static bool vec_minmaxp8( vec16_t & d, vec16_t & n, vec16_t & m, uint64_t Q, bool is_min ) { return false; }
 
-uint64_t Arm64::double_to_fixed_uint64( double d, uint64_t fracbits, FPRounding rounding )
-{
-    if ( d >= (double) UINT64_MAX )
-        return UINT64_MAX;
+#endif
 
-    double val = round_double( d * ( 1ull << fracbits ), rounding );
-    if ( val < 0.0 )
-        val = 0.0;
-    return (uint64_t) val;
-} //double_to_fixed_uint64
+// crc32 and the aes, pmull, and sha instructions. libraries like zlib, crc32fast, ring, and openssl use them when
+// the hwcaps and ID registers say they're there. x64 hosts use sse4.2 for crc32c and aes-ni and pclmulqdq when cpuid
+// has them, and Arm64 hosts built with +crc and +crypto run the instructions themselves. the rest, including crc32 with
+// the ethernet polynomial that x64 has no instruction for, and sha on x64 since sha-ni's register layout differs, is
+// portable code on 32-bit lanes, which is still far fewer host instructions than the guest's table-driven fallbacks.
+
+#if defined( ARM64_SIMD_SSE2 ) && ( defined( __x86_64__ ) || defined( _M_X64 ) )
+    #define ARM64_CRYPTO_X64
+    #include <nmmintrin.h>
+    #include <wmmintrin.h>
+    #ifdef _MSC_VER
+        #define X64_TARGET( t )
+    #else
+        #include <cpuid.h>
+        #define X64_TARGET( t ) __attribute__(( target( t ) ))
+    #endif
+#elif defined( ARM64_SIMD_NEON )
+    #if defined( __ARM_FEATURE_CRC32 )
+        #define ARM64_CRC_HOST
+        #include <arm_acle.h>
+    #endif
+    #if defined( __ARM_FEATURE_AES ) || defined( __ARM_FEATURE_CRYPTO )
+        #define ARM64_AES_HOST
+    #endif
+    #if defined( __ARM_FEATURE_SHA2 ) || defined( __ARM_FEATURE_CRYPTO )
+        #define ARM64_SHA_HOST
+    #endif
+#endif
 
-static uint64_t get_bit( uint64_t x, uint64_t bit_number )
+struct CryptoTables
 {
-    assert( 64 != bit_number );
-    return ( ( x >> bit_number ) & 1 );
-} //get_bit
+    uint32_t crc[ 2 ][ 256 ];       // reflected crc32 (0xedb88320) and crc32c (0x82f63b78), a byte at a time
+    uint8_t sbox[ 256 ];
+    uint8_t inverse_sbox[ 256 ];
+    bool host_crc32c, host_aes, host_pmull;
 
-static uint64_t gen_bitmask( uint64_t n )
-{
-    if ( 0 == n )
-        return 0;
+    static uint8_t rotl8( uint8_t x, int s ) { return (uint8_t) ( ( x << s ) | ( x >> ( 8 - s ) ) ); }
 
-    return ( ~0ull ) >> ( 64ull - n );
-} //gen_bitmask
+    CryptoTables()
+    {
+        static const uint32_t polynomials[ 2 ] = { 0xedb88320, 0x82f63b78 };
+        for ( int p = 0; p < 2; p++ )
+        {
+            for ( uint32_t i = 0; i < 256; i++ )
+            {
+                uint32_t c = i;
+                for ( int b = 0; b < 8; b++ )
+                    c = ( c & 1 ) ? ( ( c >> 1 ) ^ polynomials[ p ] ) : ( c >> 1 );
+                crc[ p ][ i ] = c;
+            }
+        }
 
-static uint64_t get_elem_bits( uint64_t val, uint64_t c, uint64_t container_size )
+        // walk the multiplicative group with generator 3, and find each inverse with multiplication by 1/3
+
+        uint8_t x = 1, y = 1;
+        do
+        {
+            x = (uint8_t) ( x ^ ( x << 1 ) ^ ( ( x & 0x80 ) ? 0x1b : 0 ) );
+            y ^= (uint8_t) ( y << 1 );
+            y ^= (uint8_t) ( y << 2 );
+            y ^= (uint8_t) ( y << 4 );
+            if ( y & 0x80 )
+                y ^= 0x09;
+            sbox[ x ] = (uint8_t) ( y ^ rotl8( y, 1 ) ^ rotl8( y, 2 ) ^ rotl8( y, 3 ) ^ rotl8( y, 4 ) ^ 0x63 );
+        } while ( 1 != x );
+        sbox[ 0 ] = 0x63;
+        for ( int i = 0; i < 256; i++ )
+            inverse_sbox[ sbox[ i ] ] = (uint8_t) i;
+
+        host_crc32c = host_aes = host_pmull = false;
+#ifdef ARM64_CRYPTO_X64
+        uint32_t ecx = 0;
+    #ifdef _MSC_VER
+        int info[ 4 ];
+        __cpuid( info, 1 );
+        ecx = (uint32_t) info[ 2 ];
+    #else
+        uint32_t eax, ebx, edx;
+        if ( !__get_cpuid( 1, &eax, &ebx, &ecx, &edx ) )
+            ecx = 0;
+    #endif
+        host_pmull = ( 0 != ( ecx & ( 1 << 1 ) ) );
+        host_crc32c = ( 0 != ( ecx & ( 1 << 20 ) ) );
+        host_aes = ( 0 != ( ecx & ( 1 << 25 ) ) );
+#endif
+    }
+};
+
+static const CryptoTables g_crypto;
+static const uint64_t g_id_aa64isar0 = 0x211120; // aes and pmull, sha1, sha2, crc32, lse atomics. the hwcaps armos passes match
+
+#ifdef ARM64_CRYPTO_X64
+
+static X64_TARGET( "sse4.2" ) uint32_t crc32c_x64( uint32_t acc, uint64_t data, uint64_t bytes )
 {
-    uint64_t mask = gen_bitmask( container_size );
-    return ( val & ( mask << ( c * container_size ) ) );
-} //get_elem_bits
+    if ( 1 == bytes )
+        return _mm_crc32_u8( acc, (uint8_t) data );
+    if ( 2 == bytes )
+        return _mm_crc32_u16( acc, (uint16_t) data );
+    if ( 4 == bytes )
+        return _mm_crc32_u32( acc, (uint32_t) data );
+    return (uint32_t) _mm_crc32_u64( acc, data );
+} //crc32c_x64
+
+static X64_TARGET( "aes" ) void aes_x64( vec16_t & state, vec16_t & key, uint32_t kind )
+{
+    __m128i s = vec_load( state );
+    __m128i zero = _mm_setzero_si128();
+
+    if ( 0 == kind )      // aese: AddRoundKey, ShiftRows, SubBytes
+        s = _mm_aesenclast_si128( _mm_xor_si128( s, vec_load( key ) ), zero );
+    else if ( 1 == kind ) // aesd: AddRoundKey, InvShiftRows, InvSubBytes
+        s = _mm_aesdeclast_si128( _mm_xor_si128( s, vec_load( key ) ), zero );
+    else if ( 2 == kind ) // aesmc: undoing aesenc's byte steps leaves just MixColumns
+        s = _mm_aesenc_si128( _mm_aesdeclast_si128( s, zero ), zero );
+    else
+        s = _mm_aesimc_si128( s );
 
-static uint64_t get_bits( uint64_t x, uint64_t lowbit, uint64_t len )
+    vec_store( state, s, 1 );
+} //aes_x64
+
+static X64_TARGET( "pclmul" ) void pmull_x64( vec16_t & d, uint64_t a, uint64_t b )
 {
-    uint64_t val = ( x >> lowbit );
-    if ( 64 == len ) // this actually happens
-        return val;
-    return ( val & ( ( 1ull << len ) - 1 ) );
-} //get_bits
+    vec_store( d, _mm_clmulepi64_si128( _mm_cvtsi64_si128( (int64_t) a ), _mm_cvtsi64_si128( (int64_t) b ), 0 ), 1 );
+} //pmull_x64
 
-static uint64_t reverse_bytes( uint64_t val, uint64_t n )
+#endif //ARM64_CRYPTO_X64
+
+static uint32_t crc32_update( uint32_t acc, uint64_t data, uint64_t bytes, bool castagnoli )
 {
-    uint64_t result = 0;
+    // crc32{c}b/h/w/x. bytes is 1, 2, 4, or 8. there's no pre- or post-inversion; the app does that
+
+#if defined( ARM64_CRC_HOST )
+    if ( castagnoli )
+        return ( 1 == bytes ) ? __crc32cb( acc, (uint8_t) data ) : ( 2 == bytes ) ? __crc32ch( acc, (uint16_t) data ) :
+               ( 4 == bytes ) ? __crc32cw( acc, (uint32_t) data ) : __crc32cd( acc, data );
+    return ( 1 == bytes ) ? __crc32b( acc, (uint8_t) data ) : ( 2 == bytes ) ? __crc32h( acc, (uint16_t) data ) :
+           ( 4 == bytes ) ? __crc32w( acc, (uint32_t) data ) : __crc32d( acc, data );
+#else
+    #ifdef ARM64_CRYPTO_X64
+        if ( castagnoli && g_crypto.host_crc32c )
+            return crc32c_x64( acc, data, bytes );
+    #endif
 
-    if ( 8 == n )
-        for ( uint64_t e = 0; e < 8; e++ )
-            result |= ( get_bits( val, e * 8, 8 ) << ( ( 7 - e ) * 8 ) );
-    else if ( 16 == n )
-        for ( uint64_t e = 0; e < 4; e++ )
-            result |= ( get_bits( val, e * 16, 16 ) << ( ( 3 - e ) * 16 ) );
-    else if ( 32 == n )
-        for ( uint64_t e = 0; e < 2; e++ )
-            result |= ( get_bits( val, e * 32, 32 ) << ( ( 1 - e ) * 32 ) );
-    else
-        assert( false );
-
-    return result;
-} //reverse_bytes
+    const uint32_t * table = g_crypto.crc[ castagnoli ? 1 : 0 ];
+    for ( uint64_t i = 0; i < bytes; i++ )
+    {
+        acc = table[ ( acc ^ (uint32_t) data ) & 0xff ] ^ ( acc >> 8 );
+        data >>= 8;
+    }
+    return acc;
+#endif
+} //crc32_update
 
-static uint64_t one_bits( uint64_t bits )
+static uint8_t gf_multiply( uint8_t a, uint8_t b )
 {
-    if ( 64 == bits )
-        return ~0ull;
-
-    return ( ( 1ull << bits ) - 1 );
-} //one_bits
+    uint8_t r = 0;
+    while ( 0 != b )
+    {
+        if ( b & 1 )
+            r ^= a;
+        a = (uint8_t) ( ( a << 1 ) ^ ( ( a & 0x80 ) ? 0x1b : 0 ) );
+        b >>= 1;
+    }
+    return r;
+} //gf_multiply
 
-static uint64_t replicate_bit( uint64_t val, uint64_t len )
+static void aes_operation( vec16_t & state, vec16_t & n, uint32_t kind )
 {
-    if ( 0 != val )
-        return one_bits( len );
-    return 0;
-} //replicate_bit
+    // kind is 0 for aese, 1 aesd, 2 aesmc, 3 aesimc. aese and aesd use n as the round key, and aesmc and aesimc
+    // transform n into state. the state is column-major: byte r + 4 * c is row r of column c
 
-static int64_t sign_extend( uint64_t x, uint64_t high_bit )
-{
-    assert( high_bit < 63 );
-    x &= ( 1ull << ( high_bit + 1 ) ) - 1; // clear bits above the high bit since they may contain noise
-    const int64_t m = 1ull << high_bit;
-    return ( x ^ m ) - m;
-} //sign_extend
+    if ( kind >= 2 )
+        state = n;
 
-static uint16_t sign_extend16( uint16_t x, uint16_t high_bit )
-{
-    assert( high_bit < 15 );
-    x &= ( 1u << ( high_bit + 1 ) ) - 1; // clear bits above the high bit since they may contain noise
-    const int16_t m = ( (uint16_t) 1 ) << high_bit;
-    return ( x ^ m ) - m;
-} //sign_extend16
+#if defined( ARM64_AES_HOST )
+    uint8x16_t s = vld1q_u8( (uint8_t *) & state );
+    uint8x16_t k = vld1q_u8( (uint8_t *) & n );
+    s = ( 0 == kind ) ? vaeseq_u8( s, k ) : ( 1 == kind ) ? vaesdq_u8( s, k ) : ( 2 == kind ) ? vaesmcq_u8( s ) : vaesimcq_u8( s );
+    vst1q_u8( (uint8_t *) & state, s );
+#else
+    #ifdef ARM64_CRYPTO_X64
+        if ( g_crypto.host_aes )
+        {
+            aes_x64( state, n, kind );
+            return;
+        }
+    #endif
 
-static uint32_t sign_extend32( uint32_t x, uint32_t high_bit )
-{
-    assert( high_bit < 31 );
-    x &= ( 1u << ( high_bit + 1 ) ) - 1; // clear bits above the high bit since they may contain noise
-    const int32_t m = ( (uint32_t) 1 ) << high_bit;
-    return ( x ^ m ) - m;
-} //sign_extend32
+    uint8_t in[ 16 ], out[ 16 ];
+    for ( uint64_t i = 0; i < 16; i++ )
+        in[ i ] = state.get8( i );
 
-static uint64_t plaster_bits( uint64_t val, uint64_t bits, uint64_t low_position, uint64_t len )
-{
-    return ( ( val & ( ~( one_bits( len ) << low_position ) ) ) | ( bits << low_position ) );
-} //plaster_bits
+    if ( kind < 2 )
+    {
+        for ( uint64_t i = 0; i < 16; i++ )
+            in[ i ] ^= n.get8( i );
 
-static uint64_t lowest_set_bit_nz( uint64_t x )
-{
-    uint64_t mask = 1;
-    for ( uint64_t i = 0; i < 64; i++ )
+        for ( int c = 0; c < 4; c++ )
+        {
+            for ( int r = 0; r < 4; r++ )
+            {
+                if ( 0 == kind )
+                    out[ r + 4 * c ] = g_crypto.sbox[ in[ r + 4 * ( ( c + r ) & 3 ) ] ];
+                else
+                    out[ r + 4 * c ] = g_crypto.inverse_sbox[ in[ r + 4 * ( ( c - r ) & 3 ) ] ];
+            }
+        }
+    }
+    else
     {
-        if ( x & mask )
-            return i;
-        mask <<= 1;
+        static const uint8_t mix[ 2 ][ 4 ] = { { 2, 3, 1, 1 }, { 14, 11, 13, 9 } };
+        const uint8_t * coefficients = mix[ kind - 2 ];
+        for ( int c = 0; c < 4; c++ )
+        {
+            const uint8_t * col = in + 4 * c;
+            for ( int r = 0; r < 4; r++ )
+                out[ r + 4 * c ] = gf_multiply( col[ r ], coefficients[ 0 ] ) ^ gf_multiply( col[ ( r + 1 ) & 3 ], coefficients[ 1 ] ) ^
+                                   gf_multiply( col[ ( r + 2 ) & 3 ], coefficients[ 2 ] ) ^ gf_multiply( col[ ( r + 3 ) & 3 ], coefficients[ 3 ] );
+        }
     }
 
-    assert( false ); // _nz means this shoudn't hit
-    return 64;
-} //lowest_set_bit_nz
+    for ( uint64_t i = 0; i < 16; i++ )
+        state.set8( i, out[ i ] );
+#endif
+} //aes_operation
 
-static uint64_t highest_set_bit_nz( uint64_t x )
+static void pmull64( vec16_t & d, uint64_t a, uint64_t b )
 {
-    uint64_t mask = 1ull << 63;
-    for ( uint64_t i = 64; i > 0; i-- )
+    // carry-less multiply of two 64-bit polynomials to 128 bits, as for ghash in aes-gcm
+
+#if defined( ARM64_AES_HOST )
+    poly128_t r = vmull_p64( (poly64_t) a, (poly64_t) b );
+    vst1q_u8( (uint8_t *) & d, vreinterpretq_u8_p128( r ) );
+#else
+    #ifdef ARM64_CRYPTO_X64
+        if ( g_crypto.host_pmull )
+        {
+            pmull_x64( d, a, b );
+            return;
+        }
+    #endif
+
+    uint64_t lo = 0, hi = 0;
+    for ( int i = 0; i < 64; i++ )
     {
-        if ( x & mask )
-            return i - 1;
-        mask >>= 1;
+        if ( b & ( 1ull << i ) )
+        {
+            lo ^= ( a << i );
+            if ( 0 != i )
+                hi ^= ( a >> ( 64 - i ) );
+        }
     }
+    d.set64( 0, lo );
+    d.set64( 1, hi );
+#endif
+} //pmull64
 
-    assert( false ); // _nz means this shoudn't hit
-    return 0;
-} //highest_set_bit_nz
+static inline uint32_t rol32( uint32_t x, int s ) { return ( x << s ) | ( x >> ( 32 - s ) ); }
+static inline uint32_t ror32( uint32_t x, int s ) { return ( x >> s ) | ( x << ( 32 - s ) ); }
 
-const char * Arm64::render_flags() const
+struct ShaWords
 {
-    static char ac[ 5 ] = {0};
+    uint32_t w[ 4 ];
 
-    ac[ 0 ] = fN ? 'N' : 'n';
-    ac[ 1 ] = fZ ? 'Z' : 'z';
-    ac[ 2 ] = fC ? 'C' : 'c';
-    ac[ 3 ] = fV ? 'V' : 'v';
+    ShaWords( vec16_t & v ) { for ( uint64_t i = 0; i < 4; i++ ) w[ i ] = v.get32( i ); }
+    void store( vec16_t & v ) const { for ( uint64_t i = 0; i < 4; i++ ) v.set32( i, w[ i ] ); }
+};
 
-    return ac;
-} //render_flags
+static uint32_t sha_choose( uint32_t x, uint32_t y, uint32_t z ) { return ( ( y ^ z ) & x ) ^ z; }
+static uint32_t sha_majority( uint32_t x, uint32_t y, uint32_t z ) { return ( x & y ) | ( ( x | y ) & z ); }
+static uint32_t sha_parity( uint32_t x, uint32_t y, uint32_t z ) { return x ^ y ^ z; }
 
-static const char * xreg_names[32] =
+static void sha1_hash( vec16_t & vd, uint32_t e, vec16_t & vm, uint32_t kind )
 {
-    "x0",  "x1",   "x2", "x3",  "x4",  "x5",  "x6",  "x7",
-    "x8",  "x9",  "x10", "x11", "x12", "x13", "x14", "x15",
-    "x16", "x17", "x18", "x19", "x20", "x21", "x22", "x23",
-    "x24", "x25", "x26", "x27", "x28", "x29", "x30", "xzr"
-};
+    // sha1c (kind 0), sha1p (1), and sha1m (2): four rounds on abcd in vd with e and the schedule words in vm
 
-static const char * wreg_names[32] =
+    ShaWords x( vd );
+    ShaWords wk( vm );
+    for ( int i = 0; i < 4; i++ )
+    {
+        uint32_t f = ( 0 == kind ) ? sha_choose( x.w[ 1 ], x.w[ 2 ], x.w[ 3 ] ) : ( 1 == kind ) ? sha_parity( x.w[ 1 ], x.w[ 2 ], x.w[ 3 ] ) :
+                     sha_majority( x.w[ 1 ], x.w[ 2 ], x.w[ 3 ] );
+        e += rol32( x.w[ 0 ], 5 ) + f + wk.w[ i ];
+        x.w[ 1 ] = rol32( x.w[ 1 ], 30 );
+        uint32_t t = x.w[ 3 ];
+        x.w[ 3 ] = x.w[ 2 ];
+        x.w[ 2 ] = x.w[ 1 ];
+        x.w[ 1 ] = x.w[ 0 ];
+        x.w[ 0 ] = e;
+        e = t;
+    }
+    x.store( vd );
+} //sha1_hash
+
+static void sha256_hash( vec16_t & vd, vec16_t & vn, vec16_t & vm, bool part1 )
 {
-    "w0",  "w1",   "w2", "w3",  "w4",  "w5",  "w6",  "w7",
-    "w8",  "w9",  "w10", "w11", "w12", "w13", "w14", "w15",
-    "w16", "w17", "w18", "w19", "w20", "w21", "w22", "w23",
-    "w24", "w25", "w26", "w27", "w28", "w29", "w30", "wzr"
-};
+    // sha256h (part1) has abcd in vd and efgh in vn, and returns the new abcd. sha256h2 has them the other way around
+    // and returns the new efgh. both run the same four rounds
 
-static const char * reg_or_zr( uint64_t x, bool xregs )
+    ShaWords x( part1 ? vd : vn );
+    ShaWords y( part1 ? vn : vd );
+    ShaWords wk( vm );
+    for ( int i = 0; i < 4; i++ )
+    {
+        uint32_t t = y.w[ 3 ] + ( ror32( y.w[ 0 ], 6 ) ^ ror32( y.w[ 0 ], 11 ) ^ ror32( y.w[ 0 ], 25 ) ) +
+                     sha_choose( y.w[ 0 ], y.w[ 1 ], y.w[ 2 ] ) + wk.w[ i ];
+        x.w[ 3 ] += t;
+        y.w[ 3 ] = t + ( ror32( x.w[ 0 ], 2 ) ^ ror32( x.w[ 0 ], 13 ) ^ ror32( x.w[ 0 ], 22 ) ) + sha_majority( x.w[ 0 ], x.w[ 1 ], x.w[ 2 ] );
+
+        uint32_t xtop = x.w[ 3 ];
+        x.w[ 3 ] = x.w[ 2 ];
+        x.w[ 2 ] = x.w[ 1 ];
+        x.w[ 1 ] = x.w[ 0 ];
+        x.w[ 0 ] = y.w[ 3 ];
+        y.w[ 3 ] = y.w[ 2 ];
+        y.w[ 2 ] = y.w[ 1 ];
+        y.w[ 1 ] = y.w[ 0 ];
+        y.w[ 0 ] = xtop;
+    }
+    ( part1 ? x : y ).store( vd );
+} //sha256_hash
+
+static void sha_schedule( vec16_t & vd, vec16_t & vn, vec16_t & vm, uint32_t kind )
 {
-    assert( x <= 31 );
-    if ( xregs )
-        return xreg_names[ x ];
+    // kind is 0 for sha1su0, 1 sha1su1, 2 sha256su0, 3 sha256su1. the two-register forms ignore vm
+
+#if defined( ARM64_SHA_HOST )
+    uint32x4_t d = vld1q_u32( (uint32_t *) & vd );
+    uint32x4_t n = vld1q_u32( (uint32_t *) & vn );
+    uint32x4_t m = vld1q_u32( (uint32_t *) & vm );
+    d = ( 0 == kind ) ? vsha1su0q_u32( d, n, m ) : ( 1 == kind ) ? vsha1su1q_u32( d, n ) : ( 2 == kind ) ? vsha256su0q_u32( d, n ) :
+        vsha256su1q_u32( d, n, m );
+    vst1q_u32( (uint32_t *) & vd, d );
+#else
+    ShaWords d( vd ), n( vn ), m( vm );
+    ShaWords r = d;
 
-    return wreg_names[ x ];
-} //reg_or_zr
+    if ( 0 == kind )
+    {
+        uint32_t t[ 4 ] = { d.w[ 2 ], d.w[ 3 ], n.w[ 0 ], n.w[ 1 ] };
+        for ( int i = 0; i < 4; i++ )
+            r.w[ i ] = t[ i ] ^ d.w[ i ] ^ m.w[ i ];
+    }
+    else if ( 1 == kind )
+    {
+        uint32_t t[ 4 ] = { d.w[ 0 ] ^ n.w[ 1 ], d.w[ 1 ] ^ n.w[ 2 ], d.w[ 2 ] ^ n.w[ 3 ], d.w[ 3 ] };
+        for ( int i = 0; i < 4; i++ )
+            r.w[ i ] = rol32( t[ i ], 1 );
+        r.w[ 3 ] ^= rol32( t[ 0 ], 2 );
+    }
+    else if ( 2 == kind )
+    {
+        uint32_t t[ 4 ] = { d.w[ 1 ], d.w[ 2 ], d.w[ 3 ], n.w[ 0 ] };
+        for ( int i = 0; i < 4; i++ )
+            r.w[ i ] = ( ror32( t[ i ], 7 ) ^ ror32( t[ i ], 18 ) ^ ( t[ i ] >> 3 ) ) + d.w[ i ];
+    }
+    else
+    {
+        uint32_t t0[ 4 ] = { n.w[ 1 ], n.w[ 2 ], n.w[ 3 ], m.w[ 0 ] };
+        for ( int i = 0; i < 4; i++ )
+        {
+            uint32_t t1 = ( i < 2 ) ? m.w[ 2 + i ] : r.w[ i - 2 ];
+            r.w[ i ] = ( ror32( t1, 17 ) ^ ror32( t1, 19 ) ^ ( t1 >> 10 ) ) + d.w[ i ] + t0[ i ];
+        }
+    }
 
-static const char * reg_or_sp( uint64_t x, bool xregs )
+    r.store( vd );
+#endif
+} //sha_schedule
+
+static uint64_t g_State = 0;
+
+const uint64_t stateTraceInstructions = 1;
+
+bool Arm64::trace_instructions( bool t )
 {
-    assert( x <= 31 );
-    if ( 31 == x )
-        return "sp";
+    bool prev = ( 0 != ( g_State & stateTraceInstructions ) );
+    if ( t )
+        g_State |= stateTraceInstructions;
+    else
+        g_State &= ~stateTraceInstructions;
+    return prev;
+} //trace_instructions
 
-    return reg_or_zr( x, xregs );
-} //reg_or_sp
+void Arm64::end_emulation() { end_requested = true; }
 
-__inline_perf uint64_t Arm64::val_reg_or_zr( uint64_t r ) const
+void Arm64::yield_svc() { yield_requested = true; }
+
+void Arm64::request_sample() { sample_requested = true; }
+
+void Arm64::copy_thread_state( Arm64 & parent )
 {
-    if ( 31 == r )
-        return 0;
-    return regs[ r ];
-} //val_reg_or_zr
+    parent.materialize_flags();
+    memcpy( regs, parent.regs, sizeof( regs ) );
+    for ( size_t i = 0; i < _countof( vregs ); i++ )
+        vregs[ i ] = parent.vregs[ i ];
+    pc = parent.pc;
+    tpidr_el0 = parent.tpidr_el0;
+    fpcr = parent.fpcr;
+    fN = parent.fN;
+    fZ = parent.fZ;
+    fC = parent.fC;
+    fV = parent.fV;
+
+    // each thread has its own predecode cache and jit code, since both are written as the thread runs
+
+    if ( 0 != parent.jit )
+        enable_jit( true );
+    else
+        enable_predecode( parent.predecode_enabled );
+
+    enable_instruction_mix( 0 != parent.op_counts );
+    enable_branch_profile( 0 != parent.profile_ranges );
+    track_memory = parent.track_memory;
+    if ( 0 != parent.ring )
+        enable_trace_ring( (uint32_t) ( parent.ring_mask + 1 ), parent.ring_trigger, parent.ring_path );
+    trace_lo = parent.trace_lo;
+    trace_hi = parent.trace_hi;
+    trace_first = parent.trace_first;
+    trace_end = parent.trace_end;
+
+    delete [] intercepts;
+    intercepts = 0;
+    intercept_count = parent.intercept_count;
+    if ( 0 != intercept_count )
+    {
+        intercepts = new uint64_t[ 2 * intercept_count ];
+        memcpy( intercepts, parent.intercepts, 2 * intercept_count * sizeof( uint64_t ) );
+    }
+} //copy_thread_state
 
-template < typename T > Arm64::ElementComparisonResult Arm64::compare( T l, T r )
+void Arm64::set_breakpoint( uint64_t address ) { breakpoint = address; }
+
+void Arm64::set_trace_filter( uint64_t lo, uint64_t hi, uint64_t first, uint64_t count )
 {
-    return ( l < r ) ? ecr_lt : ( l == r ) ? ecr_eq : ecr_gt;
-} //compare
+    trace_lo = lo;
+    trace_hi = hi;
+    trace_first = first;
+    trace_end = ( 0 == count ) ? 0 : ( first + count );
+} //set_trace_filter
 
-Arm64::ElementComparisonResult Arm64::compare_vector_elements( uint8_t * pl, uint8_t * pr, uint64_t width, bool unsigned_compare )
+void Arm64::set_intercepts( const uint64_t * addresses, const uint32_t * routines, uint32_t count )
 {
-    assert( 1 == width || 2 == width || 4 == width || 8 == width );
+    // pairs of ( address, routine ) sorted by address so build_block() can binary search
 
-    if ( unsigned_compare )
+    delete [] intercepts;
+    intercepts = 0;
+    intercept_count = count;
+    if ( 0 != count )
     {
-        if ( 1 == width )
-            return compare( *pl, *pr );
-        if ( 2 == width )
-            return compare( consider_endian16( * (uint16_t *) pl ), consider_endian16( * (uint16_t *) pr ) );
-        if ( 4 == width )
-            return compare( consider_endian32( * (uint32_t *) pl ), consider_endian32( * (uint32_t *) pr ) );
+        intercepts = new uint64_t[ 2 * count ];
+        for ( uint32_t i = 0; i < count; i++ )
+        {
+            uint32_t j = i;
+            while ( ( j > 0 ) && ( intercepts[ 2 * ( j - 1 ) ] > addresses[ i ] ) )
+            {
+                intercepts[ 2 * j ] = intercepts[ 2 * ( j - 1 ) ];
+                intercepts[ 2 * j + 1 ] = intercepts[ 2 * ( j - 1 ) + 1 ];
+                j--;
+            }
+            intercepts[ 2 * j ] = addresses[ i ];
+            intercepts[ 2 * j + 1 ] = routines[ i ];
+        }
+    }
 
-        return compare( consider_endian64( * (uint64_t *) pl ), consider_endian64( * (uint64_t *) pr ) );
+    if ( predecode_enabled )
+        flush_predecode(); // blocks already built at the addresses would run the guest's code
+} //set_intercepts
+
+bool Arm64::find_intercept( uint64_t address, uint32_t & routine ) const
+{
+    uint32_t lo = 0;
+    uint32_t hi = intercept_count;
+    while ( lo < hi )
+    {
+        uint32_t mid = ( lo + hi ) / 2;
+        if ( intercepts[ 2 * mid ] < address )
+            lo = mid + 1;
+        else
+            hi = mid;
     }
 
-    if ( 1 == width )
-        return compare( * (int8_t *) pl, * (int8_t *) pr );
-    if ( 2 == width )
-        return compare( (int16_t) consider_endian16( * (uint16_t *) pl ), (int16_t) consider_endian16( * (uint16_t *) pr ) );
-    if ( 4 == width )
-        return compare( (int32_t) consider_endian32( * (uint32_t *) pl ), (int32_t) consider_endian32( * (uint32_t *) pr ) );
+    if ( ( lo < intercept_count ) && ( address == intercepts[ 2 * lo ] ) )
+    {
+        routine = (uint32_t) intercepts[ 2 * lo + 1 ];
+        return true;
+    }
 
-    return compare( (int64_t) consider_endian64( * (uint64_t *) pl ), (int64_t) consider_endian64( * (uint64_t *) pr ) );
-} //compare_vector_elements
+    return false;
+} //find_intercept
 
-static const char * get_ld1_vector_T( uint64_t size, uint64_t Q )
+void Arm64::save_state( ArchState & state )
 {
-    if ( 0 == size )
-        return Q ? "16b" : "8b";
+    materialize_flags();
+    memcpy( state.regs, regs, sizeof( regs ) );
+    for ( size_t i = 0; i < _countof( vregs ); i++ )
+    {
+        state.vregs[ i ][ 0 ] = vregs[ i ].get64( 0 );
+        state.vregs[ i ][ 1 ] = vregs[ i ].get64( 1 );
+    }
+    state.pc = pc;
+    state.tpidr_el0 = tpidr_el0;
+    state.fpcr = fpcr;
+    state.nzcv = ( fN ? 8 : 0 ) | ( fZ ? 4 : 0 ) | ( fC ? 2 : 0 ) | ( fV ? 1 : 0 );
+} //save_state
 
-    if ( 1 == size )
-        return Q ? "8h" : "4h";
+void Arm64::restore_state( const ArchState & state )
+{
+    materialize_flags(); // so pending lazy flags don't overwrite the restored ones
+    memcpy( regs, state.regs, sizeof( regs ) );
+    for ( size_t i = 0; i < _countof( vregs ); i++ )
+    {
+        vregs[ i ].set64( 0, state.vregs[ i ][ 0 ] );
+        vregs[ i ].set64( 1, state.vregs[ i ][ 1 ] );
+    }
+    pc = state.pc;
+    tpidr_el0 = state.tpidr_el0;
+    fpcr = state.fpcr;
+    fN = ( 0 != ( state.nzcv & 8 ) );
+    fZ = ( 0 != ( state.nzcv & 4 ) );
+    fC = ( 0 != ( state.nzcv & 2 ) );
+    fV = ( 0 != ( state.nzcv & 1 ) );
+    exclusive_size = 0; // a reservation from before the snapshot doesn't survive it
+} //restore_state
+
+// exclusive loads and stores. the monitor holds raw memory bytes, so only the guest values need endian conversion
 
-    if ( 2 == size )
-        return Q ? "4s" : "2s";
+#ifdef TARGET_BIG_ENDIAN
+    static uint8_t guest_order( uint8_t x ) { return x; }
+    static uint16_t guest_order( uint16_t x ) { return flip_endian16( x ); }
+    static uint32_t guest_order( uint32_t x ) { return flip_endian32( x ); }
+    static uint64_t guest_order( uint64_t x ) { return flip_endian64( x ); }
+#else
+    template <class T> static T guest_order( T x ) { return x; }
+#endif
 
-    if ( 3 == size )
-        return Q ? "2d" : "1d";
+// host_cas_value returns what was in memory, so the swap happened if that's the expected value
 
-    return "UNKNOWN";
-} //get_ld1_vector_T
+#ifdef _MSC_VER
+    static uint8_t host_cas_value( uint8_t * p, uint8_t expected, uint8_t desired ) { return (uint8_t) _InterlockedCompareExchange8( (char *) p, (char) desired, (char) expected ); }
+    static uint16_t host_cas_value( uint16_t * p, uint16_t expected, uint16_t desired ) { return (uint16_t) _InterlockedCompareExchange16( (short *) p, (short) desired, (short) expected ); }
+    static uint32_t host_cas_value( uint32_t * p, uint32_t expected, uint32_t desired ) { return (uint32_t) _InterlockedCompareExchange( (long *) p, (long) desired, (long) expected ); }
+    static uint64_t host_cas_value( uint64_t * p, uint64_t expected, uint64_t desired ) { return (uint64_t) _InterlockedCompareExchange64( (__int64 *) p, (__int64) desired, (__int64) expected ); }
+#else
+    template <class T> static T host_cas_value( T * p, T expected, T desired )
+    {
+        __atomic_compare_exchange_n( p, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST );
+        return expected;
+    } //host_cas_value
+#endif
 
-static const char * get_saddlp_vector_T( uint64_t size, uint64_t Q )
+template <class T> static bool host_cas( T * p, T expected, T desired ) { return expected == host_cas_value( p, expected, desired ); }
+
+uint64_t Arm64::load_exclusive( uint64_t address, uint32_t size )
 {
-    if ( 0 == size )
-        return Q ? "8h" : "4h";
+    track( address, size, false );
+    uint8_t * p = getmem( address );
+    uint64_t val;
 
     if ( 1 == size )
-        return Q ? "4s" : "2s";
-
-    if ( 2 == size )
-        return Q ? "2d" : "1d";
+        exclusive_value = val = * p;
+    else if ( 2 == size )
+    {
+        uint16_t raw = * (volatile uint16_t *) p;
+        exclusive_value = raw;
+        val = guest_order( raw );
+    }
+    else if ( 4 == size )
+    {
+        uint32_t raw = * (volatile uint32_t *) p;
+        exclusive_value = raw;
+        val = guest_order( raw );
+    }
+    else
+    {
+        uint64_t raw = * (volatile uint64_t *) p;
+        exclusive_value = raw;
+        val = guest_order( raw );
+    }
 
-    return "UNKNOWN";
-} //get_saddlp_vector_T
+    exclusive_address = address;
+    exclusive_size = size;
+    return val;
+} //load_exclusive
 
-static const char * get_vector_T( uint64_t imm5, uint64_t Q )
+bool Arm64::store_exclusive( uint64_t address, uint64_t val, uint32_t size )
 {
-    if ( 1 == ( 1 & imm5 ) )
-        return Q ? "16b" : "8b";
+    // the store succeeds if the location still holds what ldxr read. that misses a write of the same value
+    // between the two (ABA), which doesn't matter for the lock and counter sequences compilers generate.
 
-    if ( 2 == ( 3 & imm5 ) )
-        return Q ? "8h" : "4h";
+    bool ok = false;
 
-    if ( 4 == ( 7 & imm5 ) )
-        return Q ? "4s" : "2s";
+    if ( ( size == exclusive_size ) && ( address == exclusive_address ) )
+    {
+        track( address, size, true );
+        uint8_t * p = getmem( address );
+
+        if ( 1 == size )
+            ok = host_cas( p, (uint8_t) exclusive_value, (uint8_t) val );
+        else if ( 2 == size )
+            ok = host_cas( (uint16_t *) p, (uint16_t) exclusive_value, guest_order( (uint16_t) val ) );
+        else if ( 4 == size )
+            ok = host_cas( (uint32_t *) p, (uint32_t) exclusive_value, guest_order( (uint32_t) val ) );
+        else
+            ok = host_cas( (uint64_t *) p, exclusive_value, guest_order( val ) );
+
+        if ( ok )
+            check_code_write( address, size );
+    }
 
-    if ( 8 == ( 0xf & imm5 ) )
-        return Q ? "2d" : "RESERVED";
+    exclusive_size = 0;
+    return ok;
+} //store_exclusive
 
-    return "RESERVED";
-} //get_vector_T
+// lse atomics. opc is bits 14:12 of ldadd, ldclr, ldeor, ldset, ldsmax, ldsmin, ldumax, and ldumin, or 8 for swp.
+// values are in guest order and S is the signed type for T
 
-static const char * get_sshr_vector_T( uint64_t immh, uint64_t Q )
+template <class T, class S> static T atomic_result( T old, T operand, uint32_t opc )
 {
-    if ( 1 == immh )
-        return Q ? "16b" : "8b";
+    switch ( opc )
+    {
+        case 0: return (T) ( old + operand );
+        case 1: return (T) ( old & ~operand );
+        case 2: return (T) ( old ^ operand );
+        case 3: return (T) ( old | operand );
+        case 4: return ( (S) old > (S) operand ) ? old : operand;
+        case 5: return ( (S) old < (S) operand ) ? old : operand;
+        case 6: return ( old > operand ) ? old : operand;
+        case 7: return ( old < operand ) ? old : operand;
+        default: return operand;
+    }
+} //atomic_result
 
-    if ( 2 == ( 0xe & immh ) )
-        return Q ? "8h" : "4h";
-
-    if ( 4 == ( 0xc & immh ) )
-        return Q ? "4s" : "2s";
+template <class T, class S> static T host_atomic_op( T * p, T operand, uint32_t opc )
+{
+#if !defined( _MSC_VER ) && !defined( TARGET_BIG_ENDIAN )
+    if ( 0 == opc )
+        return __atomic_fetch_add( p, operand, __ATOMIC_SEQ_CST );
+    if ( 1 == opc )
+        return __atomic_fetch_and( p, (T) ~operand, __ATOMIC_SEQ_CST );
+    if ( 2 == opc )
+        return __atomic_fetch_xor( p, operand, __ATOMIC_SEQ_CST );
+    if ( 3 == opc )
+        return __atomic_fetch_or( p, operand, __ATOMIC_SEQ_CST );
+    if ( 8 == opc )
+        return __atomic_exchange_n( p, operand, __ATOMIC_SEQ_CST );
+#endif
 
-    if ( 8 == ( 8 & immh ) )
-        return Q ? "2d" : "RESERVED";
+    // hosts have no atomic min and max, so those use compare-and-swap
 
-    return "RESERVED";
-} //get_sshr_vector_T
+    T raw = * (volatile T *) p;
+    for ( ;; )
+    {
+        T old = guest_order( raw );
+        T seen = host_cas_value( p, raw, guest_order( atomic_result<T, S>( old, operand, opc ) ) );
+        if ( seen == raw )
+            return old;
+        raw = seen;
+    }
+} //host_atomic_op
 
-uint64_t Arm64::extend_reg( uint64_t m, uint64_t extend_type, uint64_t shift, bool fullm )
+uint64_t Arm64::atomic_op( uint64_t address, uint64_t operand, uint32_t size, uint32_t opc )
 {
-    uint64_t x = ( 31 == m ) ? 0 : regs[ m ];
-    if ( !fullm )
-        x = (uint32_t) x;
+    // returns the old value
 
-    switch( extend_type )
-    {
-        case 0: { x &= 0xff; break; }                 // UXTB
-        case 1: { x &= 0xffff; break; }               // UXTH
-        case 2: { x &= 0xffffffff; break; }           // LSL/UXTW
-        case 3: { break; }                            // UXTX
-        case 4: { x = sign_extend( x, 7 ); break; }   // SXTB
-        case 5: { x = sign_extend( x, 15 ); break; }  // SXTH
-        case 6: { x = sign_extend( x, 31 ); break; }  // SXTW
-        case 7: { break; }                            // SXTX
-        default: unhandled();
-    }
+    track( address, size, true );
+    uint8_t * p = getmem( address );
+    uint64_t old;
 
-    x <<= shift;
-    return x;
-} //extend_reg
+    if ( 1 == size )
+        old = host_atomic_op<uint8_t, int8_t>( p, (uint8_t) operand, opc );
+    else if ( 2 == size )
+        old = host_atomic_op<uint16_t, int16_t>( (uint16_t *) p, (uint16_t) operand, opc );
+    else if ( 4 == size )
+        old = host_atomic_op<uint32_t, int32_t>( (uint32_t *) p, (uint32_t) operand, opc );
+    else
+        old = host_atomic_op<uint64_t, int64_t>( (uint64_t *) p, operand, opc );
 
-static const char * shift_type( uint64_t x )
+    check_code_write( address, size );
+    return old;
+} //atomic_op
+
+uint64_t Arm64::compare_and_swap( uint64_t address, uint64_t expected, uint64_t desired, uint32_t size )
 {
-    if ( 0 == x )
-        return "lsl";
-    if ( 1 == x )
-        return "lsr";
-    if ( 2 == x )
-        return "asr";
-    if ( 3 == x )
-        return "ror";
+    // cas and casp of 32-bit pairs. returns the old value; desired was stored if that equals expected
 
-    return "UNKNOWN_SHIFT";
-} //shift_type
+    track( address, size, true );
+    uint8_t * p = getmem( address );
+    uint64_t old;
 
-static const char * extend_type( uint64_t x )
-{
-    if ( 0 == x )
-        return "UXTB";
-    if ( 1 == x )
-        return "UXTH";
-    if ( 2 == x )
-        return "UXTW";
-    if ( 3 == x )
-        return "LSL | UXTW";
-    if ( 4 == x )
-        return "SXTB";
-    if ( 5 == x )
-        return "SXTH";
-    if ( 6 == x )
-        return "SXTW";
-    if ( 7 == x )
-        return "SXTX";
-    return "UNKNOWN_EXTEND";
-} //extend_type
+    if ( 1 == size )
+        old = host_cas_value( p, (uint8_t) expected, (uint8_t) desired );
+    else if ( 2 == size )
+        old = guest_order( host_cas_value( (uint16_t *) p, guest_order( (uint16_t) expected ), guest_order( (uint16_t) desired ) ) );
+    else if ( 4 == size )
+        old = guest_order( host_cas_value( (uint32_t *) p, guest_order( (uint32_t) expected ), guest_order( (uint32_t) desired ) ) );
+    else
+        old = guest_order( host_cas_value( (uint64_t *) p, guest_order( expected ), guest_order( desired ) ) );
 
-uint64_t Arm64::replicate_bytes( uint64_t val, uint64_t byte_len )
-{
-    uint64_t mask = one_bits( byte_len * 8 );
-    uint64_t pattern = ( val & mask );
-    uint64_t repeat = 8 / byte_len;
-    uint64_t result = 0;
-    for ( uint64_t x = 0; x < repeat; x++ )
-        result |= ( pattern << ( x * byte_len * 8 ) );
+    if ( old == expected )
+        check_code_write( address, size );
+    return old;
+} //compare_and_swap
 
-    //tracer.Trace( "replicate bytes val %#llx byte_len %lld. mask %#llx, pattern %#llx, repeat %lld, result %#llx\n", val, byte_len, mask, pattern, repeat, result );
-    return result;
-} //replicate_bytes
+#if defined( _MSC_VER ) && ( defined( _M_X64 ) || defined( _M_ARM64 ) )
+    static bool host_cas128( uint64_t * p, uint64_t expected[ 2 ], const uint64_t desired[ 2 ] )
+    {
+        return 0 != _InterlockedCompareExchange128( (__int64 *) p, (__int64) desired[ 1 ], (__int64) desired[ 0 ], (__int64 *) expected );
+    } //host_cas128
+#elif defined( __SIZEOF_INT128__ ) && ( defined( __x86_64__ ) || defined( __aarch64__ ) )
+    #ifdef __x86_64__
+        __attribute__(( target( "cx16" ) ))
+    #endif
+    static bool host_cas128( uint64_t * p, uint64_t expected[ 2 ], const uint64_t desired[ 2 ] )
+    {
+        // __sync is inlined as cmpxchg16b or an exclusive pair loop. __atomic would call libatomic
+        unsigned __int128 e = ( (unsigned __int128) expected[ 1 ] << 64 ) | expected[ 0 ];
+        unsigned __int128 d = ( (unsigned __int128) desired[ 1 ] << 64 ) | desired[ 0 ];
+        unsigned __int128 seen = __sync_val_compare_and_swap( (unsigned __int128 *) p, e, d );
+        expected[ 0 ] = (uint64_t) seen;
+        expected[ 1 ] = (uint64_t) ( seen >> 64 );
+        return seen == e;
+    } //host_cas128
+#else
+    static atomic_flag g_cas128_lock = ATOMIC_FLAG_INIT;
 
-uint64_t Arm64::adv_simd_expand_imm( uint64_t operand, uint64_t cmode, uint64_t imm8 )
-{
-    //tracer.Trace( "operand %#llx, cmode %#llx, imm8 %#llx\n", operand, cmode, imm8 );
-    uint64_t imm64 = 0;
-    uint64_t cm = ( cmode >> 1 );
-    switch ( cm )
+    static bool host_cas128( uint64_t * p, uint64_t expected[ 2 ], const uint64_t desired[ 2 ] )
     {
-        case 0: { imm64 = replicate_bytes( imm8, 4 ); break; }
-        case 1: { imm64 = replicate_bytes( imm8 << 8, 4 ); break; }
-        case 2: { imm64 = replicate_bytes( imm8 << 16, 4 ); break; }
-        case 3: { imm64 = replicate_bytes( imm8 << 24, 4 ); break; }
-        case 4: { imm64 = replicate_bytes( imm8, 2 ); break; }
-        case 5: { imm64 = replicate_bytes( imm8 << 8, 2 ); break; }
-        case 6:
-        {
-            if ( 1 == ( cmode & 1 ) )
-                imm64 = replicate_bytes( ( imm8 << 16 ) | 0xffff, 4 );
-            else
-                imm64 = replicate_bytes( ( imm8 << 8 ) | 0xff, 4 );
-            break;
-        }
-        case 7:
+        // no 128-bit host atomic, so casp of 64-bit pairs is only atomic with respect to other casp instructions
+        while ( g_cas128_lock.test_and_set( memory_order_acquire ) )
+            continue;
+        bool ok = ( p[ 0 ] == expected[ 0 ] ) && ( p[ 1 ] == expected[ 1 ] );
+        expected[ 0 ] = p[ 0 ];
+        expected[ 1 ] = p[ 1 ];
+        if ( ok )
         {
-            if ( 0 == ( cmode & 1 ) )
-            {
-                if  ( 0 == operand )
-                    imm64 = replicate_bytes( imm8, 1 );
-                else if ( 1 == operand )
-                {
-                    uint64_t imm8a = ( imm8 & 0x80 ) ? 0xff : 0;
-                    uint64_t imm8b = ( imm8 & 0x40 ) ? 0xff : 0;
-                    uint64_t imm8c = ( imm8 & 0x20 ) ? 0xff : 0;
-                    uint64_t imm8d = ( imm8 & 0x10 ) ? 0xff : 0;
-                    uint64_t imm8e = ( imm8 & 0x08 ) ? 0xff : 0;
-                    uint64_t imm8f = ( imm8 & 0x04 ) ? 0xff : 0;
-                    uint64_t imm8g = ( imm8 & 0x02 ) ? 0xff : 0;
-                    uint64_t imm8h = ( imm8 & 0x01 ) ? 0xff : 0;
-                    imm64 = ( imm8a << 56 ) | ( imm8b << 48 ) | ( imm8c << 40 ) | ( imm8d << 32 ) | ( imm8e << 24 ) | ( imm8f << 16 ) | ( imm8g << 8 ) | imm8h;
-                }
-                else
-                    unhandled();
-            }
-            else
-            {
-                if ( 0 == operand )
-                {
-                    // imm32 = imm8<7>:NOT(imm8<6>):Replicate(imm8<6>,5):imm8<5:0>:Zeros(19);
-                    // imm64 = Replicate(imm32, 2);
-
-                    uint64_t a = get_bit( imm8, 7 );
-                    uint64_t b = !get_bit( imm8, 6 );
-                    uint64_t c = replicate_bit( get_bit( imm8, 6 ), 5 );
-                    uint64_t d = get_bits( imm8, 0, 6 );
-                    uint32_t imm32 = (uint32_t) ( ( ( a << 12 ) | ( b << 11 ) | ( c << 6 ) | d ) << 19 );
-                    imm64 = replicate_bytes( imm32, 4 );
-                }
-                else
-                {
-                    // imm64 = imm8<7>:NOT(imm8<6>):Replicate(imm8<6>,8):imm8<5:0>:Zeros(48);
-                    imm64 = ( get_bit( imm8, 7 ) << 63 ) |
-                            ( ( get_bit( imm8, 6 ) ? 0ull : 1ull ) << 62 ) |
-                            ( replicate_bit( get_bit( imm8, 6 ), 8 ) << ( 62 - 8 ) ) |
-                            ( get_bits( imm8, 0, 6 ) << 48 );
-                }
-            }
-            break;
+            p[ 0 ] = desired[ 0 ];
+            p[ 1 ] = desired[ 1 ];
         }
-        default: { unhandled(); }
-    }
-
-    //tracer.Trace( "expand imm cmode %#llx, from %llx to %llx\n", cmode, imm8, imm64 );
-    return imm64;
-} //adv_simd_expand_imm
+        g_cas128_lock.clear( memory_order_release );
+        return ok;
+    } //host_cas128
+#endif
 
-static inline uint64_t ror( uint64_t elt, uint64_t size )
+bool Arm64::compare_and_swap_pair( uint64_t address, uint64_t expected[ 2 ], const uint64_t desired[ 2 ] )
 {
-    return ( ( elt & 1 ) << ( size - 1 ) ) | ( elt >> 1 );
-} //ror
+    // casp of 64-bit pairs. expected gets the old values
+
+    track( address, 16, true );
+    uint64_t e[ 2 ] = { guest_order( expected[ 0 ] ), guest_order( expected[ 1 ] ) };
+    uint64_t d[ 2 ] = { guest_order( desired[ 0 ] ), guest_order( desired[ 1 ] ) };
+    bool ok = host_cas128( (uint64_t *) getmem( address ), e, d );
+    expected[ 0 ] = guest_order( e[ 0 ] );
+    expected[ 1 ] = guest_order( e[ 1 ] );
+    if ( ok )
+        check_code_write( address, 16 );
+    return ok;
+} //compare_and_swap_pair
 
-static inline uint64_t ror_n( uint64_t elt, uint64_t size, uint64_t amount )
+template <class T> T do_abs( T x )
 {
-    return ( ( elt >> amount ) | ( elt << ( size - amount ) ) );
-} //ror_n
+    return ( x < 0 ) ? -x : x;
+} //do_abs
 
-static uint64_t decode_logical_immediate( uint64_t val, uint64_t bit_width )
+void Arm64::set_flags_from_nzcv( uint64_t nzcv )
 {
-    uint64_t N = get_bit( val, 12 );
-    uint64_t immr = get_bits( val, 6, 6 );
-    uint64_t imms = get_bits( val, 0, 6 );
-
-    uint64_t lzero_count = count_leading_zeroes32( (uint32_t) ( ( N << 6 ) | ( ( ~imms ) & 0x3f ) ) );
-    uint64_t len = 31 - lzero_count;
-    uint64_t size = ( 1ull << len );
-    uint64_t R = ( immr & ( size - 1 ) );
-    uint64_t S = ( imms & ( size - 1 ) );
-    uint64_t pattern = ( 1ull << ( S + 1 ) ) - 1;
-    pattern = ror_n( pattern, size, R );
-
-    assert( 32 == bit_width || 64 == bit_width );
-    while ( size != bit_width )
-    {
-        pattern |= ( pattern << size );
-        size *= 2;
-    }
-
-    if ( 32 == bit_width )
-        pattern = (uint32_t) pattern;
-    return pattern;
-} //decode_logical_immediate
-
-static const char * conditions[16] = { "eq", "ne", "cs", "cc", "mi", "pl", "vs", "vc", "hi", "ls", "ge", "lt", "gt", "le", "al", "nv" };
+    lazy_kind = lazy_none;
+    fN = ( 0 != ( nzcv & 8 ) );
+    fZ = ( 0 != ( nzcv & 4 ) );
+    fC = ( 0 != ( nzcv & 2 ) );
+    fV = ( 0 != ( nzcv & 1 ) );
+} //set_flags_from_nzcv
 
-static const char * get_cond( uint64_t x )
+uint16_t consider_endian16( uint16_t x )
 {
-    if ( x <= 15 )
-        return conditions[ x ];
+#ifdef TARGET_BIG_ENDIAN
+    return flip_endian16( x );
+#endif
+    return x;
+} //consider_endian16
 
-    return "UNKNOWN_CONDITION";
-} //get_cond
+uint32_t consider_endian32( uint32_t x )
+{
+#ifdef TARGET_BIG_ENDIAN
+    return flip_endian32( x );
+#endif
+    return x;
+} //consider_endian32
 
-static char get_byte_len( uint64_t l )
+uint64_t consider_endian64( uint64_t x )
 {
-    if ( 1 == l )
-        return 'b';
-    if ( 2 == l )
-        return 'h';
-    if ( 4 == l )
-        return 's';
-    if ( 8 == l )
-        return 'd';
-    if ( 16 == l )
-        return 'q';
+#ifdef TARGET_BIG_ENDIAN
+    return flip_endian64( x );
+#endif
+    return x;
+} //consider_endian64
 
-    return '?';
-} //get_byte_len
+// load a little-endian value from guest memory or a vector register. big-endian hosts may have a byte-reversing load
 
-static uint64_t vfp_expand_imm( uint64_t imm8, uint64_t N )
-{
-    assert( 16 == N || 32 == N || 64 == N );
-    uint64_t E = ( 16 == N ) ? 5 : ( 32 == N ) ? 8 : 11;
-    uint64_t F = N - E - 1;
-    uint64_t sign = ( 0 != ( imm8 & 0x80 ) );
-    uint64_t exp_part_1 = ( get_bit( imm8, 6 ) ? 0 : 1 );
-    uint64_t exp_part_2 = replicate_bit( get_bit( imm8, 6 ), E - 3 );
-    uint64_t exp_part_3 = get_bits( imm8, 4, 2 );
-    uint64_t exp = ( exp_part_1 << ( E - 3 + 2 ) ) | ( exp_part_2 << 2 ) | exp_part_3;
-    uint64_t frac_shift = F - 4;
-    uint64_t frac = ( imm8 & 0xf ) << frac_shift;
-    uint64_t result = ( sign << ( N - 1 ) ) | ( exp << F ) | frac;
-//    tracer.Trace( "result %#llx, imm8 %llu, N %llu, E %llu, F %llu, sign %llu, exp %#llx, exp1 %#llx, exp2 %#llx, exp3 %#llx, frac_shift %llu, frac %#llx\n",
-//                  result, imm8, N, E, F, sign, exp, exp_part_1, exp_part_2, exp_part_3, frac_shift, frac );
-    return result;
-} //vfp_expand_imm
+#ifdef TARGET_BIG_ENDIAN
+    static uint16_t guest_load16( const void * p ) { return load_le16( p ); }
+    static uint32_t guest_load32( const void * p ) { return load_le32( p ); }
+    static uint64_t guest_load64( const void * p ) { return load_le64( p ); }
+#else
+    static uint16_t guest_load16( const void * p ) { return * (const uint16_t *) p; }
+    static uint32_t guest_load32( const void * p ) { return * (const uint32_t *) p; }
+    static uint64_t guest_load64( const void * p ) { return * (const uint64_t *) p; }
+#endif
 
-static char get_fcvt_precision( uint64_t x )
+static __inline_perf void mcpy( void * d, const void * s, const size_t c ) // memcpy but optimized for small sizes
 {
-    return ( 0 == x ) ? 's' : ( 1 == x ) ? 'd' : ( 3 == x ) ? 'h' : '?';
-} //get_fcvt_precision
+    assert( 1 == c || 2 == c || 4 == c || 8 == c || 16 == c );
 
-void Arm64::trace_state()
-{
-    if ( !tracer.IsEnabled() ) // can happen when an app enables instruction tracing via a syscall but overall tracing is turned off.
-        return;
-
-    static const char * previous_symbol = 0;
-    uint64_t symbol_offset;
-    const char * symbol_name = emulator_symbol_lookup( pc, symbol_offset );
-    if ( symbol_name == previous_symbol )
-        symbol_name = "";
+    // I tried various permutations and this was fastest for msft c++, clang, and g++. loops fail with the latter two
+    if ( 1 == c )
+        * ( (uint8_t *) d ) = * ( (uint8_t *) s );
+    else if ( 2 == c )
+        * ( (uint16_t *) d ) = * ( (uint16_t *) s );
+    else if ( 4 == c )
+        * ( (uint32_t *) d ) = * ( (uint32_t *) s );
     else
-        previous_symbol = symbol_name;
+    {
+        * ( (uint64_t *) d ) = * ( (uint64_t *) s );
+        if ( 16 == c )
+            * ( (uint64_t *) d + 1 ) = * ( (uint64_t *) s + 1 );
+    }
+} //mcpy
 
-    char symbol_offset_str[ 40 ];
-    symbol_offset_str[ 0 ] = 0;
+static uint64_t count_bits( uint64_t x )
+{
+#ifdef _M_AMD64
+        return __popcnt64( x ); // less portable, but faster. Not on Q9650 CPU and other older Intel CPUs. use code below instead if needed.
+#elif defined( __aarch64__ )
+        return std::bitset<64>( x ).count();
+#else
+    uint64_t count = 0;
+    while ( 0 != x )
+    {
+        if ( x & 1 )
+            count++;
+        x >>= 1;
+    }
+    return count;
+#endif
+} //count_bits
 
-    if ( 0 != symbol_name[ 0 ] )
+static uint32_t count_leading_zeroes32( uint32_t x )
+{
+#ifdef _WIN32 // if targeting older CPUs you may need to rebuild with the manual code below
+    DWORD lz = 0;
+    if ( _BitScanReverse( &lz, x ) )
+        return 31 - lz;
+    return 32;
+#elif defined( __GNUC__ ) || defined( __clang__ )
+    return __builtin_clz( x );
+#else
+    uint32_t count = 0;
+    while ( x )
     {
-        if ( 0 != symbol_offset )
-            snprintf( symbol_offset_str, _countof( symbol_offset_str ), " + %llx", symbol_offset );
-        strcat( symbol_offset_str, "\n            " );
+        count++;
+        x >>= 1;
     }
 
-    //tracer.TraceBinaryData( getmem( 0x2cb97f0 + 16 ), 16, 4 );
+    return 32 - count;
+#endif
+} //count_leading_zeroes32
 
-    tracer.Trace( "pc %8llx %s%s op %08llx %s ==> ", pc, symbol_name, symbol_offset_str, op, render_flags() );
+#ifdef _WIN32
+__declspec(noinline)
+#endif
+void Arm64::unhandled()
+{
+    emulator_hard_termination( *this, "opcode not handled:", op );
+} //unhandled
 
-    uint8_t hi8 = (uint8_t) ( op >> 24 );
-    switch ( hi8 )
-    {
-        case 0: // UDF
-        {
-            uint64_t bits23to16 = opbits( 16, 8 );
-            uint64_t imm16 = opbits( 0, 16 );
-            if ( 0 == bits23to16 )
-                tracer.Trace( "udf %#llx\n", imm16 );
-            else
-                unhandled();
-            break;
-        }
-        case 0x5f: // SHL D<d>, D<n>, #<shift>    ;    FMUL <Vd>.<T>, <Vn>.<T>, <Vm>.<Ts>[<index>]    ;    FMLA <Vd>.<T>, <Vn>.<T>, <Vm>.<Ts>[<index>]
-                   // SSHR D<d>, D<n>, #<shift>
-        {
-            uint64_t n = opbits( 5, 5 );
-            uint64_t d = opbits( 0, 5 );
-            uint64_t opcode = opbits( 10, 6 );
-            uint64_t immh = opbits( 19, 4 );
-            uint64_t immb = opbits( 16, 3 );
-            uint64_t bit23 = opbit( 23 );
-            uint64_t bit22 = opbit( 22 );
-            uint64_t bits15_10 = opbits( 10, 6 );
+Arm64::FPRounding Arm64::fp_decode_rm( uint64_t rm )
+{
+    if ( 0 == rm )
+        return FPRounding_TIEAWAY;
+    if ( 1 == rm )
+        return FPRounding_TIEEVEN;
+    if ( 2 == rm )
+        return FPRounding_POSINF;
+    if ( 3 == rm )
+        return FPRounding_NEGINF;
+    unhandled();
+    return FPRounding_TIEEVEN; // keep the compiler happy
+} //fp_decode_rm
 
-            if ( !bit23 && bit22 && 0x15 == opcode ) // SHL D<d>, D<n>, #<shift>
-            {
-                uint64_t esize = 8ull << 3;
-                uint64_t shift = ( ( immh << 3 ) | immb ) - esize;
-                tracer.Trace( "shl d%llu, d%llu, #%llu\n", d, n, shift );
-            }
-            else if ( bit23 && ( 4 == opcode || 6 == opcode || 0x24 == opcode || 0x26 == opcode ) ) // FMUL <Vd>.<T>, <Vn>.<T>, <Vm>.<Ts>[<index>]    ;    FMLA <Vd>.<T>, <Vn>.<T>, <Vm>.<Ts>[<index>]
-            {
-                uint64_t m = opbits( 16, 5 );
-                uint64_t sz = opbit( 22 );
-                uint64_t L = opbit( 21 );
-                uint64_t M = opbit( 20 );
-                uint64_t H = opbit( 11 );
-                char v = sz ? 'd' : 's';
-                uint64_t Rmhi = M;
-                if ( 0 == sz )
-                    Rmhi = ( H << 1 ) | L;
-                else if ( 0 == L )
-                    Rmhi = H;
-                else
-                    unhandled();
+Arm64::FPRounding Arm64::fp_decode_rmode( uint64_t rmode ) // rmode is what is stored in 23:22 of fpcr
+{
+    if ( 0 == rmode )
+        return FPRounding_TIEEVEN;
+    if ( 1 == rmode )
+        return FPRounding_POSINF;
+    if ( 2 == rmode )
+        return FPRounding_NEGINF;
+    if ( 3 == rmode )
+        return FPRounding_ZERO;
+    unhandled();
+    return FPRounding_TIEEVEN; // keep the compiler happy
+} //fp_decode_rmode
 
-                tracer.Trace( "%s %c%llu, %c%llu, v%llu.%c[%llu]\n", ( 4 == opcode || 6 == opcode ) ? "fmla" : "fmul", v, d, v, n, m, v, Rmhi );
-            }
-            else if ( !bit23 && bit22 && 1 == bits15_10 ) // SSHR D<d>, D<n>, #<shift>
-            {
-                uint64_t esize = 8ull << 3;
-                uint64_t shift = ( esize * 2 ) - ( ( immh << 3 ) | immb );
-                tracer.Trace( "sshr d%llu, d%llu, #%llu\n", d, n, shift );
-            }
-            else
-                unhandled();
-            break;
-        }
-        case 0x0d: case 0x4d: // LD1 { <Vt>.B }[<index>], [<Xn|SP>]    ;    LD1 { <Vt>.B }[<index>], [<Xn|SP>], #1
-                              // LD1R { <Vt>.<T> }, [<Xn|SP>], <imm>   ;    LD1R { <Vt>.<T> }, [<Xn|SP>], <Xm>
-                              // ST1 { <Vt>.B }[<index>], [<Xn|SP>]    ;    ST1 { <Vt>.B }[<index>], [<Xn|SP>], #1
-        {
-            uint64_t R = opbit( 21 );
-            if ( R )
-                unhandled();
-            uint64_t post_index = opbit( 23 );
-            uint64_t opcode = opbits( 13, 3 );
-            uint64_t bit13 = opbit( 13 );
-            if ( bit13 )
-                unhandled();
-            uint64_t size = opbits( 10, 2 );
-            uint64_t n = opbits( 5, 5 );
-            uint64_t m = opbits( 16, 5 );
-            uint64_t t = opbits( 0, 5 );
-            uint64_t replicate = ( 6 == opcode );
-            uint64_t S = opbit( 12 );
-            uint64_t Q = opbit( 30 );
-            uint64_t L = opbit( 22 );
-            uint64_t index = 0;
-            uint64_t scale = get_bits( opcode, 1, 2 );
-            if ( 3 == scale )
-                scale = size;
-            else if ( 0 == scale )
-                index = ( Q << 3 ) | ( S << 2 ) | size;
-            else if ( 1 == scale )
-                index = ( Q << 2 ) | ( S << 1 ) | get_bit( size, 1 );
-            else if ( 2 == scale )
-            {
-                if ( 0 == ( size & 1 ) )
-                    index = ( Q << 1 ) | S;
-                else
-                {
-                    index = Q;
-                    scale = 3;
-                }
-            }
+static const char * get_rmode_text( uint64_t rmode )
+{
+    if ( 0 == rmode )
+        return "FPRounding_TIEEVEN";
+    if ( 1 == rmode )
+        return "FPRounding_POSINF";
+    if ( 2 == rmode )
+        return "FPRounding_NEGINF";
+    if ( 3 == rmode )
+        return "FPRounding_ZERO";
+    return "unknown";
+} //get_rmode_text
 
-            const char * pOP = L ? "ld" : "st";
-            char type = ( 0 == opcode ) ? 'b' : ( 2 == opcode ) ? 'h' : ( 4 == opcode && 0 == size ) ? 's' : 'd';
-            if ( post_index )
-            {
-                if ( 31 == m ) // immediate offset
-                {
-                    uint64_t imm = 1ull << size;
-                    tracer.Trace( "%s1%s {v%llu.%c}[%llu], [%s], #%llu\n", pOP, replicate ? "r" : "", t, type, index, reg_or_sp( n, true ), imm );
-                }
-                else // register offset
-                    tracer.Trace( "%s1%s {v%llu.%c}[%llu], [%s], %s\n", pOP, replicate ? "r" : "", t, type, index, reg_or_sp( n, true ), reg_or_zr( m, true ) );
-            }
-            else // no offset
-                tracer.Trace( "%s1%s {v%llu.%c}[%llu], [%s]\n", pOP, replicate ? "r" : "", t, type, index, reg_or_sp( n, true ) );
-            break;
-        }
-        case 0x08: // LDAXRB <Wt>, [<Xn|SP>{, #0}]    ;    LDARB <Wt>, [<Xn|SP>{, #0}]    ;    STLXRB <Ws>, <Wt>, [<Xn|SP>{, #0}]    ;    STLRB <Wt>, [<Xn|SP>{, #0}]
-                   // STXRB <Ws>, <Wt>, [<Xn|SP>{, #0}] ;  LDXRB <Wt>, [<Xn|SP>{, #0}]
-        case 0x48: // LDAXRH <Wt>, [<Xn|SP>{, #0}]    ;    LDARH <Wt>, [<Xn|SP>{, #0}]    ;    STLXRH <Ws>, <Wt>, [<Xn|SP>{, #0}]    ;    STLRH <Wt>, [<Xn|SP>{, #0}]
-                   // STXRH <Ws>, <Wt>, [<Xn|SP>{, #0}] ;  LDXRH <Wt>, [<Xn|SP>{, #0}]
-        {
-            uint64_t bit23 = opbit( 23 );
-            uint64_t L = opbit( 21 );
-            uint64_t bit21 = opbit( 21 );
-            uint64_t s = opbits( 16, 5 );
-            uint64_t oO = opbit( 15 );
-            uint64_t t2 = opbits( 10, 5 );
-            uint64_t n = opbits( 5, 5 );
-            uint64_t t = opbits( 0, 5 );
+double Arm64::round_double( double d, FPRounding rounding )
+{
+    if ( FPRounding_NEGINF == rounding )
+        return floor( d );
+    if ( FPRounding_POSINF == rounding )
+        return ceil( d );
+    if ( FPRounding_TIEEVEN == rounding || FPRounding_TIEAWAY == rounding )
+        return round( d );
+    if ( FPRounding_ODD == rounding )
+    {
+        double rounded = d;
+        if ( ( 0 == fmod( rounded, 2 ) ) && ( 0.5 == fabs( d - rounded ) ) )
+            rounded += ( d > 0.0 ) ? 1.0 : -1.0;
 
-            if ( 0 != bit21 || 0x1f != t2 )
-                unhandled();
+        return rounded;
+    }
+    if ( FPRounding_ZERO == rounding )
+        return (double) (int64_t) d;
 
-            char suffix = ( hi8 & 0x40 ) ? 'h' : 'b';
+    unhandled();
+    return d; // keep the compiler happy
+} //round_double
 
-            if ( L )
-            {
-                if ( 0x1f != s )
-                    unhandled();
-                tracer.Trace( "%s%c, w%llu, [%s, #0]\n", bit23 ? "ldar" : oO ? "ldaxr" : "ldxr", suffix, t, reg_or_sp( n, true ) );
-            }
-            else
-            {
-                if ( bit23 )
-                    tracer.Trace( "stlr%c w%llu, [%s, #0]\n", suffix, t, reg_or_sp( n, true ) );
-                else
-                    tracer.Trace( "%s%c w%llu, w%llu, [%s, #0]\n", oO ? "stlxr" : "stxr", suffix, s, t, reg_or_sp( n, true ) );
-            }
-            break;
-        }
-        case 0x1f: // fmadd, vnmadd, fmsub, fnmsub
-        {
-            uint64_t ftype = opbits( 22, 2 );
-            uint64_t bit21 = opbit( 21 );
-            uint64_t bit15 = opbit( 15 );
-            uint64_t m = opbits( 16, 5 );
-            uint64_t a = opbits( 10, 5 );
-            uint64_t n = opbits( 5, 5 );
-            uint64_t d = opbits( 0, 5 );
+int32_t Arm64::double_to_fixed_int32( double d, uint64_t fracbits, FPRounding rounding )
+{
+    if ( d >= INT32_MAX )
+        return INT32_MAX;
 
-            bool isn = ( 0 != bit21 );
-            char t = ( 0 == ftype ) ? 's' : ( 3 == ftype ) ? 'h' : ( 1 == ftype ) ? 'd' : '?';
-            if ( !bit15 )
-                tracer.Trace( "%s %c%llu, %c%llu, %c%llu, %c%llu\n", isn ? "fnmadd" : "fmadd", t, d, t, n, t, m, t, a );
-            else
-                tracer.Trace( "%s %c%llu, %c%llu, %c%llu, %c%llu\n", isn ? "fnmsub" : "fmsub", t, d, t, n, t, m, t, a );
-            break;
-        }
-        case 0x3c: // LDR <Bt>, [<Xn|SP>], #<simm>    ;    LDR <Bt>, [<Xn|SP>, #<simm>]!    ;    LDR <Qt>, [<Xn|SP>], #<simm>    ;     LDR <Qt>, [<Xn|SP>, #<simm>]!
-        case 0x3d: // LDR <Bt>, [<Xn|SP>{, #<pimm>}]  ;    LDR <Qt>, [<Xn|SP>{, #<pimm>}]
-        case 0x7c: // LDR <Ht>, [<Xn|SP>], #<simm>    ;    LDR <Ht>, [<Xn|SP>, #<simm>]!
-        case 0x7d: // LDR <Ht>, [<Xn|SP>{, #<pimm>}]
-        case 0xbc:
-        case 0xbd: // LDR <Dt>, [<Xn|SP>{, #<pimm>}]
-        case 0xfc: // LDR <Dt>, [<Xn|SP>], #<simm>    ;    LDR <Dt>, [<Xn|SP>, #<simm>]!    ;    STR <Dt>, [<Xn|SP>], #<simm>    ;    STR <Dt>, [<Xn|SP>, #<simm>]!
-        case 0xfd: // LDR <Dt>, [<Xn|SP>{, #<pimm>}]  ;    STR <Dt>, [<Xn|SP>{, #<pimm>}]   ;    STR <Dt>, [<Xn|SP>, (<Wm>|<Xm>){, <extend> {<amount>}}]
-        {
-            uint64_t bits11_10 = opbits( 10, 2 );
-            uint64_t bit21 = opbit( 21 );
-            bool unsignedOffset = ( 0xd == ( hi8 & 0xf ) );
-            bool preIndex = ( ( 0xc == ( hi8 & 0xf ) ) && ( 3 == bits11_10 ) );
-            bool postIndex = ( ( 0xc == ( hi8 & 0xf ) ) && ( 1 == bits11_10 ) );
-            bool signedUnscaledOffset = ( ( 0xc == ( hi8 & 0xf ) ) && ( 0 == bits11_10 ) );
-            bool shiftExtend = ( ( 0xc == ( hi8 & 0xf ) ) && ( bit21 ) && ( 2 == bits11_10 ) );
-            uint64_t imm12 = opbits( 10, 12 );
-            int64_t imm9 = sign_extend( opbits( 12, 9 ), 8 );
-            uint64_t size = opbits( 30, 2 );
-            uint64_t opc = opbits( 22, 2 );
-            bool is_ldr = opbit( 22 );
-            uint64_t t = opbits( 0, 5 );
-            uint64_t n = opbits( 5, 5 );
-            uint64_t byte_len = 1ull << size;
+    if ( d <= INT32_MIN )
+        return INT32_MIN;
 
-            if ( is_ldr )
-            {
-                if ( 3 == opc )
-                    byte_len = 16;
+    return (int32_t) round_double( d * ( 1ull << fracbits ), rounding );
+} //double_to_fixed_int32
 
-                if ( preIndex )
-                    tracer.Trace( "ldr %c%llu, [%s, #%lld]! //pr\n", get_byte_len( byte_len ), t, reg_or_sp( n, true ), imm9 );
-                else if ( postIndex )
-                    tracer.Trace( "ldr %c%llu, [%s] #%lld //po\n", get_byte_len( byte_len ), t, reg_or_sp( n, true ), imm9 );
-                else if ( unsignedOffset )
-                    tracer.Trace( "ldr %c%llu, [%s, #%llu] //uo\n", get_byte_len( byte_len ), t, reg_or_sp( n, true ), imm12 * byte_len );
-                else if ( signedUnscaledOffset )
-                    tracer.Trace( "ldur %c%llu, [%s, #%lld] //so\n", get_byte_len( byte_len ), t, reg_or_sp( n, true ), imm9 );
-                else if ( shiftExtend )
-                {
-                    uint64_t option = opbits( 13, 3 );
-                    uint64_t m = opbits( 16, 5 );
-                    uint64_t shift = 0;
-                    uint64_t S = opbit( 12 );
-                    if ( 0 != S )
-                    {
-                        if ( 0 == size )
-                        {
-                           if ( 3 == opc )
-                               shift = 4;
-                           else if ( 1 != opc )
-                               unhandled();
-                        }
-                        else if ( 1 == size && 1 == opc )
-                            shift = 1;
-                        else if ( 2 == size && 1 == opc )
-                            shift = 2;
-                        else if ( 3 == size && 1 == opc )
-                            shift = 3;
-                        else
-                            unhandled();
-                    }
+uint32_t Arm64::double_to_fixed_uint32( double d, uint64_t fracbits, FPRounding rounding )
+{
+    if ( d >= UINT32_MAX )
+        return UINT32_MAX;
 
-                    tracer.Trace( "ldr %c%llu, [%s, %s, %s, #%lld] //se\n", get_byte_len( byte_len ), t, reg_or_sp( n, true ), reg_or_zr( m, true ),
-                                   extend_type( option ), shift );
-                }
-                else
-                    unhandled();
-            }
-            else // str
-            {
-                if ( 2 == opc )
-                    byte_len = 16;
+    double val = round_double( d * ( 1ull << fracbits ), rounding );
+    if ( val < 0.0 )
+        val = 0.0;
+    return (uint32_t) val;
+} //double_to_fixed_uint32
 
-                if ( preIndex )
-                    tracer.Trace( "str %c%llu, [%s, #%lld]! //pr\n", get_byte_len( byte_len ), t, reg_or_sp( n, true ), imm9 );
-                else if ( postIndex )
-                    tracer.Trace( "str %c%llu, [%s] #%lld //po\n", get_byte_len( byte_len ), t, reg_or_sp( n, true ), imm9 );
-                else if ( unsignedOffset )
-                    tracer.Trace( "str %c%llu, [%s, #%llu] //uo\n", get_byte_len( byte_len ), t, reg_or_sp( n, true ), imm12 * byte_len );
-                else if ( signedUnscaledOffset )
-                    tracer.Trace( "stur %c%llu, [%s, #%lld] //so\n", get_byte_len( byte_len ), t, reg_or_sp( n, true ), imm9 );
-                else if ( shiftExtend )
-                {
-                    uint64_t option = opbits( 13, 3 );
-                    uint64_t m = opbits( 16, 5 );
-                    uint64_t shift = 0;
-                    uint64_t S = opbit( 12 );
-                    if ( 0 != S )
-                    {
-                        if ( 0 == size )
-                        {
-                           if ( 2 == opc )
-                               shift = 4;
-                           else if ( 0 != opc )
-                               unhandled();
-                        }
-                        else if ( 1 == size && 0 == opc )
-                            shift = 1;
-                        else if ( 2 == size && 0 == opc )
-                            shift = 2;
-                        else if ( 3 == size && 0 == opc )
-                            shift = 3;
-                        else
-                            unhandled();
-                    }
+int64_t Arm64::double_to_fixed_int64( double d, uint64_t fracbits, FPRounding rounding )
+{
+    if ( d >= (double) INT64_MAX )
+        return INT64_MAX;
 
-                    tracer.Trace( "str %c%llu, [%s, %s, %s, #%lld] //se\n", get_byte_len( byte_len ), t, reg_or_sp( n, true ), reg_or_zr( m, true ),
-                                   extend_type( option ), shift );
-                }
-                else
-                    unhandled();
-            }
-            break;
-        }
-        case 0x2c: // STP <St1>, <St2>, [<Xn|SP>], #<imm>     ;    LDP <St1>, <St2>, [<Xn|SP>], #<imm>
-        case 0x6c: // STP <Dt1>, <Dt2>, [<Xn|SP>], #<imm>     ;    LDP <Dt1>, <Dt2>, [<Xn|SP>], #<imm>
-        case 0xac: // STP <Qt1>, <Qt2>, [<Xn|SP>], #<imm>          LDP <Qt1>, <Qt2>, [<Xn|SP>], #<imm>
-        case 0x2d: // STP <St1>, <St2>, [<Xn|SP>, #<imm>]!    ;    STP <St1>, <St2>, [<Xn|SP>{, #<imm>}]    ;    LDP <St1>, <St2>, [<Xn|SP>, #<imm>]!    ;    LDP <St1>, <St2>, [<Xn|SP>{, #<imm>}]
-        case 0x6d: // STP <Dt1>, <Dt2>, [<Xn|SP>, #<imm>]!    ;    STP <Dt1>, <Dt2>, [<Xn|SP>{, #<imm>}]    ;    LDP <Dt1>, <Dt2>, [<Xn|SP>, #<imm>]!    ;    LDP <Dt1>, <Dt2>, [<Xn|SP>{, #<imm>}]
-        case 0xad: // STP <Qt1>, <Qt2>, [<Xn|SP>, #<imm>]!    ;    STP <Qt1>, <Qt2>, [<Xn|SP>{, #<imm>}]    ;    LDP <Qt1>, <Qt2>, [<Xn|SP>, #<imm>]!    ;    LDP <Qt1>, <Qt2>, [<Xn|SP>{, #<imm>}]
-        {
-            uint64_t opc = opbits( 30, 2 );
-            char vector_width = ( 0 == opc ) ? 's' : ( 1 == opc ) ? 'd' : 'q';
-            uint64_t imm7 = opbits( 15, 7 );
-            uint64_t t2 = opbits( 10, 5 );
-            uint64_t n = opbits( 5, 5 );
-            uint64_t t1 = opbits( 0, 5 );
-            uint64_t L = opbit( 22 );
-            uint64_t bit23 = opbit( 23 );
+    if ( d <= (double) INT64_MIN )
+        return INT64_MIN;
 
-            bool preIndex = ( ( 0xd == ( hi8 & 0xf ) ) && bit23 );
-            bool postIndex = ( ( 0xc == ( hi8 & 0xf ) ) && bit23 );
-            bool signedOffset = ( ( 0xd == ( hi8 & 0xf ) ) && !bit23 );
+    return (int64_t) round_double( d * ( 1ull << fracbits ), rounding );
+} //double_to_fixed_int64
 
-            uint64_t scale = 2 + opc;
-            int64_t offset = sign_extend( imm7, 6 ) << scale;
+uint64_t Arm64::double_to_fixed_uint64( double d, uint64_t fracbits, FPRounding rounding )
+{
+    if ( d >= (double) UINT64_MAX )
+        return UINT64_MAX;
 
-            if ( L )
-            {
-                if ( postIndex )
-                   tracer.Trace( "ldp %c%llu, %c%llu, [%s], #%lld //po\n", vector_width, t1, vector_width, t2, reg_or_sp( n, true ), offset );
-                else if ( preIndex )
-                   tracer.Trace( "ldp %c%llu, %c%llu, [%s, #%lld]! //pr\n", vector_width, t1, vector_width, t2, reg_or_sp( n, true ), offset );
-                else if ( signedOffset )
-                   tracer.Trace( "ldp %c%llu, %c%llu, [%s, #%lld] //so\n", vector_width, t1, vector_width, t2, reg_or_sp( n, true ), offset );
-                else
-                    unhandled();
-            }
-            else
-            {
-                if ( postIndex )
-                   tracer.Trace( "stp %c%llu, %c%llu, [%s], #%lld //po\n", vector_width, t1, vector_width, t2, reg_or_sp( n, true ), offset );
-                else if ( preIndex )
-                   tracer.Trace( "stp %c%llu, %c%llu, [%s, #%lld]! //pr\n", vector_width, t1, vector_width, t2, reg_or_sp( n, true ), offset );
-                else if ( signedOffset )
-                   tracer.Trace( "stp %c%llu, %c%llu, [%s, #%lld] //so\n", vector_width, t1, vector_width, t2, reg_or_sp( n, true ), offset );
-                else
-                    unhandled();
-            }
-            break;
-        }
-        case 0x0f: case 0x2f: case 0x4f: case 0x6f: case 0x7f:
-            // BIC <Vd>.<T>, #<imm8>{, LSL #<amount>}    ;    MOVI <Vd>.<T>, #<imm8>{, LSL #0}    ;          MVNI <Vd>.<T>, #<imm8>, MSL #<amount>
-            // USHR <Vd>.<T>, <Vn>.<T>, #<shift>         ;    FMUL <Vd>.<T>, <Vn>.<T>, <Vm>.<Ts>[<index>]  ; MVNI <Vd>.<T>, #<imm8>{, LSL #<amount>}
-            // FMOV <Vd>.<T>, #<imm>                     ;    FMOV <Vd>.<T>, #<imm>               ;    FMOV <Vd>.2D, #<imm>
-            // USHLL{2} <Vd>.<Ta>, <Vn>.<Tb>, #<shift>   ;    SHRN{2} <Vd>.<Tb>, <Vn>.<Ta>, #<shift>  ;   SSHLL{2} <Vd>.<Ta>, <Vn>.<Tb>, #<shift>
-            // FMLA <Vd>.<T>, <Vn>.<T>, <Vm>.<Ts>[<index>] ;  SSHR <Vd>.<T>, <Vn>.<T>, #<shift>   ;    SHL <Vd>.<T>, <Vn>.<T>, #<shift>
-            // MUL <Vd>.<T>, <Vn>.<T>, <Vm>.<Ts>[<index>] ;   URSRA <Vd>.<T>, <Vn>.<T>, #<shift>  ;    USRA <Vd>.<T>, <Vn>.<T>, #<shift>
-            // ORR <Vd>.<T>, #<imm8>{, LSL #<amount>}    ;    MOVI <Vd>.<T>, #<imm8>, MSL #<amount>  ; 
-        {
-            uint64_t cmode = opbits( 12, 4 );
-            uint64_t abc = opbits( 16, 3 );
-            uint64_t defgh = opbits( 5, 5 );
-            uint64_t val = ( abc << 5 ) | defgh;
-            uint64_t Q = opbit( 30 );
-            uint64_t bit29 = opbit( 29 );
-            uint64_t o2 = opbits( 11,1 );
-            uint64_t bit10 = opbit( 10 );
-            uint64_t bit11 = opbit( 11 );
-            uint64_t bit12 = opbit( 12 );
-            uint64_t bit23 = opbit( 23 );
-            uint64_t d = opbits( 0, 5 );
-            uint64_t bits23_19 = opbits( 19, 5 );
-            uint64_t imm = adv_simd_expand_imm( bit29, cmode, val );
-            //tracer.Trace( "bit12: %llu, cmode %llx, bit29 %llu, bit11 %llu, bit10 %llu\n", bit12, cmode, bit29, bit11, bit10 );
+    double val = round_double( d * ( 1ull << fracbits ), rounding );
+    if ( val < 0.0 )
+        val = 0.0;
+    return (uint64_t) val;
+} //double_to_fixed_uint64
 
-            if ( 0 == bits23_19 )
-            {
-                if ( ( 0x4f == hi8 || 0x0f == hi8 ) && ( 0xc == ( cmode & 0xe ) ) && !bit11 && bit10 ) // MOVI <Vd>.<T>, #<imm8>, MSL #<amount>
-                {
-                    const char * pT = Q ? "4s" : "2s";
-                    uint64_t amount = ( cmode & 1 ) ? 16 : 8;
-                    tracer.Trace( "movi v%llu.%s, #%llu, msl #%llu\n", d, pT, imm, amount );
-                }
-                else if ( ( 0x0f == hi8 || 0x4f == hi8 ) && ( 9 == ( 0xd & cmode ) || 1 == ( 9 & cmode ) ) && bit12 && !bit11 && bit10 ) // ORR <Vd>.<T>, #<imm8>{, LSL #<amount>}
-                {
-                    if ( 9 == ( 0xd & cmode ) ) // 16-bit variant
-                    {
-                        const char * pT = Q ? "8h" : "4h";
-                        uint64_t amount = ( cmode & 2 ) ? 8 : 0;
-                        tracer.Trace( "orr v%llu.%s, #%#llx, LSL #%llu\n", d, pT, val, amount );
-                    }
-                    else if ( 1 == ( 9 & cmode ) ) // 32-bit variant
-                    {
-                        const char * pT = Q ? "4s" : "2s";
-                        uint64_t amount = 8 * get_bits( cmode, 1, 2 );
-                        tracer.Trace( "orr v%llu.%s, #%#llx, LSL #%llu\n", d, pT, val, amount );
-                    }
-                    else
-                        unhandled();
-                }
-                else if ( ( 0x2f == hi8 || 0x6f == hi8 ) && !bit11 && bit10 &&
-                     ( ( 8 == ( cmode & 0xd ) ) || ( 0 == ( cmode & 9 ) ) || ( 0xc == ( cmode & 0xe ) ) ) ) // mvni
-                {
-                    if ( 8 == ( cmode & 0xd ) ) // 16-bit shifted immediate
-                    {
-                        uint64_t amount = ( cmode & 2 ) ? 8 : 0;
-                        const char * pT = Q ? "8H" : "4H";
-                        tracer.Trace( "mvni v%llu.%s, #%#llx, lsl #%llu\n", d, pT, val, amount );
-                    }
-                    else if ( 0 == ( cmode & 9 ) ) // 32-bit shifted immediate
-                    {
-                        uint64_t amount = get_bits( cmode, 1, 2 ) * 8;
-                        const char * pT = Q ? "4S" : "2S";
-                        tracer.Trace( "mvni v%llu.%s, #%#llx, lsl #%llu\n", d, pT, val, amount );
-                    }
-                    else if ( 0xc == ( cmode & 0xe ) ) // 32-bit shifting ones
-                    {
-                        imm = adv_simd_expand_imm( 1, cmode, val );
-                        uint64_t amount = get_bit( cmode, 0 ) ? 16 : 8;
-                        const char * pT = Q ? "4S" : "2S";
-                        tracer.Trace( "mvni v%llu.%s, #%#llx, msl #%llu\n", d, pT, val, amount );
-                    }
-                    else
-                        unhandled();
-                }
-                else if ( !bit12 || ( 0xc == ( cmode & 0xe ) ) ) // movi
-                {
-                    if ( !bit29 ) // movi
-                    {
-                        if ( 0xe == cmode )
-                        {
-                            const char * pT = Q ? "16B" : "8B";
-                            tracer.Trace( "movi v%llu.%s, #%#llx // imm %llx\n", d, pT, val, imm );
-                        }
-                        else if ( 8 == ( cmode & 0xd ) )
-                        {
-                            const char * pT = Q ? "8H" : "4H";
-                            uint64_t amount = ( cmode & 2 ) ? 8 : 0;
-                            tracer.Trace( "movi v%llu.%s, #%#llx, lsl #%llu\n", d, pT, imm, amount );
-                        }
-                        else if ( 0 == ( cmode & 9 ) )
-                        {
-                            const char * pT = Q ? "4S" : "2S";
-                            uint64_t amount = ( 8 * ( ( cmode >> 1 ) & 3 ) );
-                            tracer.Trace( "movi v%llu.%s, #%#llx, lsl #%llu\n", d, pT, imm, amount );
-                        }
-                        else if ( 0xa == ( cmode & 0xe ) )
-                        {
-                            const char * pT = Q ? "4S" : "2S";
-                            uint64_t amount = ( cmode & 1 ) ? 16 : 8;
-                            tracer.Trace( "movi v%llu.%s, #%#llx, msl #%llu\n", d, pT, imm, amount );
-                        }
-                        else
-                            unhandled();
-                    }
-                    else // movi
-                    {
-                        uint64_t a = opbit( 18 );
-                        uint64_t b = opbit( 17 );
-                        uint64_t c = opbit( 16 );
-                        uint64_t bitd = opbit( 9 );
-                        uint64_t e = opbit( 8 );
-                        uint64_t f = opbit( 7 );
-                        uint64_t g = opbit( 6 );
-                        uint64_t h = opbit( 5 );
+static uint64_t get_bit( uint64_t x, uint64_t bit_number )
+{
+    assert( 64 != bit_number );
+    return ( ( x >> bit_number ) & 1 );
+} //get_bit
 
-                        imm = a ? ( 0xffull << 56 ) : 0;
-                        imm |= b ? ( 0xffull << 48 ) : 0;
-                        imm |= c ? ( 0xffull << 40 ) : 0;
-                        imm |= bitd ? ( 0xffull << 32 ) : 0;
-                        imm |= e ? ( 0xffull << 24 ) : 0;
-                        imm |= f ? ( 0xffull << 16 ) : 0;
-                        imm |= g ? ( 0xffull << 8 ) : 0;
-                        imm |= h ? 0xffull : 0;
+static uint64_t gen_bitmask( uint64_t n )
+{
+    if ( 0 == n )
+        return 0;
 
-                        //tracer.Trace( "movi bit29 must be 1, Q %llu, cmode %llu\n", Q, cmode );
+    return ( ~0ull ) >> ( 64ull - n );
+} //gen_bitmask
 
-                        if ( ( 0 == Q ) && ( cmode == 0xe ) )
-                            tracer.Trace( "movi D%llu, #%#llx\n", d, imm );
-                        else if ( ( 1 == Q ) && ( cmode == 0xe ) )
-                            tracer.Trace( "movi V%llu.2D, #%#llx\n", d, imm );
-                        else
-                            unhandled();
-                    }
-                }
-                else if ( ( 0x6f == hi8 || 0x4f == hi8 || 0x2f == hi8 || 0x0f == hi8 ) && 0xf == cmode && !bit11 && bit10 ) // fmov single and double precision immediate
-                {
-                    double dval = 0.0;
-                    tracer.Trace( "imm6: %#llx\n", imm );
-                    if ( bit29 )
-                        mcpy( &dval, &imm, sizeof( dval ) );
-                    else
-                    {
-                        float float_val;
-                        mcpy( &float_val, &imm, sizeof( float_val ) );
-                        dval = (double) float_val;
-                    }
-                    tracer.Trace( "fmov v%llu.%s, #%lf\n", d, bit29 ? "2D" : Q ? "4S" : "2S", dval );
-                }
-                else if ( !bit29 ) // BIC register
-                {
-                    unhandled();
-                }
-                else if ( bit29 && bit12 ) // BIC immediate
-                {
-                    if ( 0 != o2 || 1 != bit10 )
-                        unhandled();
+static uint64_t get_elem_bits( uint64_t val, uint64_t c, uint64_t container_size )
+{
+    uint64_t mask = gen_bitmask( container_size );
+    return ( val & ( mask << ( c * container_size ) ) );
+} //get_elem_bits
 
-                    bool sixteen_bit_mode = ( cmode == 0x9 || cmode == 0xb );
-                    const char * pT = "";
-                    uint64_t amount = 0;
-                    if ( sixteen_bit_mode )
-                    {
-                        pT = Q ? "8H" : "4H";
-                        amount = ( cmode & 2 ) ? 8 : 0;
-                    }
-                    else
-                    {
-                        pT = Q ? "4S" : "2S";
-                        amount = 8 * ( ( cmode >> 1 ) & 3 );
-                    }
+static uint64_t get_bits( uint64_t x, uint64_t lowbit, uint64_t len )
+{
+    uint64_t val = ( x >> lowbit );
+    if ( 64 == len ) // this actually happens
+        return val;
+    return ( val & ( ( 1ull << len ) - 1 ) );
+} //get_bits
 
-                    tracer.Trace( "bic v%llu.%s, #%#llx, lsl #%llu\n", d, pT, val, amount );
-                    //tracer.Trace( "bic bonus: cmode %#llx, val: %#llx, abc %#llx, defgh %#llx, sixteen_bit_mode %d, imm %#llx\n", cmode, val, abc, defgh, sixteen_bit_mode, imm );
-                }
-            }
-            else // USHR, USHLL, SHRN, SHRN2, etc
-            {
-                uint64_t opcode = opbits( 12, 4 );
-                uint64_t bits23_22 = opbits( 22, 2 );
-                uint64_t bits15_12 = opbits( 12, 4 );
-                uint64_t immh = opbits( 19, 4 );
+static uint64_t reverse_bytes( uint64_t val, uint64_t n )
+{
+    uint64_t result = 0;
 
-                if ( ( 0x2f == hi8 || 0x6f == hi8 ) && !bit23 && 0 != immh && 1 == bits15_12 && !bit11 && bit10 ) // USRA <Vd>.<T>, <Vn>.<T>, #<shift>
-                {
-                    uint64_t immb = opbits( 16, 3 );
-                    uint64_t n = opbits( 5, 5 );
-                    uint64_t esize = 8ull << highest_set_bit_nz( immh );
-                    uint64_t shift = ( esize * 2 ) - ( ( immh << 3 ) | immb );
-                    const char * pT = get_sshr_vector_T( immh, Q );
-                    tracer.Trace( "usra v%llu.%s, v%llu.%s, #%llu\n", d, pT, n, pT, shift );
-                }
-                else if ( ( 0x0f == hi8 || 0x4f == hi8 ) && !bit23 && 0 != immh && 1 == bits15_12 && !bit11 && bit10 ) // SSRA <Vd>.<T>, <Vn>.<T>, #<shift>
-                {
-                    uint64_t immb = opbits( 16, 3 );
-                    uint64_t n = opbits( 5, 5 );
-                    uint64_t esize = 8ull << highest_set_bit_nz( immh );
-                    uint64_t shift = ( esize * 2 ) - ( ( immh << 3 ) | immb );
-                    const char * pT = get_sshr_vector_T( immh, Q );
-                    tracer.Trace( "ssra v%llu.%s, v%llu.%s, #%llu\n", d, pT, n, pT, shift );
-                }
-                else if ( ( ( 1 == bits23_22 || 2 == bits23_22 ) && !bit10 ) &&
-                     ( ( ( 0x4f == hi8 || 0x0f == hi8 ) && 8 == bits15_12 ) ||    // MUL <Vd>.<T>, <Vn>.<T>, <Vm>.<Ts>[<index>]
-                       ( ( 0x2f == hi8 || 0x6f == hi8 ) && 0 == bits15_12 ) ) )   // MLA <Vd>.<T>, <Vn>.<T>, <Vm>.<Ts>[<index>]
-                {
-                    uint64_t size = bits23_22;
-                    uint64_t n = opbits( 5, 5 );
-                    uint64_t L = opbit( 21 );
-                    uint64_t M = opbit( 20 );
-                    uint64_t H = opbit( 11 );
-                    uint64_t index = 0;
-                    uint64_t rmhi = 0;
-                    char TS = '?';
-                    const char * pT = "invalid";
-                    if ( 1 == size )
-                    {
-                        index = ( H << 2 ) | ( L << 1 ) | M;
-                        rmhi = 0;
-                        TS = 'h';
-                        pT = Q ? "8h" : "4h";
-                    }
-                    else if ( 2 == size )
-                    {
-                        index = ( H << 1 ) | L;
-                        rmhi = M;
-                        TS = 's';
-                        pT = Q ? "4s" : "2s";
-                    }
-                    else
-                        unhandled();
+    if ( 8 == n )
+        for ( uint64_t e = 0; e < 8; e++ )
+            result |= ( get_bits( val, e * 8, 8 ) << ( ( 7 - e ) * 8 ) );
+    else if ( 16 == n )
+        for ( uint64_t e = 0; e < 4; e++ )
+            result |= ( get_bits( val, e * 16, 16 ) << ( ( 3 - e ) * 16 ) );
+    else if ( 32 == n )
+        for ( uint64_t e = 0; e < 2; e++ )
+            result |= ( get_bits( val, e * 32, 32 ) << ( ( 1 - e ) * 32 ) );
+    else
+        assert( false );
 
-                    uint64_t m = ( rmhi << 4 ) | opbits( 16, 4 );
-                    tracer.Trace( "%s v%llu.%s, v%llu.%s, v%llu.%c[%llu]\n", ( 0x2f == hi8 || 0x6f == hi8 ) ? "mla" : "mul", d, pT, n, pT, m, TS, index );
-                }
-                else if ( ( 0x4f == hi8 || 0x0f == hi8 ) && !bit23 && 5 == opcode && !bit11 && bit10 ) // SHL <Vd>.<T>, <Vn>.<T>, #<shift>
-                {
-                    uint64_t n = opbits( 5, 5 );
-                    uint64_t immb = opbits( 16, 3 );
-                    uint64_t esize = 8ull << highest_set_bit_nz( immh );
-                    uint64_t shift = ( ( immh << 3 ) | immb ) - esize;
-                    const char * pT = get_sshr_vector_T( immh, Q );
-                    tracer.Trace( "shl v%llu.%s, v%llu.%s, #%llu\n", d, pT, n, pT, shift );
-                }
-                else if ( ( 0x0f == hi8 || 0x4f == hi8 ) && !bit23 && 0 == opcode && !bit11 && bit10 ) // SSHR <Vd>.<T>, <Vn>.<T>, #<shift>
-                {
-                    uint64_t n = opbits( 5, 5 );
-                    uint64_t immb = opbits( 16, 3 );
-                    uint64_t esize = 8ull << highest_set_bit_nz( immh );
-                    uint64_t shift = ( esize * 2 ) - ( ( immh << 3 ) | immb );
-                    const char * pT = get_sshr_vector_T( immh, Q );
-                    tracer.Trace( "sshr v%llu.%s, v%llu.%s, #%llu\n", d, pT, n, pT, shift );
-                }
-                else if ( ( 0x4f == hi8 || 0x0f == hi8 ) && bit23 && 1 == opcode && !bit10 ) // FMLA <Vd>.<T>, <Vn>.<T>, <Vm>.<Ts>[<index>]
-                {
-                    uint64_t n = opbits( 5, 5 );
-                    uint64_t m = opbits( 16, 5 );
-                    uint64_t sz = opbit( 22 );
-                    uint64_t L = opbit( 21 );
-                    uint64_t H = opbit( 11 );
-                    uint64_t szL = ( sz << 1 ) | L;
-                    uint64_t index = ( 0 == sz ) ? ( ( H << 1 ) | L ) : ( 2 == szL ) ? H : 0;
-                    uint64_t Qsz = ( Q << 1 ) | sz;
-                    const char * pT = ( 0 == Qsz ) ? "2s" : ( 2 == Qsz ) ? "4s" : ( 3 == Qsz ) ? "2d" : "?";
-                    tracer.Trace( "fmla v%llu.%s, v%llu.%s, v%llu.%c[%llu]\n", d, pT, n, pT, m, sz ? 'd' : 's', index );
-                }
-                else if ( ( 0x0f == hi8 || 0x4f == hi8 ) && !bit23 && 0 != bits23_19 && 0xa == opcode && !bit11 && bit10 ) // SSHLL{2} <Vd>.<Ta>, <Vn>.<Tb>, #<shift>
-                {
-                    uint64_t n = opbits( 5, 5 );
-                    uint64_t immb = opbits( 16, 3 );
-                    uint64_t esize = 8ull << highest_set_bit_nz( immh & 0x7 );
-                    uint64_t shift = ( ( immh << 3 ) | immb ) - esize;
-                    const char * pTA = ( 1 == immh ) ? "8H" : ( 2 == ( 0xe & immh ) ) ? "4S" : "2D";
-                    uint64_t sizeb = immh >> 1;
-                    if ( 4 & sizeb )
-                        sizeb = 4;
-                    else if ( 2 & sizeb )
-                        sizeb = 2;
-                    const char * pTB = get_ld1_vector_T( sizeb, Q );
-                    tracer.Trace( "sshll%s v%llu.%s, v%llu.%s, #%llu\n", Q ? "2" : "", d, pTA, n, pTB, shift );
-                }
-                else if ( ( 0x0f == hi8 || 0x4f == hi8 ) && !bit23 && 0 != bits23_19 && 8 == opcode && !bit11 && bit10 ) // SHRN{2} <Vd>.<Tb>, <Vn>.<Ta>, #<shift>
-                {
-                    uint64_t n = opbits( 5, 5 );
-                    uint64_t immb = opbits( 16, 3 );
-                    uint64_t esize = 8ull << highest_set_bit_nz( immh & 0x7 );
-                    uint64_t shift = ( 2 * esize ) - ( ( immh << 3 ) | immb );
-                    const char * pTA = ( 1 == immh ) ? "8H" : ( 2 == ( 0xe & immh ) ) ? "4S" : "2D";
-                    uint64_t sizeb = immh >> 1;
-                    if ( 4 & sizeb )
-                        sizeb = 4;
-                    else if ( 2 & sizeb )
-                        sizeb = 2;
-                    const char * pTB = get_ld1_vector_T( sizeb, Q );
-                    tracer.Trace( "shrn%s v%llu.%s, v%llu.%s, #%llu\n", Q ? "2" : "", d, pTB, n, pTA, shift );
-                }
-                else if ( ( 0x2f == hi8 || 0x6f == hi8 ) && !bit23 && 0 != bits23_19 && ( 0xa == opcode ) && !bit11 && bit10 ) // USHLL{2} <Vd>.<Ta>, <Vn>.<Tb>, #<shift>
-                {
-                    uint64_t n = opbits( 5, 5 );
-                    uint64_t immb = opbits( 16, 3 );
-                    uint64_t esize = 8ull << highest_set_bit_nz( immh & 0x7 );
-                    if ( 0x7f == hi8 )
-                        esize = 8ull << 3;
-                    uint64_t shift = ( ( immh << 3 ) | immb ) - esize;
-                    const char * pTA = ( 1 == immh ) ? "8H" : ( 2 == ( 0xe & immh ) ) ? "4S" : "2D";
-                    uint64_t sizeb = immh >> 1;
-                    if ( 2 & sizeb )
-                        sizeb = 2;
-                    const char * pTB = get_ld1_vector_T( sizeb, Q );
-                    tracer.Trace( "ushll%s v%llu.%s, v%llu.%s, #%llu\n", Q ? "2" : "", d, pTA, n, pTB, shift );
-                }
-                else if ( ( 0x2f == hi8 || 0x7f == hi8 || 0x6f == hi8 ) && !bit23 && 0 == opcode && !bit11 && bit10 ) // USHR
-                {
-                    uint64_t n = opbits( 5, 5 );
-                    uint64_t immb = opbits( 16, 3 );
-                    uint64_t esize = 8ull << highest_set_bit_nz( immh );
-                    if ( 0x7f == hi8 )
-                        esize = 8ull << 3;
-                    uint64_t shift = ( esize * 2 ) - ( ( immh << 3 ) | immb );
-                    tracer.Trace( "immh %llx, Q %llx\n", immh, Q );
-                    uint64_t p_type = 0;
-                    if ( 8 & immh )
-                        p_type = 3;
-                    else if ( 4 & immh )
-                        p_type = 2;
-                    else if ( 2 & immh )
-                        p_type = 1;
-                    else if ( 1 & immh )
-                        p_type = 0;
-                    const char * pT = get_ld1_vector_T( p_type, Q );
-                    if ( 0x7f == hi8 ) // USHR D<d>, D<n>, #<shift>
-                        tracer.Trace( "ushr, d%llu, d%llu, #%llu\n", d, n, shift );
-                    else // USHR <Vd>.<T>, <Vn>.<T>, #<shift>
-                        tracer.Trace( "ushr, v%llu.%s, v%llu.%s, #%llu\n", d, pT, n, pT, shift );
-                }
-                else if ( bit23 && !bit10 && 9 == opcode ) // FMUL <Vd>.<T>, <Vn>.<T>, <Vm>.<Ts>[<index>]. Vector, single-precision and double-precision
-                {
-                    uint64_t n = opbits( 5, 5 );
-                    uint64_t m = opbits( 16, 5 );
-                    uint64_t sz = opbit( 22 );
-                    uint64_t L = opbit( 21 );
-                    uint64_t H = opbit( 11 );
-                    uint64_t index = ( !sz ) ? ( ( H << 1 ) | L ) : H;
-                    const char * pT = ( Q && sz ) ? "2D" : ( !Q && !sz ) ? "2S" : ( Q && !sz ) ? "4S" : "?";
-                    tracer.Trace( "fmul v%llu.%s, v%llu.%s, v%llu.%c[%llu]\n", d, pT, n, pT, m, sz ? 'D' : 'S', index );
-                }
-                else
-                    unhandled();
-            }
-            break;
-        }
-        case 0x5a: // REV <Wd>, <Wn>  ;  CSINV <Wd>, <Wn>, <Wm>, <cond>  ;  RBIT <Wd>, <Wn>  ;  CLZ <Wd>, <Wn>  ;  CSNEG <Wd>, <Wn>, <Wm>, <cond>  ;  SBC <Wd>, <Wn>, <Wm> ; REV16 <Wd>, <Wn>
-        case 0xda: // REV <Xd>, <Xn>  ;  CSINV <Xd>, <Xn>, <Xm>, <cond>  ;  RBIT <Xd>, <Xn>  ;  CLZ <Xd>, <Xn>  ;  CSNEG <Xd>, <Xn>, <Xm>, <cond>  ;  SBC <Xd>, <Xn>, <Xm> ; REV16 <Xd>, <Xn> ; REV32 <Xd>, <Xn>
-        {
-            uint64_t xregs = ( 0 != ( 0x80 & hi8 ) );
-            uint64_t bits23_21 = opbits( 21, 3 );
-            uint64_t bits23_10 = opbits( 10, 14 );
-            uint64_t bits15_10 = opbits( 10, 6 );
-            uint64_t bit11 = opbit( 11 );
-            uint64_t bit10 = opbit( 10 );
-            uint64_t n = opbits( 5, 5 );
-            uint64_t d = opbits( 0, 5 );
-
-            if ( 0xda == hi8 && 0x3002 == bits23_10 ) // rev32
-                tracer.Trace( "rev32 %s, %s\n", reg_or_zr( d, true ), reg_or_zr( n, true ) );
-            else if ( 0x3001 == bits23_10 ) // rev16
-                tracer.Trace( "rev16 %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ) );
-            else if ( 4 == bits23_21 ) // csinv + csneg
-            {
-                if ( bit11 )
-                    unhandled();
-                uint64_t m = opbits( 16, 5 );
-                uint64_t cond = opbits( 12, 4 );
-                tracer.Trace( "%s %s, %s, %s, %s\n", bit10 ? "csneg" : "csinv", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ),  reg_or_zr( m, xregs ), get_cond( cond ) );
-            }
-            else if ( 6 == bits23_21 )
-            {
-                if ( 0 == bits15_10 ) // rbit
-                    tracer.Trace( "rbit %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ) );
-                else if ( 2 == bits15_10 || 3 == bits15_10 ) // rev
-                    tracer.Trace( "rev %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ) );
-                else if ( 4 == bits15_10 ) // clz
-                    tracer.Trace( "clz %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ) );
-                else
-                    unhandled();
-            }
-            else if ( 0 == bits23_21 )
-            {
-                if ( 0 == bits15_10 ) // sbc
-                {
-                    uint64_t m = opbits( 16, 5 );
-                    tracer.Trace( "sbc %s, %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ) );
-                }
-                else
-                    unhandled();
-            }
-            else
-                unhandled();
-            break;
-        }
-        case 0x14: case 0x15: case 0x16: case 0x17: // b label
-        {
-            int64_t imm26 = opbits( 0, 26 );
-            imm26 <<= 2;
-            imm26 = sign_extend( imm26, 27 );
-            tracer.Trace( "b %#llx\n", pc + imm26 );
-            break;
-        }
-        case 0x54: // b.cond
-        {
-            uint64_t cond = opbits( 0, 4 );
-            int64_t imm19 = opbits( 5, 19 );
-            imm19 <<= 2;
-            imm19 = sign_extend( imm19, 20 );
-            tracer.Trace( "b.%s %#llx\n", get_cond( cond ), pc + imm19 );
-            break;
-        }
-        case 0x18: // ldr wt, (literal)
-        case 0x58: // ldr xt, (literal)
-        {
-            uint64_t imm19 = opbits( 5, 19 );
-            uint64_t t = opbits( 0, 5 );
-            bool xregs = ( 0 != opbit( 30 ) );
-            tracer.Trace( "ldr %s, =%#llx\n", reg_or_zr( t, xregs ), pc + ( imm19 << 2 ) );
-            break;
-        }
-        case 0x3a: // CCMN <Wn>, #<imm>, #<nzcv>, <cond>  ;    CCMN <Wn>, <Wm>, #<nzcv>, <cond>       ;    ADCS <Wd>, <Wn>, <Wm>
-        case 0xba: // CCMN <Wn>, <Wm>, #<nzcv>, <cond>    ;    CCMN <Xn>, <Xm>, #<nzcv>, <cond>       ;    ADCS <Xd>, <Xn>, <Xm>
-        case 0x7a: // CCMP <Wn>, <Wm>, #<nzcv>, <cond>    ;    CCMP <Wn>, #<imm>, #<nzcv>, <cond>     ;    SBCS <Wd>, <Wn>, <Wm>
-        case 0xfa: // CCMP <Xn>, <Xm>, #<nzcv>, <cond>    ;    CCMP <Xn>, #<imm>, #<nzcv>, <cond>     ;    SBCS <Xd>, <Xn>, <Xm>
-        {
-            uint64_t bits23_21 = opbits( 21, 3 );
-            uint64_t bits15_10 = opbits( 10, 6 );
-            uint64_t n = opbits( 5, 5 );
-            bool xregs = ( 0 != ( 0x80 & hi8 ) );
+    return result;
+} //reverse_bytes
 
-            if ( 2 == bits23_21 )
-            {
-                uint64_t o3 = opbit( 4 );
-                if ( 0 != o3 )
-                    unhandled();
+static uint64_t one_bits( uint64_t bits )
+{
+    if ( 64 == bits )
+        return ~0ull;
 
-                bool is_ccmn = ( 0 == ( hi8 & 0x40 ) );
-                uint64_t cond = opbits( 12, 4 );
-                uint64_t nzcv = opbits( 0, 4 );
-                char width = xregs ? 'x' : 'w';
-                uint64_t o2 = opbits( 10, 2 );
-                if ( 0 == o2 ) // register
-                {
-                    uint64_t m = opbits( 16, 5 );
-                    tracer.Trace( "%s %c%llu, %c%llu, #%llu, %s\n", is_ccmn ? "ccmn" : "ccmp", width, n, width, m, nzcv, get_cond( cond ) );
-                }
-                else if ( 2 == o2 ) // immediate
-                {
-                    uint64_t imm5 = opbits( 16, 5 ); // unsigned
-                    tracer.Trace( "%s %c%llu, #%llx, #%llu, %s\n", is_ccmn ? "ccmn" : "ccmp", width, n, imm5, nzcv, get_cond( cond ) );
-                }
-                else
-                    unhandled();
-            }
-            else if ( ( 0xfa == hi8 || 0x7a == hi8 ) && 0 == bits23_21 && 0 == bits15_10 ) // SBCS <Xd>, <Xn>, <Xm>
-            {
-                uint64_t d = opbits( 0, 5 );
-                uint64_t m = opbits( 16, 5 );
-                tracer.Trace( "sbcs %s, %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ) );
-            }
-            else if ( ( 0x3a == hi8 || 0xba == hi8 ) && 0 == bits23_21 && 0 == bits15_10 ) // ADCS <Xd>, <Xn>, <Xm>
-            {
-                uint64_t d = opbits( 0, 5 );
-                uint64_t m = opbits( 16, 5 );
-                tracer.Trace( "adcs %s, %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ) );
-            }
-            else
-                unhandled();
-            break;
-        }
-        case 0x31: // ADDS <Wd>, <Wn|WSP>, #<imm>{, <shift>}  ;    CMN <Wn|WSP>, #<imm>{, <shift>}
-        case 0xb1: // ADDS <Xd>, <Xn|SP>, #<imm>{, <shift>}   ;    CMN <Xn|SP>, #<imm>{, <shift>}
-        {
-            uint64_t xregs = ( 0 != ( 0x80 & hi8 ) );
-            bool shift12 = opbit( 22 );
-            uint64_t imm12 = opbits( 10, 12 );
-            uint64_t n = opbits( 5, 5 );
-            uint64_t d = opbits( 0, 5 );
+    return ( ( 1ull << bits ) - 1 );
+} //one_bits
 
-            if ( 31 == d )
-                tracer.Trace( "cmn %s, #%#llx, lsl #%llu\n", reg_or_sp( n, xregs ), imm12, ( shift12 ? 12ull : 0ull ) );
-            else
-                tracer.Trace( "adds %s, %s, #%#llx, lsl #%llu\n", reg_or_zr( d, xregs ), reg_or_sp( n, xregs ), imm12, ( shift12 ? 12ull : 0ull ) );
-            break;
-        }
-        case 0x0b: // ADD <Wd|WSP>, <Wn|WSP>, <Wm>{, <extend> {#<amount>}}      ;    ADD <Wd>, <Wn>, <Wm>{, <shift> #<amount>}
-        case 0x2b: // ADDS <Wd>, <Wn|WSP>, <Wm>{, <extend> {#<amount>}}         ;    ADDS <Wd>, <Wn>, <Wm>{, <shift> #<amount>}
-        case 0x4b: // SUB <Wd|WSP>, <Wn|WSP>, <Wm>{, <extend> {#<amount>}}      ;    SUB <Wd>, <Wn>, <Wm>{, <shift> #<amount>}
-        case 0x6b: // SUBS <Wd>, <Wn|WSP>, <Wm>{, <extend> {#<amount>}}         ;    SUBS <Wd>, <Wn>, <Wm>{, <shift> #<amount>}
-        case 0x8b: // ADD <Xd|SP>, <Xn|SP>, <R><m>{, <extend> {#<amount>}}      ;    ADD <Xd>, <Xn>, <Xm>{, <shift> #<amount>}
-        case 0xab: // ADDS <Xd>, <Xn|SP>, <R><m>{, <extend> {#<amount>}}        ;    ADDS <Xd>, <Xn>, <Xm>{, <shift> #<amount>}
-        case 0xcb: // SUB <Xd|SP>, <Xn|SP>, <R><m>{, <extend> {#<amount>}}      ;    SUB <Xd>, <Xn>, <Xm>{, <shift> #<amount>}
-        case 0xeb: // SUBS <Xd>, <Xn|SP>, <R><m>{, <extend> {#<amount>}}        ;    SUBS <Xd>, <Xn>, <Xm>{, <shift> #<amount>}
-        {
-            uint64_t extended = opbit( 21 );
-            uint64_t issub = ( 0 != ( 0x40 & hi8 ) );
-            const char * opname = issub ? "sub" : "add";
-            uint64_t setflags = ( 0 != ( 0x20 & hi8 ) );
-            uint64_t xregs = ( 0 != ( 0x80 & hi8 ) );
-            uint64_t m = opbits( 16, 5 );
-            uint64_t n = opbits( 5, 5 );
-            uint64_t d = opbits( 0, 5 );
+static uint64_t replicate_bit( uint64_t val, uint64_t len )
+{
+    if ( 0 != val )
+        return one_bits( len );
+    return 0;
+} //replicate_bit
 
-            if ( 1 == extended ) // ADD <Xd|SP>, <Xn|SP>, <R><m>{, <extend> {#<amount>}}
-            {
-                uint64_t option = opbits( 13, 3 );
-                uint64_t imm3 = opbits( 10, 3 );
-                tracer.Trace( "%s%s, %s, %s, %s, %s #%llu\n", opname, setflags ? "s" : "",
-                              setflags ? reg_or_zr( d, xregs ) : reg_or_sp( d, xregs ),
-                              reg_or_sp( n, xregs ), reg_or_zr( m, xregs ),
-                              extend_type( option ), imm3 );
-            }
-            else // ADD <Xd>, <Xn>, <Xm>{, <shift> #<amount>}
-            {
-                uint64_t shift = opbits( 22, 2 );
-                uint64_t imm6 = opbits( 10, 6 );
-                if ( issub && ( 31 == d ) )
-                    tracer.Trace( "cmp %s, %s { %s #%llu }\n",
-                                  reg_or_zr( n, xregs ), reg_or_zr( m, xregs ),
-                                  shift_type( shift ), imm6 );
-                else
-                    tracer.Trace( "%s%s %s, %s, %s { %s #%llu }\n", opname, setflags ? "s" : "",
-                                  reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ),
-                                  shift_type( shift ), imm6 );
-            }
-            break;
-        }
-        case 0x11: // add <wd|SP>, <wn|SP>, #imm [,<shift>]
-        case 0x51: // sub <wd|SP>, <wn|SP>, #imm [,<shift>]
-        case 0x91: // add <xd|SP>, <xn|SP>, #imm [,<shift>]
-        case 0xd1: // sub <xd|SP>, <xn|SP>, #imm [,<shift>]
-        {
-            bool sf = ( 0 != opbit( 31 ) );
-            bool sh = ( 0 != opbit( 22 ) );
-            uint64_t imm12 = opbits( 10, 12 );
-            uint64_t n = opbits( 5, 5 );
-            uint64_t d = opbits( 0, 5 );
-            tracer.Trace( "%s %s, %s, #%#llx, lsl #%llu\n", ( 0x91 == hi8 || 0x11 == hi8 ) ? "add" : "sub",
-                          reg_or_sp( d, sf ), reg_or_sp( n, sf ), imm12, (uint64_t) ( sh ? 12 : 0 ) );
-            break;
-        }
-        case 0xd5: // MSR / MRS
-        {
-            uint64_t bits2322 = opbits( 22, 2 );
-            if ( 0 != bits2322 )
-                unhandled();
+static int64_t sign_extend( uint64_t x, uint64_t high_bit )
+{
+    assert( high_bit < 63 );
+    x &= ( 1ull << ( high_bit + 1 ) ) - 1; // clear bits above the high bit since they may contain noise
+    const int64_t m = 1ull << high_bit;
+    return ( x ^ m ) - m;
+} //sign_extend
 
-            if ( 0xd503201f == op ) // nop
-            {
-                tracer.Trace( "nop\n" );
-                break;
-            }
+static uint16_t sign_extend16( uint16_t x, uint16_t high_bit )
+{
+    assert( high_bit < 15 );
+    x &= ( 1u << ( high_bit + 1 ) ) - 1; // clear bits above the high bit since they may contain noise
+    const int16_t m = ( (uint16_t) 1 ) << high_bit;
+    return ( x ^ m ) - m;
+} //sign_extend16
 
-            uint64_t upper20 = opbits( 12, 20 );
-            uint64_t lower8 = opbits( 0, 8 );
-            if ( ( 0xd5033 == upper20 ) && ( 0xbf == lower8 ) ) // dmb -- no memory barries are needed due to just one thread and core
-            {
-                tracer.Trace( "dmb\n" );
-                break;
-            }
+static uint32_t sign_extend32( uint32_t x, uint32_t high_bit )
+{
+    assert( high_bit < 31 );
+    x &= ( 1u << ( high_bit + 1 ) ) - 1; // clear bits above the high bit since they may contain noise
+    const int32_t m = ( (uint32_t) 1 ) << high_bit;
+    return ( x ^ m ) - m;
+} //sign_extend32
 
-            uint64_t l = opbit( 21 );
-            uint64_t op0 = opbits( 19, 2 );
-            uint64_t op1 = opbits( 16, 3 );
-            uint64_t op2 = opbits( 5, 3 );
-            uint64_t n = opbits( 12, 4 );
-            uint64_t m = opbits( 8, 4 );
-            uint64_t t = opbits( 0, 5 );
+static uint64_t plaster_bits( uint64_t val, uint64_t bits, uint64_t low_position, uint64_t len )
+{
+    return ( ( val & ( ~( one_bits( len ) << low_position ) ) ) | ( bits << low_position ) );
+} //plaster_bits
 
-            if ( l ) // MRS <Xt>, (<systemreg>|S<op0>_<op1>_<Cn>_<Cm>_<op2>).   read system register
-            {
-                if ( ( 3 == op0 ) && ( 14 == n ) && ( 3 == op1 ) && ( 0 == m ) && ( 2 == op2 ) ) // cntvct_el0 counter-timer virtual count register
-                    tracer.Trace( "mrs x%llu, cntvct_el0\n", t );
-                else if ( ( 3 == op0 ) && ( 14 == n ) && ( 3 == op1 ) && ( 0 == m ) && ( 0 == op2 ) ) // cntfrq_el0 counter-timer frequency register
-                    tracer.Trace( "mrs x%llu, cntfrq_el0\n", t );
-                else if ( ( 3 == op0 ) && ( 0 == n ) && ( 3 == op1 ) && ( 0 == m ) && ( 7 == op2 ) )
-                    tracer.Trace( "mrs x%llu, dczid_elo\n", t );
-                else if ( ( 3 == op0 ) && ( 0 == n ) && ( 0 == op1 ) && ( 0 == m ) && ( 0 == op2 ) ) // mrs x, midr_el1
-                    tracer.Trace( "mrs x%llu, midr_el1\n", t );
-                else if ( ( 3 == op0 ) && ( 13 == n ) && ( 3 == op1 ) && ( 0 == m ) && ( 2 == op2 ) )
-                    tracer.Trace( "mrs x%llu, tpidr_el0\n", t );
-                else if ( ( 3 == op0 ) && ( 4 == n ) && ( 3 == op1 ) && ( 4 == m ) && ( 0 == op2 ) ) // mrs x, fpcr
-                    tracer.Trace( "mrs x%llu, fpcr // %s\n", t, get_rmode_text( get_bits( fpcr, 22, 2 ) ) );
-                else if ( ( 3 == op0 ) && ( 4 == n ) && ( 3 == op1 ) && ( 4 == m ) && ( 1 == op2 ) ) // mrs x, fpsr
-                    tracer.Trace( "mrs x%llu, fpsr\n", t );
-                else
-                {
-                    tracer.Trace( "MRS unhandled: t %llu op0 %llu n %llu op1 %llu m %llu op2 %llu\n", t, op0, n, op1, m, op2 );
-                    unhandled();
-                }
-            }
-            else // MSR.   write system register
-            {
-                if ( ( 3 == op0 ) && ( 13 == n ) && ( 3 == op1 ) && ( 0 == m ) && ( 2 == op2 ) )
-                    tracer.Trace( "msr tpidr_el0, x%llu\n", t );
-                else if ( ( 0 == op0 ) && ( 2 == n ) && ( 3 == op1 ) && ( 4 == m ) && ( 2 == op2 ) )
-                    tracer.Trace( "bti\n" ); // branch target identification (ignore );
-                else if ( ( 1 == op0 ) && ( 7 == n ) && ( 3 == op1 ) && ( 4 == m ) && ( 1 == op2 ) )
-                    tracer.Trace( "dc zva, %s\n", reg_or_zr( t, true ) ); // data cache operation
-                else if ( ( 0 == op0 ) && ( 2 == n ) && ( 3 == op1 ) && ( 0 == m ) && ( 7 == op2 ) ) // xpaclri
-                    tracer.Trace( "xpaclri\n" );
-                else if ( ( 3 == op0 ) && ( 4 == n ) && ( 3 == op1 ) && ( 4 == m ) && ( 0 == op2 ) ) // msr fpcr, xt
-                    tracer.Trace( "msr fpcr, x%llu // %s\n", t, get_rmode_text( get_bits( regs[ t ], 22, 2 ) ) );
-                else
-                {
-                    tracer.Trace( "MSR unhandled: t %llu op0 %llu n %llu op1 %llu m %llu op2 %llu\n", t, op0, n, op1, m, op2 );
-                    unhandled();
-                }
-            }
-            break;
-        }
-        case 0x1b: // MADD <Wd>, <Wn>, <Wm>, <Wa>    ;    MSUB <Wd>, <Wn>, <Wm>, <Wa>
-        case 0x9b: // MADD <Xd>, <Xn>, <Xm>, <Xa>    ;    MSUB <Xd>, <Xn>, <Xm>, <Xa>    ;    UMULH <Xd>, <Xn>, <Xm>    ;    UMADDL <Xd>, <Wn>, <Wm>, <Xa>
-                   // SMADDL <Xd>, <Wn>, <Wm>, <Xa>  ;    SMULH <Xd>, <Xn>, <Xm>         ;    UMSUBL <Xd>, <Wn>, <Wm>, <Xa>
-        {
-            bool xregs = ( 0 != opbit( 31 ) );
-            uint64_t m = opbits( 16, 5 );
-            uint64_t a = opbits( 10, 5 );
-            uint64_t n = opbits( 5, 5 );
-            uint64_t d = opbits( 0, 5 );
-            uint64_t bits23_21 = opbits( 21, 3 );
-            bool bit15 = ( 1 == opbit( 15 ) );
+static uint64_t lowest_set_bit_nz( uint64_t x )
+{
+    uint64_t mask = 1;
+    for ( uint64_t i = 0; i < 64; i++ )
+    {
+        if ( x & mask )
+            return i;
+        mask <<= 1;
+    }
 
-            if ( 0x9b == hi8 && 5 == bits23_21 && bit15 ) // UMSUBL <Xd>, <Wn>, <Wm>, <Xa>
-                tracer.Trace( "umsubl x%llu, w%llu, w%llu, x%llu\n", d, n, m, a );
-            else if ( 1 == bits23_21 && bit15 ) // smsubl
-                tracer.Trace( "mmsubl %s, %s, %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ), reg_or_zr( a, xregs ) );
-            else if ( 5 == bits23_21 && !bit15 )
-                tracer.Trace( "umaddl %s, %s, %s\n", reg_or_zr( d, true ), reg_or_zr( n, true ), reg_or_zr( m, true ) );
-            else if ( 1 == bits23_21 && !bit15 )
-                tracer.Trace( "smaddl %s, %s, %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, false ), reg_or_zr( m, false ), reg_or_zr( a, xregs ) );
-            else if ( 0 == bits23_21 && !bit15 )
-                tracer.Trace( "madd %s, %s, %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ), reg_or_zr( a, xregs ) );
-            else if ( 0 == bits23_21 && bit15 )
-                tracer.Trace( "msub %s, %s, %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ), reg_or_zr( a, xregs ) );
-            else if ( 6 == bits23_21 && !bit15 && 31 == a )
-                tracer.Trace( "umulh %s, %s, %s\n", reg_or_zr( d, true ), reg_or_zr( n, true ), reg_or_zr( m, true ) );
-            else if ( 2 == bits23_21 && !bit15 && 31 == a )
-                tracer.Trace( "smulh %s, %s, %s\n", reg_or_zr( d, true ), reg_or_zr( n, true ), reg_or_zr( m, true ) );
-            else
-                unhandled();
-            break;
-        }
-        case 0x71: // SUBS <Wd>, <Wn|WSP>, #<imm>{, <shift>}   ;   CMP <Wn|WSP>, #<imm>{, <shift>}
-        case 0xf1: // SUBS <Xd>, <Xn|SP>, #<imm>{, <shift>}    ;   cmp <xn|SP>, #imm [,<shift>]    ;
-        {
-            bool sf = ( 0 != opbit( 31 ) );
-            bool sh = ( 0 != opbit( 22 ) );
-            uint64_t imm12 = opbits( 10, 12 );
-            uint64_t n = opbits( 5, 5 );
-            uint64_t d = opbits( 0, 5 );
+    assert( false ); // _nz means this shoudn't hit
+    return 64;
+} //lowest_set_bit_nz
 
-            if ( 31 == d )
-                tracer.Trace( "cmp %s, #%#llx, LSL #%llu\n", reg_or_zr( n, sf ), imm12, sh ? 12ull : 0ull );
-            else
-                tracer.Trace( "subs %s, %s, #%#llx, LSL #%llu\n", reg_or_zr( d, sf ), reg_or_sp( n, sf ), imm12, sh ? 12ull : 0ull );
-            break;
-        }
-        case 0x94: case 0x95: case 0x96: case 0x97: // bl offset. The lower 2 bits of this are the high part of the offset
-        {
-            int64_t offset = ( opbits( 0, 26 ) << 2 );
-            offset = sign_extend( offset, 27 );
-            tracer.Trace( "bl %#llx\n", pc + offset );
-            break;
-        }
-        case 0x28: // ldp/stp 32 post index                   STP <Wt1>, <Wt2>, [<Xn|SP>], #<imm>     ;    LDP <Wt1>, <Wt2>, [<Xn|SP>], #<imm>
-        case 0xa8: // ldp/stp 64 post-index                   STP <Xt1>, <Xt2>, [<Xn|SP>], #<imm>     ;    LDP <Xt1>, <Xt2>, [<Xn|SP>], #<imm>
-        case 0x29: // ldp/stp 32 pre-index and signed offset: STP <Wt1>, <Wt2>, [<Xn|SP>, #<imm>]!    ;    STP <Wt1>, <Wt2>, [<Xn|SP>{, #<imm>}]
-                   //                                         LDP <Wt1>, <Wt2>, [<Xn|SP>, #<imm>]!    ;    LDP <Wt1>, <Wt2>, [<Xn|SP>{, #<imm>}]
-        case 0xa9: // ldp/stp 64 pre-index and signed offset: STP <Xt1>, <Xt2>, [<Xn|SP>, #<imm>]!    ;    STP <Xt1>, <Xt2>, [<Xn|SP>{, #<imm>}]
-                   //                                         LDP <Xt1>, <Xt2>, [<Xn|SP>, #<imm>]!    ;    LDP <Xt1>, <Xt2>, [<Xn|SP>{, #<imm>}]
-        case 0x68: // ldp 32-bit sign extended                LDPSW <Xt1>, <Xt2>, [<Xn|SP>], #<imm>
-        case 0x69: // ldp 32-bit sign extended                LDPSW <Xt1>, <Xt2>, [<Xn|SP>, #<imm>]!  ;    LDPSW <Xt1>, <Xt2>, [<Xn|SP>{, #<imm>}]
-        {
-            bool xregs = ( 0 != opbit( 31 ) );
-            uint64_t t1 = opbits( 0, 5 );
-            uint64_t t2 = opbits( 10, 5 );
-            uint64_t n = opbits( 5, 5 );
-            int64_t imm7 = sign_extend( opbits( 15, 7 ), 6 ) << ( xregs ? 3 : 2 );
-            uint64_t variant = opbits( 23, 2 );
-            if ( 0 == variant )
-                unhandled();
+static uint64_t highest_set_bit_nz( uint64_t x )
+{
+    uint64_t mask = 1ull << 63;
+    for ( uint64_t i = 64; i > 0; i-- )
+    {
+        if ( x & mask )
+            return i - 1;
+        mask >>= 1;
+    }
 
-            bool postIndex = ( 1 == variant );
-            bool preIndex = ( 3 == variant );
-            bool signedOffset = ( 2 == variant );
+    assert( false ); // _nz means this shoudn't hit
+    return 0;
+} //highest_set_bit_nz
 
-            if ( 0 == opbit( 22 ) ) // bit 22 is 0 for stp
-            {
-                if ( 0x68 == hi8 || 0x69 == hi8 ) // these are ldpsw variants
-                    unhandled();
+const char * Arm64::render_flags()
+{
+    static char ac[ 5 ] = {0};
 
-                if ( signedOffset )
-                    tracer.Trace( "stp %s, %s, [%s, #%lld] //so\n", reg_or_zr( t1, xregs ), reg_or_zr( t2, xregs ), reg_or_sp( n, true ), imm7 );
-                else if ( preIndex )
-                    tracer.Trace( "stp %s, %s, [%s, #%lld]! //pr\n", reg_or_zr( t1, xregs ), reg_or_zr( t2, xregs ), reg_or_sp( n, true ), imm7 );
-                else if ( postIndex )
-                    tracer.Trace( "stp %s, %s, [%s] #%lld //po\n", reg_or_zr( t1, xregs ), reg_or_zr( t2, xregs ), reg_or_sp( n, true ), imm7 );
-                else
-                    unhandled();
-            }
-            else // 1 means ldp
-            {
-                bool se = ( 0 != ( hi8 & 0x40 ) );
-                if ( signedOffset )
-                    tracer.Trace( "ldp%s %s, %s, [%s, #%lld] //so\n", se ? "sw" : "", reg_or_zr( t1, xregs ), reg_or_zr( t2, xregs ), reg_or_sp( n, true ), imm7 );
-                else if ( preIndex )
-                    tracer.Trace( "ldp%s %s, %s, [%s, #%lld]! //pr\n", se ? "sw" : "", reg_or_zr( t1, xregs ), reg_or_zr( t2, xregs ), reg_or_sp( n, true ), imm7 );
-                else if ( postIndex )
-                    tracer.Trace( "ldp%s %s, %s, [%s] #%lld //po\n", se ? "sw" : "", reg_or_zr( t1, xregs ), reg_or_zr( t2, xregs ), reg_or_sp( n, true ), imm7 );
-                else
-                    unhandled();
-            }
-            break;
-        }
-        case 0x4a: // EOR <Wd>, <Wn>, <Wm>{, <shift> #<amount>}    ;    EON <Wd>, <Wn>, <Wm>{, <shift> #<amount>}
-        case 0xca: // EOR <Xd>, <Xn>, <Xm>{, <shift> #<amount>}    ;    EON <Xd>, <Xn>, <Xm>{, <shift> #<amount>}
-        case 0x2a: // ORR <Wd>, <Wn>, <Wm>{, <shift> #<amount>}    ;    ORN <Wd>, <Wn>, <Wm>{, <shift> #<amount>}
-        case 0xaa: // ORR <Xd>, <Xn>, <Xm>{, <shift> #<amount>}    ;    ORN <Xd>, <Xn>, <Xm>{, <shift> #<amount>}
-        {
-            uint64_t shift = opbits( 22, 2 );
-            uint64_t N = opbit( 21 );
-            uint64_t m = opbits( 16, 5 );
-            uint64_t n = opbits( 5, 5 );
-            uint64_t d = opbits( 0, 5 );
-            uint64_t imm6 = opbits( 10, 6 );
-            uint64_t xregs = ( 0 != ( 0x80 & hi8 ) );
-            bool eor = ( 2 == opbits( 29, 2 ) ); // or eon
+    materialize_flags();
 
-            if ( ( 0 == imm6 ) && ( 31 == n ) && ( 0 == shift ) && ( 0 == N ) )
-                tracer.Trace( "mov %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( m, xregs ) );
-            else if ( ( 0 == shift ) && ( 0 == imm6 ) )
-                tracer.Trace( "%s %s, %s, %s\n", eor ? ( N ? "eon" : "eor" ) : ( !N ) ? "orr" : "orn", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ) );
-            else
-                tracer.Trace( "%s %s, %s, %s, %s #%llu\n", eor ? ( N ? "eon" : "eor" ) : ( !N ) ? "orr" : "orn", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ), shift_type( shift ), imm6 );
-            break;
-        }
-        case 0x32: // ORR <Wd|WSP>, <Wn>, #<imm>
-        case 0xb2: // ORR <Xd|SP>, <Xn>, #<imm>
-        {
-            uint64_t xregs = ( 0 != ( 0x80 & hi8 ) );
-            uint64_t N_immr_imms = opbits( 10, 13 );
-            uint64_t op2 = decode_logical_immediate( N_immr_imms, xregs ? 64 : 32 );
-            uint64_t n = opbits( 5, 5 );
-            uint64_t d = opbits( 0, 5 );
-            tracer.Trace( "orr %s, %s, #%#llx\n", reg_or_sp( d, xregs ), reg_or_zr( n, xregs ), op2 );
-            break;
-        }
-        case 0x33: // BFM <Wd>, <Wn>, #<immr>, #<imms>
-        case 0xb3: // BFM <Xd>, <Xn>, #<immr>, #<imms>
-        case 0x13: // SBFM <Wd>, <Wn>, #<immr>, #<imms>    ;    EXTR <Wd>, <Wn>, <Wm>, #<lsb>
-        case 0x93: // SBFM <Xd>, <Xn>, #<immr>, #<imms>    ;    EXTR <Xd>, <Xn>, <Xm>, #<lsb>
-        case 0x53: // UBFM <Wd>, <Wn>, #<immr>, #<imms>
-        case 0xd3: // UBFM <Xd>, <Xn>, #<immr>, #<imms>
-        {
-            uint64_t xregs = ( 0 != ( 0x80 & hi8 ) );
-            uint64_t imms = opbits( 10, 6 );
-            uint64_t n = opbits( 5, 5 );
-            uint64_t d = opbits( 0, 5 );
-            uint64_t bit23 = opbit( 23 );
-            if ( bit23 && ( 0x13 == ( 0x7f & hi8 ) ) )
-            {
-                uint64_t m = opbits( 16, 5 );
-                tracer.Trace( "extr %s, %s, %s, #%llu\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ), imms );
-            }
-            else
-            {
-                uint64_t immr = opbits( 16, 6 );
-                const char * ins = ( 0x13 == hi8 || 0x93 == hi8 ) ? "sbfm" : ( 0x33 == hi8 || 0xb3 == hi8) ? "bfm" : "ubfm";
-                tracer.Trace( "%s %s, %s, #%llu, #%llu\n", ins, reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), immr, imms );
-            }
-            break;
-        }
-        case 0x0a: // AND <Wd>, <Wn>, <Wm>{, <shift> #<amount>}     ;    BIC <Wd>, <Wn>, <Wm>{, <shift> #<amount>}
-        case 0x6a: // ANDS <Wd>, <Wn>, <Wm>{, <shift> #<amount>}    ;    BICS <Wd>, <Wn>, <Wm>{, <shift> #<amount>}
-        case 0x8a: // AND <Xd>, <Xn>, <Xm>{, <shift> #<amount>}     ;    BIC <Xd>, <Xn>, <Xm>{, <shift> #<amount>}
-        case 0xea: // ANDS <Xd>, <Xn>, <Xm>{, <shift> #<amount>}    ;    BICS <Xd>, <Xn>, <Xm>{, <shift> #<amount>}
-        {
-            uint64_t shift = opbits( 22, 2 );
-            uint64_t N = opbit( 21 );
-            uint64_t m = opbits( 16, 5 );
-            uint64_t imm6 = opbits( 10, 6 );
-            uint64_t n = opbits( 5, 5 );
-            uint64_t d = opbits( 0, 5 );
-            bool set_flags = ( 0x60 == ( hi8 & 0x60 ) );
-            bool xregs = ( 0 != ( hi8 & 0x80 ) );
-            tracer.Trace( "%s%s %s, %s, %s, %s, #%llu\n", N ? "bic" : "and", set_flags ? "s" : "",
-                          reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ), shift_type( shift ), imm6 );
-            break;
-        }
-        case 0x10: case 0x30: case 0x50: case 0x70: // ADR <Xd>, <label>
-        {
-            uint64_t d = opbits( 0, 5 );
-            uint64_t immhi = opbits( 5, 19 );
-            uint64_t immlo = opbits( 29, 2 );
-            int64_t offset = sign_extend( immhi << 2 | immlo, 20 );
-            tracer.Trace( "adr x%llu, %#llx\n", d, pc + offset );
-            break;
-        }
-        case 0x90: case 0xb0: case 0xd0: case 0xf0: // adrp rd, immediate
-        {
-            uint64_t d = ( op & 0x1f );
-            int64_t imm = ( ( op >> 3 ) & 0x1ffffc );  // 19 bits with bottom two bits 0 at the bottom
-            imm |= opbits( 29, 2 );               // two low bits
-            imm = sign_extend( imm, 20 );
-            imm <<= 12;
-            imm += ( pc & ( ~0xfff ) );
-            tracer.Trace( "adrp x%llu, %#llx\n", d, imm );
-            break;
-        }
-        case 0x36: // TBZ <R><t>, #<imm>, <label>
-        case 0x37: // TBNZ <R><t>, #<imm>, <label>
-        case 0xb6: // TBZ <R><t>, #<imm>, <label> where high bit is prepended to b40 bit selector for 6 bits total
-        case 0xb7: // TBNZ <R><t>, #<imm>, <label> where high bit is prepended to b40 bit selector for 6 bits total
-        {
-            uint64_t b40 = opbits( 19, 5 );
-            if ( 0 != ( 0x80 & hi8 ) )
-                b40 |= 0x20;
-            int64_t imm14 = (int64_t) sign_extend( ( opbits( 5, 14 ) << 2 ), 15 ) + pc;
-            uint64_t t = opbits( 0, 5 );
-            tracer.Trace( "tb%sz x%llu, #%llu, %#llx\n", ( hi8 & 1 ) ? "n" : "", t, b40, imm14 );
-            break;
-        }
-        case 0x12: // MOVN <Wd>, #<imm>{, LSL #<shift>}   ;    AND <Wd|WSP>, <Wn>, #<imm>
-        case 0x92: // MOVN <Xd>, #<imm16>, LSL #<shift>   ;    AND <Xd|SP>, <Xn>, #<imm>    ;    MOV <Xd>, #<imm>
-        {
-            uint64_t bit23 = opbit( 23 );
-            bool xregs = ( 0 != ( hi8 & 0x80 ) );
-            if ( bit23 ) // MOVN
-            {
-                uint64_t d = opbits( 0, 5 );
-                uint64_t imm16 = opbits( 5, 16 );
-                uint64_t hw = opbits( 21, 2 );
-                hw *= 16;
-                imm16 <<= hw;
-                imm16 = ~imm16;
-                char width = 'x';
+    ac[ 0 ] = fN ? 'N' : 'n';
+    ac[ 1 ] = fZ ? 'Z' : 'z';
+    ac[ 2 ] = fC ? 'C' : 'c';
+    ac[ 3 ] = fV ? 'V' : 'v';
 
-                if ( 0x12 == hi8 )
-                {
-                    if ( hw > 16 )
-                        unhandled();
-                    imm16 = (uint32_t) imm16;
-                    width = 'w';
-                }
+    return ac;
+} //render_flags
 
-                tracer.Trace( "movn %c%llu, %lld\n", width, d, imm16 );
-            }
-            else // AND
-            {
-                uint64_t N_immr_imms = opbits( 10, 13 );
-                uint64_t n = opbits( 5, 5 );
-                uint64_t d = opbits( 0, 5 );
-                uint64_t op2 = decode_logical_immediate( N_immr_imms, xregs ? 64 : 32 );
-                tracer.Trace( "and %s, %s, #%#llx\n", reg_or_sp( d, xregs ), reg_or_zr( n, xregs ), op2 );
-            }
-            break;
-        }
-        case 0x1a: // CSEL <Wd>, <Wn>, <Wm>, <cond>    ;    SDIV <Wd>, <Wn>, <Wm>    ;    UDIV <Wd>, <Wn>, <Wm>    ;    CSINC <Wd>, <Wn>, <Wm>, <cond>
-                   // LSRV <Wd>, <Wn>, <Wm>            ;    LSLV <Wd>, <Wn>, <Wm>    ;    ADC <Wd>, <Wn>, <Wm>     ;    ASRV <Wd>, <Wn>, <Wm>
-                   // RORV <Wd>, <Wn>, <Wm>
-        case 0x9a: // CSEL <Xd>, <Xn>, <Xm>, <cond>    ;    SDIV <Xd>, <Xn>, <Xm>    ;    UDIV <Xd>, <Xn>, <Xm>    ;    CSINC <Xd>, <Xn>, <Xm>, <cond>
-                   // LSRV <Xd>, <Xn>, <Xm>            ;    LSLV <Xd>, <Xn>, <Xm>    ;    ADC <Xd>, <Xn>, <Xm>     ;    ASRV <Xd>, <Xn>, <Xm>
-                   // RORV <Xd>, <Xn>, <Xm>
-        {
-            bool xregs = ( 0 != ( hi8 & 0x80 ) );
-            uint64_t bits11_10 = opbits( 10, 2 );
-            uint64_t d = opbits( 0, 5 );
-            uint64_t n = opbits( 5, 5 );
-            uint64_t m = opbits( 16, 5 );
-            uint64_t bits15_12 = opbits( 12, 4 );
-            uint64_t bits23_21 = opbits( 21, 3 );
+static const char * xreg_names[32] =
+{
+    "x0",  "x1",   "x2", "x3",  "x4",  "x5",  "x6",  "x7",
+    "x8",  "x9",  "x10", "x11", "x12", "x13", "x14", "x15",
+    "x16", "x17", "x18", "x19", "x20", "x21", "x22", "x23",
+    "x24", "x25", "x26", "x27", "x28", "x29", "x30", "xzr"
+};
 
-            if ( 0 == bits11_10 && 4 == bits23_21 ) // CSEL
-            {
-                uint64_t cond = opbits( 12, 4 );
-                tracer.Trace( "csel %s, %s, %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ), get_cond( cond ) );
-            }
-            else if ( 1 == bits11_10 && 4 == bits23_21 ) // CSINC <Xd>, XZR, XZR, <cond>
-            {
-                uint64_t cond = opbits( 12, 4 );
-                tracer.Trace( "csinc %s, %s, %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ), get_cond( cond ) );
-            }
-            else if ( 2 == bits11_10 && 6 == bits23_21 && 2 == bits15_12 ) // ASRV <Xd>, <Xn>, <Xm>
-                tracer.Trace( "asrv %s, %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ) );
-            else if ( 2 == bits11_10 && 6 == bits23_21 && 0 == bits15_12 ) // UDIV <Xd>, <Xn>, <Xm>
-                tracer.Trace( "udiv %s, %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ) );
-            else if ( 3 == bits11_10 && 6 == bits23_21 && 0 == bits15_12 ) // SDIV <Xd>, <Xn>, <Xm>
-                tracer.Trace( "sdiv %s, %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ) );
-            else if ( 1 == bits11_10 && 6 == bits23_21 && 2 == bits15_12 ) // lsrv
-                tracer.Trace( "lsrv %s, %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ) );
-            else if ( 0 == bits11_10 && 6 == bits23_21 && 2 == bits15_12 ) // lslv
-                tracer.Trace( "lslv %s, %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ) );
-            else if ( 0 == bits11_10 && 0 == bits23_21 && 0 == bits15_12 && 0 == bits11_10 ) // addc
-                tracer.Trace( "addc %s, %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ) );
-            else if ( 3 == bits11_10 && 6 == bits23_21 && 2 == bits15_12 ) // RORV <Xd>, <Xn>, <Xm>
-                tracer.Trace( "rorv %s, %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ) );
-            else
-                unhandled();
-            break;
-        }
-        case 0x52: // MOVZ <Wd>, #<imm>{, LSL #<shift>}    ;    EOR <Wd|WSP>, <Wn>, #<imm>
-        case 0xd2: // MOVZ <Xd>, #<imm>{, LSL #<shift>}    ;    EOR <Xd|SP>, <Xn>, #<imm>
-        {
-            bool xregs = ( 0 != ( hi8 & 0x80 ) );
-            uint64_t bit23 = opbit( 23 );
+static const char * wreg_names[32] =
+{
+    "w0",  "w1",   "w2", "w3",  "w4",  "w5",  "w6",  "w7",
+    "w8",  "w9",  "w10", "w11", "w12", "w13", "w14", "w15",
+    "w16", "w17", "w18", "w19", "w20", "w21", "w22", "w23",
+    "w24", "w25", "w26", "w27", "w28", "w29", "w30", "wzr"
+};
 
-            if ( bit23 ) // movz xd, imm16
-            {
-                uint64_t d = opbits( 0, 5 );
-                uint64_t imm16 = opbits( 5, 16 );
-                uint64_t hw = opbits( 21, 2 );
-                tracer.Trace( "movz %s, %#llx, LSL #%llu\n", reg_or_zr( d, xregs ), imm16, hw * 16 );
-            }
-            else // EOR
-            {
-                uint64_t N_immr_imms = opbits( 10, 13 );
-                uint64_t op2 = decode_logical_immediate( N_immr_imms, xregs ? 64 : 32 );
-                uint64_t n = opbits( 5, 5 );
-                uint64_t d = opbits( 0, 5 );
-                tracer.Trace( "eor %s, %s, #%#llx\n", reg_or_sp( d, xregs ), reg_or_sp( n, xregs ), op2 );
-            }
-            break;
-        }
-        case 0x34: case 0xb4: // CBZ <Xt>, <label>     ;    CBZ <WXt>, <label>
-        case 0x35: case 0xb5: // CBNZ <Xt>, <label>    ;    CBNZ <Wt>, <label>
-        {
-            bool xregs = ( 0 != ( hi8 & 0x80 ) );
-            uint64_t t = opbits( 0, 5 );
-            bool zero_check = ( 0 == ( hi8 & 1 ) );
-            int64_t imm19 = ( ( op >> 3 ) & 0x1ffffc ); // two low bits are 0
-            imm19 = sign_extend( imm19, 20 );
-            tracer.Trace( "cb%sz %s, %#llx\n", zero_check ? "" : "n", reg_or_zr( t, xregs ), pc + imm19 );
-            break;
-        }
-        case 0xd4: // svc
-        {
-            uint64_t bit23 = opbit( 23 );
-            uint64_t hw = opbits( 21, 2 );
+static const char * reg_or_zr( uint64_t x, bool xregs )
+{
+    assert( x <= 31 );
+    if ( xregs )
+        return xreg_names[ x ];
 
-            if ( !bit23 && ( 0 == hw ) )
-            {
-                uint64_t imm16 = opbits( 5, 16 );
-                uint64_t op2 = opbits( 2, 3 );
-                uint64_t ll = opbits( 0, 2 );
-                if ( ( 0 == op2 ) && ( 1 == ll ) ) // svc imm16 supervisor call
-                    tracer.Trace( "svc %#llx\n", imm16 );
-                else
-                    unhandled();
-            }
-            break;
-        }
-        case 0x2e: case 0x6e: // CMEQ <Vd>.<T>, <Vn>.<T>, <Vm>.<T>    ;    CMHS <Vd>.<T>, <Vn>.<T>, <Vm>.<T>    ;    UMAXP <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-                              // BIT <Vd>.<T>, <Vn>.<T>, <Vm>.<T>     ;    UMINP <Vd>.<T>, <Vn>.<T>, <Vm>.<T>   ;    BIF <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-                              // EOR <Vd>.<T>, <Vn>.<T>, <Vm>.<T>     ;    SUB <Vd>.<T>, <Vn>.<T>, <Vm>.<T>     ;    UMULL{2} <Vd>.<Ta>, <Vn>.<Tb>, <Vm>.<Tb>
-                              // MLS <Vd>.<T>, <Vn>.<T>, <Vm>.<Ts>[<index>] ;  BSL <Vd>.<T>, <Vn>.<T>, <Vm>.<T> ;    FMUL <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-                              // EXT <Vd>.<T>, <Vn>.<T>, <Vm>.<T>, #<index> ;  INS <Vd>.<Ts>[<index1>], <Vn>.<Ts>[<index2>]  ;    UADDLV <V><d>, <Vn>.<T>
-                              // USHL <Vd>.<T>, <Vn>.<T>, <Vm>.<T>    ;    FADDP <Vd>.<T>, <Vn>.<T>, <Vm>.<T>   ;    FNEG <Vd>.<T>, <Vn>.<T>
-                              // CMHI <Vd>.<T>, <Vn>.<T>, <Vm>.<T>    ;    UADDW{2} <Vd>.<Ta>, <Vn>.<Ta>, <Vm>.<Tb>  ;   FDIV <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-                              // UMAXV <V><d>, <Vn>.<T> ; UMINV <V><d>, <Vn>.<T>    ;    UMAX <Vd>.<T>, <Vn>.<T>, <Vm>.<T>    ;    UMIN <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-                              // FMINNMV S<d>, <Vn>.4S  ; FMAXNMV S<d>, <Vn>.4S     ;    MLS <Vd>.<T>, <Vn>.<T>, <Vm>.<T>     ;    UCVTF <Vd>.<T>, <Vn>.<T>
-                              // NEG <Vd>.<T>, <Vn>.<T> ; EXT <Vd>.<T>, <Vn>.<T>, <Vm>.<T>, #<index>            ;    FCVTZU <Vd>.<T>, <Vn>.<T>
-                              // UMLAL{2} <Vd>.<Ta>, <Vn>.<Tb>, <Vm>.<Tb>           ;    USUBW{2} <Vd>.<Ta>, <Vn>.<Ta>, <Vm>.<Tb>
-                              // UADDL{2} <Vd>.<Ta>, <Vn>.<Tb>, <Vm>.<Tb>           ;    USUBL{2} <Vd>.<Ta>, <Vn>.<Tb>, <Vm>.<Tb>
-                              // FSQRT <Vd>.<T>, <Vn>.<T>             ;    UMLSL{2} <Vd>.<Ta>, <Vn>.<Tb>, <Vm>.<Tb> ; NOT <Vd>.<T>, <Vn>.<T>
-                              // UADDLP <Vd>.<Ta>, <Vn>.<Tb>          ;    UADALP <Vd>.<Ta>, <Vn>.<Tb>          ;    CMLE <Vd>.<T>, <Vn>.<T>, #0
-                              // UQXTN{2} <Vd>.<Tb>, <Vn>.<Ta>        ;    FCMGT <Vd>.<T>, <Vn>.<T>, <Vm>.<T>   ;    FCMGE <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-                              // CMGE <Vd>.<T>, <Vn>.<T>, #0          ;    REV32 <Vd>.<T>, <Vn>.<T>
-        {
-            uint64_t Q = opbit( 30 );
-            uint64_t m = opbits( 16, 5 );
-            uint64_t n = opbits( 5, 5 );
-            uint64_t d = opbits( 0, 5 );
-            uint64_t size = opbits( 22, 2 );
-            uint64_t bit23 = opbit( 23 );
-            uint64_t bit21 = opbit( 21 );
-            uint64_t bit15 = opbit( 15 );
-            uint64_t bit10 = opbit( 10 );
-            uint64_t bits23_21 = opbits( 21, 3 );
-            const char * pT = get_ld1_vector_T( size, Q );
-            uint64_t opcode = opbits( 10, 6 );
-            uint64_t opcode7 = opbits( 10, 7 );
-            uint64_t bits20_17 = opbits( 17, 4 );
-            uint64_t bits20_16 = opbits( 16, 5 );
-            uint64_t bits16_10 = opbits( 10, 7 );
-            uint64_t bits15_10 = opbits( 10, 6 );
+    return wreg_names[ x ];
+} //reg_or_zr
 
-            if ( bit21 && 0 == bits20_16 && 2 == bits15_10 ) // REV32 <Vd>.<T>, <Vn>.<T>
+static const char * reg_or_sp( uint64_t x, bool xregs )
+{
+    assert( x <= 31 );
+    if ( 31 == x )
+        return "sp";
+
+    return reg_or_zr( x, xregs );
+} //reg_or_sp
+
+__inline_perf uint64_t Arm64::val_reg_or_zr( uint64_t r ) const
+{
+    if ( 31 == r )
+        return 0;
+    return regs[ r ];
+} //val_reg_or_zr
+
+template < typename T > Arm64::ElementComparisonResult Arm64::compare( T l, T r )
+{
+    return ( l < r ) ? ecr_lt : ( l == r ) ? ecr_eq : ecr_gt;
+} //compare
+
+Arm64::ElementComparisonResult Arm64::compare_vector_elements( uint8_t * pl, uint8_t * pr, uint64_t width, bool unsigned_compare )
+{
+    assert( 1 == width || 2 == width || 4 == width || 8 == width );
+
+    if ( unsigned_compare )
+    {
+        if ( 1 == width )
+            return compare( *pl, *pr );
+        if ( 2 == width )
+            return compare( guest_load16( pl ), guest_load16( pr ) );
+        if ( 4 == width )
+            return compare( guest_load32( pl ), guest_load32( pr ) );
+
+        return compare( guest_load64( pl ), guest_load64( pr ) );
+    }
+
+    if ( 1 == width )
+        return compare( * (int8_t *) pl, * (int8_t *) pr );
+    if ( 2 == width )
+        return compare( (int16_t) guest_load16( pl ), (int16_t) guest_load16( pr ) );
+    if ( 4 == width )
+        return compare( (int32_t) guest_load32( pl ), (int32_t) guest_load32( pr ) );
+
+    return compare( (int64_t) guest_load64( pl ), (int64_t) guest_load64( pr ) );
+} //compare_vector_elements
+
+static const char * get_ld1_vector_T( uint64_t size, uint64_t Q )
+{
+    if ( 0 == size )
+        return Q ? "16b" : "8b";
+
+    if ( 1 == size )
+        return Q ? "8h" : "4h";
+
+    if ( 2 == size )
+        return Q ? "4s" : "2s";
+
+    if ( 3 == size )
+        return Q ? "2d" : "1d";
+
+    return "UNKNOWN";
+} //get_ld1_vector_T
+
+static const char * get_saddlp_vector_T( uint64_t size, uint64_t Q )
+{
+    if ( 0 == size )
+        return Q ? "8h" : "4h";
+
+    if ( 1 == size )
+        return Q ? "4s" : "2s";
+
+    if ( 2 == size )
+        return Q ? "2d" : "1d";
+
+    return "UNKNOWN";
+} //get_saddlp_vector_T
+
+static const char * get_vector_T( uint64_t imm5, uint64_t Q )
+{
+    if ( 1 == ( 1 & imm5 ) )
+        return Q ? "16b" : "8b";
+
+    if ( 2 == ( 3 & imm5 ) )
+        return Q ? "8h" : "4h";
+
+    if ( 4 == ( 7 & imm5 ) )
+        return Q ? "4s" : "2s";
+
+    if ( 8 == ( 0xf & imm5 ) )
+        return Q ? "2d" : "RESERVED";
+
+    return "RESERVED";
+} //get_vector_T
+
+static const char * get_sshr_vector_T( uint64_t immh, uint64_t Q )
+{
+    if ( 1 == immh )
+        return Q ? "16b" : "8b";
+
+    if ( 2 == ( 0xe & immh ) )
+        return Q ? "8h" : "4h";
+
+    if ( 4 == ( 0xc & immh ) )
+        return Q ? "4s" : "2s";
+
+    if ( 8 == ( 8 & immh ) )
+        return Q ? "2d" : "RESERVED";
+
+    return "RESERVED";
+} //get_sshr_vector_T
+
+uint64_t Arm64::extend_reg( uint64_t m, uint64_t extend_type, uint64_t shift, bool fullm )
+{
+    uint64_t x = ( 31 == m ) ? 0 : regs[ m ];
+    if ( !fullm )
+        x = (uint32_t) x;
+
+    switch( extend_type )
+    {
+        case 0: { x &= 0xff; break; }                 // UXTB
+        case 1: { x &= 0xffff; break; }               // UXTH
+        case 2: { x &= 0xffffffff; break; }           // LSL/UXTW
+        case 3: { break; }                            // UXTX
+        case 4: { x = sign_extend( x, 7 ); break; }   // SXTB
+        case 5: { x = sign_extend( x, 15 ); break; }  // SXTH
+        case 6: { x = sign_extend( x, 31 ); break; }  // SXTW
+        case 7: { break; }                            // SXTX
+        default: unhandled();
+    }
+
+    x <<= shift;
+    return x;
+} //extend_reg
+
+static const char * shift_type( uint64_t x )
+{
+    if ( 0 == x )
+        return "lsl";
+    if ( 1 == x )
+        return "lsr";
+    if ( 2 == x )
+        return "asr";
+    if ( 3 == x )
+        return "ror";
+
+    return "UNKNOWN_SHIFT";
+} //shift_type
+
+static const char * extend_type( uint64_t x )
+{
+    if ( 0 == x )
+        return "UXTB";
+    if ( 1 == x )
+        return "UXTH";
+    if ( 2 == x )
+        return "UXTW";
+    if ( 3 == x )
+        return "LSL | UXTW";
+    if ( 4 == x )
+        return "SXTB";
+    if ( 5 == x )
+        return "SXTH";
+    if ( 6 == x )
+        return "SXTW";
+    if ( 7 == x )
+        return "SXTX";
+    return "UNKNOWN_EXTEND";
+} //extend_type
+
+uint64_t Arm64::replicate_bytes( uint64_t val, uint64_t byte_len )
+{
+    uint64_t mask = one_bits( byte_len * 8 );
+    uint64_t pattern = ( val & mask );
+    uint64_t repeat = 8 / byte_len;
+    uint64_t result = 0;
+    for ( uint64_t x = 0; x < repeat; x++ )
+        result |= ( pattern << ( x * byte_len * 8 ) );
+
+    //tracer.Trace( "replicate bytes val %#llx byte_len %lld. mask %#llx, pattern %#llx, repeat %lld, result %#llx\n", val, byte_len, mask, pattern, repeat, result );
+    return result;
+} //replicate_bytes
+
+uint64_t Arm64::adv_simd_expand_imm( uint64_t operand, uint64_t cmode, uint64_t imm8 )
+{
+    //tracer.Trace( "operand %#llx, cmode %#llx, imm8 %#llx\n", operand, cmode, imm8 );
+    uint64_t imm64 = 0;
+    uint64_t cm = ( cmode >> 1 );
+    switch ( cm )
+    {
+        case 0: { imm64 = replicate_bytes( imm8, 4 ); break; }
+        case 1: { imm64 = replicate_bytes( imm8 << 8, 4 ); break; }
+        case 2: { imm64 = replicate_bytes( imm8 << 16, 4 ); break; }
+        case 3: { imm64 = replicate_bytes( imm8 << 24, 4 ); break; }
+        case 4: { imm64 = replicate_bytes( imm8, 2 ); break; }
+        case 5: { imm64 = replicate_bytes( imm8 << 8, 2 ); break; }
+        case 6:
+        {
+            if ( 1 == ( cmode & 1 ) )
+                imm64 = replicate_bytes( ( imm8 << 16 ) | 0xffff, 4 );
+            else
+                imm64 = replicate_bytes( ( imm8 << 8 ) | 0xff, 4 );
+            break;
+        }
+        case 7:
+        {
+            if ( 0 == ( cmode & 1 ) )
             {
-                if ( size > 1 )
+                if  ( 0 == operand )
+                    imm64 = replicate_bytes( imm8, 1 );
+                else if ( 1 == operand )
+                {
+                    uint64_t imm8a = ( imm8 & 0x80 ) ? 0xff : 0;
+                    uint64_t imm8b = ( imm8 & 0x40 ) ? 0xff : 0;
+                    uint64_t imm8c = ( imm8 & 0x20 ) ? 0xff : 0;
+                    uint64_t imm8d = ( imm8 & 0x10 ) ? 0xff : 0;
+                    uint64_t imm8e = ( imm8 & 0x08 ) ? 0xff : 0;
+                    uint64_t imm8f = ( imm8 & 0x04 ) ? 0xff : 0;
+                    uint64_t imm8g = ( imm8 & 0x02 ) ? 0xff : 0;
+                    uint64_t imm8h = ( imm8 & 0x01 ) ? 0xff : 0;
+                    imm64 = ( imm8a << 56 ) | ( imm8b << 48 ) | ( imm8c << 40 ) | ( imm8d << 32 ) | ( imm8e << 24 ) | ( imm8f << 16 ) | ( imm8g << 8 ) | imm8h;
+                }
+                else
                     unhandled();
-                tracer.Trace( "rev32 v%llu.%s, v%llu.%s\n", d, pT, n, pT );
             }
-            else if ( bit21 && 0 == bits20_17 && 0x22 == bits16_10 ) // CMGE <Vd>.<T>, <Vn>.<T>, #0
-                tracer.Trace( "cmge v%llu.%s, v%llu.%s, #0\n", d, pT, n, pT );
-            else if ( 1 == bits23_21 && 0 == bits20_16 && 0x16 == bits15_10 ) // NOT <Vd>.<T>, <Vn>.<T>. AKA MVN
+            else
             {
-                pT = Q ? "16b" : "8b";
-                tracer.Trace( "not v%llu.%s, v%llu.%s # aka mvn\n", d, pT, n, pT );
+                if ( 0 == operand )
+                {
+                    // imm32 = imm8<7>:NOT(imm8<6>):Replicate(imm8<6>,5):imm8<5:0>:Zeros(19);
+                    // imm64 = Replicate(imm32, 2);
+
+                    uint64_t a = get_bit( imm8, 7 );
+                    uint64_t b = !get_bit( imm8, 6 );
+                    uint64_t c = replicate_bit( get_bit( imm8, 6 ), 5 );
+                    uint64_t d = get_bits( imm8, 0, 6 );
+                    uint32_t imm32 = (uint32_t) ( ( ( a << 12 ) | ( b << 11 ) | ( c << 6 ) | d ) << 19 );
+                    imm64 = replicate_bytes( imm32, 4 );
+                }
+                else
+                {
+                    // imm64 = imm8<7>:NOT(imm8<6>):Replicate(imm8<6>,8):imm8<5:0>:Zeros(48);
+                    imm64 = ( get_bit( imm8, 7 ) << 63 ) |
+                            ( ( get_bit( imm8, 6 ) ? 0ull : 1ull ) << 62 ) |
+                            ( replicate_bit( get_bit( imm8, 6 ), 8 ) << ( 62 - 8 ) ) |
+                            ( get_bits( imm8, 0, 6 ) << 48 );
+                }
             }
-            else if ( !bit23 && bit21 && 0x39 == bits15_10 ) // FCMGE <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+            break;
+        }
+        default: { unhandled(); }
+    }
+
+    //tracer.Trace( "expand imm cmode %#llx, from %llx to %llx\n", cmode, imm8, imm64 );
+    return imm64;
+} //adv_simd_expand_imm
+
+static inline uint64_t ror( uint64_t elt, uint64_t size )
+{
+    return ( ( elt & 1 ) << ( size - 1 ) ) | ( elt >> 1 );
+} //ror
+
+static inline uint64_t ror_n( uint64_t elt, uint64_t size, uint64_t amount )
+{
+    return ( ( elt >> amount ) | ( elt << ( size - amount ) ) );
+} //ror_n
+
+static uint64_t decode_logical_immediate( uint64_t val, uint64_t bit_width )
+{
+    uint64_t N = get_bit( val, 12 );
+    uint64_t immr = get_bits( val, 6, 6 );
+    uint64_t imms = get_bits( val, 0, 6 );
+
+    uint64_t lzero_count = count_leading_zeroes32( (uint32_t) ( ( N << 6 ) | ( ( ~imms ) & 0x3f ) ) );
+    uint64_t len = 31 - lzero_count;
+    uint64_t size = ( 1ull << len );
+    uint64_t R = ( immr & ( size - 1 ) );
+    uint64_t S = ( imms & ( size - 1 ) );
+    uint64_t pattern = ( 1ull << ( S + 1 ) ) - 1;
+    pattern = ror_n( pattern, size, R );
+
+    assert( 32 == bit_width || 64 == bit_width );
+    while ( size != bit_width )
+    {
+        pattern |= ( pattern << size );
+        size *= 2;
+    }
+
+    if ( 32 == bit_width )
+        pattern = (uint32_t) pattern;
+    return pattern;
+} //decode_logical_immediate
+
+static const char * conditions[16] = { "eq", "ne", "cs", "cc", "mi", "pl", "vs", "vc", "hi", "ls", "ge", "lt", "gt", "le", "al", "nv" };
+
+static const char * get_cond( uint64_t x )
+{
+    if ( x <= 15 )
+        return conditions[ x ];
+
+    return "UNKNOWN_CONDITION";
+} //get_cond
+
+static char get_byte_len( uint64_t l )
+{
+    if ( 1 == l )
+        return 'b';
+    if ( 2 == l )
+        return 'h';
+    if ( 4 == l )
+        return 's';
+    if ( 8 == l )
+        return 'd';
+    if ( 16 == l )
+        return 'q';
+
+    return '?';
+} //get_byte_len
+
+static uint64_t vfp_expand_imm( uint64_t imm8, uint64_t N )
+{
+    assert( 16 == N || 32 == N || 64 == N );
+    uint64_t E = ( 16 == N ) ? 5 : ( 32 == N ) ? 8 : 11;
+    uint64_t F = N - E - 1;
+    uint64_t sign = ( 0 != ( imm8 & 0x80 ) );
+    uint64_t exp_part_1 = ( get_bit( imm8, 6 ) ? 0 : 1 );
+    uint64_t exp_part_2 = replicate_bit( get_bit( imm8, 6 ), E - 3 );
+    uint64_t exp_part_3 = get_bits( imm8, 4, 2 );
+    uint64_t exp = ( exp_part_1 << ( E - 3 + 2 ) ) | ( exp_part_2 << 2 ) | exp_part_3;
+    uint64_t frac_shift = F - 4;
+    uint64_t frac = ( imm8 & 0xf ) << frac_shift;
+    uint64_t result = ( sign << ( N - 1 ) ) | ( exp << F ) | frac;
+//    tracer.Trace( "result %#llx, imm8 %llu, N %llu, E %llu, F %llu, sign %llu, exp %#llx, exp1 %#llx, exp2 %#llx, exp3 %#llx, frac_shift %llu, frac %#llx\n",
+//                  result, imm8, N, E, F, sign, exp, exp_part_1, exp_part_2, exp_part_3, frac_shift, frac );
+    return result;
+} //vfp_expand_imm
+
+static char get_fcvt_precision( uint64_t x )
+{
+    return ( 0 == x ) ? 's' : ( 1 == x ) ? 'd' : ( 3 == x ) ? 'h' : '?';
+} //get_fcvt_precision
+
+void Arm64::trace_state()
+{
+    if ( !tracer.IsEnabled() ) // can happen when an app enables instruction tracing via a syscall but overall tracing is turned off.
+        return;
+
+    static const char * previous_symbol = 0;
+    uint64_t symbol_offset;
+    const char * symbol_name = emulator_symbol_lookup( pc, symbol_offset );
+    if ( symbol_name == previous_symbol )
+        symbol_name = "";
+    else
+        previous_symbol = symbol_name;
+
+    char symbol_offset_str[ 40 ];
+    symbol_offset_str[ 0 ] = 0;
+
+    if ( 0 != symbol_name[ 0 ] )
+    {
+        if ( 0 != symbol_offset )
+            snprintf( symbol_offset_str, _countof( symbol_offset_str ), " + %llx", symbol_offset );
+        strcat( symbol_offset_str, "\n            " );
+    }
+
+    //tracer.TraceBinaryData( getmem( 0x2cb97f0 + 16 ), 16, 4 );
+
+    tracer.Trace( "pc %8llx %s%s op %08llx %s ==> ", pc, symbol_name, symbol_offset_str, op, render_flags() );
+
+    uint8_t hi8 = (uint8_t) ( op >> 24 );
+    switch ( hi8 )
+    {
+        case 0: // UDF
+        {
+            uint64_t bits23to16 = opbits( 16, 8 );
+            uint64_t imm16 = opbits( 0, 16 );
+            if ( 0 == bits23to16 )
+                tracer.Trace( "udf %#llx\n", imm16 );
+            else
+                unhandled();
+            break;
+        }
+        case 0x5f: // SHL D<d>, D<n>, #<shift>    ;    FMUL <Vd>.<T>, <Vn>.<T>, <Vm>.<Ts>[<index>]    ;    FMLA <Vd>.<T>, <Vn>.<T>, <Vm>.<Ts>[<index>]
+                   // SSHR D<d>, D<n>, #<shift>
+        {
+            uint64_t n = opbits( 5, 5 );
+            uint64_t d = opbits( 0, 5 );
+            uint64_t opcode = opbits( 10, 6 );
+            uint64_t immh = opbits( 19, 4 );
+            uint64_t immb = opbits( 16, 3 );
+            uint64_t bit23 = opbit( 23 );
+            uint64_t bit22 = opbit( 22 );
+            uint64_t bits15_10 = opbits( 10, 6 );
+
+            if ( !bit23 && bit22 && 0x15 == opcode ) // SHL D<d>, D<n>, #<shift>
             {
-                uint64_t sz = opbit( 22 );
-                pT = sz ? Q ? "2d" : "reserved" : Q ? "4s" : "2s";
-                tracer.Trace( "fcmge v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
+                uint64_t esize = 8ull << 3;
+                uint64_t shift = ( ( immh << 3 ) | immb ) - esize;
+                tracer.Trace( "shl d%llu, d%llu, #%llu\n", d, n, shift );
             }
-            else if ( bit23 && bit21 && 0x39 == bits15_10 ) // FCMGT <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+            else if ( bit23 && ( 4 == opcode || 6 == opcode || 0x24 == opcode || 0x26 == opcode ) ) // FMUL <Vd>.<T>, <Vn>.<T>, <Vm>.<Ts>[<index>]    ;    FMLA <Vd>.<T>, <Vn>.<T>, <Vm>.<Ts>[<index>]
             {
+                uint64_t m = opbits( 16, 5 );
                 uint64_t sz = opbit( 22 );
-                pT = sz ? Q ? "2d" : "reserved" : Q ? "4s" : "2s";
-                tracer.Trace( "fcmgt v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
+                uint64_t L = opbit( 21 );
+                uint64_t M = opbit( 20 );
+                uint64_t H = opbit( 11 );
+                char v = sz ? 'd' : 's';
+                uint64_t Rmhi = M;
+                if ( 0 == sz )
+                    Rmhi = ( H << 1 ) | L;
+                else if ( 0 == L )
+                    Rmhi = H;
+                else
+                    unhandled();
+
+                tracer.Trace( "%s %c%llu, %c%llu, v%llu.%c[%llu]\n", ( 4 == opcode || 6 == opcode ) ? "fmla" : "fmul", v, d, v, n, m, v, Rmhi );
             }
-            else if ( bit21 && 1 == bits20_16 && 0x12 == bits15_10 ) // UQXTN{2} <Vd>.<Tb>, <Vn>.<Ta>
+            else if ( !bit23 && bit22 && 1 == bits15_10 ) // SSHR D<d>, D<n>, #<shift>
             {
-                const char * pTA = get_saddlp_vector_T( size, 1 );
-                const char * pTB = get_ld1_vector_T( size, Q );
-                tracer.Trace( "uqxtn%s v%llu.%s, v%llu.%s\n", Q ? "2" : "", d, pTB, n, pTA );
+                uint64_t esize = 8ull << 3;
+                uint64_t shift = ( esize * 2 ) - ( ( immh << 3 ) | immb );
+                tracer.Trace( "sshr d%llu, d%llu, #%llu\n", d, n, shift );
             }
-            else if ( bit21 && 0 == bits20_17 && 0x26 == bits16_10 ) // CMLE <Vd>.<T>, <Vn>.<T>, #0
-                tracer.Trace( "cmle v%llu.%s, v%llu.%s, #0\n", d, pT, n, pT );
-            else if ( bit21 && 0 == bits20_17 && 0x1a == bits16_10 ) // UADALP <Vd>.<Ta>, <Vn>.<Tb>
+            else
+                unhandled();
+            break;
+        }
+        case 0x0d: case 0x4d: // LD1 { <Vt>.B }[<index>], [<Xn|SP>]    ;    LD1 { <Vt>.B }[<index>], [<Xn|SP>], #1
+                              // LD1R { <Vt>.<T> }, [<Xn|SP>], <imm>   ;    LD1R { <Vt>.<T> }, [<Xn|SP>], <Xm>
+                              // ST1 { <Vt>.B }[<index>], [<Xn|SP>]    ;    ST1 { <Vt>.B }[<index>], [<Xn|SP>], #1
+        {
+            uint64_t R = opbit( 21 );
+            if ( R )
+                unhandled();
+            uint64_t post_index = opbit( 23 );
+            uint64_t opcode = opbits( 13, 3 );
+            uint64_t bit13 = opbit( 13 );
+            if ( bit13 )
+                unhandled();
+            uint64_t size = opbits( 10, 2 );
+            uint64_t n = opbits( 5, 5 );
+            uint64_t m = opbits( 16, 5 );
+            uint64_t t = opbits( 0, 5 );
+            uint64_t replicate = ( 6 == opcode );
+            uint64_t S = opbit( 12 );
+            uint64_t Q = opbit( 30 );
+            uint64_t L = opbit( 22 );
+            uint64_t index = 0;
+            uint64_t scale = get_bits( opcode, 1, 2 );
+            if ( 3 == scale )
+                scale = size;
+            else if ( 0 == scale )
+                index = ( Q << 3 ) | ( S << 2 ) | size;
+            else if ( 1 == scale )
+                index = ( Q << 2 ) | ( S << 1 ) | get_bit( size, 1 );
+            else if ( 2 == scale )
             {
-                const char * pTA = get_saddlp_vector_T( size, Q );
-                const char * pTB = get_ld1_vector_T( size, Q );
-                tracer.Trace( "uadalp v%llu.%s, v%llu.%s\n", d, pTA, n, pTB );
+                if ( 0 == ( size & 1 ) )
+                    index = ( Q << 1 ) | S;
+                else
+                {
+                    index = Q;
+                    scale = 3;
+                }
             }
-            else if ( bit21 && 0 == bits20_17 && 0xa == bits16_10 ) // UADDLP <Vd>.<Ta>, <Vn>.<Tb>
+
+            const char * pOP = L ? "ld" : "st";
+            char type = ( 0 == opcode ) ? 'b' : ( 2 == opcode ) ? 'h' : ( 4 == opcode && 0 == size ) ? 's' : 'd';
+            if ( post_index )
             {
-                const char * pTA = get_saddlp_vector_T( size, Q );
-                const char * pTB = get_ld1_vector_T( size, Q );
-                tracer.Trace( "uaddlp v%llu.%s, v%llu.%s\n", d, pTA, n, pTB );
-            }
-            else if ( bit23 && bit21 && 0 == bits20_17 && 0x7e == bits16_10 ) // FSQRT <Vd>.<T>, <Vn>.<T>
-            {
-                uint64_t sz = opbit( 22 );
-                const char * pTA = sz ? Q ? "2d" : "reserved" : Q ? "4s" : "2s";
-                tracer.Trace( "fsqrt v%llu.%s, v%llu.%s\n", d, pTA, n, pTA );
-            }
-            else if ( bit21 && 8 == bits15_10 ) // USUBL{2} <Vd>.<Ta>, <Vn>.<Tb>, <Vm>.<Tb>
-            {
-                const char * pTA = ( 0 == size ) ? "8h" : ( 1 == size ) ? "4s" : ( 2 == size ) ? "2d" : "reserved";
-                tracer.Trace( "uasub%s v%llu.%s, v%llu.%s, v%llu.%s\n", Q ? "2" : "", d, pTA, n, pT, m, pT );
-            }
-            else if ( bit21 && 0 == bits15_10 ) // UADDL{2} <Vd>.<Ta>, <Vn>.<Tb>, <Vm>.<Tb>
-            {
-                const char * pTA = ( 0 == size ) ? "8h" : ( 1 == size ) ? "4s" : ( 2 == size ) ? "2d" : "reserved";
-                tracer.Trace( "uaddl%s v%llu.%s, v%llu.%s, v%llu.%s\n", Q ? "2" : "", d, pTA, n, pT, m, pT );
-            }
-            else if ( bit21 && 0xc == bits15_10 ) // USUBW{2} <Vd>.<Ta>, <Vn>.<Ta>, <Vm>.<Tb>
-            {
-                const char * pTA = ( 0 == size ) ? "8h" : ( 1 == size ) ? "4s" : ( 2 == size ) ? "2d" : "reserved";
-                tracer.Trace( "usubw%s v%llu.%s, v%llu.%s, v%llu.%s\n", Q ? "2" : "", d, pTA, n, pTA, m, pT );
-            }
-            else if ( bit21 && 0x20 == bits15_10 ) // UMLAL{2} <Vd>.<Ta>, <Vn>.<Tb>, <Vm>.<Tb>
-            {
-                const char * pTA = ( 0 == size ) ? "8h" : ( 1 == size ) ? "4s" : ( 2 == size ) ? "2d" : "reserved";
-                tracer.Trace( "umlal%s v%llu.%s, v%llu.%s, v%llu.%s\n", Q ? "2" : "", d, pTA, n, pT, m, pT );
-            }
-            else if ( bit21 && 0x28 == bits15_10 ) // UMLSL{2} <Vd>.<Ta>, <Vn>.<Tb>, <Vm>.<Tb>
-            {
-                const char * pTA = ( 0 == size ) ? "8h" : ( 1 == size ) ? "4s" : ( 2 == size ) ? "2d" : "reserved";
-                tracer.Trace( "umlsl%s v%llu.%s, v%llu.%s, v%llu.%s\n", Q ? "2" : "", d, pTA, n, pT, m, pT );
-            }
-            else if ( !bit23 && bit21 && 0 == bits20_17 && 0x76 == bits16_10 ) // UCVTF <Vd>.<T>, <Vn>.<T>
-            {
-                uint64_t sz = opbit( 22 );
-                const char * pTA = sz ? Q ? "2d" : "reserved" : Q ? "4s" : "2s";
-                tracer.Trace( "ucvtf v%llu.%s, v%llu.%s\n", d, pTA, n, pTA );
-            }
-            else if ( bit23 && bit21 && 0 == bits20_17 && 0x6e == bits16_10 ) // FCVTZU <Vd>.<T>, <Vn>.<T>
-            {
-                uint64_t sz = opbit( 22 );
-                const char * pTA = sz ? Q ? "2d" : "reserved" : Q ? "4s" : "2s";
-                tracer.Trace( "fcvtzu v%llu.%s, v%llu.%s\n", d, pTA, n, pTA );
-            }
-            else if ( 0 == bits23_21 && !bit15 && !bit10 ) // EXT <Vd>.<T>, <Vn>.<T>, <Vm>.<T>, #<index>
-            {
-                uint64_t imm4 = opbits( 11, 4 );
-                const char * pTA = Q ? "16b" : "8b";
-                tracer.Trace( "ext v%llu.%s, v%llu.%s, v%llu.%s, #%llu\n", d, pTA, n, pTA, m, pTA, imm4 );
-            }
-            else if ( bit21 && 0 == bits20_17 && 0x2e == bits16_10 ) // NEG <Vd>.<T>, <Vn>.<T>
-                tracer.Trace( "neg v%llu.%s, v%llu.%s\n", d, pT, n, pT );
-            else if ( bit21 && 0x25 == bits15_10 ) // MLS <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-                tracer.Trace( "mls v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
-            else if ( 0x6e == hi8 && ( 5 == bits23_21 || 1 == bits23_21 ) && 8 == bits20_17 && 0x32 == bits16_10 ) // FMINNMV S<d>, <Vn>.4S    ;    FMAXNMV S<d>, <Vn>.4S
-                tracer.Trace( "%s s%llu, v%llu.4s\n", 5 == bits23_21 ? "fminnmv" : "fmaxnmv", d, n );
-            else if ( !bit23 && bit21 && 0x3f == bits15_10 ) // FDIV <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-            {
-                uint64_t sz = opbit( 22 );
-                pT = ( !sz && !Q ) ? "2s" : ( !sz && Q ) ? "4s" : ( sz && Q ) ? "2d" : "?";
-                tracer.Trace( "v%llu.%s, v%llu.%s, v%llu.%s\n", n, pT, n, pT, m, pT );
-            }
-            else if ( bit21 && ( 0x1b == bits15_10 || 0x19 == bits15_10 ) ) // UMIN <Vd>.<T>, <Vn>.<T>, <Vm>.<T>    ;    UMAX <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-                tracer.Trace( "%s v%llu.%s, v%llu.%s, %llu.%s\n", ( 0x1b == bits15_10 ) ? "umin" : "umax", d, pT, n, pT, m, pT );
-            else if ( bit21 && 8 == bits20_17 && ( 0x6a == bits16_10 || 0x2a == bits16_10 ) ) // UMINV <V><d>, <Vn>.<T>    ;    UMAXV <V><d>, <Vn>.<T>
-            {
-                char v = ( 0 == size ) ? 'b' : ( 1 == size ) ? 'h' : ( 2 == size ) ? 's' : '?';
-                tracer.Trace( "%s %c%llu, v%llu.%s\n", ( 0x6a == bits16_10 ) ? "uminv" : "unaxv", v, d, n, pT );
-            }
-            else if ( bit21 && 4 == bits15_10 ) // UADDW{2} <Vd>.<Ta>, <Vn>.<Ta>, <Vm>.<Tb>
-            {
-                const char * pTA = ( 0 == size ) ? "8h" : ( 1 == size ) ? "4s" : ( 2 == size ) ? "2d" : "?";
-                const char * pTB = get_ld1_vector_T( size, Q );
-                tracer.Trace( "uaddw%s, v%llu.%s, v%llu.%s, v%llu.%s\n", Q ? "2" : "", d, pTA, n, pTA, m, pTB );
-            }
-            else if ( bit23 && bit21 && 0 == bits20_17 && 0x3e == bits16_10 ) // FNEG <Vd>.<T>, <Vn>.<T>
-            {
-                uint64_t sz = opbit( 22 );
-                uint64_t ty = ( sz << 1 ) | Q;
-                pT = ( 0 == ty ) ? "2s" : ( 1 == ty ) ? "4s" : ( 3 == ty ) ? "2d" : "?";
-                tracer.Trace( "fneg v%llu.%s, v%llu.%s\n", d, pT, n, pT );
-            }
-            else if ( !bit23 && bit21 && 0x35 == opcode ) // FADDP <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-            {
-                uint64_t sz = opbit( 22 );
-                uint64_t ty = ( sz << 1 ) | Q;
-                pT = ( 0 == ty ) ? "2s" : ( 1 == ty ) ? "4s" : ( 3 == ty ) ? "2d" : "?";
-                tracer.Trace( "faddp v%llu.%s, v%llu,%s, v%llu.%s\n", d, pT, n, pT, m, pT );
-            }
-            else if ( bit21 && 0x11 == opcode ) // USHL <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-                tracer.Trace( "ushl, v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
-            else if ( bit21 && 8 == bits20_17 && 0xe == opcode7 ) // UADDLV <V><d>, <Vn>.<T>
-                tracer.Trace( "uaddlv v%llu, v%llu.%s\n", d, n, pT );
-            else if ( 0x6e == hi8 && 0 == bits23_21 && !bit15 && bit10 ) // INS <Vd>.<Ts>[<index>], <R><n>
-            {
-                uint64_t imm5 = opbits( 16, 5 );
-                uint64_t imm4 = opbits( 11, 5 );
-                uint64_t index1 = 0;
-                uint64_t index2 = 0;
-                char T = '?';
-                if ( 1 & imm5 )
-                {
-                    index1 = get_bits( imm5, 1, 4 );
-                    index2 = imm4;
-                    T = 'B';
-                }
-                else if ( 2 & imm5 )
-                {
-                    index1 = get_bits( imm5, 2, 3 );
-                    index2 = get_bits( imm4, 1, 3 );
-                    T = 'H';
-                }
-                else if ( 4 & imm5 )
-                {
-                    index1 = get_bits( imm5, 3, 2 );
-                    index2 = get_bits( imm4, 2, 2 );
-                    T = 'S';
-                }
-                else if ( 8 & imm5 )
+                if ( 31 == m ) // immediate offset
                 {
-                    index1 = get_bit( imm5, 4 );
-                    index2 = get_bit( imm4, 3 );
-                    T = 'D';
+                    uint64_t imm = 1ull << size;
+                    tracer.Trace( "%s1%s {v%llu.%c}[%llu], [%s], #%llu\n", pOP, replicate ? "r" : "", t, type, index, reg_or_sp( n, true ), imm );
                 }
-
-                tracer.Trace( "ins v%llu.%c[%llu], v%llu.%c[%llu]\n", d, T, index1, n, T, index2 );
-            }
-            else if ( bit21 && 0x0d == opcode )
-                tracer.Trace( "cmhi v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
-            else if ( bit21 && 0x23 == opcode )
-                tracer.Trace( "cmeq v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
-            else if ( bit21 && 0x0f == opcode )
-                tracer.Trace( "cmhs v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
-            else if ( bit21 && 0x29 == opcode )
-                tracer.Trace( "umaxp v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
-            else if ( bit21 && 0x2b == opcode )
-                tracer.Trace( "uminp v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
-            else if ( bit21 && 0x07 == opcode )
-            {
-                uint64_t opc2 = opbits( 22, 2 );
-                pT = ( 0 == Q ) ? "8B" : "16B";
-                tracer.Trace( "%s v%llu.%s, v%llu.%s, v%llu.%s\n", ( 1 == opc2 ) ? "bsl" : ( 2 == opc2) ? "bit" : ( 3 == opc2 ) ? "bif" : "eor", d, pT, n, pT, m, pT );
-            }
-            else if ( bit21 && 0x21 == opcode )
-                tracer.Trace( "sub v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
-            else if ( bit21 && 0x30 == opcode )
-            {
-                const char * pTA = ( 0 == size ) ? "8h" : ( 1 == size ) ? "4s" : ( 2 == size ) ? "2d" : "?";
-                const char * pTB = get_ld1_vector_T( size, Q );
-                tracer.Trace( "umull%s v%llu.%s, v%llu.%s, v%llu.%s\n", Q ? "2" : "", d, pTA, n, pTB, m, pTB );
-            }
-            else if ( bit21 && 0x25 == opcode ) // MLS <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-            {
-                if ( 3 == size )
-                    unhandled();
-                tracer.Trace( "mls v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
-            }
-            else if ( bit21 && 0x37 == opcode )
-            {
-                uint64_t sz = opbit( 22 );
-                pT = ( 0 == sz ) ? ( 0 == Q ? "2S" : "4S" ) : ( 0 == Q ? "?" : "2D" );
-                tracer.Trace( "fmul v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
-            }
-            else if ( !bit21 && 0 == size && !bit10 && !bit15 )
-            {
-                uint64_t imm4 = opbits( 11, 4 );
-                pT = Q ? "8B" : "16B";
-                tracer.Trace( "ext v%llu.%s, v%llu.%s, v%llu.%s, #%llu\n", d, pT, n, pT, m, pT, imm4 );
+                else // register offset
+                    tracer.Trace( "%s1%s {v%llu.%c}[%llu], [%s], %s\n", pOP, replicate ? "r" : "", t, type, index, reg_or_sp( n, true ), reg_or_zr( m, true ) );
             }
-            else
-                unhandled();
+            else // no offset
+                tracer.Trace( "%s1%s {v%llu.%c}[%llu], [%s]\n", pOP, replicate ? "r" : "", t, type, index, reg_or_sp( n, true ) );
             break;
         }
-        case 0x5e: // SCVTF <V><d>, <V><n>    ;    ADDP D<d>, <Vn>.2D    ;    DUP <V><d>, <Vn>.<T>[<index>]    ;    FCVTZS <V><d>, <V><n>
-                   // CMGT D<d>, D<n>, D<m>   ;    CMGT D<d>, D<n>, #0   ;    ADD D<d>, D<n>, D<m>             ;    FCMLT <V><d>, <V><n>, #0.0
-                   // CMEQ D<d>, D<n>, #0
+        case 0x08: // LDAXRB <Wt>, [<Xn|SP>{, #0}]    ;    LDARB <Wt>, [<Xn|SP>{, #0}]    ;    STLXRB <Ws>, <Wt>, [<Xn|SP>{, #0}]    ;    STLRB <Wt>, [<Xn|SP>{, #0}]
+                   // STXRB <Ws>, <Wt>, [<Xn|SP>{, #0}] ;  LDXRB <Wt>, [<Xn|SP>{, #0}]
+        case 0x48: // LDAXRH <Wt>, [<Xn|SP>{, #0}]    ;    LDARH <Wt>, [<Xn|SP>{, #0}]    ;    STLXRH <Ws>, <Wt>, [<Xn|SP>{, #0}]    ;    STLRH <Wt>, [<Xn|SP>{, #0}]
+                   // STXRH <Ws>, <Wt>, [<Xn|SP>{, #0}] ;  LDXRH <Wt>, [<Xn|SP>{, #0}]
         {
-            uint64_t bits23_10 = opbits( 10, 14 );
             uint64_t bit23 = opbit( 23 );
+            uint64_t L = opbit( 21 );
             uint64_t bit21 = opbit( 21 );
-            uint64_t bits23_21 = opbits( 21, 3 );
-            uint64_t bits20_16 = opbits( 16, 5 );
-            uint64_t bits15_10 = opbits( 10, 6 );
+            uint64_t s = opbits( 16, 5 );
+            uint64_t oO = opbit( 15 );
+            uint64_t t2 = opbits( 10, 5 );
             uint64_t n = opbits( 5, 5 );
-            uint64_t d = opbits( 0, 5 );
+            uint64_t t = opbits( 0, 5 );
 
-            if ( 7 == bits23_21 && 0 == bits20_16 && 0x26 == bits15_10 ) // CMEQ D<d>, D<n>, #0
-                tracer.Trace( "cmeq d%llu, d%llu, #0\n", d, n );
-            else if ( bit23 && bit21 && 0 == bits20_16 && 0x3a == bits15_10 ) // FCMLT <V><d>, <V><n>, #0.0
-            {
-                uint64_t sz = opbit( 22 );
-                char width = sz ? 'd' : 's';
-                tracer.Trace( "%c%llu, %c%llu, #0.0\n", width, d, width, n );
-            }
-            else if ( 7 == bits23_21 && 0x21 == bits15_10 ) // ADD D<d>, D<n>, D<m>
-            {
-                uint64_t m = opbits( 16, 5 );
-                tracer.Trace( "add d%llu, d%llu, d%llu\n", d, n, m );
-            }
-            else if ( 7 == bits23_21 && 0xd == bits15_10 ) // CMGT D<d>, D<n>, D<m>
-            {
-                uint64_t m = opbits( 16, 5 );
-                tracer.Trace( "cmgt d%llu, d%llu, d%llu\n", d, n, m );
-            }
-            else if ( 0x3822 == bits23_10 ) // CMGT D<d>, D<n>, #0
+            if ( 0x1f != t2 )
+                unhandled();
+
+            const char * acquire_release = opbit( 22 ) ? ( oO ? "al" : "a" ) : ( oO ? "l" : "" );
+
+            if ( bit21 && bit23 ) // CAS{A}{L}B/H
             {
-                tracer.Trace( "cmgt d%llu, d%llu, #0\n", d, n ); // code not implemented
+                tracer.Trace( "cas%s%c w%llu, w%llu, [%s]\n", acquire_release, ( hi8 & 0x40 ) ? 'h' : 'b', s, t, reg_or_sp( n, true ) );
+                break;
             }
-            else if ( 0x386e == bits23_10 || 0x286e == bits23_10 ) // FCVTZS <V><d>, <V><n>
+            else if ( bit21 ) // CASP{A}{L}
             {
-                uint64_t sz = opbit( 22 );
-                char width = sz ? 'd' : 's';
-                tracer.Trace( "fcvtzs %c%llu, %c%llu\n", width, d, width, n );
+                bool xregs = ( 0 != ( hi8 & 0x40 ) );
+                tracer.Trace( "casp%s %s, %s, %s, %s, [%s]\n", acquire_release, reg_or_zr( s, xregs ), reg_or_zr( s + 1, xregs ),
+                              reg_or_zr( t, xregs ), reg_or_zr( t + 1, xregs ), reg_or_sp( n, true ) );
+                break;
             }
-            else if ( 0x0876 == ( bits23_10 & 0x2fff ) ) // SCVTF <V><d>, <V><n>
+
+            char suffix = ( hi8 & 0x40 ) ? 'h' : 'b';
+
+            if ( L )
             {
-                uint64_t sz = opbit( 22 );
-                char width = sz ? 'd' : 's';
-                tracer.Trace( "scvtf %c%llu, %c%llu\n", width, d, width, n );
+                if ( 0x1f != s )
+                    unhandled();
+                tracer.Trace( "%s%c, w%llu, [%s, #0]\n", bit23 ? "ldar" : oO ? "ldaxr" : "ldxr", suffix, t, reg_or_sp( n, true ) );
             }
-            else if ( 0x3c6e == bits23_10 ) // DUP <V><d>, <Vn>.<T>[<index>]
-                tracer.Trace( "addp D%llu, v%llu.2D\n", d, n );
-            else if ( 1 == ( bits23_10 & 0x383f ) ) // DUP <V><d>, <Vn>.<T>[<index>]   -- scalar
+            else
             {
-                uint64_t imm5 = opbits( 16, 5 );
-                uint64_t size = lowest_set_bit_nz( imm5 & 0xf );
-                uint64_t index = get_bits( imm5, size + 1, size + 2 ); // imm5:<4:size+1>
-                const char * pT = ( imm5 & 1 ) ? "B" : ( imm5 & 2 ) ? "H" : ( imm5 & 4 ) ? "S" : "D";
-                tracer.Trace( "dup %s%llu, v%llu.%s[%llu]\n", pT, d, n, pT, index );
+                if ( bit23 )
+                    tracer.Trace( "stlr%c w%llu, [%s, #0]\n", suffix, t, reg_or_sp( n, true ) );
+                else
+                    tracer.Trace( "%s%c w%llu, w%llu, [%s, #0]\n", oO ? "stlxr" : "stxr", suffix, s, t, reg_or_sp( n, true ) );
             }
-            else
-                unhandled();
             break;
         }
-        case 0x7e: // CMGE    ;    UCVTF <V><d>, <V><n>    ;    UCVTF <Hd>, <Hn>            ;    FADDP <V><d>, <Vn>.<T>    ;    FABD <V><d>, <V><n>, <V><m>
-                   // FCMGE <V><d>, <V><n>, #0.0           ;    FMINNMP <V><d>, <Vn>.<T>    ;    FMAXNMP <V><d>, <Vn>.<T>
-                   // CMHI D<d>, D<n>, D<m>                ;    FCVTZU <V><d>, <V><n>       ;    FCMGT <V><d>, <V><n>, <V><m>
-                   // FCMGE <V><d>, <V><n>, <V><m>         ;    CMLE D<d>, D<n>, #0         ;    CMGE D<d>, D<n>, #0
+        case 0x1f: // fmadd, vnmadd, fmsub, fnmsub
         {
-            uint64_t bits23_10 = opbits( 10, 14 );
-            uint64_t bits23_21 = opbits( 21, 3 );
-            uint64_t bits20_10 = opbits( 10, 11 );
-            uint64_t bits15_10 = opbits( 10, 6 );
+            uint64_t ftype = opbits( 22, 2 );
+            uint64_t bit21 = opbit( 21 );
+            uint64_t bit15 = opbit( 15 );
+            uint64_t m = opbits( 16, 5 );
+            uint64_t a = opbits( 10, 5 );
             uint64_t n = opbits( 5, 5 );
             uint64_t d = opbits( 0, 5 );
-            uint64_t bit23 = opbit( 23 );
-            uint64_t sz = opbit( 22 );
+
+            bool isn = ( 0 != bit21 );
+            char t = ( 0 == ftype ) ? 's' : ( 3 == ftype ) ? 'h' : ( 1 == ftype ) ? 'd' : '?';
+            if ( !bit15 )
+                tracer.Trace( "%s %c%llu, %c%llu, %c%llu, %c%llu\n", isn ? "fnmadd" : "fmadd", t, d, t, n, t, m, t, a );
+            else
+                tracer.Trace( "%s %c%llu, %c%llu, %c%llu, %c%llu\n", isn ? "fnmsub" : "fmsub", t, d, t, n, t, m, t, a );
+            break;
+        }
+        case 0x3c: // LDR <Bt>, [<Xn|SP>], #<simm>    ;    LDR <Bt>, [<Xn|SP>, #<simm>]!    ;    LDR <Qt>, [<Xn|SP>], #<simm>    ;     LDR <Qt>, [<Xn|SP>, #<simm>]!
+        case 0x3d: // LDR <Bt>, [<Xn|SP>{, #<pimm>}]  ;    LDR <Qt>, [<Xn|SP>{, #<pimm>}]
+        case 0x7c: // LDR <Ht>, [<Xn|SP>], #<simm>    ;    LDR <Ht>, [<Xn|SP>, #<simm>]!
+        case 0x7d: // LDR <Ht>, [<Xn|SP>{, #<pimm>}]
+        case 0xbc:
+        case 0xbd: // LDR <Dt>, [<Xn|SP>{, #<pimm>}]
+        case 0xfc: // LDR <Dt>, [<Xn|SP>], #<simm>    ;    LDR <Dt>, [<Xn|SP>, #<simm>]!    ;    STR <Dt>, [<Xn|SP>], #<simm>    ;    STR <Dt>, [<Xn|SP>, #<simm>]!
+        case 0xfd: // LDR <Dt>, [<Xn|SP>{, #<pimm>}]  ;    STR <Dt>, [<Xn|SP>{, #<pimm>}]   ;    STR <Dt>, [<Xn|SP>, (<Wm>|<Xm>){, <extend> {<amount>}}]
+        {
+            uint64_t bits11_10 = opbits( 10, 2 );
             uint64_t bit21 = opbit( 21 );
-            uint64_t opcode = opbits( 10, 6 );
+            bool unsignedOffset = ( 0xd == ( hi8 & 0xf ) );
+            bool preIndex = ( ( 0xc == ( hi8 & 0xf ) ) && ( 3 == bits11_10 ) );
+            bool postIndex = ( ( 0xc == ( hi8 & 0xf ) ) && ( 1 == bits11_10 ) );
+            bool signedUnscaledOffset = ( ( 0xc == ( hi8 & 0xf ) ) && ( 0 == bits11_10 ) );
+            bool shiftExtend = ( ( 0xc == ( hi8 & 0xf ) ) && ( bit21 ) && ( 2 == bits11_10 ) );
+            uint64_t imm12 = opbits( 10, 12 );
+            int64_t imm9 = sign_extend( opbits( 12, 9 ), 8 );
+            uint64_t size = opbits( 30, 2 );
+            uint64_t opc = opbits( 22, 2 );
+            bool is_ldr = opbit( 22 );
+            uint64_t t = opbits( 0, 5 );
+            uint64_t n = opbits( 5, 5 );
+            uint64_t byte_len = 1ull << size;
 
-            if ( !bit23 && bit21 && 0x39 == bits15_10 ) // FCMGE <V><d>, <V><n>, <V><m>
-            {
-                char width = sz ? 'd' : 's';
-                uint64_t m = opbits( 16, 5 );
-                tracer.Trace( "fcmge %c%llu, %c%llu, %c%llu\n", width, d, width, n, width, m );
-            }
-            else if ( bit23 && bit21 && 0x39 == bits15_10 ) // FCMGT <V><d>, <V><n>, <V><m>
-            {
-                char width = sz ? 'd' : 's';
-                uint64_t m = opbits( 16, 5 );
-                tracer.Trace( "fcmgt %c%llu, %c%llu, %c%llu\n", width, d, width, n, width, m );
-            }
-            else if ( bit23 && bit21 && 0x6e == bits20_10 ) // FCVTZU <V><d>, <V><n>
-            {
-                char width = sz ? 'd' : 's';
-                tracer.Trace( "fcvtzu %c%llu, %c%llu\n", width, d, width, n );
-            }
-            else if ( 7 == bits23_21 && 0xd == bits15_10 ) // CMHI D<d>, D<n>, D<m>
-            {
-                uint64_t m = opbits( 16, 5 );
-                tracer.Trace( " cmhi d%llu, d%llu, d%llu\n", d, n, m );
-            }
-            else if ( bit21 && 0x432 == bits20_10 ) // FMINNMP <V><d>, <Vn>.<T>    ;    FMAXNMP <V><d>, <Vn>.<T>
-            {
-                tracer.Trace( "%s %c%llu, v%llu.%s\n", bit23 ? "fminnmp" : "fmaxnmp", sz ? 'd' : 's', d, n, sz ? "2d" : "2s" );
-            }
-            else if ( bit23 && bit21 && 0x35 == opcode ) // FABD <V><d>, <V><n>, <V><m>
+            if ( is_ldr )
             {
-                char width = sz ? 'd' : 's';
-                uint64_t m = opbits( 16, 5 );
-                tracer.Trace( "fabd %c%llu, %c%llu, %c%llu\n", width, d, width, n, width, m );
+                if ( 3 == opc )
+                    byte_len = 16;
+
+                if ( preIndex )
+                    tracer.Trace( "ldr %c%llu, [%s, #%lld]! //pr\n", get_byte_len( byte_len ), t, reg_or_sp( n, true ), imm9 );
+                else if ( postIndex )
+                    tracer.Trace( "ldr %c%llu, [%s] #%lld //po\n", get_byte_len( byte_len ), t, reg_or_sp( n, true ), imm9 );
+                else if ( unsignedOffset )
+                    tracer.Trace( "ldr %c%llu, [%s, #%llu] //uo\n", get_byte_len( byte_len ), t, reg_or_sp( n, true ), imm12 * byte_len );
+                else if ( signedUnscaledOffset )
+                    tracer.Trace( "ldur %c%llu, [%s, #%lld] //so\n", get_byte_len( byte_len ), t, reg_or_sp( n, true ), imm9 );
+                else if ( shiftExtend )
+                {
+                    uint64_t option = opbits( 13, 3 );
+                    uint64_t m = opbits( 16, 5 );
+                    uint64_t shift = 0;
+                    uint64_t S = opbit( 12 );
+                    if ( 0 != S )
+                    {
+                        if ( 0 == size )
+                        {
+                           if ( 3 == opc )
+                               shift = 4;
+                           else if ( 1 != opc )
+                               unhandled();
+                        }
+                        else if ( 1 == size && 1 == opc )
+                            shift = 1;
+                        else if ( 2 == size && 1 == opc )
+                            shift = 2;
+                        else if ( 3 == size && 1 == opc )
+                            shift = 3;
+                        else
+                            unhandled();
+                    }
+
+                    tracer.Trace( "ldr %c%llu, [%s, %s, %s, #%lld] //se\n", get_byte_len( byte_len ), t, reg_or_sp( n, true ), reg_or_zr( m, true ),
+                                   extend_type( option ), shift );
+                }
+                else
+                    unhandled();
             }
-            else if ( 0x0c36 == bits23_10 || 0x1c36 == bits23_10 ) // FADDP <V><d>, <Vn>.<T>
+            else // str
             {
-                char width = sz ? 'd' : 's';
-                tracer.Trace( "faddp %c%llu, v%llu.2%c\n", width, d, n, width );
+                if ( 2 == opc )
+                    byte_len = 16;
+
+                if ( preIndex )
+                    tracer.Trace( "str %c%llu, [%s, #%lld]! //pr\n", get_byte_len( byte_len ), t, reg_or_sp( n, true ), imm9 );
+                else if ( postIndex )
+                    tracer.Trace( "str %c%llu, [%s] #%lld //po\n", get_byte_len( byte_len ), t, reg_or_sp( n, true ), imm9 );
+                else if ( unsignedOffset )
+                    tracer.Trace( "str %c%llu, [%s, #%llu] //uo\n", get_byte_len( byte_len ), t, reg_or_sp( n, true ), imm12 * byte_len );
+                else if ( signedUnscaledOffset )
+                    tracer.Trace( "stur %c%llu, [%s, #%lld] //so\n", get_byte_len( byte_len ), t, reg_or_sp( n, true ), imm9 );
+                else if ( shiftExtend )
+                {
+                    uint64_t option = opbits( 13, 3 );
+                    uint64_t m = opbits( 16, 5 );
+                    uint64_t shift = 0;
+                    uint64_t S = opbit( 12 );
+                    if ( 0 != S )
+                    {
+                        if ( 0 == size )
+                        {
+                           if ( 2 == opc )
+                               shift = 4;
+                           else if ( 0 != opc )
+                               unhandled();
+                        }
+                        else if ( 1 == size && 0 == opc )
+                            shift = 1;
+                        else if ( 2 == size && 0 == opc )
+                            shift = 2;
+                        else if ( 3 == size && 0 == opc )
+                            shift = 3;
+                        else
+                            unhandled();
+                    }
+
+                    tracer.Trace( "str %c%llu, [%s, %s, %s, #%lld] //se\n", get_byte_len( byte_len ), t, reg_or_sp( n, true ), reg_or_zr( m, true ),
+                                   extend_type( option ), shift );
+                }
+                else
+                    unhandled();
             }
-            else if ( 0x3822 == bits23_10 ) // CMGE D<d>, D<n>, #0
-                tracer.Trace( "cmge d%llu, d%llu, #0\n", d, n );
-            else if ( 0x3826 == bits23_10 ) // CMLE D<d>, D<n>, #0
-                tracer.Trace( "cmle d%llu, d%llu, #0\n", d, n );
-            else if ( 0x0876 == ( bits23_10 & 0x2fff ) )
+            break;
+        }
+        case 0x2c: // STP <St1>, <St2>, [<Xn|SP>], #<imm>     ;    LDP <St1>, <St2>, [<Xn|SP>], #<imm>
+        case 0x6c: // STP <Dt1>, <Dt2>, [<Xn|SP>], #<imm>     ;    LDP <Dt1>, <Dt2>, [<Xn|SP>], #<imm>
+        case 0xac: // STP <Qt1>, <Qt2>, [<Xn|SP>], #<imm>          LDP <Qt1>, <Qt2>, [<Xn|SP>], #<imm>
+        case 0x2d: // STP <St1>, <St2>, [<Xn|SP>, #<imm>]!    ;    STP <St1>, <St2>, [<Xn|SP>{, #<imm>}]    ;    LDP <St1>, <St2>, [<Xn|SP>, #<imm>]!    ;    LDP <St1>, <St2>, [<Xn|SP>{, #<imm>}]
+        case 0x6d: // STP <Dt1>, <Dt2>, [<Xn|SP>, #<imm>]!    ;    STP <Dt1>, <Dt2>, [<Xn|SP>{, #<imm>}]    ;    LDP <Dt1>, <Dt2>, [<Xn|SP>, #<imm>]!    ;    LDP <Dt1>, <Dt2>, [<Xn|SP>{, #<imm>}]
+        case 0xad: // STP <Qt1>, <Qt2>, [<Xn|SP>, #<imm>]!    ;    STP <Qt1>, <Qt2>, [<Xn|SP>{, #<imm>}]    ;    LDP <Qt1>, <Qt2>, [<Xn|SP>, #<imm>]!    ;    LDP <Qt1>, <Qt2>, [<Xn|SP>{, #<imm>}]
+        {
+            uint64_t opc = opbits( 30, 2 );
+            char vector_width = ( 0 == opc ) ? 's' : ( 1 == opc ) ? 'd' : 'q';
+            uint64_t imm7 = opbits( 15, 7 );
+            uint64_t t2 = opbits( 10, 5 );
+            uint64_t n = opbits( 5, 5 );
+            uint64_t t1 = opbits( 0, 5 );
+            uint64_t L = opbit( 22 );
+            uint64_t bit23 = opbit( 23 );
+
+            bool preIndex = ( ( 0xd == ( hi8 & 0xf ) ) && bit23 );
+            bool postIndex = ( ( 0xc == ( hi8 & 0xf ) ) && bit23 );
+            bool signedOffset = ( ( 0xd == ( hi8 & 0xf ) ) && !bit23 );
+
+            uint64_t scale = 2 + opc;
+            int64_t offset = sign_extend( imm7, 6 ) << scale;
+
+            if ( L )
             {
-                char width = sz ? 'd' : 's';
-                tracer.Trace( "ucvtf %c%llu, %c%llu\n", width, d, width, n );
+                if ( postIndex )
+                   tracer.Trace( "ldp %c%llu, %c%llu, [%s], #%lld //po\n", vector_width, t1, vector_width, t2, reg_or_sp( n, true ), offset );
+                else if ( preIndex )
+                   tracer.Trace( "ldp %c%llu, %c%llu, [%s, #%lld]! //pr\n", vector_width, t1, vector_width, t2, reg_or_sp( n, true ), offset );
+                else if ( signedOffset )
+                   tracer.Trace( "ldp %c%llu, %c%llu, [%s, #%lld] //so\n", vector_width, t1, vector_width, t2, reg_or_sp( n, true ), offset );
+                else
+                    unhandled();
             }
-            else if ( 0x2832 == bits23_10 || 0x3832 == bits23_10 ) // FCMGE <V><d>, <V><n>, #0.0
+            else
             {
-                char type = sz ? 'd' : 'f';
-                tracer.Trace( "fcmge %c%llu, %c%llu, #0.0\n", type, d, type, n );
+                if ( postIndex )
+                   tracer.Trace( "stp %c%llu, %c%llu, [%s], #%lld //po\n", vector_width, t1, vector_width, t2, reg_or_sp( n, true ), offset );
+                else if ( preIndex )
+                   tracer.Trace( "stp %c%llu, %c%llu, [%s, #%lld]! //pr\n", vector_width, t1, vector_width, t2, reg_or_sp( n, true ), offset );
+                else if ( signedOffset )
+                   tracer.Trace( "stp %c%llu, %c%llu, [%s, #%lld] //so\n", vector_width, t1, vector_width, t2, reg_or_sp( n, true ), offset );
+                else
+                    unhandled();
             }
-            else
-                unhandled();
             break;
         }
-        case 0x0e: case 0x4e: // DUP <Vd>.<T>, <Vn>.<Ts>[<index>]    ;    DUP <Vd>.<T>, <R><n>    ;             CMEQ <Vd>.<T>, <Vn>.<T>, #0    ;    ADDP <Vd>.<T>, <V
-                              // AND <Vd>.<T>, <Vn>.<T>, <Vm>.<T>    ;    UMOV <Wd>, <Vn>.<Ts>[<index>]    ;    UMOV <Xd>, <Vn>.D[<index>]     ;    CNT <Vd>.<T>, <Vn>.<T>
-                              // AND <Vd>.<T>, <Vn>.<T>, <Vm>.<T>    ;    UMOV <Wd>, <Vn>.<Ts>[<index>]    ;    UMOV <Xd>, <Vn>.D[<index>]     ;    ADDV <V><d>, <Vn>.<T>
-                              // XTN{2} <Vd>.<Tb>, <Vn>.<Ta>         ;    UZP1 <Vd>.<T>, <Vn>.<T>, <Vm>.<T> ;   UZP2 <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-                              // SMOV <Wd>, <Vn>.<Ts>[<index>]       ;    SMOV <Xd>, <Vn>.<Ts>[<index>]    ;    INS <Vd>.<Ts>[<index>], <R><n> ;    CMGT <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-                              // SCVTF <Vd>.<T>, <Vn>.<T>            ;    FMLA <Vd>.<T>, <Vn>.<T>, <Vm>.<T>;    FADD <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-                              // TRN1 <Vd>.<T>, <Vn>.<T>, <Vm>.<T>   ;    TRN2 <Vd>.<T>, <Vn>.<T>, <Vm>.<T> ;   TBL <Vd>.<Ta>, { <Vn>.16B }, <Vm>.<Ta> ; TBL <Vd>.<Ta>, { <Vn>.16B, <Vn+1>.16B, <Vn+2>.16B, <Vn+3>.16B }, <Vm>.<Ta>
-                              // ZIP1 <Vd>.<T>, <Vn>.<T>, <Vm>.<T>   ;    ZIP2 <Vd>.<T>, <Vn>.<T>, <Vm>.<T> ;   SMULL{2} <Vd>.<Ta>, <Vn>.<Tb>, <Vm>.<Tb>
-                              // MLA <Vd>.<T>, <Vn>.<T>, <Vm>.<T>    ;    MUL <Vd>.<T>, <Vn>.<T>, <Vm>.<T>  ;   CMLT <Vd>.<T>, <Vn>.<T>, #0    ;    REV64 <Vd>.<T>, <Vn>.<T>
-                              // BIC <Vd>.<T>, <Vn>.<T>, <Vm>.<T>    ;    FMLS <Vd>.<T>, <Vn>.<T>, <Vm>.<T> ;   FSUB <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-                              // SMAX <Vd>.<T>, <Vn>.<T>, <Vm>.<T>   ;    SMIN <Vd>.<T>, <Vn>.<T>, <Vm>.<T> ;   SMINV <V><d>, <Vn>.<T>         ;    SMAXV <V><d>, <Vn>.<T>
-                              // FMINNM <Vd>.<T>, <Vn>.<T>, <Vm>.<T> ;    FMAXNM <Vd>.<T>, <Vn>.<T>, <Vm>.<T> ; FCVTN{2} <Vd>.<Tb>, <Vn>.<Ta>  ;    FCVTZS <Vd>.<T>, <Vn>.<T>
-                              // ORN <Vd>.<T>, <Vn>.<T>, <Vm>.<T>    ;    FCVTL{2} <Vd>.<Ta>, <Vn>.<Tb>     ;   SSHL <Vd>.<T>, <Vn>.<T>, <Vm>.<T> ; SADDW{2} <Vd>.<Ta>, <Vn>.<Ta>, <Vm>.<Tb>
-                              // CMGE <Vd>.<T>, <Vn>.<T>, <Vm>.<T>   ;    ABS <Vd>.<T>, <Vn>.<T>            ;   SSUBW{2} <Vd>.<Ta>, <Vn>.<Ta>, <Vm>.<Tb>
-                              // FCMLT <Vd>.<T>, <Vn>.<T>, #0.0      ;    FABS <Vd>.<T>, <Vn>.<T>           ;   SMLAL{2} <Vd>.<Ta>, <Vn>.<Tb>, <Vm>.<Tb>
-                              // SADDL{2} <Vd>.<Ta>, <Vn>.<Tb>, <Vm>.<Tb> ; SADDLP <Vd>.<Ta>, <Vn>.<Tb>     ;   SADDLV <V><d>, <Vn>.<T>        ;    SADALP <Vd>.<Ta>, <Vn>.<Tb>
-                              // SQXTN{2} <Vd>.<Tb>, <Vn>.<Ta>       ;    CMGT <Vd>.<T>, <Vn>.<T>, #0       ;   CMTST <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-                              // FMIN <Vd>.<T>, <Vn>.<T>, <Vm>.<T>   ;    FCMEQ <Vd>.<T>, <Vn>.<T>, <Vm>.<T> ;  REV16 <Vd>.<T>, <Vn>.<T>
+        case 0x0f: case 0x2f: case 0x4f: case 0x6f: case 0x7f:
+            // BIC <Vd>.<T>, #<imm8>{, LSL #<amount>}    ;    MOVI <Vd>.<T>, #<imm8>{, LSL #0}    ;          MVNI <Vd>.<T>, #<imm8>, MSL #<amount>
+            // USHR <Vd>.<T>, <Vn>.<T>, #<shift>         ;    FMUL <Vd>.<T>, <Vn>.<T>, <Vm>.<Ts>[<index>]  ; MVNI <Vd>.<T>, #<imm8>{, LSL #<amount>}
+            // FMOV <Vd>.<T>, #<imm>                     ;    FMOV <Vd>.<T>, #<imm>               ;    FMOV <Vd>.2D, #<imm>
+            // USHLL{2} <Vd>.<Ta>, <Vn>.<Tb>, #<shift>   ;    SHRN{2} <Vd>.<Tb>, <Vn>.<Ta>, #<shift>  ;   SSHLL{2} <Vd>.<Ta>, <Vn>.<Tb>, #<shift>
+            // FMLA <Vd>.<T>, <Vn>.<T>, <Vm>.<Ts>[<index>] ;  SSHR <Vd>.<T>, <Vn>.<T>, #<shift>   ;    SHL <Vd>.<T>, <Vn>.<T>, #<shift>
+            // MUL <Vd>.<T>, <Vn>.<T>, <Vm>.<Ts>[<index>] ;   URSRA <Vd>.<T>, <Vn>.<T>, #<shift>  ;    USRA <Vd>.<T>, <Vn>.<T>, #<shift>
+            // ORR <Vd>.<T>, #<imm8>{, LSL #<amount>}    ;    MOVI <Vd>.<T>, #<imm8>, MSL #<amount>  ; 
         {
+            uint64_t cmode = opbits( 12, 4 );
+            uint64_t abc = opbits( 16, 3 );
+            uint64_t defgh = opbits( 5, 5 );
+            uint64_t val = ( abc << 5 ) | defgh;
             uint64_t Q = opbit( 30 );
-            uint64_t imm5 = opbits( 16, 5 );
-            uint64_t bit15 = opbit( 15 );
-            uint64_t bits14_11 = opbits( 11, 4 );
+            uint64_t bit29 = opbit( 29 );
+            uint64_t o2 = opbits( 11,1 );
             uint64_t bit10 = opbit( 10 );
-            uint64_t bits12_10 = opbits( 10, 3 );
-            uint64_t bit21 = opbit( 21 );
+            uint64_t bit11 = opbit( 11 );
+            uint64_t bit12 = opbit( 12 );
             uint64_t bit23 = opbit( 23 );
-            uint64_t bits23_21 = opbits( 21, 3 );
-            uint64_t n = opbits( 5, 5 );
             uint64_t d = opbits( 0, 5 );
-            uint64_t bits20_16 = opbits( 16, 5 );
-            uint64_t bits14_10 = opbits( 10, 5 );
-            uint64_t bits15_10 = opbits( 10, 6 );
+            uint64_t bits23_19 = opbits( 19, 5 );
+            uint64_t imm = adv_simd_expand_imm( bit29, cmode, val );
+            //tracer.Trace( "bit12: %llu, cmode %llx, bit29 %llu, bit11 %llu, bit10 %llu\n", bit12, cmode, bit29, bit11, bit10 );
 
-            if ( bit21 && 0 == bits20_16 && 6 == bits15_10 ) // REV16 <Vd>.<T>, <Vn>.<T>
+            if ( 0 == bits23_19 )
             {
-                uint64_t size = opbits( 22, 2 );
-                if ( 0 != size )
+                if ( ( 0x4f == hi8 || 0x0f == hi8 ) && ( 0xc == ( cmode & 0xe ) ) && !bit11 && bit10 ) // MOVI <Vd>.<T>, #<imm8>, MSL #<amount>
+                {
+                    const char * pT = Q ? "4s" : "2s";
+                    uint64_t amount = ( cmode & 1 ) ? 16 : 8;
+                    tracer.Trace( "movi v%llu.%s, #%llu, msl #%llu\n", d, pT, imm, amount );
+                }
+                else if ( ( 0x0f == hi8 || 0x4f == hi8 ) && ( 9 == ( 0xd & cmode ) || 1 == ( 9 & cmode ) ) && bit12 && !bit11 && bit10 ) // ORR <Vd>.<T>, #<imm8>{, LSL #<amount>}
+                {
+                    if ( 9 == ( 0xd & cmode ) ) // 16-bit variant
+                    {
+                        const char * pT = Q ? "8h" : "4h";
+                        uint64_t amount = ( cmode & 2 ) ? 8 : 0;
+                        tracer.Trace( "orr v%llu.%s, #%#llx, LSL #%llu\n", d, pT, val, amount );
+                    }
+                    else if ( 1 == ( 9 & cmode ) ) // 32-bit variant
+                    {
+                        const char * pT = Q ? "4s" : "2s";
+                        uint64_t amount = 8 * get_bits( cmode, 1, 2 );
+                        tracer.Trace( "orr v%llu.%s, #%#llx, LSL #%llu\n", d, pT, val, amount );
+                    }
+                    else
+                        unhandled();
+                }
+                else if ( ( 0x2f == hi8 || 0x6f == hi8 ) && !bit11 && bit10 &&
+                     ( ( 8 == ( cmode & 0xd ) ) || ( 0 == ( cmode & 9 ) ) || ( 0xc == ( cmode & 0xe ) ) ) ) // mvni
+                {
+                    if ( 8 == ( cmode & 0xd ) ) // 16-bit shifted immediate
+                    {
+                        uint64_t amount = ( cmode & 2 ) ? 8 : 0;
+                        const char * pT = Q ? "8H" : "4H";
+                        tracer.Trace( "mvni v%llu.%s, #%#llx, lsl #%llu\n", d, pT, val, amount );
+                    }
+                    else if ( 0 == ( cmode & 9 ) ) // 32-bit shifted immediate
+                    {
+                        uint64_t amount = get_bits( cmode, 1, 2 ) * 8;
+                        const char * pT = Q ? "4S" : "2S";
+                        tracer.Trace( "mvni v%llu.%s, #%#llx, lsl #%llu\n", d, pT, val, amount );
+                    }
+                    else if ( 0xc == ( cmode & 0xe ) ) // 32-bit shifting ones
+                    {
+                        imm = adv_simd_expand_imm( 1, cmode, val );
+                        uint64_t amount = get_bit( cmode, 0 ) ? 16 : 8;
+                        const char * pT = Q ? "4S" : "2S";
+                        tracer.Trace( "mvni v%llu.%s, #%#llx, msl #%llu\n", d, pT, val, amount );
+                    }
+                    else
+                        unhandled();
+                }
+                else if ( !bit12 || ( 0xc == ( cmode & 0xe ) ) ) // movi
+                {
+                    if ( !bit29 ) // movi
+                    {
+                        if ( 0xe == cmode )
+                        {
+                            const char * pT = Q ? "16B" : "8B";
+                            tracer.Trace( "movi v%llu.%s, #%#llx // imm %llx\n", d, pT, val, imm );
+                        }
+                        else if ( 8 == ( cmode & 0xd ) )
+                        {
+                            const char * pT = Q ? "8H" : "4H";
+                            uint64_t amount = ( cmode & 2 ) ? 8 : 0;
+                            tracer.Trace( "movi v%llu.%s, #%#llx, lsl #%llu\n", d, pT, imm, amount );
+                        }
+                        else if ( 0 == ( cmode & 9 ) )
+                        {
+                            const char * pT = Q ? "4S" : "2S";
+                            uint64_t amount = ( 8 * ( ( cmode >> 1 ) & 3 ) );
+                            tracer.Trace( "movi v%llu.%s, #%#llx, lsl #%llu\n", d, pT, imm, amount );
+                        }
+                        else if ( 0xa == ( cmode & 0xe ) )
+                        {
+                            const char * pT = Q ? "4S" : "2S";
+                            uint64_t amount = ( cmode & 1 ) ? 16 : 8;
+                            tracer.Trace( "movi v%llu.%s, #%#llx, msl #%llu\n", d, pT, imm, amount );
+                        }
+                        else
+                            unhandled();
+                    }
+                    else // movi
+                    {
+                        uint64_t a = opbit( 18 );
+                        uint64_t b = opbit( 17 );
+                        uint64_t c = opbit( 16 );
+                        uint64_t bitd = opbit( 9 );
+                        uint64_t e = opbit( 8 );
+                        uint64_t f = opbit( 7 );
+                        uint64_t g = opbit( 6 );
+                        uint64_t h = opbit( 5 );
+
+                        imm = a ? ( 0xffull << 56 ) : 0;
+                        imm |= b ? ( 0xffull << 48 ) : 0;
+                        imm |= c ? ( 0xffull << 40 ) : 0;
+                        imm |= bitd ? ( 0xffull << 32 ) : 0;
+                        imm |= e ? ( 0xffull << 24 ) : 0;
+                        imm |= f ? ( 0xffull << 16 ) : 0;
+                        imm |= g ? ( 0xffull << 8 ) : 0;
+                        imm |= h ? 0xffull : 0;
+
+                        //tracer.Trace( "movi bit29 must be 1, Q %llu, cmode %llu\n", Q, cmode );
+
+                        if ( ( 0 == Q ) && ( cmode == 0xe ) )
+                            tracer.Trace( "movi D%llu, #%#llx\n", d, imm );
+                        else if ( ( 1 == Q ) && ( cmode == 0xe ) )
+                            tracer.Trace( "movi V%llu.2D, #%#llx\n", d, imm );
+                        else
+                            unhandled();
+                    }
+                }
+                else if ( ( 0x6f == hi8 || 0x4f == hi8 || 0x2f == hi8 || 0x0f == hi8 ) && 0xf == cmode && !bit11 && bit10 ) // fmov single and double precision immediate
+                {
+                    double dval = 0.0;
+                    tracer.Trace( "imm6: %#llx\n", imm );
+                    if ( bit29 )
+                        mcpy( &dval, &imm, sizeof( dval ) );
+                    else
+                    {
+                        float float_val;
+                        mcpy( &float_val, &imm, sizeof( float_val ) );
+                        dval = (double) float_val;
+                    }
+                    tracer.Trace( "fmov v%llu.%s, #%lf\n", d, bit29 ? "2D" : Q ? "4S" : "2S", dval );
+                }
+                else if ( !bit29 ) // BIC register
+                {
                     unhandled();
-                const char * pT = Q ? "16b" : "8b";
-                tracer.Trace( "rev16 v%llu.%s, v%llu.%s\n", d, pT, n, pT );
-            }
-            else if ( !bit23 && bit21 && 0x39 == bits15_10 ) // FCMEQ <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-            {
-                uint64_t m = opbits( 16, 5 );
-                uint64_t sz = opbit( 22 );
-                const char * pT = sz ? Q ? "2d" : "reserved" : Q ? "4s" : "2s";
-                tracer.Trace( "fcmeq v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
-            }
-            else if ( bit21 && 0x3d == bits15_10 ) // FMIN <Vd>.<T>, <Vn>.<T>, <Vm>.<T>    FMAX <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-            {
-                uint64_t m = opbits( 16, 5 );
-                uint64_t sz = opbit( 22 );
-                const char * pT = sz ? Q ? "2d" : "reserved" : Q ? "4s" : "2s";
-                tracer.Trace( "%s v%llu.%s, v%llu.%s, v%llu.%s\n", bit23 ? "fmin" : "fmax", d, pT, n, pT, m, pT );
-            }
-            else if ( bit21 && 0x23 == bits15_10 ) // CMTST <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-            {
-                uint64_t size = opbits( 22, 2 );
-                uint64_t m = opbits( 16, 5 );
-                const char * pT = get_ld1_vector_T( size, Q );
-                tracer.Trace( "cmtst v%llu.%s, v%llu.%s, #0\n", d, pT, n, pT, m, pT );
-            }
-            else if ( bit21 && 0 == bits20_16 && 0x22 == bits15_10 ) // CMGT <Vd>.<T>, <Vn>.<T>, #0
-            {
-                uint64_t size = opbits( 22, 2 );
-                const char * pT = get_ld1_vector_T( size, Q );
-                tracer.Trace( "cmgt v%llu.%s, v%llu.%s, #0\n", d, pT, n, pT );
-            }
-            else if ( bit21 && 1 == bits20_16 && 0x12 == bits15_10 ) // SQXTN{2} <Vd>.<Tb>, <Vn>.<Ta>
-            {
-                uint64_t size = opbits( 22, 2 );
-                const char * pTA = get_saddlp_vector_T( size, 1 );
-                const char * pTB = get_ld1_vector_T( size, Q );
-                tracer.Trace( "sqxtn%s v%llu.%s, v%llu.%s\n", Q ? "2" : "", d, pTB, n, pTA );
-            }
-            else if ( bit21 && 0 == bits20_16 && 0x1a == bits15_10 ) // SADALP <Vd>.<Ta>, <Vn>.<Tb>
-            {
-                uint64_t size = opbits( 22, 2 );
-                const char * pTA = get_saddlp_vector_T( size, Q );
-                const char * pTB = get_ld1_vector_T( size, Q );
-                tracer.Trace( "sadalp v%llu.%s, v%llu.%s\n", d, pTA, n, pTB );
-            }
-            else if ( bit21 && 0x10 == bits20_16 && 0x0e == bits15_10 ) // SADDLV <V><d>, <Vn>.<T>
-            {
-                uint64_t size = opbits( 22, 2 );
-                const char * pT = get_ld1_vector_T( size, Q );
-                char v = ( 0 == size ) ? 'h' : ( 1 == size ) ? 's' : ( 2 == size ) ? 'd' : '?';
-                tracer.Trace( "saddlv %c%llu, v%llu.%s\n", v, d, n, pT );
-            }
-            else if ( bit21 && 0 == bits20_16 && 0x0a == bits15_10 ) // SADDLP <Vd>.<Ta>, <Vn>.<Tb>
-            {
-                uint64_t size = opbits( 22, 2 );
-                const char * pTA = get_saddlp_vector_T( size, Q );
-                const char * pTB = get_ld1_vector_T( size, Q );
-                tracer.Trace( "saddlp v%llu.%s, v%llu.%s\n", d, pTA, n, pTB );
-            }
-            else if ( bit21 && 0 == bits15_10 ) // SADDL{2} <Vd>.<Ta>, <Vn>.<Tb>, <Vm>.<Tb>
-            {
-                uint64_t size = opbits( 22, 2 );
-                uint64_t m = opbits( 16, 5 );
-                const char * pTA = ( 0 == size ) ? "8h" : ( 1 == size ) ? "4s" : ( 2 == size ) ? "2d" : "unknown";
-                const char * pTB = get_ld1_vector_T( size, Q );
-                tracer.Trace( "saddl%s v%llu.%s, v%llu.%s, v%llu.%s\n", Q ? "2" : "", d, pTA, n, pTB, m, pTB );
-            }
-            else if ( bit21 && 0x20 == bits15_10 ) // SMLAL{2} <Vd>.<Ta>, <Vn>.<Tb>, <Vm>.<Tb>
-            {
-                uint64_t size = opbits( 22, 2 );
-                uint64_t m = opbits( 16, 5 );
-                const char * pTA = ( 0 == size ) ? "8h" : ( 1 == size ) ? "4s" : ( 2 == size ) ? "2d" : "unknown";
-                const char * pTB = get_ld1_vector_T( size, Q );
-                tracer.Trace( "smlal%s v%llu.%s, v%llu.%s, v%llu.%s\n", Q ? "2" : "", d, pTA, n, pTB, m, pTB );
-            }
-            else if ( bit23 && bit21 && 0 == bits20_16 && 0x3e == bits15_10 ) // FABS <Vd>.<T>, <Vn>.<T>
-            {
-                uint64_t sz = opbit( 22 );
-                const char * pT = sz ? Q ? "2d" : "reserved" : Q ? "4s" : "2s";
-                tracer.Trace( "fabs v%llu.%s, v%llu.%s, #0.0\n", d, pT, n, pT );
-            }
-            else if ( bit23 && bit21 && 0 == bits20_16 && 0x3a == bits15_10 ) // FCMLT <Vd>.<T>, <Vn>.<T>, #0.0
-            {
-                uint64_t sz = opbit( 22 );
-                const char * pT = sz ? Q ? "2d" : "reserved" : Q ? "4s" : "2s";
-                tracer.Trace( "fcmlt v%llu.%s, v%llu.%s, #0.0\n", d, pT, n, pT );
-            }
-            else if ( bit21 && 0xc == bits15_10 ) // SSUBW{2} <Vd>.<Ta>, <Vn>.<Ta>, <Vm>.<Tb>
-            {
-                uint64_t m = opbits( 16, 5 );
-                uint64_t size = opbits( 22, 2 );
-                const char * pTA = ( 0 == size ) ? "8h" : ( 1 == size ) ? "4s" : ( 2 == size ) ? "2d" : "unknown";
-                const char * pTB = get_ld1_vector_T( size, Q );
-                tracer.Trace( "ssubw%s v%llu.%s, v%llu.%s, v%llu.%s\n", Q ? "2" : "", d, pTA, n, pTA, m, pTB );
-            }
-            else if ( bit21 && 0 == bits20_16 && 0x2e == bits15_10 ) // ABS <Vd>.<T>, <Vn>.<T>
-            {
-                uint64_t size = opbits( 22, 2 );
-                const char * pT = get_ld1_vector_T( size, Q );
-                tracer.Trace( "abs v%llu.%s, v%llu.%s\n", d, pT, n, pT );
+                }
+                else if ( bit29 && bit12 ) // BIC immediate
+                {
+                    if ( 0 != o2 || 1 != bit10 )
+                        unhandled();
+
+                    bool sixteen_bit_mode = ( cmode == 0x9 || cmode == 0xb );
+                    const char * pT = "";
+                    uint64_t amount = 0;
+                    if ( sixteen_bit_mode )
+                    {
+                        pT = Q ? "8H" : "4H";
+                        amount = ( cmode & 2 ) ? 8 : 0;
+                    }
+                    else
+                    {
+                        pT = Q ? "4S" : "2S";
+                        amount = 8 * ( ( cmode >> 1 ) & 3 );
+                    }
+
+                    tracer.Trace( "bic v%llu.%s, #%#llx, lsl #%llu\n", d, pT, val, amount );
+                    //tracer.Trace( "bic bonus: cmode %#llx, val: %#llx, abc %#llx, defgh %#llx, sixteen_bit_mode %d, imm %#llx\n", cmode, val, abc, defgh, sixteen_bit_mode, imm );
+                }
             }
-            else if ( bit21 && 4 == bits15_10 ) // SADDW{2} <Vd>.<Ta>, <Vn>.<Ta>, <Vm>.<Tb>
+            else // USHR, USHLL, SHRN, SHRN2, etc
             {
-                uint64_t m = opbits( 16, 5 );
-                uint64_t size = opbits( 22, 2 );
-                const char * pTA = ( 0 == size ) ? "8h" : ( 1 == size ) ? "4s" : ( 2 == size ) ? "2d" : "unknown";
-                const char * pTB = get_ld1_vector_T( size, Q );
-                tracer.Trace( "saddw%s v%llu.%s, v%llu.%s, v%llu.%s\n", Q ? "2" : "", d, pTA, n, pTA, m, pTB );
-            }
-            else if ( bit21 && 0x11 == bits15_10 ) // SSHL <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-            {
-                uint64_t m = opbits( 16, 5 );
-                uint64_t size = opbits( 22, 2 );
-                const char * pT = get_ld1_vector_T( size, Q );
-                tracer.Trace( "sshl v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
-            }
-            else if ( !bit23 && bit21 && 1 == bits20_16 && 0x1e == bits15_10 ) // FCVTL{2} <Vd>.<Ta>, <Vn>.<Tb>
-            {
-                uint64_t sz = opbit( 22 );
-                const char * pTA = sz ? "2d" : "4s";
-                const char * pTB = sz ? Q ? "4s" : "2s" : Q ? "8h" : "4h";
-                tracer.Trace( "fcvtl%s v%llu.%s, v%llu.%s\n", Q ? "2" : "", d, pTA, n, pTB );
-            }
-            else if ( 7 == bits23_21 && 7 == bits15_10 ) // ORN <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-            {
-                const char * pT = Q ? "16b" : "8b";
-                uint64_t m = opbits( 16, 5 );
-                tracer.Trace( "orn v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
-            }
-            else if ( bit23 && bit21 && 1 == bits20_16 && 0x2e == bits15_10 ) // FCVTZS <Vd>.<T>, <Vn>.<T>
-            {
-                uint64_t sz = opbit( 22 );
-                const char * pT = sz ? Q ? "2d" : "reserved" : Q ? "4s" : "2s";
-                tracer.Trace( "fcvtzs v%llu.%s, v%llu.%s\n", d, pT, n, pT );
-            }
-            else if ( !bit23 && bit21 && 1 == bits20_16 && 0x1a == bits15_10 ) // FCVTN{2} <Vd>.<Tb>, <Vn>.<Ta>
-            {
-                uint64_t sz = opbit( 22 );
-                const char * pTA = sz ? "2d" : "4s";
-                const char * pTB = sz ? Q ? "8h" : "4h" : Q ? "4s" : "2s";
-                tracer.Trace( "fcvtn%s v%llu.%s, v%llu.%s  # rmode %s\n", Q ? "2" : "", d, pTB, n, pTA, get_rmode_text( get_bits( fpcr, 22, 2 ) ) );
-            }
-            else if ( bit21 && 0x31 == bits15_10 ) // FMINNM <Vd>.<T>, <Vn>.<T>, <Vm>.<T> ;    FMAXNM <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-            {
-                uint64_t m = opbits( 16, 5 );
-                uint64_t sz = opbit( 22 );
-                const char * pT = ( !sz && !Q ) ? "2s" : ( !sz && Q ) ? "4s" : ( sz && Q ) ? "2d" : "?";
-                tracer.Trace( "%s v%llu,%s, v%llu.%s, v%llu.%s\n", bit23 ? "fminnm" : "fmaxnm", d, pT, n, pT, m, pT );
-            }
-            else if ( bit21 && ( 0x11 == bits20_16 || 0x10 == bits20_16 ) && 0x2a == bits15_10 ) // SMINV <V><d>, <Vn>.<T>         ;    SMAXV <V><d>, <Vn>.<T>
-            {
-                uint64_t size = opbits( 22, 2 );
-                char v = ( 0 == size ) ? 'b' : ( 1 == size ) ? 'h' : ( 2 == size ) ? 's' : '?';
-                const char * pT = get_ld1_vector_T( size, Q );
-                tracer.Trace( "%s %c%llu, v%llu.%s\n", ( 0x11 == bits20_16 ) ? "sminv" : "smaxv", v, d, n, pT );
-            }
-            else if ( bit21 && ( 0x19 == bits15_10 || 0x1b == bits15_10 ) ) // SMAX <Vd>.<T>, <Vn>.<T>, <Vm>.<T>    ;    SMIN <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-            {
-                uint64_t m = opbits( 16, 5 );
-                uint64_t size = opbits( 22, 2 );
-                const char * pT = get_ld1_vector_T( size, Q );
-                tracer.Trace( "%s v%llu.%s, v%llu.%s, v%llu.%s\n", ( 0x19 == bits15_10 ) ? "smax" : "smin", d, pT, n, pT, m, pT );
-            }
-            else if ( bit23 && bit21 && 0x35 == bits15_10 ) // FSUB <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-            {
-                uint64_t m = opbits( 16, 5 );
-                uint64_t sz = opbit( 22 );
-                const char * pT = ( !sz && !Q ) ? "2s" : ( !sz && Q ) ? "4s" : ( sz && Q ) ? "2d" : "?";
-                tracer.Trace( "fsub v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
-            }
-            else if ( bit23 && bit21 && 0x33 == bits15_10 ) // FMLS <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-            {
-                uint64_t m = opbits( 16, 5 );
-                uint64_t sz = opbit( 22 );
-                const char * pT = ( !sz && !Q ) ? "2s" : ( !sz && Q ) ? "4s" : ( sz && Q ) ? "2d" : "?";
-                tracer.Trace( "fmls v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
-            }
-            else if ( 3 == bits23_21 && 7 == bits15_10 ) // BIC <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-            {
-                const char * pT = Q ? "16b" : "8b";
-                uint64_t m = opbits( 16, 5 );
-                tracer.Trace( "bic v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
-            }
-            else if ( bit21 && 0 == bits20_16 && !bit15 && 2 == bits14_10 ) // REV64 <Vd>.<T>, <Vn>.<T>
-            {
-                uint64_t size = opbits( 22, 2 );
-                const char * pT = get_ld1_vector_T( size, Q );
-                tracer.Trace( "rev64 v%llu.%s, v%llu.%s\n", d, pT, n, pT );
-            }
-            else if ( bit21 && 0 == bits20_16 && bit15 && 0xa == bits14_10 ) // CMLT <Vd>.<T>, <Vn>.<T>, #0
-            {
-                uint64_t size = opbits( 22, 2 );
-                const char * pT = get_ld1_vector_T( size, Q );
-                tracer.Trace( "cmlt v%llu.%s, v%llu.%s, #0\n", d, pT, n, pT );
-            }
-            else if ( bit21 && bit15 && ( 7 == bits14_10 || 5 == bits14_10 ) ) // MUL <Vd>.<T>, <Vn>.<T>, <Vm>.<T>    ;    MLA <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-            {
-                uint64_t m = opbits( 16, 5 );
-                uint64_t size = opbits( 22, 2 );
-                const char * pT = get_ld1_vector_T( size, Q );
-                tracer.Trace( "%s v%llu.%s, v%llu.%s, v%llu.%s\n", ( 7 == bits14_10 ) ? "mul" : "mla", d, pT, n, pT, m, pT );
-            }
-            else if ( bit21 && bit15 && 8 == bits14_11 && !bit10 ) // SMULL{2} <Vd>.<Ta>, <Vn>.<Tb>, <Vm>.<Tb>
-            {
-                uint64_t m = opbits( 16, 5 );
-                uint64_t size = opbits( 22, 2 );
-                uint64_t part = Q;
-                const char * pTA = ( 0 == size ) ? "8h" : ( 1 == size ) ? "4s" : ( 2 == size ) ? "2d" : "unknown";
-                const char * pTB = get_ld1_vector_T( size, Q );
-                tracer.Trace( "smull%s v%llu.%s, v%llu.%s, v%llu.%s\n", part ? "2" : "", d, pTA, n, pTB, m, pTB );
-            }
-            else if ( !bit21 && !bit15 && ( 0x1e == bits14_10 || 0xe == bits14_10 ) ) // ZIP1/2 <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-            {
-                uint64_t m = opbits( 16, 5 );
-                uint64_t size = opbits( 22, 2 );
-                const char * pT = get_ld1_vector_T( size, Q );
-                tracer.Trace( "zip%c v%llu.%s, v%llu.%s, v%llu.%s\n", ( 0x1e == bits14_10 ) ? '2' : '1', d, pT, n, pT, m, pT );
-            }
-            else if ( 0 == bits23_21 && !bit15 && 0 == bits12_10 ) // TBL <Vd>.<Ta>, { <Vn>.16B, <Vn+1>.16B, <Vn+2>.16B, <Vn+3>.16B }, <Vm>.<Ta>
-            {
-                uint64_t m = opbits( 16, 5 );
-                const char * pT = Q ? "16b" : "8b";
-                uint64_t len = opbits( 13, 2 );
-                if ( 0 == len )
-                    tracer.Trace( "tbl v%llu.%s, {v%llu.16b}, v%llu.%s\n", d, pT, n, m, pT );
-                else if ( 1 == len )
-                    tracer.Trace( "tbl v%llu.%s, {v%llu.16b, v%llu.16b}, v%llu.%s\n", d, pT, n, n + 1, m, pT );
-                else if ( 2 == len )
-                    tracer.Trace( "tbl v%llu.%s, {v%llu.16b, v%llu.16b, v%llu.16b }, v%llu.%s\n", d, pT, n, n + 1, n + 2, m, pT );
-                else if ( 3 == len )
-                    tracer.Trace( "tbl v%llu.%s, {v%llu.16b, v%llu.16b, v%llu.16b, v%llu.16b }, v%llu.%s\n", d, pT, n, n + 1, n + 2, n + 3, m, pT );
-            }
-            else if ( !bit21 && !bit15 && 0xd == bits14_11 && !bit10 ) // TRN2 <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-            {
-                uint64_t m = opbits( 16, 5 );
-                uint64_t size = opbits( 22, 2 );
-                const char * pT = get_ld1_vector_T( size, Q );
-                tracer.Trace( "trn2 v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
-            }
-            else if ( !bit21 && !bit15 && 5 == bits14_11 && !bit10 ) // TRN1 <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-            {
-                uint64_t m = opbits( 16, 5 );
-                uint64_t size = opbits( 22, 2 );
-                const char * pT = get_ld1_vector_T( size, Q );
-                tracer.Trace( "trn1 v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
-            }
-            else if ( !bit23 && bit21 && bit15 && 0xa == bits14_11 && bit10 ) // FADD <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-            {
-                uint64_t sz = opbit( 22 );
-                uint64_t ty = ( sz << 1 ) | Q;
-                const char * pT = ( 0 == ty ) ? "2s" : ( 1 == ty ) ? "4s" : ( 3 == ty ) ? "2d" : "?";
-                uint64_t m = opbits( 16, 5 );
-                tracer.Trace( "fadd v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
-            }
-            else if ( !bit23 && bit21 && bit15 && 9 == bits14_11 && bit10 ) // FMLA <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-            {
-                uint64_t sz = opbit( 22 );
-                uint64_t ty = ( sz << 1 ) | Q;
-                const char * pT = ( 0 == ty ) ? "2s" : ( 1 == ty ) ? "4s" : ( 3 == ty ) ? "2d" : "?";
-                uint64_t m = opbits( 16, 5 );
-                tracer.Trace( "fmla v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
-            }
-            else if ( !bit23 && bit21 && 1 == bits20_16 && bit15 && 0x16 == bits14_10 ) // SCVTF <Vd>.<T>, <Vn>.<T>
-            {
-                uint64_t sz = opbit( 22 );
-                uint64_t ty = ( sz << 1 ) | Q;
-                const char * pT = ( 0 == ty ) ? "2s" : ( 1 == ty ) ? "4s" : ( 3 == ty ) ? "2d" : "?";
-                tracer.Trace( "scvtf v%llu.%s, v%llu.%s\n", d, pT, n, pT );
-            }
-            else if ( 0x4e == hi8 && 0 == bits23_21 && !bit15 && 3 == bits14_11 && bit10 ) // INS <Vd>.<Ts>[<index>], <R><n>
-            {
-                char T = '?';
-                uint64_t index = 0;
-                if ( imm5 & 1 )
+                uint64_t opcode = opbits( 12, 4 );
+                uint64_t bits23_22 = opbits( 22, 2 );
+                uint64_t bits15_12 = opbits( 12, 4 );
+                uint64_t immh = opbits( 19, 4 );
+
+                if ( ( 0x2f == hi8 || 0x6f == hi8 ) && !bit23 && 0 != immh && 1 == bits15_12 && !bit11 && bit10 ) // USRA <Vd>.<T>, <Vn>.<T>, #<shift>
                 {
-                    T = 'B';
-                    index = get_bits( imm5, 1, 4 );
+                    uint64_t immb = opbits( 16, 3 );
+                    uint64_t n = opbits( 5, 5 );
+                    uint64_t esize = 8ull << highest_set_bit_nz( immh );
+                    uint64_t shift = ( esize * 2 ) - ( ( immh << 3 ) | immb );
+                    const char * pT = get_sshr_vector_T( immh, Q );
+                    tracer.Trace( "usra v%llu.%s, v%llu.%s, #%llu\n", d, pT, n, pT, shift );
                 }
-                else if ( imm5 & 2 )
+                else if ( ( 0x0f == hi8 || 0x4f == hi8 ) && !bit23 && 0 != immh && 1 == bits15_12 && !bit11 && bit10 ) // SSRA <Vd>.<T>, <Vn>.<T>, #<shift>
                 {
-                    T = 'H';
-                    index = get_bits( imm5, 2, 3 );
+                    uint64_t immb = opbits( 16, 3 );
+                    uint64_t n = opbits( 5, 5 );
+                    uint64_t esize = 8ull << highest_set_bit_nz( immh );
+                    uint64_t shift = ( esize * 2 ) - ( ( immh << 3 ) | immb );
+                    const char * pT = get_sshr_vector_T( immh, Q );
+                    tracer.Trace( "ssra v%llu.%s, v%llu.%s, #%llu\n", d, pT, n, pT, shift );
                 }
-                else if ( imm5 & 4 )
+                else if ( ( ( 1 == bits23_22 || 2 == bits23_22 ) && !bit10 ) &&
+                     ( ( ( 0x4f == hi8 || 0x0f == hi8 ) && 8 == bits15_12 ) ||    // MUL <Vd>.<T>, <Vn>.<T>, <Vm>.<Ts>[<index>]
+                       ( ( 0x2f == hi8 || 0x6f == hi8 ) && 0 == bits15_12 ) ) )   // MLA <Vd>.<T>, <Vn>.<T>, <Vm>.<Ts>[<index>]
                 {
-                    T = 'S';
-                    index = get_bits( imm5, 3, 2 );
+                    uint64_t size = bits23_22;
+                    uint64_t n = opbits( 5, 5 );
+                    uint64_t L = opbit( 21 );
+                    uint64_t M = opbit( 20 );
+                    uint64_t H = opbit( 11 );
+                    uint64_t index = 0;
+                    uint64_t rmhi = 0;
+                    char TS = '?';
+                    const char * pT = "invalid";
+                    if ( 1 == size )
+                    {
+                        index = ( H << 2 ) | ( L << 1 ) | M;
+                        rmhi = 0;
+                        TS = 'h';
+                        pT = Q ? "8h" : "4h";
+                    }
+                    else if ( 2 == size )
+                    {
+                        index = ( H << 1 ) | L;
+                        rmhi = M;
+                        TS = 's';
+                        pT = Q ? "4s" : "2s";
+                    }
+                    else
+                        unhandled();
+
+                    uint64_t m = ( rmhi << 4 ) | opbits( 16, 4 );
+                    tracer.Trace( "%s v%llu.%s, v%llu.%s, v%llu.%c[%llu]\n", ( 0x2f == hi8 || 0x6f == hi8 ) ? "mla" : "mul", d, pT, n, pT, m, TS, index );
                 }
-                else if ( imm5 & 8 )
+                else if ( ( 0x4f == hi8 || 0x0f == hi8 ) && !bit23 && 5 == opcode && !bit11 && bit10 ) // SHL <Vd>.<T>, <Vn>.<T>, #<shift>
                 {
-                    T = 'D';
-                    index = get_bit( imm5, 4 );
+                    uint64_t n = opbits( 5, 5 );
+                    uint64_t immb = opbits( 16, 3 );
+                    uint64_t esize = 8ull << highest_set_bit_nz( immh );
+                    uint64_t shift = ( ( immh << 3 ) | immb ) - esize;
+                    const char * pT = get_sshr_vector_T( immh, Q );
+                    tracer.Trace( "shl v%llu.%s, v%llu.%s, #%llu\n", d, pT, n, pT, shift );
+                }
+                else if ( ( 0x0f == hi8 || 0x4f == hi8 ) && !bit23 && 0 == opcode && !bit11 && bit10 ) // SSHR <Vd>.<T>, <Vn>.<T>, #<shift>
+                {
+                    uint64_t n = opbits( 5, 5 );
+                    uint64_t immb = opbits( 16, 3 );
+                    uint64_t esize = 8ull << highest_set_bit_nz( immh );
+                    uint64_t shift = ( esize * 2 ) - ( ( immh << 3 ) | immb );
+                    const char * pT = get_sshr_vector_T( immh, Q );
+                    tracer.Trace( "sshr v%llu.%s, v%llu.%s, #%llu\n", d, pT, n, pT, shift );
+                }
+                else if ( ( 0x4f == hi8 || 0x0f == hi8 ) && bit23 && 1 == opcode && !bit10 ) // FMLA <Vd>.<T>, <Vn>.<T>, <Vm>.<Ts>[<index>]
+                {
+                    uint64_t n = opbits( 5, 5 );
+                    uint64_t m = opbits( 16, 5 );
+                    uint64_t sz = opbit( 22 );
+                    uint64_t L = opbit( 21 );
+                    uint64_t H = opbit( 11 );
+                    uint64_t szL = ( sz << 1 ) | L;
+                    uint64_t index = ( 0 == sz ) ? ( ( H << 1 ) | L ) : ( 2 == szL ) ? H : 0;
+                    uint64_t Qsz = ( Q << 1 ) | sz;
+                    const char * pT = ( 0 == Qsz ) ? "2s" : ( 2 == Qsz ) ? "4s" : ( 3 == Qsz ) ? "2d" : "?";
+                    tracer.Trace( "fmla v%llu.%s, v%llu.%s, v%llu.%c[%llu]\n", d, pT, n, pT, m, sz ? 'd' : 's', index );
+                }
+                else if ( ( 0x0f == hi8 || 0x4f == hi8 ) && !bit23 && 0 != bits23_19 && 0xa == opcode && !bit11 && bit10 ) // SSHLL{2} <Vd>.<Ta>, <Vn>.<Tb>, #<shift>
+                {
+                    uint64_t n = opbits( 5, 5 );
+                    uint64_t immb = opbits( 16, 3 );
+                    uint64_t esize = 8ull << highest_set_bit_nz( immh & 0x7 );
+                    uint64_t shift = ( ( immh << 3 ) | immb ) - esize;
+                    const char * pTA = ( 1 == immh ) ? "8H" : ( 2 == ( 0xe & immh ) ) ? "4S" : "2D";
+                    uint64_t sizeb = immh >> 1;
+                    if ( 4 & sizeb )
+                        sizeb = 4;
+                    else if ( 2 & sizeb )
+                        sizeb = 2;
+                    const char * pTB = get_ld1_vector_T( sizeb, Q );
+                    tracer.Trace( "sshll%s v%llu.%s, v%llu.%s, #%llu\n", Q ? "2" : "", d, pTA, n, pTB, shift );
+                }
+                else if ( ( 0x0f == hi8 || 0x4f == hi8 ) && !bit23 && 0 != bits23_19 && 8 == opcode && !bit11 && bit10 ) // SHRN{2} <Vd>.<Tb>, <Vn>.<Ta>, #<shift>
+                {
+                    uint64_t n = opbits( 5, 5 );
+                    uint64_t immb = opbits( 16, 3 );
+                    uint64_t esize = 8ull << highest_set_bit_nz( immh & 0x7 );
+                    uint64_t shift = ( 2 * esize ) - ( ( immh << 3 ) | immb );
+                    const char * pTA = ( 1 == immh ) ? "8H" : ( 2 == ( 0xe & immh ) ) ? "4S" : "2D";
+                    uint64_t sizeb = immh >> 1;
+                    if ( 4 & sizeb )
+                        sizeb = 4;
+                    else if ( 2 & sizeb )
+                        sizeb = 2;
+                    const char * pTB = get_ld1_vector_T( sizeb, Q );
+                    tracer.Trace( "shrn%s v%llu.%s, v%llu.%s, #%llu\n", Q ? "2" : "", d, pTB, n, pTA, shift );
+                }
+                else if ( ( 0x2f == hi8 || 0x6f == hi8 ) && !bit23 && 0 != bits23_19 && ( 0xa == opcode ) && !bit11 && bit10 ) // USHLL{2} <Vd>.<Ta>, <Vn>.<Tb>, #<shift>
+                {
+                    uint64_t n = opbits( 5, 5 );
+                    uint64_t immb = opbits( 16, 3 );
+                    uint64_t esize = 8ull << highest_set_bit_nz( immh & 0x7 );
+                    if ( 0x7f == hi8 )
+                        esize = 8ull << 3;
+                    uint64_t shift = ( ( immh << 3 ) | immb ) - esize;
+                    const char * pTA = ( 1 == immh ) ? "8H" : ( 2 == ( 0xe & immh ) ) ? "4S" : "2D";
+                    uint64_t sizeb = immh >> 1;
+                    if ( 2 & sizeb )
+                        sizeb = 2;
+                    const char * pTB = get_ld1_vector_T( sizeb, Q );
+                    tracer.Trace( "ushll%s v%llu.%s, v%llu.%s, #%llu\n", Q ? "2" : "", d, pTA, n, pTB, shift );
+                }
+                else if ( ( 0x2f == hi8 || 0x7f == hi8 || 0x6f == hi8 ) && !bit23 && 0 == opcode && !bit11 && bit10 ) // USHR
+                {
+                    uint64_t n = opbits( 5, 5 );
+                    uint64_t immb = opbits( 16, 3 );
+                    uint64_t esize = 8ull << highest_set_bit_nz( immh );
+                    if ( 0x7f == hi8 )
+                        esize = 8ull << 3;
+                    uint64_t shift = ( esize * 2 ) - ( ( immh << 3 ) | immb );
+                    tracer.Trace( "immh %llx, Q %llx\n", immh, Q );
+                    uint64_t p_type = 0;
+                    if ( 8 & immh )
+                        p_type = 3;
+                    else if ( 4 & immh )
+                        p_type = 2;
+                    else if ( 2 & immh )
+                        p_type = 1;
+                    else if ( 1 & immh )
+                        p_type = 0;
+                    const char * pT = get_ld1_vector_T( p_type, Q );
+                    if ( 0x7f == hi8 ) // USHR D<d>, D<n>, #<shift>
+                        tracer.Trace( "ushr, d%llu, d%llu, #%llu\n", d, n, shift );
+                    else // USHR <Vd>.<T>, <Vn>.<T>, #<shift>
+                        tracer.Trace( "ushr, v%llu.%s, v%llu.%s, #%llu\n", d, pT, n, pT, shift );
+                }
+                else if ( bit23 && !bit10 && 9 == opcode ) // FMUL <Vd>.<T>, <Vn>.<T>, <Vm>.<Ts>[<index>]. Vector, single-precision and double-precision
+                {
+                    uint64_t n = opbits( 5, 5 );
+                    uint64_t m = opbits( 16, 5 );
+                    uint64_t sz = opbit( 22 );
+                    uint64_t L = opbit( 21 );
+                    uint64_t H = opbit( 11 );
+                    uint64_t index = ( !sz ) ? ( ( H << 1 ) | L ) : H;
+                    const char * pT = ( Q && sz ) ? "2D" : ( !Q && !sz ) ? "2S" : ( Q && !sz ) ? "4S" : "?";
+                    tracer.Trace( "fmul v%llu.%s, v%llu.%s, v%llu.%c[%llu]\n", d, pT, n, pT, m, sz ? 'D' : 'S', index );
                 }
                 else
                     unhandled();
-                tracer.Trace( "ins v%llu.%c[%llu], %s\n", d, T, index, reg_or_zr( n, ( 8 == ( imm5 & 0xf ) ) ) );
-            }
-            else if ( !bit21 && !bit15 && ( 7 == bits14_11 || 5 == bits14_11 ) && bit10 )
-            {
-                // UMOV <Wd>, <Vn>.<Ts>[<index>]    ;    UMOV <Xd>, <Vn>.D[<index>]    ;     SMOV <Wd>, <Vn>.<Ts>[<index>]    ;    SMOV <Xd>, <Vn>.<Ts>[<index>]
-                uint64_t size = lowest_set_bit_nz( imm5 & ( ( 7 == bits14_11 ) ? 0xf : 7 ) );
-                uint64_t bits_to_copy = 4 - size;
-                uint64_t index = get_bits( imm5, 4 + 1 - bits_to_copy, bits_to_copy );
-
-                const char * pT = "UNKNOWN";
-                if ( imm5 & 1 )
-                    pT = "B";
-                else if ( imm5 & 2 )
-                    pT = "H";
-                else if ( imm5 & 4 )
-                    pT = "S";
-                else if ( imm5 & 8 )
-                    pT = "D";
-                else
-                    unhandled();
-                tracer.Trace( "%cmov %s, v%llu.%s[%llu]\n", ( 7 == bits14_11 ) ? 'u' : 's', reg_or_zr( d, Q ), n, pT, index );
-            }
-            else if ( !bit21 && !bit15 && ( 0x3 == bits14_11 || 0xb == bits14_11 ) && !bit10 ) //
-            {
-                uint64_t size = opbits( 22, 2 );
-                uint64_t part = opbit( 14 );
-                uint64_t m = imm5;
-                const char * pT = get_ld1_vector_T( size, Q );
-                tracer.Trace( "uzp%c v%llu.%s, v%llu.%s, v%llu.%s\n", ( 1 == part ) ? '2' : '1', d, pT, n, pT, m, pT );
-            }
-            else if ( 1 == bits23_21 && !bit15 && 3 == bits14_11 && bit10 ) // AND <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-            {
-                uint64_t m = imm5;
-                const char * pT = ( 0 == Q ) ? "8B" : "16B";
-                tracer.Trace( "and v%llu.%s, v%llu.%s v%llu.%s\n", d, pT, n, pT, m, pT );
-            }
-            else if ( 5 == bits23_21 && !bit15 && 3 == bits14_11 && bit10 ) // ORR <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-            {
-                uint64_t m = imm5;
-                const char * pT = ( 0 == Q ) ? "8B" : "16B";
-                tracer.Trace( "orr v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
-            }
-            else if ( bit21 && bit15 && 3 == bits14_11 && !bit10 && 0 == bits20_16 )  // CMEQ <Vd>.<T>, <Vn>.<T>, #0
-            {
-                uint64_t size = opbits( 22, 2 );
-                tracer.Trace( "cmeq v%llu.%s, v%llu.%s, #0\n", d, get_ld1_vector_T( size, Q ), n, get_ld1_vector_T( size, Q ) );
-            }
-            else if ( bit21 && !bit15 && 7 == bits14_11 && bit10 ) // CMGE <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-            {
-                uint64_t m = opbits( 16, 5 );
-                uint64_t size = opbits( 22, 2 );
-                const char * pT = get_ld1_vector_T( size, Q );
-                tracer.Trace( "cmge v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
-            }
-            else if ( bit21 && !bit15 && 6 == bits14_11 && bit10 ) // CMGT <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-            {
-                uint64_t m = opbits( 16, 5 );
-                uint64_t size = opbits( 22, 2 );
-                const char * pT = get_ld1_vector_T( size, Q );
-                tracer.Trace( "cmgt v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
-            }
-            else if ( bit21 && bit15 && 7 == bits14_11 && bit10 ) // ADDP <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-            {
-                uint64_t m = opbits( 16, 5 );
-                uint64_t size = opbits( 22, 2 );
-                const char * pT = get_ld1_vector_T( size, Q );
-                tracer.Trace( "addp v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
-            }
-            else if ( 0 == bits23_21 && !bit15 && 1 == bits14_11 && bit10 ) // DUP <Vd>.<T>, <R><n>
-                tracer.Trace( "dup v%llu.%s, %s\n", d, get_vector_T( imm5, Q ), reg_or_zr( n, 0x1000 == ( imm5 & 0xffff ) ) );
-            else if ( 0 == bits23_21 && !bit15 && 0 == bits14_11 && bit10 ) // DUP <Vd>.<T>, <Vn>.<Ts>[<index>]
-            {
-                uint64_t size = lowest_set_bit_nz( imm5 & 0xf );
-                uint64_t index = get_bits( imm5, size + 1, 4 - ( size + 1 ) + 1 );
-                uint64_t indsize = 64ull << get_bit( imm5, 4 );
-                uint64_t esize = 8ull << size;
-                uint64_t datasize = 64ull << Q;
-                uint64_t elements = datasize / esize;
-                tracer.Trace( "size %llu, index %llu, indsize %llu, esize %llu, datasize %llu, elements %llu\n", size, index, indsize, esize, datasize, elements );
-                char byte_len = ( imm5 & 1 ) ? 'B' : ( 2 == ( imm5 & 3 ) ) ? 'H' : ( 4 == ( imm5 & 7 ) ) ? 'S' : ( 8 == ( imm5 & 0xf ) ) ? 'D' : '?';
-                tracer.Trace( "dup v%llu.%s, v%llu.%c[%llu]\n", d, get_vector_T( imm5, Q ), n, byte_len, index );
-            }
-            else if ( bit21 && bit15 && 0 == bits14_11 && bit10 ) // ADD <Vd>.<T>, <Vn>.<T>, <Vm>.<T>.   add vector
-            {
-                uint64_t size = opbits( 22, 2 );
-                uint64_t m = opbits( 16, 5 );
-                const char * pT = get_ld1_vector_T( size, Q );
-                tracer.Trace( "add v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
             }
-            else if ( bit21 && 0xb == bits14_11 && 0 == bits20_16 && !bit15 ) // CNT
+            break;
+        }
+        case 0x5a: // REV <Wd>, <Wn>  ;  CSINV <Wd>, <Wn>, <Wm>, <cond>  ;  RBIT <Wd>, <Wn>  ;  CLZ <Wd>, <Wn>  ;  CSNEG <Wd>, <Wn>, <Wm>, <cond>  ;  SBC <Wd>, <Wn>, <Wm> ; REV16 <Wd>, <Wn>
+        case 0xda: // REV <Xd>, <Xn>  ;  CSINV <Xd>, <Xn>, <Xm>, <cond>  ;  RBIT <Xd>, <Xn>  ;  CLZ <Xd>, <Xn>  ;  CSNEG <Xd>, <Xn>, <Xm>, <cond>  ;  SBC <Xd>, <Xn>, <Xm> ; REV16 <Xd>, <Xn> ; REV32 <Xd>, <Xn>
+        {
+            uint64_t xregs = ( 0 != ( 0x80 & hi8 ) );
+            uint64_t bits23_21 = opbits( 21, 3 );
+            uint64_t bits23_10 = opbits( 10, 14 );
+            uint64_t bits15_10 = opbits( 10, 6 );
+            uint64_t bit11 = opbit( 11 );
+            uint64_t bit10 = opbit( 10 );
+            uint64_t n = opbits( 5, 5 );
+            uint64_t d = opbits( 0, 5 );
+
+            if ( 0xda == hi8 && 0x3002 == bits23_10 ) // rev32
+                tracer.Trace( "rev32 %s, %s\n", reg_or_zr( d, true ), reg_or_zr( n, true ) );
+            else if ( 0x3001 == bits23_10 ) // rev16
+                tracer.Trace( "rev16 %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ) );
+            else if ( 4 == bits23_21 ) // csinv + csneg
             {
-                uint64_t size = opbits( 22, 2 );
-                if ( 0 != size )
+                if ( bit11 )
                     unhandled();
-
-                const char * pT = get_ld1_vector_T( size, Q );
-                tracer.Trace( "cnt v%llu.%s, v%llu.%s\n", d, pT, n, pT );
+                uint64_t m = opbits( 16, 5 );
+                uint64_t cond = opbits( 12, 4 );
+                tracer.Trace( "%s %s, %s, %s, %s\n", bit10 ? "csneg" : "csinv", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ),  reg_or_zr( m, xregs ), get_cond( cond ) );
             }
-            else if ( bit21 && 0x11 == bits20_16 && bit15 && 7 == bits14_11 ) // ADDV <V><d>, <Vn>.<T>
+            else if ( 6 == bits23_21 )
             {
-                uint64_t size = opbits( 22, 2 );
-                if ( 3 == size )
+                if ( 0 == bits15_10 ) // rbit
+                    tracer.Trace( "rbit %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ) );
+                else if ( 2 == bits15_10 || 3 == bits15_10 ) // rev
+                    tracer.Trace( "rev %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ) );
+                else if ( 4 == bits15_10 ) // clz
+                    tracer.Trace( "clz %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ) );
+                else
                     unhandled();
-                const char * pT = get_ld1_vector_T( size, Q );
-                char dstT = ( 0 == size ) ? 'B' : ( 1 == size ) ? 'H' : 'S';
-                tracer.Trace( "addv %c%llu, v%llu.%s\n", dstT, d, n, pT );
             }
-            else if ( bit21 && 1 == bits20_16 && !bit15 && 5 == bits14_11 && !bit10 ) // xtn, xtn2 XTN{2} <Vd>.<Tb>, <Vn>.<Ta>
+            else if ( 0 == bits23_21 )
             {
-                uint64_t size = opbits( 22, 2 );
-                if ( 3 == size )
+                if ( 0 == bits15_10 ) // sbc
+                {
+                    uint64_t m = opbits( 16, 5 );
+                    tracer.Trace( "sbc %s, %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ) );
+                }
+                else
                     unhandled();
-
-                const char * pTb = get_ld1_vector_T( size, Q );
-                const char * pTa = ( 0 == size ) ? "8h" : ( 1 == size ) ? "4s" : "2d";
-                tracer.Trace( "xtn%s v%llu.%s, v%llu.%s\n", Q ? "2" : "", d, pTb, n, pTa );
             }
             else
-            {
-                tracer.Trace( "unknown opcode bits23_21 %lld, bit15 %llu, bits14_11 %llu, bit10 %llu\n", bits23_21, bit15, bits14_11, bit10 );
                 unhandled();
-            }
             break;
         }
-        case 0x1e: // FMOV <Wd>, <Hn>    ;    FMUL                ;    FMOV <Wd>, imm       ;    FCVTZU <Wd>, <Dn>    ;    FRINTA <Dd>, <Dn>    ;    FMAXNM <Dd>, <Dn>, <Dm>, FMAX <Dd>, <Dn>, <Dm>
-                   // FMAX <Dd>, <Dn>, <Dm> ; FMINNM <Dd>, <Dn>, <Dm>  ; FMIN <Dd>, <Dn>, <Dm> ; FRINTZ <Dd>, <Dn>    ;    FRINTP <Dd>, <Dn>
-        case 0x9e: // FMOV <Xd>, <Hn>    ;    UCVTF <Hd>, <Dn>    ;    FCVTZU <Xd>, <Dn>    ;    FCVTAS <Xd>, <Dn>    ;    FCVTMU <Xd>, <Dn>
+        case 0x14: case 0x15: case 0x16: case 0x17: // b label
         {
-            uint64_t sf = opbit( 31 );
-            uint64_t ftype = opbits( 22, 2 );
-            uint64_t bit21 = opbit( 21 );
-            uint64_t bit11 = opbit( 11 );
-            uint64_t bit10 = opbit( 10 );
-            uint64_t bit4 = opbit( 4 );
-            uint64_t bits21_19 = opbits( 19, 3 );
-            uint64_t bits18_16 = opbits( 16, 3 );
-            uint64_t bits18_10 = opbits( 10, 9 );
-            uint64_t bits15_10 = opbits( 10, 6 );
-            uint64_t n = opbits( 5, 5 );
-            uint64_t d = opbits( 0, 5 );
-            uint64_t rmode = opbits( 19, 2 );
-            //tracer.Trace( "ftype %llu, bit21 %llu, rmode %llu, bits18_10 %#llx\n", ftype, bit21, rmode, bits18_10 );
-
-            if ( 0x1e == hi8 && 4 == bits21_19 && 0x130 == bits18_10 ) // FRINTP <Dd>, <Dn>
-            {
-                char t = ( 0 == ftype ) ? 's' : ( 3 == ftype ) ? 'h' : ( 1 == ftype ) ? 'd' : '?';
-                tracer.Trace( "frintp %c%llu, %c%llu\n", t, d, t, n );
-            }
-            else if ( 0x1e == hi8 && 4 == bits21_19 && 0x170 == bits18_10 ) // FRINTZ <Dd>, <Dn>
+            int64_t imm26 = opbits( 0, 26 );
+            imm26 <<= 2;
+            imm26 = sign_extend( imm26, 27 );
+            tracer.Trace( "b %#llx\n", pc + imm26 );
+            break;
+        }
+        case 0x54: // b.cond
+        {
+            uint64_t cond = opbits( 0, 4 );
+            int64_t imm19 = opbits( 5, 19 );
+            imm19 <<= 2;
+            imm19 = sign_extend( imm19, 20 );
+            tracer.Trace( "b.%s %#llx\n", get_cond( cond ), pc + imm19 );
+            break;
+        }
+        case 0x18: // ldr wt, (literal)
+        case 0x58: // ldr xt, (literal)
+        {
+            uint64_t imm19 = opbits( 5, 19 );
+            uint64_t t = opbits( 0, 5 );
+            bool xregs = ( 0 != opbit( 30 ) );
+            tracer.Trace( "ldr %s, =%#llx\n", reg_or_zr( t, xregs ), pc + ( imm19 << 2 ) );
+            break;
+        }
+        case 0x3a: // CCMN <Wn>, #<imm>, #<nzcv>, <cond>  ;    CCMN <Wn>, <Wm>, #<nzcv>, <cond>       ;    ADCS <Wd>, <Wn>, <Wm>
+        case 0xba: // CCMN <Wn>, <Wm>, #<nzcv>, <cond>    ;    CCMN <Xn>, <Xm>, #<nzcv>, <cond>       ;    ADCS <Xd>, <Xn>, <Xm>
+        case 0x7a: // CCMP <Wn>, <Wm>, #<nzcv>, <cond>    ;    CCMP <Wn>, #<imm>, #<nzcv>, <cond>     ;    SBCS <Wd>, <Wn>, <Wm>
+        case 0xfa: // CCMP <Xn>, <Xm>, #<nzcv>, <cond>    ;    CCMP <Xn>, #<imm>, #<nzcv>, <cond>     ;    SBCS <Xd>, <Xn>, <Xm>
+        {
+            uint64_t bits23_21 = opbits( 21, 3 );
+            uint64_t bits15_10 = opbits( 10, 6 );
+            uint64_t n = opbits( 5, 5 );
+            bool xregs = ( 0 != ( 0x80 & hi8 ) );
+
+            if ( 2 == bits23_21 )
             {
-                char t = ( 0 == ftype ) ? 's' : ( 3 == ftype ) ? 'h' : ( 1 == ftype ) ? 'd' : '?';
-                tracer.Trace( "frintz %c%llu, %c%llu\n", t, d, t, n );
+                uint64_t o3 = opbit( 4 );
+                if ( 0 != o3 )
+                    unhandled();
+
+                bool is_ccmn = ( 0 == ( hi8 & 0x40 ) );
+                uint64_t cond = opbits( 12, 4 );
+                uint64_t nzcv = opbits( 0, 4 );
+                char width = xregs ? 'x' : 'w';
+                uint64_t o2 = opbits( 10, 2 );
+                if ( 0 == o2 ) // register
+                {
+                    uint64_t m = opbits( 16, 5 );
+                    tracer.Trace( "%s %c%llu, %c%llu, #%llu, %s\n", is_ccmn ? "ccmn" : "ccmp", width, n, width, m, nzcv, get_cond( cond ) );
+                }
+                else if ( 2 == o2 ) // immediate
+                {
+                    uint64_t imm5 = opbits( 16, 5 ); // unsigned
+                    tracer.Trace( "%s %c%llu, #%llx, #%llu, %s\n", is_ccmn ? "ccmn" : "ccmp", width, n, imm5, nzcv, get_cond( cond ) );
+                }
+                else
+                    unhandled();
             }
-            else if ( 0x1e == hi8 && bit21 && ( 0x12 == bits15_10 || 0x1a == bits15_10 ) ) // FMAX <Dd>, <Dn>, <Dm>    ;    FMAXNM <Dd>, <Dn>, <Dm>,
+            else if ( ( 0xfa == hi8 || 0x7a == hi8 ) && 0 == bits23_21 && 0 == bits15_10 ) // SBCS <Xd>, <Xn>, <Xm>
             {
+                uint64_t d = opbits( 0, 5 );
                 uint64_t m = opbits( 16, 5 );
-                char t = ( 0 == ftype ) ? 's' : ( 3 == ftype ) ? 'h' : ( 1 == ftype ) ? 'd' : '?';
-                tracer.Trace( "%s %c%llu, %c%llu, %c%llu\n", ( 0x12 == bits15_10 ) ? "fmax" : "fmaxnm", t, d, t, n, t, m );
+                tracer.Trace( "sbcs %s, %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ) );
             }
-            else if ( 0x1e == hi8 && bit21 && ( 0x16 == bits15_10 || 0x1e == bits15_10 ) ) // FMIN <Dd>, <Dn>, <Dm>    ;    FMINNM <Dd>, <Dn>, <Dm>
+            else if ( ( 0x3a == hi8 || 0xba == hi8 ) && 0 == bits23_21 && 0 == bits15_10 ) // ADCS <Xd>, <Xn>, <Xm>
             {
+                uint64_t d = opbits( 0, 5 );
                 uint64_t m = opbits( 16, 5 );
-                char t = ( 0 == ftype ) ? 's' : ( 3 == ftype ) ? 'h' : ( 1 == ftype ) ? 'd' : '?';
-                tracer.Trace( "%s %c%llu, %c%llu, %c%llu\n", ( 0x16 == bits15_10 ) ? "fmin" : "fminnm", t, d, t, n, t, m );
-            }
-            else if ( 0x1e == hi8 && 4 == bits21_19 && 0x150 == bits18_10 ) // FRINTM <Dd>, <Dn>
-            {
-                char t = ( 0 == ftype ) ? 's' : ( 3 == ftype ) ? 'h' : ( 1 == ftype ) ? 'd' : '?';
-                tracer.Trace( "frintm %c%llu, %c%llu\n", t, d, t, n );
+                tracer.Trace( "adcs %s, %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ) );
             }
-            else if ( 0x1e == hi8 && bit21 && !bit11 && bit10 && bit4 ) // FCCMPE <Sn>, <Sm>, #<nzcv>, <cond>    ;    FCCMPE <Dn>, <Dm>, #<nzcv>, <cond>
+            else
+                unhandled();
+            break;
+        }
+        case 0x31: // ADDS <Wd>, <Wn|WSP>, #<imm>{, <shift>}  ;    CMN <Wn|WSP>, #<imm>{, <shift>}
+        case 0xb1: // ADDS <Xd>, <Xn|SP>, #<imm>{, <shift>}   ;    CMN <Xn|SP>, #<imm>{, <shift>}
+        {
+            uint64_t xregs = ( 0 != ( 0x80 & hi8 ) );
+            bool shift12 = opbit( 22 );
+            uint64_t imm12 = opbits( 10, 12 );
+            uint64_t n = opbits( 5, 5 );
+            uint64_t d = opbits( 0, 5 );
+
+            if ( 31 == d )
+                tracer.Trace( "cmn %s, #%#llx, lsl #%llu\n", reg_or_sp( n, xregs ), imm12, ( shift12 ? 12ull : 0ull ) );
+            else
+                tracer.Trace( "adds %s, %s, #%#llx, lsl #%llu\n", reg_or_zr( d, xregs ), reg_or_sp( n, xregs ), imm12, ( shift12 ? 12ull : 0ull ) );
+            break;
+        }
+        case 0x0b: // ADD <Wd|WSP>, <Wn|WSP>, <Wm>{, <extend> {#<amount>}}      ;    ADD <Wd>, <Wn>, <Wm>{, <shift> #<amount>}
+        case 0x2b: // ADDS <Wd>, <Wn|WSP>, <Wm>{, <extend> {#<amount>}}         ;    ADDS <Wd>, <Wn>, <Wm>{, <shift> #<amount>}
+        case 0x4b: // SUB <Wd|WSP>, <Wn|WSP>, <Wm>{, <extend> {#<amount>}}      ;    SUB <Wd>, <Wn>, <Wm>{, <shift> #<amount>}
+        case 0x6b: // SUBS <Wd>, <Wn|WSP>, <Wm>{, <extend> {#<amount>}}         ;    SUBS <Wd>, <Wn>, <Wm>{, <shift> #<amount>}
+        case 0x8b: // ADD <Xd|SP>, <Xn|SP>, <R><m>{, <extend> {#<amount>}}      ;    ADD <Xd>, <Xn>, <Xm>{, <shift> #<amount>}
+        case 0xab: // ADDS <Xd>, <Xn|SP>, <R><m>{, <extend> {#<amount>}}        ;    ADDS <Xd>, <Xn>, <Xm>{, <shift> #<amount>}
+        case 0xcb: // SUB <Xd|SP>, <Xn|SP>, <R><m>{, <extend> {#<amount>}}      ;    SUB <Xd>, <Xn>, <Xm>{, <shift> #<amount>}
+        case 0xeb: // SUBS <Xd>, <Xn|SP>, <R><m>{, <extend> {#<amount>}}        ;    SUBS <Xd>, <Xn>, <Xm>{, <shift> #<amount>}
+        {
+            uint64_t extended = opbit( 21 );
+            uint64_t issub = ( 0 != ( 0x40 & hi8 ) );
+            const char * opname = issub ? "sub" : "add";
+            uint64_t setflags = ( 0 != ( 0x20 & hi8 ) );
+            uint64_t xregs = ( 0 != ( 0x80 & hi8 ) );
+            uint64_t m = opbits( 16, 5 );
+            uint64_t n = opbits( 5, 5 );
+            uint64_t d = opbits( 0, 5 );
+
+            if ( 1 == extended ) // ADD <Xd|SP>, <Xn|SP>, <R><m>{, <extend> {#<amount>}}
             {
-                char t = ( 0 == ftype ) ? 's' : ( 3 == ftype ) ? 'h' : ( 1 == ftype ) ? 'd' : '?';
-                uint64_t m = opbits( 16, 5 );
-                uint64_t nzcv = opbits( 0, 4 );
-                uint64_t cond = opbits( 12, 4 );
-                tracer.Trace( "fccmpe %c%llu, %c%llu, #%#llx, %s\n", t, n, t, m, nzcv, get_cond( cond ) );
+                uint64_t option = opbits( 13, 3 );
+                uint64_t imm3 = opbits( 10, 3 );
+                tracer.Trace( "%s%s, %s, %s, %s, %s #%llu\n", opname, setflags ? "s" : "",
+                              setflags ? reg_or_zr( d, xregs ) : reg_or_sp( d, xregs ),
+                              reg_or_sp( n, xregs ), reg_or_zr( m, xregs ),
+                              extend_type( option ), imm3 );
             }
-            else if ( 3 == bits21_19 && 0 == bits18_16 ) // FCVTZS <Xd>, <Dn>, #<fbits>
+            else // ADD <Xd>, <Xn>, <Xm>{, <shift> #<amount>}
             {
-                char t = ( 0 == ftype ) ? 's' : ( 3 == ftype ) ? 'h' : ( 1 == ftype ) ? 'd' : '?';
-                uint64_t scale = opbits( 10, 6 );
-                uint64_t fbits = 64 - scale;
-                tracer.Trace( "fcvtzs %s, %c%llu, #%llu\n", reg_or_zr( d, sf ), t, n, fbits );
+                uint64_t shift = opbits( 22, 2 );
+                uint64_t imm6 = opbits( 10, 6 );
+                if ( issub && ( 31 == d ) )
+                    tracer.Trace( "cmp %s, %s { %s #%llu }\n",
+                                  reg_or_zr( n, xregs ), reg_or_zr( m, xregs ),
+                                  shift_type( shift ), imm6 );
+                else
+                    tracer.Trace( "%s%s %s, %s, %s { %s #%llu }\n", opname, setflags ? "s" : "",
+                                  reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ),
+                                  shift_type( shift ), imm6 );
             }
-            else if ( 6 == bits21_19 && 0x40 == bits18_10 ) // FCVTMU <Xd>, <Dn>
+            break;
+        }
+        case 0x11: // add <wd|SP>, <wn|SP>, #imm [,<shift>]
+        case 0x51: // sub <wd|SP>, <wn|SP>, #imm [,<shift>]
+        case 0x91: // add <xd|SP>, <xn|SP>, #imm [,<shift>]
+        case 0xd1: // sub <xd|SP>, <xn|SP>, #imm [,<shift>]
+        {
+            bool sf = ( 0 != opbit( 31 ) );
+            bool sh = ( 0 != opbit( 22 ) );
+            uint64_t imm12 = opbits( 10, 12 );
+            uint64_t n = opbits( 5, 5 );
+            uint64_t d = opbits( 0, 5 );
+            tracer.Trace( "%s %s, %s, #%#llx, lsl #%llu\n", ( 0x91 == hi8 || 0x11 == hi8 ) ? "add" : "sub",
+                          reg_or_sp( d, sf ), reg_or_sp( n, sf ), imm12, (uint64_t) ( sh ? 12 : 0 ) );
+            break;
+        }
+        case 0xd5: // MSR / MRS
+        {
+            uint64_t bits2322 = opbits( 22, 2 );
+            if ( 0 != bits2322 )
+                unhandled();
+
+            if ( 0xd503201f == op ) // nop
             {
-                char type = ( 0 == ftype ) ? 's' : ( 1 == ftype ) ? 'd' : ( 3 == ftype ) ? 'h' : '?';
-                tracer.Trace( "fcvtmu %s, %c%llu\n", reg_or_zr( d, sf ), type, n );
+                tracer.Trace( "nop\n" );
+                break;
             }
-            else if ( 4 == bits21_19 && 0x100 == bits18_10 ) // FCVTAS <Xd>, <Dn>
+
+            uint64_t upper20 = opbits( 12, 20 );
+            uint64_t lower8 = opbits( 0, 8 );
+            if ( ( 0xd5033 == upper20 ) && ( 0xbf == lower8 ) ) // dmb -- no memory barries are needed due to just one thread and core
             {
-                char type = ( 0 == ftype ) ? 's' : ( 1 == ftype ) ? 'd' : ( 3 == ftype ) ? 'h' : '?';
-                tracer.Trace( "fcvtas %s, %c%llu\n", reg_or_zr( d, sf ), type, n );
+                tracer.Trace( "dmb\n" );
+                break;
             }
-            else if ( 0x1e == hi8 && 4 == bits21_19 && 0x190 == bits18_10 ) // FRINTA <Dd>, <Dn>
+
+            if ( ( 0xd5033 == upper20 ) && ( 0x9f == lower8 || 0xdf == lower8 ) )
             {
-                char type = ( 0 == ftype ) ? 's' : ( 1 == ftype ) ? 'd' : ( 3 == ftype ) ? 'h' : '?';
-                tracer.Trace( "frinta %c%llu, %c%llu\n", type, d, type, n );
+                tracer.Trace( "%s\n", ( 0x9f == lower8 ) ? "dsb" : "isb" );
+                break;
             }
-            else if ( ( 0x180 == ( bits18_10 & 0x1bf ) ) && ( bit21 ) && ( 0 == ( rmode & 2 ) ) ) // fmov reg, vreg  OR mov vreg, reg
-            {
-                uint64_t opcode = opbits( 16, 3 );
-                if ( 0 == sf )
-                {
-                    if ( 0 != rmode )
-                        unhandled();
 
-                    if ( 3 == ftype )
-                    {
-                        if ( 6 == opcode )
-                            tracer.Trace( "fmov w%llu, h%llu\n", d, n );
-                        else if ( 7 == opcode )
-                            tracer.Trace( "fmov h%llu, w%llu\n", d, n );
-                    }
-                    else if ( 0 == ftype )
-                    {
-                        if ( 7 == opcode )
-                            tracer.Trace( "fmov s%llu, w%llu\n", d, n );
-                        else if ( 6 == opcode )
-                            tracer.Trace( "fmov w%llu, s%llu\n", d, n );
-                    }
-                    else
-                        unhandled();
-                }
+            uint64_t l = opbit( 21 );
+            uint64_t op0 = opbits( 19, 2 );
+            uint64_t op1 = opbits( 16, 3 );
+            uint64_t op2 = opbits( 5, 3 );
+            uint64_t n = opbits( 12, 4 );
+            uint64_t m = opbits( 8, 4 );
+            uint64_t t = opbits( 0, 5 );
+
+            if ( l ) // MRS <Xt>, (<systemreg>|S<op0>_<op1>_<Cn>_<Cm>_<op2>).   read system register
+            {
+                if ( ( 3 == op0 ) && ( 14 == n ) && ( 3 == op1 ) && ( 0 == m ) && ( 2 == op2 ) ) // cntvct_el0 counter-timer virtual count register
+                    tracer.Trace( "mrs x%llu, cntvct_el0\n", t );
+                else if ( ( 3 == op0 ) && ( 14 == n ) && ( 3 == op1 ) && ( 0 == m ) && ( 0 == op2 ) ) // cntfrq_el0 counter-timer frequency register
+                    tracer.Trace( "mrs x%llu, cntfrq_el0\n", t );
+                else if ( ( 3 == op0 ) && ( 15 == n ) && ( 3 == op1 ) && ( 0 == m ) )
+                    tracer.Trace( "mrs x%llu, S3_3_C15_C0_%llu\n", t, op2 );
+                else if ( ( 3 == op0 ) && ( 9 == n ) && ( 3 == op1 ) && ( 13 == m ) && ( 0 == op2 ) )
+                    tracer.Trace( "mrs x%llu, pmccntr_el0\n", t );
+                else if ( ( 3 == op0 ) && ( 14 == n ) && ( 3 == op1 ) && ( m >= 8 ) && ( m <= 11 ) )
+                    tracer.Trace( "mrs x%llu, pmevcntr%llu_el0\n", t, ( ( m & 3 ) << 3 ) | op2 );
+                else if ( ( 3 == op0 ) && ( 0 == n ) && ( 3 == op1 ) && ( 0 == m ) && ( 7 == op2 ) )
+                    tracer.Trace( "mrs x%llu, dczid_elo\n", t );
+                else if ( ( 3 == op0 ) && ( 0 == n ) && ( 0 == op1 ) && ( 0 == m ) && ( 0 == op2 ) ) // mrs x, midr_el1
+                    tracer.Trace( "mrs x%llu, midr_el1\n", t );
+                else if ( ( 3 == op0 ) && ( 0 == n ) && ( 0 == op1 ) && ( m >= 4 ) && ( m <= 7 ) )
+                    tracer.Trace( "mrs x%llu, S3_0_C0_C%llu_%llu // ID_AA64 register\n", t, m, op2 );
+                else if ( ( 3 == op0 ) && ( 13 == n ) && ( 3 == op1 ) && ( 0 == m ) && ( 2 == op2 ) )
+                    tracer.Trace( "mrs x%llu, tpidr_el0\n", t );
+                else if ( ( 3 == op0 ) && ( 4 == n ) && ( 3 == op1 ) && ( 4 == m ) && ( 0 == op2 ) ) // mrs x, fpcr
+                    tracer.Trace( "mrs x%llu, fpcr // %s\n", t, get_rmode_text( get_bits( fpcr, 22, 2 ) ) );
+                else if ( ( 3 == op0 ) && ( 4 == n ) && ( 3 == op1 ) && ( 4 == m ) && ( 1 == op2 ) ) // mrs x, fpsr
+                    tracer.Trace( "mrs x%llu, fpsr\n", t );
+                else if ( ( 3 == op0 ) && ( 4 == n ) && ( 3 == op1 ) && ( 2 == m ) && ( 0 == op2 ) )
+                    tracer.Trace( "mrs x%llu, nzcv\n", t );
+                else if ( ( 3 == op0 ) && ( 0 == n ) && ( 3 == op1 ) && ( 0 == m ) && ( 1 == op2 ) )
+                    tracer.Trace( "mrs x%llu, ctr_el0\n", t );
                 else
                 {
-                    if ( 0 == rmode )
-                    {
-                        if ( 3 == ftype && 6 == opcode )
-                            tracer.Trace( "fmov x%llu, h%llu\n", d, n );
-                        else if ( 3 == ftype && 7 == opcode )
-                            tracer.Trace( "fmov h%llu, %s\n", d, reg_or_zr( n, false ) );
-                        else if ( 1 == ftype && 7 == opcode )
-                            tracer.Trace( "fmov d%llu, %s\n", d, reg_or_zr( n, true ) );
-                        else if ( 1 == ftype && 6 == opcode )
-                            tracer.Trace( "fmov x%llu, d%llu\n", d, n );
-                        else
-                            unhandled();
-                    }
-                    else
-                    {
-                        if ( 2 == ftype && 7 == opcode )
-                            tracer.Trace( "fmov v%llu.D[1], x%llu\n", d, n );
-                        else if ( 2 == ftype && 6 == opcode )
-                            tracer.Trace( "fmov x%llu, v%llu.D[1]\n", d, n );
-                    }
+                    tracer.Trace( "MRS unhandled: t %llu op0 %llu n %llu op1 %llu m %llu op2 %llu\n", t, op0, n, op1, m, op2 );
+                    unhandled();
                 }
             }
-            else if ( 0x40 == bits18_10 && bit21 && 3 == rmode ) // FCVTZU <Wd>, <Dn>
+            else // MSR.   write system register
             {
-                char t = ( 0 == ftype ) ? 's' : ( 3 == ftype ) ? 'h' : ( 1 == ftype ) ? 'd' : '?';
-                tracer.Trace( "fcvtzu %s, %c%llu\n", reg_or_zr( d, sf ), t, n );
-            }
-            else if ( 0x40 == ( bits18_10 & 0x1c0 ) && !bit21 && 3 == rmode ) // FCVTZU <Wd>, <Dn>, #<fbits>
-            {
-                char t = ( 0 == ftype ) ? 's' : ( 3 == ftype ) ? 'h' : ( 1 == ftype ) ? 'd' : '?';
-                uint64_t scale = opbits( 10, 6 );
-                uint64_t fbits = 64 - scale;
-                tracer.Trace( "fcvtzu %s, %cllu, #%llu\n", reg_or_zr( d, sf ), t, n, fbits );
-            }
-            else if ( ( 0x1e == hi8 ) && ( 4 == ( bits18_10 & 7 ) ) && bit21 && 0 == opbits( 5, 5 ) ) // fmov scalar immediate
-            {
-                //tracer.Trace( "ftype %llu, bit21 %llu, rmode %llu, bits18_10 %#llx\n", ftype, bit21, rmode, bits18_10 );
-                uint64_t fltsize = ( 2 == ftype ) ? 64 : ( 8ull << ( ftype ^ 2 ) );
-                char width = ( 3 == ftype ) ? 'H' : ( 0 == ftype ) ? 'S' : ( 1 == ftype ) ? 'D' : '?';
-                uint64_t imm8 = opbits( 13, 8 );
-                //tracer.Trace( "imm8: %llu == %#llx\n", imm8, imm8 );
-                uint64_t val = vfp_expand_imm( imm8, fltsize );
-                double dval = 0.0;
-                if ( 1 == ftype )
-                    mcpy( &dval, &val, sizeof( dval ) );
-                else if ( 0 == ftype )
+                if ( ( 3 == op0 ) && ( 13 == n ) && ( 3 == op1 ) && ( 0 == m ) && ( 2 == op2 ) )
+                    tracer.Trace( "msr tpidr_el0, x%llu\n", t );
+                else if ( ( 0 == op0 ) && ( 2 == n ) && ( 3 == op1 ) && ( 4 == m ) && ( 2 == op2 ) )
+                    tracer.Trace( "bti\n" ); // branch target identification (ignore );
+                else if ( ( 1 == op0 ) && ( 7 == n ) && ( 3 == op1 ) && ( 4 == m ) && ( 1 == op2 ) )
+                    tracer.Trace( "dc zva, %s\n", reg_or_zr( t, true ) ); // data cache operation
+                else if ( ( 1 == op0 ) && ( 7 == n ) && ( 3 == op1 ) && ( 5 == m ) && ( 1 == op2 ) )
+                    tracer.Trace( "ic ivau, %s\n", reg_or_zr( t, true ) );
+                else if ( ( 1 == op0 ) && ( 7 == n ) && ( 3 == op1 ) && ( 10 == m || 11 == m || 14 == m ) && ( 1 == op2 ) )
+                    tracer.Trace( "dc %s, %s\n", ( 10 == m ) ? "cvac" : ( 11 == m ) ? "cvau" : "civac", reg_or_zr( t, true ) );
+                else if ( ( 3 == op0 ) && ( 4 == n ) && ( 3 == op1 ) && ( 2 == m ) && ( 0 == op2 ) )
+                    tracer.Trace( "msr nzcv, x%llu\n", t );
+                else if ( ( 0 == op0 ) && ( 2 == n ) && ( 3 == op1 ) && ( 0 == m ) && ( 7 == op2 ) ) // xpaclri
+                    tracer.Trace( "xpaclri\n" );
+                else if ( ( 3 == op0 ) && ( 4 == n ) && ( 3 == op1 ) && ( 4 == m ) && ( 0 == op2 ) ) // msr fpcr, xt
+                    tracer.Trace( "msr fpcr, x%llu // %s\n", t, get_rmode_text( get_bits( regs[ t ], 22, 2 ) ) );
+                else
                 {
-                    float float_val;
-                    mcpy( &float_val, &val, sizeof( float_val ) );
-                    dval = (double) float_val;
+                    tracer.Trace( "MSR unhandled: t %llu op0 %llu n %llu op1 %llu m %llu op2 %llu\n", t, op0, n, op1, m, op2 );
+                    unhandled();
                 }
-                tracer.Trace( "fmov %c%llu, #%lf // %#llx\n", width, d, dval, val );
             }
-            else if ( ( 0x1e == hi8 ) && ( 2 == ( bits18_10 & 0x3f ) ) && ( bit21 ) ) // fmul vreg, vreg, vreg
+            break;
+        }
+        case 0x1b: // MADD <Wd>, <Wn>, <Wm>, <Wa>    ;    MSUB <Wd>, <Wn>, <Wm>, <Wa>
+        case 0x9b: // MADD <Xd>, <Xn>, <Xm>, <Xa>    ;    MSUB <Xd>, <Xn>, <Xm>, <Xa>    ;    UMULH <Xd>, <Xn>, <Xm>    ;    UMADDL <Xd>, <Wn>, <Wm>, <Xa>
+                   // SMADDL <Xd>, <Wn>, <Wm>, <Xa>  ;    SMULH <Xd>, <Xn>, <Xm>         ;    UMSUBL <Xd>, <Wn>, <Wm>, <Xa>
+        {
+            bool xregs = ( 0 != opbit( 31 ) );
+            uint64_t m = opbits( 16, 5 );
+            uint64_t a = opbits( 10, 5 );
+            uint64_t n = opbits( 5, 5 );
+            uint64_t d = opbits( 0, 5 );
+            uint64_t bits23_21 = opbits( 21, 3 );
+            bool bit15 = ( 1 == opbit( 15 ) );
+
+            if ( 0x9b == hi8 && 5 == bits23_21 && bit15 ) // UMSUBL <Xd>, <Wn>, <Wm>, <Xa>
+                tracer.Trace( "umsubl x%llu, w%llu, w%llu, x%llu\n", d, n, m, a );
+            else if ( 1 == bits23_21 && bit15 ) // smsubl
+                tracer.Trace( "mmsubl %s, %s, %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ), reg_or_zr( a, xregs ) );
+            else if ( 5 == bits23_21 && !bit15 )
+                tracer.Trace( "umaddl %s, %s, %s\n", reg_or_zr( d, true ), reg_or_zr( n, true ), reg_or_zr( m, true ) );
+            else if ( 1 == bits23_21 && !bit15 )
+                tracer.Trace( "smaddl %s, %s, %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, false ), reg_or_zr( m, false ), reg_or_zr( a, xregs ) );
+            else if ( 0 == bits23_21 && !bit15 )
+                tracer.Trace( "madd %s, %s, %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ), reg_or_zr( a, xregs ) );
+            else if ( 0 == bits23_21 && bit15 )
+                tracer.Trace( "msub %s, %s, %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ), reg_or_zr( a, xregs ) );
+            else if ( 6 == bits23_21 && !bit15 && 31 == a )
+                tracer.Trace( "umulh %s, %s, %s\n", reg_or_zr( d, true ), reg_or_zr( n, true ), reg_or_zr( m, true ) );
+            else if ( 2 == bits23_21 && !bit15 && 31 == a )
+                tracer.Trace( "smulh %s, %s, %s\n", reg_or_zr( d, true ), reg_or_zr( n, true ), reg_or_zr( m, true ) );
+            else
+                unhandled();
+            break;
+        }
+        case 0x71: // SUBS <Wd>, <Wn|WSP>, #<imm>{, <shift>}   ;   CMP <Wn|WSP>, #<imm>{, <shift>}
+        case 0xf1: // SUBS <Xd>, <Xn|SP>, #<imm>{, <shift>}    ;   cmp <xn|SP>, #imm [,<shift>]    ;
+        {
+            bool sf = ( 0 != opbit( 31 ) );
+            bool sh = ( 0 != opbit( 22 ) );
+            uint64_t imm12 = opbits( 10, 12 );
+            uint64_t n = opbits( 5, 5 );
+            uint64_t d = opbits( 0, 5 );
+
+            if ( 31 == d )
+                tracer.Trace( "cmp %s, #%#llx, LSL #%llu\n", reg_or_zr( n, sf ), imm12, sh ? 12ull : 0ull );
+            else
+                tracer.Trace( "subs %s, %s, #%#llx, LSL #%llu\n", reg_or_zr( d, sf ), reg_or_sp( n, sf ), imm12, sh ? 12ull : 0ull );
+            break;
+        }
+        case 0x94: case 0x95: case 0x96: case 0x97: // bl offset. The lower 2 bits of this are the high part of the offset
+        {
+            int64_t offset = ( opbits( 0, 26 ) << 2 );
+            offset = sign_extend( offset, 27 );
+            tracer.Trace( "bl %#llx\n", pc + offset );
+            break;
+        }
+        case 0x28: // ldp/stp 32 post index                   STP <Wt1>, <Wt2>, [<Xn|SP>], #<imm>     ;    LDP <Wt1>, <Wt2>, [<Xn|SP>], #<imm>
+        case 0xa8: // ldp/stp 64 post-index                   STP <Xt1>, <Xt2>, [<Xn|SP>], #<imm>     ;    LDP <Xt1>, <Xt2>, [<Xn|SP>], #<imm>
+        case 0x29: // ldp/stp 32 pre-index and signed offset: STP <Wt1>, <Wt2>, [<Xn|SP>, #<imm>]!    ;    STP <Wt1>, <Wt2>, [<Xn|SP>{, #<imm>}]
+                   //                                         LDP <Wt1>, <Wt2>, [<Xn|SP>, #<imm>]!    ;    LDP <Wt1>, <Wt2>, [<Xn|SP>{, #<imm>}]
+        case 0xa9: // ldp/stp 64 pre-index and signed offset: STP <Xt1>, <Xt2>, [<Xn|SP>, #<imm>]!    ;    STP <Xt1>, <Xt2>, [<Xn|SP>{, #<imm>}]
+                   //                                         LDP <Xt1>, <Xt2>, [<Xn|SP>, #<imm>]!    ;    LDP <Xt1>, <Xt2>, [<Xn|SP>{, #<imm>}]
+        case 0x68: // ldp 32-bit sign extended                LDPSW <Xt1>, <Xt2>, [<Xn|SP>], #<imm>
+        case 0x69: // ldp 32-bit sign extended                LDPSW <Xt1>, <Xt2>, [<Xn|SP>, #<imm>]!  ;    LDPSW <Xt1>, <Xt2>, [<Xn|SP>{, #<imm>}]
+        {
+            bool xregs = ( 0 != opbit( 31 ) );
+            uint64_t t1 = opbits( 0, 5 );
+            uint64_t t2 = opbits( 10, 5 );
+            uint64_t n = opbits( 5, 5 );
+            int64_t imm7 = sign_extend( opbits( 15, 7 ), 6 ) << ( xregs ? 3 : 2 );
+            uint64_t variant = opbits( 23, 2 );
+            if ( 0 == variant )
+                unhandled();
+
+            bool postIndex = ( 1 == variant );
+            bool preIndex = ( 3 == variant );
+            bool signedOffset = ( 2 == variant );
+
+            if ( 0 == opbit( 22 ) ) // bit 22 is 0 for stp
             {
-                uint64_t m = opbits( 16, 5 );
-                if ( 0 == ftype ) // single-precision
-                    tracer.Trace( "fmul s%llu, s%llu, s%llu\n", d, n, m );
-                else if ( 1 == ftype ) // double-precision
-                    tracer.Trace( "fmul d%llu, d%llu, d%llu\n", d, n, m );
-                else
+                if ( 0x68 == hi8 || 0x69 == hi8 ) // these are ldpsw variants
                     unhandled();
-            }
-            else if ( ( 0x1e == hi8 ) && ( 0x90 == ( bits18_10 & 0x19f ) ) && ( bit21 ) ) // fcvt vreg, vreg
-            {
-                uint64_t opc = opbits( 15, 2 );
-                tracer.Trace( "fcvt %c%llu, %c%llu\n", get_fcvt_precision( opc ), d, get_fcvt_precision( ftype ), n );
-            }
-            else if ( ( 0x1e == hi8 ) && ( 0x10 == bits18_10 ) && ( 4 == bits21_19 ) ) // fmov vreg, vreg
-            {
-                tracer.Trace( "fmov %c%llu, %c%llu\n", get_fcvt_precision( ftype ), d, get_fcvt_precision( ftype ), n );
-            }
-            else if ( ( 0x1e == hi8 ) && ( 8 == ( bits18_10 & 0x3f ) ) && ( bit21 ) ) // fcmp vreg, vreg   OR    fcmp vreg, 0.0 and fcmpe variants
-            {
-                uint64_t m = opbits( 16, 5 );
-                uint64_t opc = opbits( 3, 2 );
-                bool is_fcmpe = ( ( 3 == ftype && 2 == opc ) || ( 3 == ftype && 3 == opc ) || ( 0 == ftype && 2 == opc ) || ( 0 == ftype && 0 == m && 3 == opc ) ||
-                                  ( 1 == ftype && 2 == opc ) || ( 1 == ftype && 0 == m && 3 == opc ) );
-                if ( ( 1 == opc || 3 == opc ) && 0 == m )
-                    tracer.Trace( "%s %c%llu, #0.0\n", is_fcmpe ? "fcmpe" : "fcmp", get_fcvt_precision( ftype ), n );
-                else
-                    tracer.Trace( "%s %c%llu, %c%llu\n", is_fcmpe ? "fcmpe" : "fcmp", get_fcvt_precision( ftype ), n, get_fcvt_precision( ftype ), m );
-            }
-            else if ( ( 0x1e == hi8 ) && ( 0x30 == bits18_10 ) && ( 4 == bits21_19 ) ) // fabs vreg, vreg
-            {
-                tracer.Trace( "fabs %c%llu, %c%llu\n", get_fcvt_precision( ftype ), d, get_fcvt_precision( ftype ), n );
-            }
-            else if ( 0x1e == hi8 && ( 6 == ( 0x3f & bits18_10 ) ) && bit21 ) // fdiv
-            {
-                uint64_t m = opbits( 16, 5 );
-                if ( 0 == ftype ) // single-precision
-                    tracer.Trace( "fdiv s%llu, s%llu, s%llu\n", d, n, m );
-                else if ( 1 == ftype ) // double-precision
-                    tracer.Trace( "fdiv d%llu, d%llu, d%llu\n", d, n, m );
+
+                if ( signedOffset )
+                    tracer.Trace( "stp %s, %s, [%s, #%lld] //so\n", reg_or_zr( t1, xregs ), reg_or_zr( t2, xregs ), reg_or_sp( n, true ), imm7 );
+                else if ( preIndex )
+                    tracer.Trace( "stp %s, %s, [%s, #%lld]! //pr\n", reg_or_zr( t1, xregs ), reg_or_zr( t2, xregs ), reg_or_sp( n, true ), imm7 );
+                else if ( postIndex )
+                    tracer.Trace( "stp %s, %s, [%s] #%lld //po\n", reg_or_zr( t1, xregs ), reg_or_zr( t2, xregs ), reg_or_sp( n, true ), imm7 );
                 else
                     unhandled();
             }
-            else if ( 0x1e == hi8 && ( 0xa == ( 0x3f & bits18_10 ) ) && bit21 ) // fadd
+            else // 1 means ldp
             {
-                uint64_t m = opbits( 16, 5 );
-                if ( 0 == ftype ) // single-precision
-                    tracer.Trace( "fadd s%llu, s%llu, s%llu\n", d, n, m );
-                else if ( 1 == ftype ) // double-precision
-                    tracer.Trace( "fadd d%llu, d%llu, d%llu\n", d, n, m );
+                bool se = ( 0 != ( hi8 & 0x40 ) );
+                if ( signedOffset )
+                    tracer.Trace( "ldp%s %s, %s, [%s, #%lld] //so\n", se ? "sw" : "", reg_or_zr( t1, xregs ), reg_or_zr( t2, xregs ), reg_or_sp( n, true ), imm7 );
+                else if ( preIndex )
+                    tracer.Trace( "ldp%s %s, %s, [%s, #%lld]! //pr\n", se ? "sw" : "", reg_or_zr( t1, xregs ), reg_or_zr( t2, xregs ), reg_or_sp( n, true ), imm7 );
+                else if ( postIndex )
+                    tracer.Trace( "ldp%s %s, %s, [%s] #%lld //po\n", se ? "sw" : "", reg_or_zr( t1, xregs ), reg_or_zr( t2, xregs ), reg_or_sp( n, true ), imm7 );
                 else
                     unhandled();
             }
-            else if ( 0x1e == hi8 && ( 0xe == ( 0x3f & bits18_10 ) ) && bit21 ) // fsub
+            break;
+        }
+        case 0x4a: // EOR <Wd>, <Wn>, <Wm>{, <shift> #<amount>}    ;    EON <Wd>, <Wn>, <Wm>{, <shift> #<amount>}
+        case 0xca: // EOR <Xd>, <Xn>, <Xm>{, <shift> #<amount>}    ;    EON <Xd>, <Xn>, <Xm>{, <shift> #<amount>}
+        case 0x2a: // ORR <Wd>, <Wn>, <Wm>{, <shift> #<amount>}    ;    ORN <Wd>, <Wn>, <Wm>{, <shift> #<amount>}
+        case 0xaa: // ORR <Xd>, <Xn>, <Xm>{, <shift> #<amount>}    ;    ORN <Xd>, <Xn>, <Xm>{, <shift> #<amount>}
+        {
+            uint64_t shift = opbits( 22, 2 );
+            uint64_t N = opbit( 21 );
+            uint64_t m = opbits( 16, 5 );
+            uint64_t n = opbits( 5, 5 );
+            uint64_t d = opbits( 0, 5 );
+            uint64_t imm6 = opbits( 10, 6 );
+            uint64_t xregs = ( 0 != ( 0x80 & hi8 ) );
+            bool eor = ( 2 == opbits( 29, 2 ) ); // or eon
+
+            if ( ( 0 == imm6 ) && ( 31 == n ) && ( 0 == shift ) && ( 0 == N ) )
+                tracer.Trace( "mov %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( m, xregs ) );
+            else if ( ( 0 == shift ) && ( 0 == imm6 ) )
+                tracer.Trace( "%s %s, %s, %s\n", eor ? ( N ? "eon" : "eor" ) : ( !N ) ? "orr" : "orn", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ) );
+            else
+                tracer.Trace( "%s %s, %s, %s, %s #%llu\n", eor ? ( N ? "eon" : "eor" ) : ( !N ) ? "orr" : "orn", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ), shift_type( shift ), imm6 );
+            break;
+        }
+        case 0x32: // ORR <Wd|WSP>, <Wn>, #<imm>
+        case 0xb2: // ORR <Xd|SP>, <Xn>, #<imm>
+        {
+            uint64_t xregs = ( 0 != ( 0x80 & hi8 ) );
+            uint64_t N_immr_imms = opbits( 10, 13 );
+            uint64_t op2 = decode_logical_immediate( N_immr_imms, xregs ? 64 : 32 );
+            uint64_t n = opbits( 5, 5 );
+            uint64_t d = opbits( 0, 5 );
+            tracer.Trace( "orr %s, %s, #%#llx\n", reg_or_sp( d, xregs ), reg_or_zr( n, xregs ), op2 );
+            break;
+        }
+        case 0x33: // BFM <Wd>, <Wn>, #<immr>, #<imms>
+        case 0xb3: // BFM <Xd>, <Xn>, #<immr>, #<imms>
+        case 0x13: // SBFM <Wd>, <Wn>, #<immr>, #<imms>    ;    EXTR <Wd>, <Wn>, <Wm>, #<lsb>
+        case 0x93: // SBFM <Xd>, <Xn>, #<immr>, #<imms>    ;    EXTR <Xd>, <Xn>, <Xm>, #<lsb>
+        case 0x53: // UBFM <Wd>, <Wn>, #<immr>, #<imms>
+        case 0xd3: // UBFM <Xd>, <Xn>, #<immr>, #<imms>
+        {
+            uint64_t xregs = ( 0 != ( 0x80 & hi8 ) );
+            uint64_t imms = opbits( 10, 6 );
+            uint64_t n = opbits( 5, 5 );
+            uint64_t d = opbits( 0, 5 );
+            uint64_t bit23 = opbit( 23 );
+            if ( bit23 && ( 0x13 == ( 0x7f & hi8 ) ) )
             {
                 uint64_t m = opbits( 16, 5 );
-                if ( 0 == ftype ) // single-precision
-                    tracer.Trace( "fsub s%llu, s%llu, s%llu\n", d, n, m );
-                else if ( 1 == ftype ) // double-precision
-                    tracer.Trace( "fsub d%llu, d%llu, d%llu\n", d, n, m );
-                else
-                    unhandled();
-            }
-            else if ( 0x80 == bits18_10 && bit21 && 0 == rmode ) // SCVTF (scalar, integer)
-            {
-                char t = ( 0 == ftype ) ? 's' : ( 3 == ftype ) ? 'h' : ( 1 == ftype ) ? 'd' : '?';
-                tracer.Trace( "scvtf %c%llu, %s\n", t, d, reg_or_zr( n, sf ) );
-            }
-            else if ( 0x70 == bits18_10 && bit21 && 0 == rmode ) // fsqrt s#, s#
-            {
-                char t = ( 0 == ftype ) ? 's' : ( 3 == ftype ) ? 'h' : ( 1 == ftype ) ? 'd' : '?';
-                tracer.Trace( "fsqrt %c%llu, %c%llu\n", t, d, t, n );
+                tracer.Trace( "extr %s, %s, %s, #%llu\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ), imms );
             }
-            else if ( bit21 && ( 3 == ( 3 & bits18_10 ) ) ) // fcsel
+            else
             {
-                char t = ( 0 == ftype ) ? 's' : ( 3 == ftype ) ? 'h' : ( 1 == ftype ) ? 'd' : '?';
-                uint64_t m = opbits( 16, 5 );
-                uint64_t cond = opbits( 12, 4 );
-                tracer.Trace( "fcsel %c%llu, %c%llu, %c%llu, %s\n", t, d, t, n, t, m, get_cond( cond ) );
+                uint64_t immr = opbits( 16, 6 );
+                const char * ins = ( 0x13 == hi8 || 0x93 == hi8 ) ? "sbfm" : ( 0x33 == hi8 || 0xb3 == hi8) ? "bfm" : "ubfm";
+                tracer.Trace( "%s %s, %s, #%llu, #%llu\n", ins, reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), immr, imms );
             }
-            else if ( bit21 && ( 0x50 == bits18_10 ) ) // fneg (scalar)
-            {
-                char t = ( 0 == ftype ) ? 's' : ( 3 == ftype ) ? 'h' : ( 1 == ftype ) ? 'd' : '?';
-                tracer.Trace( "fneg %c%llu, %c%llu\n", t, d, t, n );
+            break;
+        }
+        case 0x0a: // AND <Wd>, <Wn>, <Wm>{, <shift> #<amount>}     ;    BIC <Wd>, <Wn>, <Wm>{, <shift> #<amount>}
+        case 0x6a: // ANDS <Wd>, <Wn>, <Wm>{, <shift> #<amount>}    ;    BICS <Wd>, <Wn>, <Wm>{, <shift> #<amount>}
+        case 0x8a: // AND <Xd>, <Xn>, <Xm>{, <shift> #<amount>}     ;    BIC <Xd>, <Xn>, <Xm>{, <shift> #<amount>}
+        case 0xea: // ANDS <Xd>, <Xn>, <Xm>{, <shift> #<amount>}    ;    BICS <Xd>, <Xn>, <Xm>{, <shift> #<amount>}
+        {
+            uint64_t shift = opbits( 22, 2 );
+            uint64_t N = opbit( 21 );
+            uint64_t m = opbits( 16, 5 );
+            uint64_t imm6 = opbits( 10, 6 );
+            uint64_t n = opbits( 5, 5 );
+            uint64_t d = opbits( 0, 5 );
+            bool set_flags = ( 0x60 == ( hi8 & 0x60 ) );
+            bool xregs = ( 0 != ( hi8 & 0x80 ) );
+            tracer.Trace( "%s%s %s, %s, %s, %s, #%llu\n", N ? "bic" : "and", set_flags ? "s" : "",
+                          reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ), shift_type( shift ), imm6 );
+            break;
+        }
+        case 0x10: case 0x30: case 0x50: case 0x70: // ADR <Xd>, <label>
+        {
+            uint64_t d = opbits( 0, 5 );
+            uint64_t immhi = opbits( 5, 19 );
+            uint64_t immlo = opbits( 29, 2 );
+            int64_t offset = sign_extend( immhi << 2 | immlo, 20 );
+            tracer.Trace( "adr x%llu, %#llx\n", d, pc + offset );
+            break;
+        }
+        case 0x90: case 0xb0: case 0xd0: case 0xf0: // adrp rd, immediate
+        {
+            uint64_t d = ( op & 0x1f );
+            int64_t imm = ( ( op >> 3 ) & 0x1ffffc );  // 19 bits with bottom two bits 0 at the bottom
+            imm |= opbits( 29, 2 );               // two low bits
+            imm = sign_extend( imm, 20 );
+            imm <<= 12;
+            imm += ( pc & ( ~0xfff ) );
+            tracer.Trace( "adrp x%llu, %#llx\n", d, imm );
+            break;
+        }
+        case 0x36: // TBZ <R><t>, #<imm>, <label>
+        case 0x37: // TBNZ <R><t>, #<imm>, <label>
+        case 0xb6: // TBZ <R><t>, #<imm>, <label> where high bit is prepended to b40 bit selector for 6 bits total
+        case 0xb7: // TBNZ <R><t>, #<imm>, <label> where high bit is prepended to b40 bit selector for 6 bits total
+        {
+            uint64_t b40 = opbits( 19, 5 );
+            if ( 0 != ( 0x80 & hi8 ) )
+                b40 |= 0x20;
+            int64_t imm14 = (int64_t) sign_extend( ( opbits( 5, 14 ) << 2 ), 15 ) + pc;
+            uint64_t t = opbits( 0, 5 );
+            tracer.Trace( "tb%sz x%llu, #%llu, %#llx\n", ( hi8 & 1 ) ? "n" : "", t, b40, imm14 );
+            break;
+        }
+        case 0x12: // MOVN <Wd>, #<imm>{, LSL #<shift>}   ;    AND <Wd|WSP>, <Wn>, #<imm>
+        case 0x92: // MOVN <Xd>, #<imm16>, LSL #<shift>   ;    AND <Xd|SP>, <Xn>, #<imm>    ;    MOV <Xd>, #<imm>
+        {
+            uint64_t bit23 = opbit( 23 );
+            bool xregs = ( 0 != ( hi8 & 0x80 ) );
+            if ( bit23 ) // MOVN
+            {
+                uint64_t d = opbits( 0, 5 );
+                uint64_t imm16 = opbits( 5, 16 );
+                uint64_t hw = opbits( 21, 2 );
+                hw *= 16;
+                imm16 <<= hw;
+                imm16 = ~imm16;
+                char width = 'x';
+
+                if ( 0x12 == hi8 )
+                {
+                    if ( hw > 16 )
+                        unhandled();
+                    imm16 = (uint32_t) imm16;
+                    width = 'w';
+                }
+
+                tracer.Trace( "movn %c%llu, %lld\n", width, d, imm16 );
             }
-            else if ( bit21 && 0 == bits18_10 && 3 == rmode ) // fcvtzs
+            else // AND
             {
-                char t = ( 0 == ftype ) ? 's' : ( 3 == ftype ) ? 'h' : ( 1 == ftype ) ? 'd' : '?';
-                tracer.Trace( "fcvtzs %s, %c%llu\n", reg_or_zr( d, sf ), t, n );
+                uint64_t N_immr_imms = opbits( 10, 13 );
+                uint64_t n = opbits( 5, 5 );
+                uint64_t d = opbits( 0, 5 );
+                uint64_t op2 = decode_logical_immediate( N_immr_imms, xregs ? 64 : 32 );
+                tracer.Trace( "and %s, %s, #%#llx\n", reg_or_sp( d, xregs ), reg_or_zr( n, xregs ), op2 );
             }
-            else if ( bit21 && ( 1 == ( bits18_10 & 3 ) ) && ( 0 == opbit( 4 ) ) ) // fccmp
+            break;
+        }
+        case 0x1a: // CSEL <Wd>, <Wn>, <Wm>, <cond>    ;    SDIV <Wd>, <Wn>, <Wm>    ;    UDIV <Wd>, <Wn>, <Wm>    ;    CSINC <Wd>, <Wn>, <Wm>, <cond>
+                   // LSRV <Wd>, <Wn>, <Wm>            ;    LSLV <Wd>, <Wn>, <Wm>    ;    ADC <Wd>, <Wn>, <Wm>     ;    ASRV <Wd>, <Wn>, <Wm>
+                   // RORV <Wd>, <Wn>, <Wm>
+        case 0x9a: // CSEL <Xd>, <Xn>, <Xm>, <cond>    ;    SDIV <Xd>, <Xn>, <Xm>    ;    UDIV <Xd>, <Xn>, <Xm>    ;    CSINC <Xd>, <Xn>, <Xm>, <cond>
+                   // LSRV <Xd>, <Xn>, <Xm>            ;    LSLV <Xd>, <Xn>, <Xm>    ;    ADC <Xd>, <Xn>, <Xm>     ;    ASRV <Xd>, <Xn>, <Xm>
+                   // RORV <Xd>, <Xn>, <Xm>
+        {
+            bool xregs = ( 0 != ( hi8 & 0x80 ) );
+            uint64_t bits11_10 = opbits( 10, 2 );
+            uint64_t d = opbits( 0, 5 );
+            uint64_t n = opbits( 5, 5 );
+            uint64_t m = opbits( 16, 5 );
+            uint64_t bits15_12 = opbits( 12, 4 );
+            uint64_t bits23_21 = opbits( 21, 3 );
+
+            if ( 0 == bits11_10 && 4 == bits23_21 ) // CSEL
             {
-                char t = ( 0 == ftype ) ? 's' : ( 3 == ftype ) ? 'h' : ( 1 == ftype ) ? 'd' : '?';
-                uint64_t m = opbits( 16, 5 );
                 uint64_t cond = opbits( 12, 4 );
-                uint64_t nzcv = opbits( 0, 4 );
-                tracer.Trace( "fccmp %c%llu, %c%llu, #%#llx, %s\n", t, n, t, m, nzcv, get_cond( cond ) );
+                tracer.Trace( "csel %s, %s, %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ), get_cond( cond ) );
             }
-            else if ( bit21 && ( 0xc0 == ( 0x1c0 & bits18_10 ) ) && 0 == rmode ) // UCVTF <Hd>, <Wn>, #<fbits>
+            else if ( 1 == bits11_10 && 4 == bits23_21 ) // CSINC <Xd>, XZR, XZR, <cond>
             {
-                char t = ( 0 == ftype ) ? 's' : ( 3 == ftype ) ? 'h' : ( 1 == ftype ) ? 'd' : '?';
-                uint64_t scale = opbits( 10, 6 );
-                uint64_t fbits = 64 - scale;
-                tracer.Trace( "ucvtf %c%llu, %s, #%#llx\n", t, d, reg_or_zr( n, sf ), fbits );
+                uint64_t cond = opbits( 12, 4 );
+                tracer.Trace( "csinc %s, %s, %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ), get_cond( cond ) );
             }
-            else
+            else if ( 2 == bits11_10 && 6 == bits23_21 && 2 == bits15_12 ) // ASRV <Xd>, <Xn>, <Xm>
+                tracer.Trace( "asrv %s, %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ) );
+            else if ( 6 == bits23_21 && 4 == ( bits15_12 & 0xe ) ) // CRC32{C}B/H/W/X
             {
-                tracer.Trace( "ftype %llu, bit21 %llu, rmode %llu, bits18_10 %#llx\n", ftype, bit21, rmode, bits18_10 );
-                unhandled();
+                static const char sizes[] = "bhwx";
+                tracer.Trace( "crc32%s%c %s, %s, %s\n", ( bits15_12 & 1 ) ? "c" : "", sizes[ bits11_10 ], reg_or_zr( d, false ),
+                              reg_or_zr( n, false ), reg_or_zr( m, xregs ) );
             }
+            else if ( 2 == bits11_10 && 6 == bits23_21 && 0 == bits15_12 ) // UDIV <Xd>, <Xn>, <Xm>
+                tracer.Trace( "udiv %s, %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ) );
+            else if ( 3 == bits11_10 && 6 == bits23_21 && 0 == bits15_12 ) // SDIV <Xd>, <Xn>, <Xm>
+                tracer.Trace( "sdiv %s, %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ) );
+            else if ( 1 == bits11_10 && 6 == bits23_21 && 2 == bits15_12 ) // lsrv
+                tracer.Trace( "lsrv %s, %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ) );
+            else if ( 0 == bits11_10 && 6 == bits23_21 && 2 == bits15_12 ) // lslv
+                tracer.Trace( "lslv %s, %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ) );
+            else if ( 0 == bits11_10 && 0 == bits23_21 && 0 == bits15_12 && 0 == bits11_10 ) // addc
+                tracer.Trace( "addc %s, %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ) );
+            else if ( 3 == bits11_10 && 6 == bits23_21 && 2 == bits15_12 ) // RORV <Xd>, <Xn>, <Xm>
+                tracer.Trace( "rorv %s, %s, %s\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), reg_or_zr( m, xregs ) );
+            else
+                unhandled();
             break;
         }
-        case 0x0c:
-        case 0x4c: // LD1 { <Vt>.<T> }, [<Xn|SP>]    ;    LD2 { <Vt>.<T>, <Vt2>.<T> }, [<Xn|SP>]
-                   // ST2 { <Vt>.<T>, <Vt2>.<T> }, [<Xn|SP>]    ;    ST2 { <Vt>.<T>, <Vt2>.<T> }, [<Xn|SP>], <imm>    ;    ST2 { <Vt>.<T>, <Vt2>.<T> }, [<Xn|SP>], <Xm>
-                   // LD3 { <Vt>.<T>, <Vt2>.<T>, <Vt3>.<T> }, [<Xn|SP>]
-                   // LD3 { <Vt>.<T>, <Vt2>.<T>, <Vt3>.<T> }, [<Xn|SP>], <imm>
-                   // LD3 { <Vt>.<T>, <Vt2>.<T>, <Vt3>.<T> }, [<Xn|SP>], <Xm>
-                   // LD4 { <Vt>.<T>, <Vt2>.<T>, <Vt3>.<T>, <Vt4>.<T> }, [<Xn|SP>]
-                   // LD4 { <Vt>.<T>, <Vt2>.<T>, <Vt3>.<T>, <Vt4>.<T> }, [<Xn|SP>], <imm>
-                   // LD4 { <Vt>.<T>, <Vt2>.<T>, <Vt3>.<T>, <Vt4>.<T> }, [<Xn|SP>], <Xm>
+        case 0x52: // MOVZ <Wd>, #<imm>{, LSL #<shift>}    ;    EOR <Wd|WSP>, <Wn>, #<imm>
+        case 0xd2: // MOVZ <Xd>, #<imm>{, LSL #<shift>}    ;    EOR <Xd|SP>, <Xn>, #<imm>
         {
-            uint64_t Q = opbit( 30 );
-            uint64_t L = opbit( 22 ); // load vs. store
-            const char * pname = L ? "ld" : "st";
-            uint64_t post_index = opbit( 23 );
-            uint64_t opcode = opbits( 12, 4 );
-            uint64_t size = opbits( 10, 2 );
-            uint64_t bits23_21 = opbits( 21, 3 );
-            uint64_t m = opbits( 16, 5 );
-            uint64_t n = opbits( 5, 5 );
-            uint64_t t = opbits( 0, 5 );
-
-            if ( 2 != bits23_21 && 6 != bits23_21 && 0 != bits23_21 && 4 != bits23_21 )
-                unhandled();
+            bool xregs = ( 0 != ( hi8 & 0x80 ) );
+            uint64_t bit23 = opbit( 23 );
 
-            if ( ( 2 & opcode ) || 8 == opcode || 4 == opcode || 0 == opcode ) // LD1 / LD2 / LD3 / LD4 / ST1 / ST2 / ST3 / ST4
+            if ( bit23 ) // movz xd, imm16
             {
-                uint64_t t2 = ( t + 1 ) % 32;
-                if ( post_index )
-                {
-                    if ( 31 == m )
-                    {
-                        const char * pT = get_ld1_vector_T( size, Q );
-                        if ( 7 == opcode ) // LD1 { <Vt>.<T> }, [<Xn|SP>], <imm>
-                            tracer.Trace( "%s1 {v%llu.%s}, [%s], #%llu\n", pname, t, pT, reg_or_sp( n, true ), Q ? 16ull : 8ull );
-                        else if ( 8 == opcode ) // LD2 { <Vt>.<T>, <Vt2>.<T> }, [<Xn|SP>], <imm>
-                            tracer.Trace( "%s2 {v%llu.%s, v%llu.%s}, [%s], #%llu\n", pname, t, pT, t2, pT, reg_or_sp( n, true ), Q ? 32llu : 16llu );
-                        else if ( 3 == opcode ) // LD3 { <Vt>.<T>, <Vt2>.<T>, <Vt3>.<T>, <Vt4>.<T> }, [<Xn|SP>], <imm>
-                            tracer.Trace( "%s3 {v%llu.%s-v%llu.%s}, [%s], #%llu\n", pname, t, pT, ( t + 2 ) % 32, pT, reg_or_sp( n, true ), Q ? 64llu : 32llu );
-                        else if ( 0 == opcode ) // LD4 { <Vt>.<T>, <Vt2>.<T>, <Vt3>.<T>, <Vt4>.<T> }, [<Xn|SP>], <imm>
-                            tracer.Trace( "%s4 {v%llu.%s-v%llu.%s}, [%s], #%llu\n", pname, t, pT, ( t + 3 ) % 32, pT, reg_or_sp( n, true ), Q ? 64llu : 32llu );
-                        else
-                            unhandled();
-                    }
-                    else
-                        unhandled();
-                }
-                else // no offset
-                {
-                    if ( 0 == m )
-                    {
-                        const char * pT = get_ld1_vector_T( size, Q );
-                        if ( 7 == opcode ) // LD1 { <Vt>.<T> }, [<Xn|SP>]
-                            tracer.Trace( "%s1 {v%llu.%s}, [%s]\n", pname, t, pT, reg_or_sp( n, true ) );
-                        else if ( 10 == opcode ) // LD1 { <Vt>.<T>, <Vt2>.<T> }, [<Xn|SP>]
-                            tracer.Trace( "%s1 {v%llu.%s}, {v%llu.%s}, [%s]\n", pname, t, pT, t2, pT, reg_or_sp( n, true ) );
-                        else if ( 8 == opcode ) // LD2 { <Vt>.<T>, <Vt2>.<T> }, [<Xn|SP>]
-                            tracer.Trace( "%s2 { v%llu.%s, %llu.%s }, [%s]\n", pname, t, pT, t2, pT, reg_or_sp( n, true ) );
-                        else if ( 4 == opcode ) // LD3 { <Vt>.<T>, <Vt2>.<T> }, [<Xn|SP>]
-                            tracer.Trace( "%s3 { v%llu.%s-v%llu.%s }, [%s]\n", pname, t, pT, ( t + 2 ) % 32, pT, reg_or_sp( n, true ) );
-                        else if ( 0 == opcode || 2 == opcode ) // LD4 { <Vt>.<T>-<Vtn>.<T> }, [<Xn|SP>]
-                            tracer.Trace( "%s4 { v%llu.%s-v%llu.%s }, [%s]\n", pname, t, pT, ( t + 3 ) % 32, pT, reg_or_sp( n, true ) );
-                        else
-                            unhandled();
-                    }
-                    else
-                        unhandled();
-                }
+                uint64_t d = opbits( 0, 5 );
+                uint64_t imm16 = opbits( 5, 16 );
+                uint64_t hw = opbits( 21, 2 );
+                tracer.Trace( "movz %s, %#llx, LSL #%llu\n", reg_or_zr( d, xregs ), imm16, hw * 16 );
             }
-            else if ( 0 == opcode && 0 == opbits( 12, 9 ) ) // LD4 multiple structures
+            else // EOR
             {
-                if ( 2 == bits23_21 ) // no offset LD4 { <Vt>.<T>, <Vt2>.<T>, <Vt3>.<T>, <Vt4>.<T> }, [<Xn|SP>]
-                {
-                    const char * pT = get_ld1_vector_T( size, Q );
-                    tracer.Trace( "ld4 {v%llu.%s-v%llu.%s}, [%s]\n", t, pT, ( t + 3 ) % 32, pT, reg_or_sp( n , true ) );
-                }
-                else if ( 6 == bits23_21 ) // post-index
-                    unhandled();
-                else
-                    unhandled();
+                uint64_t N_immr_imms = opbits( 10, 13 );
+                uint64_t op2 = decode_logical_immediate( N_immr_imms, xregs ? 64 : 32 );
+                uint64_t n = opbits( 5, 5 );
+                uint64_t d = opbits( 0, 5 );
+                tracer.Trace( "eor %s, %s, #%#llx\n", reg_or_sp( d, xregs ), reg_or_sp( n, xregs ), op2 );
             }
-            else
-                unhandled();
             break;
         }
-        case 0x88: // LDAXR <Wt>, [<Xn|SP>{, #0}]    ;    LDXR <Wt>, [<Xn|SP>{, #0}]    ;    STXR <Ws>, <Wt>, [<Xn|SP>{, #0}]    ;    STLXR <Ws>, <Wt>, [<Xn|SP>{, #0}]
-                   //                                                                        STLR <Wt>, [<Xn|SP>{, #0}]          ;    STLR <Wt>, [<Xn|SP>, #-4]!
-        case 0xc8: // LDAXR <Xt>, [<Xn|SP>{, #0}]    ;    LDXR <Xt>, [<Xn|SP>{, #0}]    ;    STXR <Ws>, <Xt>, [<Xn|SP>{, #0}]    ;    STLXR <Ws>, <Xt>, [<Xn|SP>{, #0}]
-                   //                                                                        STLR <Xt>, [<Xn|SP>{, #0}]          ;    STLR <Xt>, [<Xn|SP>, #-8]!
+        case 0x34: case 0xb4: // CBZ <Xt>, <label>     ;    CBZ <WXt>, <label>
+        case 0x35: case 0xb5: // CBNZ <Xt>, <label>    ;    CBNZ <Wt>, <label>
         {
+            bool xregs = ( 0 != ( hi8 & 0x80 ) );
             uint64_t t = opbits( 0, 5 );
-            uint64_t n = opbits( 5, 5 );
-            uint64_t t2 = opbits( 10, 5 );
-            uint64_t s = opbits( 16, 5 );
-            uint64_t L = opbits( 21, 2 );
-            uint64_t oO = opbit( 15 );
+            bool zero_check = ( 0 == ( hi8 & 1 ) );
+            int64_t imm19 = ( ( op >> 3 ) & 0x1ffffc ); // two low bits are 0
+            imm19 = sign_extend( imm19, 20 );
+            tracer.Trace( "cb%sz %s, %#llx\n", zero_check ? "" : "n", reg_or_zr( t, xregs ), pc + imm19 );
+            break;
+        }
+        case 0xd4: // svc
+        {
             uint64_t bit23 = opbit( 23 );
-            uint64_t bit30 = opbit( 30 );
+            uint64_t hw = opbits( 21, 2 );
+
+            if ( !bit23 && ( 0 == hw ) )
+            {
+                uint64_t imm16 = opbits( 5, 16 );
+                uint64_t op2 = opbits( 2, 3 );
+                uint64_t ll = opbits( 0, 2 );
+                if ( ( 0 == op2 ) && ( 1 == ll ) ) // svc imm16 supervisor call
+                    tracer.Trace( "svc %#llx\n", imm16 );
+                else
+                    unhandled();
+            }
+            break;
+        }
+        case 0x2e: case 0x6e: // CMEQ <Vd>.<T>, <Vn>.<T>, <Vm>.<T>    ;    CMHS <Vd>.<T>, <Vn>.<T>, <Vm>.<T>    ;    UMAXP <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+                              // BIT <Vd>.<T>, <Vn>.<T>, <Vm>.<T>     ;    UMINP <Vd>.<T>, <Vn>.<T>, <Vm>.<T>   ;    BIF <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+                              // EOR <Vd>.<T>, <Vn>.<T>, <Vm>.<T>     ;    SUB <Vd>.<T>, <Vn>.<T>, <Vm>.<T>     ;    UMULL{2} <Vd>.<Ta>, <Vn>.<Tb>, <Vm>.<Tb>
+                              // MLS <Vd>.<T>, <Vn>.<T>, <Vm>.<Ts>[<index>] ;  BSL <Vd>.<T>, <Vn>.<T>, <Vm>.<T> ;    FMUL <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+                              // EXT <Vd>.<T>, <Vn>.<T>, <Vm>.<T>, #<index> ;  INS <Vd>.<Ts>[<index1>], <Vn>.<Ts>[<index2>]  ;    UADDLV <V><d>, <Vn>.<T>
+                              // USHL <Vd>.<T>, <Vn>.<T>, <Vm>.<T>    ;    FADDP <Vd>.<T>, <Vn>.<T>, <Vm>.<T>   ;    FNEG <Vd>.<T>, <Vn>.<T>
+                              // CMHI <Vd>.<T>, <Vn>.<T>, <Vm>.<T>    ;    UADDW{2} <Vd>.<Ta>, <Vn>.<Ta>, <Vm>.<Tb>  ;   FDIV <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+                              // UMAXV <V><d>, <Vn>.<T> ; UMINV <V><d>, <Vn>.<T>    ;    UMAX <Vd>.<T>, <Vn>.<T>, <Vm>.<T>    ;    UMIN <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+                              // FMINNMV S<d>, <Vn>.4S  ; FMAXNMV S<d>, <Vn>.4S     ;    MLS <Vd>.<T>, <Vn>.<T>, <Vm>.<T>     ;    UCVTF <Vd>.<T>, <Vn>.<T>
+                              // NEG <Vd>.<T>, <Vn>.<T> ; EXT <Vd>.<T>, <Vn>.<T>, <Vm>.<T>, #<index>            ;    FCVTZU <Vd>.<T>, <Vn>.<T>
+                              // UMLAL{2} <Vd>.<Ta>, <Vn>.<Tb>, <Vm>.<Tb>           ;    USUBW{2} <Vd>.<Ta>, <Vn>.<Ta>, <Vm>.<Tb>
+                              // UADDL{2} <Vd>.<Ta>, <Vn>.<Tb>, <Vm>.<Tb>           ;    USUBL{2} <Vd>.<Ta>, <Vn>.<Tb>, <Vm>.<Tb>
+                              // FSQRT <Vd>.<T>, <Vn>.<T>             ;    UMLSL{2} <Vd>.<Ta>, <Vn>.<Tb>, <Vm>.<Tb> ; NOT <Vd>.<T>, <Vn>.<T>
+                              // UADDLP <Vd>.<Ta>, <Vn>.<Tb>          ;    UADALP <Vd>.<Ta>, <Vn>.<Tb>          ;    CMLE <Vd>.<T>, <Vn>.<T>, #0
+                              // UQXTN{2} <Vd>.<Tb>, <Vn>.<Ta>        ;    FCMGT <Vd>.<T>, <Vn>.<T>, <Vm>.<T>   ;    FCMGE <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+                              // CMGE <Vd>.<T>, <Vn>.<T>, #0          ;    REV32 <Vd>.<T>, <Vn>.<T>
+        {
+            uint64_t Q = opbit( 30 );
+            uint64_t m = opbits( 16, 5 );
+            uint64_t n = opbits( 5, 5 );
+            uint64_t d = opbits( 0, 5 );
+            uint64_t size = opbits( 22, 2 );
+            uint64_t bit23 = opbit( 23 );
+            uint64_t bit21 = opbit( 21 );
+            uint64_t bit15 = opbit( 15 );
+            uint64_t bit10 = opbit( 10 );
+            uint64_t bits23_21 = opbits( 21, 3 );
+            const char * pT = get_ld1_vector_T( size, Q );
+            uint64_t opcode = opbits( 10, 6 );
+            uint64_t opcode7 = opbits( 10, 7 );
+            uint64_t bits20_17 = opbits( 17, 4 );
+            uint64_t bits20_16 = opbits( 16, 5 );
+            uint64_t bits16_10 = opbits( 10, 7 );
+            uint64_t bits15_10 = opbits( 10, 6 );
+
+            if ( bit21 && 0 == bits20_16 && 2 == bits15_10 ) // REV32 <Vd>.<T>, <Vn>.<T>
+            {
+                if ( size > 1 )
+                    unhandled();
+                tracer.Trace( "rev32 v%llu.%s, v%llu.%s\n", d, pT, n, pT );
+            }
+            else if ( bit21 && 0 == bits20_17 && 0x22 == bits16_10 ) // CMGE <Vd>.<T>, <Vn>.<T>, #0
+                tracer.Trace( "cmge v%llu.%s, v%llu.%s, #0\n", d, pT, n, pT );
+            else if ( 1 == bits23_21 && 0 == bits20_16 && 0x16 == bits15_10 ) // NOT <Vd>.<T>, <Vn>.<T>. AKA MVN
+            {
+                pT = Q ? "16b" : "8b";
+                tracer.Trace( "not v%llu.%s, v%llu.%s # aka mvn\n", d, pT, n, pT );
+            }
+            else if ( !bit23 && bit21 && 0x39 == bits15_10 ) // FCMGE <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+            {
+                uint64_t sz = opbit( 22 );
+                pT = sz ? Q ? "2d" : "reserved" : Q ? "4s" : "2s";
+                tracer.Trace( "fcmge v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
+            }
+            else if ( bit23 && bit21 && 0x39 == bits15_10 ) // FCMGT <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+            {
+                uint64_t sz = opbit( 22 );
+                pT = sz ? Q ? "2d" : "reserved" : Q ? "4s" : "2s";
+                tracer.Trace( "fcmgt v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
+            }
+            else if ( bit21 && 1 == bits20_16 && 0x12 == bits15_10 ) // UQXTN{2} <Vd>.<Tb>, <Vn>.<Ta>
+            {
+                const char * pTA = get_saddlp_vector_T( size, 1 );
+                const char * pTB = get_ld1_vector_T( size, Q );
+                tracer.Trace( "uqxtn%s v%llu.%s, v%llu.%s\n", Q ? "2" : "", d, pTB, n, pTA );
+            }
+            else if ( bit21 && 0 == bits20_17 && 0x26 == bits16_10 ) // CMLE <Vd>.<T>, <Vn>.<T>, #0
+                tracer.Trace( "cmle v%llu.%s, v%llu.%s, #0\n", d, pT, n, pT );
+            else if ( bit21 && 0 == bits20_17 && 0x1a == bits16_10 ) // UADALP <Vd>.<Ta>, <Vn>.<Tb>
+            {
+                const char * pTA = get_saddlp_vector_T( size, Q );
+                const char * pTB = get_ld1_vector_T( size, Q );
+                tracer.Trace( "uadalp v%llu.%s, v%llu.%s\n", d, pTA, n, pTB );
+            }
+            else if ( bit21 && 0 == bits20_17 && 0xa == bits16_10 ) // UADDLP <Vd>.<Ta>, <Vn>.<Tb>
+            {
+                const char * pTA = get_saddlp_vector_T( size, Q );
+                const char * pTB = get_ld1_vector_T( size, Q );
+                tracer.Trace( "uaddlp v%llu.%s, v%llu.%s\n", d, pTA, n, pTB );
+            }
+            else if ( bit23 && bit21 && 0 == bits20_17 && 0x7e == bits16_10 ) // FSQRT <Vd>.<T>, <Vn>.<T>
+            {
+                uint64_t sz = opbit( 22 );
+                const char * pTA = sz ? Q ? "2d" : "reserved" : Q ? "4s" : "2s";
+                tracer.Trace( "fsqrt v%llu.%s, v%llu.%s\n", d, pTA, n, pTA );
+            }
+            else if ( bit21 && 8 == bits15_10 ) // USUBL{2} <Vd>.<Ta>, <Vn>.<Tb>, <Vm>.<Tb>
+            {
+                const char * pTA = ( 0 == size ) ? "8h" : ( 1 == size ) ? "4s" : ( 2 == size ) ? "2d" : "reserved";
+                tracer.Trace( "uasub%s v%llu.%s, v%llu.%s, v%llu.%s\n", Q ? "2" : "", d, pTA, n, pT, m, pT );
+            }
+            else if ( bit21 && 0 == bits15_10 ) // UADDL{2} <Vd>.<Ta>, <Vn>.<Tb>, <Vm>.<Tb>
+            {
+                const char * pTA = ( 0 == size ) ? "8h" : ( 1 == size ) ? "4s" : ( 2 == size ) ? "2d" : "reserved";
+                tracer.Trace( "uaddl%s v%llu.%s, v%llu.%s, v%llu.%s\n", Q ? "2" : "", d, pTA, n, pT, m, pT );
+            }
+            else if ( bit21 && 0xc == bits15_10 ) // USUBW{2} <Vd>.<Ta>, <Vn>.<Ta>, <Vm>.<Tb>
+            {
+                const char * pTA = ( 0 == size ) ? "8h" : ( 1 == size ) ? "4s" : ( 2 == size ) ? "2d" : "reserved";
+                tracer.Trace( "usubw%s v%llu.%s, v%llu.%s, v%llu.%s\n", Q ? "2" : "", d, pTA, n, pTA, m, pT );
+            }
+            else if ( bit21 && 0x20 == bits15_10 ) // UMLAL{2} <Vd>.<Ta>, <Vn>.<Tb>, <Vm>.<Tb>
+            {
+                const char * pTA = ( 0 == size ) ? "8h" : ( 1 == size ) ? "4s" : ( 2 == size ) ? "2d" : "reserved";
+                tracer.Trace( "umlal%s v%llu.%s, v%llu.%s, v%llu.%s\n", Q ? "2" : "", d, pTA, n, pT, m, pT );
+            }
+            else if ( bit21 && 0x28 == bits15_10 ) // UMLSL{2} <Vd>.<Ta>, <Vn>.<Tb>, <Vm>.<Tb>
+            {
+                const char * pTA = ( 0 == size ) ? "8h" : ( 1 == size ) ? "4s" : ( 2 == size ) ? "2d" : "reserved";
+                tracer.Trace( "umlsl%s v%llu.%s, v%llu.%s, v%llu.%s\n", Q ? "2" : "", d, pTA, n, pT, m, pT );
+            }
+            else if ( !bit23 && bit21 && 0 == bits20_17 && 0x76 == bits16_10 ) // UCVTF <Vd>.<T>, <Vn>.<T>
+            {
+                uint64_t sz = opbit( 22 );
+                const char * pTA = sz ? Q ? "2d" : "reserved" : Q ? "4s" : "2s";
+                tracer.Trace( "ucvtf v%llu.%s, v%llu.%s\n", d, pTA, n, pTA );
+            }
+            else if ( bit23 && bit21 && 0 == bits20_17 && 0x6e == bits16_10 ) // FCVTZU <Vd>.<T>, <Vn>.<T>
+            {
+                uint64_t sz = opbit( 22 );
+                const char * pTA = sz ? Q ? "2d" : "reserved" : Q ? "4s" : "2s";
+                tracer.Trace( "fcvtzu v%llu.%s, v%llu.%s\n", d, pTA, n, pTA );
+            }
+            else if ( 0 == bits23_21 && !bit15 && !bit10 ) // EXT <Vd>.<T>, <Vn>.<T>, <Vm>.<T>, #<index>
+            {
+                uint64_t imm4 = opbits( 11, 4 );
+                const char * pTA = Q ? "16b" : "8b";
+                tracer.Trace( "ext v%llu.%s, v%llu.%s, v%llu.%s, #%llu\n", d, pTA, n, pTA, m, pTA, imm4 );
+            }
+            else if ( bit21 && 0 == bits20_17 && 0x2e == bits16_10 ) // NEG <Vd>.<T>, <Vn>.<T>
+                tracer.Trace( "neg v%llu.%s, v%llu.%s\n", d, pT, n, pT );
+            else if ( bit21 && 0x25 == bits15_10 ) // MLS <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+                tracer.Trace( "mls v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
+            else if ( 0x6e == hi8 && ( 5 == bits23_21 || 1 == bits23_21 ) && 8 == bits20_17 && 0x32 == bits16_10 ) // FMINNMV S<d>, <Vn>.4S    ;    FMAXNMV S<d>, <Vn>.4S
+                tracer.Trace( "%s s%llu, v%llu.4s\n", 5 == bits23_21 ? "fminnmv" : "fmaxnmv", d, n );
+            else if ( !bit23 && bit21 && 0x3f == bits15_10 ) // FDIV <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+            {
+                uint64_t sz = opbit( 22 );
+                pT = ( !sz && !Q ) ? "2s" : ( !sz && Q ) ? "4s" : ( sz && Q ) ? "2d" : "?";
+                tracer.Trace( "v%llu.%s, v%llu.%s, v%llu.%s\n", n, pT, n, pT, m, pT );
+            }
+            else if ( bit21 && ( 0x1b == bits15_10 || 0x19 == bits15_10 ) ) // UMIN <Vd>.<T>, <Vn>.<T>, <Vm>.<T>    ;    UMAX <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+                tracer.Trace( "%s v%llu.%s, v%llu.%s, %llu.%s\n", ( 0x1b == bits15_10 ) ? "umin" : "umax", d, pT, n, pT, m, pT );
+            else if ( bit21 && 8 == bits20_17 && ( 0x6a == bits16_10 || 0x2a == bits16_10 ) ) // UMINV <V><d>, <Vn>.<T>    ;    UMAXV <V><d>, <Vn>.<T>
+            {
+                char v = ( 0 == size ) ? 'b' : ( 1 == size ) ? 'h' : ( 2 == size ) ? 's' : '?';
+                tracer.Trace( "%s %c%llu, v%llu.%s\n", ( 0x6a == bits16_10 ) ? "uminv" : "unaxv", v, d, n, pT );
+            }
+            else if ( bit21 && 4 == bits15_10 ) // UADDW{2} <Vd>.<Ta>, <Vn>.<Ta>, <Vm>.<Tb>
+            {
+                const char * pTA = ( 0 == size ) ? "8h" : ( 1 == size ) ? "4s" : ( 2 == size ) ? "2d" : "?";
+                const char * pTB = get_ld1_vector_T( size, Q );
+                tracer.Trace( "uaddw%s, v%llu.%s, v%llu.%s, v%llu.%s\n", Q ? "2" : "", d, pTA, n, pTA, m, pTB );
+            }
+            else if ( bit23 && bit21 && 0 == bits20_17 && 0x3e == bits16_10 ) // FNEG <Vd>.<T>, <Vn>.<T>
+            {
+                uint64_t sz = opbit( 22 );
+                uint64_t ty = ( sz << 1 ) | Q;
+                pT = ( 0 == ty ) ? "2s" : ( 1 == ty ) ? "4s" : ( 3 == ty ) ? "2d" : "?";
+                tracer.Trace( "fneg v%llu.%s, v%llu.%s\n", d, pT, n, pT );
+            }
+            else if ( !bit23 && bit21 && 0x35 == opcode ) // FADDP <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+            {
+                uint64_t sz = opbit( 22 );
+                uint64_t ty = ( sz << 1 ) | Q;
+                pT = ( 0 == ty ) ? "2s" : ( 1 == ty ) ? "4s" : ( 3 == ty ) ? "2d" : "?";
+                tracer.Trace( "faddp v%llu.%s, v%llu,%s, v%llu.%s\n", d, pT, n, pT, m, pT );
+            }
+            else if ( bit21 && 0x11 == opcode ) // USHL <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+                tracer.Trace( "ushl, v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
+            else if ( bit21 && 8 == bits20_17 && 0xe == opcode7 ) // UADDLV <V><d>, <Vn>.<T>
+                tracer.Trace( "uaddlv v%llu, v%llu.%s\n", d, n, pT );
+            else if ( 0x6e == hi8 && 0 == bits23_21 && !bit15 && bit10 ) // INS <Vd>.<Ts>[<index>], <R><n>
+            {
+                uint64_t imm5 = opbits( 16, 5 );
+                uint64_t imm4 = opbits( 11, 5 );
+                uint64_t index1 = 0;
+                uint64_t index2 = 0;
+                char T = '?';
+                if ( 1 & imm5 )
+                {
+                    index1 = get_bits( imm5, 1, 4 );
+                    index2 = imm4;
+                    T = 'B';
+                }
+                else if ( 2 & imm5 )
+                {
+                    index1 = get_bits( imm5, 2, 3 );
+                    index2 = get_bits( imm4, 1, 3 );
+                    T = 'H';
+                }
+                else if ( 4 & imm5 )
+                {
+                    index1 = get_bits( imm5, 3, 2 );
+                    index2 = get_bits( imm4, 2, 2 );
+                    T = 'S';
+                }
+                else if ( 8 & imm5 )
+                {
+                    index1 = get_bit( imm5, 4 );
+                    index2 = get_bit( imm4, 3 );
+                    T = 'D';
+                }
+
+                tracer.Trace( "ins v%llu.%c[%llu], v%llu.%c[%llu]\n", d, T, index1, n, T, index2 );
+            }
+            else if ( bit21 && 0x0d == opcode )
+                tracer.Trace( "cmhi v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
+            else if ( bit21 && 0x23 == opcode )
+                tracer.Trace( "cmeq v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
+            else if ( bit21 && 0x0f == opcode )
+                tracer.Trace( "cmhs v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
+            else if ( bit21 && 0x29 == opcode )
+                tracer.Trace( "umaxp v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
+            else if ( bit21 && 0x2b == opcode )
+                tracer.Trace( "uminp v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
+            else if ( bit21 && 0x07 == opcode )
+            {
+                uint64_t opc2 = opbits( 22, 2 );
+                pT = ( 0 == Q ) ? "8B" : "16B";
+                tracer.Trace( "%s v%llu.%s, v%llu.%s, v%llu.%s\n", ( 1 == opc2 ) ? "bsl" : ( 2 == opc2) ? "bit" : ( 3 == opc2 ) ? "bif" : "eor", d, pT, n, pT, m, pT );
+            }
+            else if ( bit21 && 0x21 == opcode )
+                tracer.Trace( "sub v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
+            else if ( bit21 && 0x30 == opcode )
+            {
+                const char * pTA = ( 0 == size ) ? "8h" : ( 1 == size ) ? "4s" : ( 2 == size ) ? "2d" : "?";
+                const char * pTB = get_ld1_vector_T( size, Q );
+                tracer.Trace( "umull%s v%llu.%s, v%llu.%s, v%llu.%s\n", Q ? "2" : "", d, pTA, n, pTB, m, pTB );
+            }
+            else if ( bit21 && 0x25 == opcode ) // MLS <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+            {
+                if ( 3 == size )
+                    unhandled();
+                tracer.Trace( "mls v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
+            }
+            else if ( bit21 && 0x37 == opcode )
+            {
+                uint64_t sz = opbit( 22 );
+                pT = ( 0 == sz ) ? ( 0 == Q ? "2S" : "4S" ) : ( 0 == Q ? "?" : "2D" );
+                tracer.Trace( "fmul v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
+            }
+            else if ( !bit21 && 0 == size && !bit10 && !bit15 )
+            {
+                uint64_t imm4 = opbits( 11, 4 );
+                pT = Q ? "8B" : "16B";
+                tracer.Trace( "ext v%llu.%s, v%llu.%s, v%llu.%s, #%llu\n", d, pT, n, pT, m, pT, imm4 );
+            }
+            else
+                unhandled();
+            break;
+        }
+        case 0x5e: // SCVTF <V><d>, <V><n>    ;    ADDP D<d>, <Vn>.2D    ;    DUP <V><d>, <Vn>.<T>[<index>]    ;    FCVTZS <V><d>, <V><n>
+                   // CMGT D<d>, D<n>, D<m>   ;    CMGT D<d>, D<n>, #0   ;    ADD D<d>, D<n>, D<m>             ;    FCMLT <V><d>, <V><n>, #0.0
+                   // CMEQ D<d>, D<n>, #0
+        {
+            uint64_t bits23_10 = opbits( 10, 14 );
+            uint64_t bit23 = opbit( 23 );
+            uint64_t bit21 = opbit( 21 );
+            uint64_t bits23_21 = opbits( 21, 3 );
+            uint64_t bits20_16 = opbits( 16, 5 );
+            uint64_t bits15_10 = opbits( 10, 6 );
+            uint64_t n = opbits( 5, 5 );
+            uint64_t d = opbits( 0, 5 );
+
+            if ( 0x5e000000 == ( op & 0xffe08c00 ) ) // SHA1C/SHA1P/SHA1M/SHA1SU0/SHA256H/SHA256H2/SHA256SU1
+            {
+                static const char * names[] = { "sha1c", "sha1p", "sha1m", "sha1su0", "sha256h", "sha256h2", "sha256su1", "reserved" };
+                uint64_t m = opbits( 16, 5 );
+                uint64_t opc = opbits( 12, 3 );
+                if ( opc <= 2 )
+                    tracer.Trace( "%s q%llu, s%llu, v%llu.4s\n", names[ opc ], d, n, m );
+                else if ( 4 == opc || 5 == opc )
+                    tracer.Trace( "%s q%llu, q%llu, v%llu.4s\n", names[ opc ], d, n, m );
+                else
+                    tracer.Trace( "%s v%llu.4s, v%llu.4s, v%llu.4s\n", names[ opc ], d, n, m );
+            }
+            else if ( 0x5e280800 == ( op & 0xffffcc00 ) ) // SHA1H    ;    SHA1SU1    ;    SHA256SU0
+            {
+                uint64_t opc = opbits( 12, 2 );
+                if ( 0 == opc )
+                    tracer.Trace( "sha1h s%llu, s%llu\n", d, n );
+                else
+                    tracer.Trace( "%s v%llu.4s, v%llu.4s\n", ( 1 == opc ) ? "sha1su1" : "sha256su0", d, n );
+            }
+            else if ( 7 == bits23_21 && 0 == bits20_16 && 0x26 == bits15_10 ) // CMEQ D<d>, D<n>, #0
+                tracer.Trace( "cmeq d%llu, d%llu, #0\n", d, n );
+            else if ( bit23 && bit21 && 0 == bits20_16 && 0x3a == bits15_10 ) // FCMLT <V><d>, <V><n>, #0.0
+            {
+                uint64_t sz = opbit( 22 );
+                char width = sz ? 'd' : 's';
+                tracer.Trace( "%c%llu, %c%llu, #0.0\n", width, d, width, n );
+            }
+            else if ( 7 == bits23_21 && 0x21 == bits15_10 ) // ADD D<d>, D<n>, D<m>
+            {
+                uint64_t m = opbits( 16, 5 );
+                tracer.Trace( "add d%llu, d%llu, d%llu\n", d, n, m );
+            }
+            else if ( 7 == bits23_21 && 0xd == bits15_10 ) // CMGT D<d>, D<n>, D<m>
+            {
+                uint64_t m = opbits( 16, 5 );
+                tracer.Trace( "cmgt d%llu, d%llu, d%llu\n", d, n, m );
+            }
+            else if ( 0x3822 == bits23_10 ) // CMGT D<d>, D<n>, #0
+            {
+                tracer.Trace( "cmgt d%llu, d%llu, #0\n", d, n ); // code not implemented
+            }
+            else if ( 0x386e == bits23_10 || 0x286e == bits23_10 ) // FCVTZS <V><d>, <V><n>
+            {
+                uint64_t sz = opbit( 22 );
+                char width = sz ? 'd' : 's';
+                tracer.Trace( "fcvtzs %c%llu, %c%llu\n", width, d, width, n );
+            }
+            else if ( 0x0876 == ( bits23_10 & 0x2fff ) ) // SCVTF <V><d>, <V><n>
+            {
+                uint64_t sz = opbit( 22 );
+                char width = sz ? 'd' : 's';
+                tracer.Trace( "scvtf %c%llu, %c%llu\n", width, d, width, n );
+            }
+            else if ( 0x3c6e == bits23_10 ) // DUP <V><d>, <Vn>.<T>[<index>]
+                tracer.Trace( "addp D%llu, v%llu.2D\n", d, n );
+            else if ( 1 == ( bits23_10 & 0x383f ) ) // DUP <V><d>, <Vn>.<T>[<index>]   -- scalar
+            {
+                uint64_t imm5 = opbits( 16, 5 );
+                uint64_t size = lowest_set_bit_nz( imm5 & 0xf );
+                uint64_t index = get_bits( imm5, size + 1, size + 2 ); // imm5:<4:size+1>
+                const char * pT = ( imm5 & 1 ) ? "B" : ( imm5 & 2 ) ? "H" : ( imm5 & 4 ) ? "S" : "D";
+                tracer.Trace( "dup %s%llu, v%llu.%s[%llu]\n", pT, d, n, pT, index );
+            }
+            else
+                unhandled();
+            break;
+        }
+        case 0x7e: // CMGE    ;    UCVTF <V><d>, <V><n>    ;    UCVTF <Hd>, <Hn>            ;    FADDP <V><d>, <Vn>.<T>    ;    FABD <V><d>, <V><n>, <V><m>
+                   // FCMGE <V><d>, <V><n>, #0.0           ;    FMINNMP <V><d>, <Vn>.<T>    ;    FMAXNMP <V><d>, <Vn>.<T>
+                   // CMHI D<d>, D<n>, D<m>                ;    FCVTZU <V><d>, <V><n>       ;    FCMGT <V><d>, <V><n>, <V><m>
+                   // FCMGE <V><d>, <V><n>, <V><m>         ;    CMLE D<d>, D<n>, #0         ;    CMGE D<d>, D<n>, #0
+        {
+            uint64_t bits23_10 = opbits( 10, 14 );
+            uint64_t bits23_21 = opbits( 21, 3 );
+            uint64_t bits20_10 = opbits( 10, 11 );
+            uint64_t bits15_10 = opbits( 10, 6 );
+            uint64_t n = opbits( 5, 5 );
+            uint64_t d = opbits( 0, 5 );
+            uint64_t bit23 = opbit( 23 );
+            uint64_t sz = opbit( 22 );
+            uint64_t bit21 = opbit( 21 );
+            uint64_t opcode = opbits( 10, 6 );
+
+            if ( !bit23 && bit21 && 0x39 == bits15_10 ) // FCMGE <V><d>, <V><n>, <V><m>
+            {
+                char width = sz ? 'd' : 's';
+                uint64_t m = opbits( 16, 5 );
+                tracer.Trace( "fcmge %c%llu, %c%llu, %c%llu\n", width, d, width, n, width, m );
+            }
+            else if ( bit23 && bit21 && 0x39 == bits15_10 ) // FCMGT <V><d>, <V><n>, <V><m>
+            {
+                char width = sz ? 'd' : 's';
+                uint64_t m = opbits( 16, 5 );
+                tracer.Trace( "fcmgt %c%llu, %c%llu, %c%llu\n", width, d, width, n, width, m );
+            }
+            else if ( bit23 && bit21 && 0x6e == bits20_10 ) // FCVTZU <V><d>, <V><n>
+            {
+                char width = sz ? 'd' : 's';
+                tracer.Trace( "fcvtzu %c%llu, %c%llu\n", width, d, width, n );
+            }
+            else if ( 7 == bits23_21 && 0xd == bits15_10 ) // CMHI D<d>, D<n>, D<m>
+            {
+                uint64_t m = opbits( 16, 5 );
+                tracer.Trace( " cmhi d%llu, d%llu, d%llu\n", d, n, m );
+            }
+            else if ( bit21 && 0x432 == bits20_10 ) // FMINNMP <V><d>, <Vn>.<T>    ;    FMAXNMP <V><d>, <Vn>.<T>
+            {
+                tracer.Trace( "%s %c%llu, v%llu.%s\n", bit23 ? "fminnmp" : "fmaxnmp", sz ? 'd' : 's', d, n, sz ? "2d" : "2s" );
+            }
+            else if ( bit23 && bit21 && 0x35 == opcode ) // FABD <V><d>, <V><n>, <V><m>
+            {
+                char width = sz ? 'd' : 's';
+                uint64_t m = opbits( 16, 5 );
+                tracer.Trace( "fabd %c%llu, %c%llu, %c%llu\n", width, d, width, n, width, m );
+            }
+            else if ( 0x0c36 == bits23_10 || 0x1c36 == bits23_10 ) // FADDP <V><d>, <Vn>.<T>
+            {
+                char width = sz ? 'd' : 's';
+                tracer.Trace( "faddp %c%llu, v%llu.2%c\n", width, d, n, width );
+            }
+            else if ( 0x3822 == bits23_10 ) // CMGE D<d>, D<n>, #0
+                tracer.Trace( "cmge d%llu, d%llu, #0\n", d, n );
+            else if ( 0x3826 == bits23_10 ) // CMLE D<d>, D<n>, #0
+                tracer.Trace( "cmle d%llu, d%llu, #0\n", d, n );
+            else if ( 0x0876 == ( bits23_10 & 0x2fff ) )
+            {
+                char width = sz ? 'd' : 's';
+                tracer.Trace( "ucvtf %c%llu, %c%llu\n", width, d, width, n );
+            }
+            else if ( 0x2832 == bits23_10 || 0x3832 == bits23_10 ) // FCMGE <V><d>, <V><n>, #0.0
+            {
+                char type = sz ? 'd' : 'f';
+                tracer.Trace( "fcmge %c%llu, %c%llu, #0.0\n", type, d, type, n );
+            }
+            else
+                unhandled();
+            break;
+        }
+        case 0x0e: case 0x4e: // DUP <Vd>.<T>, <Vn>.<Ts>[<index>]    ;    DUP <Vd>.<T>, <R><n>    ;             CMEQ <Vd>.<T>, <Vn>.<T>, #0    ;    ADDP <Vd>.<T>, <V
+                              // AND <Vd>.<T>, <Vn>.<T>, <Vm>.<T>    ;    UMOV <Wd>, <Vn>.<Ts>[<index>]    ;    UMOV <Xd>, <Vn>.D[<index>]     ;    CNT <Vd>.<T>, <Vn>.<T>
+                              // AND <Vd>.<T>, <Vn>.<T>, <Vm>.<T>    ;    UMOV <Wd>, <Vn>.<Ts>[<index>]    ;    UMOV <Xd>, <Vn>.D[<index>]     ;    ADDV <V><d>, <Vn>.<T>
+                              // XTN{2} <Vd>.<Tb>, <Vn>.<Ta>         ;    UZP1 <Vd>.<T>, <Vn>.<T>, <Vm>.<T> ;   UZP2 <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+                              // SMOV <Wd>, <Vn>.<Ts>[<index>]       ;    SMOV <Xd>, <Vn>.<Ts>[<index>]    ;    INS <Vd>.<Ts>[<index>], <R><n> ;    CMGT <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+                              // SCVTF <Vd>.<T>, <Vn>.<T>            ;    FMLA <Vd>.<T>, <Vn>.<T>, <Vm>.<T>;    FADD <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+                              // TRN1 <Vd>.<T>, <Vn>.<T>, <Vm>.<T>   ;    TRN2 <Vd>.<T>, <Vn>.<T>, <Vm>.<T> ;   TBL <Vd>.<Ta>, { <Vn>.16B }, <Vm>.<Ta> ; TBL <Vd>.<Ta>, { <Vn>.16B, <Vn+1>.16B, <Vn+2>.16B, <Vn+3>.16B }, <Vm>.<Ta>
+                              // ZIP1 <Vd>.<T>, <Vn>.<T>, <Vm>.<T>   ;    ZIP2 <Vd>.<T>, <Vn>.<T>, <Vm>.<T> ;   SMULL{2} <Vd>.<Ta>, <Vn>.<Tb>, <Vm>.<Tb>
+                              // MLA <Vd>.<T>, <Vn>.<T>, <Vm>.<T>    ;    MUL <Vd>.<T>, <Vn>.<T>, <Vm>.<T>  ;   CMLT <Vd>.<T>, <Vn>.<T>, #0    ;    REV64 <Vd>.<T>, <Vn>.<T>
+                              // BIC <Vd>.<T>, <Vn>.<T>, <Vm>.<T>    ;    FMLS <Vd>.<T>, <Vn>.<T>, <Vm>.<T> ;   FSUB <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+                              // SMAX <Vd>.<T>, <Vn>.<T>, <Vm>.<T>   ;    SMIN <Vd>.<T>, <Vn>.<T>, <Vm>.<T> ;   SMINV <V><d>, <Vn>.<T>         ;    SMAXV <V><d>, <Vn>.<T>
+                              // FMINNM <Vd>.<T>, <Vn>.<T>, <Vm>.<T> ;    FMAXNM <Vd>.<T>, <Vn>.<T>, <Vm>.<T> ; FCVTN{2} <Vd>.<Tb>, <Vn>.<Ta>  ;    FCVTZS <Vd>.<T>, <Vn>.<T>
+                              // ORN <Vd>.<T>, <Vn>.<T>, <Vm>.<T>    ;    FCVTL{2} <Vd>.<Ta>, <Vn>.<Tb>     ;   SSHL <Vd>.<T>, <Vn>.<T>, <Vm>.<T> ; SADDW{2} <Vd>.<Ta>, <Vn>.<Ta>, <Vm>.<Tb>
+                              // CMGE <Vd>.<T>, <Vn>.<T>, <Vm>.<T>   ;    ABS <Vd>.<T>, <Vn>.<T>            ;   SSUBW{2} <Vd>.<Ta>, <Vn>.<Ta>, <Vm>.<Tb>
+                              // FCMLT <Vd>.<T>, <Vn>.<T>, #0.0      ;    FABS <Vd>.<T>, <Vn>.<T>           ;   SMLAL{2} <Vd>.<Ta>, <Vn>.<Tb>, <Vm>.<Tb>
+                              // SADDL{2} <Vd>.<Ta>, <Vn>.<Tb>, <Vm>.<Tb> ; SADDLP <Vd>.<Ta>, <Vn>.<Tb>     ;   SADDLV <V><d>, <Vn>.<T>        ;    SADALP <Vd>.<Ta>, <Vn>.<Tb>
+                              // SQXTN{2} <Vd>.<Tb>, <Vn>.<Ta>       ;    CMGT <Vd>.<T>, <Vn>.<T>, #0       ;   CMTST <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+                              // FMIN <Vd>.<T>, <Vn>.<T>, <Vm>.<T>   ;    FCMEQ <Vd>.<T>, <Vn>.<T>, <Vm>.<T> ;  REV16 <Vd>.<T>, <Vn>.<T>
+        {
+            uint64_t Q = opbit( 30 );
+            uint64_t imm5 = opbits( 16, 5 );
+            uint64_t bit15 = opbit( 15 );
+            uint64_t bits14_11 = opbits( 11, 4 );
+            uint64_t bit10 = opbit( 10 );
+            uint64_t bits12_10 = opbits( 10, 3 );
+            uint64_t bit21 = opbit( 21 );
+            uint64_t bit23 = opbit( 23 );
+            uint64_t bits23_21 = opbits( 21, 3 );
+            uint64_t n = opbits( 5, 5 );
+            uint64_t d = opbits( 0, 5 );
+            uint64_t bits20_16 = opbits( 16, 5 );
+            uint64_t bits14_10 = opbits( 10, 5 );
+            uint64_t bits15_10 = opbits( 10, 6 );
+
+            if ( 0x4e284800 == ( op & 0xffffcc00 ) ) // AESE    ;    AESD    ;    AESMC    ;    AESIMC
+            {
+                static const char * names[] = { "aese", "aesd", "aesmc", "aesimc" };
+                tracer.Trace( "%s v%llu.16b, v%llu.16b\n", names[ opbits( 12, 2 ) ], d, n );
+            }
+            else if ( 0x0e20e000 == ( op & 0xbf20fc00 ) ) // PMULL{2} <Vd>.<Ta>, <Vn>.<Tb>, <Vm>.<Tb>
+            {
+                uint64_t m = opbits( 16, 5 );
+                uint64_t size = opbits( 22, 2 );
+                const char * pTA = ( 3 == size ) ? "1q" : "8h";
+                const char * pTB = ( 3 == size ) ? ( Q ? "2d" : "1d" ) : ( Q ? "16b" : "8b" );
+                tracer.Trace( "pmull%s v%llu.%s, v%llu.%s, v%llu.%s\n", Q ? "2" : "", d, pTA, n, pTB, m, pTB );
+            }
+            else if ( bit21 && 0 == bits20_16 && 6 == bits15_10 ) // REV16 <Vd>.<T>, <Vn>.<T>
+            {
+                uint64_t size = opbits( 22, 2 );
+                if ( 0 != size )
+                    unhandled();
+                const char * pT = Q ? "16b" : "8b";
+                tracer.Trace( "rev16 v%llu.%s, v%llu.%s\n", d, pT, n, pT );
+            }
+            else if ( !bit23 && bit21 && 0x39 == bits15_10 ) // FCMEQ <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+            {
+                uint64_t m = opbits( 16, 5 );
+                uint64_t sz = opbit( 22 );
+                const char * pT = sz ? Q ? "2d" : "reserved" : Q ? "4s" : "2s";
+                tracer.Trace( "fcmeq v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
+            }
+            else if ( bit21 && 0x3d == bits15_10 ) // FMIN <Vd>.<T>, <Vn>.<T>, <Vm>.<T>    FMAX <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+            {
+                uint64_t m = opbits( 16, 5 );
+                uint64_t sz = opbit( 22 );
+                const char * pT = sz ? Q ? "2d" : "reserved" : Q ? "4s" : "2s";
+                tracer.Trace( "%s v%llu.%s, v%llu.%s, v%llu.%s\n", bit23 ? "fmin" : "fmax", d, pT, n, pT, m, pT );
+            }
+            else if ( bit21 && 0x23 == bits15_10 ) // CMTST <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+            {
+                uint64_t size = opbits( 22, 2 );
+                uint64_t m = opbits( 16, 5 );
+                const char * pT = get_ld1_vector_T( size, Q );
+                tracer.Trace( "cmtst v%llu.%s, v%llu.%s, #0\n", d, pT, n, pT, m, pT );
+            }
+            else if ( bit21 && 0 == bits20_16 && 0x22 == bits15_10 ) // CMGT <Vd>.<T>, <Vn>.<T>, #0
+            {
+                uint64_t size = opbits( 22, 2 );
+                const char * pT = get_ld1_vector_T( size, Q );
+                tracer.Trace( "cmgt v%llu.%s, v%llu.%s, #0\n", d, pT, n, pT );
+            }
+            else if ( bit21 && 1 == bits20_16 && 0x12 == bits15_10 ) // SQXTN{2} <Vd>.<Tb>, <Vn>.<Ta>
+            {
+                uint64_t size = opbits( 22, 2 );
+                const char * pTA = get_saddlp_vector_T( size, 1 );
+                const char * pTB = get_ld1_vector_T( size, Q );
+                tracer.Trace( "sqxtn%s v%llu.%s, v%llu.%s\n", Q ? "2" : "", d, pTB, n, pTA );
+            }
+            else if ( bit21 && 0 == bits20_16 && 0x1a == bits15_10 ) // SADALP <Vd>.<Ta>, <Vn>.<Tb>
+            {
+                uint64_t size = opbits( 22, 2 );
+                const char * pTA = get_saddlp_vector_T( size, Q );
+                const char * pTB = get_ld1_vector_T( size, Q );
+                tracer.Trace( "sadalp v%llu.%s, v%llu.%s\n", d, pTA, n, pTB );
+            }
+            else if ( bit21 && 0x10 == bits20_16 && 0x0e == bits15_10 ) // SADDLV <V><d>, <Vn>.<T>
+            {
+                uint64_t size = opbits( 22, 2 );
+                const char * pT = get_ld1_vector_T( size, Q );
+                char v = ( 0 == size ) ? 'h' : ( 1 == size ) ? 's' : ( 2 == size ) ? 'd' : '?';
+                tracer.Trace( "saddlv %c%llu, v%llu.%s\n", v, d, n, pT );
+            }
+            else if ( bit21 && 0 == bits20_16 && 0x0a == bits15_10 ) // SADDLP <Vd>.<Ta>, <Vn>.<Tb>
+            {
+                uint64_t size = opbits( 22, 2 );
+                const char * pTA = get_saddlp_vector_T( size, Q );
+                const char * pTB = get_ld1_vector_T( size, Q );
+                tracer.Trace( "saddlp v%llu.%s, v%llu.%s\n", d, pTA, n, pTB );
+            }
+            else if ( bit21 && 0 == bits15_10 ) // SADDL{2} <Vd>.<Ta>, <Vn>.<Tb>, <Vm>.<Tb>
+            {
+                uint64_t size = opbits( 22, 2 );
+                uint64_t m = opbits( 16, 5 );
+                const char * pTA = ( 0 == size ) ? "8h" : ( 1 == size ) ? "4s" : ( 2 == size ) ? "2d" : "unknown";
+                const char * pTB = get_ld1_vector_T( size, Q );
+                tracer.Trace( "saddl%s v%llu.%s, v%llu.%s, v%llu.%s\n", Q ? "2" : "", d, pTA, n, pTB, m, pTB );
+            }
+            else if ( bit21 && 0x20 == bits15_10 ) // SMLAL{2} <Vd>.<Ta>, <Vn>.<Tb>, <Vm>.<Tb>
+            {
+                uint64_t size = opbits( 22, 2 );
+                uint64_t m = opbits( 16, 5 );
+                const char * pTA = ( 0 == size ) ? "8h" : ( 1 == size ) ? "4s" : ( 2 == size ) ? "2d" : "unknown";
+                const char * pTB = get_ld1_vector_T( size, Q );
+                tracer.Trace( "smlal%s v%llu.%s, v%llu.%s, v%llu.%s\n", Q ? "2" : "", d, pTA, n, pTB, m, pTB );
+            }
+            else if ( bit23 && bit21 && 0 == bits20_16 && 0x3e == bits15_10 ) // FABS <Vd>.<T>, <Vn>.<T>
+            {
+                uint64_t sz = opbit( 22 );
+                const char * pT = sz ? Q ? "2d" : "reserved" : Q ? "4s" : "2s";
+                tracer.Trace( "fabs v%llu.%s, v%llu.%s, #0.0\n", d, pT, n, pT );
+            }
+            else if ( bit23 && bit21 && 0 == bits20_16 && 0x3a == bits15_10 ) // FCMLT <Vd>.<T>, <Vn>.<T>, #0.0
+            {
+                uint64_t sz = opbit( 22 );
+                const char * pT = sz ? Q ? "2d" : "reserved" : Q ? "4s" : "2s";
+                tracer.Trace( "fcmlt v%llu.%s, v%llu.%s, #0.0\n", d, pT, n, pT );
+            }
+            else if ( bit21 && 0xc == bits15_10 ) // SSUBW{2} <Vd>.<Ta>, <Vn>.<Ta>, <Vm>.<Tb>
+            {
+                uint64_t m = opbits( 16, 5 );
+                uint64_t size = opbits( 22, 2 );
+                const char * pTA = ( 0 == size ) ? "8h" : ( 1 == size ) ? "4s" : ( 2 == size ) ? "2d" : "unknown";
+                const char * pTB = get_ld1_vector_T( size, Q );
+                tracer.Trace( "ssubw%s v%llu.%s, v%llu.%s, v%llu.%s\n", Q ? "2" : "", d, pTA, n, pTA, m, pTB );
+            }
+            else if ( bit21 && 0 == bits20_16 && 0x2e == bits15_10 ) // ABS <Vd>.<T>, <Vn>.<T>
+            {
+                uint64_t size = opbits( 22, 2 );
+                const char * pT = get_ld1_vector_T( size, Q );
+                tracer.Trace( "abs v%llu.%s, v%llu.%s\n", d, pT, n, pT );
+            }
+            else if ( bit21 && 4 == bits15_10 ) // SADDW{2} <Vd>.<Ta>, <Vn>.<Ta>, <Vm>.<Tb>
+            {
+                uint64_t m = opbits( 16, 5 );
+                uint64_t size = opbits( 22, 2 );
+                const char * pTA = ( 0 == size ) ? "8h" : ( 1 == size ) ? "4s" : ( 2 == size ) ? "2d" : "unknown";
+                const char * pTB = get_ld1_vector_T( size, Q );
+                tracer.Trace( "saddw%s v%llu.%s, v%llu.%s, v%llu.%s\n", Q ? "2" : "", d, pTA, n, pTA, m, pTB );
+            }
+            else if ( bit21 && 0x11 == bits15_10 ) // SSHL <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+            {
+                uint64_t m = opbits( 16, 5 );
+                uint64_t size = opbits( 22, 2 );
+                const char * pT = get_ld1_vector_T( size, Q );
+                tracer.Trace( "sshl v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
+            }
+            else if ( !bit23 && bit21 && 1 == bits20_16 && 0x1e == bits15_10 ) // FCVTL{2} <Vd>.<Ta>, <Vn>.<Tb>
+            {
+                uint64_t sz = opbit( 22 );
+                const char * pTA = sz ? "2d" : "4s";
+                const char * pTB = sz ? Q ? "4s" : "2s" : Q ? "8h" : "4h";
+                tracer.Trace( "fcvtl%s v%llu.%s, v%llu.%s\n", Q ? "2" : "", d, pTA, n, pTB );
+            }
+            else if ( 7 == bits23_21 && 7 == bits15_10 ) // ORN <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+            {
+                const char * pT = Q ? "16b" : "8b";
+                uint64_t m = opbits( 16, 5 );
+                tracer.Trace( "orn v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
+            }
+            else if ( bit23 && bit21 && 1 == bits20_16 && 0x2e == bits15_10 ) // FCVTZS <Vd>.<T>, <Vn>.<T>
+            {
+                uint64_t sz = opbit( 22 );
+                const char * pT = sz ? Q ? "2d" : "reserved" : Q ? "4s" : "2s";
+                tracer.Trace( "fcvtzs v%llu.%s, v%llu.%s\n", d, pT, n, pT );
+            }
+            else if ( !bit23 && bit21 && 1 == bits20_16 && 0x1a == bits15_10 ) // FCVTN{2} <Vd>.<Tb>, <Vn>.<Ta>
+            {
+                uint64_t sz = opbit( 22 );
+                const char * pTA = sz ? "2d" : "4s";
+                const char * pTB = sz ? Q ? "8h" : "4h" : Q ? "4s" : "2s";
+                tracer.Trace( "fcvtn%s v%llu.%s, v%llu.%s  # rmode %s\n", Q ? "2" : "", d, pTB, n, pTA, get_rmode_text( get_bits( fpcr, 22, 2 ) ) );
+            }
+            else if ( bit21 && 0x31 == bits15_10 ) // FMINNM <Vd>.<T>, <Vn>.<T>, <Vm>.<T> ;    FMAXNM <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+            {
+                uint64_t m = opbits( 16, 5 );
+                uint64_t sz = opbit( 22 );
+                const char * pT = ( !sz && !Q ) ? "2s" : ( !sz && Q ) ? "4s" : ( sz && Q ) ? "2d" : "?";
+                tracer.Trace( "%s v%llu,%s, v%llu.%s, v%llu.%s\n", bit23 ? "fminnm" : "fmaxnm", d, pT, n, pT, m, pT );
+            }
+            else if ( bit21 && ( 0x11 == bits20_16 || 0x10 == bits20_16 ) && 0x2a == bits15_10 ) // SMINV <V><d>, <Vn>.<T>         ;    SMAXV <V><d>, <Vn>.<T>
+            {
+                uint64_t size = opbits( 22, 2 );
+                char v = ( 0 == size ) ? 'b' : ( 1 == size ) ? 'h' : ( 2 == size ) ? 's' : '?';
+                const char * pT = get_ld1_vector_T( size, Q );
+                tracer.Trace( "%s %c%llu, v%llu.%s\n", ( 0x11 == bits20_16 ) ? "sminv" : "smaxv", v, d, n, pT );
+            }
+            else if ( bit21 && ( 0x19 == bits15_10 || 0x1b == bits15_10 ) ) // SMAX <Vd>.<T>, <Vn>.<T>, <Vm>.<T>    ;    SMIN <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+            {
+                uint64_t m = opbits( 16, 5 );
+                uint64_t size = opbits( 22, 2 );
+                const char * pT = get_ld1_vector_T( size, Q );
+                tracer.Trace( "%s v%llu.%s, v%llu.%s, v%llu.%s\n", ( 0x19 == bits15_10 ) ? "smax" : "smin", d, pT, n, pT, m, pT );
+            }
+            else if ( bit23 && bit21 && 0x35 == bits15_10 ) // FSUB <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+            {
+                uint64_t m = opbits( 16, 5 );
+                uint64_t sz = opbit( 22 );
+                const char * pT = ( !sz && !Q ) ? "2s" : ( !sz && Q ) ? "4s" : ( sz && Q ) ? "2d" : "?";
+                tracer.Trace( "fsub v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
+            }
+            else if ( bit23 && bit21 && 0x33 == bits15_10 ) // FMLS <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+            {
+                uint64_t m = opbits( 16, 5 );
+                uint64_t sz = opbit( 22 );
+                const char * pT = ( !sz && !Q ) ? "2s" : ( !sz && Q ) ? "4s" : ( sz && Q ) ? "2d" : "?";
+                tracer.Trace( "fmls v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
+            }
+            else if ( 3 == bits23_21 && 7 == bits15_10 ) // BIC <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+            {
+                const char * pT = Q ? "16b" : "8b";
+                uint64_t m = opbits( 16, 5 );
+                tracer.Trace( "bic v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
+            }
+            else if ( bit21 && 0 == bits20_16 && !bit15 && 2 == bits14_10 ) // REV64 <Vd>.<T>, <Vn>.<T>
+            {
+                uint64_t size = opbits( 22, 2 );
+                const char * pT = get_ld1_vector_T( size, Q );
+                tracer.Trace( "rev64 v%llu.%s, v%llu.%s\n", d, pT, n, pT );
+            }
+            else if ( bit21 && 0 == bits20_16 && bit15 && 0xa == bits14_10 ) // CMLT <Vd>.<T>, <Vn>.<T>, #0
+            {
+                uint64_t size = opbits( 22, 2 );
+                const char * pT = get_ld1_vector_T( size, Q );
+                tracer.Trace( "cmlt v%llu.%s, v%llu.%s, #0\n", d, pT, n, pT );
+            }
+            else if ( bit21 && bit15 && ( 7 == bits14_10 || 5 == bits14_10 ) ) // MUL <Vd>.<T>, <Vn>.<T>, <Vm>.<T>    ;    MLA <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+            {
+                uint64_t m = opbits( 16, 5 );
+                uint64_t size = opbits( 22, 2 );
+                const char * pT = get_ld1_vector_T( size, Q );
+                tracer.Trace( "%s v%llu.%s, v%llu.%s, v%llu.%s\n", ( 7 == bits14_10 ) ? "mul" : "mla", d, pT, n, pT, m, pT );
+            }
+            else if ( bit21 && bit15 && 8 == bits14_11 && !bit10 ) // SMULL{2} <Vd>.<Ta>, <Vn>.<Tb>, <Vm>.<Tb>
+            {
+                uint64_t m = opbits( 16, 5 );
+                uint64_t size = opbits( 22, 2 );
+                uint64_t part = Q;
+                const char * pTA = ( 0 == size ) ? "8h" : ( 1 == size ) ? "4s" : ( 2 == size ) ? "2d" : "unknown";
+                const char * pTB = get_ld1_vector_T( size, Q );
+                tracer.Trace( "smull%s v%llu.%s, v%llu.%s, v%llu.%s\n", part ? "2" : "", d, pTA, n, pTB, m, pTB );
+            }
+            else if ( !bit21 && !bit15 && ( 0x1e == bits14_10 || 0xe == bits14_10 ) ) // ZIP1/2 <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+            {
+                uint64_t m = opbits( 16, 5 );
+                uint64_t size = opbits( 22, 2 );
+                const char * pT = get_ld1_vector_T( size, Q );
+                tracer.Trace( "zip%c v%llu.%s, v%llu.%s, v%llu.%s\n", ( 0x1e == bits14_10 ) ? '2' : '1', d, pT, n, pT, m, pT );
+            }
+            else if ( 0 == bits23_21 && !bit15 && 0 == bits12_10 ) // TBL <Vd>.<Ta>, { <Vn>.16B, <Vn+1>.16B, <Vn+2>.16B, <Vn+3>.16B }, <Vm>.<Ta>
+            {
+                uint64_t m = opbits( 16, 5 );
+                const char * pT = Q ? "16b" : "8b";
+                uint64_t len = opbits( 13, 2 );
+                if ( 0 == len )
+                    tracer.Trace( "tbl v%llu.%s, {v%llu.16b}, v%llu.%s\n", d, pT, n, m, pT );
+                else if ( 1 == len )
+                    tracer.Trace( "tbl v%llu.%s, {v%llu.16b, v%llu.16b}, v%llu.%s\n", d, pT, n, n + 1, m, pT );
+                else if ( 2 == len )
+                    tracer.Trace( "tbl v%llu.%s, {v%llu.16b, v%llu.16b, v%llu.16b }, v%llu.%s\n", d, pT, n, n + 1, n + 2, m, pT );
+                else if ( 3 == len )
+                    tracer.Trace( "tbl v%llu.%s, {v%llu.16b, v%llu.16b, v%llu.16b, v%llu.16b }, v%llu.%s\n", d, pT, n, n + 1, n + 2, n + 3, m, pT );
+            }
+            else if ( !bit21 && !bit15 && 0xd == bits14_11 && !bit10 ) // TRN2 <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+            {
+                uint64_t m = opbits( 16, 5 );
+                uint64_t size = opbits( 22, 2 );
+                const char * pT = get_ld1_vector_T( size, Q );
+                tracer.Trace( "trn2 v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
+            }
+            else if ( !bit21 && !bit15 && 5 == bits14_11 && !bit10 ) // TRN1 <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+            {
+                uint64_t m = opbits( 16, 5 );
+                uint64_t size = opbits( 22, 2 );
+                const char * pT = get_ld1_vector_T( size, Q );
+                tracer.Trace( "trn1 v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
+            }
+            else if ( !bit23 && bit21 && bit15 && 0xa == bits14_11 && bit10 ) // FADD <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+            {
+                uint64_t sz = opbit( 22 );
+                uint64_t ty = ( sz << 1 ) | Q;
+                const char * pT = ( 0 == ty ) ? "2s" : ( 1 == ty ) ? "4s" : ( 3 == ty ) ? "2d" : "?";
+                uint64_t m = opbits( 16, 5 );
+                tracer.Trace( "fadd v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
+            }
+            else if ( !bit23 && bit21 && bit15 && 9 == bits14_11 && bit10 ) // FMLA <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+            {
+                uint64_t sz = opbit( 22 );
+                uint64_t ty = ( sz << 1 ) | Q;
+                const char * pT = ( 0 == ty ) ? "2s" : ( 1 == ty ) ? "4s" : ( 3 == ty ) ? "2d" : "?";
+                uint64_t m = opbits( 16, 5 );
+                tracer.Trace( "fmla v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
+            }
+            else if ( !bit23 && bit21 && 1 == bits20_16 && bit15 && 0x16 == bits14_10 ) // SCVTF <Vd>.<T>, <Vn>.<T>
+            {
+                uint64_t sz = opbit( 22 );
+                uint64_t ty = ( sz << 1 ) | Q;
+                const char * pT = ( 0 == ty ) ? "2s" : ( 1 == ty ) ? "4s" : ( 3 == ty ) ? "2d" : "?";
+                tracer.Trace( "scvtf v%llu.%s, v%llu.%s\n", d, pT, n, pT );
+            }
+            else if ( 0x4e == hi8 && 0 == bits23_21 && !bit15 && 3 == bits14_11 && bit10 ) // INS <Vd>.<Ts>[<index>], <R><n>
+            {
+                char T = '?';
+                uint64_t index = 0;
+                if ( imm5 & 1 )
+                {
+                    T = 'B';
+                    index = get_bits( imm5, 1, 4 );
+                }
+                else if ( imm5 & 2 )
+                {
+                    T = 'H';
+                    index = get_bits( imm5, 2, 3 );
+                }
+                else if ( imm5 & 4 )
+                {
+                    T = 'S';
+                    index = get_bits( imm5, 3, 2 );
+                }
+                else if ( imm5 & 8 )
+                {
+                    T = 'D';
+                    index = get_bit( imm5, 4 );
+                }
+                else
+                    unhandled();
+                tracer.Trace( "ins v%llu.%c[%llu], %s\n", d, T, index, reg_or_zr( n, ( 8 == ( imm5 & 0xf ) ) ) );
+            }
+            else if ( !bit21 && !bit15 && ( 7 == bits14_11 || 5 == bits14_11 ) && bit10 )
+            {
+                // UMOV <Wd>, <Vn>.<Ts>[<index>]    ;    UMOV <Xd>, <Vn>.D[<index>]    ;     SMOV <Wd>, <Vn>.<Ts>[<index>]    ;    SMOV <Xd>, <Vn>.<Ts>[<index>]
+                uint64_t size = lowest_set_bit_nz( imm5 & ( ( 7 == bits14_11 ) ? 0xf : 7 ) );
+                uint64_t bits_to_copy = 4 - size;
+                uint64_t index = get_bits( imm5, 4 + 1 - bits_to_copy, bits_to_copy );
+
+                const char * pT = "UNKNOWN";
+                if ( imm5 & 1 )
+                    pT = "B";
+                else if ( imm5 & 2 )
+                    pT = "H";
+                else if ( imm5 & 4 )
+                    pT = "S";
+                else if ( imm5 & 8 )
+                    pT = "D";
+                else
+                    unhandled();
+                tracer.Trace( "%cmov %s, v%llu.%s[%llu]\n", ( 7 == bits14_11 ) ? 'u' : 's', reg_or_zr( d, Q ), n, pT, index );
+            }
+            else if ( !bit21 && !bit15 && ( 0x3 == bits14_11 || 0xb == bits14_11 ) && !bit10 ) //
+            {
+                uint64_t size = opbits( 22, 2 );
+                uint64_t part = opbit( 14 );
+                uint64_t m = imm5;
+                const char * pT = get_ld1_vector_T( size, Q );
+                tracer.Trace( "uzp%c v%llu.%s, v%llu.%s, v%llu.%s\n", ( 1 == part ) ? '2' : '1', d, pT, n, pT, m, pT );
+            }
+            else if ( 1 == bits23_21 && !bit15 && 3 == bits14_11 && bit10 ) // AND <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+            {
+                uint64_t m = imm5;
+                const char * pT = ( 0 == Q ) ? "8B" : "16B";
+                tracer.Trace( "and v%llu.%s, v%llu.%s v%llu.%s\n", d, pT, n, pT, m, pT );
+            }
+            else if ( 5 == bits23_21 && !bit15 && 3 == bits14_11 && bit10 ) // ORR <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+            {
+                uint64_t m = imm5;
+                const char * pT = ( 0 == Q ) ? "8B" : "16B";
+                tracer.Trace( "orr v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
+            }
+            else if ( bit21 && bit15 && 3 == bits14_11 && !bit10 && 0 == bits20_16 )  // CMEQ <Vd>.<T>, <Vn>.<T>, #0
+            {
+                uint64_t size = opbits( 22, 2 );
+                tracer.Trace( "cmeq v%llu.%s, v%llu.%s, #0\n", d, get_ld1_vector_T( size, Q ), n, get_ld1_vector_T( size, Q ) );
+            }
+            else if ( bit21 && !bit15 && 7 == bits14_11 && bit10 ) // CMGE <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+            {
+                uint64_t m = opbits( 16, 5 );
+                uint64_t size = opbits( 22, 2 );
+                const char * pT = get_ld1_vector_T( size, Q );
+                tracer.Trace( "cmge v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
+            }
+            else if ( bit21 && !bit15 && 6 == bits14_11 && bit10 ) // CMGT <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+            {
+                uint64_t m = opbits( 16, 5 );
+                uint64_t size = opbits( 22, 2 );
+                const char * pT = get_ld1_vector_T( size, Q );
+                tracer.Trace( "cmgt v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
+            }
+            else if ( bit21 && bit15 && 7 == bits14_11 && bit10 ) // ADDP <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+            {
+                uint64_t m = opbits( 16, 5 );
+                uint64_t size = opbits( 22, 2 );
+                const char * pT = get_ld1_vector_T( size, Q );
+                tracer.Trace( "addp v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
+            }
+            else if ( 0 == bits23_21 && !bit15 && 1 == bits14_11 && bit10 ) // DUP <Vd>.<T>, <R><n>
+                tracer.Trace( "dup v%llu.%s, %s\n", d, get_vector_T( imm5, Q ), reg_or_zr( n, 0x1000 == ( imm5 & 0xffff ) ) );
+            else if ( 0 == bits23_21 && !bit15 && 0 == bits14_11 && bit10 ) // DUP <Vd>.<T>, <Vn>.<Ts>[<index>]
+            {
+                uint64_t size = lowest_set_bit_nz( imm5 & 0xf );
+                uint64_t index = get_bits( imm5, size + 1, 4 - ( size + 1 ) + 1 );
+                uint64_t indsize = 64ull << get_bit( imm5, 4 );
+                uint64_t esize = 8ull << size;
+                uint64_t datasize = 64ull << Q;
+                uint64_t elements = datasize / esize;
+                tracer.Trace( "size %llu, index %llu, indsize %llu, esize %llu, datasize %llu, elements %llu\n", size, index, indsize, esize, datasize, elements );
+                char byte_len = ( imm5 & 1 ) ? 'B' : ( 2 == ( imm5 & 3 ) ) ? 'H' : ( 4 == ( imm5 & 7 ) ) ? 'S' : ( 8 == ( imm5 & 0xf ) ) ? 'D' : '?';
+                tracer.Trace( "dup v%llu.%s, v%llu.%c[%llu]\n", d, get_vector_T( imm5, Q ), n, byte_len, index );
+            }
+            else if ( bit21 && bit15 && 0 == bits14_11 && bit10 ) // ADD <Vd>.<T>, <Vn>.<T>, <Vm>.<T>.   add vector
+            {
+                uint64_t size = opbits( 22, 2 );
+                uint64_t m = opbits( 16, 5 );
+                const char * pT = get_ld1_vector_T( size, Q );
+                tracer.Trace( "add v%llu.%s, v%llu.%s, v%llu.%s\n", d, pT, n, pT, m, pT );
+            }
+            else if ( bit21 && 0xb == bits14_11 && 0 == bits20_16 && !bit15 ) // CNT
+            {
+                uint64_t size = opbits( 22, 2 );
+                if ( 0 != size )
+                    unhandled();
+
+                const char * pT = get_ld1_vector_T( size, Q );
+                tracer.Trace( "cnt v%llu.%s, v%llu.%s\n", d, pT, n, pT );
+            }
+            else if ( bit21 && 0x11 == bits20_16 && bit15 && 7 == bits14_11 ) // ADDV <V><d>, <Vn>.<T>
+            {
+                uint64_t size = opbits( 22, 2 );
+                if ( 3 == size )
+                    unhandled();
+                const char * pT = get_ld1_vector_T( size, Q );
+                char dstT = ( 0 == size ) ? 'B' : ( 1 == size ) ? 'H' : 'S';
+                tracer.Trace( "addv %c%llu, v%llu.%s\n", dstT, d, n, pT );
+            }
+            else if ( bit21 && 1 == bits20_16 && !bit15 && 5 == bits14_11 && !bit10 ) // xtn, xtn2 XTN{2} <Vd>.<Tb>, <Vn>.<Ta>
+            {
+                uint64_t size = opbits( 22, 2 );
+                if ( 3 == size )
+                    unhandled();
+
+                const char * pTb = get_ld1_vector_T( size, Q );
+                const char * pTa = ( 0 == size ) ? "8h" : ( 1 == size ) ? "4s" : "2d";
+                tracer.Trace( "xtn%s v%llu.%s, v%llu.%s\n", Q ? "2" : "", d, pTb, n, pTa );
+            }
+            else
+            {
+                tracer.Trace( "unknown opcode bits23_21 %lld, bit15 %llu, bits14_11 %llu, bit10 %llu\n", bits23_21, bit15, bits14_11, bit10 );
+                unhandled();
+            }
+            break;
+        }
+        case 0x1e: // FMOV <Wd>, <Hn>    ;    FMUL                ;    FMOV <Wd>, imm       ;    FCVTZU <Wd>, <Dn>    ;    FRINTA <Dd>, <Dn>    ;    FMAXNM <Dd>, <Dn>, <Dm>, FMAX <Dd>, <Dn>, <Dm>
+                   // FMAX <Dd>, <Dn>, <Dm> ; FMINNM <Dd>, <Dn>, <Dm>  ; FMIN <Dd>, <Dn>, <Dm> ; FRINTZ <Dd>, <Dn>    ;    FRINTP <Dd>, <Dn>
+        case 0x9e: // FMOV <Xd>, <Hn>    ;    UCVTF <Hd>, <Dn>    ;    FCVTZU <Xd>, <Dn>    ;    FCVTAS <Xd>, <Dn>    ;    FCVTMU <Xd>, <Dn>
+        {
+            uint64_t sf = opbit( 31 );
+            uint64_t ftype = opbits( 22, 2 );
+            uint64_t bit21 = opbit( 21 );
+            uint64_t bit11 = opbit( 11 );
+            uint64_t bit10 = opbit( 10 );
+            uint64_t bit4 = opbit( 4 );
+            uint64_t bits21_19 = opbits( 19, 3 );
+            uint64_t bits18_16 = opbits( 16, 3 );
+            uint64_t bits18_10 = opbits( 10, 9 );
+            uint64_t bits15_10 = opbits( 10, 6 );
+            uint64_t n = opbits( 5, 5 );
+            uint64_t d = opbits( 0, 5 );
+            uint64_t rmode = opbits( 19, 2 );
+            //tracer.Trace( "ftype %llu, bit21 %llu, rmode %llu, bits18_10 %#llx\n", ftype, bit21, rmode, bits18_10 );
+
+            if ( 0x1e == hi8 && 4 == bits21_19 && 0x130 == bits18_10 ) // FRINTP <Dd>, <Dn>
+            {
+                char t = ( 0 == ftype ) ? 's' : ( 3 == ftype ) ? 'h' : ( 1 == ftype ) ? 'd' : '?';
+                tracer.Trace( "frintp %c%llu, %c%llu\n", t, d, t, n );
+            }
+            else if ( 0x1e == hi8 && 4 == bits21_19 && 0x170 == bits18_10 ) // FRINTZ <Dd>, <Dn>
+            {
+                char t = ( 0 == ftype ) ? 's' : ( 3 == ftype ) ? 'h' : ( 1 == ftype ) ? 'd' : '?';
+                tracer.Trace( "frintz %c%llu, %c%llu\n", t, d, t, n );
+            }
+            else if ( 0x1e == hi8 && bit21 && ( 0x12 == bits15_10 || 0x1a == bits15_10 ) ) // FMAX <Dd>, <Dn>, <Dm>    ;    FMAXNM <Dd>, <Dn>, <Dm>,
+            {
+                uint64_t m = opbits( 16, 5 );
+                char t = ( 0 == ftype ) ? 's' : ( 3 == ftype ) ? 'h' : ( 1 == ftype ) ? 'd' : '?';
+                tracer.Trace( "%s %c%llu, %c%llu, %c%llu\n", ( 0x12 == bits15_10 ) ? "fmax" : "fmaxnm", t, d, t, n, t, m );
+            }
+            else if ( 0x1e == hi8 && bit21 && ( 0x16 == bits15_10 || 0x1e == bits15_10 ) ) // FMIN <Dd>, <Dn>, <Dm>    ;    FMINNM <Dd>, <Dn>, <Dm>
+            {
+                uint64_t m = opbits( 16, 5 );
+                char t = ( 0 == ftype ) ? 's' : ( 3 == ftype ) ? 'h' : ( 1 == ftype ) ? 'd' : '?';
+                tracer.Trace( "%s %c%llu, %c%llu, %c%llu\n", ( 0x16 == bits15_10 ) ? "fmin" : "fminnm", t, d, t, n, t, m );
+            }
+            else if ( 0x1e == hi8 && 4 == bits21_19 && 0x150 == bits18_10 ) // FRINTM <Dd>, <Dn>
+            {
+                char t = ( 0 == ftype ) ? 's' : ( 3 == ftype ) ? 'h' : ( 1 == ftype ) ? 'd' : '?';
+                tracer.Trace( "frintm %c%llu, %c%llu\n", t, d, t, n );
+            }
+            else if ( 0x1e == hi8 && bit21 && !bit11 && bit10 && bit4 ) // FCCMPE <Sn>, <Sm>, #<nzcv>, <cond>    ;    FCCMPE <Dn>, <Dm>, #<nzcv>, <cond>
+            {
+                char t = ( 0 == ftype ) ? 's' : ( 3 == ftype ) ? 'h' : ( 1 == ftype ) ? 'd' : '?';
+                uint64_t m = opbits( 16, 5 );
+                uint64_t nzcv = opbits( 0, 4 );
+                uint64_t cond = opbits( 12, 4 );
+                tracer.Trace( "fccmpe %c%llu, %c%llu, #%#llx, %s\n", t, n, t, m, nzcv, get_cond( cond ) );
+            }
+            else if ( 3 == bits21_19 && 0 == bits18_16 ) // FCVTZS <Xd>, <Dn>, #<fbits>
+            {
+                char t = ( 0 == ftype ) ? 's' : ( 3 == ftype ) ? 'h' : ( 1 == ftype ) ? 'd' : '?';
+                uint64_t scale = opbits( 10, 6 );
+                uint64_t fbits = 64 - scale;
+                tracer.Trace( "fcvtzs %s, %c%llu, #%llu\n", reg_or_zr( d, sf ), t, n, fbits );
+            }
+            else if ( 6 == bits21_19 && 0x40 == bits18_10 ) // FCVTMU <Xd>, <Dn>
+            {
+                char type = ( 0 == ftype ) ? 's' : ( 1 == ftype ) ? 'd' : ( 3 == ftype ) ? 'h' : '?';
+                tracer.Trace( "fcvtmu %s, %c%llu\n", reg_or_zr( d, sf ), type, n );
+            }
+            else if ( 4 == bits21_19 && 0x100 == bits18_10 ) // FCVTAS <Xd>, <Dn>
+            {
+                char type = ( 0 == ftype ) ? 's' : ( 1 == ftype ) ? 'd' : ( 3 == ftype ) ? 'h' : '?';
+                tracer.Trace( "fcvtas %s, %c%llu\n", reg_or_zr( d, sf ), type, n );
+            }
+            else if ( 0x1e == hi8 && 4 == bits21_19 && 0x190 == bits18_10 ) // FRINTA <Dd>, <Dn>
+            {
+                char type = ( 0 == ftype ) ? 's' : ( 1 == ftype ) ? 'd' : ( 3 == ftype ) ? 'h' : '?';
+                tracer.Trace( "frinta %c%llu, %c%llu\n", type, d, type, n );
+            }
+            else if ( ( 0x180 == ( bits18_10 & 0x1bf ) ) && ( bit21 ) && ( 0 == ( rmode & 2 ) ) ) // fmov reg, vreg  OR mov vreg, reg
+            {
+                uint64_t opcode = opbits( 16, 3 );
+                if ( 0 == sf )
+                {
+                    if ( 0 != rmode )
+                        unhandled();
+
+                    if ( 3 == ftype )
+                    {
+                        if ( 6 == opcode )
+                            tracer.Trace( "fmov w%llu, h%llu\n", d, n );
+                        else if ( 7 == opcode )
+                            tracer.Trace( "fmov h%llu, w%llu\n", d, n );
+                    }
+                    else if ( 0 == ftype )
+                    {
+                        if ( 7 == opcode )
+                            tracer.Trace( "fmov s%llu, w%llu\n", d, n );
+                        else if ( 6 == opcode )
+                            tracer.Trace( "fmov w%llu, s%llu\n", d, n );
+                    }
+                    else
+                        unhandled();
+                }
+                else
+                {
+                    if ( 0 == rmode )
+                    {
+                        if ( 3 == ftype && 6 == opcode )
+                            tracer.Trace( "fmov x%llu, h%llu\n", d, n );
+                        else if ( 3 == ftype && 7 == opcode )
+                            tracer.Trace( "fmov h%llu, %s\n", d, reg_or_zr( n, false ) );
+                        else if ( 1 == ftype && 7 == opcode )
+                            tracer.Trace( "fmov d%llu, %s\n", d, reg_or_zr( n, true ) );
+                        else if ( 1 == ftype && 6 == opcode )
+                            tracer.Trace( "fmov x%llu, d%llu\n", d, n );
+                        else
+                            unhandled();
+                    }
+                    else
+                    {
+                        if ( 2 == ftype && 7 == opcode )
+                            tracer.Trace( "fmov v%llu.D[1], x%llu\n", d, n );
+                        else if ( 2 == ftype && 6 == opcode )
+                            tracer.Trace( "fmov x%llu, v%llu.D[1]\n", d, n );
+                    }
+                }
+            }
+            else if ( 0x40 == bits18_10 && bit21 && 3 == rmode ) // FCVTZU <Wd>, <Dn>
+            {
+                char t = ( 0 == ftype ) ? 's' : ( 3 == ftype ) ? 'h' : ( 1 == ftype ) ? 'd' : '?';
+                tracer.Trace( "fcvtzu %s, %c%llu\n", reg_or_zr( d, sf ), t, n );
+            }
+            else if ( 0x40 == ( bits18_10 & 0x1c0 ) && !bit21 && 3 == rmode ) // FCVTZU <Wd>, <Dn>, #<fbits>
+            {
+                char t = ( 0 == ftype ) ? 's' : ( 3 == ftype ) ? 'h' : ( 1 == ftype ) ? 'd' : '?';
+                uint64_t scale = opbits( 10, 6 );
+                uint64_t fbits = 64 - scale;
+                tracer.Trace( "fcvtzu %s, %cllu, #%llu\n", reg_or_zr( d, sf ), t, n, fbits );
+            }
+            else if ( ( 0x1e == hi8 ) && ( 4 == ( bits18_10 & 7 ) ) && bit21 && 0 == opbits( 5, 5 ) ) // fmov scalar immediate
+            {
+                //tracer.Trace( "ftype %llu, bit21 %llu, rmode %llu, bits18_10 %#llx\n", ftype, bit21, rmode, bits18_10 );
+                uint64_t fltsize = ( 2 == ftype ) ? 64 : ( 8ull << ( ftype ^ 2 ) );
+                char width = ( 3 == ftype ) ? 'H' : ( 0 == ftype ) ? 'S' : ( 1 == ftype ) ? 'D' : '?';
+                uint64_t imm8 = opbits( 13, 8 );
+                //tracer.Trace( "imm8: %llu == %#llx\n", imm8, imm8 );
+                uint64_t val = vfp_expand_imm( imm8, fltsize );
+                double dval = 0.0;
+                if ( 1 == ftype )
+                    mcpy( &dval, &val, sizeof( dval ) );
+                else if ( 0 == ftype )
+                {
+                    float float_val;
+                    mcpy( &float_val, &val, sizeof( float_val ) );
+                    dval = (double) float_val;
+                }
+                tracer.Trace( "fmov %c%llu, #%lf // %#llx\n", width, d, dval, val );
+            }
+            else if ( ( 0x1e == hi8 ) && ( 2 == ( bits18_10 & 0x3f ) ) && ( bit21 ) ) // fmul vreg, vreg, vreg
+            {
+                uint64_t m = opbits( 16, 5 );
+                if ( 0 == ftype ) // single-precision
+                    tracer.Trace( "fmul s%llu, s%llu, s%llu\n", d, n, m );
+                else if ( 1 == ftype ) // double-precision
+                    tracer.Trace( "fmul d%llu, d%llu, d%llu\n", d, n, m );
+                else
+                    unhandled();
+            }
+            else if ( ( 0x1e == hi8 ) && ( 0x90 == ( bits18_10 & 0x19f ) ) && ( bit21 ) ) // fcvt vreg, vreg
+            {
+                uint64_t opc = opbits( 15, 2 );
+                tracer.Trace( "fcvt %c%llu, %c%llu\n", get_fcvt_precision( opc ), d, get_fcvt_precision( ftype ), n );
+            }
+            else if ( ( 0x1e == hi8 ) && ( 0x10 == bits18_10 ) && ( 4 == bits21_19 ) ) // fmov vreg, vreg
+            {
+                tracer.Trace( "fmov %c%llu, %c%llu\n", get_fcvt_precision( ftype ), d, get_fcvt_precision( ftype ), n );
+            }
+            else if ( ( 0x1e == hi8 ) && ( 8 == ( bits18_10 & 0x3f ) ) && ( bit21 ) ) // fcmp vreg, vreg   OR    fcmp vreg, 0.0 and fcmpe variants
+            {
+                uint64_t m = opbits( 16, 5 );
+                uint64_t opc = opbits( 3, 2 );
+                bool is_fcmpe = ( ( 3 == ftype && 2 == opc ) || ( 3 == ftype && 3 == opc ) || ( 0 == ftype && 2 == opc ) || ( 0 == ftype && 0 == m && 3 == opc ) ||
+                                  ( 1 == ftype && 2 == opc ) || ( 1 == ftype && 0 == m && 3 == opc ) );
+                if ( ( 1 == opc || 3 == opc ) && 0 == m )
+                    tracer.Trace( "%s %c%llu, #0.0\n", is_fcmpe ? "fcmpe" : "fcmp", get_fcvt_precision( ftype ), n );
+                else
+                    tracer.Trace( "%s %c%llu, %c%llu\n", is_fcmpe ? "fcmpe" : "fcmp", get_fcvt_precision( ftype ), n, get_fcvt_precision( ftype ), m );
+            }
+            else if ( ( 0x1e == hi8 ) && ( 0x30 == bits18_10 ) && ( 4 == bits21_19 ) ) // fabs vreg, vreg
+            {
+                tracer.Trace( "fabs %c%llu, %c%llu\n", get_fcvt_precision( ftype ), d, get_fcvt_precision( ftype ), n );
+            }
+            else if ( 0x1e == hi8 && ( 6 == ( 0x3f & bits18_10 ) ) && bit21 ) // fdiv
+            {
+                uint64_t m = opbits( 16, 5 );
+                if ( 0 == ftype ) // single-precision
+                    tracer.Trace( "fdiv s%llu, s%llu, s%llu\n", d, n, m );
+                else if ( 1 == ftype ) // double-precision
+                    tracer.Trace( "fdiv d%llu, d%llu, d%llu\n", d, n, m );
+                else
+                    unhandled();
+            }
+            else if ( 0x1e == hi8 && ( 0xa == ( 0x3f & bits18_10 ) ) && bit21 ) // fadd
+            {
+                uint64_t m = opbits( 16, 5 );
+                if ( 0 == ftype ) // single-precision
+                    tracer.Trace( "fadd s%llu, s%llu, s%llu\n", d, n, m );
+                else if ( 1 == ftype ) // double-precision
+                    tracer.Trace( "fadd d%llu, d%llu, d%llu\n", d, n, m );
+                else
+                    unhandled();
+            }
+            else if ( 0x1e == hi8 && ( 0xe == ( 0x3f & bits18_10 ) ) && bit21 ) // fsub
+            {
+                uint64_t m = opbits( 16, 5 );
+                if ( 0 == ftype ) // single-precision
+                    tracer.Trace( "fsub s%llu, s%llu, s%llu\n", d, n, m );
+                else if ( 1 == ftype ) // double-precision
+                    tracer.Trace( "fsub d%llu, d%llu, d%llu\n", d, n, m );
+                else
+                    unhandled();
+            }
+            else if ( 0x80 == bits18_10 && bit21 && 0 == rmode ) // SCVTF (scalar, integer)
+            {
+                char t = ( 0 == ftype ) ? 's' : ( 3 == ftype ) ? 'h' : ( 1 == ftype ) ? 'd' : '?';
+                tracer.Trace( "scvtf %c%llu, %s\n", t, d, reg_or_zr( n, sf ) );
+            }
+            else if ( 0x70 == bits18_10 && bit21 && 0 == rmode ) // fsqrt s#, s#
+            {
+                char t = ( 0 == ftype ) ? 's' : ( 3 == ftype ) ? 'h' : ( 1 == ftype ) ? 'd' : '?';
+                tracer.Trace( "fsqrt %c%llu, %c%llu\n", t, d, t, n );
+            }
+            else if ( bit21 && ( 3 == ( 3 & bits18_10 ) ) ) // fcsel
+            {
+                char t = ( 0 == ftype ) ? 's' : ( 3 == ftype ) ? 'h' : ( 1 == ftype ) ? 'd' : '?';
+                uint64_t m = opbits( 16, 5 );
+                uint64_t cond = opbits( 12, 4 );
+                tracer.Trace( "fcsel %c%llu, %c%llu, %c%llu, %s\n", t, d, t, n, t, m, get_cond( cond ) );
+            }
+            else if ( bit21 && ( 0x50 == bits18_10 ) ) // fneg (scalar)
+            {
+                char t = ( 0 == ftype ) ? 's' : ( 3 == ftype ) ? 'h' : ( 1 == ftype ) ? 'd' : '?';
+                tracer.Trace( "fneg %c%llu, %c%llu\n", t, d, t, n );
+            }
+            else if ( bit21 && 0 == bits18_10 && 3 == rmode ) // fcvtzs
+            {
+                char t = ( 0 == ftype ) ? 's' : ( 3 == ftype ) ? 'h' : ( 1 == ftype ) ? 'd' : '?';
+                tracer.Trace( "fcvtzs %s, %c%llu\n", reg_or_zr( d, sf ), t, n );
+            }
+            else if ( bit21 && ( 1 == ( bits18_10 & 3 ) ) && ( 0 == opbit( 4 ) ) ) // fccmp
+            {
+                char t = ( 0 == ftype ) ? 's' : ( 3 == ftype ) ? 'h' : ( 1 == ftype ) ? 'd' : '?';
+                uint64_t m = opbits( 16, 5 );
+                uint64_t cond = opbits( 12, 4 );
+                uint64_t nzcv = opbits( 0, 4 );
+                tracer.Trace( "fccmp %c%llu, %c%llu, #%#llx, %s\n", t, n, t, m, nzcv, get_cond( cond ) );
+            }
+            else if ( bit21 && ( 0xc0 == ( 0x1c0 & bits18_10 ) ) && 0 == rmode ) // UCVTF <Hd>, <Wn>, #<fbits>
+            {
+                char t = ( 0 == ftype ) ? 's' : ( 3 == ftype ) ? 'h' : ( 1 == ftype ) ? 'd' : '?';
+                uint64_t scale = opbits( 10, 6 );
+                uint64_t fbits = 64 - scale;
+                tracer.Trace( "ucvtf %c%llu, %s, #%#llx\n", t, d, reg_or_zr( n, sf ), fbits );
+            }
+            else
+            {
+                tracer.Trace( "ftype %llu, bit21 %llu, rmode %llu, bits18_10 %#llx\n", ftype, bit21, rmode, bits18_10 );
+                unhandled();
+            }
+            break;
+        }
+        case 0x0c:
+        case 0x4c: // LD1 { <Vt>.<T> }, [<Xn|SP>]    ;    LD2 { <Vt>.<T>, <Vt2>.<T> }, [<Xn|SP>]
+                   // ST2 { <Vt>.<T>, <Vt2>.<T> }, [<Xn|SP>]    ;    ST2 { <Vt>.<T>, <Vt2>.<T> }, [<Xn|SP>], <imm>    ;    ST2 { <Vt>.<T>, <Vt2>.<T> }, [<Xn|SP>], <Xm>
+                   // LD3 { <Vt>.<T>, <Vt2>.<T>, <Vt3>.<T> }, [<Xn|SP>]
+                   // LD3 { <Vt>.<T>, <Vt2>.<T>, <Vt3>.<T> }, [<Xn|SP>], <imm>
+                   // LD3 { <Vt>.<T>, <Vt2>.<T>, <Vt3>.<T> }, [<Xn|SP>], <Xm>
+                   // LD4 { <Vt>.<T>, <Vt2>.<T>, <Vt3>.<T>, <Vt4>.<T> }, [<Xn|SP>]
+                   // LD4 { <Vt>.<T>, <Vt2>.<T>, <Vt3>.<T>, <Vt4>.<T> }, [<Xn|SP>], <imm>
+                   // LD4 { <Vt>.<T>, <Vt2>.<T>, <Vt3>.<T>, <Vt4>.<T> }, [<Xn|SP>], <Xm>
+        {
+            uint64_t Q = opbit( 30 );
+            uint64_t L = opbit( 22 ); // load vs. store
+            const char * pname = L ? "ld" : "st";
+            uint64_t post_index = opbit( 23 );
+            uint64_t opcode = opbits( 12, 4 );
+            uint64_t size = opbits( 10, 2 );
+            uint64_t bits23_21 = opbits( 21, 3 );
+            uint64_t m = opbits( 16, 5 );
+            uint64_t n = opbits( 5, 5 );
+            uint64_t t = opbits( 0, 5 );
+
+            if ( 2 != bits23_21 && 6 != bits23_21 && 0 != bits23_21 && 4 != bits23_21 )
+                unhandled();
+
+            if ( ( 2 & opcode ) || 8 == opcode || 4 == opcode || 0 == opcode ) // LD1 / LD2 / LD3 / LD4 / ST1 / ST2 / ST3 / ST4
+            {
+                uint64_t t2 = ( t + 1 ) % 32;
+                if ( post_index )
+                {
+                    if ( 31 == m )
+                    {
+                        const char * pT = get_ld1_vector_T( size, Q );
+                        if ( 7 == opcode ) // LD1 { <Vt>.<T> }, [<Xn|SP>], <imm>
+                            tracer.Trace( "%s1 {v%llu.%s}, [%s], #%llu\n", pname, t, pT, reg_or_sp( n, true ), Q ? 16ull : 8ull );
+                        else if ( 8 == opcode ) // LD2 { <Vt>.<T>, <Vt2>.<T> }, [<Xn|SP>], <imm>
+                            tracer.Trace( "%s2 {v%llu.%s, v%llu.%s}, [%s], #%llu\n", pname, t, pT, t2, pT, reg_or_sp( n, true ), Q ? 32llu : 16llu );
+                        else if ( 3 == opcode ) // LD3 { <Vt>.<T>, <Vt2>.<T>, <Vt3>.<T>, <Vt4>.<T> }, [<Xn|SP>], <imm>
+                            tracer.Trace( "%s3 {v%llu.%s-v%llu.%s}, [%s], #%llu\n", pname, t, pT, ( t + 2 ) % 32, pT, reg_or_sp( n, true ), Q ? 64llu : 32llu );
+                        else if ( 0 == opcode ) // LD4 { <Vt>.<T>, <Vt2>.<T>, <Vt3>.<T>, <Vt4>.<T> }, [<Xn|SP>], <imm>
+                            tracer.Trace( "%s4 {v%llu.%s-v%llu.%s}, [%s], #%llu\n", pname, t, pT, ( t + 3 ) % 32, pT, reg_or_sp( n, true ), Q ? 64llu : 32llu );
+                        else
+                            unhandled();
+                    }
+                    else
+                        unhandled();
+                }
+                else // no offset
+                {
+                    if ( 0 == m )
+                    {
+                        const char * pT = get_ld1_vector_T( size, Q );
+                        if ( 7 == opcode ) // LD1 { <Vt>.<T> }, [<Xn|SP>]
+                            tracer.Trace( "%s1 {v%llu.%s}, [%s]\n", pname, t, pT, reg_or_sp( n, true ) );
+                        else if ( 10 == opcode ) // LD1 { <Vt>.<T>, <Vt2>.<T> }, [<Xn|SP>]
+                            tracer.Trace( "%s1 {v%llu.%s}, {v%llu.%s}, [%s]\n", pname, t, pT, t2, pT, reg_or_sp( n, true ) );
+                        else if ( 8 == opcode ) // LD2 { <Vt>.<T>, <Vt2>.<T> }, [<Xn|SP>]
+                            tracer.Trace( "%s2 { v%llu.%s, %llu.%s }, [%s]\n", pname, t, pT, t2, pT, reg_or_sp( n, true ) );
+                        else if ( 4 == opcode ) // LD3 { <Vt>.<T>, <Vt2>.<T> }, [<Xn|SP>]
+                            tracer.Trace( "%s3 { v%llu.%s-v%llu.%s }, [%s]\n", pname, t, pT, ( t + 2 ) % 32, pT, reg_or_sp( n, true ) );
+                        else if ( 0 == opcode || 2 == opcode ) // LD4 { <Vt>.<T>-<Vtn>.<T> }, [<Xn|SP>]
+                            tracer.Trace( "%s4 { v%llu.%s-v%llu.%s }, [%s]\n", pname, t, pT, ( t + 3 ) % 32, pT, reg_or_sp( n, true ) );
+                        else
+                            unhandled();
+                    }
+                    else
+                        unhandled();
+                }
+            }
+            else if ( 0 == opcode && 0 == opbits( 12, 9 ) ) // LD4 multiple structures
+            {
+                if ( 2 == bits23_21 ) // no offset LD4 { <Vt>.<T>, <Vt2>.<T>, <Vt3>.<T>, <Vt4>.<T> }, [<Xn|SP>]
+                {
+                    const char * pT = get_ld1_vector_T( size, Q );
+                    tracer.Trace( "ld4 {v%llu.%s-v%llu.%s}, [%s]\n", t, pT, ( t + 3 ) % 32, pT, reg_or_sp( n , true ) );
+                }
+                else if ( 6 == bits23_21 ) // post-index
+                    unhandled();
+                else
+                    unhandled();
+            }
+            else
+                unhandled();
+            break;
+        }
+        case 0x88: // LDAXR <Wt>, [<Xn|SP>{, #0}]    ;    LDXR <Wt>, [<Xn|SP>{, #0}]    ;    STXR <Ws>, <Wt>, [<Xn|SP>{, #0}]    ;    STLXR <Ws>, <Wt>, [<Xn|SP>{, #0}]
+                   //                                                                        STLR <Wt>, [<Xn|SP>{, #0}]          ;    STLR <Wt>, [<Xn|SP>, #-4]!
+        case 0xc8: // LDAXR <Xt>, [<Xn|SP>{, #0}]    ;    LDXR <Xt>, [<Xn|SP>{, #0}]    ;    STXR <Ws>, <Xt>, [<Xn|SP>{, #0}]    ;    STLXR <Ws>, <Xt>, [<Xn|SP>{, #0}]
+                   //                                                                        STLR <Xt>, [<Xn|SP>{, #0}]          ;    STLR <Xt>, [<Xn|SP>, #-8]!
+        {
+            uint64_t t = opbits( 0, 5 );
+            uint64_t n = opbits( 5, 5 );
+            uint64_t t2 = opbits( 10, 5 );
+            uint64_t s = opbits( 16, 5 );
+            uint64_t L = opbits( 21, 2 );
+            uint64_t oO = opbit( 15 );
+            uint64_t bit23 = opbit( 23 );
+            uint64_t bit30 = opbit( 30 );
+
+            if ( 0x1f != t2 )
+                unhandled();
+
+            if ( bit23 && ( L & 1 ) ) // CAS{A}{L}
+                tracer.Trace( "cas%s %s, %s, [%s]\n", opbit( 22 ) ? ( oO ? "al" : "a" ) : ( oO ? "l" : "" ), reg_or_zr( s, bit30 ),
+                              reg_or_zr( t, bit30 ), reg_or_sp( n, true ) );
+            else if ( 0 == L ) // stxr, stlr
+            {
+                if ( bit23 )
+                    tracer.Trace( "stlr %s, [%s]\n", reg_or_zr( t, bit30 ), reg_or_sp( n, bit30 ) );
+                else
+                    tracer.Trace( "%s %s, %s, [ %s ]\n", ( 1 == oO ) ? "stlxr" : "stxr", reg_or_zr( s, false ), reg_or_zr( t, ( 0xc8 == hi8 ) ), reg_or_sp( n, true ) );
+            }
+            else if ( 2 == L ) // ldxr and ldaxr
+            {
+                if ( 0x1f != s )
+                    unhandled();
+                tracer.Trace( "%s %s, [ %s ]\n", ( 1 == oO ) ? "ldaxr" : "ldxr", reg_or_zr( t, ( 0xc8 == hi8 ) ), reg_or_sp( n, true ) );
+            }
+            break;
+        }
+        case 0xd6: // BLR <Xn>    ;    BR <Xn>    ;    RET {<Xn>}
+        {
+            uint64_t n = opbits( 5, 5 );
+            uint64_t theop = opbits( 21, 2 );
+            uint64_t bit23 = opbit( 23 );
+            uint64_t op2 = opbits( 12, 9 );
+            uint64_t A = opbit( 11 );
+            uint64_t M = opbit( 10 );
+            if ( 0 != bit23 )
+                unhandled();
+            if ( 0x1f0 != op2 )
+                unhandled();
+            if ( ( 0 != A ) || ( 0 != M ) )
+                unhandled();
+
+            if ( 0 == theop ) // br
+                tracer.Trace( "br x%llu\n", n );
+            else if ( 1 == theop ) // blr
+                tracer.Trace( "blr x%llu\n", n );
+            else if ( 2 == theop ) // ret
+                tracer.Trace( "ret x%llu\n", n );
+            else
+                unhandled();
+            break;
+        }
+        case 0x72: // MOVK <Wd>, #<imm>{, LSL #<shift>}       ;  ANDS <Wd>, <Wn>, #<imm>
+        case 0xf2: // MOVK <Xd>, #<imm>{, LSL #<shift>}       ;  ANDS <Xd>, <Xn>, #<imm>
+        {
+            uint64_t xregs = ( 0 != ( 0x80 & hi8 ) );
+            uint64_t bit23 = opbit( 23 ); // 1 for MOVK, 0 for ANDS
+            if ( bit23 ) // MOVK
+            {
+                uint64_t hw = opbits( 21, 2 );
+                uint64_t pos = ( hw << 4 );
+                uint64_t imm16 = opbits( 5, 16 );
+                uint64_t d = opbits( 0, 5 );
+                tracer.Trace( "movk %s, #%#llx, LSL #%llu\n", reg_or_zr( d, xregs ), imm16, pos );
+            }
+            else // ANDS
+            {
+                uint64_t N_immr_imms = opbits( 10, 13 );
+                uint64_t op2 = decode_logical_immediate( N_immr_imms, xregs ? 64 : 32 );
+                uint64_t n = opbits( 5, 5 );
+                uint64_t d = opbits( 0, 5 );
+                tracer.Trace( "ands %s, %s, #%#llx\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), op2 );
+            }
+            break;
+        }
+        case 0x38: // B
+        case 0x78: // H
+        case 0xb8: // W
+        case 0xf8: // X
+        {
+            // LDR <Xt>, [<Xn|SP>, (<Wm>|<Xm>){, <extend> {<amount>}}]
+            // LDR <Xt>, [<Xn|SP>], #<simm>
+            // LDR <Xt>, [<Xn|SP>, #<simm>]!
+            // STR <Xt>, [<Xn|SP>, (<Wm>|<Xm>){, <extend> {<amount>}}]
+            // STR <Xt>, [<Xn|SP>], #<simm>
+            // STR <Xt>, [<Xn|SP>, #<simm>]!
+            // W, H and B variants use <Wt> as the first argument
+            // H and B variants use LDRH, STRH, LDRB, STRB instructions. W and X variants use STR and LDR
+            // LDR has sign-extend LDRSx and LDURSW variants
+
+            uint64_t opc = opbits( 21, 3 );
+            uint64_t n = opbits( 5, 5 );
+            uint64_t t = opbits( 0, 5 );
+            bool xregs = ( 0 != opbit( 30 ) );
+
+            const char * suffix = "";
+            if ( 0x38 == hi8 )
+                suffix = "b";
+            else if ( 0x78 == hi8 )
+                suffix = "h";
+
+            char prefix = 'w';
+            if ( xregs )
+                prefix = 'x';
+
+            if ( opbit( 21 ) && 0 == opbits( 10, 2 ) ) // LDADD, LDCLR, LDEOR, LDSET, LDSMAX, LDSMIN, LDUMAX, LDUMIN, SWP
+            {
+                static const char * names[] = { "ldadd", "ldclr", "ldeor", "ldset", "ldsmax", "ldsmin", "ldumax", "ldumin" };
+                bool x = ( 0xf8 == hi8 );
+                const char * acquire_release = opbit( 23 ) ? ( opbit( 22 ) ? "al" : "a" ) : ( opbit( 22 ) ? "l" : "" );
+                tracer.Trace( "%s%s%s %s, %s, [%s]\n", opbit( 15 ) ? "swp" : names[ opbits( 12, 3 ) ], acquire_release, suffix,
+                              reg_or_zr( opbits( 16, 5 ), x ), reg_or_zr( t, x ), reg_or_sp( n, true ) );
+                break;
+            }
+
+            if ( 0 == opc ) // str (immediate) post-index and pre-index
+            {
+                uint64_t unsigned_imm9 = opbits( 12, 9 );
+                int64_t extended_imm9 = sign_extend( unsigned_imm9, 8 );
+                uint64_t option = opbits( 10, 2 );
+                if ( 0 == option) // // STUR <Xt>, [<Xn|SP>{, #<simm>}]
+                    tracer.Trace( "stur%s %s, %s, #%lld // so\n", suffix, reg_or_zr( t, xregs ), reg_or_sp( n, xregs ), extended_imm9 );
+                else if ( 1 == option) // post-index STR <Xt>, [<Xn|SP>], #<simm>
+                    tracer.Trace( "str%s %c%llu, %s, #%lld // po\n", suffix, prefix, t, reg_or_sp( n, true ), extended_imm9 );
+                else if ( 3 == option ) // pre-index STR <Xt>, [<Xn|SP>, #<simm>]!
+                    tracer.Trace( "str%s %c%llu, [%s, #%lld]! //pr\n", suffix, prefix, t, reg_or_sp( n, true ), extended_imm9 );
+                else
+                    unhandled();
+            }
+            else if ( 1 == opc ) // STR <Xt>, [<Xn|SP>, (<Wm>|<Xm>){, <extend> {<amount>}}]
+            {
+                uint64_t m = opbits( 16, 5 );
+                uint64_t shift = opbit( 12 );
+                uint64_t option = opbits( 13, 3 );
+                tracer.Trace( "str%s %s, [ %s, x%llu, %s #%llu]\n", suffix, reg_or_zr( t, xregs ), reg_or_sp( n, true ), m, extend_type( option ),
+                              ( 3 == option ) ? 0 : ( 0 == shift ) ? 0ull : xregs ? 3ull : 2ull );
+            }
+            else if ( 2 == opc ) // ldr (immediate)
+            {
+                uint64_t unsigned_imm9 = opbits( 12, 9 );
+                int64_t extended_imm9 = sign_extend( unsigned_imm9, 8 );
+                uint64_t option = opbits( 10, 2 );
+                if ( 0 == option) // LDUR <Xt>, [<Xn|SP>{, #<simm>}]
+                    tracer.Trace( "ldur%s %c%llu, [%s, #%lld] //so\n", suffix, prefix, t, reg_or_sp( n, true ), extended_imm9 );
+                else if ( 1 == option) // post-index LDR <Xt>, [<Xn|SP>], #<simm>
+                    tracer.Trace( "ldr%s %c%llu, [%s], #%lld //po\n", suffix, prefix, t, reg_or_sp( n, true ), extended_imm9 );
+                else if ( 3 == option ) // pre-index LDR <Xt>, [<Xn|SP>, #<simm>]!
+                    tracer.Trace( "ldr%s %c%llu, [%s, #%lld]! //pr\n", suffix, prefix, t, reg_or_sp( n, true ), extended_imm9 );
+                else
+                    unhandled();
+            }
+            else if ( 3 == opc ) // LDR <Xt>, [<Xn|SP>, (<Wm>|<Xm>){, <extend> {<amount>}}]
+            {
+                uint64_t m = opbits( 16, 5 );
+                uint64_t shift = opbit( 12 );
+                uint64_t option = opbits( 13, 3 );
+                tracer.Trace( "ldr%s %s, [%s, %s, %s #%llu]\n", suffix, reg_or_zr( t, xregs ), reg_or_sp( n, true ), reg_or_zr( m, true ),
+                              extend_type( option ), ( 0 == shift ) ? 0ull : xregs ? 3ull : 2ull );
+            }
+            else if ( 4 == opc || 6 == opc ) // LDRSW <Xt>, [<Xn|SP>], #<simm>    ;    LDRSW <Xt>, [<Xn|SP>, #<simm>]!
+            {
+                uint64_t bits11_10 = opbits( 10, 2 );
+                if ( 0 == bits11_10 ) // LDURSB <Wt>, [<Xn|SP>{, #<simm>}]    ;    LDURSB <Xt>, [<Xn|SP>{, #<simm>}]
+                {
+                    bool isx = ( 0 == opbit( 22 ) );
+                    int64_t imm9 = sign_extend( opbits( 12, 9 ), 8 );
+                    tracer.Trace( "ldurs%s %s, [%s, #%lld]\n", suffix, reg_or_zr( t, isx ), reg_or_sp( n, true ), imm9 );
+                }
+                else
+                {
+                    uint64_t preindex = opbit( 11 ); // 1 for pre, 0 for post increment
+                    int64_t imm9 = sign_extend( opbits( 12, 9 ), 8 );
+                    xregs = ( 4 == opc );
+                    if ( preindex )
+                        tracer.Trace( "ldrs%s %s [%s, #%lld]! // pr\n", suffix, reg_or_zr( t, xregs ), reg_or_sp( n, true ), imm9 );
+                    else
+                        tracer.Trace( "ldrs%s %s [%s], #%lld // po\n", suffix, reg_or_zr( t, xregs ), reg_or_sp( n, true ), imm9 );
+                }
+            }
+            else if ( 5 == opc  || 7 == opc ) // hi8 = 0x78
+                                              //     (opc == 7)                  LDRSH <Wt>, [<Xn|SP>, (<Wm>|<Xm>){, <extend> {<amount>}}]
+                                              //     (opc == 5)                  LDRSH <Xt>, [<Xn|SP>, (<Wm>|<Xm>){, <extend> {<amount>}}]
+                                              // hi8 = 0x38
+                                              //     (opc == 7 && option != 011) LDRSB <Wt>, [<Xn|SP>, (<Wm>|<Xm>), <extend> {<amount>}]
+                                              //     (opc == 5 && option != 011) LDRSB <Xt>, [<Xn|SP>, (<Wm>|<Xm>), <extend> {<amount>}]
+                                              //     (opc == 7 && option == 011) LDRSB <Wt>, [<Xn|SP>, <Xm>{, LSL <amount>}]
+                                              //     (opc == 5 && option == 011) LDRSB <Xt>, [<Xn|SP>, <Xm>{, LSL <amount>}]
+                                              // hi8 == 0xb8
+                                              //     (opc == 5 && option = many) LDRSW <Xt>, [<Xn|SP>, (<Wm>|<Xm>){, <extend> {<amount>}}]
+            {
+                uint64_t m = opbits( 16, 5 );
+                uint64_t shift = opbit( 12 );
+                uint64_t option = opbits( 13, 3 );
+                bool mIsX = ( 1 == ( option & 1 ) );
+                bool tIsX = ( 5 == opc );
+
+                if ( 0xb8 == hi8 )
+                    tracer.Trace( "ldrsw %s, [%s, %s, %s, %llu]\n", reg_or_zr( t, true ), reg_or_sp( n, true ), reg_or_zr( m, option & 1 ), extend_type( option ), shift ? 2 : 0 );
+                else if ( 0x38 == hi8 )
+                {
+                    if ( 3 == option )
+                        tracer.Trace( "ldrsb %s, [%s, x%llu {, LSL %lluu}]\n", reg_or_zr( t, tIsX ), reg_or_sp( n, true ), m, shift );
+                    else
+                        tracer.Trace( "ldrsb %s, [%s, %s, %s {#%llu}]\n", reg_or_zr( t, tIsX ), reg_or_sp( n, true ), reg_or_zr( m, mIsX ), extend_type( option ), shift );
+                }
+                else if ( 0x78 == hi8 )
+                    tracer.Trace( "ldrsh %s, [%s, %s {, %s #%llu}]\n", reg_or_zr( t, tIsX ), reg_or_sp( n, true ),
+                                  reg_or_zr( m, mIsX ), extend_type( option ), shift );
+                else
+                    unhandled();
+            }
+            else
+                unhandled();
+
+            break;
+        }
+        case 0x39: // B
+        case 0x79: // H                              ;    LDRSH <Wt>, [<Xn|SP>{, #<pimm>}]
+        case 0xb9: // W
+        case 0xf9: // X ldr + str unsigned offset    ;    LDRSW <Xt>, [<Xn|SP>{, #<pimm>}]
+        {
+            // LDR <Xt>, [<Xn|SP>{, #<pimm>}]
+            // STR <Xt>, [<Xn|SP>{, #<pimm>}]
+
+            uint64_t opc = opbits( 22, 2 );
+            uint64_t imm12 = opbits( 10, 12 );
+            uint64_t lsl = opbits( 30, 2 );
+            imm12 <<= lsl;
+            uint64_t t = opbits( 0, 5 );
+            uint64_t n = opbits( 5, 5 );
+
+            const char * suffix = "";
+            if ( 0x39 == hi8 )
+                suffix = "b";
+            else if ( 0x79 == hi8 )
+                suffix = "h";
+
+            char prefix = 'w';
+            if ( 0xf9 == hi8 )
+                prefix = 'x';
+
+            if ( 0 == opc )
+                tracer.Trace( "str%s %s, [%s,#%llu] //uo\n", suffix, reg_or_zr( t, ( 0xf9 == hi8 ) ), reg_or_sp( n, true ), imm12 );
+            else if ( 1 == opc )
+                tracer.Trace( "ldr%s %c%llu, [%s,#%llu] //uo\n", suffix, prefix, t, reg_or_sp( n, true ), imm12 );
+            else if ( 2 == opc || 3 == opc )
+                tracer.Trace( "ldrs%s %c%llu, [%s,#%llu] //uo\n", suffix, prefix, t, reg_or_sp( n, true ), imm12 );
+            else
+                unhandled();
+
+            break;
+        }
+        default:
+            unhandled();
+    }
+
+    static char acregs[ 32 * 32 + 10 ]; // way too much.
+    acregs[ 0 ] = 0;
+    int len = 0;
+    for ( int r = 0; r < 31; r++ )
+        if ( 0 != regs[ r ] )
+            len += snprintf( & acregs[ len ], 32, "%u:%llx ", r, regs[ r ] );
+    len += snprintf( &acregs[ len ], 32, "sp:%llx", regs[ 31 ] );
+    tracer.Trace( "         %s\n", acregs );
+} //trace_state
+
+// N (negative): Set if the result is negative
+// Z (zero): Set if the result is zero
+// C (carry): Set if the result cannot be represented as an unsigned integer
+// V (overflow): Set if the result cannot be represented as a signed integer
+
+uint64_t Arm64::add_with_carry64( uint64_t x, uint64_t y, bool carry, bool setflags )
+{
+    if ( setflags )
+    {
+        lazy_kind = lazy_add64;
+        lazy_x = x;
+        lazy_y = y;
+        lazy_carry = carry;
+    }
+    return x + y + (uint64_t) carry;
+} //add_with_carry64
+
+__inline_perf uint64_t Arm64::sub64( uint64_t x, uint64_t y, bool setflags )
+{
+    return add_with_carry64( x, ~y, true, setflags );
+} //sub64
+
+uint32_t Arm64::add_with_carry32( uint32_t x, uint32_t y, bool carry, bool setflags )
+{
+    if ( setflags )
+    {
+        lazy_kind = lazy_add32;
+        lazy_x = x;
+        lazy_y = y;
+        lazy_carry = carry;
+    }
+    return x + y + (uint32_t) carry;
+} //add_with_carry32
+
+__inline_perf uint32_t Arm64::sub32( uint32_t x, uint32_t y, bool setflags )
+{
+    return add_with_carry32( x, ~y, true, setflags );
+} //sub32
+
+void Arm64::compute_lazy_flags()
+{
+    uint64_t x = lazy_x;
+    uint64_t y = lazy_y;
+    bool carry = lazy_carry;
+
+    if ( lazy_add64 == lazy_kind )
+    {
+        uint64_t result = x + y + (uint64_t) carry;
+        int64_t iresult = (int64_t) result;
+        fN = ( iresult < 0 );
+        fZ = ( 0 == result );
+
+        // strangely literal fC computation; there must be a faster way
+
+        uint64_t u_y = y + (uint64_t) carry;
+        uint64_t u_low = ( ( x & 0xffffffff ) + ( u_y & 0xffffffff ) );
+        uint64_t u_low_carry = ( u_low >> 32 );
+        uint64_t carry_carry = ( ~0ull == y && carry ) ? 1 : 0;
+        uint64_t u_hi = ( ( x >> 32 ) + ( u_y >> 32 ) + u_low_carry + carry_carry );
+        uint64_t u_sum = ( u_hi << 32 ) | ( 0xffffffff & u_low );
+        fC = ( ( result != u_sum ) || ( 0 != ( u_hi >> 32 ) ) );
+
+        int64_t ix = (int64_t) x;
+        int64_t iy = (int64_t) y;
+        fV = ( ( ( ix >= 0 && iy >= 0 ) && ( iresult < ix || iresult < iy ) ) ||
+               ( ( ix < 0 && iy < 0 ) && ( iresult > ix || iresult > iy ) ) );
+    }
+    else
+    {
+        // this method of setting flags is as the Arm documentation suggests
+        uint64_t unsigned_sum = x + y + (uint64_t) carry;
+        uint32_t result = (uint32_t) unsigned_sum;
+        fN = ( ( (int32_t) result ) < 0 );
+        fZ = ( 0 == result );
+        fC = ( (uint64_t) result != unsigned_sum );
+        int64_t signed_sum = (int64_t) (int32_t) x + (int64_t) (int32_t) y + (int64_t) carry;
+        fV = ( ( (int64_t) (int32_t) result ) != signed_sum );
+    }
+
+    lazy_kind = lazy_none;
+} //compute_lazy_flags
+
+uint64_t Arm64::shift_reg64( uint64_t reg, uint64_t shift_type, uint64_t amount )
+{
+    uint64_t val = val_reg_or_zr( reg );
+    amount &= 0x3f;
+    if ( 0 == amount )
+        return val;
+
+    if ( 0 == shift_type ) // lsl
+        val <<= amount;
+    else if ( 1 == shift_type ) // lsr
+        val >>= amount;
+    else if ( 2 == shift_type ) // asr
+        val = (uint64_t) ( ( (int64_t) val ) >> amount ); // modern C compilers do the right thing
+    else if ( 3 == shift_type ) // ror.
+        val = ( ( val >> amount ) | ( val << ( 64 - amount ) ) );
+    else
+        unhandled();
+
+    return val;
+} //shift_reg64
+
+uint32_t Arm64::shift_reg32( uint64_t reg, uint64_t shift_type, uint64_t amount )
+{
+    uint32_t val = ( 31 == reg ) ? 0 : (uint32_t) regs[ reg ];
+    amount &= 0x1f;
+    if ( 0 == amount )
+        return val;
+
+    if ( 0 == shift_type ) // lsl
+        val <<= amount;
+    else if ( 1 == shift_type ) // lsr
+        val >>= amount;
+    else if ( 2 == shift_type ) // asr
+        val = (uint32_t) ( (int32_t) val >> amount ); // modern C compilers do the right thing
+    else if ( 3 == shift_type ) // ror.
+        val = ( ( val >> amount ) | ( val << ( 32 - amount ) ) );
+    else
+        unhandled();
+
+    return val;
+} //shift_reg32
+
+double set_double_sign( double d, bool sign )
+{
+    uint64_t val = sign ? ( ( * (uint64_t *) &d ) | 0x8000000000000000 ) : ( ( * (uint64_t *) &d ) & 0x7fffffffffffffff );
+    return * (double *) &val;
+} //set_double_sign
+
+static double fsub_special( double a, double b )
+{
+    if ( isinf( a ) && isinf( b ) )
+    {
+        if ( signbit( a ) != signbit( b ) )
+            return a;
+        return MY_NAN; // msft C will return -nan if this check isn't here
+    }
+
+    if ( isnan( a ) )
+        return a;
+
+    if ( isnan( b ) )
+        return b;
+
+    return a - b;
+} //fsub_special
+
+static double fadd_special( double a, double b )
+{
+    bool ainf = isinf( a );
+    bool binf = isinf( b );
+
+    if ( ainf && binf )
+    {
+        if ( signbit( a ) == signbit( b ) )
+            return a;
+        return MY_NAN; // msft C will return -nan if this check isn't here
+    }
+
+    if ( isnan( a ) )
+        return a;
+
+    if ( isnan( b ) )
+        return b;
+
+    if ( ainf )
+        return a;
+
+    if ( binf )
+        return b;
+
+    return a + b;
+} //fadd_special
+
+static double fmul_special( double a, double b )
+{
+    if ( isnan( a ) )
+        return a;
+
+    if ( isnan( b ) )
+        return b;
+
+    bool ainf = isinf( a );
+    bool binf = isinf( b );
+    bool azero = ( 0.0 == a );
+    bool bzero = ( 0.0 == b );
+
+    if ( ( ainf && bzero ) || ( azero && binf ) )
+        return MY_NAN;
+
+    if ( ainf && binf )
+        set_double_sign( INFINITY, ( signbit( a ) != signbit( b ) ) );
+
+    if ( ainf || binf )
+        return set_double_sign( INFINITY, signbit( a ) != signbit( b ) );
+
+    if ( azero || bzero )
+        return set_double_sign( 0.0, signbit( a ) != signbit( b ) );
+
+    return a * b;
+} //fmul_special
+
+static double fdiv_special( double a, double b )
+{
+    if ( isnan( a ) )
+        return a;
+
+    if ( isnan( b ) )
+        return b;
+
+    bool ainf = isinf( a );
+    bool binf = isinf( b );
+    bool azero = ( 0.0 == a );
+    bool bzero = ( 0.0 == b );
+
+    if ( ( ainf && binf ) || ( azero && bzero ) )
+        return MY_NAN;
+
+    if ( ainf )
+        return set_double_sign( INFINITY, signbit( a ) != signbit( b ) );
+
+    if ( binf )
+        return set_double_sign( 0.0, signbit( a ) != signbit( b ) );
+
+    if ( azero )
+        return set_double_sign( 0.0, signbit( a ) != signbit( b ) );
+
+    return a / b;
+} //fdiv_special
+
+static double fmin_special( double a, double b )
+{
+    if ( ( 0.0 == a ) && ( 0.0 == b ) )
+    {
+        if ( signbit( a ) )
+            return a;
+        return b;
+    }
+
+    bool anan = isnan( a );
+    bool bnan = isnan( b );
+
+    if ( anan && bnan )
+        return a;         // not clearly documented, but this is what hardware does
+
+    if ( anan )
+        return b;
+
+    if ( bnan )
+        return a;
+
+    return get_min( a, b );
+} //fmin_special
+
+static double fmax_special( double a, double b )
+{
+    if ( ( 0.0 == a ) && ( 0.0 == b ) )
+    {
+        if ( signbit( a ) )
+            return b;
+        return a;
+    }
+
+    bool anan = isnan( a );
+    bool bnan = isnan( b );
+
+    if ( anan && bnan )
+        return a;         // not clearly documented, but this is what hardware does
+
+    if ( anan )
+        return b;
+
+    if ( bnan )
+        return a;
+
+    return get_max( a, b );
+} //fmax_special
+
+// the host's IEEE arithmetic gives the Arm result for everything but NaNs, which Arm propagates differently
+// (and for which msft C returns -nan). the special functions above handle those and the min/max corner cases
+
+static __inline_perf double do_fsub( double a, double b )
+{
+    double r = a - b;
+    if ( !isnan( r ) )
+        return r;
+    return fsub_special( a, b );
+} //do_fsub
+
+static __inline_perf double do_fadd( double a, double b )
+{
+    double r = a + b;
+    if ( !isnan( r ) )
+        return r;
+    return fadd_special( a, b );
+} //do_fadd
+
+static __inline_perf double do_fmul( double a, double b )
+{
+    double r = a * b;
+    if ( !isnan( r ) )
+        return r;
+    return fmul_special( a, b );
+} //do_fmul
+
+static __inline_perf double do_fdiv( double a, double b )
+{
+    double r = a / b;
+    if ( !isnan( r ) )
+        return r;
+    return fdiv_special( a, b );
+} //do_fdiv
+
+static __inline_perf double do_fmin( double a, double b )
+{
+    if ( a < b )
+        return a;
+    if ( b < a )
+        return b;
+    return fmin_special( a, b ); // equal values including signed zeros, or a NaN
+} //do_fmin
+
+static __inline_perf double do_fmax( double a, double b )
+{
+    if ( a > b )
+        return a;
+    if ( b > a )
+        return b;
+    return fmax_special( a, b );
+} //do_fmax
 
-            if ( 0x1f != t2 )
-                unhandled();
+// fused multiply-add ( a * b ) + c with a single rounding like FMADD and FMLA. the host's fma() does that;
+// NaN results go through the unfused special cases to get Arm's NaN propagation
 
-            if ( 0 == L ) // stxr, stlr
-            {
-                if ( bit23 )
-                    tracer.Trace( "stlr %s, [%s]\n", reg_or_zr( t, bit30 ), reg_or_sp( n, bit30 ) );
-                else
-                    tracer.Trace( "%s %s, %s, [ %s ]\n", ( 1 == oO ) ? "stlxr" : "stxr", reg_or_zr( s, false ), reg_or_zr( t, ( 0xc8 == hi8 ) ), reg_or_sp( n, true ) );
-            }
-            else if ( 2 == L ) // ldxr and ldaxr
-            {
-                if ( 0x1f != s )
-                    unhandled();
-                tracer.Trace( "%s %s, [ %s ]\n", ( 1 == oO ) ? "ldaxr" : "ldxr", reg_or_zr( t, ( 0xc8 == hi8 ) ), reg_or_sp( n, true ) );
-            }
-            break;
-        }
-        case 0xd6: // BLR <Xn>    ;    BR <Xn>    ;    RET {<Xn>}
-        {
-            uint64_t n = opbits( 5, 5 );
-            uint64_t theop = opbits( 21, 2 );
-            uint64_t bit23 = opbit( 23 );
-            uint64_t op2 = opbits( 12, 9 );
-            uint64_t A = opbit( 11 );
-            uint64_t M = opbit( 10 );
-            if ( 0 != bit23 )
-                unhandled();
-            if ( 0x1f0 != op2 )
-                unhandled();
-            if ( ( 0 != A ) || ( 0 != M ) )
-                unhandled();
+static __inline_perf double do_fmadd( double a, double b, double c )
+{
+    double r = fma( a, b, c );
+    if ( !isnan( r ) )
+        return r;
+    return fadd_special( fmul_special( a, b ), c );
+} //do_fmadd
 
-            if ( 0 == theop ) // br
-                tracer.Trace( "br x%llu\n", n );
-            else if ( 1 == theop ) // blr
-                tracer.Trace( "blr x%llu\n", n );
-            else if ( 2 == theop ) // ret
-                tracer.Trace( "ret x%llu\n", n );
+static __inline_perf float do_fmaddf( float a, float b, float c )
+{
+    float r = fmaf( a, b, c );
+    if ( !isnan( r ) )
+        return r;
+    return (float) fadd_special( fmul_special( a, b ), c );
+} //do_fmaddf
+
+// evaluate a condition directly from the operands of a pending compare a - b. returns -1 for VS and VC,
+// which need the flags computed.
+
+template <typename U, typename S> static __inline_perf int compare_conditional( U a, U b, uint64_t cond )
+{
+    switch ( cond & 0xf )
+    {
+        case 0: { return ( a == b ); }
+        case 1: { return ( a != b ); }
+        case 2: { return ( a >= b ); }
+        case 3: { return ( a < b ); }
+        case 4: { return ( (S) (U) ( a - b ) < 0 ); }
+        case 5: { return ( (S) (U) ( a - b ) >= 0 ); }
+        case 8: { return ( a > b ); }
+        case 9: { return ( a <= b ); }
+        case 10: { return ( (S) a >= (S) b ); }
+        case 11: { return ( (S) a < (S) b ); }
+        case 12: { return ( (S) a > (S) b ); }
+        case 13: { return ( (S) a <= (S) b ); }
+        case 14: case 15: { return 1; }
+        default: { return -1; }
+    }
+} //compare_conditional
+
+bool Arm64::check_conditional( uint64_t cond )
+{
+    assert( cond <= 15 );
+
+    if ( lazy_none != lazy_kind )
+    {
+        // add with carry in of x and y sets the same flags as the subtraction x - ~y, so with a carry in
+        // of 1 (subs, cmp, and friends) conditions are just comparisons of the operands.
+
+        int result = -1;
+        if ( lazy_carry )
+        {
+            if ( lazy_add64 == lazy_kind )
+                result = compare_conditional<uint64_t, int64_t>( lazy_x, ~lazy_y, cond );
             else
-                unhandled();
-            break;
+                result = compare_conditional<uint32_t, int32_t>( (uint32_t) lazy_x, (uint32_t) ~lazy_y, cond );
         }
-        case 0x72: // MOVK <Wd>, #<imm>{, LSL #<shift>}       ;  ANDS <Wd>, <Wn>, #<imm>
-        case 0xf2: // MOVK <Xd>, #<imm>{, LSL #<shift>}       ;  ANDS <Xd>, <Xn>, #<imm>
+
+        if ( -1 != result )
+            return ( 0 != result );
+
+        compute_lazy_flags();
+    }
+
+    switch ( cond & 0xf ) // do the reduant mask so the msft compiler doesn't add a conditional
+    {
+        case 0: { return fZ; }                          // EQ = Zero / Equal
+        case 1: { return !fZ; }                         // NE = Not Equal
+        case 2: { return fC; }                          // CS = Carry Set
+        case 3: { return !fC; }                         // CC = Carry Clear
+        case 4: { return fN; }                          // MI = Minus / Negative
+        case 5: { return !fN; }                         // PL = Plus. Positive or Zero
+        case 6: { return fV;  }                         // VS = Overflow Set
+        case 7: { return !fV;  }                        // VC = Overflow Clear
+        case 8: { return ( fC && !fZ ); }               // HI = Unsigned Higher
+        case 9: { return ( !fC || fZ ); }               // LS = Lower or Same
+        case 10: { return ( fN == fV ); }               // GE = Signed Greater Than or Equal
+        case 11: { return ( fN != fV ); }               // LT = Signed Less Than
+        case 12: { return ( ( fN == fV ) && !fZ ); }    // GT = Signed Greater Than
+        case 13: { return ( ( fN != fV ) || fZ ); }     // LE = Signed Less Than or Equal
+        case 14: case 15:
+        default: { return true; }                       // AL = Always true. not used in practice. 14 and 15
+    }
+} //check_conditional
+
+void Arm64::set_flags_from_double( double result )
+{
+    lazy_kind = lazy_none;
+    if ( isnan( result ) )
+    {
+        fN = fZ = false;
+        fC = fV = true;
+    }
+    else if ( result > 0.0 )
+    {
+        fN = fZ = fV = false;
+        fC = true;
+    }
+    else if ( result < 0.0 )
+    {
+        fN = true;
+        fZ = fC = fV = false;
+    }
+    else
+    {
+        fN = fV = false;
+        fZ = fC = true;
+    }
+} //set_flags_from_double
+
+#ifdef _WIN32
+__declspec(noinline)
+#endif
+void Arm64::force_trace_vregs()
+{
+    for ( uint64_t i = 0; i < _countof( vregs ); i++ )
+    {
+        if ( memcmp( &vec_zeroes, &vregs[ i ], sizeof( vec_zeroes ) ) )
         {
-            uint64_t xregs = ( 0 != ( 0x80 & hi8 ) );
-            uint64_t bit23 = opbit( 23 ); // 1 for MOVK, 0 for ANDS
-            if ( bit23 ) // MOVK
-            {
-                uint64_t hw = opbits( 21, 2 );
-                uint64_t pos = ( hw << 4 );
-                uint64_t imm16 = opbits( 5, 16 );
-                uint64_t d = opbits( 0, 5 );
-                tracer.Trace( "movk %s, #%#llx, LSL #%llu\n", reg_or_zr( d, xregs ), imm16, pos );
-            }
-            else // ANDS
-            {
-                uint64_t N_immr_imms = opbits( 10, 13 );
-                uint64_t op2 = decode_logical_immediate( N_immr_imms, xregs ? 64 : 32 );
-                uint64_t n = opbits( 5, 5 );
-                uint64_t d = opbits( 0, 5 );
-                tracer.Trace( "ands %s, %s, #%#llx\n", reg_or_zr( d, xregs ), reg_or_zr( n, xregs ), op2 );
-            }
-            break;
+            tracer.Trace( "    vreg %2llu: ", i );
+            tracer.TraceBinaryData( (uint8_t *) & vregs[ i ], 16, 4 );
         }
-        case 0x38: // B
-        case 0x78: // H
-        case 0xb8: // W
-        case 0xf8: // X
-        {
-            // LDR <Xt>, [<Xn|SP>, (<Wm>|<Xm>){, <extend> {<amount>}}]
-            // LDR <Xt>, [<Xn|SP>], #<simm>
-            // LDR <Xt>, [<Xn|SP>, #<simm>]!
-            // STR <Xt>, [<Xn|SP>, (<Wm>|<Xm>){, <extend> {<amount>}}]
-            // STR <Xt>, [<Xn|SP>], #<simm>
-            // STR <Xt>, [<Xn|SP>, #<simm>]!
-            // W, H and B variants use <Wt> as the first argument
-            // H and B variants use LDRH, STRH, LDRB, STRB instructions. W and X variants use STR and LDR
-            // LDR has sign-extend LDRSx and LDURSW variants
+    }
+} //trace_vregs
 
-            uint64_t opc = opbits( 21, 3 );
-            uint64_t n = opbits( 5, 5 );
-            uint64_t t = opbits( 0, 5 );
-            bool xregs = ( 0 != opbit( 30 ) );
+void Arm64::trace_vregs()
+{
+    if ( !tracer.IsEnabled() ) // can happen when an app enables instruction tracing via a syscall but overall tracing is turned off.
+        return;
 
-            const char * suffix = "";
-            if ( 0x38 == hi8 )
-                suffix = "b";
-            else if ( 0x78 == hi8 )
-                suffix = "h";
+    if ( ! ( g_State & stateTraceInstructions ) || !in_trace_filter() )
+        return;
 
-            char prefix = 'w';
-            if ( xregs )
-                prefix = 'x';
+    force_trace_vregs();
+} //trace_vregs
 
-            if ( 0 == opc ) // str (immediate) post-index and pre-index
-            {
-                uint64_t unsigned_imm9 = opbits( 12, 9 );
-                int64_t extended_imm9 = sign_extend( unsigned_imm9, 8 );
-                uint64_t option = opbits( 10, 2 );
-                if ( 0 == option) // // STUR <Xt>, [<Xn|SP>{, #<simm>}]
-                    tracer.Trace( "stur%s %s, %s, #%lld // so\n", suffix, reg_or_zr( t, xregs ), reg_or_sp( n, xregs ), extended_imm9 );
-                else if ( 1 == option) // post-index STR <Xt>, [<Xn|SP>], #<simm>
-                    tracer.Trace( "str%s %c%llu, %s, #%lld // po\n", suffix, prefix, t, reg_or_sp( n, true ), extended_imm9 );
-                else if ( 3 == option ) // pre-index STR <Xt>, [<Xn|SP>, #<simm>]!
-                    tracer.Trace( "str%s %c%llu, [%s, #%lld]! //pr\n", suffix, prefix, t, reg_or_sp( n, true ), extended_imm9 );
-                else
-                    unhandled();
-            }
-            else if ( 1 == opc ) // STR <Xt>, [<Xn|SP>, (<Wm>|<Xm>){, <extend> {<amount>}}]
-            {
-                uint64_t m = opbits( 16, 5 );
-                uint64_t shift = opbit( 12 );
-                uint64_t option = opbits( 13, 3 );
-                tracer.Trace( "str%s %s, [ %s, x%llu, %s #%llu]\n", suffix, reg_or_zr( t, xregs ), reg_or_sp( n, true ), m, extend_type( option ),
-                              ( 3 == option ) ? 0 : ( 0 == shift ) ? 0ull : xregs ? 3ull : 2ull );
-            }
-            else if ( 2 == opc ) // ldr (immediate)
-            {
-                uint64_t unsigned_imm9 = opbits( 12, 9 );
-                int64_t extended_imm9 = sign_extend( unsigned_imm9, 8 );
-                uint64_t option = opbits( 10, 2 );
-                if ( 0 == option) // LDUR <Xt>, [<Xn|SP>{, #<simm>}]
-                    tracer.Trace( "ldur%s %c%llu, [%s, #%lld] //so\n", suffix, prefix, t, reg_or_sp( n, true ), extended_imm9 );
-                else if ( 1 == option) // post-index LDR <Xt>, [<Xn|SP>], #<simm>
-                    tracer.Trace( "ldr%s %c%llu, [%s], #%lld //po\n", suffix, prefix, t, reg_or_sp( n, true ), extended_imm9 );
-                else if ( 3 == option ) // pre-index LDR <Xt>, [<Xn|SP>, #<simm>]!
-                    tracer.Trace( "ldr%s %c%llu, [%s, #%lld]! //pr\n", suffix, prefix, t, reg_or_sp( n, true ), extended_imm9 );
-                else
-                    unhandled();
-            }
-            else if ( 3 == opc ) // LDR <Xt>, [<Xn|SP>, (<Wm>|<Xm>){, <extend> {<amount>}}]
-            {
-                uint64_t m = opbits( 16, 5 );
-                uint64_t shift = opbit( 12 );
-                uint64_t option = opbits( 13, 3 );
-                tracer.Trace( "ldr%s %s, [%s, %s, %s #%llu]\n", suffix, reg_or_zr( t, xregs ), reg_or_sp( n, true ), reg_or_zr( m, true ),
-                              extend_type( option ), ( 0 == shift ) ? 0ull : xregs ? 3ull : 2ull );
-            }
-            else if ( 4 == opc || 6 == opc ) // LDRSW <Xt>, [<Xn|SP>], #<simm>    ;    LDRSW <Xt>, [<Xn|SP>, #<simm>]!
-            {
-                uint64_t bits11_10 = opbits( 10, 2 );
-                if ( 0 == bits11_10 ) // LDURSB <Wt>, [<Xn|SP>{, #<simm>}]    ;    LDURSB <Xt>, [<Xn|SP>{, #<simm>}]
-                {
-                    bool isx = ( 0 == opbit( 22 ) );
-                    int64_t imm9 = sign_extend( opbits( 12, 9 ), 8 );
-                    tracer.Trace( "ldurs%s %s, [%s, #%lld]\n", suffix, reg_or_zr( t, isx ), reg_or_sp( n, true ), imm9 );
-                }
-                else
-                {
-                    uint64_t preindex = opbit( 11 ); // 1 for pre, 0 for post increment
-                    int64_t imm9 = sign_extend( opbits( 12, 9 ), 8 );
-                    xregs = ( 4 == opc );
-                    if ( preindex )
-                        tracer.Trace( "ldrs%s %s [%s, #%lld]! // pr\n", suffix, reg_or_zr( t, xregs ), reg_or_sp( n, true ), imm9 );
-                    else
-                        tracer.Trace( "ldrs%s %s [%s], #%lld // po\n", suffix, reg_or_zr( t, xregs ), reg_or_sp( n, true ), imm9 );
-                }
-            }
-            else if ( 5 == opc  || 7 == opc ) // hi8 = 0x78
-                                              //     (opc == 7)                  LDRSH <Wt>, [<Xn|SP>, (<Wm>|<Xm>){, <extend> {<amount>}}]
-                                              //     (opc == 5)                  LDRSH <Xt>, [<Xn|SP>, (<Wm>|<Xm>){, <extend> {<amount>}}]
-                                              // hi8 = 0x38
-                                              //     (opc == 7 && option != 011) LDRSB <Wt>, [<Xn|SP>, (<Wm>|<Xm>), <extend> {<amount>}]
-                                              //     (opc == 5 && option != 011) LDRSB <Xt>, [<Xn|SP>, (<Wm>|<Xm>), <extend> {<amount>}]
-                                              //     (opc == 7 && option == 011) LDRSB <Wt>, [<Xn|SP>, <Xm>{, LSL <amount>}]
-                                              //     (opc == 5 && option == 011) LDRSB <Xt>, [<Xn|SP>, <Xm>{, LSL <amount>}]
-                                              // hi8 == 0xb8
-                                              //     (opc == 5 && option = many) LDRSW <Xt>, [<Xn|SP>, (<Wm>|<Xm>){, <extend> {<amount>}}]
-            {
-                uint64_t m = opbits( 16, 5 );
-                uint64_t shift = opbit( 12 );
-                uint64_t option = opbits( 13, 3 );
-                bool mIsX = ( 1 == ( option & 1 ) );
-                bool tIsX = ( 5 == opc );
+void Arm64::flush_predecode()
+{
+    fold_block_counts();
+    if ( 0 != block_table )
+        memset( block_table, 0, block_table_entries * sizeof( uint32_t ) );
+    block_count = 0;
+    block_op_count = 0;
+    pdc_lo = 0;
+    pdc_hi = 0;
+    code_modified = false;
+    if ( 0 != jit )
+        jit->reset();
+} //flush_predecode
+
+void Arm64::enable_predecode( bool enable )
+{
+    if ( enable && ( 0 == blocks ) )
+    {
+        blocks = new BasicBlock[ block_capacity ];
+        block_ops = new PredecodedOp[ block_op_capacity ];
+        block_table = new uint32_t[ block_table_entries ];
+    }
+
+    flush_predecode();
+    predecode_enabled = enable;
+    code_rewritten = false;
+} //enable_predecode
+
+// export_predecode() data: a header, the blocks, then the instructions. blocks keep their chains since those are
+// indexes into the same arrays. execution counts aren't saved. with jit code, next come the offset of each block's
+// translation in the code (or no_translation) and the code, which only refers to guest addresses and Arm64 members
 
-                if ( 0xb8 == hi8 )
-                    tracer.Trace( "ldrsw %s, [%s, %s, %s, %llu]\n", reg_or_zr( t, true ), reg_or_sp( n, true ), reg_or_zr( m, option & 1 ), extend_type( option ), shift ? 2 : 0 );
-                else if ( 0x38 == hi8 )
-                {
-                    if ( 3 == option )
-                        tracer.Trace( "ldrsb %s, [%s, x%llu {, LSL %lluu}]\n", reg_or_zr( t, tIsX ), reg_or_sp( n, true ), m, shift );
-                    else
-                        tracer.Trace( "ldrsb %s, [%s, %s, %s {#%llu}]\n", reg_or_zr( t, tIsX ), reg_or_sp( n, true ), reg_or_zr( m, mIsX ), extend_type( option ), shift );
-                }
-                else if ( 0x78 == hi8 )
-                    tracer.Trace( "ldrsh %s, [%s, %s {, %s #%llu}]\n", reg_or_zr( t, tIsX ), reg_or_sp( n, true ),
-                                  reg_or_zr( m, mIsX ), extend_type( option ), shift );
-                else
-                    unhandled();
-            }
-            else
-                unhandled();
+struct PredecodeImageHeader
+{
+    uint64_t build;                 // hash of when this file was compiled, since handler numbers change between builds
+    uint64_t intercepts;            // hash of the set_intercepts() table
+    uint64_t pdc_lo, pdc_hi;
+    uint32_t block_size;
+    uint32_t op_size;
+    uint32_t block_count;
+    uint32_t op_count;
+    uint32_t jit_bytes;             // 0 if there's no jit code
+    uint32_t reserved;
+};
 
-            break;
+static const uint32_t no_translation = 0xffffffff;
+
+static uint64_t predecode_build_hash()
+{
+    static const char build[] = __DATE__ " " __TIME__;
+    return fnv1a( build, sizeof( build ) );
+} //predecode_build_hash
+
+bool Arm64::export_predecode( std::vector<uint8_t> & data, uint64_t lo, uint64_t hi, bool include_jit )
+{
+    if ( code_rewritten || ( 0 == block_count ) || ( pdc_lo < lo ) || ( pdc_hi > hi ) )
+        return false;
+
+    PredecodeImageHeader h;
+    memset( &h, 0, sizeof( h ) );
+    h.build = predecode_build_hash();
+    h.intercepts = fnv1a( intercepts, 2 * intercept_count * sizeof( uint64_t ) );
+    h.pdc_lo = pdc_lo;
+    h.pdc_hi = pdc_hi;
+    h.block_size = sizeof( BasicBlock );
+    h.op_size = sizeof( PredecodedOp );
+    h.block_count = block_count;
+    h.op_count = block_op_count;
+    if ( include_jit && ( 0 != jit ) )
+        h.jit_bytes = (uint32_t) jit->code_bytes();
+
+    size_t block_bytes = block_count * sizeof( BasicBlock );
+    size_t op_bytes = block_op_count * sizeof( PredecodedOp );
+    size_t offset_bytes = ( 0 == h.jit_bytes ) ? 0 : block_count * sizeof( uint32_t );
+    data.resize( sizeof( h ) + block_bytes + op_bytes + offset_bytes + h.jit_bytes );
+    memcpy( data.data(), &h, sizeof( h ) );
+    memcpy( data.data() + sizeof( h ), blocks, block_bytes );
+    memcpy( data.data() + sizeof( h ) + block_bytes, block_ops, op_bytes );
+
+    BasicBlock * pb = (BasicBlock *) ( data.data() + sizeof( h ) );
+    for ( uint32_t i = 0; i < block_count; i++ )
+    {
+        pb[ i ].executions = 0;
+        pb[ i ].mix_executions = 0;
+        pb[ i ].profile_executions = 0;
+        pb[ i ].profile_next[ 0 ] = 0;
+        pb[ i ].profile_next[ 1 ] = 0;
+        pb[ i ].jitted = 0;
+    }
+
+    if ( 0 != h.jit_bytes )
+    {
+        uint8_t * po = data.data() + sizeof( h ) + block_bytes + op_bytes;
+        for ( uint32_t i = 0; i < block_count; i++ )
+        {
+            uint32_t offset = ( 0 == blocks[ i ].jitted ) ? no_translation : (uint32_t) ( (const uint8_t *) blocks[ i ].jitted - jit->code_base() );
+            memcpy( po + i * sizeof( uint32_t ), &offset, sizeof( offset ) );
         }
-        case 0x39: // B
-        case 0x79: // H                              ;    LDRSH <Wt>, [<Xn|SP>{, #<pimm>}]
-        case 0xb9: // W
-        case 0xf9: // X ldr + str unsigned offset    ;    LDRSW <Xt>, [<Xn|SP>{, #<pimm>}]
+        memcpy( po + offset_bytes, jit->code_base(), h.jit_bytes );
+    }
+    return true;
+} //export_predecode
+
+bool Arm64::import_predecode( const uint8_t * data, size_t size, uint64_t lo, uint64_t hi )
+{
+    if ( !predecode_enabled || ( size < sizeof( PredecodeImageHeader ) ) )
+        return false;
+
+    PredecodeImageHeader h;
+    memcpy( &h, data, sizeof( h ) );
+    size_t block_bytes = (size_t) h.block_count * sizeof( BasicBlock );
+    size_t op_bytes = (size_t) h.op_count * sizeof( PredecodedOp );
+    size_t offset_bytes = ( 0 == h.jit_bytes ) ? 0 : (size_t) h.block_count * sizeof( uint32_t );
+    if ( ( predecode_build_hash() != h.build ) || ( sizeof( BasicBlock ) != h.block_size ) || ( sizeof( PredecodedOp ) != h.op_size ) ||
+         ( fnv1a( intercepts, 2 * intercept_count * sizeof( uint64_t ) ) != h.intercepts ) ||
+         ( h.block_count >= block_capacity ) || ( ( h.op_count + max_block_ops ) > block_op_capacity ) ||
+         ( h.pdc_lo < lo ) || ( h.pdc_hi > hi ) || ( h.pdc_lo >= h.pdc_hi ) || !is_address_valid( h.pdc_lo ) ||
+         !is_address_valid( h.pdc_hi - 1 ) ||
+         ( size != ( sizeof( h ) + block_bytes + op_bytes + offset_bytes + h.jit_bytes ) ) )
+        return false;
+
+    // check the blocks fit together so a damaged file can't send run() outside of the arrays, that chains lead to
+    // the blocks for their addresses, and that each block's instructions are the image's as loaded
+
+    const BasicBlock * pb = (const BasicBlock *) ( data + sizeof( h ) );
+    const PredecodedOp * po = (const PredecodedOp * ) ( data + sizeof( h ) + block_bytes );
+    for ( uint32_t i = 0; i < h.block_count; i++ )
+    {
+        const BasicBlock & b = pb[ i ];
+        if ( ( 0 == b.count ) || ( b.count > max_block_ops ) || ( b.first > h.op_count ) || ( b.count > ( h.op_count - b.first ) ) ||
+             ( 0 != ( b.pc & 3 ) ) || ( b.pc < h.pdc_lo ) || ( b.pc >= h.pdc_hi ) || ( b.count > ( ( h.pdc_hi - b.pc ) / 4 ) ) )
+            return false;
+
+        for ( uint32_t k = 0; k < 2; k++ )
+            if ( ( 0 != b.next_pc[ k ] ) && ( ( b.next[ k ] >= h.block_count ) || ( pb[ b.next[ k ] ].pc != b.next_pc[ k ] ) ) )
+                return false;
+
+        for ( uint32_t k = 0; k < b.count; k++ )
         {
-            // LDR <Xt>, [<Xn|SP>{, #<pimm>}]
-            // STR <Xt>, [<Xn|SP>{, #<pimm>}]
+            const PredecodedOp & pd = po[ b.first + k ];
+            if ( ( pd.pc != ( b.pc + 4 * k ) ) || ( pd.op != getui32( pd.pc ) ) )
+                return false;
 
-            uint64_t opc = opbits( 22, 2 );
-            uint64_t imm12 = opbits( 10, 12 );
-            uint64_t lsl = opbits( 30, 2 );
-            imm12 <<= lsl;
-            uint64_t t = opbits( 0, 5 );
-            uint64_t n = opbits( 5, 5 );
+            uint32_t routine;
+            if ( ( pdh_intercept == pd.handler ) && ( !find_intercept( pd.pc, routine ) || ( (int64_t) routine != pd.imm ) ) )
+                return false;
+        }
+    }
 
-            const char * suffix = "";
-            if ( 0x39 == hi8 )
-                suffix = "b";
-            else if ( 0x79 == hi8 )
-                suffix = "h";
+    for ( uint32_t i = 0; i < h.op_count; i++ )
+        if ( ( po[ i ].handler > pdh_epilogue ) || ( ( po[ i ].d | po[ i ].n | po[ i ].m ) > 31 ) )
+            return false;
 
-            char prefix = 'w';
-            if ( 0xf9 == hi8 )
-                prefix = 'x';
+    const uint8_t * poffsets = data + sizeof( h ) + block_bytes + op_bytes;
+    for ( uint32_t i = 0; i < h.block_count && ( 0 != h.jit_bytes ); i++ )
+    {
+        uint32_t offset;
+        memcpy( &offset, poffsets + i * sizeof( uint32_t ), sizeof( offset ) );
+        if ( ( no_translation != offset ) && ( offset >= h.jit_bytes ) )
+            return false;
+    }
 
-            if ( 0 == opc )
-                tracer.Trace( "str%s %s, [%s,#%llu] //uo\n", suffix, reg_or_zr( t, ( 0xf9 == hi8 ) ), reg_or_sp( n, true ), imm12 );
-            else if ( 1 == opc )
-                tracer.Trace( "ldr%s %c%llu, [%s,#%llu] //uo\n", suffix, prefix, t, reg_or_sp( n, true ), imm12 );
-            else if ( 2 == opc || 3 == opc )
-                tracer.Trace( "ldrs%s %c%llu, [%s,#%llu] //uo\n", suffix, prefix, t, reg_or_sp( n, true ), imm12 );
-            else
-                unhandled();
+    flush_predecode();
+    memcpy( blocks, pb, block_bytes );
+    memcpy( block_ops, po, op_bytes );
+    block_count = h.block_count;
+    block_op_count = h.op_count;
+    pdc_lo = h.pdc_lo;
+    pdc_hi = h.pdc_hi;
 
-            break;
+    for ( uint32_t i = 0; i < block_count; i++ )
+        block_table[ ( blocks[ i ].pc >> 2 ) & ( block_table_entries - 1 ) ] = i + 1;
+
+    // without the jit, or if its code doesn't fit, blocks are translated as they get hot like always
+
+    if ( ( 0 != h.jit_bytes ) && ( 0 != jit ) && jit->load( poffsets + offset_bytes, h.jit_bytes ) )
+    {
+        for ( uint32_t i = 0; i < block_count; i++ )
+        {
+            uint32_t offset;
+            memcpy( &offset, poffsets + i * sizeof( uint32_t ), sizeof( offset ) );
+            if ( no_translation != offset )
+                blocks[ i ].jitted = (Arm64JitFunction) ( jit->code_base() + offset );
         }
-        default:
-            unhandled();
     }
 
-    static char acregs[ 32 * 32 + 10 ]; // way too much.
-    acregs[ 0 ] = 0;
-    int len = 0;
-    for ( int r = 0; r < 31; r++ )
-        if ( 0 != regs[ r ] )
-            len += snprintf( & acregs[ len ], 32, "%u:%llx ", r, regs[ r ] );
-    len += snprintf( &acregs[ len ], 32, "sp:%llx", regs[ 31 ] );
-    tracer.Trace( "         %s\n", acregs );
-} //trace_state
+    return true;
+} //import_predecode
 
-// N (negative): Set if the result is negative
-// Z (zero): Set if the result is zero
-// C (carry): Set if the result cannot be represented as an unsigned integer
-// V (overflow): Set if the result cannot be represented as a signed integer
+static uint32_t block_successors( uint32_t op, uint64_t pc, uint64_t * next )
+{
+    // where a block ending with op at pc can go without an indirect branch. returns how many are written to next
 
-uint64_t Arm64::add_with_carry64( uint64_t x, uint64_t y, bool carry, bool setflags )
+    uint32_t count = 0;
+    bool falls_through = true;
+    uint32_t hi8 = op >> 24;
+
+    if ( 0x14 == ( hi8 & 0x7c ) ) // b, bl
+    {
+        next[ count++ ] = pc + ( sign_extend( op & 0x3ffffff, 25 ) * 4 );
+        falls_through = ( 0 != ( op & 0x80000000 ) );
+    }
+    else if ( 0x54 == hi8 ) // b.cond
+    {
+        next[ count++ ] = pc + ( sign_extend( ( op >> 5 ) & 0x7ffff, 18 ) * 4 );
+        falls_through = ( ( op & 0xf ) < 14 );
+    }
+    else if ( 0x34 == ( hi8 & 0x7e ) ) // cbz, cbnz
+        next[ count++ ] = pc + ( sign_extend( ( op >> 5 ) & 0x7ffff, 18 ) * 4 );
+    else if ( 0x36 == ( hi8 & 0x7e ) ) // tbz, tbnz
+        next[ count++ ] = pc + ( sign_extend( ( op >> 5 ) & 0x3fff, 13 ) * 4 );
+    else if ( 0xd6 == hi8 ) // br, ret, and eret go elsewhere. blr returns
+        falls_through = ( 1 == ( ( op >> 21 ) & 3 ) );
+
+    if ( falls_through )
+        next[ count++ ] = pc + 4;
+    return count;
+} //block_successors
+
+uint32_t Arm64::translate_ahead( const uint64_t * starts, uint32_t count, uint64_t lo, uint64_t hi )
 {
-    uint64_t result = x + y + (uint64_t) carry;
+    // the walk stops at half the cache so the app has room for blocks it can't find, like the targets of indirect
+    // branches, without a flush that would discard everything
 
-    if ( setflags )
+    flush_predecode();
+    std::vector<uint64_t> pending( starts, starts + count );
+    std::unordered_map<uint64_t, uint32_t> built; // pc -> index in blocks[]
+
+    while ( !pending.empty() && ( block_count < ( block_capacity / 2 ) ) && ( ( block_op_count + max_block_ops ) <= ( block_op_capacity / 2 ) ) )
     {
-        int64_t iresult = (int64_t) result;
-        fN = ( iresult < 0 );
-        fZ = ( 0 == result );
+        uint64_t a = pending.back();
+        pending.pop_back();
+        if ( ( a < lo ) || ( ( a + 4 ) > hi ) || ( 0 != ( a & 3 ) ) || ( 0 != built.count( a ) ) )
+            continue;
+
+        BasicBlock * b = build_block( a );
+        uint32_t index = (uint32_t) ( b - blocks );
+        built[ a ] = index;
+        block_table[ ( a >> 2 ) & ( block_table_entries - 1 ) ] = index + 1;
+
+        const PredecodedOp & last = block_ops[ b->first + b->count - 1 ];
+        uint64_t next[ 2 ];
+        uint32_t n = block_successors( last.op, last.pc, next );
+        for ( uint32_t i = 0; i < n; i++ )
+            pending.push_back( next[ i ] );
+    }
 
-        // strangely literal fC computation; there must be a faster way
+    // chain blocks to their successors as run() would, then translate them
 
-        uint64_t u_y = y + (uint64_t) carry;
-        uint64_t u_low = ( ( x & 0xffffffff ) + ( u_y & 0xffffffff ) );
-        uint64_t u_low_carry = ( u_low >> 32 );
-        uint64_t carry_carry = ( ~0ull == y && carry ) ? 1 : 0;
-        uint64_t u_hi = ( ( x >> 32 ) + ( u_y >> 32 ) + u_low_carry + carry_carry );
-        uint64_t u_sum = ( u_hi << 32 ) | ( 0xffffffff & u_low );
-        fC = ( ( result != u_sum ) || ( 0 != ( u_hi >> 32 ) ) );
+    for ( uint32_t i = 0; i < block_count; i++ )
+    {
+        BasicBlock & b = blocks[ i ];
+        const PredecodedOp & last = block_ops[ b.first + b.count - 1 ];
+        uint64_t next[ 2 ];
+        uint32_t n = block_successors( last.op, last.pc, next );
+        uint32_t slot = 0;
+        for ( uint32_t s = 0; s < n; s++ )
+        {
+            std::unordered_map<uint64_t, uint32_t>::iterator it = built.find( next[ s ] );
+            if ( it != built.end() )
+            {
+                b.next_pc[ slot ] = next[ s ];
+                b.next[ slot++ ] = it->second;
+            }
+        }
 
-        int64_t ix = (int64_t) x;
-        int64_t iy = (int64_t) y;
-        fV = ( ( ( ix >= 0 && iy >= 0 ) && ( iresult < ix || iresult < iy ) ) ||
-               ( ( ix < 0 && iy < 0 ) && ( iresult > ix || iresult > iy ) ) );
+        if ( 0 != jit )
+            b.jitted = jit->compile( *this, i );
     }
-    return result;
-} //add_with_carry64
 
-__inline_perf uint64_t Arm64::sub64( uint64_t x, uint64_t y, bool setflags )
-{
-    return add_with_carry64( x, ~y, true, setflags );
-} //sub64
+    return block_count;
+} //translate_ahead
 
-uint32_t Arm64::add_with_carry32( uint32_t x, uint32_t y, bool carry, bool setflags )
+bool Arm64::enable_jit( bool enable )
 {
-    uint64_t unsigned_sum = (uint64_t) x + (uint64_t) y + (uint64_t) carry;
-    uint32_t result = (uint32_t) unsigned_sum;
+    if ( enable && !Arm64Jit::is_supported() )
+        return false;
 
-    if ( setflags )
+    if ( enable )
     {
-        // this method of setting flags is as the Arm documentation suggests
-        fN = ( ( (int32_t) result ) < 0 );
-        fZ = ( 0 == result );
-        fC = ( (uint64_t) result != unsigned_sum );
-        int64_t signed_sum = (int64_t) (int32_t) x + (int64_t) (int32_t) y + (int64_t) carry;
-        fV = ( ( (int64_t) (int32_t) result ) != signed_sum );
+        if ( 0 == jit )
+            jit = new Arm64Jit();
+        enable_predecode( true ); // the jit translates predecoded blocks
+    }
+    else
+    {
+        delete jit;
+        jit = 0;
+        flush_predecode();
     }
-    return result;
-} //add_with_carry32
 
-__inline_perf uint32_t Arm64::sub32( uint32_t x, uint32_t y, bool setflags )
+    return true;
+} //enable_jit
+
+void Arm64::enable_instruction_mix( bool enable )
 {
-    return add_with_carry32( x, ~y, true, setflags );
-} //sub32
+    if ( enable && ( 0 == op_counts ) )
+        op_counts = new OpCounts();
+    else if ( !enable )
+    {
+        delete op_counts;
+        op_counts = 0;
+    }
+} //enable_instruction_mix
 
-uint64_t Arm64::shift_reg64( uint64_t reg, uint64_t shift_type, uint64_t amount )
+void Arm64::enable_branch_profile( bool enable )
 {
-    uint64_t val = val_reg_or_zr( reg );
-    amount &= 0x3f;
-    if ( 0 == amount )
-        return val;
+    if ( enable && ( 0 == profile_ranges ) )
+    {
+        profile_ranges = new EdgeCounts();
+        profile_branches = new EdgeCounts();
+    }
+    else if ( !enable )
+    {
+        delete profile_ranges;
+        delete profile_branches;
+        profile_ranges = 0;
+        profile_branches = 0;
+    }
+} //enable_branch_profile
 
-    if ( 0 == shift_type ) // lsl
-        val <<= amount;
-    else if ( 1 == shift_type ) // lsr
-        val >>= amount;
-    else if ( 2 == shift_type ) // asr
-        val = (uint64_t) ( ( (int64_t) val ) >> amount ); // modern C compilers do the right thing
-    else if ( 3 == shift_type ) // ror.
-        val = ( ( val >> amount ) | ( val << ( 64 - amount ) ) );
-    else
-        unhandled();
+void Arm64::fold_profile_edge( BasicBlock & b, uint32_t slot )
+{
+    // leaving for the next instruction is falling through, not a branch. blocks end early when they get too long
 
-    return val;
-} //shift_reg64
+    uint64_t last = block_ops[ b.first + b.count - 1 ].pc;
+    if ( ( 0 != b.profile_next[ slot ] ) && ( b.next_pc[ slot ] != ( last + 4 ) ) )
+        ( *profile_branches )[ std::make_pair( last, b.next_pc[ slot ] ) ] += b.profile_next[ slot ];
+    b.profile_next[ slot ] = 0;
+} //fold_profile_edge
 
-uint32_t Arm64::shift_reg32( uint64_t reg, uint64_t shift_type, uint64_t amount )
+void Arm64::profile_block_exit( BasicBlock & b )
 {
-    uint32_t val = ( 31 == reg ) ? 0 : (uint32_t) regs[ reg ];
-    amount &= 0x1f;
-    if ( 0 == amount )
-        return val;
+    // the pc is where b went. successors that aren't chained yet are counted here, since find_block() chains them
 
-    if ( 0 == shift_type ) // lsl
-        val <<= amount;
-    else if ( 1 == shift_type ) // lsr
-        val >>= amount;
-    else if ( 2 == shift_type ) // asr
-        val = (uint32_t) ( (int32_t) val >> amount ); // modern C compilers do the right thing
-    else if ( 3 == shift_type ) // ror.
-        val = ( ( val >> amount ) | ( val << ( 32 - amount ) ) );
+    if ( pc == b.next_pc[ 0 ] )
+        b.profile_next[ 0 ]++;
+    else if ( pc == b.next_pc[ 1 ] )
+        b.profile_next[ 1 ]++;
     else
-        unhandled();
-
-    return val;
-} //shift_reg32
+    {
+        uint64_t last = block_ops[ b.first + b.count - 1 ].pc;
+        if ( pc != ( last + 4 ) )
+            ( *profile_branches )[ std::make_pair( last, pc ) ]++;
+    }
+} //profile_block_exit
 
-double set_double_sign( double d, bool sign )
+void Arm64::fold_block_counts()
 {
-    uint64_t val = sign ? ( ( * (uint64_t *) &d ) | 0x8000000000000000 ) : ( ( * (uint64_t *) &d ) & 0x7fffffffffffffff );
-    return * (double *) &val;
-} //set_double_sign
+    if ( ( 0 == op_counts ) && ( 0 == profile_ranges ) )
+        return;
 
-double do_fsub( double a, double b )
-{
-    if ( isinf( a ) && isinf( b ) )
+    for ( uint32_t b = 0; b < block_count; b++ )
     {
-        if ( signbit( a ) != signbit( b ) )
-            return a;
-        return MY_NAN; // msft C will return -nan if this check isn't here
+        BasicBlock & block = blocks[ b ];
+        if ( 0 != profile_ranges )
+        {
+            if ( 0 != block.profile_executions )
+                ( *profile_ranges )[ std::make_pair( block.pc, block_ops[ block.first + block.count - 1 ].pc ) ] += block.profile_executions;
+            block.profile_executions = 0;
+            fold_profile_edge( block, 0 );
+            fold_profile_edge( block, 1 );
+        }
+
+        if ( ( 0 == op_counts ) || ( 0 == block.mix_executions ) )
+            continue;
+
+        for ( uint32_t i = 0; i < block.count; i++ )
+            ( *op_counts )[ block_ops[ block.first + i ].op ] += block.mix_executions;
+        block.mix_executions = 0;
     }
+} //fold_block_counts
 
-    if ( isnan( a ) )
-        return a;
+void Arm64::collect_branch_profile( EdgeCounts & ranges, EdgeCounts & branches )
+{
+    fold_block_counts();
+    if ( 0 == profile_ranges )
+        return;
 
-    if ( isnan( b ) )
-        return b;
+    for ( EdgeCounts::iterator it = profile_ranges->begin(); it != profile_ranges->end(); it++ )
+        ranges[ it->first ] += it->second;
+    for ( EdgeCounts::iterator it = profile_branches->begin(); it != profile_branches->end(); it++ )
+        branches[ it->first ] += it->second;
+    profile_ranges->clear();
+    profile_branches->clear();
+} //collect_branch_profile
 
-    return a - b;
-} //do_fsub
+void Arm64::collect_instruction_mix( OpCounts & counts )
+{
+    fold_block_counts();
+    if ( 0 == op_counts )
+        return;
 
-double do_fadd( double a, double b )
+    for ( OpCounts::iterator it = op_counts->begin(); it != op_counts->end(); it++ )
+        counts[ it->first ] += it->second;
+    op_counts->clear();
+} //collect_instruction_mix
+
+void Arm64::name_instruction_mix( const OpCounts & counts, std::map<std::string, uint64_t> & mix )
 {
-    bool ainf = isinf( a );
-    bool binf = isinf( b );
+    // disassemble each distinct opcode with trace_state() into a temporary file and keep the mnemonic
 
-    if ( ainf && binf )
+    FILE * fp = tmpfile();
+    if ( 0 == fp )
+        return;
+
+    uint64_t save_pc = pc;
+    uint64_t save_op = op;
+    bool save_quiet = tracer.GetQuiet();
+    FILE * save_fp = tracer.SetFile( fp );
+    tracer.SetQuiet( true );
+
+    char line[ 400 ];
+    for ( OpCounts::const_iterator it = counts.begin(); it != counts.end(); it++ )
     {
-        if ( signbit( a ) == signbit( b ) )
-            return a;
-        return MY_NAN; // msft C will return -nan if this check isn't here
-    }
+        rewind( fp );
+        op = it->first;
+        trace_state();
+        tracer.Flush();
+        rewind( fp );
 
-    if ( isnan( a ) )
-        return a;
+        // the trace is "pc ... ==> mnemonic operands". a symbol name may put a newline before it
 
-    if ( isnan( b ) )
-        return b;
+        std::string name = "unknown";
+        while ( 0 != fgets( line, sizeof( line ), fp ) )
+        {
+            char * p = strstr( line, "==> " );
+            if ( 0 != p )
+            {
+                p += 4;
+                size_t len = strcspn( p, " \t\r\n" );
+                if ( 0 != len )
+                    name.assign( p, len );
+                break;
+            }
+        }
 
-    if ( ainf )
-        return a;
+        mix[ name ] += it->second;
+    }
 
-    if ( binf )
-        return b;
+    tracer.SetFile( save_fp );
+    tracer.SetQuiet( save_quiet );
+    fclose( fp );
+    op = save_op;
+    pc = save_pc;
+} //name_instruction_mix
 
-    return a + b;
-} //do_fadd
+void Arm64::enable_trace_ring( uint32_t records, uint64_t trigger_pc, const char * path )
+{
+    delete [] ring;
+    delete [] ring_shadow;
+    ring = 0;
+    ring_shadow = 0;
+    ring_count = 0;
+
+    if ( 0 == records )
+        return;
 
-double do_fmul( double a, double b )
+    assert( 0 == ( records & ( records - 1 ) ) );
+    ring = new TraceRecord[ records ];
+    ring_shadow = new uint64_t[ 32 ];
+    ring_mask = records - 1;
+    ring_trigger = trigger_pc;
+    ring_path = path;
+} //enable_trace_ring
+
+void Arm64::finish_record( TraceRecord & r )
 {
-    if ( isnan( a ) )
-        return a;
+    // note the registers the record's instruction changed and catch the shadow up
 
-    if ( isnan( b ) )
-        return b;
+    for ( uint32_t i = 0; i < 32; i++ )
+    {
+        if ( regs[ i ] == ring_shadow[ i ] )
+            continue;
 
-    bool ainf = isinf( a );
-    bool binf = isinf( b );
-    bool azero = ( 0.0 == a );
-    bool bzero = ( 0.0 == b );
+        if ( r.changed < _countof( r.reg ) )
+        {
+            r.reg[ r.changed ] = (uint8_t) i;
+            r.old_value[ r.changed ] = ring_shadow[ i ];
+            r.changed++;
+        }
+        else
+            r.changed = ring_overflow;
+        ring_shadow[ i ] = regs[ i ];
+    }
+} //finish_record
 
-    if ( ( ainf && bzero ) || ( azero && binf ) )
-        return MY_NAN;
+void Arm64::record_instruction()
+{
+    if ( 0 == ring_count )
+        memcpy( ring_shadow, regs, sizeof( regs ) );
+    else
+        finish_record( ring[ ( ring_count - 1 ) & ring_mask ] );
 
-    if ( ainf && binf )
-        set_double_sign( INFINITY, ( signbit( a ) != signbit( b ) ) );
+    materialize_flags();
+    TraceRecord & r = ring[ ring_count & ring_mask ];
+    r.pc = pc;
+    r.op = (uint32_t) op;
+    r.flags = (uint8_t) ( ( fN << 3 ) | ( fZ << 2 ) | ( fC << 1 ) | (uint8_t) fV );
+    r.changed = 0;
+    ring_count++;
 
-    if ( ainf || binf )
-        return set_double_sign( INFINITY, signbit( a ) != signbit( b ) );
+    if ( pc == ring_trigger )
+        write_trace_ring( ring_path );
+} //record_instruction
 
-    if ( azero || bzero )
-        return set_double_sign( 0.0, signbit( a ) != signbit( b ) );
+struct TraceRingHeader
+{
+    char magic[ 8 ];
+    uint32_t record_size;
+    uint32_t flags;                 // nzcv at the time of the dump
+    uint64_t count;                 // records that follow, oldest first
+    uint64_t pc;
+    uint64_t regs[ 32 ];            // x0..x31 at the time of the dump
+};
 
-    return a * b;
-} //do_fmul
+static const char ring_magic[ 8 ] = { 'a', 'r', 'm', 'r', 'i', 'n', 'g', '1' };
 
-double do_fdiv( double a, double b )
+bool Arm64::write_trace_ring( const char * path )
 {
-    if ( isnan( a ) )
-        return a;
+    if ( ( 0 == ring ) || ( 0 == path ) )
+        return false;
+
+    if ( 0 != ring_count ) // the newest instruction may have started but not finished; keep what it changed so far
+        finish_record( ring[ ( ring_count - 1 ) & ring_mask ] );
+
+    FILE * fp = fopen( path, "wb" );
+    if ( 0 == fp )
+        return false;
+
+    TraceRingHeader h;
+    memset( &h, 0, sizeof( h ) );
+    memcpy( h.magic, ring_magic, sizeof( h.magic ) );
+    h.record_size = sizeof( TraceRecord );
+    materialize_flags();
+    h.flags = ( fN << 3 ) | ( fZ << 2 ) | ( fC << 1 ) | (uint32_t) fV;
+    h.count = get_min( ring_count, ring_mask + 1 );
+    h.pc = pc;
+    memcpy( h.regs, regs, sizeof( h.regs ) );
+
+    bool ok = ( 1 == fwrite( &h, sizeof( h ), 1, fp ) );
+    for ( uint64_t i = ring_count - h.count; ok && ( i < ring_count ); i++ )
+        ok = ( 1 == fwrite( &ring[ i & ring_mask ], sizeof( TraceRecord ), 1, fp ) );
+
+    ok = ( 0 == fclose( fp ) ) && ok;
+    return ok;
+} //write_trace_ring
+
+uint64_t Arm64::render_trace_ring( const char * path )
+{
+    FILE * fp = fopen( path, "rb" );
+    if ( 0 == fp )
+        return 0;
 
-    if ( isnan( b ) )
-        return b;
+    TraceRingHeader h;
+    std::vector<TraceRecord> records;
+    if ( ( 1 == fread( &h, sizeof( h ), 1, fp ) ) && ( 0 == memcmp( h.magic, ring_magic, sizeof( h.magic ) ) ) &&
+         ( sizeof( TraceRecord ) == h.record_size ) )
+    {
+        records.resize( (size_t) h.count );
+        if ( 0 != h.count && ( h.count != fread( records.data(), sizeof( TraceRecord ), (size_t) h.count, fp ) ) )
+            records.clear();
+    }
+    fclose( fp );
 
-    bool ainf = isinf( a );
-    bool binf = isinf( b );
-    bool azero = ( 0.0 == a );
-    bool bzero = ( 0.0 == b );
+    if ( records.empty() )
+        return 0;
 
-    if ( ( ainf && binf ) || ( azero && bzero ) )
-        return MY_NAN;
+    // only the registers' final values and each instruction's old values were kept, so walk back from the end to
+    // recover the registers before each instruction. old_value is swapped for the new value on the way so the
+    // forward pass can reapply it.
 
-    if ( ainf )
-        return set_double_sign( INFINITY, signbit( a ) != signbit( b ) );
+    memcpy( regs, h.regs, sizeof( regs ) );
+    size_t incomplete = records.size();
+    for ( size_t i = records.size(); i > 0; i-- )
+    {
+        TraceRecord & r = records[ i - 1 ];
+        if ( ring_overflow == r.changed )
+        {
+            incomplete = i - 1;
+            break;
+        }
 
-    if ( binf )
-        return set_double_sign( 0.0, signbit( a ) != signbit( b ) );
+        for ( size_t c = r.changed; c > 0; c-- )
+        {
+            uint64_t v = regs[ r.reg[ c - 1 ] ];
+            regs[ r.reg[ c - 1 ] ] = r.old_value[ c - 1 ];
+            r.old_value[ c - 1 ] = v;
+        }
+    }
 
-    if ( azero )
-        return set_double_sign( 0.0, signbit( a ) != signbit( b ) );
+    // registers shown before an instruction that wrote more of them than a record holds aren't known
 
-    return a / b;
-} //do_fdiv
+    size_t first = ( incomplete == records.size() ) ? 0 : incomplete + 1;
+    tracer.Trace( "trace ring %s: %zu instructions, the last at pc %llx\n", path, records.size(), h.pc );
+    if ( 0 != first )
+        tracer.Trace( "skipping the %zu oldest records; registers aren't known before the instruction at %llx\n", first, records[ incomplete ].pc );
 
-double do_fmin( double a, double b )
-{
-    if ( ( 0.0 == a ) && ( 0.0 == b ) )
+    for ( size_t i = first; i < records.size(); i++ )
     {
-        if ( signbit( a ) )
-            return a;
-        return b;
+        TraceRecord & r = records[ i ];
+        pc = r.pc;
+        op = r.op;
+        lazy_kind = lazy_none;
+        fN = ( 0 != ( r.flags & 8 ) );
+        fZ = ( 0 != ( r.flags & 4 ) );
+        fC = ( 0 != ( r.flags & 2 ) );
+        fV = ( 0 != ( r.flags & 1 ) );
+        trace_state();
+
+        for ( size_t c = 0; c < r.changed; c++ )
+            regs[ r.reg[ c ] ] = r.old_value[ c ];
     }
 
-    bool anan = isnan( a );
-    bool bnan = isnan( b );
+    return records.size() - first;
+} //render_trace_ring
 
-    if ( anan && bnan )
-        return a;         // not clearly documented, but this is what hardware does
+uint64_t Arm64::jit_blocks_compiled() const
+{
+    return ( 0 == jit ) ? 0 : jit->blocks_compiled();
+} //jit_blocks_compiled
 
-    if ( anan )
-        return b;
+Arm64::~Arm64()
+{
+    delete [] ring;
+    delete [] ring_shadow;
+    delete op_counts;
+    delete profile_ranges;
+    delete profile_branches;
+    delete jit;
+    delete [] blocks;
+    delete [] block_ops;
+    delete [] block_table;
+    delete [] intercepts;
+} //~Arm64
+
+void Arm64::invalidate_code( uint64_t address, uint64_t length )
+{
+    // blocks are chained to each other, so rather than unlinking just the overlapping blocks drop them all.
+    // code is rarely written, and the flush is deferred so the block currently executing stays valid.
 
-    if ( bnan )
-        return a;
+    if ( ( address < pdc_hi ) && ( ( address + length ) > pdc_lo ) )
+    {
+        code_modified = true;
+        code_rewritten = true;
+    }
+} //invalidate_code
 
-    return get_min( a, b );
-} //do_fmin
+// timing loops read the clock often, so those mrs instructions are predecoded and don't end the block. cntvct_el0
+// counts nanoseconds on the host's monotonic clock. S3_3_C15_C0_<n> is armos' own register that reads Linux clock n
+// the way clock_gettime() would; the vdso armos gives apps uses it
 
-double do_fmax( double a, double b )
+static bool is_clock_read( uint32_t op, int64_t & clock )
 {
-    if ( ( 0.0 == a ) && ( 0.0 == b ) )
+    if ( 0xd53be040 == ( op & 0xffffffe0 ) ) // mrs xt, cntvct_el0
+        clock = -1;
+    else if ( 0xd53bf000 == ( op & 0xffffff00 ) ) // mrs xt, S3_3_C15_C0_<clock>
+        clock = ( op >> 5 ) & 7;
+    else
+        return false;
+
+    return true;
+} //is_clock_read
+
+static inline uint64_t counter_ticks()
+{
+    return (uint64_t) duration_cast<nanoseconds>( steady_clock::now().time_since_epoch() ).count();
+} //counter_ticks
+
+void Arm64::predecode( PredecodedOp & pd, uint64_t address )
+{
+    uint32_t o = getui32( address );
+    uint8_t hi8 = (uint8_t) ( o >> 24 );
+    uint8_t d = (uint8_t) ( o & 0x1f );
+    uint8_t n = (uint8_t) ( ( o >> 5 ) & 0x1f );
+    uint8_t m = (uint8_t) ( ( o >> 16 ) & 0x1f );
+    uint8_t handler = pdh_generic;
+    int64_t imm = 0;
+
+    switch ( hi8 )
     {
-        if ( signbit( a ) )
-            return b;
-        return a;
+        case 0x11: case 0x51: case 0x91: case 0xd1: // add/sub <xd|SP>, <xn|SP>, #imm [,<shift>]
+        {
+            imm = ( o >> 10 ) & 0xfff;
+            if ( o & ( 1 << 22 ) )
+                imm <<= 12;
+            if ( hi8 & 0x40 )
+                imm = -imm;
+            handler = ( hi8 & 0x80 ) ? pdh_add_imm64 : pdh_add_imm32;
+            break;
+        }
+        case 0x71: case 0xf1: // subs / cmp <xn|SP>, #imm [,<shift>]
+        {
+            imm = ( o >> 10 ) & 0xfff;
+            if ( o & ( 1 << 22 ) )
+                imm <<= 12;
+            handler = ( hi8 & 0x80 ) ? pdh_subs_imm64 : pdh_subs_imm32;
+            break;
+        }
+        case 0x8b: case 0xcb: case 0xeb: case 0x6b: // add / sub / subs with an unshifted register and no zr operands
+        {
+            if ( 0 != ( o & 0x00e0fc00 ) || 31 == n || 31 == m )
+                break;
+            if ( 0x8b == hi8 || 0xcb == hi8 )
+            {
+                if ( 31 != d )
+                    handler = ( 0x8b == hi8 ) ? pdh_add_reg64 : pdh_sub_reg64;
+            }
+            else
+                handler = ( 0xeb == hi8 ) ? pdh_subs_reg64 : pdh_subs_reg32;
+            break;
+        }
+        case 0x2a: case 0xaa: // mov <xd>, <xm> is an alias for orr <xd>, xzr, <xm>
+        {
+            if ( 0 == ( o & 0x00e0fc00 ) && 31 == n && 31 != d && 31 != m )
+                handler = ( 0xaa == hi8 ) ? pdh_mov64 : pdh_mov32;
+            break;
+        }
+        case 0x52: case 0xd2: // movz
+        {
+            uint64_t hw = ( o >> 21 ) & 3;
+            if ( ( o & ( 1 << 23 ) ) && ( 31 != d ) && ( ( 0xd2 == hi8 ) || ( hw < 2 ) ) )
+            {
+                imm = (int64_t) ( (uint64_t) ( ( o >> 5 ) & 0xffff ) << ( hw * 16 ) );
+                handler = pdh_movz;
+            }
+            break;
+        }
+        case 0x10: case 0x30: case 0x50: case 0x70: // adr
+        case 0x90: case 0xb0: case 0xd0: case 0xf0: // adrp
+        {
+            if ( 31 == d ) // once the address is known both are constant loads like movz
+                break;
+            imm = ( ( o >> 3 ) & 0x1ffffc ) | ( ( o >> 29 ) & 3 );
+            imm = sign_extend( imm, 20 );
+            if ( hi8 & 0x80 )
+                imm = (int64_t) ( ( imm << 12 ) + ( address & ( ~0xfff ) ) );
+            else
+                imm += address;
+            handler = pdh_movz;
+            break;
+        }
+        case 0x14: case 0x15: case 0x16: case 0x17: // b label
+        case 0x94: case 0x95: case 0x96: case 0x97: // bl label
+        {
+            imm = sign_extend( ( o & 0x3ffffff ) << 2, 27 );
+            handler = ( hi8 & 0x80 ) ? pdh_bl : pdh_b;
+            break;
+        }
+        case 0x54: // b.cond
+        {
+            imm = sign_extend( ( ( o >> 5 ) & 0x7ffff ) << 2, 20 );
+            d = (uint8_t) ( o & 0xf );
+            handler = pdh_bcond;
+            break;
+        }
+        case 0x34: case 0x35: case 0xb4: case 0xb5: // cbz / cbnz
+        {
+            if ( 31 == d )
+                break;
+            imm = sign_extend( ( o >> 3 ) & 0x1ffffc, 20 );
+            if ( hi8 & 0x80 )
+                handler = ( hi8 & 1 ) ? pdh_cbnz64 : pdh_cbz64;
+            else
+                handler = ( hi8 & 1 ) ? pdh_cbnz32 : pdh_cbz32;
+            break;
+        }
+        case 0xd6: // br / blr / ret
+        {
+            uint64_t theop = ( o >> 21 ) & 3;
+            if ( 0 != ( o & ( 1 << 23 ) ) || 0x1f0 != ( ( o >> 12 ) & 0x1ff ) || 0 != ( o & 0xc00 ) )
+                break;
+            if ( 0 == theop || 2 == theop )
+                handler = pdh_br;
+            else if ( 1 == theop )
+                handler = pdh_blr;
+            break;
+        }
+        case 0x39: case 0xb9: case 0xf9: // ldr / str unsigned offset
+        {
+            uint64_t opc = ( o >> 22 ) & 3;
+            if ( opc > 1 || 31 == d )
+                break;
+            imm = (int64_t) ( ( ( o >> 10 ) & 0xfff ) << ( o >> 30 ) );
+            if ( 0xf9 == hi8 )
+                handler = opc ? pdh_ldr64 : pdh_str64;
+            else if ( 0xb9 == hi8 )
+                handler = opc ? pdh_ldr32 : pdh_str32;
+            else
+                handler = opc ? pdh_ldr8 : pdh_str8;
+            break;
+        }
+        case 0xd5:
+        {
+            if ( ( 31 != d ) && is_clock_read( o, imm ) )
+                handler = pdh_mrs_clock;
+            break;
+        }
+        case 0xa8: case 0xa9: // ldp / stp of x registers: post-index, signed offset, pre-index
+        {
+            uint64_t variant = ( o >> 23 ) & 3;
+            m = (uint8_t) ( ( o >> 10 ) & 0x1f );
+            if ( 0 == variant || 31 == d || 31 == m ) // ldnp / stnp and xzr operands use the full decoder
+                break;
+            imm = sign_extend( ( o >> 15 ) & 0x7f, 6 ) * 8;
+            if ( o & ( 1 << 22 ) )
+                handler = ( 1 == variant ) ? pdh_ldp64_post : ( 2 == variant ) ? pdh_ldp64 : pdh_ldp64_pre;
+            else
+                handler = ( 1 == variant ) ? pdh_stp64_post : ( 2 == variant ) ? pdh_stp64 : pdh_stp64_pre;
+            break;
+        }
+        default:
+            break;
     }
 
-    bool anan = isnan( a );
-    bool bnan = isnan( b );
+    pd.pc = address;
+    pd.op = o;
+    pd.handler = handler;
+    pd.d = d;
+    pd.n = n;
+    pd.m = m;
+    pd.imm = imm;
+} //predecode
 
-    if ( anan && bnan )
-        return a;         // not clearly documented, but this is what hardware does
+const char * Arm64::fused_idiom_name( uint32_t idiom )
+{
+    static const char * names[ fi_count ] = { "cmp+b.cond", "adrp+add", "adrp+ldr", "movz+movk", "stp prologue", "ldp epilogue" };
+    return ( idiom < fi_count ) ? names[ idiom ] : "unknown";
+} //fused_idiom_name
 
-    if ( anan )
-        return b;
+void Arm64::fuse_block( BasicBlock & b )
+{
+    // look for compiler idioms and give the first instruction of each a handler that executes the whole sequence.
+    // only the first op changes; the rest stay in place so the handlers can read them and the counts are unchanged.
 
-    if ( bnan )
-        return a;
+    PredecodedOp * ops = block_ops + b.first;
 
-    return get_max( a, b );
-} //do_fmax
+    for ( uint32_t i = 0; ( i + 1 ) < b.count; i++ )
+    {
+        PredecodedOp & pd = ops[ i ];
+        PredecodedOp & next = ops[ i + 1 ];
+        uint8_t hi8 = (uint8_t) ( pd.op >> 24 );
+
+        switch ( pd.handler )
+        {
+            case pdh_subs_imm64: case pdh_subs_imm32: case pdh_subs_reg64: case pdh_subs_reg32:
+            {
+                if ( pdh_bcond != next.handler )
+                    break;
+                if ( pdh_subs_imm64 == pd.handler )
+                    pd.handler = pdh_subs_imm64_bcond;
+                else if ( pdh_subs_imm32 == pd.handler )
+                    pd.handler = pdh_subs_imm32_bcond;
+                else if ( pdh_subs_reg64 == pd.handler )
+                    pd.handler = pdh_subs_reg64_bcond;
+                else
+                    pd.handler = pdh_subs_reg32_bcond;
+                break;
+            }
+            case pdh_movz:
+            {
+                if ( 0x10 == ( hi8 & 0x1f ) ) // adr / adrp
+                {
+                    if ( 0x80 != ( hi8 & 0x80 ) || next.n != pd.d )
+                        break;
+                    if ( pdh_add_imm64 == next.handler )
+                        pd.handler = pdh_adrp_add;
+                    else if ( pdh_ldr64 == next.handler )
+                        pd.handler = pdh_adrp_ldr64;
+                    else if ( pdh_ldr32 == next.handler )
+                        pd.handler = pdh_adrp_ldr32;
+                    break;
+                }
 
-bool Arm64::check_conditional( uint64_t cond ) const
+                // movz followed by up to 3 movk to the same register. the final value is computed here
+
+                uint32_t movk = ( pd.op & 0x80000000 ) ? 0xf2800000 : 0x72800000;
+                uint64_t val = pd.imm;
+                uint32_t k = 0;
+                while ( ( k < 3 ) && ( ( i + 1 + k ) < b.count ) )
+                {
+                    uint32_t o = ops[ i + 1 + k ].op;
+                    uint64_t hw = ( o >> 21 ) & 3;
+                    if ( ( movk != ( o & 0xff800000 ) ) || ( pd.d != ( o & 0x1f ) ) || ( ( 0x72800000 == movk ) && ( hw > 1 ) ) )
+                        break;
+                    uint64_t shift = hw * 16;
+                    val = ( val & ~( 0xffffull << shift ) ) | ( (uint64_t) ( ( o >> 5 ) & 0xffff ) << shift );
+                    k++;
+                }
+                if ( 0 != k )
+                {
+                    pd.handler = pdh_movz_movk;
+                    pd.imm = (int64_t) val;
+                    pd.m = (uint8_t) k;
+                }
+                break;
+            }
+            case pdh_stp64_pre: case pdh_ldp64_post: // imm is already the scaled offset
+            {
+                if ( ( 0xa9807bfd == ( pd.op & 0xffc07fff ) ) && ( 0x910003fd == next.op ) ) // stp x29, x30, [sp, #imm]! ; mov x29, sp
+                    pd.handler = pdh_prologue;
+                else if ( ( 0xa8c07bfd == ( pd.op & 0xffc07fff ) ) && ( 0xd65f03c0 == next.op ) ) // ldp x29, x30, [sp], #imm ; ret
+                    pd.handler = pdh_epilogue;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+} //fuse_block
+
+static bool ends_block( uint32_t op )
 {
-    assert( cond <= 15 );
+    if ( 0xd503201f == ( op & 0xfffff01f ) ) // nop, bti, and other hints are common in straight-line code
+        return false;
 
-    switch ( cond & 0xf ) // do the reduant mask so the msft compiler doesn't add a conditional
+    int64_t clock;
+    if ( is_clock_read( op, clock ) )
+        return false;
+
+    switch ( op >> 24 )
     {
-        case 0: { return fZ; }                          // EQ = Zero / Equal
-        case 1: { return !fZ; }                         // NE = Not Equal
-        case 2: { return fC; }                          // CS = Carry Set
-        case 3: { return !fC; }                         // CC = Carry Clear
-        case 4: { return fN; }                          // MI = Minus / Negative
-        case 5: { return !fN; }                         // PL = Plus. Positive or Zero
-        case 6: { return fV;  }                         // VS = Overflow Set
-        case 7: { return !fV;  }                        // VC = Overflow Clear
-        case 8: { return ( fC && !fZ ); }               // HI = Unsigned Higher
-        case 9: { return ( !fC || fZ ); }               // LS = Lower or Same
-        case 10: { return ( fN == fV ); }               // GE = Signed Greater Than or Equal
-        case 11: { return ( fN != fV ); }               // LT = Signed Less Than
-        case 12: { return ( ( fN == fV ) && !fZ ); }    // GT = Signed Greater Than
-        case 13: { return ( ( fN != fV ) || fZ ); }     // LE = Signed Less Than or Equal
-        case 14: case 15:
-        default: { return true; }                       // AL = Always true. not used in practice. 14 and 15
+        case 0x14: case 0x15: case 0x16: case 0x17: // b
+        case 0x94: case 0x95: case 0x96: case 0x97: // bl
+        case 0x54:                                  // b.cond
+        case 0x34: case 0x35: case 0xb4: case 0xb5: // cbz, cbnz
+        case 0x36: case 0x37: case 0xb6: case 0xb7: // tbz, tbnz
+        case 0xd6:                                  // br, blr, ret
+        case 0xd4:                                  // svc can end emulation or change tracing
+        case 0xd5:                                  // isb, ic ivau, msr, etc.
+            return true;
     }
-} //check_conditional
 
-void Arm64::set_flags_from_double( double result )
+    return false;
+} //ends_block
+
+Arm64::BasicBlock * Arm64::build_block( uint64_t address )
 {
-    if ( isnan( result ) )
+    BasicBlock & b = blocks[ block_count++ ];
+    b.pc = address;
+    b.next_pc[ 0 ] = 0;
+    b.next_pc[ 1 ] = 0;
+    b.first = block_op_count;
+    b.count = 0;
+    b.executions = 0;
+    b.mix_executions = 0;
+    b.profile_executions = 0;
+    b.profile_next[ 0 ] = 0;
+    b.profile_next[ 1 ] = 0;
+    b.jitted = 0;
+
+    uint64_t a = address;
+    uint32_t routine;
+    if ( ( 0 != intercept_count ) && find_intercept( address, routine ) )
     {
-        fN = fZ = false;
-        fC = fV = true;
+        // the routine's first instruction is kept in case the host declines the call
+
+        PredecodedOp & pd = block_ops[ block_op_count++ ];
+        predecode( pd, a );
+        pd.handler = pdh_intercept;
+        pd.imm = routine;
+        b.count = 1;
     }
-    else if ( result > 0.0 )
+    else
     {
-        fN = fZ = fV = false;
-        fC = true;
+        do
+        {
+            PredecodedOp & pd = block_ops[ block_op_count++ ];
+            predecode( pd, a );
+            b.count++;
+            if ( ends_block( pd.op ) )
+                break;
+            a += 4;
+        } while ( ( b.count < max_block_ops ) && is_address_valid( a + 3 ) );
+
+        fuse_block( b );
     }
-    else if ( result < 0.0 )
+
+    if ( ( 0 == pdc_hi ) || ( address < pdc_lo ) )
+        pdc_lo = address;
+    if ( ( a + 4 ) > pdc_hi )
+        pdc_hi = a + 4;
+
+    return & b;
+} //build_block
+
+Arm64::BasicBlock * Arm64::find_block( BasicBlock * prev )
+{
+    if ( code_modified || ( block_count >= block_capacity ) || ( ( block_op_count + max_block_ops ) > block_op_capacity ) )
     {
-        fN = true;
-        fZ = fC = fV = false;
+        flush_predecode();
+        prev = 0;
     }
+
+    uint32_t & entry = block_table[ ( pc >> 2 ) & ( block_table_entries - 1 ) ];
+    BasicBlock * b;
+
+    if ( ( 0 != entry ) && ( pc == blocks[ entry - 1 ].pc ) )
+        b = & blocks[ entry - 1 ];
     else
     {
-        fN = fV = false;
-        fZ = fC = true;
+        b = build_block( pc );
+        entry = (uint32_t) ( 1 + ( b - blocks ) );
     }
-} //set_flags_from_double
 
-#ifdef _WIN32
-__declspec(noinline)
-#endif
-void Arm64::force_trace_vregs()
-{
-    for ( uint64_t i = 0; i < _countof( vregs ); i++ )
+    if ( 0 != prev ) // chain so next time prev goes straight to b
     {
-        if ( memcmp( &vec_zeroes, &vregs[ i ], sizeof( vec_zeroes ) ) )
-        {
-            tracer.Trace( "    vreg %2llu: ", i );
-            tracer.TraceBinaryData( (uint8_t *) & vregs[ i ], 16, 4 );
-        }
+        uint32_t slot = ( 0 == prev->next_pc[ 0 ] ) ? 0 : 1;
+        if ( 0 != profile_ranges )
+            fold_profile_edge( *prev, slot );
+        prev->next_pc[ slot ] = pc;
+        prev->next[ slot ] = (uint32_t) ( b - blocks );
     }
-} //trace_vregs
 
-void Arm64::trace_vregs()
+    return b;
+} //find_block
+
+// g++ and clang builds dispatch through tables of label addresses (computed goto) instead of switch statements.
+// each predecoded handler then ends with its own indirect jump to the next instruction in the block, which host
+// branch predictors handle much better than the single shared jump of a switch. build with -DARM64_SWITCH_DISPATCH
+// to use the switch statements anyway for comparison. msft compilers don't support computed goto.
+
+#if defined( __GNUC__ ) && !defined( ARM64_SWITCH_DISPATCH )
+    #define ARM64_COMPUTED_GOTO
+#endif
+
+#ifdef ARM64_COMPUTED_GOTO
+    #define PD_CASE( h ) lbl_##h:
+    #define PD_NEXT() { if ( pnext != pbeyond ) { ppd = pnext++; assert( pc == ppd->pc ); goto * pd_labels[ ppd->handler ]; } continue; }
+    #define OP_CASE( x ) case x: lbl_op_##x:
+#else
+    #define PD_CASE( h ) case h:
+    #define PD_NEXT() continue
+    #define OP_CASE( x ) case x:
+#endif
+
+uint64_t Arm64::run( void )
+{
+    run( 0 );
+    return cycles;
+} //run
+
+bool Arm64::needs_stepping() const
+{
+    return !predecode_enabled || ( ( 0 != ( g_State & stateTraceInstructions ) ) && in_trace_filter() ) || ( 0 != ring ) || ( 0 != breakpoint );
+} //needs_stepping
+
+void Arm64::check_run_state()
+{
+    if ( regs[ 31 ] <= ( stack_top - stack_size ) )
+        emulator_hard_termination( *this, "stack pointer is below stack memory:", regs[ 31 ] );
+
+    if ( regs[ 31 ] > stack_top )
+        emulator_hard_termination( *this, "stack pointer is above the top of its starting point:", regs[ 31 ] );
+
+    if ( pc < base )
+        emulator_hard_termination( *this, "pc is lower than memory:", pc );
+
+    if ( pc >= ( base + mem_size - stack_size ) )
+        emulator_hard_termination( *this, "pc is higher than it should be:", pc );
+
+    if ( 0 != ( regs[ 31 ] & 0xf ) ) // by convention, arm64 stacks are 16-byte aligned
+        emulator_hard_termination( *this, "the stack pointer isn't 16-byte aligned:", regs[ 31 ] );
+} //check_run_state
+
+// the host's rounding mode follows FPCR.RMode while the app runs, so host arithmetic rounds the way the app asked.
+// it's per host thread, and it's put back to round to nearest whenever run() returns
+
+static void set_host_rounding( uint64_t fpcr )
+{
+    static const int modes[ 4 ] = { FE_TONEAREST, FE_UPWARD, FE_DOWNWARD, FE_TOWARDZERO };
+    fesetround( modes[ get_bits( fpcr, 22, 2 ) ] );
+} //set_host_rounding
+
+Arm64::StopReason Arm64::run( uint64_t max_instructions )
 {
-    if ( !tracer.IsEnabled() ) // can happen when an app enables instruction tracing via a syscall but overall tracing is turned off.
-        return;
+    StopReason reason = stop_ended;
+    uint64_t budget_end = ( 0 == max_instructions ) ? ~0ull : ( cycles + max_instructions );
 
-    if ( ! ( g_State & stateTraceInstructions ) )
-        return;
+    if ( 0 != get_bits( fpcr, 22, 2 ) )
+        set_host_rounding( fpcr );
 
-    force_trace_vregs();
-} //trace_vregs
+    for ( ;; )
+    {
+        bool stopped = needs_stepping() ? run_loop<true>( budget_end, reason ) : run_loop<false>( budget_end, reason );
+        if ( stopped )
+        {
+            if ( 0 != get_bits( fpcr, 22, 2 ) )
+                fesetround( FE_TONEAREST );
+            return reason;
+        }
+    }
+} //run
 
-uint64_t Arm64::run( void )
+template <bool stepping> bool Arm64::run_loop( uint64_t budget_end, StopReason & reason )
 {
-    cycles = 0;
+    BasicBlock * pblock = 0;        // block being executed
+    PredecodedOp * pnext = 0;       // next instruction to execute in pblock
+    PredecodedOp * pbeyond = 0;     // just past the last instruction in pblock
 
     for ( ;; )
     {
         #ifndef NDEBUG
-            if ( regs[ 31 ] <= ( stack_top - stack_size ) )
-                emulator_hard_termination( *this, "stack pointer is below stack memory:", regs[ 31 ] );
+            if ( stepping ) // blocks are checked once at their start
+                check_run_state();
+        #endif
+
+        PredecodedOp * ppd = 0;
+
+        if ( pnext != pbeyond ) // within a block; the per-instruction checks happened at the start of the block
+        {
+            ppd = pnext++;
+            assert( pc == ppd->pc );
+            op = ppd->op;
+        }
+        else
+        {
+            if ( end_requested )
+            {
+                end_requested = false;
+                break;
+            }
 
-            if ( regs[ 31 ] > stack_top )
-                emulator_hard_termination( *this, "stack pointer is above the top of its starting point:", regs[ 31 ] );
+            if ( yield_requested ) // svc ends a block, so the pc is just past it
+            {
+                yield_requested = false;
+                reason = stop_svc;
+                break;
+            }
 
-            if ( pc < base )
-                emulator_hard_termination( *this, "pc is lower than memory:", pc );
+            if ( cycles >= budget_end )
+            {
+                reason = stop_budget;
+                break;
+            }
 
-            if ( pc >= ( base + mem_size - stack_size ) )
-                emulator_hard_termination( *this, "pc is higher than it should be:", pc );
+            if ( sample_requested )
+            {
+                sample_requested = false;
+                emulator_sample( *this );
+            }
 
-            if ( 0 != ( regs[ 31 ] & 0xf ) ) // by convention, arm64 stacks are 16-byte aligned
-                emulator_hard_termination( *this, "the stack pointer isn't 16-byte aligned:", regs[ 31 ] );
-        #endif
+            if ( stepping && ( 0 != breakpoint ) && ( pc == breakpoint ) )
+            {
+                breakpoint = 0;
+                emulator_breakpoint( *this );
+            }
+
+            if ( stepping != needs_stepping() ) // tracing was turned on or off, the breakpoint was hit, etc.
+                return false;
+
+            if ( !stepping )
+            {
+                #ifndef NDEBUG
+                    check_run_state();
+                #endif
+
+                if ( ( 0 != profile_ranges ) && ( 0 != pblock ) )
+                    profile_block_exit( *pblock );
+
+                if ( ( 0 != pblock ) && !code_modified && ( pc == pblock->next_pc[ 0 ] ) )
+                    pblock = blocks + pblock->next[ 0 ];
+                else if ( ( 0 != pblock ) && !code_modified && ( pc == pblock->next_pc[ 1 ] ) )
+                    pblock = blocks + pblock->next[ 1 ];
+                else
+                    pblock = find_block( pblock );
+
+                pnext = block_ops + pblock->first;
+                pbeyond = pnext + pblock->count;
+                cycles += pblock->count;
+                if ( 0 != op_counts )
+                    pblock->mix_executions++;
+                if ( 0 != profile_ranges )
+                    pblock->profile_executions++;
+
+                if ( 0 != jit )
+                {
+                    if ( 0 != pblock->jitted )
+                    {
+                        materialize_flags(); // generated code reads and writes fN, fZ, fC, and fV directly
+                        pnext += pblock->jitted( this ); // runs a prefix or all of the block and updates pc
+                        if ( pnext == pbeyond )
+                            continue;
+                    }
+                    else if ( jit_threshold == ++pblock->executions )
+                        pblock->jitted = jit->compile( *this, (uint32_t) ( pblock - blocks ) );
+                }
+
+                ppd = pnext++;
+                op = ppd->op;
+            }
+            else
+            {
+                op = getui32( pc );
+
+                if ( ( g_State & stateTraceInstructions ) && in_trace_filter() )
+                    trace_state();
+
+                if ( 0 != ring )
+                    record_instruction();
+
+                if ( 0 != op_counts )
+                    ( *op_counts )[ (uint32_t) op ]++;
+
+                cycles++;
+            }
+        }
 
-        op = getui32( pc );
         uint8_t hi8 = (uint8_t) ( op >> 24 );
 
-        if ( 0 != g_State )
+        if ( !stepping )
         {
-            if ( g_State & stateEndEmulation )
+#ifdef ARM64_COMPUTED_GOTO
+            static const void * pd_labels[] = { &&lbl_pdh_generic, // same order as PredecodeHandler
+                &&lbl_pdh_add_imm64, &&lbl_pdh_add_imm32, &&lbl_pdh_subs_imm64, &&lbl_pdh_subs_imm32, &&lbl_pdh_add_reg64, &&lbl_pdh_sub_reg64,
+                &&lbl_pdh_subs_reg64, &&lbl_pdh_subs_reg32, &&lbl_pdh_mov64, &&lbl_pdh_mov32, &&lbl_pdh_movz, &&lbl_pdh_b, &&lbl_pdh_bl,
+                &&lbl_pdh_bcond, &&lbl_pdh_cbz64, &&lbl_pdh_cbnz64, &&lbl_pdh_cbz32, &&lbl_pdh_cbnz32, &&lbl_pdh_br, &&lbl_pdh_blr,
+                &&lbl_pdh_ldr64, &&lbl_pdh_ldr32, &&lbl_pdh_ldr8, &&lbl_pdh_str64, &&lbl_pdh_str32, &&lbl_pdh_str8,
+                &&lbl_pdh_ldp64, &&lbl_pdh_ldp64_pre, &&lbl_pdh_ldp64_post, &&lbl_pdh_stp64, &&lbl_pdh_stp64_pre, &&lbl_pdh_stp64_post,
+                &&lbl_pdh_mrs_clock, &&lbl_pdh_intercept,
+                &&lbl_pdh_subs_imm64_bcond, &&lbl_pdh_subs_imm32_bcond, &&lbl_pdh_subs_reg64_bcond, &&lbl_pdh_subs_reg32_bcond,
+                &&lbl_pdh_adrp_add, &&lbl_pdh_adrp_ldr64, &&lbl_pdh_adrp_ldr32, &&lbl_pdh_movz_movk, &&lbl_pdh_prologue, &&lbl_pdh_epilogue };
+
+            goto * pd_labels[ ppd->handler ];
+#else
+            switch ( ppd->handler )
+#endif
             {
-                g_State &= ~stateEndEmulation;
-                break;
+                PD_CASE( pdh_add_imm64 ) { regs[ ppd->d ] = regs[ ppd->n ] + ppd->imm; pc += 4; PD_NEXT(); }
+                PD_CASE( pdh_add_imm32 ) { regs[ ppd->d ] = (uint32_t) ( regs[ ppd->n ] + ppd->imm ); pc += 4; PD_NEXT(); }
+                PD_CASE( pdh_subs_imm64 )
+                {
+                    uint64_t result = sub64( regs[ ppd->n ], ppd->imm, true );
+                    if ( 31 != ppd->d )
+                        regs[ ppd->d ] = result;
+                    pc += 4;
+                    PD_NEXT();
+                }
+                PD_CASE( pdh_subs_imm32 )
+                {
+                    uint64_t result = sub32( (uint32_t) regs[ ppd->n ], (uint32_t) ppd->imm, true );
+                    if ( 31 != ppd->d )
+                        regs[ ppd->d ] = result;
+                    pc += 4;
+                    PD_NEXT();
+                }
+                PD_CASE( pdh_add_reg64 ) { regs[ ppd->d ] = regs[ ppd->n ] + regs[ ppd->m ]; pc += 4; PD_NEXT(); }
+                PD_CASE( pdh_sub_reg64 ) { regs[ ppd->d ] = regs[ ppd->n ] - regs[ ppd->m ]; pc += 4; PD_NEXT(); }
+                PD_CASE( pdh_subs_reg64 )
+                {
+                    uint64_t result = sub64( regs[ ppd->n ], regs[ ppd->m ], true );
+                    if ( 31 != ppd->d )
+                        regs[ ppd->d ] = result;
+                    pc += 4;
+                    PD_NEXT();
+                }
+                PD_CASE( pdh_subs_reg32 )
+                {
+                    uint64_t result = sub32( (uint32_t) regs[ ppd->n ], (uint32_t) regs[ ppd->m ], true );
+                    if ( 31 != ppd->d )
+                        regs[ ppd->d ] = result;
+                    pc += 4;
+                    PD_NEXT();
+                }
+                PD_CASE( pdh_mov64 ) { regs[ ppd->d ] = regs[ ppd->m ]; pc += 4; PD_NEXT(); }
+                PD_CASE( pdh_mov32 ) { regs[ ppd->d ] = (uint32_t) regs[ ppd->m ]; pc += 4; PD_NEXT(); }
+                PD_CASE( pdh_movz ) { regs[ ppd->d ] = ppd->imm; pc += 4; PD_NEXT(); }
+                PD_CASE( pdh_b ) { pc += ppd->imm; PD_NEXT(); }
+                PD_CASE( pdh_bl ) { regs[ 30 ] = pc + 4; pc += ppd->imm; PD_NEXT(); }
+                PD_CASE( pdh_bcond ) { pc += check_conditional( ppd->d ) ? ppd->imm : 4; PD_NEXT(); }
+                PD_CASE( pdh_cbz64 ) { pc += ( 0 == regs[ ppd->d ] ) ? ppd->imm : 4; PD_NEXT(); }
+                PD_CASE( pdh_cbnz64 ) { pc += ( 0 != regs[ ppd->d ] ) ? ppd->imm : 4; PD_NEXT(); }
+                PD_CASE( pdh_cbz32 ) { pc += ( 0 == (uint32_t) regs[ ppd->d ] ) ? ppd->imm : 4; PD_NEXT(); }
+                PD_CASE( pdh_cbnz32 ) { pc += ( 0 != (uint32_t) regs[ ppd->d ] ) ? ppd->imm : 4; PD_NEXT(); }
+                PD_CASE( pdh_br ) { pc = regs[ ppd->n ]; PD_NEXT(); }
+                PD_CASE( pdh_blr )
+                {
+                    uint64_t location = pc + 4;
+                    pc = regs[ ppd->n ];
+                    regs[ 30 ] = location;
+                    PD_NEXT();
+                }
+                PD_CASE( pdh_ldr64 ) { regs[ ppd->d ] = getui64( regs[ ppd->n ] + ppd->imm ); pc += 4; PD_NEXT(); }
+                PD_CASE( pdh_ldr32 ) { regs[ ppd->d ] = getui32( regs[ ppd->n ] + ppd->imm ); pc += 4; PD_NEXT(); }
+                PD_CASE( pdh_ldr8 ) { regs[ ppd->d ] = getui8( regs[ ppd->n ] + ppd->imm ); pc += 4; PD_NEXT(); }
+                PD_CASE( pdh_str64 ) { setui64( regs[ ppd->n ] + ppd->imm, regs[ ppd->d ] ); pc += 4; PD_NEXT(); }
+                PD_CASE( pdh_str32 ) { setui32( regs[ ppd->n ] + ppd->imm, (uint32_t) regs[ ppd->d ] ); pc += 4; PD_NEXT(); }
+                PD_CASE( pdh_str8 ) { setui8( regs[ ppd->n ] + ppd->imm, (uint8_t) regs[ ppd->d ] ); pc += 4; PD_NEXT(); }
+
+                // ldp / stp. like the full decoder, both loads happen before writeback and stores read the old base
+
+                PD_CASE( pdh_ldp64 ) { getui64_pair( regs[ ppd->n ] + ppd->imm, regs[ ppd->d ], regs[ ppd->m ] ); pc += 4; PD_NEXT(); }
+                PD_CASE( pdh_ldp64_pre )
+                {
+                    uint64_t address = regs[ ppd->n ] + ppd->imm;
+                    getui64_pair( address, regs[ ppd->d ], regs[ ppd->m ] );
+                    regs[ ppd->n ] = address;
+                    pc += 4;
+                    PD_NEXT();
+                }
+                PD_CASE( pdh_ldp64_post )
+                {
+                    uint64_t address = regs[ ppd->n ];
+                    getui64_pair( address, regs[ ppd->d ], regs[ ppd->m ] );
+                    regs[ ppd->n ] = address + ppd->imm;
+                    pc += 4;
+                    PD_NEXT();
+                }
+                PD_CASE( pdh_stp64 ) { setui64_pair( regs[ ppd->n ] + ppd->imm, regs[ ppd->d ], regs[ ppd->m ] ); pc += 4; PD_NEXT(); }
+                PD_CASE( pdh_stp64_pre )
+                {
+                    uint64_t address = regs[ ppd->n ] + ppd->imm;
+                    setui64_pair( address, regs[ ppd->d ], regs[ ppd->m ] );
+                    regs[ ppd->n ] = address;
+                    pc += 4;
+                    PD_NEXT();
+                }
+                PD_CASE( pdh_stp64_post )
+                {
+                    uint64_t address = regs[ ppd->n ];
+                    setui64_pair( address, regs[ ppd->d ], regs[ ppd->m ] );
+                    regs[ ppd->n ] = address + ppd->imm;
+                    pc += 4;
+                    PD_NEXT();
+                }
+                PD_CASE( pdh_mrs_clock )
+                {
+                    regs[ ppd->d ] = ( ppd->imm < 0 ) ? counter_ticks() : emulator_clock( (uint32_t) ppd->imm );
+                    pc += 4;
+                    PD_NEXT();
+                }
+
+                // superinstructions. ppd[ 1 ] etc. are the other instructions in the sequence; pnext skips past them
+
+                PD_CASE( pdh_subs_imm64_bcond )
+                {
+                    uint64_t result = sub64( regs[ ppd->n ], ppd->imm, true );
+                    if ( 31 != ppd->d )
+                        regs[ ppd->d ] = result;
+                    pc += check_conditional( ppd[ 1 ].d ) ? ( 4 + ppd[ 1 ].imm ) : 8;
+                    pnext++;
+                    fused_counts[ fi_subs_bcond ]++;
+                    PD_NEXT();
+                }
+                PD_CASE( pdh_subs_imm32_bcond )
+                {
+                    uint64_t result = sub32( (uint32_t) regs[ ppd->n ], (uint32_t) ppd->imm, true );
+                    if ( 31 != ppd->d )
+                        regs[ ppd->d ] = result;
+                    pc += check_conditional( ppd[ 1 ].d ) ? ( 4 + ppd[ 1 ].imm ) : 8;
+                    pnext++;
+                    fused_counts[ fi_subs_bcond ]++;
+                    PD_NEXT();
+                }
+                PD_CASE( pdh_subs_reg64_bcond )
+                {
+                    uint64_t result = sub64( regs[ ppd->n ], regs[ ppd->m ], true );
+                    if ( 31 != ppd->d )
+                        regs[ ppd->d ] = result;
+                    pc += check_conditional( ppd[ 1 ].d ) ? ( 4 + ppd[ 1 ].imm ) : 8;
+                    pnext++;
+                    fused_counts[ fi_subs_bcond ]++;
+                    PD_NEXT();
+                }
+                PD_CASE( pdh_subs_reg32_bcond )
+                {
+                    uint64_t result = sub32( (uint32_t) regs[ ppd->n ], (uint32_t) regs[ ppd->m ], true );
+                    if ( 31 != ppd->d )
+                        regs[ ppd->d ] = result;
+                    pc += check_conditional( ppd[ 1 ].d ) ? ( 4 + ppd[ 1 ].imm ) : 8;
+                    pnext++;
+                    fused_counts[ fi_subs_bcond ]++;
+                    PD_NEXT();
+                }
+                PD_CASE( pdh_adrp_add )
+                {
+                    regs[ ppd->d ] = ppd->imm;
+                    regs[ ppd[ 1 ].d ] = ppd->imm + ppd[ 1 ].imm;
+                    pc += 8;
+                    pnext++;
+                    fused_counts[ fi_adrp_add ]++;
+                    PD_NEXT();
+                }
+                PD_CASE( pdh_adrp_ldr64 )
+                {
+                    regs[ ppd->d ] = ppd->imm;
+                    regs[ ppd[ 1 ].d ] = getui64( ppd->imm + ppd[ 1 ].imm );
+                    pc += 8;
+                    pnext++;
+                    fused_counts[ fi_adrp_ldr ]++;
+                    PD_NEXT();
+                }
+                PD_CASE( pdh_adrp_ldr32 )
+                {
+                    regs[ ppd->d ] = ppd->imm;
+                    regs[ ppd[ 1 ].d ] = getui32( ppd->imm + ppd[ 1 ].imm );
+                    pc += 8;
+                    pnext++;
+                    fused_counts[ fi_adrp_ldr ]++;
+                    PD_NEXT();
+                }
+                PD_CASE( pdh_movz_movk ) // m is the count of movk instructions folded into imm
+                {
+                    regs[ ppd->d ] = ppd->imm;
+                    pc += 4 * ( 1 + ppd->m );
+                    pnext += ppd->m;
+                    fused_counts[ fi_movz_movk ]++;
+                    PD_NEXT();
+                }
+                PD_CASE( pdh_prologue ) // stp x29, x30, [sp, #imm]! ; mov x29, sp
+                {
+                    uint64_t address = regs[ 31 ] + ppd->imm;
+                    setui64( address, regs[ 29 ] );
+                    setui64( address + 8, regs[ 30 ] );
+                    regs[ 31 ] = address;
+                    regs[ 29 ] = address;
+                    pc += 8;
+                    pnext++;
+                    fused_counts[ fi_prologue ]++;
+                    PD_NEXT();
+                }
+                PD_CASE( pdh_intercept )
+                {
+                    if ( emulator_intercept( *this, (uint32_t) ppd->imm ) )
+                        PD_NEXT();
+#ifdef ARM64_COMPUTED_GOTO
+                    goto lbl_pdh_generic; // the guest's routine runs after all
+#else
+                    break;
+#endif
+                }
+                PD_CASE( pdh_epilogue ) // ldp x29, x30, [sp], #imm ; ret
+                {
+                    uint64_t address = regs[ 31 ];
+                    regs[ 29 ] = getui64( address );
+                    regs[ 30 ] = getui64( address + 8 );
+                    regs[ 31 ] = address + ppd->imm;
+                    pc = regs[ 30 ];
+                    pnext++;
+                    fused_counts[ fi_epilogue ]++;
+                    PD_NEXT();
+                }
+#ifdef ARM64_COMPUTED_GOTO
+                lbl_pdh_generic: // fall through to the full decoder
+                    op = ppd->op;
+                    hi8 = (uint8_t) ( op >> 24 );
+#else
+                default: break; // pdh_generic falls through to the full decoder
+#endif
             }
-
-            if ( g_State & stateTraceInstructions )
-                trace_state();
         }
 
-        cycles++;
+#ifdef ARM64_COMPUTED_GOTO
+        static const void * op_labels[ 256 ] = {
+            &&lbl_op_0x00, &&lbl_op_0x01, &&lbl_op_0x02, &&lbl_op_0x03, &&lbl_op_0x04, &&lbl_op_0x05, &&lbl_op_0x06, &&lbl_op_0x07, &&lbl_op_0x08, &&lbl_op_0x09, &&lbl_op_0x0a, &&lbl_op_0x0b, &&lbl_op_0x0c, &&lbl_op_0x0d, &&lbl_op_0x0e, &&lbl_op_0x0f,
+            &&lbl_op_0x10, &&lbl_op_0x11, &&lbl_op_0x12, &&lbl_op_0x13, &&lbl_op_0x14, &&lbl_op_0x15, &&lbl_op_0x16, &&lbl_op_0x17, &&lbl_op_0x18, &&lbl_op_0x19, &&lbl_op_0x1a, &&lbl_op_0x1b, &&lbl_op_0x1c, &&lbl_op_0x1d, &&lbl_op_0x1e, &&lbl_op_0x1f,
+            &&lbl_op_0x20, &&lbl_op_0x21, &&lbl_op_0x22, &&lbl_op_0x23, &&lbl_op_0x24, &&lbl_op_0x25, &&lbl_op_0x26, &&lbl_op_0x27, &&lbl_op_0x28, &&lbl_op_0x29, &&lbl_op_0x2a, &&lbl_op_0x2b, &&lbl_op_0x2c, &&lbl_op_0x2d, &&lbl_op_0x2e, &&lbl_op_0x2f,
+            &&lbl_op_0x30, &&lbl_op_0x31, &&lbl_op_0x32, &&lbl_op_0x33, &&lbl_op_0x34, &&lbl_op_0x35, &&lbl_op_0x36, &&lbl_op_0x37, &&lbl_op_0x38, &&lbl_op_0x39, &&lbl_op_0x3a, &&lbl_op_0x3b, &&lbl_op_0x3c, &&lbl_op_0x3d, &&lbl_op_0x3e, &&lbl_op_0x3f,
+            &&lbl_op_0x40, &&lbl_op_0x41, &&lbl_op_0x42, &&lbl_op_0x43, &&lbl_op_0x44, &&lbl_op_0x45, &&lbl_op_0x46, &&lbl_op_0x47, &&lbl_op_0x48, &&lbl_op_0x49, &&lbl_op_0x4a, &&lbl_op_0x4b, &&lbl_op_0x4c, &&lbl_op_0x4d, &&lbl_op_0x4e, &&lbl_op_0x4f,
+            &&lbl_op_0x50, &&lbl_op_0x51, &&lbl_op_0x52, &&lbl_op_0x53, &&lbl_op_0x54, &&lbl_op_0x55, &&lbl_op_0x56, &&lbl_op_0x57, &&lbl_op_0x58, &&lbl_op_0x59, &&lbl_op_0x5a, &&lbl_op_0x5b, &&lbl_op_0x5c, &&lbl_op_0x5d, &&lbl_op_0x5e, &&lbl_op_0x5f,
+            &&lbl_op_0x60, &&lbl_op_0x61, &&lbl_op_0x62, &&lbl_op_0x63, &&lbl_op_0x64, &&lbl_op_0x65, &&lbl_op_0x66, &&lbl_op_0x67, &&lbl_op_0x68, &&lbl_op_0x69, &&lbl_op_0x6a, &&lbl_op_0x6b, &&lbl_op_0x6c, &&lbl_op_0x6d, &&lbl_op_0x6e, &&lbl_op_0x6f,
+            &&lbl_op_0x70, &&lbl_op_0x71, &&lbl_op_0x72, &&lbl_op_0x73, &&lbl_op_0x74, &&lbl_op_0x75, &&lbl_op_0x76, &&lbl_op_0x77, &&lbl_op_0x78, &&lbl_op_0x79, &&lbl_op_0x7a, &&lbl_op_0x7b, &&lbl_op_0x7c, &&lbl_op_0x7d, &&lbl_op_0x7e, &&lbl_op_0x7f,
+            &&lbl_op_0x80, &&lbl_op_0x81, &&lbl_op_0x82, &&lbl_op_0x83, &&lbl_op_0x84, &&lbl_op_0x85, &&lbl_op_0x86, &&lbl_op_0x87, &&lbl_op_0x88, &&lbl_op_0x89, &&lbl_op_0x8a, &&lbl_op_0x8b, &&lbl_op_0x8c, &&lbl_op_0x8d, &&lbl_op_0x8e, &&lbl_op_0x8f,
+            &&lbl_op_0x90, &&lbl_op_0x91, &&lbl_op_0x92, &&lbl_op_0x93, &&lbl_op_0x94, &&lbl_op_0x95, &&lbl_op_0x96, &&lbl_op_0x97, &&lbl_op_0x98, &&lbl_op_0x99, &&lbl_op_0x9a, &&lbl_op_0x9b, &&lbl_op_0x9c, &&lbl_op_0x9d, &&lbl_op_0x9e, &&lbl_op_0x9f,
+            &&lbl_op_0xa0, &&lbl_op_0xa1, &&lbl_op_0xa2, &&lbl_op_0xa3, &&lbl_op_0xa4, &&lbl_op_0xa5, &&lbl_op_0xa6, &&lbl_op_0xa7, &&lbl_op_0xa8, &&lbl_op_0xa9, &&lbl_op_0xaa, &&lbl_op_0xab, &&lbl_op_0xac, &&lbl_op_0xad, &&lbl_op_0xae, &&lbl_op_0xaf,
+            &&lbl_op_0xb0, &&lbl_op_0xb1, &&lbl_op_0xb2, &&lbl_op_0xb3, &&lbl_op_0xb4, &&lbl_op_0xb5, &&lbl_op_0xb6, &&lbl_op_0xb7, &&lbl_op_0xb8, &&lbl_op_0xb9, &&lbl_op_0xba, &&lbl_op_0xbb, &&lbl_op_0xbc, &&lbl_op_0xbd, &&lbl_op_0xbe, &&lbl_op_0xbf,
+            &&lbl_op_0xc0, &&lbl_op_0xc1, &&lbl_op_0xc2, &&lbl_op_0xc3, &&lbl_op_0xc4, &&lbl_op_0xc5, &&lbl_op_0xc6, &&lbl_op_0xc7, &&lbl_op_0xc8, &&lbl_op_0xc9, &&lbl_op_0xca, &&lbl_op_0xcb, &&lbl_op_0xcc, &&lbl_op_0xcd, &&lbl_op_0xce, &&lbl_op_0xcf,
+            &&lbl_op_0xd0, &&lbl_op_0xd1, &&lbl_op_0xd2, &&lbl_op_0xd3, &&lbl_op_0xd4, &&lbl_op_0xd5, &&lbl_op_0xd6, &&lbl_op_0xd7, &&lbl_op_0xd8, &&lbl_op_0xd9, &&lbl_op_0xda, &&lbl_op_0xdb, &&lbl_op_0xdc, &&lbl_op_0xdd, &&lbl_op_0xde, &&lbl_op_0xdf,
+            &&lbl_op_0xe0, &&lbl_op_0xe1, &&lbl_op_0xe2, &&lbl_op_0xe3, &&lbl_op_0xe4, &&lbl_op_0xe5, &&lbl_op_0xe6, &&lbl_op_0xe7, &&lbl_op_0xe8, &&lbl_op_0xe9, &&lbl_op_0xea, &&lbl_op_0xeb, &&lbl_op_0xec, &&lbl_op_0xed, &&lbl_op_0xee, &&lbl_op_0xef,
+            &&lbl_op_0xf0, &&lbl_op_0xf1, &&lbl_op_0xf2, &&lbl_op_0xf3, &&lbl_op_0xf4, &&lbl_op_0xf5, &&lbl_op_0xf6, &&lbl_op_0xf7, &&lbl_op_0xf8, &&lbl_op_0xf9, &&lbl_op_0xfa, &&lbl_op_0xfb, &&lbl_op_0xfc, &&lbl_op_0xfd, &&lbl_op_0xfe, &&lbl_op_0xff };
+
+        goto * op_labels[ hi8 ];
+#endif
 
         switch ( hi8 )
         {
-            case 0: // UDF
+            OP_CASE( 0x00 ) // UDF
             {
                 uint64_t bits23to16 = opbits( 16, 8 );
                 if ( 0 == bits23to16 )
@@ -3920,7 +6616,7 @@ uint64_t Arm64::run( void )
                     unhandled();
                 break;
             }
-            case 0x5f: // SHL D<d>, D<n>, #<shift>    ;    FMUL <Vd>.<T>, <Vn>.<T>, <Vm>.<Ts>[<index>]    ;    FMLA <Vd>.<T>, <Vn>.<T>, <Vm>.<Ts>[<index>]
+            OP_CASE( 0x5f ) // SHL D<d>, D<n>, #<shift>    ;    FMUL <Vd>.<T>, <Vn>.<T>, <Vm>.<Ts>[<index>]    ;    FMLA <Vd>.<T>, <Vn>.<T>, <Vm>.<Ts>[<index>]
                        // SSHR D<d>, D<n>, #<shift>
             {
                 uint64_t n = opbits( 5, 5 );
@@ -3959,7 +6655,8 @@ uint64_t Arm64::run( void )
                     uint64_t datasize = 64ull << Q;
                     uint64_t elements = datasize / esize;
                     vec16_t target;
-                    if ( 4 == opcode || 6 == opcode ) // FMLA <Vd>.<T>, <Vn>.<T>, <Vm>.<Ts>[<index>]
+                    bool fmla = ( 4 == opcode || 6 == opcode ); // FMLA <Vd>.<T>, <Vn>.<T>, <Vm>.<Ts>[<index>]
+                    if ( fmla )
                         target = vregs[ d ];
                     vec16_t & nvec = vregs[ n ];
 
@@ -3973,9 +6670,9 @@ uint64_t Arm64::run( void )
                     for ( uint64_t e = 0; e < elements; e++ )
                     {
                         if ( 4 == ebytes )
-                            target.setf( e, target.getf( e ) + (float) do_fmul( nvec.getf( e ), mfloat ) );
+                            target.setf( e, fmla ? do_fmaddf( nvec.getf( e ), mfloat, target.getf( e ) ) : (float) do_fmul( nvec.getf( e ), mfloat ) );
                         else if ( 8 == ebytes )
-                            target.setd( e, target.getd( e ) + do_fmul( nvec.getd( e ), mdouble ) );
+                            target.setd( e, fmla ? do_fmadd( nvec.getd( e ), mdouble, target.getd( e ) ) : do_fmul( nvec.getd( e ), mdouble ) );
                     }
 
                     vregs[ d ] = target;
@@ -3989,7 +6686,7 @@ uint64_t Arm64::run( void )
                     unhandled();
                 break;
             }
-            case 0x0d: case 0x4d: // LD1 { <Vt>.B }[<index>], [<Xn|SP>]    ;    LD1 { <Vt>.B }[<index>], [<Xn|SP>], #1
+            OP_CASE( 0x0d ) OP_CASE( 0x4d ) // LD1 { <Vt>.B }[<index>], [<Xn|SP>]    ;    LD1 { <Vt>.B }[<index>], [<Xn|SP>], #1
                                   // LD1R { <Vt>.<T> }, [<Xn|SP>], <imm>   ;    LD1R { <Vt>.<T> }, [<Xn|SP>], <Xm>
                                   // ST1 { <Vt>.B }[<index>], [<Xn|SP>]    ;    ST1 { <Vt>.B }[<index>], [<Xn|SP>], #1
             {
@@ -4044,7 +6741,7 @@ uint64_t Arm64::run( void )
                         uint64_t eaddr = nval + offs;
                         uint64_t element = 0;
                         if ( 1 == ebytes )
-                            element = * getmem( eaddr );
+                            element = getui8( eaddr );
                         else if ( 2 == ebytes )
                             element = getui16( eaddr );
                         else if ( 4 == ebytes )
@@ -4063,6 +6760,7 @@ uint64_t Arm64::run( void )
                     for ( uint64_t e = 0; e < selem; e++ )
                     {
                         uint64_t eaddr = nval + offs;
+                        track( eaddr, (uint32_t) ebytes, !L );
                         if ( L )
                             mcpy( vreg_ptr( t, index * ebytes ), getmem( eaddr ), ebytes );
                         else
@@ -4079,12 +6777,13 @@ uint64_t Arm64::run( void )
                 if ( post_index )
                     regs[ n ] += offs;
 
-                trace_vregs();
+                if ( stepping )
+                    trace_vregs();
                 break;
             }
-            case 0x08: // LDAXRB <Wt>, [<Xn|SP>{, #0}]    ;    LDARB <Wt>, [<Xn|SP>{, #0}]    ;    STLXRB <Ws>, <Wt>, [<Xn|SP>{, #0}]    ;
+            OP_CASE( 0x08 ) // LDAXRB <Wt>, [<Xn|SP>{, #0}]    ;    LDARB <Wt>, [<Xn|SP>{, #0}]    ;    STLXRB <Ws>, <Wt>, [<Xn|SP>{, #0}]    ;
                        // STXRB <Ws>, <Wt>, [<Xn|SP>{, #0}] ;  LDXRB <Wt>, [<Xn|SP>{, #0}]
-            case 0x48: // LDAXRH <Wt>, [<Xn|SP>{, #0}]    ;    LDARH <Wt>, [<Xn|SP>{, #0}]    ;    STLXRH <Ws>, <Wt>, [<Xn|SP>{, #0}]    ;    STLRH <Wt>, [<Xn|SP>{, #0}]
+            OP_CASE( 0x48 ) // LDAXRH <Wt>, [<Xn|SP>{, #0}]    ;    LDARH <Wt>, [<Xn|SP>{, #0}]    ;    STLXRH <Ws>, <Wt>, [<Xn|SP>{, #0}]    ;    STLRH <Wt>, [<Xn|SP>{, #0}]
                        // STXRH <Ws>, <Wt>, [<Xn|SP>{, #0}] ;  LDXRH <Wt>, [<Xn|SP>{, #0}]
             {
                 uint64_t bit23 = opbit( 23 );
@@ -4096,35 +6795,89 @@ uint64_t Arm64::run( void )
                 uint64_t t = opbits( 0, 5 );
                 bool is16 = opbit( 30 );
 
-                if ( 0 != bit21 || 0x1f != t2 )
+                if ( 0x1f != t2 )
                     unhandled();
 
-                if ( L )
+                if ( bit21 ) // CAS{A}{L}B/H <Ws>, <Wt>, [<Xn|SP>]    ;    CASP{A}{L} <Ws>, <W(s+1)>, <Wt>, <W(t+1)>, [<Xn|SP>]    ;    CASP{A}{L} <Xs>, <X(s+1)>, <Xt>, <X(t+1)>, [<Xn|SP>]
                 {
-                    if ( 31 == t )
+                    if ( bit23 )
+                    {
+                        uint64_t mask = is16 ? 0xffff : 0xff;
+                        uint64_t old = compare_and_swap( regs[ n ], val_reg_or_zr( s ) & mask, val_reg_or_zr( t ) & mask, is16 ? 2 : 1 );
+                        if ( 31 != s )
+                            regs[ s ] = old;
                         break;
+                    }
+
+                    if ( ( s & 1 ) || ( t & 1 ) )
+                        unhandled();
+
+                    uint64_t old[ 2 ];
+                    if ( is16 ) // the pair is two x registers
+                    {
+                        uint64_t desired[ 2 ] = { val_reg_or_zr( t ), val_reg_or_zr( t + 1 ) };
+                        old[ 0 ] = val_reg_or_zr( s );
+                        old[ 1 ] = val_reg_or_zr( s + 1 );
+                        compare_and_swap_pair( regs[ n ], old, desired );
+                    }
+                    else
+                    {
+                        uint64_t expected = (uint32_t) val_reg_or_zr( s ) | ( val_reg_or_zr( s + 1 ) << 32 );
+                        uint64_t desired = (uint32_t) val_reg_or_zr( t ) | ( val_reg_or_zr( t + 1 ) << 32 );
+                        uint64_t both = compare_and_swap( regs[ n ], expected, desired, 8 );
+                        old[ 0 ] = (uint32_t) both;
+                        old[ 1 ] = both >> 32;
+                    }
+
+                    if ( 31 != s )
+                        regs[ s ] = old[ 0 ];
+                    if ( 30 != s )
+                        regs[ s + 1 ] = old[ 1 ];
+                    break;
+                }
+
+                bool ordered = opbit( 15 ); // ldar, ldaxr, stlr, stlxr
 
+                if ( L )
+                {
                     if ( 0x1f != s )
                         unhandled();
 
-                    if ( is16 )
-                        regs[ t ] = getui16( regs[ n ] );
+                    uint64_t val;
+                    if ( !bit23 )
+                        val = load_exclusive( regs[ n ], is16 ? 2 : 1 );
+                    else if ( is16 )
+                        val = getui16( regs[ n ] );
                     else
-                        regs[ t ] = getui8( regs[ n ] );
+                        val = getui8( regs[ n ] );
+
+                    if ( ordered )
+                        atomic_thread_fence( memory_order_acquire );
+
+                    if ( 31 != t )
+                        regs[ t ] = val;
                 }
                 else
                 {
-                    if ( !bit23 && 31 != s )
-                        regs[ s ] = 0; // indicate the store succeeded for stlxrW and stxrW
+                    uint64_t val = val_reg_or_zr( t ) & ( is16 ? 0xffff : 0xff );
 
-                    if ( is16 )
-                        setui16( regs[ n ], 0xffff & val_reg_or_zr( t ) );
+                    if ( ordered )
+                        atomic_thread_fence( memory_order_release );
+
+                    if ( !bit23 ) // stxr and stlxr write 0 to Ws on success and 1 on failure
+                    {
+                        bool ok = store_exclusive( regs[ n ], val, is16 ? 2 : 1 );
+                        if ( 31 != s )
+                            regs[ s ] = ok ? 0 : 1;
+                    }
+                    else if ( is16 )
+                        setui16( regs[ n ], (uint16_t) val );
                     else
-                        setui8( regs[ n ], 0xff & val_reg_or_zr( t ) );
+                        setui8( regs[ n ], (uint8_t) val );
                 }
                 break;
             }
-            case 0x1f: // fmadd, fnmadd, fmsub, fnmsub
+            OP_CASE( 0x1f ) // fmadd, fnmadd, fmsub, fnmsub
             {
                 uint64_t ftype = opbits( 22, 2 );
                 uint64_t m = opbits( 16, 5 );
@@ -4134,59 +6887,38 @@ uint64_t Arm64::run( void )
                 uint64_t subtract = opbit( 15 );
                 uint64_t negate = opbit( 21 );
 
+                // FMADD n * m + a, FMSUB a - n * m, FNMADD -a - n * m, FNMSUB n * m - a, each with a single rounding
+
+                bool negate_product = ( subtract != negate );
+
                 if ( 0 == ftype ) // float
                 {
-                    // do math using doubles to match the behavior of arm64 hardware (test app ttypes.c validates this)
-
-                    double product = do_fmul( vregs[ n ].getf( 0 ), vregs[ m ].getf( 0 ) );
-                    if ( subtract )
-                    {
-                        if ( negate )
-                            vregs[ d ].setf( 0, (float) do_fsub( product, vregs[ a ].getf( 0 ) ) );
-                        else
-                            vregs[ d ].setf( 0, (float) do_fsub( vregs[ a ].getf( 0 ), product ) );
-                    }
-                    else
-                    {
-                        if ( negate )
-                            vregs[ d ].setf( 0, (float) do_fsub( -product, vregs[ a ].getf( 0 ) ) );
-                        else
-                            vregs[ d ].setf( 0, (float) do_fadd( product, vregs[ a ].getf( 0 ) ) );
-                    }
+                    float nval = vregs[ n ].getf( 0 );
+                    float aval = vregs[ a ].getf( 0 );
+                    vregs[ d ].setf( 0, do_fmaddf( negate_product ? -nval : nval, vregs[ m ].getf( 0 ), negate ? -aval : aval ) );
                     memset( vreg_ptr( d, 4 ), 0, 12 );
                 }
                 else if ( 1 == ftype ) // double
                 {
-                    double product = do_fmul( vregs[ n ].getd( 0 ), vregs[ m ].getd( 0 ) );
-                    if ( subtract )
-                    {
-                        if ( negate )
-                            vregs[ d ].setd( 0, do_fsub( product, vregs[ a ].getd( 0 ) ) );
-                        else
-                            vregs[ d ].setd( 0, do_fsub( vregs[ a ].getd( 0 ), product ) );
-                    }
-                    else
-                    {
-                        if ( negate )
-                            vregs[ d ].setd( 0, do_fsub( -product, vregs[ a ].getd( 0 ) ) );
-                        else
-                            vregs[ d ].setd( 0, do_fadd( product, vregs[ a ].getd( 0 ) ) );
-                    }
+                    double nval = vregs[ n ].getd( 0 );
+                    double aval = vregs[ a ].getd( 0 );
+                    vregs[ d ].setd( 0, do_fmadd( negate_product ? -nval : nval, vregs[ m ].getd( 0 ), negate ? -aval : aval ) );
                     memset( vreg_ptr( d, 8 ), 0, 8 );
                 }
                 else
                     unhandled();
-                trace_vregs();
+                if ( stepping )
+                    trace_vregs();
                 break;
             }
-            case 0x3c: // LDR <Bt>, [<Xn|SP>], #<simm>    ;    LDR <Bt>, [<Xn|SP>, #<simm>]!    ;    LDR <Qt>, [<Xn|SP>], #<simm>    ;     LDR <Qt>, [<Xn|SP>, #<simm>]!    ;    STUR <Bt>, [<Xn|SP>{, #<simm>}]
-            case 0x3d: // LDR <Bt>, [<Xn|SP>{, #<pimm>}]  ;    LDR <Qt>, [<Xn|SP>{, #<pimm>}]
-            case 0x7c: // LDR <Ht>, [<Xn|SP>], #<simm>    ;    LDR <Ht>, [<Xn|SP>, #<simm>]!
-            case 0x7d: // LDR <Ht>, [<Xn|SP>{, #<pimm>}]
-            case 0xbc:
-            case 0xbd: // LDR <Dt>, [<Xn|SP>{, #<pimm>}]
-            case 0xfc: // LDR <Dt>, [<Xn|SP>], #<simm>    ;    LDR <Dt>, [<Xn|SP>, #<simm>]!    ;    STR <Dt>, [<Xn|SP>], #<simm>    ;    STR <Dt>, [<Xn|SP>, #<simm>]!
-            case 0xfd: // LDR <Dt>, [<Xn|SP>{, #<pimm>}]  ;    STR <Dt>, [<Xn|SP>{, #<pimm>}]
+            OP_CASE( 0x3c ) // LDR <Bt>, [<Xn|SP>], #<simm>    ;    LDR <Bt>, [<Xn|SP>, #<simm>]!    ;    LDR <Qt>, [<Xn|SP>], #<simm>    ;     LDR <Qt>, [<Xn|SP>, #<simm>]!    ;    STUR <Bt>, [<Xn|SP>{, #<simm>}]
+            OP_CASE( 0x3d ) // LDR <Bt>, [<Xn|SP>{, #<pimm>}]  ;    LDR <Qt>, [<Xn|SP>{, #<pimm>}]
+            OP_CASE( 0x7c ) // LDR <Ht>, [<Xn|SP>], #<simm>    ;    LDR <Ht>, [<Xn|SP>, #<simm>]!
+            OP_CASE( 0x7d ) // LDR <Ht>, [<Xn|SP>{, #<pimm>}]
+            OP_CASE( 0xbc )
+            OP_CASE( 0xbd ) // LDR <Dt>, [<Xn|SP>{, #<pimm>}]
+            OP_CASE( 0xfc ) // LDR <Dt>, [<Xn|SP>], #<simm>    ;    LDR <Dt>, [<Xn|SP>, #<simm>]!    ;    STR <Dt>, [<Xn|SP>], #<simm>    ;    STR <Dt>, [<Xn|SP>, #<simm>]!
+            OP_CASE( 0xfd ) // LDR <Dt>, [<Xn|SP>{, #<pimm>}]  ;    STR <Dt>, [<Xn|SP>{, #<pimm>}]
             {
                 uint64_t bits11_10 = opbits( 10, 2 );
                 uint64_t bit21 = opbit( 21 );
@@ -4267,6 +6999,7 @@ uint64_t Arm64::run( void )
                 else if ( !postIndex )
                     unhandled();
 
+                track( address, (uint32_t) byte_len, !is_ldr );
                 if ( is_ldr )
                 {
                     zero_vreg( t );
@@ -4278,15 +7011,16 @@ uint64_t Arm64::run( void )
                 if ( postIndex )
                      regs[ n ] += imm9;
 
-                trace_vregs();
+                if ( stepping )
+                    trace_vregs();
                 break;
             }
-            case 0x2c: // STP <St1>, <St2>, [<Xn|SP>], #<imm>     ;    LDP <St1>, <St2>,
-            case 0x6c: // STP <Dt1>, <Dt2>, [<Xn|SP>], #<imm>     ;    LDP <Dt1>, <Dt2>, [<Xn|SP>], #<imm>
-            case 0xac: // STP <Qt1>, <Qt2>, [<Xn|SP>], #<imm>          LDP <Qt1>, <Qt2>, [<Xn|SP>], #<imm>
-            case 0x2d: // STP <St1>, <St2>, [<Xn|SP>, #<imm>]!    ;    STP <St1>, <St2>, [<Xn|SP>{, #<imm>}]    ;    LDP <St1>, <St2>, [<Xn|SP>, #<imm>]!    ;    LDP <St1>, <St2>, [<Xn|SP>{, #<imm>}]
-            case 0x6d: // STP <Dt1>, <Dt2>, [<Xn|SP>, #<imm>]!    ;    STP <Dt1>, <Dt2>, [<Xn|SP>{, #<imm>}]    ;    LDP <Dt1>, <Dt2>, [<Xn|SP>, #<imm>]!    ;    LDP <Dt1>, <Dt2>, [<Xn|SP>{, #<imm>}]
-            case 0xad: // STP <Qt1>, <Qt2>, [<Xn|SP>, #<imm>]!    ;    STP <Qt1>, <Qt2>, [<Xn|SP>{, #<imm>}]    ;    LDP <Qt1>, <Qt2>, [<Xn|SP>, #<imm>]!    ;    LDP <Qt1>, <Qt2>, [<Xn|SP>{, #<imm>}]
+            OP_CASE( 0x2c ) // STP <St1>, <St2>, [<Xn|SP>], #<imm>     ;    LDP <St1>, <St2>,
+            OP_CASE( 0x6c ) // STP <Dt1>, <Dt2>, [<Xn|SP>], #<imm>     ;    LDP <Dt1>, <Dt2>, [<Xn|SP>], #<imm>
+            OP_CASE( 0xac ) // STP <Qt1>, <Qt2>, [<Xn|SP>], #<imm>          LDP <Qt1>, <Qt2>, [<Xn|SP>], #<imm>
+            OP_CASE( 0x2d ) // STP <St1>, <St2>, [<Xn|SP>, #<imm>]!    ;    STP <St1>, <St2>, [<Xn|SP>{, #<imm>}]    ;    LDP <St1>, <St2>, [<Xn|SP>, #<imm>]!    ;    LDP <St1>, <St2>, [<Xn|SP>{, #<imm>}]
+            OP_CASE( 0x6d ) // STP <Dt1>, <Dt2>, [<Xn|SP>, #<imm>]!    ;    STP <Dt1>, <Dt2>, [<Xn|SP>{, #<imm>}]    ;    LDP <Dt1>, <Dt2>, [<Xn|SP>, #<imm>]!    ;    LDP <Dt1>, <Dt2>, [<Xn|SP>{, #<imm>}]
+            OP_CASE( 0xad ) // STP <Qt1>, <Qt2>, [<Xn|SP>, #<imm>]!    ;    STP <Qt1>, <Qt2>, [<Xn|SP>{, #<imm>}]    ;    LDP <Qt1>, <Qt2>, [<Xn|SP>, #<imm>]!    ;    LDP <Qt1>, <Qt2>, [<Xn|SP>{, #<imm>}]
             {
                 uint64_t opc = opbits( 30, 2 );
                 uint64_t imm7 = opbits( 15, 7 );
@@ -4308,6 +7042,7 @@ uint64_t Arm64::run( void )
                 if ( preIndex || signedOffset )
                     address += offset;
 
+                track( address, (uint32_t) ( 2 * byte_len ), 0 == L );
                 if ( 1 == L ) // ldp
                 {
                     zero_vreg( t1 );
@@ -4327,10 +7062,11 @@ uint64_t Arm64::run( void )
                 if ( !signedOffset )
                     regs[ n ] = address;
 
-                trace_vregs();
+                if ( stepping )
+                    trace_vregs();
                 break;
             }
-            case 0x0f: case 0x2f: case 0x4f: case 0x6f: case 0x7f:
+            OP_CASE( 0x0f ) OP_CASE( 0x2f ) OP_CASE( 0x4f ) OP_CASE( 0x6f ) OP_CASE( 0x7f )
                 // BIC <Vd>.<T>, #<imm8>{, LSL #<amount>}    ;    MOVI <Vd>.<T>, #<imm8>{, LSL #0}    ;    MVNI <Vd>.<T>, #<imm8>, MSL #<amount>
                 // USHR <Vd>.<T>, <Vn>.<T>, #<shift>         ;    FMUL <Vd>.<T>, <Vn>.<T>, <Vm>.<Ts>[<index>]
                 // FMOV <Vd>.<T>, #<imm>                     ;    FMOV <Vd>.<T>, #<imm>               ;    FMOV <Vd>.2D, #<imm>
@@ -4709,13 +7445,13 @@ uint64_t Arm64::run( void )
                         {
                             double element2 = vregs[ m ].getd( index );
                             for ( uint64_t e = 0; e < elements; e++ )
-                                target.setd( e, do_fadd( target.getd( e ), do_fmul( element2, vn.getd( e ) ) ) );
+                                target.setd( e, do_fmadd( element2, vn.getd( e ), target.getd( e ) ) );
                         }
                         else if ( 4 == ebytes )
                         {
-                            double element2 = (double) vregs[ m ].getf( index );
+                            float element2 = vregs[ m ].getf( index );
                             for ( uint64_t e = 0; e < elements; e++ )
-                                target.setf( e, (float) do_fadd( target.getf( e ), do_fmul( element2, vn.getf( e ) ) ) );
+                                target.setf( e, do_fmaddf( element2, vn.getf( e ), target.getf( e ) ) );
                         }
                         else
                             unhandled() ;
@@ -4879,11 +7615,12 @@ uint64_t Arm64::run( void )
                         unhandled();
                 }
 
-                trace_vregs();
+                if ( stepping )
+                    trace_vregs();
                 break;
             }
-            case 0x5a: // REV <Wd>, <Wn>  ;  CSINV <Wd>, <Wn>, <Wm>, <cond>  ;  RBIT <Wd>, <Wn>  ;  CLZ <Wd>, <Wn>  ;  CSNEG <Wd>, <Wn>, <Wm>, <cond>  ;  SBC <Wd>, <Wn>, <Wm> ; REV16 <Wd>, <Wn>
-            case 0xda: // REV <Xd>, <Xn>  ;  CSINV <Xd>, <Xn>, <Xm>, <cond>  ;  RBIT <Xd>, <Xn>  ;  CLZ <Xd>, <Xn>  ;  CSNEG <Xd>, <Xn>, <Xm>, <cond>  ;  SBC <Xd>, <Xn>, <Xm> ; REV16 <Xd>, <Xn>
+            OP_CASE( 0x5a ) // REV <Wd>, <Wn>  ;  CSINV <Wd>, <Wn>, <Wm>, <cond>  ;  RBIT <Wd>, <Wn>  ;  CLZ <Wd>, <Wn>  ;  CSNEG <Wd>, <Wn>, <Wm>, <cond>  ;  SBC <Wd>, <Wn>, <Wm> ; REV16 <Wd>, <Wn>
+            OP_CASE( 0xda ) // REV <Xd>, <Xn>  ;  CSINV <Xd>, <Xn>, <Xm>, <cond>  ;  RBIT <Xd>, <Xn>  ;  CLZ <Xd>, <Xn>  ;  CSNEG <Xd>, <Xn>, <Xm>, <cond>  ;  SBC <Xd>, <Xn>, <Xm> ; REV16 <Xd>, <Xn>
             {
                 uint64_t xregs = ( 0 != ( 0x80 & hi8 ) );
                 uint64_t opc = opbits( 10, 2 ); // 2 or 3 for container size
@@ -4974,9 +7711,9 @@ uint64_t Arm64::run( void )
                         uint64_t mval = val_reg_or_zr( m );
 
                         if ( xregs )
-                            result = add_with_carry64( nval, ~mval, fC, false );
+                            result = add_with_carry64( nval, ~mval, carry_flag(), false );
                         else
-                            result = add_with_carry32( (uint32_t) nval, (uint32_t) ( ~ mval ), fC, false );
+                            result = add_with_carry32( (uint32_t) nval, (uint32_t) ( ~ mval ), carry_flag(), false );
                     }
                     else
                         unhandled();
@@ -4991,7 +7728,7 @@ uint64_t Arm64::run( void )
                 regs[ d ] = result;
                 break;
             }
-            case 0x14: case 0x15: case 0x16: case 0x17: // b label
+            OP_CASE( 0x14 ) OP_CASE( 0x15 ) OP_CASE( 0x16 ) OP_CASE( 0x17 ) // b label
             {
                 int64_t imm26 = opbits( 0, 26 );
                 imm26 <<= 2;
@@ -4999,10 +7736,10 @@ uint64_t Arm64::run( void )
                 pc += imm26;
                 continue;
             }
-            case 0x1a: // CSEL <Wd>, <Wn>, <Wm>, <cond>    ;    SDIV <Wd>, <Wn>, <Wm>    ;    UDIV <Wd>, <Wn>, <Wm>    ;    CSINC <Wd>, <Wn>, <Wm>, <cond>
+            OP_CASE( 0x1a ) // CSEL <Wd>, <Wn>, <Wm>, <cond>    ;    SDIV <Wd>, <Wn>, <Wm>    ;    UDIV <Wd>, <Wn>, <Wm>    ;    CSINC <Wd>, <Wn>, <Wm>, <cond>
                        // LSRV <Wd>, <Wn>, <Wm>            ;    LSLV <Wd>, <Wn>, <Wm>    ;    ADC <Wd>, <Wn>, <Wm>     ;    ASRV <Wd>, <Wn>, <Wm>
                        // RORV <Wd>, <Wn>, <Wm>
-            case 0x9a: // CSEL <Xd>, <Xn>, <Xm>, <cond>    ;    SDIV <Xd>, <Xn>, <Xm>    ;    UDIV <Xd>, <Xn>, <Xm>    ;    CSINC <Xd>, <Xn>, <Xm>, <cond>
+            OP_CASE( 0x9a ) // CSEL <Xd>, <Xn>, <Xm>, <cond>    ;    SDIV <Xd>, <Xn>, <Xm>    ;    UDIV <Xd>, <Xn>, <Xm>    ;    CSINC <Xd>, <Xn>, <Xm>, <cond>
                        // LSRV <Xd>, <Xn>, <Xm>            ;    LSLV <Xd>, <Xn>, <Xm>    ;    ADC <Xd>, <Xn>, <Xm>     ;    ASRV <Xd>, <Xn>, <Xm>
                        // RORV <Xd>, <Xn>, <Xm>
             {
@@ -5052,6 +7789,12 @@ uint64_t Arm64::run( void )
 
                     regs[ d ] = result;
                 }
+                else if ( 6 == bits23_21 && 4 == ( bits15_12 & 0xe ) ) // CRC32{C}B/H/W <Wd>, <Wn>, <Wm>    ;    CRC32{C}X <Wd>, <Wn>, <Xm>
+                {
+                    if ( xregs != ( 3 == bits11_10 ) )
+                        unhandled();
+                    regs[ d ] = crc32_update( (uint32_t) nval, mval, 1ull << bits11_10, 0 != ( bits15_12 & 1 ) );
+                }
                 else if ( 2 == bits11_10 && 6 == bits23_21 && 0 == bits15_12 ) // UDIV <Xd>, <Xn>, <Xm>
                 {
                     if ( xregs )
@@ -5095,9 +7838,9 @@ uint64_t Arm64::run( void )
                 else if ( 0 == bits11_10 && 0 == bits23_21 && 0 == bits15_12 && 0 == bits11_10 ) // addc
                 {
                     if ( xregs )
-                        regs[ d ] = add_with_carry64( nval, mval, fC, false );
+                        regs[ d ] = add_with_carry64( nval, mval, carry_flag(), false );
                     else
-                        regs[ d ] = add_with_carry32( (uint32_t) nval, (uint32_t) mval, fC, false );
+                        regs[ d ] = add_with_carry32( (uint32_t) nval, (uint32_t) mval, carry_flag(), false );
                 }
                 else if ( 3 == bits11_10 && 6 == bits23_21 && 2 == bits15_12 ) // RORV <Xd>, <Xn>, <Xm>
                 {
@@ -5113,7 +7856,7 @@ uint64_t Arm64::run( void )
                     regs[ d ] = (uint32_t) regs[ d ];
                 break;
             }
-            case 0x54: // b.cond
+            OP_CASE( 0x54 ) // b.cond
             {
                 if ( check_conditional( opbits( 0, 4 ) ) )
                 {
@@ -5125,8 +7868,8 @@ uint64_t Arm64::run( void )
                 }
                 break;
             }
-            case 0x18: // ldr wt, (literal)
-            case 0x58: // ldr xt, (literal)
+            OP_CASE( 0x18 ) // ldr wt, (literal)
+            OP_CASE( 0x58 ) // ldr xt, (literal)
             {
                 uint64_t imm19 = opbits( 5, 19 );
                 uint64_t t = opbits( 0, 5 );
@@ -5140,10 +7883,10 @@ uint64_t Arm64::run( void )
                     regs[ t ] = getui32( address );
                 break;
             }
-            case 0x3a: // CCMN <Wn>, #<imm>, #<nzcv>, <cond>  ;    CCMN <Wn>, <Wm>, #<nzcv>, <cond>       ;    ADCS <Wd>, <Wn>, <Wm>
-            case 0xba: // CCMN <Wn>, <Wm>, #<nzcv>, <cond>    ;    CCMN <Xn>, <Xm>, #<nzcv>, <cond>       ;    ADCS <Xd>, <Xn>, <Xm>
-            case 0x7a: // CCMP <Wn>, <Wm>, #<nzcv>, <cond>    ;    CCMP <Wn>, #<imm>, #<nzcv>, <cond>     ;    SBCS <Wd>, <Wn>, <Wm>
-            case 0xfa: // CCMP <Xn>, <Xm>, #<nzcv>, <cond>    ;    CCMP <Xn>, #<imm>, #<nzcv>, <cond>     ;    SBCS <Xd>, <Xn>, <Xm>
+            OP_CASE( 0x3a ) // CCMN <Wn>, #<imm>, #<nzcv>, <cond>  ;    CCMN <Wn>, <Wm>, #<nzcv>, <cond>       ;    ADCS <Wd>, <Wn>, <Wm>
+            OP_CASE( 0xba ) // CCMN <Wn>, <Wm>, #<nzcv>, <cond>    ;    CCMN <Xn>, <Xm>, #<nzcv>, <cond>       ;    ADCS <Xd>, <Xn>, <Xm>
+            OP_CASE( 0x7a ) // CCMP <Wn>, <Wm>, #<nzcv>, <cond>    ;    CCMP <Wn>, #<imm>, #<nzcv>, <cond>     ;    SBCS <Wd>, <Wn>, <Wm>
+            OP_CASE( 0xfa ) // CCMP <Xn>, <Xm>, #<nzcv>, <cond>    ;    CCMP <Xn>, #<imm>, #<nzcv>, <cond>     ;    SBCS <Xd>, <Xn>, <Xm>
             {
                 uint64_t bits23_21 = opbits( 21, 3 );
                 uint64_t bits15_10 = opbits( 10, 6 );
@@ -5198,9 +7941,9 @@ uint64_t Arm64::run( void )
 
                     uint64_t result = 0;
                     if ( xregs )
-                        result = add_with_carry64( nval, ~mval, fC, true );
+                        result = add_with_carry64( nval, ~mval, carry_flag(), true );
                     else
-                        result = add_with_carry32( (uint32_t) nval, (uint32_t) ( ~ mval ), fC, true );
+                        result = add_with_carry32( (uint32_t) nval, (uint32_t) ( ~ mval ), carry_flag(), true );
                     if ( 31 != d )
                         regs[ d ] = result;
                 }
@@ -5213,9 +7956,9 @@ uint64_t Arm64::run( void )
 
                     uint64_t result = 0;
                     if ( xregs )
-                        result = add_with_carry64( nval, mval, fC, true );
+                        result = add_with_carry64( nval, mval, carry_flag(), true );
                     else
-                        result = add_with_carry32( (uint32_t) nval, (uint32_t) mval, fC, true );
+                        result = add_with_carry32( (uint32_t) nval, (uint32_t) mval, carry_flag(), true );
                     if ( 31 != d )
                         regs[ d ] = result;
                 }
@@ -5223,10 +7966,10 @@ uint64_t Arm64::run( void )
                     unhandled();
                 break;
             }
-            case 0x71: // SUBS <Wd>, <Wn|WSP>, #<imm>{, <shift>}   ;   CMP <Wn|WSP>, #<imm>{, <shift>}
-            case 0xf1: // SUBS <Xd>, <Xn|SP>, #<imm>{, <shift>}    ;   cmp <xn|SP>, #imm [,<shift>]
-            case 0x31: // ADDS <Wd>, <Wn|WSP>, #<imm>{, <shift>}  ;    CMN <Wn|WSP>, #<imm>{, <shift>}
-            case 0xb1: // ADDS <Xd>, <Xn|SP>, #<imm>{, <shift>}   ;    CMN <Xn|SP>, #<imm>{, <shift>}
+            OP_CASE( 0x71 ) // SUBS <Wd>, <Wn|WSP>, #<imm>{, <shift>}   ;   CMP <Wn|WSP>, #<imm>{, <shift>}
+            OP_CASE( 0xf1 ) // SUBS <Xd>, <Xn|SP>, #<imm>{, <shift>}    ;   cmp <xn|SP>, #imm [,<shift>]
+            OP_CASE( 0x31 ) // ADDS <Wd>, <Wn|WSP>, #<imm>{, <shift>}  ;    CMN <Wn|WSP>, #<imm>{, <shift>}
+            OP_CASE( 0xb1 ) // ADDS <Xd>, <Xn|SP>, #<imm>{, <shift>}   ;    CMN <Xn|SP>, #<imm>{, <shift>}
             {
                 uint64_t xregs = ( 0 != ( 0x80 & hi8 ) );
                 uint64_t imm12 = opbits( 10, 12 );
@@ -5258,14 +8001,14 @@ uint64_t Arm64::run( void )
                     regs[ d ] = result;
                 break;
             }
-            case 0x0b: // ADD <Wd|WSP>, <Wn|WSP>, <Wm>{, <extend> {#<amount>}}      ;    ADD <Wd>, <Wn>, <Wm>{, <shift> #<amount>}
-            case 0x2b: // ADDS <Wd>, <Wn|WSP>, <Wm>{, <extend> {#<amount>}}         ;    ADDS <Wd>, <Wn>, <Wm>{, <shift> #<amount>}
-            case 0x4b: // SUB <Wd|WSP>, <Wn|WSP>, <Wm>{, <extend> {#<amount>}}      ;    SUB <Wd>, <Wn>, <Wm>{, <shift> #<amount>}
-            case 0x6b: // SUBS <Wd>, <Wn|WSP>, <Wm>{, <extend> {#<amount>}}         ;    SUBS <Wd>, <Wn>, <Wm>{, <shift> #<amount>}
-            case 0x8b: // ADD <Xd|SP>, <Xn|SP>, <R><m>{, <extend> {#<amount>}}      ;    ADD <Xd>, <Xn>, <Xm>{, <shift> #<amount>}
-            case 0xab: // ADDS <Xd>, <Xn|SP>, <R><m>{, <extend> {#<amount>}}        ;    ADDS <Xd>, <Xn>, <Xm>{, <shift> #<amount>}
-            case 0xcb: // SUB <Xd|SP>, <Xn|SP>, <R><m>{, <extend> {#<amount>}}      ;    SUB <Xd>, <Xn>, <Xm>{, <shift> #<amount>}
-            case 0xeb: // SUBS <Xd>, <Xn|SP>, <R><m>{, <extend> {#<amount>}}        ;    SUBS <Xd>, <Xn>, <Xm>{, <shift> #<amount>}
+            OP_CASE( 0x0b ) // ADD <Wd|WSP>, <Wn|WSP>, <Wm>{, <extend> {#<amount>}}      ;    ADD <Wd>, <Wn>, <Wm>{, <shift> #<amount>}
+            OP_CASE( 0x2b ) // ADDS <Wd>, <Wn|WSP>, <Wm>{, <extend> {#<amount>}}         ;    ADDS <Wd>, <Wn>, <Wm>{, <shift> #<amount>}
+            OP_CASE( 0x4b ) // SUB <Wd|WSP>, <Wn|WSP>, <Wm>{, <extend> {#<amount>}}      ;    SUB <Wd>, <Wn>, <Wm>{, <shift> #<amount>}
+            OP_CASE( 0x6b ) // SUBS <Wd>, <Wn|WSP>, <Wm>{, <extend> {#<amount>}}         ;    SUBS <Wd>, <Wn>, <Wm>{, <shift> #<amount>}
+            OP_CASE( 0x8b ) // ADD <Xd|SP>, <Xn|SP>, <R><m>{, <extend> {#<amount>}}      ;    ADD <Xd>, <Xn>, <Xm>{, <shift> #<amount>}
+            OP_CASE( 0xab ) // ADDS <Xd>, <Xn|SP>, <R><m>{, <extend> {#<amount>}}        ;    ADDS <Xd>, <Xn>, <Xm>{, <shift> #<amount>}
+            OP_CASE( 0xcb ) // SUB <Xd|SP>, <Xn|SP>, <R><m>{, <extend> {#<amount>}}      ;    SUB <Xd>, <Xn>, <Xm>{, <shift> #<amount>}
+            OP_CASE( 0xeb ) // SUBS <Xd>, <Xn|SP>, <R><m>{, <extend> {#<amount>}}        ;    SUBS <Xd>, <Xn>, <Xm>{, <shift> #<amount>}
             {
                 uint64_t extended = opbit( 21 );
                 uint64_t issub = ( 0 != ( 0x40 & hi8 ) );
@@ -5315,7 +8058,7 @@ uint64_t Arm64::run( void )
                     regs[ d ] = result;
                 break;
             }
-            case 0x94: case 0x95: case 0x96: case 0x97: // bl offset. The lower 2 bits of this are the high part of the offset
+            OP_CASE( 0x94 ) OP_CASE( 0x95 ) OP_CASE( 0x96 ) OP_CASE( 0x97 ) // bl offset. The lower 2 bits of this are the high part of the offset
             {
                 int64_t offset = ( opbits( 0, 26 ) << 2 );
                 offset = sign_extend( offset, 27 );
@@ -5324,10 +8067,10 @@ uint64_t Arm64::run( void )
                 //trace_vregs();
                 continue;
             }
-            case 0x11: // add <wd|SP>, <wn|SP>, #imm [,<shift>]
-            case 0x51: // sub <wd|SP>, <wn|SP>, #imm [,<shift>]
-            case 0x91: // add <xd|SP>, <xn|SP>, #imm [,<shift>]
-            case 0xd1: // sub <xd|SP>, <xn|SP>, #imm [,<shift>]
+            OP_CASE( 0x11 ) // add <wd|SP>, <wn|SP>, #imm [,<shift>]
+            OP_CASE( 0x51 ) // sub <wd|SP>, <wn|SP>, #imm [,<shift>]
+            OP_CASE( 0x91 ) // add <xd|SP>, <xn|SP>, #imm [,<shift>]
+            OP_CASE( 0xd1 ) // sub <xd|SP>, <xn|SP>, #imm [,<shift>]
             {
                 bool sf = ( 0 != opbit( 31 ) );
                 bool sh = ( 0 != opbit( 22 ) );
@@ -5354,14 +8097,14 @@ uint64_t Arm64::run( void )
                 regs[ d ] = result;
                 break;
             }
-            case 0x28: // ldp/stp 32 post index                   STP <Wt1>, <Wt2>, [<Xn|SP>], #<imm>     ;    LDP <Wt1>, <Wt2>, [<Xn|SP>], #<imm>
-            case 0xa8: // ldp/stp 64 post-index                   STP <Xt1>, <Xt2>, [<Xn|SP>], #<imm>     ;    LDP <Xt1>, <Xt2>, [<Xn|SP>], #<imm>
-            case 0x29: // ldp/stp 32 pre-index and signed offset: STP <Wt1>, <Wt2>, [<Xn|SP>, #<imm>]!    ;    STP <Wt1>, <Wt2>, [<Xn|SP>{, #<imm>}]
+            OP_CASE( 0x28 ) // ldp/stp 32 post index                   STP <Wt1>, <Wt2>, [<Xn|SP>], #<imm>     ;    LDP <Wt1>, <Wt2>, [<Xn|SP>], #<imm>
+            OP_CASE( 0xa8 ) // ldp/stp 64 post-index                   STP <Xt1>, <Xt2>, [<Xn|SP>], #<imm>     ;    LDP <Xt1>, <Xt2>, [<Xn|SP>], #<imm>
+            OP_CASE( 0x29 ) // ldp/stp 32 pre-index and signed offset: STP <Wt1>, <Wt2>, [<Xn|SP>, #<imm>]!    ;    STP <Wt1>, <Wt2>, [<Xn|SP>{, #<imm>}]
                        //                                         LDP <Wt1>, <Wt2>, [<Xn|SP>, #<imm>]!    ;    LDP <Wt1>, <Wt2>, [<Xn|SP>{, #<imm>}]
-            case 0xa9: // ldp/stp 64 pre-index and signed offset: STP <Xt1>, <Xt2>, [<Xn|SP>, #<imm>]!    ;    STP <Xt1>, <Xt2>, [<Xn|SP>{, #<imm>}]
+            OP_CASE( 0xa9 ) // ldp/stp 64 pre-index and signed offset: STP <Xt1>, <Xt2>, [<Xn|SP>, #<imm>]!    ;    STP <Xt1>, <Xt2>, [<Xn|SP>{, #<imm>}]
                        //                                         LDP <Xt1>, <Xt2>, [<Xn|SP>, #<imm>]!    ;    LDP <Xt1>, <Xt2>, [<Xn|SP>{, #<imm>}]
-            case 0x68: // ldp 32-bit sign extended                LDPSW <Xt1>, <Xt2>, [<Xn|SP>], #<imm>
-            case 0x69: // ldp 32-bit sign extended                LDPSW <Xt1>, <Xt2>, [<Xn|SP>, #<imm>]!  ;    LDPSW <Xt1>, <Xt2>, [<Xn|SP>{, #<imm>}]
+            OP_CASE( 0x68 ) // ldp 32-bit sign extended                LDPSW <Xt1>, <Xt2>, [<Xn|SP>], #<imm>
+            OP_CASE( 0x69 ) // ldp 32-bit sign extended                LDPSW <Xt1>, <Xt2>, [<Xn|SP>, #<imm>]!  ;    LDPSW <Xt1>, <Xt2>, [<Xn|SP>{, #<imm>}]
             {
                 bool xregs = ( 0 != opbit( 31 ) );
                 uint64_t t1 = opbits( 0, 5 );
@@ -5434,8 +8177,8 @@ uint64_t Arm64::run( void )
                     regs[ n ] = address;
                 break;
             }
-            case 0x32: // ORR <Wd|WSP>, <Wn>, #<imm>
-            case 0xb2: // ORR <Xd|SP>, <Xn>, #<imm>
+            OP_CASE( 0x32 ) // ORR <Wd|WSP>, <Wn>, #<imm>
+            OP_CASE( 0xb2 ) // ORR <Xd|SP>, <Xn>, #<imm>
             {
                 uint64_t xregs = ( 0 != ( 0x80 & hi8 ) );
                 uint64_t N_immr_imms = opbits( 10, 13 );
@@ -5449,10 +8192,10 @@ uint64_t Arm64::run( void )
                     regs[ d ] = (uint32_t) regs[ d ];
                 break;
             }
-            case 0x4a: // EOR <Wd>, <Wn>, <Wm>{, <shift> #<amount>}    ;    EON <Wd>, <Wn>, <Wm>{, <shift> #<amount>}
-            case 0xca: // EOR <Xd>, <Xn>, <Xm>{, <shift> #<amount>}    ;    EON <Xd>, <Xn>, <Xm>{, <shift> #<amount>}
-            case 0x2a: // ORR <Wd>, <Wn>, <Wm>{, <shift> #<amount>}    ;    ORN <Wd>, <Wn>, <Wm>{, <shift> #<amount>}
-            case 0xaa: // ORR <Xd>, <Xn>, <Xm>{, <shift> #<amount>}    ;    ORN <Xd>, <Xn>, <Xm>{, <shift> #<amount>}
+            OP_CASE( 0x4a ) // EOR <Wd>, <Wn>, <Wm>{, <shift> #<amount>}    ;    EON <Wd>, <Wn>, <Wm>{, <shift> #<amount>}
+            OP_CASE( 0xca ) // EOR <Xd>, <Xn>, <Xm>{, <shift> #<amount>}    ;    EON <Xd>, <Xn>, <Xm>{, <shift> #<amount>}
+            OP_CASE( 0x2a ) // ORR <Wd>, <Wn>, <Wm>{, <shift> #<amount>}    ;    ORN <Wd>, <Wn>, <Wm>{, <shift> #<amount>}
+            OP_CASE( 0xaa ) // ORR <Xd>, <Xn>, <Xm>{, <shift> #<amount>}    ;    ORN <Xd>, <Xn>, <Xm>{, <shift> #<amount>}
             {
                 uint64_t shift = opbits( 22, 2 );
                 uint64_t N = opbit( 21 );
@@ -5490,12 +8233,12 @@ uint64_t Arm64::run( void )
                     regs[ d ] = (uint32_t) regs[ d ];
                 break;
             }
-            case 0x33: // BFM <Wd>, <Wn>, #<immr>, #<imms>       // original bits intact
-            case 0xb3: // BFM <Xd>, <Xn>, #<immr>, #<imms>
-            case 0x13: // SBFM <Wd>, <Wn>, #<immr>, #<imms>    ;    EXTR <Wd>, <Wn>, <Wm>, #<lsb>
-            case 0x93: // SBFM <Xd>, <Xn>, #<immr>, #<imms>    ;    EXTR <Xd>, <Xn>, <Xm>, #<lsb>
-            case 0x53: // UBFM <Wd>, <Wn>, #<immr>, #<imms>      // unmodified bits set to 0
-            case 0xd3: // UBFM <Xd>, <Xn>, #<immr>, #<imms>
+            OP_CASE( 0x33 ) // BFM <Wd>, <Wn>, #<immr>, #<imms>       // original bits intact
+            OP_CASE( 0xb3 ) // BFM <Xd>, <Xn>, #<immr>, #<imms>
+            OP_CASE( 0x13 ) // SBFM <Wd>, <Wn>, #<immr>, #<imms>    ;    EXTR <Wd>, <Wn>, <Wm>, #<lsb>
+            OP_CASE( 0x93 ) // SBFM <Xd>, <Xn>, #<immr>, #<imms>    ;    EXTR <Xd>, <Xn>, <Xm>, #<lsb>
+            OP_CASE( 0x53 ) // UBFM <Wd>, <Wn>, #<immr>, #<imms>      // unmodified bits set to 0
+            OP_CASE( 0xd3 ) // UBFM <Xd>, <Xn>, #<immr>, #<imms>
             {
                 uint64_t imms = opbits( 10, 6 );
                 uint64_t n = opbits( 5, 5 );
@@ -5561,10 +8304,10 @@ uint64_t Arm64::run( void )
                 }
                 break;
             }
-            case 0x0a: // AND <Wd>, <Wn>, <Wm>{, <shift> #<amount>}     ;    BIC <Wd>, <Wn>, <Wm>{, <shift> #<amount>}
-            case 0x6a: // ANDS <Wd>, <Wn>, <Wm>{, <shift> #<amount>}    ;    BICS <Wd>, <Wn>, <Wm>{, <shift> #<amount>}
-            case 0x8a: // AND <Xd>, <Xn>, <Xm>{, <shift> #<amount>}     ;    BIC <Xd>, <Xn>, <Xm>{, <shift> #<amount>}
-            case 0xea: // ANDS <Xd>, <Xn>, <Xm>{, <shift> #<amount>}    ;    BICS <Xd>, <Xn>, <Xm>{, <shift> #<amount>}
+            OP_CASE( 0x0a ) // AND <Wd>, <Wn>, <Wm>{, <shift> #<amount>}     ;    BIC <Wd>, <Wn>, <Wm>{, <shift> #<amount>}
+            OP_CASE( 0x6a ) // ANDS <Wd>, <Wn>, <Wm>{, <shift> #<amount>}    ;    BICS <Wd>, <Wn>, <Wm>{, <shift> #<amount>}
+            OP_CASE( 0x8a ) // AND <Xd>, <Xn>, <Xm>{, <shift> #<amount>}     ;    BIC <Xd>, <Xn>, <Xm>{, <shift> #<amount>}
+            OP_CASE( 0xea ) // ANDS <Xd>, <Xn>, <Xm>{, <shift> #<amount>}    ;    BICS <Xd>, <Xn>, <Xm>{, <shift> #<amount>}
             {
                 uint64_t shift = opbits( 22, 2 );
                 uint64_t N = opbit( 21 ); // BICS -- complement
@@ -5593,6 +8336,7 @@ uint64_t Arm64::run( void )
 
                 if ( set_flags )
                 {
+                    lazy_kind = lazy_none;
                     fZ = ( 0 == result );
                     fV = fC = false;
                     fN = xregs ? get_bit( result, 63 ) : get_bit( result, 31 );
@@ -5602,8 +8346,8 @@ uint64_t Arm64::run( void )
                     regs[ d ] = result;
                 break;
             }
-            case 0x10: case 0x30: case 0x50: case 0x70: // ADR <Xd>, <label>
-            case 0x90: case 0xb0: case 0xd0: case 0xf0: // ADRP <Xd>, <label>
+            OP_CASE( 0x10 ) OP_CASE( 0x30 ) OP_CASE( 0x50 ) OP_CASE( 0x70 ) // ADR <Xd>, <label>
+            OP_CASE( 0x90 ) OP_CASE( 0xb0 ) OP_CASE( 0xd0 ) OP_CASE( 0xf0 ) // ADRP <Xd>, <label>
             {
                 uint64_t d = opbits( 0, 5 );
                 if ( 31 == d )
@@ -5621,8 +8365,8 @@ uint64_t Arm64::run( void )
                 regs[ d ] = imm;
                 break;
             }
-            case 0x52: // MOVZ <Wd>, #<imm>{, LSL #<shift>}    ;    EOR <Wd|WSP>, <Wn>, #<imm>
-            case 0xd2: // MOVZ <Xd>, #<imm>{, LSL #<shift>}    ;    EOR <Xd|SP>, <Xn>, #<imm>
+            OP_CASE( 0x52 ) // MOVZ <Wd>, #<imm>{, LSL #<shift>}    ;    EOR <Wd|WSP>, <Wn>, #<imm>
+            OP_CASE( 0xd2 ) // MOVZ <Xd>, #<imm>{, LSL #<shift>}    ;    EOR <Xd|SP>, <Xn>, #<imm>
             {
                 bool xregs = ( 0 != ( hi8 & 0x80 ) );
                 uint64_t d = opbits( 0, 5 );
@@ -5648,10 +8392,10 @@ uint64_t Arm64::run( void )
                 }
                 break;
             }
-            case 0x36: // TBZ <R><t>, #<imm>, <label>
-            case 0x37: // TBNZ <R><t>, #<imm>, <label>
-            case 0xb6: // TBZ <R><t>, #<imm>, <label> where high bit is prepended to b40 bit selector for 6 bits total
-            case 0xb7: // TBNZ <R><t>, #<imm>, <label> where high bit is prepended to b40 bit selector for 6 bits total
+            OP_CASE( 0x36 ) // TBZ <R><t>, #<imm>, <label>
+            OP_CASE( 0x37 ) // TBNZ <R><t>, #<imm>, <label>
+            OP_CASE( 0xb6 ) // TBZ <R><t>, #<imm>, <label> where high bit is prepended to b40 bit selector for 6 bits total
+            OP_CASE( 0xb7 ) // TBNZ <R><t>, #<imm>, <label> where high bit is prepended to b40 bit selector for 6 bits total
             {
                 uint64_t b40 = opbits( 19, 5 );
                 if ( 0 != ( 0x80 & hi8 ) )
@@ -5668,8 +8412,8 @@ uint64_t Arm64::run( void )
                 }
                 break;
             }
-            case 0x12: // MOVN <Wd>, #<imm>{, LSL #<shift>}   ;    AND <Wd|WSP>, <Wn>, #<imm>
-            case 0x92: // MOVN <Xd>, #<imm16>, LSL #<shift>   ;    AND <Xd|SP>, <Xn>, #<imm>    ;    MOV <Xd>, #<imm>
+            OP_CASE( 0x12 ) // MOVN <Wd>, #<imm>{, LSL #<shift>}   ;    AND <Wd|WSP>, <Wn>, #<imm>
+            OP_CASE( 0x92 ) // MOVN <Xd>, #<imm16>, LSL #<shift>   ;    AND <Xd|SP>, <Xn>, #<imm>    ;    MOV <Xd>, #<imm>
             {
                 uint64_t d = opbits( 0, 5 );
                 uint64_t bit23 = opbit( 23 );
@@ -5704,10 +8448,10 @@ uint64_t Arm64::run( void )
                 }
                 break;
             }
-            case 0x34: // CBZ <Wt>, <label>
-            case 0x35: // CBNZ <Wt>, <label>
-            case 0xb4: // CBZ <Xt>, <label>
-            case 0xb5: // CBNZ <Xt>, <label>
+            OP_CASE( 0x34 ) // CBZ <Wt>, <label>
+            OP_CASE( 0x35 ) // CBNZ <Wt>, <label>
+            OP_CASE( 0xb4 ) // CBZ <Xt>, <label>
+            OP_CASE( 0xb5 ) // CBNZ <Xt>, <label>
             {
                 uint64_t t = opbits( 0, 5 );
                 uint64_t val = val_reg_or_zr( t );
@@ -5724,7 +8468,7 @@ uint64_t Arm64::run( void )
                 }
                 break;
             }
-            case 0xd4: // SVC
+            OP_CASE( 0xd4 ) // SVC
             {
                 uint64_t bit23 = opbit( 23 );
                 uint64_t hw = opbits( 21, 2 );
@@ -5742,7 +8486,7 @@ uint64_t Arm64::run( void )
                     unhandled();
                 break;
             }
-            case 0xd5: // MSR / MRS
+            OP_CASE( 0xd5 ) // MSR / MRS
             {
                 uint64_t bits2322 = opbits( 22, 2 );
                 if ( 0 != bits2322 )
@@ -5753,8 +8497,20 @@ uint64_t Arm64::run( void )
 
                 uint64_t upper20 = opbits( 12, 20 );
                 uint64_t lower8 = opbits( 0, 8 );
-                if ( ( 0xd5033 == upper20 ) && ( 0xbf == lower8 ) ) // dmb -- no memory barries are needed due to just one thread and core
+                if ( ( 0xd5033 == upper20 ) && ( 0xbf == lower8 || 0x9f == lower8 ) ) // dmb, dsb. guest threads may be on different host cores
+                {
+                    atomic_thread_fence( memory_order_seq_cst );
+                    break;
+                }
+
+                if ( ( 0xd5033 == upper20 ) && ( 0xdf == lower8 ) ) // isb. predecoded instructions are dropped by ic ivau
+                    break;
+
+                if ( ( 0xd5033 == upper20 ) && ( 0x5f == lower8 ) ) // clrex
+                {
+                    exclusive_size = 0;
                     break;
+                }
 
                 uint64_t l = opbit( 21 );
                 uint64_t op0 = opbits( 19, 2 );
@@ -5767,22 +8523,38 @@ uint64_t Arm64::run( void )
                 if ( l ) // MRS <Xt>, (<systemreg>|S<op0>_<op1>_<Cn>_<Cm>_<op2>).   read system register
                 {
                     if ( ( 3 == op0 ) && ( 14 == n ) && ( 3 == op1 ) && ( 0 == m ) && ( 2 == op2 ) ) // cntvct_el0 counter-timer virtual count register
-                    {
-                        system_clock::duration d = system_clock::now().time_since_epoch();
-                        regs[ t ] = duration_cast<nanoseconds>( d ).count();
-                    }
+                        regs[ t ] = counter_ticks();
                     else if ( ( 3 == op0 ) && ( 14 == n ) && ( 3 == op1 ) && ( 0 == m ) && ( 0 == op2 ) ) // cntfrq_el0 counter-timer frequency register
                         regs[ t ] = 1000000000; // nanoseconds = billionths of a second
+                    else if ( ( 3 == op0 ) && ( 15 == n ) && ( 3 == op1 ) && ( 0 == m ) ) // S3_3_C15_C0_<clock>. see is_clock_read()
+                        regs[ t ] = emulator_clock( (uint32_t) op2 );
+                    else if ( ( 3 == op0 ) && ( 9 == n ) && ( 3 == op1 ) && ( 13 == m ) && ( 0 == op2 ) ) // PMCCNTR_EL0. instructions retired by this cpu
+                        regs[ t ] = cycles; // system instructions end blocks, so this counts every instruction through the mrs
+                    else if ( ( 3 == op0 ) && ( 14 == n ) && ( 3 == op1 ) && ( m >= 8 ) && ( m <= 11 ) ) // PMEVCNTR<n>_EL0
+                        regs[ t ] = emulator_counter( (uint32_t) ( ( ( m & 3 ) << 3 ) | op2 ) );
+                    else if ( ( 3 == op0 ) && ( 0 == n ) && ( 3 == op1 ) && ( 0 == m ) && ( 1 == op2 ) ) // CTR_EL0. cache type register used by __clear_cache
+                        regs[ t ] = 0x8444c004; // 64-byte i and d cache lines
                     else if ( ( 3 == op0 ) && ( 0 == n ) && ( 3 == op1 ) && ( 0 == m ) && ( 7 == op2 ) ) // DCZID_EL0. data cache block size for dc zva instruction
                         regs[ t ] = 4; // doesn't matter becasuse there is no caching in the emulator
                     else if ( ( 3 == op0 ) && ( 0 == n ) && ( 0 == op1 ) && ( 0 == m ) && ( 0 == op2 ) ) // mrs x, midr_el1
                         regs[ t ] = 0x595a5449; // ITZY don't you know you have a superpower? // my dev machine: 0x410fd4c0;
+                    else if ( ( 3 == op0 ) && ( 0 == n ) && ( 0 == op1 ) && ( 6 == m ) && ( 0 == op2 ) ) // ID_AA64ISAR0_EL1
+                        regs[ t ] = g_id_aa64isar0; // linux lets apps read the ID registers and emulates them for el0
+                    else if ( ( 3 == op0 ) && ( 0 == n ) && ( 0 == op1 ) && ( 4 == m ) && ( 0 == op2 ) ) // ID_AA64PFR0_EL1
+                        regs[ t ] = 0x11; // el0 and el1 are aarch64. fp and advsimd are implemented
+                    else if ( ( 3 == op0 ) && ( 0 == n ) && ( 0 == op1 ) && ( m >= 4 ) && ( m <= 7 ) ) // the other ID_AA64*_EL1
+                        regs[ t ] = 0;
                     else if ( ( 3 == op0 ) && ( 13 == n ) && ( 3 == op1 ) && ( 0 == m ) && ( 2 == op2 ) ) // software thread id
                         regs[ t ] = tpidr_el0;
                     else if ( ( 3 == op0 ) && ( 4 == n ) && ( 3 == op1 ) && ( 4 == m ) && ( 0 == op2 ) ) // mrs x, fpcr
                         regs[ t ] = fpcr;
                     else if ( ( 3 == op0 ) && ( 4 == n ) && ( 3 == op1 ) && ( 4 == m ) && ( 1 == op2 ) ) // mrs x, fpsr
                         regs[ t ] = 0;
+                    else if ( ( 3 == op0 ) && ( 4 == n ) && ( 3 == op1 ) && ( 2 == m ) && ( 0 == op2 ) ) // mrs x, nzcv
+                    {
+                        materialize_flags();
+                        regs[ t ] = ( (uint64_t) fN << 31 ) | ( (uint64_t) fZ << 30 ) | ( (uint64_t) fC << 29 ) | ( (uint64_t) fV << 28 );
+                    }
                     else
                         unhandled();
                 }
@@ -5795,11 +8567,23 @@ uint64_t Arm64::run( void )
                         // branch target identification (ignore)
                     }
                     else if ( ( 1 == op0 ) && ( 7 == n ) && ( 3 == op1 ) && ( 4 == m ) && ( 1 == op2 ) )
+                    {
+                        invalidate_code( regs[ t ], 4 * 32 );
+                        track( regs[ t ], 4 * 32, true );
                         memset( getmem( regs[ t ] ), 0, 4 * 32 ); // dc zva <Xt>
+                    }
+                    else if ( ( 1 == op0 ) && ( 7 == n ) && ( 3 == op1 ) && ( 5 == m ) && ( 1 == op2 ) ) // ic ivau <Xt>
+                        invalidate_code( regs[ t ] & ~63ull, 64 );
+                    else if ( ( 1 == op0 ) && ( 7 == n ) && ( 3 == op1 ) && ( 10 == m || 11 == m || 14 == m ) && ( 1 == op2 ) )
+                    {
+                        // dc cvac, dc cvau, dc civac. there is no data cache to clean
+                    }
                     else if ( ( 0 == op0 ) && ( 2 == n ) && ( 3 == op1 ) && ( 0 == m ) && ( 7 == op2 ) ) // xpaclri
                     {
                         // do nothing
                     }
+                    else if ( ( 3 == op0 ) && ( 4 == n ) && ( 3 == op1 ) && ( 2 == m ) && ( 0 == op2 ) ) // msr nzcv, xt
+                        set_flags_from_nzcv( regs[ t ] >> 28 );
                     else if ( ( 3 == op0 ) && ( 4 == n ) && ( 3 == op1 ) && ( 4 == m ) && ( 0 == op2 ) ) // msr fpcr, xt
                     {
                         // If FPCR.AH (bit 1) is 1, then the following instructions use Round to Nearest mode regardless of the value of this bit:
@@ -5810,14 +8594,17 @@ uint64_t Arm64::run( void )
                         //   01 = round towards plus infinity RP
                         //   10 = round towards minus infinity RM
                         //   11 = round towards zero RZ
+                        bool rounding_changed = ( get_bits( fpcr, 22, 2 ) != get_bits( regs[ t ], 22, 2 ) );
                         fpcr = regs[ t ];
+                        if ( rounding_changed )
+                            set_host_rounding( fpcr );
                     }
                     else
                         unhandled();
                 }
                 break;
             }
-            case 0x2e: case 0x6e: // CMEQ <Vd>.<T>, <Vn>.<T>, <Vm>.<T>    ;    CMHS <Vd>.<T>, <Vn>.<T>, <Vm>.<T>    ;    UMAXP <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+            OP_CASE( 0x2e ) OP_CASE( 0x6e ) // CMEQ <Vd>.<T>, <Vn>.<T>, <Vm>.<T>    ;    CMHS <Vd>.<T>, <Vn>.<T>, <Vm>.<T>    ;    UMAXP <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
                                   // BIT <Vd>.<T>, <Vn>.<T>, <Vm>.<T>     ;    UMINP <Vd>.<T>, <Vn>.<T>, <Vm>.<T>   ;    BIF <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
                                   // EOR <Vd>.<T>, <Vn>.<T>, <Vm>.<T>     ;    SUB <Vd>.<T>, <Vn>.<T>, <Vm>.<T>     ;    UMULL{2} <Vd>.<Ta>, <Vn>.<Tb>, <Vm>.<Tb>
                                   // MLS <Vd>.<T>, <Vn>.<T>, <Vm>.<Ts>[<index>] ;  BSL <Vd>.<T>, <Vn>.<T>, <Vm>.<T> ;    FMUL <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
@@ -6278,7 +9065,9 @@ uint64_t Arm64::run( void )
                         else
                             unhandled(); // no 8-byte variant exists
 
-                        for ( uint64_t e = 1; e < elements; e++ )
+                        bool host_simd = ( 1 == ebytes ) && vec_minmaxv8( cur_ui8, vregs[ n ], Q, ( 0x6a == bits16_10 ) );
+
+                        for ( uint64_t e = 1; !host_simd && ( e < elements ); e++ )
                         {
                             if ( 1 == ebytes )
                             {
@@ -6464,7 +9253,11 @@ uint64_t Arm64::run( void )
                         bool is_min = ( 0x2b == opcode );
                         vec16_t & nref = vregs[ n ];
                         vec16_t & mref = vregs[ m ];
-                        if ( 1 == ebytes )
+                        if ( ( 1 == ebytes ) && vec_minmaxp8( target, nref, mref, Q, is_min ) )
+                        {
+                            // handled with host simd
+                        }
+                        else if ( 1 == ebytes )
                         {
                             for ( uint64_t e = 0; e < elements; e += 2 )
                             {
@@ -6563,18 +9356,21 @@ uint64_t Arm64::run( void )
                         {
                             vec16_t & nreg = vregs[ n ];
                             vec16_t & mreg = vregs[ m ];
-                            for ( uint64_t e = 0; e < elements; e++ )
+                            if ( !vec_add( target, nreg, mreg, ebytes, Q, true ) )
                             {
-                                if ( 1 == ebytes )
-                                    target.set8( e, nreg.get8( e ) - mreg.get8( e ) );
-                                else if ( 2 == ebytes )
-                                    target.set16( e, nreg.get16( e ) - mreg.get16( e ) );
-                                else if ( 4 == ebytes )
-                                    target.set32( e, nreg.get32( e ) - mreg.get32( e ) );
-                                else if ( 8 == ebytes )
-                                    target.set64( e, nreg.get64( e ) - mreg.get64( e ) );
-                                else
-                                    unhandled();
+                                for ( uint64_t e = 0; e < elements; e++ )
+                                {
+                                    if ( 1 == ebytes )
+                                        target.set8( e, nreg.get8( e ) - mreg.get8( e ) );
+                                    else if ( 2 == ebytes )
+                                        target.set16( e, nreg.get16( e ) - mreg.get16( e ) );
+                                    else if ( 4 == ebytes )
+                                        target.set32( e, nreg.get32( e ) - mreg.get32( e ) );
+                                    else if ( 8 == ebytes )
+                                        target.set64( e, nreg.get64( e ) - mreg.get64( e ) );
+                                    else
+                                        unhandled();
+                                }
                             }
                         }
                         else if ( 0x30 == opcode ) // UMULL{2} <Vd>.<Ta>, <Vn>.<Tb>, <Vm>.<Tb>
@@ -6616,19 +9412,23 @@ uint64_t Arm64::run( void )
                         }
                         else if ( 0x23 == opcode || 0x0d == opcode || 0x0f == opcode ) // vector comparisons
                         {
-                            for ( uint64_t e = 0; e < elements; e++ )
+                            VectorCompare kind = ( 0x23 == opcode ) ? vc_eq : ( 0x0d == opcode ) ? vc_hi : vc_hs;
+                            if ( !vec_compare( target, vregs[ n ], vregs[ m ], ebytes, Q, kind ) )
                             {
-                                uint64_t offset = ( e * ebytes );
-                                ElementComparisonResult res = compare_vector_elements( vreg_ptr( n, offset ), vreg_ptr( m, offset ), ebytes, true );
-                                bool copy_ones = ( ( 0x23 == opcode && ecr_eq == res ) ||                          // CMEQ <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-                                                   ( 0x0d == opcode && ecr_gt == res ) ||                          // CMHI <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-                                                   ( 0x0f == opcode && ( ecr_gt == res || ecr_eq == res ) ) );     // CMHS <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
-
-                                assert( ( offset + ebytes ) <= sizeof( target ) );
-                                if ( copy_ones )
-                                    mcpy( ptarget + offset, &vec_ones, ebytes );
-                                else
-                                    mcpy( ptarget + offset, &vec_zeroes, ebytes );
+                                for ( uint64_t e = 0; e < elements; e++ )
+                                {
+                                    uint64_t offset = ( e * ebytes );
+                                    ElementComparisonResult res = compare_vector_elements( vreg_ptr( n, offset ), vreg_ptr( m, offset ), ebytes, true );
+                                    bool copy_ones = ( ( 0x23 == opcode && ecr_eq == res ) ||                          // CMEQ <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+                                                       ( 0x0d == opcode && ecr_gt == res ) ||                          // CMHI <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+                                                       ( 0x0f == opcode && ( ecr_gt == res || ecr_eq == res ) ) );     // CMHS <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
+
+                                    assert( ( offset + ebytes ) <= sizeof( target ) );
+                                    if ( copy_ones )
+                                        mcpy( ptarget + offset, &vec_ones, ebytes );
+                                    else
+                                        mcpy( ptarget + offset, &vec_zeroes, ebytes );
+                                }
                             }
                         }
                         else
@@ -6708,10 +9508,11 @@ uint64_t Arm64::run( void )
                     else
                        unhandled();
                 }
-                trace_vregs();
+                if ( stepping )
+                    trace_vregs();
                 break;
             }
-            case 0x5e: // SCVTF <V><d>, <V><n>    ;    ADDP D<d>, <Vn>.2D    ;    DUP <V><d>, <Vn>.<T>[<index>]    ;    FCVTZS <V><d>, <V><n>
+            OP_CASE( 0x5e ) // SCVTF <V><d>, <V><n>    ;    ADDP D<d>, <Vn>.2D    ;    DUP <V><d>, <Vn>.<T>[<index>]    ;    FCVTZS <V><d>, <V><n>
                        // CMGT D<d>, D<n>, D<m>   ;    CMGT D<d>, D<n>, #0   ;    ADD D<d>, D<n>, D<m>             ;    FCMLT <V><d>, <V><n>, #0.0
                        // CMEQ D<d>, D<n>, #0
             {
@@ -6724,7 +9525,34 @@ uint64_t Arm64::run( void )
                 uint64_t n = opbits( 5, 5 );
                 uint64_t d = opbits( 0, 5 );
 
-                if ( 7 == bits23_21 && 0 == bits20_16 && 0x26 == bits15_10 ) // CMEQ D<d>, D<n>, #0
+                if ( 0x5e000000 == ( op & 0xffe08c00 ) ) // SHA1C/SHA1P/SHA1M/SHA256H/SHA256H2 <Qd>, <Qn|Sn>, <Vm>.4S    ;    SHA1SU0/SHA256SU1 <Vd>.4S, <Vn>.4S, <Vm>.4S
+                {
+                    uint64_t m = opbits( 16, 5 );
+                    uint64_t opc = opbits( 12, 3 );
+                    if ( opc <= 2 )
+                        sha1_hash( vregs[ d ], vregs[ n ].get32( 0 ), vregs[ m ], (uint32_t) opc );
+                    else if ( 4 == opc || 5 == opc )
+                        sha256_hash( vregs[ d ], vregs[ n ], vregs[ m ], 4 == opc );
+                    else if ( 3 == opc || 6 == opc )
+                        sha_schedule( vregs[ d ], vregs[ n ], vregs[ m ], ( 3 == opc ) ? 0 : 3 );
+                    else
+                        unhandled();
+                }
+                else if ( 0x5e280800 == ( op & 0xffffcc00 ) ) // SHA1H <Sd>, <Sn>    ;    SHA1SU1 <Vd>.4S, <Vn>.4S    ;    SHA256SU0 <Vd>.4S, <Vn>.4S
+                {
+                    uint64_t opc = opbits( 12, 2 );
+                    if ( 0 == opc )
+                    {
+                        uint32_t e = vregs[ n ].get32( 0 );
+                        vregs[ d ].zero();
+                        vregs[ d ].set32( 0, ( e << 30 ) | ( e >> 2 ) );
+                    }
+                    else if ( opc <= 2 )
+                        sha_schedule( vregs[ d ], vregs[ n ], vregs[ n ], (uint32_t) opc );
+                    else
+                        unhandled();
+                }
+                else if ( 7 == bits23_21 && 0 == bits20_16 && 0x26 == bits15_10 ) // CMEQ D<d>, D<n>, #0
                 {
                     vregs[ d ].set64( 0, ( 0 == vregs[ n ].get64( 0 ) ) ? ~0 : 0 );
                 }
@@ -6735,20 +9563,23 @@ uint64_t Arm64::run( void )
                         vregs[ d ].set64( 0, ( vregs[ n ].getd( 0 ) < 0.0 ) ? ~0 : 0 );
                     else
                         vregs[ d ].set32( 0, ( vregs[ n ].getf( 0 ) < 0.0 ) ? ~0 : 0 );
-                    trace_vregs();
+                    if ( stepping )
+                        trace_vregs();
                 }
                 else if ( 7 == bits23_21 && 0x21 == bits15_10 ) // ADD D<d>, D<n>, D<m>
                 {
                     uint64_t m = opbits( 16, 5 );
                     vregs[ d ].set64( 0, vregs[ n ].get64( 0 ) + vregs[ m ].get64( 0 ) );
                     vregs[ d ].set64( 1, 0 );
-                    trace_vregs();
+                    if ( stepping )
+                        trace_vregs();
                 }
                 else if ( 7 == bits23_21 && 0xd == bits15_10 ) // CMGT D<d>, D<n>, D<m>
                 {
                     uint64_t m = opbits( 16, 5 );
                     vregs[ d ].set64( 0, ( (int64_t) vregs[ n ].get64( 0 ) > (int64_t) vregs[ m ].get64( 0 ) ) ? ~0 : 0 );
-                    trace_vregs();
+                    if ( stepping )
+                        trace_vregs();
                 }
                 else if ( 0x386e == bits23_10 || 0x286e == bits23_10 ) // FCVTZS <V><d>, <V><n>. round towards zero fp to signed integer
                 {
@@ -6765,7 +9596,8 @@ uint64_t Arm64::run( void )
                         zero_vreg( d );
                         vregs[ d ].set32( 0, nval );
                     }
-                    trace_vregs();
+                    if ( stepping )
+                        trace_vregs();
                 }
                 else if ( 0x0876 == ( bits23_10 & 0x2fff ) ) // SCVTF <Vd>.<T>, <Vn>.<T>
                 {
@@ -6774,13 +9606,15 @@ uint64_t Arm64::run( void )
                         vregs[ d ].setd( 0, (double) (int64_t) vregs[ n ].get64( 0 ) );
                     else
                         vregs[ d ].setf( 0, (float) (int32_t) vregs[ n ].get32( 0 ) );
-                    trace_vregs();
+                    if ( stepping )
+                        trace_vregs();
                 }
                 else if ( 0x3c6e == bits23_10 ) // ADDP D<d>, <Vn>.2D
                 {
                     vregs[ d ].set64( 0, vregs[ n ].get64( 0 ) + vregs[ n ].get64( 1 ) );
                     vregs[ d ].set64( 1, 0 );
-                    trace_vregs();
+                    if ( stepping )
+                        trace_vregs();
                 }
                 else if ( 1 == ( bits23_10 & 0x383f ) ) // DUP <V><d>, <Vn>.<T>[<index>]   -- scalar
                 {
@@ -6801,13 +9635,14 @@ uint64_t Arm64::run( void )
                         target.set64( 0, vregs[ n ].get64( index ) );
 
                     vregs[ d ] = target;
-                    trace_vregs();
+                    if ( stepping )
+                        trace_vregs();
                 }
                 else
                     unhandled();
                 break;
             }
-            case 0x7e: // CMGE    ;    UCVTF <V><d>, <V><n>    ;    UCVTF <Hd>, <Hn>            ;    FADDP <V><d>, <Vn>.<T>    ;    FABD <V><d>, <V><n>, <V><m>
+            OP_CASE( 0x7e ) // CMGE    ;    UCVTF <V><d>, <V><n>    ;    UCVTF <Hd>, <Hn>            ;    FADDP <V><d>, <Vn>.<T>    ;    FABD <V><d>, <V><n>, <V><m>
                        // FCMGE <V><d>, <V><n>, #0.0           ;    FMINNMP <V><d>, <Vn>.<T>    ;    FMAXNMP <V><d>, <Vn>.<T>
                        // CMHI D<d>, D<n>, D<m>                ;    FCVTZU <V><d>, <V><n>       ;    FCMGT <V><d>, <V><n>, <V><m>
                        // FCMGE <V><d>, <V><n>, <V><m>         ;    CMLE D<d>, D<n>, #0         ;    CMGE D<d>, D<n>, #0
@@ -6897,7 +9732,8 @@ uint64_t Arm64::run( void )
                         zero_vreg( d );
                         vregs[ d ].setf( 0, result );
                     }
-                    trace_vregs();
+                    if ( stepping )
+                        trace_vregs();
                 }
                 else if ( 0x3822 == bits23_10 ) // CMGE D<d>, D<n>, #0
                 {
@@ -6921,7 +9757,7 @@ uint64_t Arm64::run( void )
                     unhandled();
                 break;
             }
-            case 0x0e: case 0x4e: // DUP <Vd>.<T>, <Vn>.<Ts>[<index>]    ;    DUP <Vd>.<T>, <R><n>    ;             CMEQ <Vd>.<T>, <Vn>.<T>, #0    ;    ADDP <Vd>.<T>, <V
+            OP_CASE( 0x0e ) OP_CASE( 0x4e ) // DUP <Vd>.<T>, <Vn>.<Ts>[<index>]    ;    DUP <Vd>.<T>, <R><n>    ;             CMEQ <Vd>.<T>, <Vn>.<T>, #0    ;    ADDP <Vd>.<T>, <V
                                   // AND <Vd>.<T>, <Vn>.<T>, <Vm>.<T>    ;    UMOV <Wd>, <Vn>.<Ts>[<index>]    ;    UMOV <Xd>, <Vn>.D[<index>]     ;    CNT <Vd>.<T>, <Vn>.<T>
                                   // AND <Vd>.<T>, <Vn>.<T>, <Vm>.<T>    ;    UMOV <Wd>, <Vn>.<Ts>[<index>]    ;    UMOV <Xd>, <Vn>.D[<index>]     ;    ADDV <V><d>, <Vn>.<T>
                                   // XTN{2} <Vd>.<Tb>, <Vn>.<Ta>         ;    UZP1 <Vd>.<T>, <Vn>.<T>, <Vm>.<T> ;   UZP2 <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
@@ -6956,7 +9792,33 @@ uint64_t Arm64::run( void )
                 uint64_t bits12_10 = opbits( 10, 3 );
                 uint64_t bits15_10 = opbits( 10, 6 );
 
-                if ( bit21 )
+                if ( 0x4e284800 == ( op & 0xffffcc00 ) ) // AESE <Vd>.16B, <Vn>.16B    ;    AESD    ;    AESMC    ;    AESIMC
+                    aes_operation( vregs[ d ], vregs[ n ], (uint32_t) opbits( 12, 2 ) );
+                else if ( 0x0e20e000 == ( op & 0xbf20fc00 ) ) // PMULL{2} <Vd>.<Ta>, <Vn>.<Tb>, <Vm>.<Tb>
+                {
+                    uint64_t m = opbits( 16, 5 );
+                    uint64_t size = opbits( 22, 2 );
+                    if ( 3 == size )
+                        pmull64( vregs[ d ], vregs[ n ].get64( Q ), vregs[ m ].get64( Q ) );
+                    else if ( 0 == size )
+                    {
+                        vec16_t target;
+                        for ( uint64_t e = 0; e < 8; e++ )
+                        {
+                            uint32_t a = vregs[ n ].get8( e + 8 * Q );
+                            uint32_t b = vregs[ m ].get8( e + 8 * Q );
+                            uint32_t product = 0;
+                            for ( int i = 0; i < 8; i++ )
+                                if ( b & ( 1 << i ) )
+                                    product ^= ( a << i );
+                            target.set16( e, (uint16_t) product );
+                        }
+                        vregs[ d ] = target;
+                    }
+                    else
+                        unhandled();
+                }
+                else if ( bit21 )
                 {
                     if ( 0 == bits20_16 && 6 == bits15_10 ) // REV16 <Vd>.<T>, <Vn>.<T>
                     {
@@ -7497,7 +10359,8 @@ uint64_t Arm64::run( void )
                             else
                                 unhandled();
                         }
-                        trace_vregs();
+                        if ( stepping )
+                            trace_vregs();
                     }
                     else if ( ( 0x11 == bits20_16 || 0x10 == bits20_16 ) && 0x2a == bits15_10 ) // SMINV <V><d>, <Vn>.<T>         ;    SMAXV <V><d>, <Vn>.<T>
                     {
@@ -7625,10 +10488,10 @@ uint64_t Arm64::run( void )
 
                         if ( 4 == ebytes )
                             for ( uint64_t e = 0; e < elements; e++ )
-                                vregs[ d ].setf( e, (float) do_fsub( vregs[ d ].getf( e ), do_fmul( vregs[ n ].getf( e ), vregs[ m ].getf( e ) ) ) );
+                                vregs[ d ].setf( e, do_fmaddf( -vregs[ n ].getf( e ), vregs[ m ].getf( e ), vregs[ d ].getf( e ) ) );
                         else if ( 8 == ebytes )
                             for ( uint64_t e = 0; e < elements; e++ )
-                                vregs[ d ].setd( e, do_fsub( vregs[ d ].getd( e ), do_fmul( vregs[ n ].getd( e ), vregs[ m ].getd( e ) ) ) );
+                                vregs[ d ].setd( e, do_fmadd( -vregs[ n ].getd( e ), vregs[ m ].getd( e ), vregs[ d ].getd( e ) ) );
                         else
                             unhandled();
                     }
@@ -7778,9 +10641,9 @@ uint64_t Arm64::run( void )
                         for ( uint64_t e = 0; e < elements; e++ )
                         {
                             if ( 8 == ebytes )
-                                target.setd( e, do_fadd( do_fmul( vn.getd( e ), vm.getd( e ) ), vd.getd( e ) ) );
+                                target.setd( e, do_fmadd( vn.getd( e ), vm.getd( e ), vd.getd( e ) ) );
                             else if ( 4 == ebytes )
-                                target.setf( e, (float) do_fadd( do_fmul( vn.getf( e ), vm.getf( e ) ), (double) vd.getf( e ) ) );
+                                target.setf( e, do_fmaddf( vn.getf( e ), vm.getf( e ), vd.getf( e ) ) );
                             else
                                 unhandled();
                         }
@@ -7828,16 +10691,19 @@ uint64_t Arm64::run( void )
                         uint64_t elements = datasize / esize;
                         vec16_t & dref = vregs[ d ];
                         vec16_t & nref = vregs[ n ];
-                        for ( uint64_t e = 0; e < elements; e++ )
+                        if ( !vec_compare( dref, nref, vec_zeroes, ebytes, Q, vc_eq ) )
                         {
-                            if ( 1 == ebytes )
-                                dref.set8( e, ( 0 == nref.get8( e ) ) ? ~0 : 0 );
-                            else if ( 2 == ebytes )
-                                dref.set16( e, ( 0 == nref.get16( e ) ) ? ~0 : 0 );
-                            else if ( 4 == ebytes )
-                                dref.set32( e, ( 0 == nref.get32( e ) ) ? ~0 : 0 );
-                            else
-                                dref.set64( e, ( 0 == nref.get64( e ) ) ? ~0 : 0 );
+                            for ( uint64_t e = 0; e < elements; e++ )
+                            {
+                                if ( 1 == ebytes )
+                                    dref.set8( e, ( 0 == nref.get8( e ) ) ? ~0 : 0 );
+                                else if ( 2 == ebytes )
+                                    dref.set16( e, ( 0 == nref.get16( e ) ) ? ~0 : 0 );
+                                else if ( 4 == ebytes )
+                                    dref.set32( e, ( 0 == nref.get32( e ) ) ? ~0 : 0 );
+                                else
+                                    dref.set64( e, ( 0 == nref.get64( e ) ) ? ~0 : 0 );
+                            }
                         }
                     }
                     else if ( !bit15 && ( 7 == bits14_11 || 6 == bits14_11 ) && bit10 ) // CMGE <Vd>.<T>, <Vn>.<T>, <Vm>.<T>  ;  CMGT <Vd>.<T>, <Vn>.<T>, <Vm>.<T>
@@ -7919,7 +10785,11 @@ uint64_t Arm64::run( void )
                         vec16_t & vn = vregs[ n ];
                         vec16_t & vm = vregs[ m ];
 
-                        if ( 1 == ebytes )
+                        if ( vec_add( target, vn, vm, ebytes, Q, false ) )
+                        {
+                            // handled with host simd
+                        }
+                        else if ( 1 == ebytes )
                             for ( uint64_t e = 0; e < elements; e++ )
                                 target.set8( e, vn.get8( e ) + vm.get8( e ) );
                         else if ( 2 == ebytes )
@@ -8196,12 +11066,13 @@ uint64_t Arm64::run( void )
                         unhandled();
                 }
 
-                trace_vregs();
+                if ( stepping )
+                    trace_vregs();
                 break;
             }
-            case 0x1e: // FMOV <Wd>, <Hn>    ;    FMUL                ;    FMOV <Wd>, imm       ;    FCVTZU <Wd>, <Dn>    ;    FRINTA <Dd>, <Dn>    ;    FMAXNM <Dd>, <Dn>, <Dm>
+            OP_CASE( 0x1e ) // FMOV <Wd>, <Hn>    ;    FMUL                ;    FMOV <Wd>, imm       ;    FCVTZU <Wd>, <Dn>    ;    FRINTA <Dd>, <Dn>    ;    FMAXNM <Dd>, <Dn>, <Dm>
                        // FMAX <Dd>, <Dn>, <Dm> ; FMINNM <Dd>, <Dn>, <Dm>  ; FMIN <Dd>, <Dn>, <Dm> ; FRINTZ <Dd>, <Dn>    ;    FRINTP <Dd>, <Dn>
-            case 0x9e: // FMOV <Xd>, <Hn>    ;    UCVTF <Hd>, <Dn>    ;    FCVTZU <Xd>, <Dn>    ;    FCVTAS <Xd>, <Dn>    ;    FCVTMU <Xd>, <Dn>
+            OP_CASE( 0x9e ) // FMOV <Xd>, <Hn>    ;    UCVTF <Hd>, <Dn>    ;    FCVTZU <Xd>, <Dn>    ;    FCVTAS <Xd>, <Dn>    ;    FCVTMU <Xd>, <Dn>
             {
                 uint64_t sf = opbit( 31 );
                 uint64_t ftype = opbits( 22, 2 );
@@ -8266,7 +11137,8 @@ uint64_t Arm64::run( void )
                     else
                         vregs[ d ].setd( 0, result );
 
-                    trace_vregs();
+                    if ( stepping )
+                        trace_vregs();
                 }
                 else if ( 0x1e == hi8 && bit21 && ( 0x16 == bits15_10 || 0x1e == bits15_10 ) ) // FMIN <Dd>, <Dn>, <Dm>    ;    FMINNM <Dd>, <Dn>, <Dm>
                 {
@@ -8299,7 +11171,8 @@ uint64_t Arm64::run( void )
                     else
                         vregs[ d ].setd( 0, result );
 
-                    trace_vregs();
+                    if ( stepping )
+                        trace_vregs();
                 }
                 else if ( 0x1e == hi8 && 4 == bits21_19 && 0x150 == bits18_10 ) // FRINTM <Dd>, <Dn>
                 {
@@ -8391,7 +11264,8 @@ uint64_t Arm64::run( void )
                         vregs[ d ].setd( 0, round_double( vregs[ n ].getd( 0 ), FPRounding_TIEAWAY ) );
                     else
                         unhandled();
-                    trace_vregs();
+                    if ( stepping )
+                        trace_vregs();
                 }
                 else if ( ( 0x180 == ( bits18_10 & 0x1bf ) ) && ( bit21 ) && ( 0 == ( rmode & 2 ) ) ) // fmov reg, vreg  OR  fmov vreg, reg
                 {
@@ -8429,7 +11303,8 @@ uint64_t Arm64::run( void )
                         else
                             unhandled();
 
-                        trace_vregs();
+                        if ( stepping )
+                            trace_vregs();
                     }
                     else
                     {
@@ -8452,7 +11327,8 @@ uint64_t Arm64::run( void )
                             else
                                 unhandled();
 
-                            trace_vregs();
+                            if ( stepping )
+                                trace_vregs();
                         }
                         else
                         {
@@ -8548,7 +11424,8 @@ uint64_t Arm64::run( void )
                         vregs[ d ].set32( 0, (uint32_t) val );
                     else
                         unhandled();
-                    trace_vregs();
+                    if ( stepping )
+                        trace_vregs();
                 }
                 else if ( ( 0x1e == hi8 ) && ( 2 == ( bits18_10 & 0x3f ) ) && ( bit21 ) ) // fmul (scalar)
                 {
@@ -8565,7 +11442,8 @@ uint64_t Arm64::run( void )
                     }
                     else
                         unhandled();
-                    trace_vregs();
+                    if ( stepping )
+                        trace_vregs();
                 }
                 else if ( ( 0x1e == hi8 ) && ( 0x90 == ( bits18_10 & 0x19f ) ) && ( bit21 ) ) // fcvt
                 {
@@ -8593,7 +11471,8 @@ uint64_t Arm64::run( void )
                     else
                         unhandled();
 
-                    trace_vregs();
+                    if ( stepping )
+                        trace_vregs();
                 }
                 else if ( ( 0x1e == hi8 ) && ( 0x10 == bits18_10 ) && ( 4 == bits21_19 ) ) // fmov
                     vregs[ d ] = vregs[ n ];
@@ -8668,7 +11547,8 @@ uint64_t Arm64::run( void )
                     }
                     else
                         unhandled();
-                    trace_vregs();
+                    if ( stepping )
+                        trace_vregs();
                 }
                 else if ( 0x1e == hi8 && ( 6 == ( 0x3f & bits18_10 ) ) && bit21 ) // fdiv v, v, v
                 {
@@ -8679,7 +11559,8 @@ uint64_t Arm64::run( void )
                         vregs[ d ].setd( 0, do_fdiv( vregs[ n ].getd( 0 ), vregs[ m ].getd( 0 ) ) );
                     else
                         unhandled();
-                    trace_vregs();
+                    if ( stepping )
+                        trace_vregs();
                 }
                 else if ( 0x1e == hi8 && ( 0xa == ( 0x3f & bits18_10 ) ) && bit21 ) // fadd v, v, v
                 {
@@ -8690,7 +11571,8 @@ uint64_t Arm64::run( void )
                         vregs[ d ].setd( 0, do_fadd( vregs[ n ].getd( 0 ), vregs[ m ].getd( 0 ) ) );
                     else
                         unhandled();
-                    trace_vregs();
+                    if ( stepping )
+                        trace_vregs();
                 }
                 else if ( 0x1e == hi8 && ( 0xe == ( 0x3f & bits18_10 ) ) && bit21 ) // fsub v, v, v
                 {
@@ -8820,8 +11702,8 @@ uint64_t Arm64::run( void )
                     unhandled();
                 break;
             }
-            case 0x0c:
-            case 0x4c: // LD1 { <Vt>.<T> }, [<Xn|SP>]    ;    LD2 { <Vt>.<T>, <Vt2>.<T> }, [<Xn|SP>]
+            OP_CASE( 0x0c )
+            OP_CASE( 0x4c ) // LD1 { <Vt>.<T> }, [<Xn|SP>]    ;    LD2 { <Vt>.<T>, <Vt2>.<T> }, [<Xn|SP>]
                        // ST2 { <Vt>.<T>, <Vt2>.<T> }, [<Xn|SP>]    ;    ST2 { <Vt>.<T>, <Vt2>.<T> }, [<Xn|SP>], <imm>    ;    ST2 { <Vt>.<T>, <Vt2>.<T> }, [<Xn|SP>], <Xm>
                        // LD3 { <Vt>.<T>, <Vt2>.<T>, <Vt3>.<T> }, [<Xn|SP>]
                        // LD3 { <Vt>.<T>, <Vt2>.<T>, <Vt3>.<T> }, [<Xn|SP>], <imm>
@@ -8894,6 +11776,7 @@ uint64_t Arm64::run( void )
                             for ( uint64_t s = 0; s < selem; s++ )
                             {
                                 uint64_t eaddr = address + offs;
+                                track( eaddr, (uint32_t) ebytes, !L );
                                 if ( L ) // LD
                                     mcpy( vreg_ptr( tt, e * ebytes ), getmem( eaddr ), ebytes );
                                 else // ST
@@ -8904,7 +11787,7 @@ uint64_t Arm64::run( void )
                         }
                     }
 
-                    if ( L )
+                    if ( stepping && L )
                         trace_vregs();
 
                     if ( post_index )
@@ -8932,9 +11815,9 @@ uint64_t Arm64::run( void )
                     unhandled();
                 break;
             }
-            case 0x88: // LDAXR <Wt>, [<Xn|SP>{, #0}]    ;    LDXR <Wt>, [<Xn|SP>{, #0}]    ;    STXR <Ws>, <Wt>, [<Xn|SP>{, #0}]    ;    STLXR <Ws>, <Wt>, [<Xn|SP>{, #0}]
+            OP_CASE( 0x88 ) // LDAXR <Wt>, [<Xn|SP>{, #0}]    ;    LDXR <Wt>, [<Xn|SP>{, #0}]    ;    STXR <Ws>, <Wt>, [<Xn|SP>{, #0}]    ;    STLXR <Ws>, <Wt>, [<Xn|SP>{, #0}]
                        //                                                                        STLR <Wt>, [<Xn|SP>{, #0}]          ;    STLR <Wt>, [<Xn|SP>, #-4]!
-            case 0xc8: // LDAXR <Xt>, [<Xn|SP>{, #0}]    ;    LDXR <Xt>, [<Xn|SP>{, #0}]    ;    STXR <Ws>, <Xt>, [<Xn|SP>{, #0}]    ;    STLXR <Ws>, <Xt>, [<Xn|SP>{, #0}]
+            OP_CASE( 0xc8 ) // LDAXR <Xt>, [<Xn|SP>{, #0}]    ;    LDXR <Xt>, [<Xn|SP>{, #0}]    ;    STXR <Ws>, <Xt>, [<Xn|SP>{, #0}]    ;    STLXR <Ws>, <Xt>, [<Xn|SP>{, #0}]
                        //                                                                        STLR <Xt>, [<Xn|SP>{, #0}]          ;    STLR <Xt>, [<Xn|SP>, #-8]!
             {
                 uint64_t t = opbits( 0, 5 );
@@ -8947,34 +11830,60 @@ uint64_t Arm64::run( void )
                 if ( 0x1f != t2 )
                     unhandled();
 
-                if ( 0 == L ) // stxr, stlr
+                bool ordered = opbit( 15 );
+                bool is64 = ( 0xc8 == hi8 );
+
+                if ( bit23 && ( L & 1 ) ) // CAS{A}{L} <Ws>, <Wt>, [<Xn|SP>]    ;    CAS{A}{L} <Xs>, <Xt>, [<Xn|SP>]
+                {
+                    uint64_t mask = is64 ? ~0ull : 0xffffffff;
+                    uint64_t old = compare_and_swap( regs[ n ], val_reg_or_zr( s ) & mask, val_reg_or_zr( t ) & mask, is64 ? 8 : 4 );
+                    if ( 31 != s )
+                        regs[ s ] = old;
+                    break;
+                }
+
+                if ( 0 == L ) // stxr, stlxr, stlr
                 {
-                    uint64_t bit30 = opbit( 30 );
                     uint64_t tval = val_reg_or_zr( t );
-                    if ( bit30 )
+                    if ( !is64 )
+                        tval = (uint32_t) tval;
+
+                    if ( ordered )
+                        atomic_thread_fence( memory_order_release );
+
+                    if ( !bit23 ) // stxr and stlxr write 0 to Ws on success and 1 on failure
+                    {
+                        bool ok = store_exclusive( regs[ n ], tval, is64 ? 8 : 4 );
+                        if ( 31 != s )
+                            regs[ s ] = ok ? 0 : 1;
+                    }
+                    else if ( is64 )
                         setui64( regs[ n ], tval );
                     else
                         setui32( regs[ n ], (uint32_t) tval );
-
-                    if ( !bit23 && 31 != s ) // stxr
-                        regs[ s ] = 0; // success
                 }
-                else if ( 2 == L ) // ldaxr or ldxr
+                else if ( 2 == L ) // ldxr, ldaxr, ldar
                 {
                     if ( 0x1f != s )
                         unhandled();
 
-                    if ( 31 == t )
-                        break;
-
-                    if ( 0xc8 == hi8 )
-                        regs[ t ] = getui64( regs[ n ] );
+                    uint64_t val;
+                    if ( !bit23 )
+                        val = load_exclusive( regs[ n ], is64 ? 8 : 4 );
+                    else if ( is64 )
+                        val = getui64( regs[ n ] );
                     else
-                        regs[ t ] = getui32( regs[ n ] );
+                        val = getui32( regs[ n ] );
+
+                    if ( ordered )
+                        atomic_thread_fence( memory_order_acquire );
+
+                    if ( 31 != t )
+                        regs[ t ] = val;
                 }
                 break;
             }
-            case 0xd6: // BLR <Xn>    ;    BR <Xn>    ;    RET {<Xn>}
+            OP_CASE( 0xd6 ) // BLR <Xn>    ;    BR <Xn>    ;    RET {<Xn>}
             {
                 uint64_t n = opbits( 5, 5 );
                 uint64_t theop = opbits( 21, 2 );
@@ -8998,8 +11907,8 @@ uint64_t Arm64::run( void )
 
                 continue;
             }
-            case 0x1b: // MADD <Wd>, <Wn>, <Wm>, <Wa>    ;    MSUB <Wd>, <Wn>, <Wm>, <Wa>
-            case 0x9b: // MADD <Xd>, <Xn>, <Xm>, <Xa>    ;    MSUB <Xd>, <Xn>, <Xm>, <Xa>    ;    UMULH <Xd>, <Xn>, <Xm>    ;    UMADDL <Xd>, <Wn>, <Wm>, <Xa>
+            OP_CASE( 0x1b ) // MADD <Wd>, <Wn>, <Wm>, <Wa>    ;    MSUB <Wd>, <Wn>, <Wm>, <Wa>
+            OP_CASE( 0x9b ) // MADD <Xd>, <Xn>, <Xm>, <Xa>    ;    MSUB <Xd>, <Xn>, <Xm>, <Xa>    ;    UMULH <Xd>, <Xn>, <Xm>    ;    UMADDL <Xd>, <Wn>, <Wm>, <Xa>
                        // SMADDL <Xd>, <Wn>, <Wm>, <Xa>  ;    SMULH <Xd>, <Xn>, <Xm>         ;    UMSUBL <Xd>, <Wn>, <Wm>, <Xa>
             {
                 uint64_t d = opbits( 0, 5 );
@@ -9057,8 +11966,8 @@ uint64_t Arm64::run( void )
                 }
                 break;
             }
-            case 0x72: // MOVK <Wd>, #<imm>{, LSL #<shift>}       ;  ANDS <Wd>, <Wn>, #<imm>
-            case 0xf2: // MOVK <Xd>, #<imm>{, LSL #<shift>}       ;  ANDS <Xd>, <Xn>, #<imm>
+            OP_CASE( 0x72 ) // MOVK <Wd>, #<imm>{, LSL #<shift>}       ;  ANDS <Wd>, <Wn>, #<imm>
+            OP_CASE( 0xf2 ) // MOVK <Xd>, #<imm>{, LSL #<shift>}       ;  ANDS <Xd>, <Xn>, #<imm>
             {
                 uint64_t d = opbits( 0, 5 );
                 uint64_t bit23 = opbit( 23 ); // 1 for MOVK, 0 for ANDS
@@ -9079,6 +11988,7 @@ uint64_t Arm64::run( void )
                     uint64_t n = opbits( 5, 5 );
                     uint64_t nvalue = val_reg_or_zr( n );
                     uint64_t result = ( nvalue & op2 );
+                    lazy_kind = lazy_none;
                     if ( xregs )
                         fN = get_bit( result, 63 );
                     else
@@ -9094,10 +12004,10 @@ uint64_t Arm64::run( void )
                 }
                 break;
             }
-            case 0x38: // B LDRB STRB
-            case 0x78: // H LDRH STRH
-            case 0xb8: // W
-            case 0xf8: // X
+            OP_CASE( 0x38 ) // B LDRB STRB
+            OP_CASE( 0x78 ) // H LDRH STRH
+            OP_CASE( 0xb8 ) // W
+            OP_CASE( 0xf8 ) // X
             {
                 // LDR <Xt>, [<Xn|SP>, (<Wm>|<Xm>){, <extend> {<amount>}}]
                 // LDR <Xt>, [<Xn|SP>], #<simm>
@@ -9110,6 +12020,20 @@ uint64_t Arm64::run( void )
                 uint64_t n = opbits( 5, 5 );
                 uint64_t t = opbits( 0, 5 );
 
+                if ( opbit( 21 ) && 0 == opbits( 10, 2 ) ) // LDADD, LDCLR, LDEOR, LDSET, LDSMAX, LDSMIN, LDUMAX, LDUMIN, SWP {A}{L}{B|H} <Ws>, <Wt>, [<Xn|SP>] and the ST* aliases
+                {
+                    uint64_t s = opbits( 16, 5 );
+                    uint64_t o3 = opbit( 15 );
+                    uint64_t atomic_opc = opbits( 12, 3 );
+                    if ( o3 && 0 != atomic_opc )
+                        unhandled();
+
+                    uint64_t old = atomic_op( regs[ n ], val_reg_or_zr( s ), 1 << opbits( 30, 2 ), o3 ? 8 : (uint32_t) atomic_opc );
+                    if ( 31 != t )
+                        regs[ t ] = old;
+                    break;
+                }
+
                 if ( 0 == opc ) // str (immediate) post-index and pre-index
                 {
                     uint64_t unsigned_imm9 = opbits( 12, 9 );
@@ -9302,10 +12226,10 @@ uint64_t Arm64::run( void )
                 }
                 break;
             }
-            case 0x39: // B
-            case 0x79: // H                              ;    LDRSH <Wt>, [<Xn|SP>{, #<pimm>}]    ;     STR/LDR <Xt>, [<Xn|SP>{, #<pimm>}]
-            case 0xb9: // W
-            case 0xf9: // X ldr + str unsigned offset    ;    LDRSW <Xt>, [<Xn|SP>{, #<pimm>}]
+            OP_CASE( 0x39 ) // B
+            OP_CASE( 0x79 ) // H                              ;    LDRSH <Wt>, [<Xn|SP>{, #<pimm>}]    ;     STR/LDR <Xt>, [<Xn|SP>{, #<pimm>}]
+            OP_CASE( 0xb9 ) // W
+            OP_CASE( 0xf9 ) // X ldr + str unsigned offset    ;    LDRSW <Xt>, [<Xn|SP>{, #<pimm>}]
             {
                 uint64_t opc = opbits( 22, 2 );
                 uint64_t imm12 = opbits( 10, 12 );
@@ -9372,7 +12296,19 @@ uint64_t Arm64::run( void )
                 }
                 break;
             }
-            case 0xff: // call this maximum out so the msft compiler doesn't do a bounds check at runtime for the switch jump table
+            // opcodes with no handler are listed so every hi8 has a label for computed goto dispatch
+            OP_CASE( 0x01 ) OP_CASE( 0x02 ) OP_CASE( 0x03 ) OP_CASE( 0x04 ) OP_CASE( 0x05 ) OP_CASE( 0x06 ) OP_CASE( 0x07 ) OP_CASE( 0x09 ) OP_CASE( 0x19 ) OP_CASE( 0x1c ) OP_CASE( 0x1d ) OP_CASE( 0x20 )
+            OP_CASE( 0x21 ) OP_CASE( 0x22 ) OP_CASE( 0x23 ) OP_CASE( 0x24 ) OP_CASE( 0x25 ) OP_CASE( 0x26 ) OP_CASE( 0x27 ) OP_CASE( 0x3b ) OP_CASE( 0x3e ) OP_CASE( 0x3f ) OP_CASE( 0x40 ) OP_CASE( 0x41 )
+            OP_CASE( 0x42 ) OP_CASE( 0x43 ) OP_CASE( 0x44 ) OP_CASE( 0x45 ) OP_CASE( 0x46 ) OP_CASE( 0x47 ) OP_CASE( 0x49 ) OP_CASE( 0x55 ) OP_CASE( 0x56 ) OP_CASE( 0x57 ) OP_CASE( 0x59 ) OP_CASE( 0x5b )
+            OP_CASE( 0x5c ) OP_CASE( 0x5d ) OP_CASE( 0x60 ) OP_CASE( 0x61 ) OP_CASE( 0x62 ) OP_CASE( 0x63 ) OP_CASE( 0x64 ) OP_CASE( 0x65 ) OP_CASE( 0x66 ) OP_CASE( 0x67 ) OP_CASE( 0x73 ) OP_CASE( 0x74 )
+            OP_CASE( 0x75 ) OP_CASE( 0x76 ) OP_CASE( 0x77 ) OP_CASE( 0x7b ) OP_CASE( 0x80 ) OP_CASE( 0x81 ) OP_CASE( 0x82 ) OP_CASE( 0x83 ) OP_CASE( 0x84 ) OP_CASE( 0x85 ) OP_CASE( 0x86 ) OP_CASE( 0x87 )
+            OP_CASE( 0x89 ) OP_CASE( 0x8c ) OP_CASE( 0x8d ) OP_CASE( 0x8e ) OP_CASE( 0x8f ) OP_CASE( 0x98 ) OP_CASE( 0x99 ) OP_CASE( 0x9c ) OP_CASE( 0x9d ) OP_CASE( 0x9f ) OP_CASE( 0xa0 ) OP_CASE( 0xa1 )
+            OP_CASE( 0xa2 ) OP_CASE( 0xa3 ) OP_CASE( 0xa4 ) OP_CASE( 0xa5 ) OP_CASE( 0xa6 ) OP_CASE( 0xa7 ) OP_CASE( 0xae ) OP_CASE( 0xaf ) OP_CASE( 0xbb ) OP_CASE( 0xbe ) OP_CASE( 0xbf ) OP_CASE( 0xc0 )
+            OP_CASE( 0xc1 ) OP_CASE( 0xc2 ) OP_CASE( 0xc3 ) OP_CASE( 0xc4 ) OP_CASE( 0xc5 ) OP_CASE( 0xc6 ) OP_CASE( 0xc7 ) OP_CASE( 0xc9 ) OP_CASE( 0xcc ) OP_CASE( 0xcd ) OP_CASE( 0xce ) OP_CASE( 0xcf )
+            OP_CASE( 0xd7 ) OP_CASE( 0xd8 ) OP_CASE( 0xd9 ) OP_CASE( 0xdb ) OP_CASE( 0xdc ) OP_CASE( 0xdd ) OP_CASE( 0xde ) OP_CASE( 0xdf ) OP_CASE( 0xe0 ) OP_CASE( 0xe1 ) OP_CASE( 0xe2 ) OP_CASE( 0xe3 )
+            OP_CASE( 0xe4 ) OP_CASE( 0xe5 ) OP_CASE( 0xe6 ) OP_CASE( 0xe7 ) OP_CASE( 0xe8 ) OP_CASE( 0xe9 ) OP_CASE( 0xec ) OP_CASE( 0xed ) OP_CASE( 0xee ) OP_CASE( 0xef ) OP_CASE( 0xf3 ) OP_CASE( 0xf4 )
+            OP_CASE( 0xf5 ) OP_CASE( 0xf6 ) OP_CASE( 0xf7 ) OP_CASE( 0xfb ) OP_CASE( 0xfe )
+            OP_CASE( 0xff ) // call this maximum out so the msft compiler doesn't do a bounds check at runtime for the switch jump table
             default:
                 unhandled();
         }
@@ -9380,5 +12316,5 @@ uint64_t Arm64::run( void )
         pc += 4;
     } //for
 
-    return cycles;
-} //run
+    return true;
+} //run_loop
@@ -1,6 +1,14 @@
 #pragma once
 
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #include <djl_os.hxx>
+#include <djl_vmem.hxx>
+
+#include "arm64jit.hxx"
 
 #ifdef _MSC_VER
 
@@ -20,16 +28,59 @@ struct Arm64;
 extern void emulator_invoke_svc( Arm64 & cpu );                                               // called when the svc instruction is executed
 extern const char * emulator_symbol_lookup( uint64_t address, uint64_t & offset );            // returns the best guess for a symbol name and offset for the address
 extern void emulator_hard_termination( Arm64 & cpu, const char *pcerr, uint64_t error_value ); // show an error and exit
+extern void emulator_sample( Arm64 & cpu );                                                   // called at a block boundary after request_sample()
+extern void emulator_breakpoint( Arm64 & cpu );                                               // called once when the pc reaches the set_breakpoint() address
+extern bool emulator_intercept( Arm64 & cpu, uint32_t routine );                              // called at a set_intercepts() address. false to run the guest's code
+extern uint64_t emulator_clock( uint32_t clock_id );                                          // nanoseconds on a Linux clock (0..7) for mrs of S3_3_C15_C0_<clock_id>
+extern uint64_t emulator_counter( uint32_t counter );                                         // the emulator's event counter for mrs of PMEVCNTR<counter>_EL0
+extern void emulator_memory_access( Arm64 & cpu, uint64_t address, uint32_t size, bool write ); // each guest load and store after enable_memory_tracking()
+
+// guest memory and vector registers hold little-endian data, so big-endian hosts convert values as they're loaded
+// and stored. sparc v9 has byte-reversing loads and stores, so the conversion is free there. compilers for powerpc
+// and s390 make single byte-reversing instructions of a load followed by a swap. build with -DARM64_SWAP_AFTER_LOAD
+// to use plain loads and stores followed by swaps everywhere, for comparison
+
+#ifdef TARGET_BIG_ENDIAN
+
+#if defined( __GNUC__ ) && ( defined( __sparc_v9__ ) || defined( __arch64__ ) ) && !defined( ARM64_SWAP_AFTER_LOAD )
+
+    // asi 0x88 is ASI_PRIMARY_LITTLE, which user code can use
+
+    inline uint16_t load_le16( const void * p ) { uint16_t x; __asm__ ( "lduha [%1] 0x88, %0" : "=r" ( x ) : "r" ( p ), "m" ( * (const uint16_t *) p ) ); return x; }
+    inline uint32_t load_le32( const void * p ) { uint32_t x; __asm__ ( "lduwa [%1] 0x88, %0" : "=r" ( x ) : "r" ( p ), "m" ( * (const uint32_t *) p ) ); return x; }
+    inline void store_le16( void * p, uint16_t x ) { __asm__ ( "stha %1, [%2] 0x88" : "=m" ( * (uint16_t *) p ) : "r" ( x ), "r" ( p ) ); }
+    inline void store_le32( void * p, uint32_t x ) { __asm__ ( "stwa %1, [%2] 0x88" : "=m" ( * (uint32_t *) p ) : "r" ( x ), "r" ( p ) ); }
+
+    #ifdef __arch64__
+        inline uint64_t load_le64( const void * p ) { uint64_t x; __asm__ ( "ldxa [%1] 0x88, %0" : "=r" ( x ) : "r" ( p ), "m" ( * (const uint64_t *) p ) ); return x; }
+        inline void store_le64( void * p, uint64_t x ) { __asm__ ( "stxa %1, [%2] 0x88" : "=m" ( * (uint64_t *) p ) : "r" ( x ), "r" ( p ) ); }
+    #else // 32-bit code can't hold 64 bits in one register
+        inline uint64_t load_le64( const void * p ) { return load_le32( p ) | ( (uint64_t) load_le32( (const uint8_t *) p + 4 ) << 32 ); }
+        inline void store_le64( void * p, uint64_t x ) { store_le32( p, (uint32_t) x ); store_le32( (uint8_t *) p + 4, (uint32_t) ( x >> 32 ) ); }
+    #endif
+
+#else
+
+    inline uint16_t load_le16( const void * p ) { return flip_endian16( * (const uint16_t *) p ); }
+    inline uint32_t load_le32( const void * p ) { return flip_endian32( * (const uint32_t *) p ); }
+    inline uint64_t load_le64( const void * p ) { return flip_endian64( * (const uint64_t *) p ); }
+    inline void store_le16( void * p, uint16_t x ) { * (uint16_t *) p = flip_endian16( x ); }
+    inline void store_le32( void * p, uint32_t x ) { * (uint32_t *) p = flip_endian32( x ); }
+    inline void store_le64( void * p, uint64_t x ) { * (uint64_t *) p = flip_endian64( x ); }
+
+#endif
+
+#endif //TARGET_BIG_ENDIAN
 
 typedef struct vec16_t
 {
     #ifdef TARGET_BIG_ENDIAN
-        uint16_t get16( uint64_t elem ) { return flip_endian16( ui16[ elem ] ); }
-        void set16( uint64_t elem, uint16_t val ) { ui16[ elem ] = flip_endian16( val ); }
-        uint32_t get32( uint64_t elem ) { return flip_endian32( ui32[ elem ] ); }
-        void set32( uint64_t elem, uint32_t val ) { ui32[ elem ] = flip_endian32( val ); }
-        uint64_t get64( uint64_t elem ) { return flip_endian64( ui64[ elem ] ); }
-        void set64( uint64_t elem, uint64_t val ) { ui64[ elem ] = flip_endian64( val ); }
+        uint16_t get16( uint64_t elem ) { return load_le16( & ui16[ elem ] ); }
+        void set16( uint64_t elem, uint16_t val ) { store_le16( & ui16[ elem ], val ); }
+        uint32_t get32( uint64_t elem ) { return load_le32( & ui32[ elem ] ); }
+        void set32( uint64_t elem, uint32_t val ) { store_le32( & ui32[ elem ], val ); }
+        uint64_t get64( uint64_t elem ) { return load_le64( & ui64[ elem ] ); }
+        void set64( uint64_t elem, uint64_t val ) { store_le64( & ui64[ elem ], val ); }
         float getf( uint64_t elem ) { uint32_t x = get32( elem ); return * (float *) & x; }
         void setf( uint64_t elem, float val ) { set32( elem, * (uint32_t *) & val); }
         double getd( uint64_t elem ) { uint64_t x = get64( elem ); return * (double *) & x; }
@@ -68,9 +119,88 @@ typedef struct vec16_t
 struct Arm64
 {
     bool trace_instructions( bool trace );                // enable/disable tracing each instruction
-    void end_emulation( void );                           // make the emulator return at the start of the next instruction
+    void end_emulation( void );                           // make the emulator return at the start of the next instruction. callable from any thread
+    void yield_svc( void );                               // from emulator_invoke_svc: run() returns stop_svc once the svc completes
+    void request_sample( void );                          // call emulator_sample() at the next block boundary for profiling. callable from any thread
+    void copy_thread_state( Arm64 & parent );             // start a new guest thread with the registers and settings of the one that cloned it
+    void set_breakpoint( uint64_t address );              // call emulator_breakpoint() before the instruction at address runs. 0 to clear
+
+    // with instruction tracing on, trace only while the pc is in [lo, hi) and the instruction count is in
+    // [first, first + count). hi 0 is any pc and count 0 is no limit. instructions outside the filter run at full
+    // speed; it's checked at block boundaries, so tracing starts and stops at the next branch
+
+    void set_trace_filter( uint64_t lo, uint64_t hi, uint64_t first, uint64_t count );
+
+    // library routines the host runs instead of the guest. when a predecoded block starts at addresses[ i ],
+    // emulator_intercept( cpu, routines[ i ] ) is called in place of the routine's first instruction, and it sets
+    // the pc to x30 if it handled the call. the arrays are copied and needn't be sorted. only the predecode cache
+    // checks the addresses, so -c and instruction tracing disable interception
+
+    void set_intercepts( const uint64_t * addresses, const uint32_t * routines, uint32_t count );
+
+    // everything about the cpu a guest can observe, for snapshots. host byte order
 
-    Arm64( vector<uint8_t> & memory, uint64_t base_address, uint64_t start, uint64_t stack_commit, uint64_t top_of_stack )
+    struct ArchState
+    {
+        uint64_t regs[ 32 ];
+        uint64_t vregs[ 32 ][ 2 ];
+        uint64_t pc;
+        uint64_t tpidr_el0;
+        uint64_t fpcr;
+        uint64_t nzcv;              // n, z, c, v in bits 3..0
+    };
+
+    void save_state( ArchState & state );
+    void restore_state( const ArchState & state );
+    void enable_predecode( bool enable );                 // cache decoded instructions keyed by pc so hot code skips decoding
+    void enable_memory_tracking( bool enable ) { track_memory = enable; } // for memory models. code from the jit isn't tracked
+
+    // the predecoded blocks as bytes, so a later run of the same image can start with them. the caller checks that
+    // the image is the same. export returns false if blocks lie outside [lo, hi) or code was written since
+    // enable_predecode(), since then they may not match the image next time. include_jit adds the jit's code.
+    // import returns false if the data is from another build of the emulator, was made with different
+    // set_intercepts() addresses, has blocks outside [lo, hi) or that don't match the code in memory, or doesn't
+    // fit the cache. jit code is used if the jit is enabled
+
+    bool export_predecode( std::vector<uint8_t> & data, uint64_t lo, uint64_t hi, bool include_jit = false );
+    bool import_predecode( const uint8_t * data, size_t size, uint64_t lo, uint64_t hi );
+    uint32_t predecoded_blocks( void ) const { return block_count; }
+
+    // predecode the blocks reachable from starts by direct branches and falling through, within [lo, hi), and
+    // translate them if the jit is enabled. returns the number of blocks
+    uint32_t translate_ahead( const uint64_t * starts, uint32_t count, uint64_t lo, uint64_t hi );
+    void invalidate_code( uint64_t address, uint64_t length ); // discard predecoded instructions in a range of guest memory
+    bool enable_jit( bool enable );                       // translate hot blocks to host code. false if the host isn't supported
+    // instruction mix: executions per raw opcode, and the mnemonics trace_state() disassembles them to
+
+    typedef std::unordered_map<uint32_t, uint64_t> OpCounts;
+    void enable_instruction_mix( bool enable );
+    void collect_instruction_mix( OpCounts & counts );    // add this cpu's counts and reset them. call on the cpu's thread
+    void name_instruction_mix( const OpCounts & counts, std::map<std::string, uint64_t> & mix ); // uses the tracer; call when single-threaded
+
+    // branch profile for profile-guided optimization. ranges are instructions that ran straight through, keyed by the
+    // first and last pc, and branches are taken branches keyed by the branch's pc and the target. only predecoded
+    // blocks are counted, so nothing is while instructions run one at a time (-c, tracing, the trace ring)
+
+    typedef std::map<std::pair<uint64_t, uint64_t>, uint64_t> EdgeCounts;
+    void enable_branch_profile( bool enable );
+    void collect_branch_profile( EdgeCounts & ranges, EdgeCounts & branches ); // add this cpu's counts and reset them. call on the cpu's thread
+
+    // binary trace ring: the last instructions executed as pc, opcode, flags, and the old values of the x registers
+    // each one wrote. while it's enabled instructions run one at a time like -c. the file is in host byte order
+
+    void enable_trace_ring( uint32_t records, uint64_t trigger_pc, const char * path ); // records: a power of 2 or 0 to disable
+    bool write_trace_ring( const char * path );           // also done when the pc reaches trigger_pc. false on failure
+    uint64_t render_trace_ring( const char * path );      // trace a ring file's records as -t -i text. returns the count
+
+    // common instruction sequences fused into superinstructions by the predecode cache. counts are for -p
+
+    enum FusedIdiom { fi_subs_bcond = 0, fi_adrp_add, fi_adrp_ldr, fi_movz_movk, fi_prologue, fi_epilogue, fi_count };
+    static const char * fused_idiom_name( uint32_t idiom );
+    uint64_t fused_idiom_count( uint32_t idiom ) const { return fused_counts[ idiom ]; }
+    uint64_t jit_blocks_compiled( void ) const;
+
+    Arm64( CVirtualMemory & memory, uint64_t base_address, uint64_t start, uint64_t stack_commit, uint64_t top_of_stack )
     {
         memset( this, 0, sizeof( *this ) );
         pc = start;
@@ -85,7 +215,16 @@ struct Arm64
         memset( &vec_ones, 0xff, sizeof( vec_ones ) );
     } //Arm64
 
-    uint64_t run( void );
+    ~Arm64();
+
+    // run( max_instructions ) returns when end_emulation() or yield_svc() was called, or after about max_instructions
+    // (0 for no limit). the budget is checked where end_emulation() is, at block boundaries, so up to a block more
+    // may run. call it again to continue. cycles counts instructions across calls
+
+    enum StopReason { stop_ended = 0, stop_budget, stop_svc };
+
+    uint64_t run( void );                                 // until end_emulation(). returns cycles
+    StopReason run( uint64_t max_instructions );
 
     uint64_t regs[ 32 ];            // x0 through x31. x31 is sp. XZR references to x31 are handled in code
     vec16_t vregs[ 32 ];            // v0 through v31
@@ -102,9 +241,22 @@ struct Arm64
     uint64_t stack_top;
     uint64_t mem_size;
     uint64_t cycles;
+    bool track_memory;              // call emulator_memory_access() for loads and stores
     vec16_t vec_zeroes;
     vec16_t vec_ones;
 
+    void check_code_write( uint64_t o, uint64_t length )
+    {
+        if ( ( o < pdc_hi ) && ( ( o + length ) > pdc_lo ) ) // only true for stores into code that has been predecoded
+            invalidate_code( o, length );
+    } //check_code_write
+
+    __inline_perf void track( uint64_t o, uint32_t size, bool write )
+    {
+        if ( track_memory )
+            emulator_memory_access( *this, o, size, write );
+    } //track
+
     uint64_t getoffset( uint64_t address ) const
     {
         return address - base;
@@ -148,33 +300,70 @@ struct Arm64
     } //is_address_valid
 
 #ifdef TARGET_BIG_ENDIAN
-    uint64_t getui64( uint64_t o ) { return flip_endian64( * (uint64_t *) getmem( o ) ); }
-    uint32_t getui32( uint64_t o ) { return flip_endian32( * (uint32_t *) getmem( o ) ); }
-    uint16_t getui16( uint64_t o ) { return flip_endian16( * (uint16_t *) getmem( o ) ); }
+    uint64_t getui64( uint64_t o ) { track( o, 8, false ); return load_le64( getmem( o ) ); }
+    uint32_t getui32( uint64_t o ) { track( o, 4, false ); return load_le32( getmem( o ) ); }
+    uint16_t getui16( uint64_t o ) { track( o, 2, false ); return load_le16( getmem( o ) ); }
     float getfloat( uint64_t o ) { uint32_t x = getui32( o ); return * (float *) & x; }
     double getdouble( uint64_t o ) { uint64_t x = getui64( o ); return * (double *) & x; }
 
-    void setui64( uint64_t o, uint64_t val ) { * (uint64_t *) getmem( o ) = flip_endian64( val ); }
-    void setui32( uint64_t o, uint32_t val ) { * (uint32_t *) getmem( o ) = flip_endian32( val ); }
-    void setui16( uint64_t o, uint16_t val ) { * (uint16_t *) getmem( o ) = flip_endian16( val ); }
+    void setui64( uint64_t o, uint64_t val ) { track( o, 8, true ); check_code_write( o, 8 ); store_le64( getmem( o ), val ); }
+    void setui32( uint64_t o, uint32_t val ) { track( o, 4, true ); check_code_write( o, 4 ); store_le32( getmem( o ), val ); }
+    void setui16( uint64_t o, uint16_t val ) { track( o, 2, true ); check_code_write( o, 2 ); store_le16( getmem( o ), val ); }
     void setfloat( uint64_t o, float val ) { uint32_t x = * (uint32_t *) & val; setui32( o, x ); }
     void setdouble( uint64_t o, double val ) { uint64_t x = * (uint64_t *) & val; setui64( o, x ); }
 #else
-    uint64_t getui64( uint64_t o ) { return * (uint64_t *) getmem( o ); }
-    uint32_t getui32( uint64_t o ) { return * (uint32_t *) getmem( o ); }
-    uint16_t getui16( uint64_t o ) { return * (uint16_t *) getmem( o ); }
-    float getfloat( uint64_t o ) { return * (float *) getmem( o ); }
-    double getdouble( uint64_t o ) { return * (double *) getmem( o ); }
-
-    void setui64( uint64_t o, uint64_t val ) { * (uint64_t *) getmem( o ) = val; }
-    void setui32( uint64_t o, uint32_t val ) { * (uint32_t *) getmem( o ) = val; }
-    void setui16( uint64_t o, uint16_t val ) { * (uint16_t *) getmem( o ) = val; }
-    void setfloat( uint64_t o, float val ) { * (float *) getmem( o ) = val; }
-    void setdouble( uint64_t o, double val ) { * (double *) getmem( o ) = val; }
+    uint64_t getui64( uint64_t o ) { track( o, 8, false ); return * (uint64_t *) getmem( o ); }
+    uint32_t getui32( uint64_t o ) { track( o, 4, false ); return * (uint32_t *) getmem( o ); }
+    uint16_t getui16( uint64_t o ) { track( o, 2, false ); return * (uint16_t *) getmem( o ); }
+    float getfloat( uint64_t o ) { track( o, 4, false ); return * (float *) getmem( o ); }
+    double getdouble( uint64_t o ) { track( o, 8, false ); return * (double *) getmem( o ); }
+
+    void setui64( uint64_t o, uint64_t val ) { track( o, 8, true ); check_code_write( o, 8 ); * (uint64_t *) getmem( o ) = val; }
+    void setui32( uint64_t o, uint32_t val ) { track( o, 4, true ); check_code_write( o, 4 ); * (uint32_t *) getmem( o ) = val; }
+    void setui16( uint64_t o, uint16_t val ) { track( o, 2, true ); check_code_write( o, 2 ); * (uint16_t *) getmem( o ) = val; }
+    void setfloat( uint64_t o, float val ) { track( o, 4, true ); check_code_write( o, 4 ); * (float *) getmem( o ) = val; }
+    void setdouble( uint64_t o, double val ) { track( o, 8, true ); check_code_write( o, 8 ); * (double *) getmem( o ) = val; }
 #endif //TARGET_BIG_ENDIAN
 
-    uint8_t getui8( uint64_t o ) { return * (uint8_t *) getmem( o ); }
-    void setui8( uint64_t o, uint8_t val ) { * (uint8_t *) getmem( o ) = val; }
+    uint8_t getui8( uint64_t o ) { track( o, 1, false ); return * (uint8_t *) getmem( o ); }
+    void setui8( uint64_t o, uint8_t val ) { track( o, 1, true ); check_code_write( o, 1 ); * (uint8_t *) getmem( o ) = val; }
+
+    // ldp / stp of x registers as one 16-byte access. getmem() checks the first byte, so debug builds check the last too
+
+    uint64_t * getmem_pair( uint64_t o )
+    {
+        #ifndef NDEBUG
+            getmem( o + 15 );
+        #endif
+        return (uint64_t *) getmem( o );
+    } //getmem_pair
+
+    void getui64_pair( uint64_t o, uint64_t & a, uint64_t & b )
+    {
+        track( o, 16, false );
+        uint64_t * p = getmem_pair( o );
+        #ifdef TARGET_BIG_ENDIAN
+            a = load_le64( p );
+            b = load_le64( p + 1 );
+        #else
+            a = p[ 0 ];
+            b = p[ 1 ];
+        #endif
+    } //getui64_pair
+
+    void setui64_pair( uint64_t o, uint64_t a, uint64_t b )
+    {
+        track( o, 16, true );
+        check_code_write( o, 16 );
+        uint64_t * p = getmem_pair( o );
+        #ifdef TARGET_BIG_ENDIAN
+            store_le64( p, a );
+            store_le64( p + 1, b );
+        #else
+            p[ 0 ] = a;
+            p[ 1 ] = b;
+        #endif
+    } //setui64_pair
 
     void trace_vregs();
     void force_trace_vregs();
@@ -185,6 +374,151 @@ struct Arm64
     enum ElementComparisonResult { ecr_lt, ecr_eq, ecr_gt };
     uint64_t op; // opcode of the current instruction being executed. only need uint32_t, but faster like this given usage.
 
+    // the predecode cache holds the most common instruction forms with register numbers and immediates already extracted.
+    // anything else is cached as pdh_generic so run() just skips the fetch and uses the full decoder.
+
+    enum PredecodeHandler { pdh_generic = 0, pdh_add_imm64, pdh_add_imm32, pdh_subs_imm64, pdh_subs_imm32, pdh_add_reg64, pdh_sub_reg64,
+                            pdh_subs_reg64, pdh_subs_reg32, pdh_mov64, pdh_mov32, pdh_movz, pdh_b, pdh_bl, pdh_bcond, pdh_cbz64, pdh_cbnz64,
+                            pdh_cbz32, pdh_cbnz32, pdh_br, pdh_blr, pdh_ldr64, pdh_ldr32, pdh_ldr8, pdh_str64, pdh_str32, pdh_str8,
+                            pdh_ldp64, pdh_ldp64_pre, pdh_ldp64_post, pdh_stp64, pdh_stp64_pre, pdh_stp64_post, // m is Rt2
+                            pdh_mrs_clock, // imm is the clock for emulator_clock(), or -1 for cntvct_el0
+                            pdh_intercept, // imm is the routine passed to emulator_intercept(). always alone in its block
+
+                            // superinstructions. the first instruction of a fused sequence gets one of these handlers and
+                            // the following instructions stay in the block so cycles and the jit see every instruction.
+
+                            pdh_subs_imm64_bcond, pdh_subs_imm32_bcond, pdh_subs_reg64_bcond, pdh_subs_reg32_bcond,
+                            pdh_adrp_add, pdh_adrp_ldr64, pdh_adrp_ldr32, pdh_movz_movk, pdh_prologue, pdh_epilogue,
+                            pdh_first_fused = pdh_subs_imm64_bcond };
+
+    struct PredecodedOp
+    {
+        uint64_t pc;                // guest address of the instruction
+        uint32_t op;                // the raw opcode
+        uint8_t handler;            // PredecodeHandler
+        uint8_t d, n, m;            // register numbers (d is the condition for b.cond)
+        int64_t imm;                // immediate, already shifted / sign-extended / negated as needed
+    };
+
+    // predecoded instructions are grouped into basic blocks that end with a branch, svc, or system instruction.
+    // run() checks g_State and updates cycles once per block, and each block remembers the blocks that
+    // most recently followed it so the block table lookup is only needed for new or indirect targets.
+
+    struct BasicBlock
+    {
+        uint64_t pc;                // guest address of the first instruction
+        uint64_t next_pc[ 2 ];      // guest addresses of chained successor blocks. 0 if not yet chained
+        uint32_t next[ 2 ];         // indexes in blocks[] of the chained successors
+        uint32_t first;             // index in block_ops[] of the first instruction
+        uint32_t count;             // number of instructions in the block
+        uint32_t executions;        // times entered, until it reaches jit_threshold
+        uint64_t mix_executions;    // times entered while the instruction mix is enabled
+        uint64_t profile_executions; // times entered while the branch profile is enabled
+        uint64_t profile_next[ 2 ]; // times left for next_pc[] while the branch profile is enabled
+        Arm64JitFunction jitted;    // host code for the block or a prefix of it. 0 if not translated
+    };
+
+    static const uint32_t max_block_ops = 64;
+    static const uint32_t block_table_entries = 8192;    // direct-mapped on pc. must be a power of 2
+    static const uint32_t block_capacity = 16384;        // the whole cache is flushed when blocks or ops run out
+    static const uint32_t block_op_capacity = 131072;
+
+    BasicBlock * blocks;
+    PredecodedOp * block_ops;
+    uint32_t * block_table;         // 1 + index into blocks[]. 0 if empty
+    uint32_t block_count;
+    uint32_t block_op_count;
+    uint64_t pdc_lo, pdc_hi;        // bounds of guest addresses in blocks. pdc_hi == 0 when empty
+    bool code_modified;             // predecoded code was written; blocks are flushed at the next block boundary
+    bool code_rewritten;            // code_modified was set since enable_predecode(), so blocks may not match the image
+    bool predecode_enabled;
+    Arm64Jit * jit;                 // 0 unless the jit is enabled
+
+    static const uint32_t jit_threshold = 50;            // block executions before it's translated
+
+    friend class Arm64Jit;
+
+    uint64_t fused_counts[ fi_count ]; // executions of each superinstruction
+
+    // the instruction mix. predecoded blocks are counted as they're entered and folded into op_counts when the
+    // block cache is flushed or the mix is read, so the per-instruction cost is only paid without predecoding.
+
+    OpCounts * op_counts;           // raw opcode -> executions. 0 unless the instruction mix is enabled
+
+    EdgeCounts * profile_ranges;    // 0 unless the branch profile is enabled
+    EdgeCounts * profile_branches;
+
+    void fold_block_counts( void );
+    void profile_block_exit( BasicBlock & b );
+    void fold_profile_edge( BasicBlock & b, uint32_t slot );
+
+    struct TraceRecord
+    {
+        uint64_t pc;
+        uint32_t op;
+        uint8_t flags;              // nzcv before the instruction in bits 3..0
+        uint8_t changed;            // entries used in reg[] and old_value[]. ring_overflow if the instruction wrote more
+        uint8_t reg[ 3 ];
+        uint64_t old_value[ 3 ];    // the registers before the instruction, or after once a renderer has undone it
+    };
+
+    static const uint8_t ring_overflow = 0xff;
+
+    TraceRecord * ring;             // 0 unless the trace ring is enabled
+    uint64_t * ring_shadow;         // x0..x31 as of the start of the newest record
+    uint64_t ring_mask;
+    uint64_t ring_count;            // records ever written; the newest is ring[ ( ring_count - 1 ) & ring_mask ]
+    uint64_t ring_trigger;
+    const char * ring_path;
+
+    void record_instruction( void );
+    void finish_record( TraceRecord & r );
+
+    volatile bool end_requested;    // set by end_emulation(), possibly from another thread; checked at block boundaries
+    volatile bool sample_requested; // likewise for request_sample()
+    bool yield_requested;           // by yield_svc(), on the cpu's thread
+    uint64_t breakpoint;            // while non-zero, instructions run one at a time so the pc can be checked
+    uint64_t trace_lo;              // set_trace_filter(). trace_hi and trace_end are 0 when they don't apply
+    uint64_t trace_hi;
+    uint64_t trace_first;
+    uint64_t trace_end;
+
+    __inline_perf bool in_trace_filter( void ) const
+    {
+        return ( ( 0 == trace_hi ) || ( ( pc >= trace_lo ) && ( pc < trace_hi ) ) ) &&
+               ( cycles >= trace_first ) && ( ( 0 == trace_end ) || ( cycles < trace_end ) );
+    } //in_trace_filter
+    uint64_t * intercepts;          // set_intercepts() addresses sorted ascending, each followed by its routine number
+    uint32_t intercept_count;
+
+    // the exclusive monitor. ldxr remembers the address and the value it read, and stxr only stores if memory still
+    // holds that value, using a host compare-and-swap so guest threads running on host threads get atomic updates.
+
+    uint64_t exclusive_address;
+    uint64_t exclusive_value;
+    uint32_t exclusive_size;        // 0 when the monitor is clear
+
+    uint64_t load_exclusive( uint64_t address, uint32_t size );
+    bool store_exclusive( uint64_t address, uint64_t val, uint32_t size );
+    uint64_t atomic_op( uint64_t address, uint64_t operand, uint32_t size, uint32_t opc );
+    uint64_t compare_and_swap( uint64_t address, uint64_t expected, uint64_t desired, uint32_t size );
+    bool compare_and_swap_pair( uint64_t address, uint64_t expected[ 2 ], const uint64_t desired[ 2 ] );
+
+    void predecode( PredecodedOp & pd, uint64_t address );
+    void fuse_block( BasicBlock & b );
+    void flush_predecode( void );
+    BasicBlock * find_block( BasicBlock * prev );
+    BasicBlock * build_block( uint64_t address );
+
+    // run() alternates between two compilations of its loop. stepping runs one instruction at a time for tracing,
+    // the trace ring, breakpoints, and -c. the other runs only predecoded blocks, without those checks. each returns
+    // true when run() should return, and false when the other loop should take over
+
+    bool needs_stepping( void ) const;
+    void check_run_state( void );   // sanity checks of sp and pc in debug builds
+    template <bool stepping> bool run_loop( uint64_t budget_end, StopReason & reason );
+    bool find_intercept( uint64_t address, uint32_t & routine ) const;
+
     void unhandled( void );
 
     __inline_perf uint64_t opbits( uint64_t lowbit, uint64_t len ) const
@@ -203,12 +537,12 @@ struct Arm64
     uint32_t add_with_carry32( uint32_t x, uint32_t y, bool carry, bool setflags );
     uint64_t sub64( uint64_t x, uint64_t y, bool setflags );
     uint32_t sub32( uint32_t x, uint32_t y, bool setflags );
-    bool check_conditional( uint64_t cond ) const;
+    bool check_conditional( uint64_t cond );
     uint64_t shift_reg64( uint64_t reg, uint64_t shift_type, uint64_t amount );
     uint32_t shift_reg32( uint64_t reg, uint64_t shift_type, uint64_t amount );
     uint64_t extend_reg( uint64_t m, uint64_t extend_type, uint64_t shift, bool fullm = true );
     uint64_t val_reg_or_zr( uint64_t r ) const;
-    const char * render_flags() const;
+    const char * render_flags();
     template < typename T > ElementComparisonResult compare( T pl, T pr );
     ElementComparisonResult compare_vector_elements( uint8_t * pl, uint8_t * pr, uint64_t width, bool unsigned_compare );
     uint8_t * vreg_ptr( uint64_t reg, uint64_t offset ) { return offset + (uint8_t *) & ( vregs[ reg ] ); }
@@ -217,6 +551,18 @@ struct Arm64
     uint64_t replicate_bytes( uint64_t val, uint64_t byte_len );
     void set_flags_from_double( double result );
     void set_flags_from_nzcv( uint64_t nzcv );
+
+    // flag-setting adds and subtracts just record their inputs. fN, fZ, fC, and fV are computed from them when
+    // something reads the flags, since most compares are followed by another compare before a branch looks.
+
+    enum LazyFlags { lazy_none = 0, lazy_add64, lazy_add32 }; // lazy_none: fN, fZ, fC, and fV are current
+    uint8_t lazy_kind;
+    bool lazy_carry;
+    uint64_t lazy_x, lazy_y;
+
+    void compute_lazy_flags( void );
+    __inline_perf void materialize_flags( void ) { if ( lazy_none != lazy_kind ) compute_lazy_flags(); }
+    __inline_perf bool carry_flag( void ) { materialize_flags(); return fC; }
     int64_t double_to_fixed_int64( double d, uint64_t fracbits, FPRounding rounding );
     uint64_t double_to_fixed_uint64( double d, uint64_t fracbits, FPRounding rounding );
     uint32_t double_to_fixed_uint32( double d, uint64_t fracbits, FPRounding rounding );
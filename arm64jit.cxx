@@ -0,0 +1,433 @@
+/*
+    JIT tier for the Arm64 emulator.
+    Hot basic blocks found by Arm64::run() are translated here from their predecoded form to host machine code.
+    Generated functions take the Arm64 object and operate on its registers, flags, and memory directly.
+    Translation stops at the first instruction form that isn't supported and the interpreter picks up from there.
+    Register usage in generated AMD64 code: rbx = Arm64 *, rsi = membase, rax/rcx/rdx = scratch.
+*/
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+#include <djltrace.hxx>
+
+#include "arm64.hxx"
+#include "arm64jit.hxx"
+
+using namespace std;
+
+static const size_t jit_code_size = 16 * 1024 * 1024;
+
+// x64 register numbers
+
+static const uint8_t xRAX = 0;
+static const uint8_t xRCX = 1;
+static const uint8_t xRDX = 2;
+static const uint8_t xRSI = 6;
+
+template <class T> static uint32_t cpu_offset( Arm64 & cpu, T & member )
+{
+    return (uint32_t) ( (uint8_t *) & member - (uint8_t *) & cpu );
+} //cpu_offset
+
+Arm64Jit::Arm64Jit() : code( 0 ), code_size( 0 ), code_used( 0 ), p( 0 ), compiled( 0 )
+{
+#ifdef ARM64JIT_AMD64
+    #ifdef _WIN32
+        code = (uint8_t *) VirtualAlloc( 0, jit_code_size, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE );
+    #else
+        void * pv = mmap( 0, jit_code_size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+        code = ( MAP_FAILED == pv ) ? 0 : (uint8_t *) pv;
+    #endif
+
+    if ( 0 != code )
+        code_size = jit_code_size;
+    else
+        tracer.Trace( "unable to allocate executable memory for the jit; continuing without it\n" );
+#endif
+} //Arm64Jit
+
+Arm64Jit::~Arm64Jit()
+{
+    if ( 0 != code )
+    {
+    #ifdef _WIN32
+        VirtualFree( code, 0, MEM_RELEASE );
+    #else
+        munmap( code, code_size );
+    #endif
+    }
+} //~Arm64Jit
+
+bool Arm64Jit::is_supported()
+{
+#ifdef ARM64JIT_AMD64
+    return true;
+#else
+    return false;
+#endif
+} //is_supported
+
+void Arm64Jit::reset()
+{
+    code_used = 0;
+} //reset
+
+bool Arm64Jit::load( const uint8_t * pb, size_t len )
+{
+    if ( ( 0 == code ) || ( len > code_size ) )
+        return false;
+
+    memcpy( code, pb, len );
+    code_used = len;
+    return true;
+} //load
+
+void Arm64Jit::emit_rbx( uint8_t rex, uint8_t op0, uint8_t op1, uint8_t reg, uint32_t disp )
+{
+    if ( 0 != rex )
+        emit8( rex );
+    emit8( op0 );
+    if ( 0 != op1 )
+        emit8( op1 );
+    emit8( (uint8_t) ( 0x80 | ( reg << 3 ) | 3 ) ); // mod 10 = disp32, rm 011 = rbx
+    emit32( disp );
+} //emit_rbx
+
+void Arm64Jit::emit_imm64( uint8_t reg, uint64_t val )
+{
+    emit8( 0x48 );
+    emit8( (uint8_t) ( 0xb8 + reg ) );
+    emit64( val );
+} //emit_imm64
+
+void Arm64Jit::emit_set_pc( Arm64 & cpu, uint64_t address )
+{
+    emit_imm64( xRAX, address );
+    emit_rbx( 0x48, 0x89, 0, xRAX, cpu_offset( cpu, cpu.pc ) );          // mov [pc], rax
+} //emit_set_pc
+
+void Arm64Jit::emit_condition( Arm64 & cpu, uint64_t cond )
+{
+    static const uint8_t xor_ecx_1[] = { 0x83, 0xf1, 0x01 };
+    static const uint8_t and_eax_ecx[] = { 0x21, 0xc8 };
+    static const uint8_t sete_al[] = { 0x0f, 0x94, 0xc0 };
+    static const uint8_t xor_eax_1[] = { 0x83, 0xf0, 0x01 };
+
+    uint32_t oN = cpu_offset( cpu, cpu.fN );
+    uint32_t oZ = cpu_offset( cpu, cpu.fZ );
+    uint32_t oC = cpu_offset( cpu, cpu.fC );
+    uint32_t oV = cpu_offset( cpu, cpu.fV );
+
+    switch ( cond >> 1 )
+    {
+        case 0: { emit_rbx( 0, 0x0f, 0xb6, xRAX, oZ ); break; }       // movzx eax, byte [fZ]
+        case 1: { emit_rbx( 0, 0x0f, 0xb6, xRAX, oC ); break; }
+        case 2: { emit_rbx( 0, 0x0f, 0xb6, xRAX, oN ); break; }
+        case 3: { emit_rbx( 0, 0x0f, 0xb6, xRAX, oV ); break; }
+        case 4: // HI = C && !Z
+        {
+            emit_rbx( 0, 0x0f, 0xb6, xRAX, oC );
+            emit_rbx( 0, 0x0f, 0xb6, xRCX, oZ );
+            emit( xor_ecx_1, sizeof( xor_ecx_1 ) );
+            emit( and_eax_ecx, sizeof( and_eax_ecx ) );
+            break;
+        }
+        case 5: // GE = N == V
+        case 6: // GT = N == V && !Z
+        {
+            emit_rbx( 0, 0x0f, 0xb6, xRAX, oN );
+            emit_rbx( 0, 0x3a, 0, xRAX, oV );                            // cmp al, byte [fV]
+            emit( sete_al, sizeof( sete_al ) );
+            if ( 6 == ( cond >> 1 ) )
+            {
+                emit_rbx( 0, 0x0f, 0xb6, xRCX, oZ );
+                emit( xor_ecx_1, sizeof( xor_ecx_1 ) );
+                emit( and_eax_ecx, sizeof( and_eax_ecx ) );
+            }
+            break;
+        }
+        default: { assert( false ); }
+    }
+
+    if ( cond & 1 )
+        emit( xor_eax_1, sizeof( xor_eax_1 ) );
+} //emit_condition
+
+void Arm64Jit::emit_select_pc( Arm64 & cpu, bool jump_if_nonzero, uint64_t taken, uint64_t not_taken )
+{
+    // x64 flags are already set by a test instruction. mov doesn't change them
+
+    emit_imm64( xRCX, not_taken );
+    emit_imm64( xRDX, taken );
+    emit8( 0x48 );
+    emit8( 0x0f );
+    emit8( jump_if_nonzero ? 0x45 : 0x44 );                               // cmovnz / cmovz rcx, rdx
+    emit8( 0xca );
+    emit_rbx( 0x48, 0x89, 0, xRCX, cpu_offset( cpu, cpu.pc ) );          // mov [pc], rcx
+} //emit_select_pc
+
+void Arm64Jit::emit_code_write_check( Arm64 & cpu, uint32_t len )
+{
+    // same test as Arm64::check_code_write(): ( rdx < pdc_hi ) && ( ( rdx + len ) > pdc_lo ) means code was written
+
+    emit_rbx( 0x48, 0x3b, 0, xRDX, cpu_offset( cpu, cpu.pdc_hi ) );      // cmp rdx, [pdc_hi]
+    emit8( 0x73 );                                                        // jae skip
+    uint8_t * pjae = p;
+    emit8( 0 );
+    emit8( 0x48 );
+    emit8( 0x8d );
+    emit8( 0x4a );
+    emit8( (uint8_t) len );                                               // lea rcx, [rdx + len]
+    emit_rbx( 0x48, 0x3b, 0, xRCX, cpu_offset( cpu, cpu.pdc_lo ) );      // cmp rcx, [pdc_lo]
+    emit8( 0x76 );                                                        // jbe skip
+    uint8_t * pjbe = p;
+    emit8( 0 );
+    emit_rbx( 0, 0xc6, 0, 0, cpu_offset( cpu, cpu.code_modified ) );     // mov byte [code_modified], 1
+    emit8( 1 );
+    *pjae = (uint8_t) ( p - pjae - 1 );
+    *pjbe = (uint8_t) ( p - pjbe - 1 );
+} //emit_code_write_check
+
+Arm64JitFunction Arm64Jit::compile( Arm64 & cpu, uint32_t block )
+{
+#ifdef ARM64JIT_AMD64
+    Arm64::BasicBlock & b = cpu.blocks[ block ];
+    const size_t worst_case = 64 + ( b.count * 96 ); // no translated instruction needs close to 96 bytes
+    if ( ( 0 == code ) || ( ( code_used + worst_case ) > code_size ) )
+        return 0;
+
+    static const uint8_t prolog[] = { 0x53, 0x56,                        // push rbx, push rsi
+#ifdef _WIN32
+                                      0x48, 0x89, 0xcb };                // mov rbx, rcx
+#else
+                                      0x48, 0x89, 0xfb };                // mov rbx, rdi
+#endif
+    static const uint8_t epilog[] = { 0x5e, 0x5b, 0xc3 };                // pop rsi, pop rbx, ret
+    static const uint8_t test_rax[] = { 0x48, 0x85, 0xc0 };
+    static const uint8_t test_eax[] = { 0x85, 0xc0 };
+    static const uint8_t test_al[] = { 0x84, 0xc0 };
+
+    uint8_t * start = code + code_used;
+    p = start;
+    emit( prolog, sizeof( prolog ) );
+    emit_rbx( 0x48, 0x8b, 0, xRSI, cpu_offset( cpu, cpu.membase ) );     // mov rsi, [membase]
+
+    uint32_t oN = cpu_offset( cpu, cpu.fN );
+    uint32_t oZ = cpu_offset( cpu, cpu.fZ );
+    uint32_t oC = cpu_offset( cpu, cpu.fC );
+    uint32_t oV = cpu_offset( cpu, cpu.fV );
+    #define R( r ) cpu_offset( cpu, cpu.regs[ r ] )
+
+    uint32_t done = 0;
+    bool branched = false;
+
+    for ( ; done < b.count; done++ )
+    {
+        Arm64::PredecodedOp pd = cpu.block_ops[ b.first + done ];
+        if ( pd.handler >= Arm64::pdh_first_fused ) // superinstructions are translated one instruction at a time
+            cpu.predecode( pd, pd.pc );
+        bool translated = true;
+
+        switch ( pd.handler )
+        {
+            case Arm64::pdh_add_imm64:
+            case Arm64::pdh_add_imm32:
+            {
+                bool x = ( Arm64::pdh_add_imm64 == pd.handler );
+                emit_rbx( x ? 0x48 : 0, 0x8b, 0, xRAX, R( pd.n ) );      // mov rax/eax, [n]
+                if ( x )
+                    emit8( 0x48 );
+                emit8( 0x05 );                                            // add rax/eax, imm32
+                emit32( (uint32_t) pd.imm );
+                emit_rbx( 0x48, 0x89, 0, xRAX, R( pd.d ) );              // mov [d], rax. 32-bit ops zeroed the high half
+                break;
+            }
+            case Arm64::pdh_subs_imm64:
+            case Arm64::pdh_subs_imm32:
+            case Arm64::pdh_subs_reg64:
+            case Arm64::pdh_subs_reg32:
+            {
+                bool x = ( Arm64::pdh_subs_imm64 == pd.handler || Arm64::pdh_subs_reg64 == pd.handler );
+                emit_rbx( x ? 0x48 : 0, 0x8b, 0, xRAX, R( pd.n ) );
+                if ( Arm64::pdh_subs_imm64 == pd.handler || Arm64::pdh_subs_imm32 == pd.handler )
+                {
+                    if ( x )
+                        emit8( 0x48 );
+                    emit8( 0x2d );                                        // sub rax/eax, imm32
+                    emit32( (uint32_t) pd.imm );
+                }
+                else
+                    emit_rbx( x ? 0x48 : 0, 0x2b, 0, xRAX, R( pd.m ) );  // sub rax/eax, [m]
+
+                // the x64 flags match Arm's except for carry, which Arm defines as not borrow
+
+                emit_rbx( 0, 0x0f, 0x98, 0, oN );                         // sets [fN]
+                emit_rbx( 0, 0x0f, 0x94, 0, oZ );                         // sete [fZ]
+                emit_rbx( 0, 0x0f, 0x93, 0, oC );                         // setae [fC]
+                emit_rbx( 0, 0x0f, 0x90, 0, oV );                         // seto [fV]
+                if ( 31 != pd.d )
+                    emit_rbx( 0x48, 0x89, 0, xRAX, R( pd.d ) );
+                break;
+            }
+            case Arm64::pdh_add_reg64:
+            case Arm64::pdh_sub_reg64:
+            {
+                emit_rbx( 0x48, 0x8b, 0, xRAX, R( pd.n ) );
+                emit_rbx( 0x48, ( Arm64::pdh_add_reg64 == pd.handler ) ? 0x03 : 0x2b, 0, xRAX, R( pd.m ) );
+                emit_rbx( 0x48, 0x89, 0, xRAX, R( pd.d ) );
+                break;
+            }
+            case Arm64::pdh_mov64:
+            case Arm64::pdh_mov32:
+            {
+                emit_rbx( ( Arm64::pdh_mov64 == pd.handler ) ? 0x48 : 0, 0x8b, 0, xRAX, R( pd.m ) );
+                emit_rbx( 0x48, 0x89, 0, xRAX, R( pd.d ) );
+                break;
+            }
+            case Arm64::pdh_movz:
+            {
+                emit_imm64( xRAX, pd.imm );
+                emit_rbx( 0x48, 0x89, 0, xRAX, R( pd.d ) );
+                break;
+            }
+            case Arm64::pdh_b:
+            {
+                emit_set_pc( cpu, pd.pc + pd.imm );
+                branched = true;
+                break;
+            }
+            case Arm64::pdh_bl:
+            {
+                emit_imm64( xRAX, pd.pc + 4 );
+                emit_rbx( 0x48, 0x89, 0, xRAX, R( 30 ) );
+                emit_set_pc( cpu, pd.pc + pd.imm );
+                branched = true;
+                break;
+            }
+            case Arm64::pdh_bcond:
+            {
+                if ( pd.d >= 14 ) // always
+                    emit_set_pc( cpu, pd.pc + pd.imm );
+                else
+                {
+                    emit_condition( cpu, pd.d );
+                    emit( test_al, sizeof( test_al ) );
+                    emit_select_pc( cpu, true, pd.pc + pd.imm, pd.pc + 4 );
+                }
+                branched = true;
+                break;
+            }
+            case Arm64::pdh_cbz64:
+            case Arm64::pdh_cbnz64:
+            case Arm64::pdh_cbz32:
+            case Arm64::pdh_cbnz32:
+            {
+                bool x = ( Arm64::pdh_cbz64 == pd.handler || Arm64::pdh_cbnz64 == pd.handler );
+                emit_rbx( x ? 0x48 : 0, 0x8b, 0, xRAX, R( pd.d ) );
+                if ( x )
+                    emit( test_rax, sizeof( test_rax ) );
+                else
+                    emit( test_eax, sizeof( test_eax ) );
+                bool nonzero = ( Arm64::pdh_cbnz64 == pd.handler || Arm64::pdh_cbnz32 == pd.handler );
+                emit_select_pc( cpu, nonzero, pd.pc + pd.imm, pd.pc + 4 );
+                branched = true;
+                break;
+            }
+            case Arm64::pdh_br:
+            case Arm64::pdh_blr:
+            {
+                emit_rbx( 0x48, 0x8b, 0, xRAX, R( pd.n ) );
+                if ( Arm64::pdh_blr == pd.handler )
+                {
+                    emit_imm64( xRCX, pd.pc + 4 );
+                    emit_rbx( 0x48, 0x89, 0, xRCX, R( 30 ) );
+                }
+                emit_rbx( 0x48, 0x89, 0, xRAX, cpu_offset( cpu, cpu.pc ) );
+                branched = true;
+                break;
+            }
+            case Arm64::pdh_ldr64:
+            case Arm64::pdh_ldr32:
+            case Arm64::pdh_ldr8:
+            {
+                emit_rbx( 0x48, 0x8b, 0, xRAX, R( pd.n ) );
+                if ( Arm64::pdh_ldr64 == pd.handler )
+                {
+                    emit8( 0x48 );
+                    emit8( 0x8b );                                        // mov rax, [rsi + rax + disp32]
+                }
+                else if ( Arm64::pdh_ldr32 == pd.handler )
+                    emit8( 0x8b );                                        // mov eax, [rsi + rax + disp32]
+                else
+                {
+                    emit8( 0x0f );
+                    emit8( 0xb6 );                                        // movzx eax, byte [rsi + rax + disp32]
+                }
+                emit8( 0x84 );
+                emit8( 0x06 );
+                emit32( (uint32_t) pd.imm );
+                emit_rbx( 0x48, 0x89, 0, xRAX, R( pd.d ) );
+                break;
+            }
+            case Arm64::pdh_str64:
+            case Arm64::pdh_str32:
+            case Arm64::pdh_str8:
+            {
+                uint32_t len = ( Arm64::pdh_str64 == pd.handler ) ? 8 : ( Arm64::pdh_str32 == pd.handler ) ? 4 : 1;
+                emit_rbx( 0x48, 0x8b, 0, xRAX, R( pd.n ) );
+                emit8( 0x48 );
+                emit8( 0x8d );
+                emit8( 0x90 );                                            // lea rdx, [rax + disp32]
+                emit32( (uint32_t) pd.imm );
+                emit_code_write_check( cpu, len );
+                emit_rbx( 0x48, 0x8b, 0, xRAX, R( pd.d ) );
+                if ( 8 == len )
+                {
+                    emit8( 0x48 );
+                    emit8( 0x89 );                                        // mov [rsi + rdx], rax
+                }
+                else
+                    emit8( ( 4 == len ) ? 0x89 : 0x88 );                  // mov [rsi + rdx], eax / al
+                emit8( 0x04 );
+                emit8( 0x16 );
+                break;
+            }
+            default:
+            {
+                translated = false;
+                break;
+            }
+        }
+
+        if ( !translated )
+            break;
+    }
+
+    #undef R
+
+    if ( 0 == done )
+        return 0;
+
+    if ( !branched )
+        emit_set_pc( cpu, b.pc + ( 4 * done ) );
+
+    emit8( 0xb8 );                                                        // mov eax, done
+    emit32( done );
+    emit( epilog, sizeof( epilog ) );
+
+    assert( (size_t) ( p - start ) <= worst_case );
+    code_used += ( p - start );
+    compiled++;
+    tracer.Trace( "jit translated %u of %u instructions of the block at %llx into %u bytes\n", done, b.count, b.pc, (uint32_t) ( p - start ) );
+
+    return (Arm64JitFunction) start;
+#else
+    return 0;
+#endif
+} //compile
@@ -0,0 +1,50 @@
+#pragma once
+
+// Optional JIT tier for the Arm64 emulator. Basic blocks that run often are translated to host machine code.
+// The translation covers the predecoded instruction forms; a block is translated up to its first instruction that
+// isn't covered and the interpreter resumes there. Only AMD64 hosts generate code for now. On other hosts
+// is_supported() returns false and the interpreter runs everything.
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined( __x86_64__ ) || defined( _M_X64 )
+    #define ARM64JIT_AMD64
+#endif
+
+struct Arm64;
+
+typedef uint32_t ( * Arm64JitFunction )( Arm64 * cpu ); // returns the count of block instructions executed. pc is updated
+
+class Arm64Jit
+{
+    public:
+        Arm64Jit();
+        ~Arm64Jit();
+
+        static bool is_supported( void );
+        Arm64JitFunction compile( Arm64 & cpu, uint32_t block );  // returns 0 if nothing in the block could be translated
+        void reset( void );                                        // discard all generated code
+        uint64_t blocks_compiled( void ) const { return compiled; }
+        const uint8_t * code_base( void ) const { return code; }
+        size_t code_bytes( void ) const { return code_used; }      // generated so far, from code_base()
+        bool load( const uint8_t * pb, size_t len );               // replace all generated code with code from code_bytes()
+
+    private:
+        uint8_t * code;          // executable memory
+        size_t code_size;
+        size_t code_used;
+        uint8_t * p;             // where the next byte is emitted
+        uint64_t compiled;
+
+        void emit8( uint8_t b ) { *p++ = b; }
+        void emit32( uint32_t v ) { memcpy( p, &v, 4 ); p += 4; }
+        void emit64( uint64_t v ) { memcpy( p, &v, 8 ); p += 8; }
+        void emit( const uint8_t * pb, size_t len ) { memcpy( p, pb, len ); p += len; }
+        void emit_rbx( uint8_t rex, uint8_t op0, uint8_t op1, uint8_t reg, uint32_t disp ); // <op> reg, [rbx + disp32]
+        void emit_imm64( uint8_t reg, uint64_t val );                                      // mov reg, imm64
+        void emit_set_pc( Arm64 & cpu, uint64_t address );
+        void emit_condition( Arm64 & cpu, uint64_t cond );                                 // al = 1 if cond passes else 0
+        void emit_select_pc( Arm64 & cpu, bool jump_if_nonzero, uint64_t taken, uint64_t not_taken );
+        void emit_code_write_check( Arm64 & cpu, uint32_t len );                           // rdx is the guest address
+}; //Arm64Jit
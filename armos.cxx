@@ -37,6 +37,8 @@
 #include <ctype.h>
 #include <errno.h>
 #include <vector>
+#include <map>
+#include <algorithm>
 #include <chrono>
 #include <locale.h>
 #include <cstddef>
@@ -46,6 +48,7 @@
 
 #ifdef _WIN32
     #include <io.h>
+    #include <sys/utime.h>
 
     struct iovec
     {
@@ -67,6 +70,21 @@
 
 #else
     #include <unistd.h>
+    #include <signal.h>
+    #include <utime.h>
+
+    #ifdef ARMOS
+        #include <sys/socket.h>
+        #include <sys/un.h>
+        #include <sys/wait.h>
+        #include <poll.h>
+
+        #if defined( __linux__ ) && defined( __LP64__ ) && ( __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ )
+            #define ARMOS_HOST_SOCKETS // the host's socket structures and constants match Arm64 Linux's
+            #include <sys/epoll.h>
+            #include <sys/sendfile.h>
+        #endif
+    #endif
 
     #ifndef OLDGCC      // the several-years-old Gnu C compilers for the RISC-V development boards
 #ifndef __mc68000__
@@ -100,18 +118,30 @@
 #include <djltrace.hxx>
 #include <djl_con.hxx>
 #include <djl_mmap.hxx>
+#include <djl_vmem.hxx>
+#include <djl_hash.hxx>
 
 using namespace std;
 using namespace std::chrono;
 
 #ifdef ARMOS
 
+    #include <thread>
+    #include <mutex>
+    #include <condition_variable>
+    #include <atomic>
+    #include <setjmp.h>
     #include "arm64.hxx"
+    #include "armos_embed.hxx"
 
     #define CPUClass Arm64
     #define ELF_MACHINE_ISA 0xb7
     #define APP_NAME "ARMOS"
     #define LOGFILE_NAME "armos.log"
+    #define PROFILE_NAME "armos.prof"
+    #define FOLDED_NAME "armos.folded"
+    #define HEAT_NAME "armos.heat"
+    #define RING_NAME "armos.ring"
     #define REG_FORMAT "%lld"
     #define REG_TYPE uint64_t
     #define SIGNED_REG_TYPE int64_t
@@ -259,32 +289,14 @@ using namespace std::chrono;
 
 CDJLTrace tracer;
 ConsoleConfiguration g_consoleConfig;
-bool g_compressed_rvc = false;                 // is the app compressed risc-v?
 const REG_TYPE g_arg_data_commit = 1024;       // storage spot for command-line arguments and environment variables
-REG_TYPE g_stack_commit = 128 * 1024;          // RAM to allocate for the fixed stack. the top of this has argv data
-
-REG_TYPE g_brk_commit = 40 * 1024 * 1024;      // RAM to reserve if the app calls brk to allocate space. 40 meg default
-REG_TYPE g_mmap_commit = 40 * 1024 * 1024;     // RAM to reserve if the app calls mmap to allocate space. 40 meg default
-
-bool g_terminate = false;                      // has the app asked to shut down?
-int g_exit_code = 0;                           // exit code of the app in the vm
-vector<uint8_t> memory;                        // RAM for the vm
-REG_TYPE g_base_address = 0;                   // vm address of start of memory
-REG_TYPE g_execution_address = 0;              // where the program counter starts
-REG_TYPE g_brk_offset = 0;                     // offset of brk, initially g_end_of_data
-REG_TYPE g_mmap_offset = 0;                    // offset of where mmap allocations start
-REG_TYPE g_highwater_brk = 0;                  // highest brk seen during app; peak dynamically-allocated RAM
-REG_TYPE g_end_of_data = 0;                    // official end of the loaded app
-REG_TYPE g_bottom_of_stack = 0;                // just beyond where brk might move
-REG_TYPE g_top_of_stack = 0;                   // argc, argv, penv, aux records sit above this
-CMMap g_mmap;                                  // for mmap and munmap system calls
 bool g_hostIsLittleEndian = true;              // is the host little endian?
 bool g_addCRBeforeLF = false;                  // on Windows, a command-line argument can make this true
 
 // fake descriptors.
 // /etc/timezone is not implemented, so apps running in the emulator on Windows assume UTC
 
-const uint64_t findFirstDescriptor = 3000;
+const uint64_t findFirstDescriptor = 4000; // and up, one per directory a Windows host app has open
 const uint64_t timebaseFrequencyDescriptor = 3001;
 const uint64_t osreleaseDescriptor = 3002;
 
@@ -826,8 +838,267 @@ struct ElfSectionHeader32
 
 #pragma pack(pop)
 
+// the state of one emulated Linux process. main() runs one. with the embedding API in armos_embed.hxx there can be
+// many, each run by its own host threads. g_process is the one the current host thread is running, and the emulator
+// reaches process state through it.
+
+#if !defined( OLDGCC ) && !defined( __mc68000__ )
+
+// file-backed mmap regions. where the host can map the file straight into guest memory, only the range is kept so
+// munmap can put anonymous memory back. otherwise the file's data is copied in, and MAP_SHARED writes are copied
+// back to the file by msync, munmap, and at exit.
+
+struct FileMapping
+{
+    REG_TYPE length;
+    uint64_t file_offset;
+    int fd;                  // a dup of the app's descriptor for copying back MAP_SHARED data, otherwise -1
+    bool host_mapped;
+};
+
+#endif
+
+// per-syscall latency and byte counts for -p. nothing is timed unless -p is set. ARMOS threads update the table
+// while holding syscall_mutex.
+
+struct SyscallStats
+{
+    uint64_t calls;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint64_t bytes;
+    uint64_t cache_hits;           // answered by -statcache
+};
+
+#if !defined( OLDGCC ) && !defined( __mc68000__ )
+
+// -statcache keeps the results of path-based newfstatat, statx, and faccessat calls for a short time, since runtimes
+// and build tools ask about the same paths over and over. the app's own syscalls that change metadata clear it
+
+struct StatCacheEntry
+{
+    steady_clock::time_point expires;
+    int result;                    // 0 or -1
+    int error;                     // errno when result is -1
+#ifdef _WIN32
+    struct stat_linux_syscall st;
+#else
+    struct stat st;
+#endif
+};
+
+#endif
+
+#if defined( ARMOS ) && !defined( _WIN32 )
+
+struct MappedFileRange
+{
+    void * base;            // page-aligned start of the host mapping
+    size_t length;          // of the host mapping
+    const uint8_t * data;   // the requested file offset
+    size_t size;            // the requested length
+};
+
+#endif
+
+#if defined( _WIN32 ) || !defined( OLDGCC )
+
+// a directory the app is enumerating with getdents, per descriptor so enumerations can nest. an entry read from the
+// host that didn't fit in the app's buffer is kept for the next call
+
+struct DirEnumeration
+{
+#ifdef _WIN32
+    HANDLE find;                   // INVALID_HANDLE_VALUE until the first getdents
+    string pattern;                // path\*.*
+#else
+    DIR * dir;                     // from fdopendir on the first getdents
+#endif
+    uint64_t position;             // entries returned so far; each entry's d_off is its successor's position
+    bool pending;                  // name and type hold an entry not yet returned
+    bool done;
+    uint8_t type;                  // DT_*
+    string name;
+
+#ifdef _WIN32
+    DirEnumeration() : find( INVALID_HANDLE_VALUE ), position( 0 ), pending( false ), done( false ), type( 0 ) {}
+#else
+    DirEnumeration() : dir( 0 ), position( 0 ), pending( false ), done( false ), type( 0 ) {}
+#endif
+};
+
+#endif
+
+#ifdef ARMOS
+struct FutexWaiter;
+#endif
+
+#ifdef ARMOS
+// guest RAM is committed as brk and mmap grow into it, so on 64-bit hosts the reservations can be generous
+static const uint64_t g_default_brk_reservation = ( sizeof( void * ) >= 8 ) ? ( 4ull << 30 ) : ( 40 * 1024 * 1024 );
+static const uint64_t g_default_mmap_reservation = ( sizeof( void * ) >= 8 ) ? ( 16ull << 30 ) : ( 40 * 1024 * 1024 );
+static const uint64_t g_max_reservation_megs = ( sizeof( void * ) >= 8 ) ? ( 256 * 1024 ) : 1024;
+#else
+static const REG_TYPE g_default_brk_reservation = 40 * 1024 * 1024;
+static const REG_TYPE g_default_mmap_reservation = 40 * 1024 * 1024;
+static const REG_TYPE g_max_reservation_megs = 1024;
+#endif
+
+struct EmulatedProcess
+{
+    REG_TYPE stack_commit;         // RAM to allocate for the fixed stack. the top of this has argv data
+    REG_TYPE brk_commit;           // RAM to reserve if the app calls brk to allocate space
+    REG_TYPE mmap_commit;          // RAM to reserve if the app calls mmap to allocate space
+    bool terminate;                // has the app asked to shut down?
+    int exit_code;                 // exit code of the app in the vm
+#ifdef ARMOS
+    CVirtualMemory vm_memory;      // RAM for the vm, surrounded by guard pages
+#else
+    vector<uint8_t> vm_memory;     // RAM for the vm
+#endif
+    REG_TYPE base_address;         // vm address of start of memory
+    REG_TYPE execution_address;    // where the program counter starts
+    REG_TYPE brk_offset;           // offset of brk, initially end_of_data
+    REG_TYPE mmap_offset;          // offset of where mmap allocations start
+    REG_TYPE highwater_brk;        // highest brk seen during app; peak dynamically-allocated RAM
+    REG_TYPE end_of_data;          // official end of the loaded app
+    REG_TYPE bottom_of_stack;      // just beyond where brk might move
+    REG_TYPE top_of_stack;         // argc, argv, penv, aux records sit above this
+    REG_TYPE arg_data_offset;      // where load_image put the argument and environment strings
+    high_resolution_clock::time_point app_start; // for the process cpu time clocks
+    CMMap mmap_arena;              // for mmap and munmap system calls
+    bool compressed_rvc;           // is the app compressed risc-v?
+    struct linux_user_desc user_desc;
+    vector<char> string_table;     // strings in the elf image
+    vector<ElfSymbol64> symbols;   // symbols in the elf image
+    vector<ElfSymbol32> symbols32; // symbols in the elf image
+    map<uint32_t, SyscallStats> syscall_stats;
+#if !defined( OLDGCC ) && !defined( __mc68000__ )
+    map<REG_TYPE, FileMapping> file_mappings; // guest address -> mapping
+#endif
+#if defined( _WIN32 ) || !defined( OLDGCC )
+    map<REG_TYPE, DirEnumeration> dir_enumerations; // descriptor -> enumeration
+#endif
+#if !defined( OLDGCC ) && !defined( __mc68000__ )
+    map<string, StatCacheEntry> stat_cache; // see stat_cache_key()
+    bool stat_cache_hit;           // the current syscall was answered from stat_cache, for -p
+#endif
+#ifdef ARMOS
+    vector<string> app_env;        // environment variables load_image adds after OS=
+    mutex syscall_mutex;
+    mutex thread_mutex;            // for threads, live_threads, and main_cpu
+    condition_variable thread_exited;
+    vector<CPUClass *> threads;    // cpus of running threads other than main
+    uint32_t live_threads;         // threads other than main whose host thread hasn't finished
+    CPUClass * main_cpu;
+    atomic<uint32_t> next_tid;     // the main thread is tid 1
+    atomic<uint64_t> thread_instructions; // executed by threads other than main, for -p
+    atomic<uint64_t> syscall_count; // made by all threads, for emulator_counter()
+    mutex futex_mutex;
+    multimap<uint64_t, FutexWaiter *> futex_waiters;
+    bool embedded;                 // run by an ArmosGuest, so faults return to it rather than ending the host process
+    ArmosGuest::SyscallHook syscall_hook; // embedders can handle syscalls before the emulator does
+    void * syscall_hook_context;
+    string fault;                  // why an embedded app was stopped
+    uint64_t image_hash;           // of the PT_LOAD segments, for -cache
+    uint64_t image_end;            // guest address just past the last PT_LOAD segment's file data
+    uint64_t code_start;           // bounds of the executable PT_LOAD segments, for -aot
+    uint64_t code_end;
+    uint64_t vdso_address;         // guest address of the vdso page. see build_vdso()
+    string exec_path;              // set by execve of an Arm64 image, which main loads once the cpu stops
+    vector<string> exec_argv;
+    vector<string> exec_env;
+#endif
+#if defined( ARMOS ) && !defined( _WIN32 )
+    MappedFileRange symbol_view;   // see ensure_symbols()
+    MappedFileRange string_view;
+    uint64_t symbols_image_end;
+    atomic<bool> symbols_pending;
+    mutex symbols_mutex;
+#endif
+
+    EmulatedProcess() : stack_commit( 128 * 1024 ), brk_commit( g_default_brk_reservation ), mmap_commit( g_default_mmap_reservation ),
+                        terminate( false ), exit_code( 0 ), base_address( 0 ), execution_address( 0 ), brk_offset( 0 ),
+                        mmap_offset( 0 ), highwater_brk( 0 ), end_of_data( 0 ), bottom_of_stack( 0 ), top_of_stack( 0 ),
+                        arg_data_offset( 0 ), compressed_rvc( false )
+#if !defined( OLDGCC ) && !defined( __mc68000__ )
+                        , stat_cache_hit( false )
+#endif
+#ifdef ARMOS
+                        , live_threads( 0 ), main_cpu( 0 ), next_tid( 2 ), thread_instructions( 0 ), syscall_count( 0 ), embedded( false ),
+                        syscall_hook( 0 ), syscall_hook_context( 0 ), image_hash( 0 ), image_end( 0 ),
+                        code_start( 0 ), code_end( 0 ), vdso_address( 0 )
+#endif
+#if defined( ARMOS ) && !defined( _WIN32 )
+                        , symbols_image_end( 0 ), symbols_pending( false )
+#endif
+    {
+        memset( &user_desc, 0, sizeof( user_desc ) );
+#if defined( ARMOS ) && !defined( _WIN32 )
+        memset( &symbol_view, 0, sizeof( symbol_view ) );
+        memset( &string_view, 0, sizeof( string_view ) );
+#endif
+    }
+};
+
+static EmulatedProcess g_main_process;
+#ifdef ARMOS
+static thread_local EmulatedProcess * g_process = &g_main_process;
+#else
+static EmulatedProcess * g_process = &g_main_process;
+#endif
+
+#ifdef ARMOS
+static bool g_large_pages = false;          // -largepages: ask for 2MB host pages for guest RAM
+#endif
+
+#ifdef ARMOS
+#endif
+#if defined( ARMOS ) && !defined( _WIN32 )
+#endif
+
+#ifdef ARMOS
+
+// for an embedded app, what would end the host process instead jumps back to the ArmosGuest running it on this host
+// thread, with the reason in its fault. a syscall that fails this way can't unwind, so its lock is released here
+
+#ifdef _WIN32
+    typedef jmp_buf FaultJump;
+    #define FAULT_SETJMP( j ) setjmp( j )
+    #define FAULT_LONGJMP( j ) longjmp( j, 1 )
+#else
+    typedef sigjmp_buf FaultJump;
+    #define FAULT_SETJMP( j ) sigsetjmp( j, 1 )
+    #define FAULT_LONGJMP( j ) siglongjmp( j, 1 )
+#endif
+
+typedef unique_lock<mutex> SyscallLock;              // syscall_mutex, held while a syscall runs
+
+static thread_local FaultJump * g_fault_jump = 0;
+static thread_local SyscallLock * g_held_syscall_lock = 0; // set while emulator_invoke_svc runs
+
+static void embedded_fault( const char * pmessage )
+{
+    if ( !g_process->embedded || ( 0 == g_fault_jump ) )
+        return;
+
+    tracer.Trace( "embedded app fault: %s\n", pmessage );
+    if ( g_process->fault.empty() ) // the first fault is the interesting one
+        g_process->fault = pmessage;
+    if ( ( 0 != g_held_syscall_lock ) && g_held_syscall_lock->owns_lock() )
+        g_held_syscall_lock->unlock();
+    g_held_syscall_lock = 0;
+    FAULT_LONGJMP( * g_fault_jump );
+} //embedded_fault
+
+#endif
+
 static void usage( char const * perror = 0 )
 {
+#ifdef ARMOS
+    embedded_fault( ( 0 != perror ) ? perror : "the app can't be loaded" );
+#endif
+
     g_consoleConfig.RestoreConsole( false );
 
     if ( 0 != perror )
@@ -835,19 +1106,68 @@ static void usage( char const * perror = 0 )
 
     printf( "usage: %s <%s arguments> <executable> <app arguments>\n", APP_NAME, APP_NAME );
     printf( "   arguments:    -e     just show information about the elf executable; don't actually run it\n" );
+#ifdef ARMOS
+    printf( "                 -aot:F translate the app's code to host instructions in F for -j:F, then exit (AMD64 hosts only)\n" );
+    printf( "                 -c     don't cache predecoded instructions (slower; for debugging the emulator)\n" );
+    printf( "                 -cache:D[,M] keep predecoded instructions in directory D between runs. M MB at most; default 64\n" );
+    printf( "                 -csim[:S] model an L1D, L2, and TLB; show miss rates per function and write %s at exit\n", HEAT_NAME );
+    printf( "                        S is L1 KB,L1 ways,L2 KB,L2 ways,TLB entries. default 64,4,1024,8,48\n" );
+    printf( "                 -d:F   render trace ring file F written by -r to %s as -t -i text. the app supplies symbols\n", LOGFILE_NAME );
+    printf( "                 -f     run memcpy, memmove, memset, memcmp, strlen, and strchr as host code. not with -c or -i\n" );
+    printf( "                 -fdo:F write block and branch counts to F for AutoFDO's create_gcov and create_llvm_prof\n" );
+#endif
 #ifdef RVOS
     printf( "                 -g     (internal) generate rcvtable.txt then exit\n" );
 #endif
-    printf( "                 -h:X   # of meg for the heap (brk space). 0..1024 are valid. default is 40\n" );
+    printf( "                 -h:X   # of meg for the heap (brk space). 0..%llu are valid. default is %llu\n",
+            (unsigned long long) g_max_reservation_megs, (unsigned long long) ( g_default_brk_reservation / ( 1024 * 1024 ) ) );
     printf( "                 -i     if -t is set, also enables instruction tracing with symbols\n" );
+#ifdef ARMOS
+    printf( "                 -j     translate hot code to host instructions (AMD64 hosts only)\n" );
+    printf( "                 -j:F   like -j, starting with the translations in F written by -aot\n" );
+#endif
 #ifdef _WIN32
     printf( "                 -l     when a LF (10) is output, allow Windows to add a CR (13) beforehand\n" );
 #endif
-    printf( "                 -m:X   # of meg for mmap space. 0..1024 are valid. default is 40.\n" );
+#ifdef ARMOS
+    printf( "                 -largepages  back guest RAM with 2MB host pages where the host allows. -p shows how much\n" );
+#endif
+    printf( "                 -m:X   # of meg for mmap space. 0..%llu are valid. default is %llu\n",
+            (unsigned long long) g_max_reservation_megs, (unsigned long long) ( g_default_mmap_reservation / ( 1024 * 1024 ) ) );
     printf( "                 -p     shows performance information at app exit\n" );
+    printf( "                 -p:json  like -p, but as one line of JSON for benchmark scripts\n" );
+#ifdef ARMOS
+    printf( "                 -P:X   sample the guest pc X times per second; write %s and %s at exit\n", PROFILE_NAME, FOLDED_NAME );
+#endif
+#ifdef ARMOS
+    printf( "                 -r:X[,T] keep a binary trace of the last X instructions; write %s on a crash or when T runs\n", RING_NAME );
+    printf( "                        T is a hex address (0x...) or a symbol. instructions run one at a time like -c\n" );
+#endif
+#ifdef ARMOS
+    printf( "                 -record:F log every syscall's result and output buffers to F for -replay\n" );
+    printf( "                 -replay:F answer the app's syscalls from log F written by -record, without host I/O\n" );
+    printf( "                 -restore:F resume snapshot F written by -snap, passing the app's arguments anew. the count must match\n" );
+#endif
     printf( "                 -s:X   # of KB for stack space. 1..1024 are valid. default is 128.\n" );
+#if defined( ARMOS ) && !defined( _WIN32 )
+    printf( "                 -serve:S run jobs sent to unix socket S, each in a forked copy of %s. see README.md\n", APP_NAME );
+    printf( "                        with an app, the app runs to its emulator_sys_snapshot syscall and jobs continue from there\n" );
+#endif
+#ifdef ARMOS
+    printf( "                 -snap:F[,T] write snapshot F when the app makes the emulator_sys_snapshot (0x2013) syscall\n" );
+    printf( "                        or when T runs. T is a hex address (0x...) or a symbol. single-threaded apps only\n" );
+#endif
+    printf( "                 -statcache[:X] keep newfstatat, statx, and faccessat results for X ms. default 500\n" );
     printf( "                 -t     enable debug tracing to %s\n", LOGFILE_NAME );
+    printf( "                 -t:a   like -t, but buffered and written by a background thread\n" );
+#ifdef ARMOS
+    printf( "                 -tf:F  like -t -i, but trace instructions only where filter F matches. F is a comma-separated\n" );
+    printf( "                        list of sym=name, pc=lo-hi (hex), after=N instructions, and count=M instructions\n" );
+#endif
     printf( "                 -v     used with -e shows verbose information (e.g. symbols)\n" );
+#ifdef ARMOS
+    printf( "                 -x     shows the mix of executed instructions by mnemonic at app exit\n" );
+#endif
     printf( "  %s\n", build_string() );
     exit( 1 );
 } //usage
@@ -946,25 +1266,25 @@ class SetBinaryMode
   0x8000    O_BINARY
   0x10000                   O_DIRECTORY                 O_DIRECT                         O_DIRECTORY
   0x10100                   O_SYNC                      O_SYNC
-  0x80000                                                                    O_DIRECT                 O_DIRECT
+  0x80000                   O_CLOEXEC                   O_CLOEXEC            O_DIRECT                 O_DIRECT
   0x100000                                                                   O_DIRECTORY O_DIRECT
   0x200000                                                                                            O_DIRECTORY
   0x2010000                                                                              O_TMPFILE
 */
 
 enum em_platform { dos_win = 0, linux_rv64_amd64_x32, linux_arm, macos, linux_sparc, newlib_68k };
-enum open_flags { o_append = 0, o_creat, o_trunc, o_excl, o_direct, o_directory, o_async, o_sync };
-
-static const int flagmap[ 6 ][ 8 ] =
-{
-    //0          1         2         3        4          5            6        7
-    //O_APPEND   O_CREAT   O_TRUNC   O_EXCL   O_DIRECT   O_DIRECTORY  O_ASYNC  O_SYNC
-    { 0x8,       0x100,    0x200,    0x400,   0,         0,           0,       0 },                  // DOS + Windows
-    { 0x400,     0x40,     0x200,    0x80,    0x4000,    0x10000,     0x2000,  0x10100 },            // Linux on RISC-V64, AMD64, X32
-    { 0x400,     0x40,     0x200,    0x80,    0x10000,   0x4000,      0x2000,  0x10100 },            // Linux on ARM32 and ARM64
-    { 0x8,       0x200,    0x400,    0x800,   0x80000,   0x100000,    0,       0x2000 },             // macOS
-    { 0x8,       0x200,    0x400,    0x800,   0x100000,  0x10000,     0x40,    0x2000 },             // Linux on Sparc
-    { 0x8,       0x200,    0x400,    0x800,   0x80000,   0x200000,    0,       0x2000 }              // Newlib on 68000
+enum open_flags { o_append = 0, o_creat, o_trunc, o_excl, o_direct, o_directory, o_async, o_sync, o_cloexec };
+
+static const int flagmap[ 6 ][ 9 ] =
+{
+    //0          1         2         3        4          5            6        7        8
+    //O_APPEND   O_CREAT   O_TRUNC   O_EXCL   O_DIRECT   O_DIRECTORY  O_ASYNC  O_SYNC   O_CLOEXEC
+    { 0x8,       0x100,    0x200,    0x400,   0,         0,           0,       0,       0x80 },      // DOS + Windows
+    { 0x400,     0x40,     0x200,    0x80,    0x4000,    0x10000,     0x2000,  0x10100, 0x80000 },   // Linux on RISC-V64, AMD64, X32
+    { 0x400,     0x40,     0x200,    0x80,    0x10000,   0x4000,      0x2000,  0x10100, 0x80000 },   // Linux on ARM32 and ARM64
+    { 0x8,       0x200,    0x400,    0x800,   0x80000,   0x100000,    0,       0x2000,  0x1000000 }, // macOS
+    { 0x8,       0x200,    0x400,    0x800,   0x100000,  0x10000,     0x40,    0x2000,  0x400000 },  // Linux on Sparc
+    { 0x8,       0x200,    0x400,    0x800,   0x80000,   0x200000,    0,       0x2000,  0x40000 }    // Newlib on 68000
 };
 
 em_platform build_target_platform()
@@ -1043,39 +1363,136 @@ int translate_open_flags( int f )
     return result;
 } //translate_open_flags
 
+#if defined( ARMOS ) && !defined( _WIN32 )
+
+// the file status flags fcntl's F_GETFL and F_SETFL see, as Linux on Arm64 numbers them and as the host does. the
+// access mode is the low 2 bits everywhere
+
+static const int status_flag_map[][ 2 ] =
+{
+    { 0x400, O_APPEND },
+    { 0x800, O_NONBLOCK },
+    { 0x2000, O_ASYNC },
+#ifdef O_DIRECT
+    { 0x10000, O_DIRECT },
+#endif
+#ifdef O_NOATIME
+    { 0x40000, O_NOATIME },
+#endif
+    { 0x1000, O_DSYNC },
+};
+
+static int translate_status_flags( int f, bool to_host )
+{
+    int from = to_host ? 0 : 1;
+    int result = ( f & 3 );
+    for ( size_t i = 0; i < _countof( status_flag_map ); i++ )
+        if ( f & status_flag_map[ i ][ from ] )
+            result |= status_flag_map[ i ][ !from ];
+    return result;
+} //translate_status_flags
+
+#endif
+
 #ifdef _WIN32
 
-size_t WinWrite( int descriptor, uint8_t * p, int count )
+// guest stdout and stderr. each guest write becomes one host write: UTF-8 is converted to UTF-16 for WriteConsoleW
+// when the descriptor is a console, and other handles get the bytes as-is with WriteFile. neither goes through the
+// C runtime's text mode, so LF isn't turned into CR LF unless -l asks for it. callers are serialized by the syscall
+// lock or are single-threaded
+
+struct ConsoleWriter
+{
+    HANDLE handle;                 // the handle is_console was found for
+    bool is_console;
+    uint8_t partial[ 4 ];          // the start of a UTF-8 sequence the previous write split
+    int partial_count;
+    vector<uint8_t> bytes;
+    vector<wchar_t> wide;
+
+    ConsoleWriter() : handle( INVALID_HANDLE_VALUE ), is_console( false ), partial_count( 0 ) {}
+};
+
+static ConsoleWriter g_console_writers[ 2 ]; // stdout, stderr
+
+static int utf8_incomplete_tail( const uint8_t * p, int count )
+{
+    // how many bytes at the end of p begin a sequence that continues in the next write
+
+    for ( int back = 1; back <= 3 && back <= count; back++ )
+    {
+        uint8_t b = p[ count - back ];
+        if ( 0x80 == ( b & 0xc0 ) ) // continuation byte; keep looking for the lead
+            continue;
+
+        int length = ( 0xc0 == ( b & 0xe0 ) ) ? 2 : ( 0xe0 == ( b & 0xf0 ) ) ? 3 : ( 0xf0 == ( b & 0xf8 ) ) ? 4 : 1;
+        return ( length > back ) ? back : 0;
+    }
+    return 0;
+} //utf8_incomplete_tail
+
+size_t WinWrite( int descriptor, const uint8_t * p, int count )
 {
-    // When in text mode, Windows converts 10 to 13 10 (CR + LF). In binary mode, it doesn't.
-    // When in text mode, Windows handles UTF-8 characters properly. In binary mode, it doesn't.
-    // We don't want it to add the CR here because well-behaved DOS and CP/M apps will already have done that and Linux and Apple I apps don't need it.
-    // We can't stay in Binary mode because UTF-8 characters require Text mode to work and update the screen properly for apps like the
-    // NTVDM DOS emulator.
-    // So stay in Text mode for UTF-8 characters to work but flip to Binary mode just for the LF characters. I see SQLite does something similar.
+    ConsoleWriter & w = g_console_writers[ ( 2 == descriptor ) ? 1 : 0 ];
+    HANDLE h = (HANDLE) _get_osfhandle( descriptor );
+    if ( INVALID_HANDLE_VALUE == h )
+    {
+        errno = EBADF;
+        return (size_t) -1;
+    }
+
+    if ( h != w.handle ) // the app may have dup'ed something else onto the descriptor
+    {
+        DWORD mode;
+        w.handle = h;
+        w.is_console = ( 0 != GetConsoleMode( h, &mode ) );
+        w.partial_count = 0;
+    }
 
-    size_t written = 0;
-    int start = 0;
-    int towrite = 0;
+    fflush( ( 2 == descriptor ) ? stderr : stdout ); // anything armos printed comes first
 
+    // one buffer with the bytes split off by the last write, this write, and CRs if -l added them
+
+    w.bytes.resize( 0 );
+    w.bytes.insert( w.bytes.end(), w.partial, w.partial + w.partial_count );
     for ( int i = 0; i < count; i++ )
     {
-        if ( 10 == p[ i ] )
+        if ( g_addCRBeforeLF && ( 10 == p[ i ] ) )
+            w.bytes.push_back( 13 );
+        w.bytes.push_back( p[ i ] );
+    }
+
+    BOOL ok = TRUE;
+    DWORD done = 0;
+    if ( w.is_console )
+    {
+        int tail = utf8_incomplete_tail( w.bytes.data(), (int) w.bytes.size() );
+        int complete = (int) w.bytes.size() - tail;
+        memcpy( w.partial, w.bytes.data() + complete, tail );
+        w.partial_count = tail;
+
+        if ( 0 != complete )
         {
-            if ( 0 != towrite )
-                written += write( descriptor, & p[ start ], towrite );
+            // invalid sequences become U+FFFD. UTF-16 never needs more code units than UTF-8 has bytes
 
-            SetBinaryMode binmode( true );
-            written += write( descriptor, & p[ i ], 1 );
-            towrite = 0;
-            start = i + 1;
+            w.wide.resize( complete );
+            int chars = MultiByteToWideChar( CP_UTF8, 0, (const char *) w.bytes.data(), complete, w.wide.data(), complete );
+            if ( chars > 0 )
+                ok = WriteConsoleW( h, w.wide.data(), (DWORD) chars, &done, 0 );
         }
-        else
-            towrite++;
     }
-    if ( 0 != towrite )
-        written += write( descriptor, & p[ start ], towrite );
-    return written;
+    else if ( !w.bytes.empty() )
+        ok = WriteFile( h, w.bytes.data(), (DWORD) w.bytes.size(), &done, 0 );
+
+    if ( !ok )
+    {
+        DWORD error = GetLastError();
+        w.partial_count = 0;
+        errno = ( ERROR_BROKEN_PIPE == error || ERROR_NO_DATA == error ) ? EPIPE : EIO;
+        return (size_t) -1;
+    }
+
+    return count; // the guest's bytes are all consumed, including any held back until the sequence is complete
 } //WinWrite
 
 static void slash_to_backslash( char * p )
@@ -1156,7 +1573,7 @@ static int fill_pstat_windows( int descriptor, struct stat_linux_syscall * pstat
             pstat->st_rdev = 4096;
         }
     }
-    else if ( findFirstDescriptor == descriptor )
+    else if ( 0 != g_process->dir_enumerations.count( descriptor ) )
     {
         pstat->st_mode = S_IFDIR;
         pstat->st_rdev = 4096;
@@ -1262,8 +1679,6 @@ static const char * get_clockid( clockid_t clockid )
     return "unknown";
 } //get_clockid
 
-high_resolution_clock::time_point g_tAppStart;
-
 static int msc_clock_gettime( clockid_t clockid, struct timespec_syscall * tv )
 {
     tracer.Trace( "  msc_clock_gettime, clockid %d == %s\n", clockid, get_clockid( clockid ) );
@@ -1278,7 +1693,7 @@ static int msc_clock_gettime( clockid_t clockid, struct timespec_syscall * tv )
               CLOCK_PROCESS_CPUTIME_ID == clockid || CLOCK_THREAD_CPUTIME_ID == clockid )
     {
         high_resolution_clock::time_point tNow = high_resolution_clock::now();
-        diff = duration_cast<std::chrono::nanoseconds>( tNow - g_tAppStart ).count();
+        diff = duration_cast<std::chrono::nanoseconds>( tNow - g_process->app_start ).count();
     }
 
     tv->tv_sec = diff / 1000000000ULL;
@@ -1519,6 +1934,11 @@ struct SysCall
 static const SysCall syscalls[] =
 {
     { "SYS_getcwd", SYS_getcwd },
+    { "SYS_epoll_create1", SYS_epoll_create1 },
+    { "SYS_epoll_ctl", SYS_epoll_ctl },
+    { "SYS_epoll_pwait", SYS_epoll_pwait },
+    { "SYS_dup", SYS_dup },
+    { "SYS_dup3", SYS_dup3 },
     { "SYS_fcntl", SYS_fcntl },
     { "SYS_ioctl", SYS_ioctl },
     { "SYS_mkdirat", SYS_mkdirat },
@@ -1528,13 +1948,21 @@ static const SysCall syscalls[] =
     { "SYS_chdir", SYS_chdir },
     { "SYS_openat", SYS_openat },
     { "SYS_close", SYS_close },
+    { "SYS_pipe2", SYS_pipe2 },
     { "SYS_getdents64", SYS_getdents64 },
     { "SYS_lseek", SYS_lseek },
     { "SYS_read", SYS_read },
     { "SYS_write", SYS_write },
+    { "SYS_readv", SYS_readv },
     { "SYS_writev", SYS_writev },
+    { "SYS_pread64", SYS_pread64 },
+    { "SYS_pwrite64", SYS_pwrite64 },
+    { "SYS_preadv", SYS_preadv },
+    { "SYS_pwritev", SYS_pwritev },
+    { "SYS_sendfile", SYS_sendfile },
     { "SYS_pselect6", SYS_pselect6 },
     { "SYS_ppoll_time32", SYS_ppoll_time32 },
+    { "SYS_splice", SYS_splice },
     { "SYS_readlinkat", SYS_readlinkat },
     { "SYS_newfstatat", SYS_newfstatat },
     { "SYS_newfstat", SYS_newfstat },
@@ -1561,26 +1989,48 @@ static const SysCall syscalls[] =
     { "SYS_prctl", SYS_prctl },
     { "SYS_gettimeofday", SYS_gettimeofday },
     { "SYS_getpid", SYS_getpid },
+    { "SYS_getppid", SYS_getppid },
     { "SYS_getuid", SYS_getuid },
     { "SYS_geteuid", SYS_geteuid },
     { "SYS_getgid", SYS_getgid },
     { "SYS_getegid", SYS_getegid },
     { "SYS_gettid", SYS_gettid },
     { "SYS_sysinfo", SYS_sysinfo },
+    { "SYS_socket", SYS_socket },
+    { "SYS_socketpair", SYS_socketpair },
+    { "SYS_bind", SYS_bind },
+    { "SYS_listen", SYS_listen },
+    { "SYS_accept", SYS_accept },
+    { "SYS_connect", SYS_connect },
+    { "SYS_getsockname", SYS_getsockname },
+    { "SYS_getpeername", SYS_getpeername },
+    { "SYS_sendto", SYS_sendto },
+    { "SYS_recvfrom", SYS_recvfrom },
+    { "SYS_setsockopt", SYS_setsockopt },
+    { "SYS_getsockopt", SYS_getsockopt },
+    { "SYS_shutdown", SYS_shutdown },
+    { "SYS_sendmsg", SYS_sendmsg },
+    { "SYS_recvmsg", SYS_recvmsg },
     { "SYS_brk", SYS_brk },
     { "SYS_munmap", SYS_munmap },
     { "SYS_mremap", SYS_mremap },
     { "SYS_clone", SYS_clone },
+    { "SYS_execve", SYS_execve },
     { "SYS_mmap", SYS_mmap },
     { "SYS_mprotect", SYS_mprotect },
+    { "SYS_msync", SYS_msync },
     { "SYS_madvise", SYS_madvise },
+    { "SYS_accept4", SYS_accept4 },
     { "SYS_riscv_flush_icache", SYS_riscv_flush_icache },
+    { "SYS_wait4", SYS_wait4 },
     { "SYS_prlimit64", SYS_prlimit64 },
     { "SYS_renameat2", SYS_renameat2 },
     { "SYS_getrandom", SYS_getrandom },
+    { "SYS_copy_file_range", SYS_copy_file_range },
     { "SYS_statx", SYS_statx },
     { "SYS_rseq", SYS_rseq },
     { "SYS_clock_gettime64", SYS_clock_gettime64 },
+    { "SYS_clone3", SYS_clone3 },
     { "SYS_open", SYS_open }, // only called for older systems
     { "SYS_unlink", SYS_unlink }, // only called for older systems
     { "SYS_mkdir", SYS_mkdir }, // only called for older systems
@@ -1606,6 +2056,9 @@ static const SysCall syscalls[] =
     { "emulator_sys_set_thread_area", emulator_sys_set_thread_area }, // exists on x32 and some other platforms
     { "emulator_sys_get_thread_area", emulator_sys_get_thread_area },
     { "emulator_sys_ugetrlimit", emulator_sys_ugetrlimit },
+    { "emulator_sys_snapshot", emulator_sys_snapshot },
+    { "emulator_sys_run_nested", emulator_sys_run_nested },
+    { "emulator_sys_counters", emulator_sys_counters },
 };
 
 // Use custom versions of bsearch and qsort to get consistent behavior across platforms.
@@ -1736,6 +2189,21 @@ static int syscall_compare( const void * a, const void * b )
     return 0;
 } //syscall_compare
 
+// the common syscall numbers are looked up directly. anything higher (e.g. emulator_sys_trace_instructions) uses bsearch
+
+struct DirectSyscallMap
+{
+    uint16_t r[ 512 ];
+
+    template <class T> DirectSyscallMap( const T * table, size_t count )
+    {
+        memset( r, 0, sizeof( r ) );
+        for ( size_t i = 0; i < count; i++ )
+            if ( table[ i ].s < _countof( r ) )
+                r[ table[ i ].s ] = table[ i ].r;
+    }
+};
+
 #endif
 
 #ifdef X64OS
@@ -1754,6 +2222,9 @@ static const SyscalltoRV X64ToRiscV[] = // per https://gpages.juszkiewicz.com.pl
     { 13, SYS_sigaction },
     { 14, SYS_rt_sigprocmask },
     { 16, SYS_ioctl },
+    { 17, SYS_pread64 },
+    { 18, SYS_pwrite64 },
+    { 19, SYS_readv },
     { 20, SYS_writev },
     { 21, emulator_sys_access },
     { 25, SYS_mremap },
@@ -1803,8 +2274,13 @@ static const SyscalltoRV X64ToRiscV[] = // per https://gpages.juszkiewicz.com.pl
     { 0x2002, emulator_sys_trace_instructions }, // same value
 };
 
+static const DirectSyscallMap g_directX64ToRiscV( X64ToRiscV, _countof( X64ToRiscV ) );
+
 uint16_t MapX64ToRiscV( REG_TYPE c )
 {
+    if ( c < _countof( g_directX64ToRiscV.r ) )
+        return g_directX64ToRiscV.r[ c ];
+
     SyscalltoRV key = { (uint16_t) c, 0 };
     SyscalltoRV * presult = (SyscalltoRV *) my_bsearch( &key, X64ToRiscV, _countof( X64ToRiscV ), sizeof( key ), syscall_compare );
     if ( 0 != presult )
@@ -1877,8 +2353,13 @@ static const SyscalltoRV X32ToRiscV[] = // per https://gpages.juszkiewicz.com.pl
     { 0x2002, emulator_sys_trace_instructions }, // same value
 };
 
+static const DirectSyscallMap g_directX32ToRiscV( X32ToRiscV, _countof( X32ToRiscV ) );
+
 uint16_t MapX32ToRiscV( REG_TYPE c )
 {
+    if ( c < _countof( g_directX32ToRiscV.r ) )
+        return g_directX32ToRiscV.r[ c ];
+
     SyscalltoRV key = { (uint16_t) c, 0 };
     SyscalltoRV * presult = (SyscalltoRV *) my_bsearch( &key, X32ToRiscV, _countof( X32ToRiscV ), sizeof( key ), syscall_compare );
     if ( 0 != presult )
@@ -1939,8 +2420,13 @@ static const StoRV SparcToRiscV[] = // per https://gpages.juszkiewicz.com.pl/sys
     { 0x2002, emulator_sys_trace_instructions }, // same value
 };
 
+static const DirectSyscallMap g_directSparcToRiscV( SparcToRiscV, _countof( SparcToRiscV ) );
+
 uint16_t MapSparcToRiscV( REG_TYPE c )
 {
+    if ( c < _countof( g_directSparcToRiscV.r ) )
+        return g_directSparcToRiscV.r[ c ];
+
     SyscalltoRV key = { (uint16_t) c, 0 };
     SyscalltoRV * presult = (SyscalltoRV *) my_bsearch( &key, SparcToRiscV, _countof( SparcToRiscV ), sizeof( key ), syscall_compare );
     if ( 0 != presult )
@@ -1976,94 +2462,3956 @@ void send_character( uint8_t c )
     printf( "%c", c );
 } //send_character
 
-static struct linux_user_desc g_user_desc;
-
 #ifdef __mc68000__
 extern "C" long syscall( long number, ... );
 #endif
 
-// this is called when the arm64 app has an svc #0 instruction or a RISC-V 64 app has an ecall instruction
-// https://thevivekpandey.github.io/posts/2017-09-25-linux-system-calls.html
+#ifdef ARMOS
 
-#pragma warning(disable: 4189) // unreferenced local variable
+// guest threads created by clone run on host threads, each with its own CPUClass and predecode cache. guest memory is
+// shared. syscalls are serialized by syscall_mutex since they use the emulator's file, mmap, and console state,
+// except where they block: futex waits, sleeps, yields, and console reads use BLOCKING_CALL to let other threads in.
 
-void emulator_invoke_svc( CPUClass & cpu )
-{
-#ifdef _WIN32
-    static HANDLE g_hFindFirst = INVALID_HANDLE_VALUE; // for enumerating directories. Only one can be active at once.
-    static char g_acFindFirstPattern[ EMULATOR_MAX_PATH ];
-    char acPath[ EMULATOR_MAX_PATH ];
-#else
-    #if !defined( OLDGCC )
-        static DIR * g_FindFirst = 0;
-        static REG_TYPE g_FindFirstDescriptor = -1;
-    #endif
-#endif
+const uint64_t linuxCLONE_VM = 0x100;
+const uint64_t linuxCLONE_SIGHAND = 0x800;
+const uint64_t linuxCLONE_VFORK = 0x4000;
+const uint64_t linuxCLONE_THREAD = 0x10000;
+const uint64_t linuxCLONE_SETTLS = 0x80000;
+const uint64_t linuxCLONE_PARENT_SETTID = 0x100000;
+const uint64_t linuxCLONE_CHILD_CLEARTID = 0x200000;
+const uint64_t linuxCLONE_CHILD_SETTID = 0x1000000;
 
-    REG_TYPE syscall_id = ACCESS_REG( REG_SYSCALL );
+const int64_t linuxEAGAIN = 11;                      // host errno values differ on Windows
+const int64_t linuxEINVAL = 22;
+const int64_t linuxENOSYS = 38;
+const int64_t linuxETIMEDOUT = 110;
 
-#ifdef SPARCOS
-    cpu.setflag_c( 0 ); // Linux on Sparc uses the carry flag in addition to the result register to indicate success/failure
-    syscall_id = MapSparcToRiscV( syscall_id );
-    tracer.Trace( "mapped sparc syscall %u to %u\n", ACCESS_REG( REG_SYSCALL ), syscall_id );
-    if ( 0 == syscall_id )
-    {
-        printf( "unable to find a Sparc mapping for syscall %u\n", ACCESS_REG( REG_SYSCALL ) );
-        tracer.Trace( "unable to find a Sparc mapping for syscall %u\n", ACCESS_REG( REG_SYSCALL ) );
-    }
-#elif defined( X64OS )
-    syscall_id = MapX64ToRiscV( syscall_id );
-    tracer.Trace( "mapped x64 syscall %llu to %llu\n", ACCESS_REG( REG_SYSCALL ), syscall_id );
-    if ( 0 == syscall_id )
-    {
-        printf( "unable to find an X64 mapping for syscall %llu\n", ACCESS_REG( REG_SYSCALL ) );
-        tracer.Trace( "unable to find an X64 mapping for syscall %llu\n", ACCESS_REG( REG_SYSCALL ) );
-    }
-#elif defined( X32OS )
-    syscall_id = MapX32ToRiscV( syscall_id );
-    tracer.Trace( "mapped x32 syscall %u to %u\n", ACCESS_REG( REG_SYSCALL ), syscall_id );
-    if ( 0 == syscall_id )
+static bool g_show_instruction_mix = false;
+static Arm64::OpCounts g_op_counts;                  // for -x. guarded by thread_mutex
+static const char * g_branch_profile_path = 0;       // for -fdo. 0 when the branch profile is off
+static Arm64::EdgeCounts g_branch_ranges;            // for -fdo. guarded by thread_mutex
+static Arm64::EdgeCounts g_branch_taken;
+static thread_local uint32_t g_tid = 1;
+static thread_local uint64_t g_clear_child_tid = 0;  // from CLONE_CHILD_CLEARTID or set_tid_address. zeroed and woken at exit
+
+#define BLOCKING_CALL( x ) { syscall_lock.unlock(); x; syscall_lock.lock(); }
+
+static void install_guard_fault_handler( CPUClass * pcpu );
+static void collect_memory_model();
+
+// futex waiters are kept by guest address. each has its own condition variable so wakes can pick exactly who to wake
+
+struct FutexWaiter
+{
+    uint64_t address;
+    uint32_t bitset;
+    bool woken;
+    condition_variable cv;
+};
+
+static void futex_unlink( FutexWaiter & w )
+{
+    pair<multimap<uint64_t, FutexWaiter *>::iterator, multimap<uint64_t, FutexWaiter *>::iterator> range = g_process->futex_waiters.equal_range( w.address );
+    for ( multimap<uint64_t, FutexWaiter *>::iterator it = range.first; it != range.second; it++ )
     {
-        printf( "unable to find an X32 mapping for syscall %u\n", ACCESS_REG( REG_SYSCALL ) );
-        tracer.Trace( "unable to find an X32 mapping for syscall %u\n", ACCESS_REG( REG_SYSCALL ) );
+        if ( &w == it->second )
+        {
+            g_process->futex_waiters.erase( it );
+            break;
+        }
     }
-#endif
+} //futex_unlink
+
+static int64_t futex_wait( CPUClass & cpu, uint64_t address, uint32_t value, uint32_t bitset, const steady_clock::time_point * deadline )
+{
+    unique_lock<mutex> lock( g_process->futex_mutex );
 
-    // Linux syscalls support up to 6 arguments
+    // the value is checked while holding the futex lock so a waker that changes it and then wakes can't be missed
 
-    if ( tracer.IsEnabled() )
-#if defined( M68 ) || defined( SPARCOS ) || defined( X32OS )
-        tracer.Trace( "syscall %s %x = %d, arg0 %x, arg1 %x, arg2 %x, arg3 %x, arg4 %x, arg5 %x\n",
-                      lookup_syscall( syscall_id ), syscall_id, syscall_id,
-                      ACCESS_REG( REG_ARG0 ), ACCESS_REG( REG_ARG1 ), ACCESS_REG( REG_ARG2 ), ACCESS_REG( REG_ARG3 ),
-                      ACCESS_REG( REG_ARG4 ), ACCESS_REG( REG_ARG5 ) );
-#else
-        tracer.Trace( "syscall %s %llx = %lld, arg0 %llx, arg1 %llx, arg2 %llx, arg3 %llx, arg4 %llx, arg5 %llx\n",
-                      lookup_syscall( (uint32_t) syscall_id ), syscall_id, syscall_id,
-                      ACCESS_REG( REG_ARG0 ), ACCESS_REG( REG_ARG1 ), ACCESS_REG( REG_ARG2 ), ACCESS_REG( REG_ARG3 ),
-                      ACCESS_REG( REG_ARG4 ), ACCESS_REG( REG_ARG5 ) );
-#endif
+    if ( swap_endian32( * (volatile uint32_t *) cpu.getmem( address ) ) != value )
+        return -linuxEAGAIN;
 
-    switch ( syscall_id )
+    FutexWaiter w;
+    w.address = address;
+    w.bitset = bitset;
+    w.woken = false;
+    g_process->futex_waiters.insert( make_pair( address, &w ) );
+
+    while ( !w.woken && !g_process->terminate )
     {
-        case emulator_sys_exit: // exit
-        case SYS_exit:
-        case SYS_exit_group:
-        case SYS_tgkill:
+        if ( 0 == deadline )
+            w.cv.wait( lock );
+        else if ( ( cv_status::timeout == w.cv.wait_until( lock, *deadline ) ) && !w.woken )
         {
-            g_terminate = true;
-            cpu.end_emulation();
-            g_exit_code = (int) ACCESS_REG( REG_ARG0 );
-            tracer.Trace( "  emulated app exit code %d\n", g_exit_code );
-            update_result_errno( cpu, 0 );
-            break;
+            futex_unlink( w );
+            return -linuxETIMEDOUT;
         }
-#if defined( X32OS )
-        case emulator_sys_ugetrlimit:
+    }
+
+    if ( !w.woken )
+        futex_unlink( w );
+    return 0;
+} //futex_wait
+
+static int64_t futex_wake_locked( uint64_t address, int64_t count, uint32_t bitset )
+{
+    int64_t woken = 0;
+    multimap<uint64_t, FutexWaiter *>::iterator it = g_process->futex_waiters.lower_bound( address );
+    while ( ( woken < count ) && ( it != g_process->futex_waiters.end() ) && ( address == it->first ) )
+    {
+        FutexWaiter * pw = it->second;
+        if ( 0 != ( pw->bitset & bitset ) )
         {
-            errno = EINVAL;
-            update_result_errno( cpu, -1 );
-            break;
+            pw->woken = true;
+            pw->cv.notify_one();
+            g_process->futex_waiters.erase( it++ );
+            woken++;
+        }
+        else
+            it++;
+    }
+
+    return woken;
+} //futex_wake_locked
+
+static int64_t futex_wake( uint64_t address, int64_t count, uint32_t bitset )
+{
+    lock_guard<mutex> lock( g_process->futex_mutex );
+    return futex_wake_locked( address, count, bitset );
+} //futex_wake
+
+static int64_t futex_requeue( CPUClass & cpu, uint64_t address, int64_t wake_count, int64_t requeue_count, uint64_t address2, bool compare, uint32_t value )
+{
+    lock_guard<mutex> lock( g_process->futex_mutex );
+
+    if ( compare && ( swap_endian32( * (volatile uint32_t *) cpu.getmem( address ) ) != value ) )
+        return -linuxEAGAIN;
+
+    int64_t woken = futex_wake_locked( address, wake_count, 0xffffffff );
+    int64_t moved = 0;
+    multimap<uint64_t, FutexWaiter *>::iterator it = g_process->futex_waiters.lower_bound( address );
+    while ( ( moved < requeue_count ) && ( it != g_process->futex_waiters.end() ) && ( address == it->first ) )
+    {
+        FutexWaiter * pw = it->second;
+        g_process->futex_waiters.erase( it++ );
+        pw->address = address2;
+        g_process->futex_waiters.insert( make_pair( address2, pw ) );
+        moved++;
+    }
+
+    return compare ? ( woken + moved ) : woken;
+} //futex_requeue
+
+static void futex_wake_all()
+{
+    lock_guard<mutex> lock( g_process->futex_mutex );
+    for ( multimap<uint64_t, FutexWaiter *>::iterator it = g_process->futex_waiters.begin(); it != g_process->futex_waiters.end(); it++ )
+    {
+        it->second->woken = true;
+        it->second->cv.notify_one();
+    }
+    g_process->futex_waiters.clear();
+} //futex_wake_all
+
+static int64_t guest_clock_ns( clockid_t clockid )
+{
+#ifdef _WIN32
+    struct timespec_syscall tv;
+    msc_clock_gettime( clockid, &tv );
+#else
+    struct timespec tv;
+    clock_gettime( clockid, &tv );
+#endif
+    return (int64_t) tv.tv_sec * 1000000000 + tv.tv_nsec;
+} //guest_clock_ns
+
+static void end_all_threads()
+{
+    // exit_group. other threads stop at their next block boundary or when their futex wait is cut short
+
+    {
+        lock_guard<mutex> lock( g_process->thread_mutex );
+        g_process->terminate = true;
+        for ( size_t i = 0; i < g_process->threads.size(); i++ )
+            g_process->threads[ i ]->end_emulation();
+        if ( 0 != g_process->main_cpu )
+            g_process->main_cpu->end_emulation();
+        g_process->thread_exited.notify_all();
+    }
+
+    futex_wake_all();
+} //end_all_threads
+
+static void guest_thread( EmulatedProcess * process, CPUClass * pcpu, uint32_t tid, uint64_t clear_child_tid )
+{
+    g_process = process;
+    g_tid = tid;
+    g_clear_child_tid = clear_child_tid;
+    install_guard_fault_handler( pcpu );
+
+    FaultJump jump;
+    if ( !process->embedded || ( 0 == FAULT_SETJMP( jump ) ) )
+    {
+        g_fault_jump = &jump;
+        g_process->thread_instructions += pcpu->run();
+    }
+    else
+    {
+        g_process->exit_code = 1; // a fault in any thread ends the app
+        end_all_threads();
+    }
+    g_fault_jump = 0;
+
+    if ( 0 != g_clear_child_tid ) // how pthread_join learns the thread is gone
+    {
+        * (volatile uint32_t *) pcpu->getmem( g_clear_child_tid ) = 0;
+        futex_wake( g_clear_child_tid, 1, 0xffffffff );
+    }
+
+    {
+        lock_guard<mutex> lock( g_process->thread_mutex );
+        g_process->threads.erase( find( g_process->threads.begin(), g_process->threads.end(), pcpu ) );
+        pcpu->collect_instruction_mix( g_op_counts );
+        pcpu->collect_branch_profile( g_branch_ranges, g_branch_taken );
+        collect_memory_model();
+    }
+
+    tracer.Trace( "thread %u exiting\n", tid );
+    delete pcpu;
+
+    lock_guard<mutex> lock( g_process->thread_mutex );
+    g_process->live_threads--;
+    g_process->thread_exited.notify_all();
+} //guest_thread
+
+static FILE * g_record_file = 0;                     // -record: the syscall log being written. see SyscallLog
+
+#ifndef _WIN32
+
+// a clone that makes a new process forks armos, so the child's guest memory is a copy-on-write copy of the parent's
+// and both run at once, as shell pipelines expect. see execve for replacing the child's image
+
+static bool g_forked = false;                        // this armos is an app's child. it exits without reports
+
+static void lock_for_fork();
+static void unlock_after_fork( bool child );
+
+static int64_t fork_process( CPUClass & cpu, uint64_t flags, uint64_t stack, uint64_t parent_tid, uint64_t child_tid, uint64_t tls )
+{
+    if ( g_process->embedded ) // the host program isn't the app's to copy
+        return -EACCES;
+
+    fflush( stdout ); // so buffered output isn't written by both processes
+    if ( 0 != g_record_file )
+        fflush( g_record_file );
+    lock_for_fork(); // no tracing until the locks are released
+    pid_t pid = fork();
+    unlock_after_fork( 0 == pid );
+    if ( -1 == pid )
+        return -linuxEAGAIN;
+
+    if ( 0 == pid )
+    {
+        // only the calling thread exists in the child. a vfork child gets a copy of memory too and the parent doesn't
+        // wait for it, which is fine for posix_spawn and system() since they just exec and wait
+
+        if ( 0 != stack )
+            cpu.regs[ 31 ] = stack;
+        if ( flags & linuxCLONE_SETTLS )
+            cpu.tpidr_el0 = tls;
+        if ( flags & linuxCLONE_CHILD_SETTID )
+            * (uint32_t *) cpu.getmem( child_tid ) = swap_endian32( g_tid );
+        tracer.Trace( "  in forked child process %d\n", (int) getpid() );
+        return 0;
+    }
+
+    if ( flags & linuxCLONE_PARENT_SETTID )
+        * (uint32_t *) cpu.getmem( parent_tid ) = swap_endian32( (uint32_t) pid );
+    tracer.Trace( "  forked child process %d\n", (int) pid );
+    return pid;
+} //fork_process
+
+#endif
+
+static bool clone_forks( uint64_t flags )
+{
+    return !( flags & linuxCLONE_THREAD ) && ( !( flags & linuxCLONE_VM ) || ( flags & linuxCLONE_VFORK ) );
+} //clone_forks
+
+static int64_t clone_thread( CPUClass & cpu, uint64_t flags, uint64_t stack, uint64_t parent_tid, uint64_t child_tid, uint64_t tls )
+{
+    const uint64_t thread_flags = linuxCLONE_VM | linuxCLONE_SIGHAND | linuxCLONE_THREAD;
+    if ( thread_flags != ( flags & thread_flags ) )
+    {
+#ifndef _WIN32
+        if ( clone_forks( flags ) )
+            return fork_process( cpu, flags, stack, parent_tid, child_tid, tls );
+#endif
+        tracer.Trace( "  clone flags %#llx don't create a thread or a process; failing with EACCES\n", flags );
+        return -EACCES;
+    }
+
+    if ( 0 == stack )
+        return -linuxEINVAL;
+
+    // the child's stack is wherever the app allocated it, so for debug builds' stack checks it's anywhere above the loaded image
+
+    CPUClass * pchild = new CPUClass( g_process->vm_memory, g_process->base_address, cpu.pc + 4, g_process->vm_memory.size() - g_process->end_of_data, g_process->base_address + g_process->vm_memory.size() );
+    pchild->copy_thread_state( cpu );
+    pchild->pc = cpu.pc + 4;  // just past the svc, like the parent
+    pchild->regs[ 0 ] = 0;    // clone returns 0 in the child
+    pchild->regs[ 31 ] = stack;
+    if ( flags & linuxCLONE_SETTLS )
+        pchild->tpidr_el0 = tls;
+
+    uint32_t tid = g_process->next_tid++;
+    if ( flags & linuxCLONE_PARENT_SETTID )
+        * (uint32_t *) cpu.getmem( parent_tid ) = swap_endian32( tid );
+    if ( flags & linuxCLONE_CHILD_SETTID )
+        * (uint32_t *) cpu.getmem( child_tid ) = swap_endian32( tid );
+
+    {
+        lock_guard<mutex> lock( g_process->thread_mutex );
+        g_process->threads.push_back( pchild );
+        g_process->live_threads++;
+    }
+
+    tracer.Trace( "  starting thread %u with pc %llx and sp %llx\n", tid, pchild->pc, stack );
+    thread t( guest_thread, g_process, pchild, tid, ( flags & linuxCLONE_CHILD_CLEARTID ) ? child_tid : 0 );
+    t.detach();
+    return tid;
+} //clone_thread
+
+static void read_guest_strings( CPUClass & cpu, uint64_t address, vector<string> & strings )
+{
+    // argv and envp are null-terminated arrays of string pointers
+
+    if ( 0 == address )
+        return;
+
+    for ( ;; address += 8 )
+    {
+        uint64_t p = swap_endian64( * (uint64_t *) cpu.getmem( address ) );
+        if ( 0 == p )
+            break;
+        strings.push_back( (const char *) cpu.getmem( p ) );
+    }
+} //read_guest_strings
+
+static int start_exec( CPUClass & cpu, const char * path, uint64_t argv, uint64_t envp )
+{
+    // an Arm64 image replaces the app once its cpu stops; see replace_image(). other programs, like the host's /bin/sh
+    // for system(), replace armos itself. returns -1 with errno set on failure
+
+    if ( g_process->embedded ) // the host program isn't the app's to replace
+    {
+        errno = EACCES;
+        return -1;
+    }
+
+    vector<string> args, env;
+    read_guest_strings( cpu, argv, args );
+    read_guest_strings( cpu, envp, env );
+
+    FILE * fp = fopen( path, "rb" );
+    if ( 0 == fp )
+        return -1;
+
+    ElfHeader64 ehead = {0};
+    bool elf = ( 1 == fread( &ehead, sizeof ehead, 1, fp ) ) && ( 0x464c457f == ehead.magic || 0x7f454c46 == ehead.magic );
+    fclose( fp );
+    if ( elf )
+        ehead.swap_endianness();
+
+    if ( !elf || ( 2 != ehead.bit_width ) || ( 2 != ehead.type ) || ( ELF_MACHINE_ISA != ehead.machine ) )
+    {
+#ifdef _WIN32
+        errno = ENOEXEC;
+#else
+        vector<char *> host_args, host_env;
+        for ( size_t i = 0; i < args.size(); i++ )
+            host_args.push_back( (char *) args[ i ].c_str() );
+        host_args.push_back( 0 );
+        for ( size_t i = 0; i < env.size(); i++ )
+            host_env.push_back( (char *) env[ i ].c_str() );
+        host_env.push_back( 0 );
+
+        tracer.Trace( "  execve of host program %s\n", path );
+        fflush( stdout );
+        if ( 0 != g_record_file )
+            fflush( g_record_file );
+        tracer.Flush();
+        execve( path, host_args.data(), host_env.data() );
+#endif
+        return -1;
+    }
+
+    {
+        lock_guard<mutex> lock( g_process->thread_mutex );
+        if ( !g_process->threads.empty() )
+        {
+            tracer.Trace( "  execve from an app that has other threads isn't supported\n" );
+            errno = EAGAIN;
+            return -1;
+        }
+    }
+
+    size_t args_bytes = 0;
+    for ( size_t i = 0; i < args.size(); i++ )
+        args_bytes += args[ i ].size() + 1;
+
+    if ( ( args.size() > 40 ) || ( ( args_bytes + 16 ) > g_arg_data_commit ) )
+    {
+        errno = E2BIG;
+        return -1;
+    }
+
+    g_process->exec_path = path;
+    g_process->exec_argv = args;
+    g_process->exec_env.clear();
+    for ( size_t i = 0; i < env.size(); i++ )
+    {
+        bool added_by_load = !strncmp( env[ i ].c_str(), "OS=", 3 );
+#ifdef _WIN32
+        added_by_load = added_by_load || !strncmp( env[ i ].c_str(), "TZ=", 3 );
+#endif
+        if ( !added_by_load )
+            g_process->exec_env.push_back( env[ i ] );
+    }
+
+    tracer.Trace( "  execve of %s with %zu arguments after the cpu stops\n", path, args.size() );
+    cpu.end_emulation();
+    return 0;
+} //start_exec
+
+static bool wait_for_threads()
+{
+    // called once main's cpu returns. if main used exit rather than exit_group, the app runs until the other threads
+    // exit. threads blocked in the host (reading the console, sleeping) get a moment to notice exit_group and are then
+    // abandoned. returns true if they all finished.
+
+    unique_lock<mutex> lock( g_process->thread_mutex );
+    g_process->main_cpu = 0;
+    g_process->thread_exited.wait( lock, [] { return ( 0 == g_process->live_threads ) || g_process->terminate; } );
+    return g_process->thread_exited.wait_for( lock, seconds( 2 ), [] { return 0 == g_process->live_threads; } );
+} //wait_for_threads
+
+// -P:<hz> sampling profiler. a host thread asks each running guest cpu for a sample at that rate, and the cpu records
+// its pc plus the return addresses in its x29 frame chain at the next block boundary. at exit a flat profile and
+// collapsed stacks for flamegraph.pl are written. a thread blocked in the host takes its sample when it resumes.
+
+static const size_t max_profile_depth = 128;
+static uint32_t g_profile_hz = 0;                    // 0 when profiling is off
+static mutex g_profile_mutex;                        // for g_profile_stacks and g_profile_samples
+static map<vector<uint64_t>, uint64_t> g_profile_stacks; // leaf-first pcs -> sample count
+static uint64_t g_profile_samples = 0;
+static bool g_profile_stop = false;                  // guarded by thread_mutex
+static condition_variable g_profile_wake;
+static thread g_profile_thread;
+
+void emulator_sample( CPUClass & cpu )
+{
+    vector<uint64_t> stack;
+    stack.push_back( cpu.pc );
+
+    // each frame record is the caller's x29 then the return address. the chain moves toward the top of the stack
+
+    uint64_t fp = cpu.regs[ 29 ];
+    uint64_t limit = g_process->base_address + g_process->vm_memory.size();
+
+    // leaf functions often don't push a frame, so their caller is only in x30. skip x30 when it's already the first
+    // frame's return address or it's stale from a call the current function already made
+
+    uint64_t x30 = cpu.regs[ 30 ];
+    bool fp_valid = ( 0 == ( fp & 7 ) ) && ( fp >= g_process->base_address ) && ( ( fp + 16 ) <= limit );
+    if ( ( x30 >= 4 ) && !( fp_valid && ( x30 == swap_endian64( ( (const uint64_t *) ( g_process->vm_memory.data() + ( fp - g_process->base_address ) ) )[ 1 ] ) ) ) )
+    {
+        uint64_t offset;
+        if ( emulator_symbol_lookup( x30 - 4, offset ) != emulator_symbol_lookup( cpu.pc, offset ) )
+            stack.push_back( x30 - 4 );
+    }
+    while ( ( stack.size() < max_profile_depth ) && ( 0 == ( fp & 7 ) ) && ( fp >= g_process->base_address ) && ( ( fp + 16 ) <= limit ) )
+    {
+        const uint64_t * frame = (const uint64_t *) ( g_process->vm_memory.data() + ( fp - g_process->base_address ) );
+        uint64_t next = swap_endian64( frame[ 0 ] );
+        uint64_t lr = swap_endian64( frame[ 1 ] );
+        if ( lr < 4 )
+            break;
+        stack.push_back( lr - 4 ); // the bl, so the sample is attributed to the caller rather than whatever follows
+        if ( next <= fp )
+            break;
+        fp = next;
+    }
+
+    lock_guard<mutex> lock( g_profile_mutex );
+    g_profile_stacks[ stack ]++;
+    g_profile_samples++;
+} //emulator_sample
+
+static void profile_sampler()
+{
+    nanoseconds interval( 1000000000 / g_profile_hz );
+    steady_clock::time_point next = steady_clock::now() + interval;
+    unique_lock<mutex> lock( g_process->thread_mutex );
+
+    while ( !g_profile_wake.wait_until( lock, next, [] { return g_profile_stop; } ) )
+    {
+        if ( 0 != g_process->main_cpu )
+            g_process->main_cpu->request_sample();
+        for ( size_t i = 0; i < g_process->threads.size(); i++ )
+            g_process->threads[ i ]->request_sample();
+
+        next += interval;
+        steady_clock::time_point now = steady_clock::now();
+        if ( next < now ) // the host fell behind; don't try to catch up
+            next = now + interval;
+    }
+} //profile_sampler
+
+static void end_profile_thread()
+{
+    // stop the sampler without writing a profile. exit() from usage(), a hard termination, or -serve would otherwise
+    // destroy a joinable thread, which calls terminate()
+
+    if ( !g_profile_thread.joinable() )
+        return;
+
+    {
+        lock_guard<mutex> lock( g_process->thread_mutex );
+        g_profile_stop = true;
+        g_profile_wake.notify_all();
+    }
+    g_profile_thread.join();
+} //end_profile_thread
+
+static void start_profiler()
+{
+    if ( 0 != g_profile_hz )
+    {
+        g_profile_thread = thread( profile_sampler );
+        atexit( end_profile_thread ); // runs before g_profile_thread is destroyed, since it's registered later
+    }
+} //start_profiler
+
+#ifndef _WIN32
+
+static void lock_for_fork()
+{
+    // the locks other threads take, in lock order, so the child can't be copied with one held for good
+
+    g_process->thread_mutex.lock();
+    g_process->futex_mutex.lock();
+    g_profile_mutex.lock();
+    tracer.BeforeFork();
+} //lock_for_fork
+
+static void unlock_after_fork( bool child )
+{
+    if ( child )
+    {
+        // only the forking thread was copied. that excludes the sampler, so the child doesn't profile
+
+        tracer.AfterFork();
+        g_forked = true;
+        g_process->threads.clear();
+        g_process->live_threads = 0;
+        g_process->futex_waiters.clear();
+        g_profile_hz = 0;
+        g_profile_stacks.clear();
+        g_profile_samples = 0;
+        new ( & g_profile_thread ) thread(); // the parent's sampler isn't this process's to join
+    }
+    else
+        tracer.AfterForkParent();
+
+    g_profile_mutex.unlock();
+    g_process->futex_mutex.unlock();
+    g_process->thread_mutex.unlock();
+} //unlock_after_fork
+
+#endif
+
+static const char * profile_frame_name( uint64_t pc, char * buf, size_t len )
+{
+    uint64_t offset;
+    const char * name = emulator_symbol_lookup( pc, offset );
+    if ( 0 != name[ 0 ] )
+        return name;
+
+    snprintf( buf, len, "%#llx", (unsigned long long) pc );
+    return buf;
+} //profile_frame_name
+
+struct ProfileEntry
+{
+    string name;
+    uint64_t self;
+    uint64_t total;
+};
+
+static bool profile_entry_compare( const ProfileEntry & a, const ProfileEntry & b )
+{
+    if ( a.self != b.self )
+        return a.self > b.self;
+    return a.total > b.total;
+} //profile_entry_compare
+
+static void stop_profiler()
+{
+    if ( 0 == g_profile_hz )
+        return;
+
+    end_profile_thread();
+
+    lock_guard<mutex> lock( g_profile_mutex );
+    map<string, ProfileEntry> functions;
+    map<string, uint64_t> folded;
+    char ac[ 40 ];
+
+    for ( map<vector<uint64_t>, uint64_t>::iterator it = g_profile_stacks.begin(); it != g_profile_stacks.end(); it++ )
+    {
+        const vector<uint64_t> & stack = it->first;
+        vector<string> names;
+        for ( size_t i = 0; i < stack.size(); i++ )
+            names.push_back( profile_frame_name( stack[ i ], ac, sizeof( ac ) ) );
+
+        string line;
+        for ( size_t i = names.size(); i > 0; i-- )
+        {
+            if ( i != names.size() )
+                line += ';';
+            line += names[ i - 1 ];
+
+            // recursion shouldn't count a function more than once in the inclusive total
+
+            if ( names.end() == find( names.begin() + i, names.end(), names[ i - 1 ] ) )
+            {
+                ProfileEntry & e = functions[ names[ i - 1 ] ];
+                e.name = names[ i - 1 ];
+                e.total += it->second;
+            }
+        }
+
+        functions[ names[ 0 ] ].self += it->second;
+        folded[ line ] += it->second;
+    }
+
+    vector<ProfileEntry> sorted;
+    for ( map<string, ProfileEntry>::iterator it = functions.begin(); it != functions.end(); it++ )
+        sorted.push_back( it->second );
+    sort( sorted.begin(), sorted.end(), profile_entry_compare );
+
+    FILE * fp = fopen( PROFILE_NAME, "w" );
+    if ( 0 != fp )
+    {
+        uint64_t n = get_max( g_profile_samples, (uint64_t) 1 );
+        fprintf( fp, "%llu samples at %u hz\n\n", (unsigned long long) g_profile_samples, g_profile_hz );
+        fprintf( fp, "%12s %7s %12s %7s  %s\n", "self", "self%", "total", "total%", "function" );
+        for ( size_t i = 0; i < sorted.size(); i++ )
+            fprintf( fp, "%12llu %6.2f%% %12llu %6.2f%%  %s\n", (unsigned long long) sorted[ i ].self, 100.0 * sorted[ i ].self / n,
+                     (unsigned long long) sorted[ i ].total, 100.0 * sorted[ i ].total / n, sorted[ i ].name.c_str() );
+        fclose( fp );
+    }
+
+    fp = fopen( FOLDED_NAME, "w" );
+    if ( 0 != fp )
+    {
+        for ( map<string, uint64_t>::iterator it = folded.begin(); it != folded.end(); it++ )
+            fprintf( fp, "%s %llu\n", it->first.c_str(), (unsigned long long) it->second );
+        fclose( fp );
+    }
+
+    printf( "profile: %llu samples written to %s and %s\n", (unsigned long long) g_profile_samples, PROFILE_NAME, FOLDED_NAME );
+} //stop_profiler
+
+// -x instruction mix. each cpu counts executions per raw opcode, threads add theirs to g_op_counts as they exit,
+// and at exit the opcodes are disassembled to mnemonics and shown sorted by executions.
+static bool mix_compare( const pair<string, uint64_t> & a, const pair<string, uint64_t> & b )
+{
+    return a.second > b.second;
+} //mix_compare
+
+static void show_instruction_mix( CPUClass & cpu )
+{
+    {
+        lock_guard<mutex> lock( g_process->thread_mutex );
+        cpu.collect_instruction_mix( g_op_counts );
+    }
+
+    map<string, uint64_t> mix;
+    cpu.name_instruction_mix( g_op_counts, mix );
+
+    vector<pair<string, uint64_t>> sorted( mix.begin(), mix.end() );
+    sort( sorted.begin(), sorted.end(), mix_compare );
+    uint64_t total = 0;
+    for ( size_t i = 0; i < sorted.size(); i++ )
+        total += sorted[ i ].second;
+    if ( 0 == total )
+        return;
+
+    char ac[ 100 ];
+    printf( "instruction mix: %zu mnemonics from %zu distinct opcodes\n", sorted.size(), g_op_counts.size() );
+    printf( "%-14s %15s %8s %11s\n", "mnemonic", "executions", "percent", "cumulative" );
+    uint64_t running = 0;
+    for ( size_t i = 0; i < sorted.size(); i++ )
+    {
+        running += sorted[ i ].second;
+        printf( "%-14s %15s %7.2f%% %10.2f%%\n", sorted[ i ].first.c_str(), CDJLTrace::RenderNumberWithCommas( sorted[ i ].second, ac ),
+                100.0 * sorted[ i ].second / total, 100.0 * running / total );
+    }
+} //show_instruction_mix
+
+// -fdo:F branch profile. each cpu counts executions of its predecoded blocks and the branches taken between them,
+// threads add theirs as they exit, and at exit they're written to F in the text format AutoFDO's create_gcov and
+// create_llvm_prof read with --profiler=text. those map the addresses to source lines with the app's debug info,
+// so only addresses in the app's functions are written.
+
+static void write_branch_profile( CPUClass & cpu )
+{
+    if ( 0 == g_branch_profile_path )
+        return;
+
+    lock_guard<mutex> lock( g_process->thread_mutex );
+    cpu.collect_branch_profile( g_branch_ranges, g_branch_taken );
+
+    map<string, uint64_t> functions; // name -> instructions executed
+    vector<pair<pair<uint64_t, uint64_t>, uint64_t>> ranges, branches;
+    uint64_t offset;
+
+    for ( Arm64::EdgeCounts::iterator it = g_branch_ranges.begin(); it != g_branch_ranges.end(); it++ )
+    {
+        const char * name = emulator_symbol_lookup( it->first.first, offset );
+        if ( 0 == name[ 0 ] )
+            continue;
+        ranges.push_back( *it );
+        functions[ name ] += it->second * ( 1 + ( it->first.second - it->first.first ) / 4 );
+    }
+
+    for ( Arm64::EdgeCounts::iterator it = g_branch_taken.begin(); it != g_branch_taken.end(); it++ )
+        if ( ( 0 != emulator_symbol_lookup( it->first.first, offset )[ 0 ] ) && ( 0 != emulator_symbol_lookup( it->first.second, offset )[ 0 ] ) )
+            branches.push_back( *it );
+
+    FILE * fp = fopen( g_branch_profile_path, "w" );
+    if ( 0 == fp )
+    {
+        printf( "fdo: unable to create %s\n", g_branch_profile_path );
+        return;
+    }
+
+    fprintf( fp, "%zu\n", ranges.size() );
+    for ( size_t i = 0; i < ranges.size(); i++ )
+        fprintf( fp, "%llx-%llx:%llu\n", (unsigned long long) ranges[ i ].first.first, (unsigned long long) ranges[ i ].first.second,
+                 (unsigned long long) ranges[ i ].second );
+    fprintf( fp, "0\n" ); // sampled addresses; every executed instruction is in a range
+    fprintf( fp, "%zu\n", branches.size() );
+    for ( size_t i = 0; i < branches.size(); i++ )
+        fprintf( fp, "%llx->%llx:%llu\n", (unsigned long long) branches[ i ].first.first, (unsigned long long) branches[ i ].first.second,
+                 (unsigned long long) branches[ i ].second );
+    fclose( fp );
+
+    tracer.Trace( "branch profile instructions by function:\n" );
+    for ( map<string, uint64_t>::iterator it = functions.begin(); it != functions.end(); it++ )
+        tracer.Trace( "  %16llu  %s\n", (unsigned long long) it->second, it->first.c_str() );
+
+    printf( "fdo: %zu ranges and %zu branches in %zu functions written to %s\n", ranges.size(), branches.size(), functions.size(),
+            g_branch_profile_path );
+} //write_branch_profile
+
+// -csim memory hierarchy model. every guest load and store goes through a private L1D, L2, and data TLB per guest
+// thread, like cores, with lru replacement and write-allocate. misses are counted per instruction and per 4K page, and
+// threads add theirs to g_memory_totals as they exit. at exit the miss rates are shown per function and the pages of
+// the brk and mmap heaps are written to HEAT_NAME with their access and miss counts.
+
+struct ModelCache
+{
+    uint32_t ways;
+    uint32_t set_mask;
+    uint32_t line_shift;
+    vector<uint64_t> tags;          // each set's lines, most recently used first. ~0 when empty
+
+    void initialize( uint64_t bytes, uint32_t w, uint32_t shift )
+    {
+        ways = w;
+        line_shift = shift;
+        uint64_t sets = bytes >> shift;
+        sets /= w;
+        set_mask = (uint32_t) ( sets - 1 );
+        tags.assign( sets * w, ~0ull );
+    } //initialize
+
+    bool access( uint64_t address ) // true on a hit
+    {
+        uint64_t line = address >> line_shift;
+        uint64_t * set = tags.data() + ( line & set_mask ) * ways;
+        uint32_t w = 0;
+        while ( ( w < ( ways - 1 ) ) && ( line != set[ w ] ) )
+            w++;
+        bool hit = ( line == set[ w ] );
+        memmove( set + 1, set, w * sizeof( uint64_t ) );
+        set[ 0 ] = line;
+        return hit;
+    } //access
+};
+
+struct MemoryCounts
+{
+    uint64_t accesses, l1_misses, l2_misses, tlb_misses;
+
+    void add( const MemoryCounts & c )
+    {
+        accesses += c.accesses;
+        l1_misses += c.l1_misses;
+        l2_misses += c.l2_misses;
+        tlb_misses += c.tlb_misses;
+    } //add
+};
+
+struct MemoryModel
+{
+    ModelCache l1, l2, tlb;
+    MemoryCounts total;
+    unordered_map<uint64_t, MemoryCounts> by_pc;
+    unordered_map<uint64_t, MemoryCounts> by_page;
+};
+
+struct MemoryModelConfig
+{
+    uint32_t l1_kb, l1_ways, l2_kb, l2_ways, tlb_entries;
+};
+
+static const uint32_t model_line_shift = 6;          // 64-byte cache lines
+static const uint32_t model_page_shift = 12;
+static bool g_memory_model_enabled = false;
+static MemoryModelConfig g_memory_config = { 64, 4, 1024, 8, 48 }; // like a Neoverse N1
+static MemoryModel g_memory_totals;                  // threads that have exited. guarded by thread_mutex
+static thread_local MemoryModel * g_memory_model = 0;
+
+static void model_access( MemoryModel & m, uint64_t pc, uint64_t address )
+{
+    MemoryCounts c = { 1, 0, 0, 0 };
+    if ( !m.tlb.access( address ) )
+        c.tlb_misses = 1;
+    if ( !m.l1.access( address ) )
+    {
+        c.l1_misses = 1;
+        if ( !m.l2.access( address ) )
+            c.l2_misses = 1;
+    }
+
+    m.total.add( c );
+    m.by_pc[ pc ].add( c );
+    m.by_page[ address >> model_page_shift ].add( c );
+} //model_access
+
+void emulator_memory_access( CPUClass & cpu, uint64_t address, uint32_t size, bool write )
+{
+    if ( 0 == g_memory_model )
+    {
+        MemoryModel * m = new MemoryModel();
+        m->l1.initialize( g_memory_config.l1_kb * 1024ull, g_memory_config.l1_ways, model_line_shift );
+        m->l2.initialize( g_memory_config.l2_kb * 1024ull, g_memory_config.l2_ways, model_line_shift );
+        m->tlb.initialize( (uint64_t) g_memory_config.tlb_entries << model_page_shift, g_memory_config.tlb_entries, model_page_shift );
+        g_memory_model = m;
+    }
+
+    // an access that straddles cache lines is an access to each of them. stores allocate like loads
+
+    uint64_t last = address + ( ( 0 == size ) ? 0 : ( size - 1 ) );
+    for ( uint64_t line = address >> model_line_shift; line <= ( last >> model_line_shift ); line++ )
+        model_access( *g_memory_model, cpu.pc, get_max( address, line << model_line_shift ) );
+} //emulator_memory_access
+
+static void collect_memory_model()
+{
+    // add this thread's counts to g_memory_totals. call with thread_mutex held
+
+    MemoryModel * m = g_memory_model;
+    if ( 0 == m )
+        return;
+
+    g_memory_totals.total.add( m->total );
+    for ( unordered_map<uint64_t, MemoryCounts>::iterator it = m->by_pc.begin(); it != m->by_pc.end(); it++ )
+        g_memory_totals.by_pc[ it->first ].add( it->second );
+    for ( unordered_map<uint64_t, MemoryCounts>::iterator it = m->by_page.begin(); it != m->by_page.end(); it++ )
+        g_memory_totals.by_page[ it->first ].add( it->second );
+    delete m;
+    g_memory_model = 0;
+} //collect_memory_model
+
+static bool valid_cache_shape( uint32_t kb, uint32_t ways )
+{
+    // the set count must be a power of 2 so a set is picked with a mask
+
+    if ( ( 0 == ways ) || ( ways > 64 ) || ( 0 == kb ) || ( kb > 1024 * 1024 ) )
+        return false;
+
+    uint64_t lines = ( kb * 1024ull ) >> model_line_shift;
+    uint64_t sets = lines / ways;
+    return ( 0 != sets ) && ( ( sets * ways ) == lines ) && ( 0 == ( sets & ( sets - 1 ) ) );
+} //valid_cache_shape
+
+static double miss_rate( uint64_t misses, uint64_t accesses )
+{
+    return ( 0 == accesses ) ? 0.0 : ( 100.0 * misses / accesses );
+} //miss_rate
+
+static bool memory_counts_compare( const pair<string, MemoryCounts> & a, const pair<string, MemoryCounts> & b )
+{
+    if ( a.second.l1_misses != b.second.l1_misses )
+        return a.second.l1_misses > b.second.l1_misses;
+    return a.second.accesses > b.second.accesses;
+} //memory_counts_compare
+
+static void show_memory_model()
+{
+    if ( !g_memory_model_enabled )
+        return;
+
+    lock_guard<mutex> lock( g_process->thread_mutex );
+    collect_memory_model();
+    g_memory_model_enabled = false;
+
+    const MemoryCounts & t = g_memory_totals.total;
+    char ac[ 100 ];
+    printf( "memory model: L1D %u KB %u-way, L2 %u KB %u-way, %u-byte lines, TLB %u entries of 4 KB pages\n", g_memory_config.l1_kb,
+            g_memory_config.l1_ways, g_memory_config.l2_kb, g_memory_config.l2_ways, 1u << model_line_shift, g_memory_config.tlb_entries );
+    printf( "  accesses:   %15s\n", CDJLTrace::RenderNumberWithCommas( t.accesses, ac ) );
+    printf( "  L1D misses: %15s %7.2f%%\n", CDJLTrace::RenderNumberWithCommas( t.l1_misses, ac ), miss_rate( t.l1_misses, t.accesses ) );
+    printf( "  L2 misses:  %15s %7.2f%% of L1D misses\n", CDJLTrace::RenderNumberWithCommas( t.l2_misses, ac ), miss_rate( t.l2_misses, t.l1_misses ) );
+    printf( "  TLB misses: %15s %7.2f%%\n", CDJLTrace::RenderNumberWithCommas( t.tlb_misses, ac ), miss_rate( t.tlb_misses, t.accesses ) );
+
+    map<string, MemoryCounts> functions;
+    char acpc[ 40 ];
+    for ( unordered_map<uint64_t, MemoryCounts>::iterator it = g_memory_totals.by_pc.begin(); it != g_memory_totals.by_pc.end(); it++ )
+        functions[ profile_frame_name( it->first, acpc, sizeof( acpc ) ) ].add( it->second );
+
+    vector<pair<string, MemoryCounts>> sorted( functions.begin(), functions.end() );
+    sort( sorted.begin(), sorted.end(), memory_counts_compare );
+    printf( "%15s %15s %7s %7s %7s  %s\n", "accesses", "L1D misses", "L1D%", "L2%", "TLB%", "function" );
+    for ( size_t i = 0; i < sorted.size() && i < 20; i++ )
+    {
+        const MemoryCounts & c = sorted[ i ].second;
+        printf( "%15s ", CDJLTrace::RenderNumberWithCommas( c.accesses, ac ) );
+        printf( "%15s %6.2f%% %6.2f%% %6.2f%%  %s\n", CDJLTrace::RenderNumberWithCommas( c.l1_misses, ac ), miss_rate( c.l1_misses, c.accesses ),
+                miss_rate( c.l2_misses, c.l1_misses ), miss_rate( c.tlb_misses, c.accesses ), sorted[ i ].first.c_str() );
+    }
+
+    // the heatmap covers the brk heap as high as it got and the mmap arena
+
+    uint64_t brk_lo = g_process->base_address + g_process->end_of_data;
+    uint64_t brk_hi = g_process->base_address + g_process->highwater_brk;
+    uint64_t mmap_lo = g_process->base_address + g_process->mmap_offset;
+    uint64_t mmap_hi = mmap_lo + g_process->mmap_commit;
+    map<uint64_t, MemoryCounts> pages;
+    for ( unordered_map<uint64_t, MemoryCounts>::iterator it = g_memory_totals.by_page.begin(); it != g_memory_totals.by_page.end(); it++ )
+    {
+        uint64_t a = it->first << model_page_shift;
+        if ( ( ( a + ( 1ull << model_page_shift ) ) > brk_lo && a < brk_hi ) || ( a >= mmap_lo && a < mmap_hi ) )
+            pages[ a ] = it->second;
+    }
+
+    FILE * fp = fopen( HEAT_NAME, "w" );
+    if ( 0 != fp )
+    {
+        fprintf( fp, "%-6s %16s %15s %15s %15s\n", "region", "page", "accesses", "L1D misses", "TLB misses" );
+        for ( map<uint64_t, MemoryCounts>::iterator it = pages.begin(); it != pages.end(); it++ )
+            fprintf( fp, "%-6s %16llx %15llu %15llu %15llu\n", ( it->first >= mmap_lo && it->first < mmap_hi ) ? "mmap" : "brk",
+                     (unsigned long long) it->first, (unsigned long long) it->second.accesses, (unsigned long long) it->second.l1_misses,
+                     (unsigned long long) it->second.tlb_misses );
+        fclose( fp );
+        printf( "heatmap of %zu brk and mmap pages written to %s\n", pages.size(), HEAT_NAME );
+    }
+} //show_memory_model
+
+#else
+
+#define BLOCKING_CALL( x ) x
+
+#endif //ARMOS
+
+static int read_stdin( void * buffer, uint32_t buffer_size )
+{
+    // pipes and files get one host read per call rather than one per byte. the console delivers a character at a time
+
+    if ( ConsoleConfiguration::stdin_redirected() )
+    {
+        int r = ConsoleConfiguration::redirected_read( (char *) buffer, (int) buffer_size );
+        tracer.Trace( "  read %d bytes from redirected stdin\n", r );
+        return r;
+    }
+
+    if ( 0 == buffer_size )
+        return 0;
+
+#ifdef _WIN32
+    int r = g_consoleConfig.linux_getch();
+#else
+    int r = g_consoleConfig.portable_getch();
+#endif
+    if ( EOF == r )
+    {
+        tracer.Trace( "  getch reached the end of file on stdin\n" );
+        return 0;
+    }
+
+    * (char *) buffer = (char) r;
+    tracer.Trace( "  getch read character %u == '%c'\n", (uint8_t) r, printable( (uint8_t) r ) );
+    return 1;
+} //read_stdin
+
+#if !defined( OLDGCC ) && !defined( __mc68000__ )
+
+static int64_t host_file_size( int fd )
+{
+#ifdef _WIN32
+    return _filelengthi64( fd );
+#else
+    struct stat st;
+    return ( 0 == fstat( fd, &st ) ) ? (int64_t) st.st_size : -1;
+#endif
+} //host_file_size
+
+static int64_t host_pread( int fd, void * buf, size_t len, uint64_t offset )
+{
+#ifdef _WIN32
+    int64_t original = _lseeki64( fd, 0, SEEK_CUR ); // the app's file position must not move
+    if ( -1 == _lseeki64( fd, offset, SEEK_SET ) )
+        return -1;
+    int64_t result = _read( fd, buf, (unsigned int) len );
+    _lseeki64( fd, original, SEEK_SET );
+    return result;
+#else
+    return pread( fd, buf, len, (off_t) offset );
+#endif
+} //host_pread
+
+static int64_t host_pwrite( int fd, const void * buf, size_t len, uint64_t offset )
+{
+#ifdef _WIN32
+    int64_t original = _lseeki64( fd, 0, SEEK_CUR );
+    if ( -1 == _lseeki64( fd, offset, SEEK_SET ) )
+        return -1;
+    int64_t result = _write( fd, buf, (unsigned int) len );
+    _lseeki64( fd, original, SEEK_SET );
+    return result;
+#else
+    return pwrite( fd, buf, len, (off_t) offset );
+#endif
+} //host_pwrite
+
+static void write_back_file_mapping( REG_TYPE address, const FileMapping & fm, REG_TYPE start, REG_TYPE length )
+{
+    // copy [start, start + length) of a copied MAP_SHARED mapping back to the file. it never grows the file, like Linux
+
+    if ( -1 == fm.fd )
+        return;
+
+    int64_t file_size = host_file_size( fm.fd );
+    uint64_t file_start = fm.file_offset + ( start - address );
+    if ( ( file_size < 0 ) || ( file_start >= (uint64_t) file_size ) )
+        return;
+
+    uint64_t len = get_min( (uint64_t) length, (uint64_t) file_size - file_start );
+    int64_t written = host_pwrite( fm.fd, g_process->vm_memory.data() + ( start - g_process->base_address ), (size_t) len, file_start );
+    tracer.Trace( "  wrote back %lld of %llu bytes of mapped data to file offset %llu\n", written, len, file_start );
+} //write_back_file_mapping
+
+static bool map_file_into_memory( REG_TYPE address, REG_TYPE length, int fd, uint64_t file_offset, bool shared, bool writable )
+{
+    FileMapping fm;
+    fm.length = length;
+    fm.file_offset = file_offset;
+    fm.fd = -1;
+    fm.host_mapped = false;
+
+#ifdef ARMOS
+    if ( g_process->vm_memory.can_map_files() )
+    {
+        if ( !g_process->vm_memory.map_file( address - g_process->base_address, length, fd, file_offset, shared, writable ) )
+        {
+            tracer.Trace( "  host mmap of the file failed, errno %d\n", errno );
+            return false;
+        }
+
+        tracer.Trace( "  mapped fd %d offset %llu into guest memory at %llx\n", fd, file_offset, address );
+        fm.host_mapped = true;
+        g_process->file_mappings[ address ] = fm;
+        return true;
+    }
+#endif
+
+    // copy the file's data. the allocation is already zero beyond the end of the file
+
+    uint8_t * p = g_process->vm_memory.data() + ( address - g_process->base_address );
+    uint64_t done = 0;
+    while ( done < length )
+    {
+        int64_t r = host_pread( fd, p + done, (size_t) ( length - done ), file_offset + done );
+        if ( r < 0 )
+            return false;
+        if ( 0 == r )
+            break;
+        done += r;
+    }
+
+    if ( shared && writable )
+        fm.fd = dup( fd );
+
+    tracer.Trace( "  copied %llu bytes of fd %d offset %llu to %llx\n", done, fd, file_offset, address );
+    g_process->file_mappings[ address ] = fm;
+    return true;
+} //map_file_into_memory
+
+#if defined( ARMOS ) && !defined( _WIN32 )
+static bool map_shared_memory( REG_TYPE address, REG_TYPE length )
+{
+    // MAP_SHARED | MAP_ANONYMOUS memory must stay shared with children made by fork, so it's host shared memory. it's
+    // kept with the file mappings so munmap and MAP_FIXED put private memory back
+
+    if ( !g_process->vm_memory.can_map_files() )
+    {
+        errno = ENODEV;
+        return false;
+    }
+
+    if ( !g_process->vm_memory.map_shared( address - g_process->base_address, length ) )
+    {
+        tracer.Trace( "  host mmap of shared memory failed, errno %d\n", errno );
+        return false;
+    }
+
+    FileMapping fm;
+    fm.length = length;
+    fm.file_offset = 0;
+    fm.fd = -1;
+    fm.host_mapped = true;
+    g_process->file_mappings[ address ] = fm;
+    return true;
+} //map_shared_memory
+#endif
+
+static bool is_file_mapped( REG_TYPE a, REG_TYPE l )
+{
+    map<REG_TYPE, FileMapping>::iterator it = g_process->file_mappings.lower_bound( a );
+    if ( ( it != g_process->file_mappings.end() ) && ( it->first < ( a + l ) ) )
+        return true;
+    if ( it == g_process->file_mappings.begin() )
+        return false;
+    it--;
+    return ( ( it->first + it->second.length ) > a );
+} //is_file_mapped
+
+static void release_file_mappings( REG_TYPE a, REG_TYPE l )
+{
+    // munmap or MAP_FIXED over part or all of some file mappings. what's left of each mapping on either side stays
+
+    map<REG_TYPE, FileMapping>::iterator it = g_process->file_mappings.lower_bound( a );
+    if ( it != g_process->file_mappings.begin() )
+        it--;
+
+    while ( ( it != g_process->file_mappings.end() ) && ( it->first < ( a + l ) ) )
+    {
+        REG_TYPE start = it->first;
+        REG_TYPE end = start + it->second.length;
+        if ( end <= a )
+        {
+            it++;
+            continue;
+        }
+
+        FileMapping fm = it->second;
+        g_process->file_mappings.erase( it++ );
+
+        REG_TYPE cut_start = get_max( start, a );
+        REG_TYPE cut_end = get_min( end, a + l );
+        write_back_file_mapping( start, fm, cut_start, cut_end - cut_start );
+#ifdef ARMOS
+        if ( fm.host_mapped )
+            g_process->vm_memory.unmap_file( cut_start - g_process->base_address, cut_end - cut_start );
+#endif
+
+        bool head = ( start < cut_start );
+        if ( head )
+        {
+            FileMapping h = fm;
+            h.length = cut_start - start;
+            g_process->file_mappings[ start ] = h;
+        }
+
+        if ( cut_end < end )
+        {
+            FileMapping t = fm;
+            t.length = end - cut_end;
+            t.file_offset += cut_end - start;
+            if ( head && ( -1 != fm.fd ) )
+                t.fd = dup( fm.fd ); // each piece owns its descriptor
+            g_process->file_mappings[ cut_end ] = t;
+        }
+        else if ( !head && ( -1 != fm.fd ) )
+            close( fm.fd );
+    }
+} //release_file_mappings
+
+static void sync_file_mappings( REG_TYPE a, REG_TYPE l, bool wait )
+{
+    for ( map<REG_TYPE, FileMapping>::iterator it = g_process->file_mappings.begin(); it != g_process->file_mappings.end(); it++ )
+    {
+        REG_TYPE start = get_max( it->first, a );
+        REG_TYPE end = get_min( it->first + it->second.length, a + l );
+        if ( start >= end )
+            continue;
+
+#ifdef ARMOS
+        if ( it->second.host_mapped )
+            g_process->vm_memory.sync_file( start - g_process->base_address, end - start, wait );
+#endif
+        write_back_file_mapping( it->first, it->second, start, end - start );
+    }
+} //sync_file_mappings
+
+// readv, writev, preadv, and pwritev. the guest's iovec array is translated in one pass to host iovecs that point
+// into guest memory so each syscall is one host call. Windows has no scatter/gather file I/O, so there writes are
+// gathered into one buffer and reads are scattered from one.
+
+struct guest_iovec
+{
+    REG_TYPE iov_base;
+    REG_TYPE iov_len;
+};
+
+static REG_TYPE swap_endian_reg( REG_TYPE x )
+{
+    return ( 8 == sizeof( REG_TYPE ) ) ? (REG_TYPE) swap_endian64( (uint64_t) x ) : (REG_TYPE) swap_endian32( (uint32_t) x );
+} //swap_endian_reg
+
+static size_t translate_iovecs( CPUClass & cpu, REG_TYPE address, REG_TYPE count, vector<iovec> & vecs )
+{
+    // returns the total length. the caller validates count against UIO_MAXIOV
+
+    vecs.resize( (size_t) count );
+    const guest_iovec * pvec = (const guest_iovec *) cpu.getmem( address );
+    size_t total = 0;
+    for ( size_t i = 0; i < (size_t) count; i++ )
+    {
+        REG_TYPE base = swap_endian_reg( pvec[ i ].iov_base );
+        REG_TYPE len = swap_endian_reg( pvec[ i ].iov_len );
+        vecs[ i ].iov_base = ( 0 == len ) ? 0 : cpu.getmem( base ); // empty elements may have any base
+        vecs[ i ].iov_len = (size_t) len;
+        total += (size_t) len;
+        tracer.Trace( "    iovec %zu: base %llx, length %llu\n", i, (uint64_t) base, (uint64_t) len );
+    }
+    return total;
+} //translate_iovecs
+
+#ifdef ARMOS_HOST_SOCKETS
+
+struct guest_msghdr
+{
+    uint64_t msg_name;
+    uint32_t msg_namelen;
+    uint32_t padding;
+    uint64_t msg_iov;
+    uint64_t msg_iovlen;
+    uint64_t msg_control;
+    uint64_t msg_controllen;
+    int32_t msg_flags;
+};
+
+struct guest_epoll_event           // the host's is packed to 12 bytes on AMD64
+{
+    uint32_t events;
+    uint32_t padding;
+    uint64_t data;
+};
+
+static void * guest_pointer( CPUClass & cpu, uint64_t address )
+{
+    return ( 0 == address ) ? 0 : cpu.getmem( address );
+} //guest_pointer
+
+static void ignore_sigpipe()
+{
+    // writes to a socket the peer closed fail with EPIPE rather than ending armos
+
+    static bool ignoring = false;
+    if ( !ignoring )
+    {
+        signal( SIGPIPE, SIG_IGN );
+        ignoring = true;
+    }
+} //ignore_sigpipe
+
+static int64_t socket_message( CPUClass & cpu, int fd, uint64_t address, int flags, bool sending, SyscallLock & syscall_lock )
+{
+    // sendmsg and recvmsg. the msghdr and iovecs hold guest pointers, so they're translated. data, names, and
+    // ancillary data stay in guest memory
+
+    guest_msghdr * pg = (guest_msghdr *) cpu.getmem( address );
+    if ( pg->msg_iovlen > 1024 ) // UIO_MAXIOV
+    {
+        errno = EMSGSIZE;
+        return -1;
+    }
+
+    vector<iovec> vecs;
+    if ( 0 != pg->msg_iovlen )
+        translate_iovecs( cpu, pg->msg_iov, pg->msg_iovlen, vecs );
+
+    struct msghdr m;
+    memset( &m, 0, sizeof( m ) );
+    m.msg_name = guest_pointer( cpu, pg->msg_name );
+    m.msg_namelen = pg->msg_namelen;
+    m.msg_iov = vecs.data();
+    m.msg_iovlen = vecs.size();
+    m.msg_control = guest_pointer( cpu, pg->msg_control );
+    m.msg_controllen = pg->msg_controllen;
+
+    ssize_t result;
+    if ( sending )
+        BLOCKING_CALL( result = sendmsg( fd, &m, flags ) )
+    else
+    {
+        BLOCKING_CALL( result = recvmsg( fd, &m, flags ) );
+        if ( result >= 0 )
+        {
+            pg->msg_namelen = m.msg_namelen;
+            pg->msg_controllen = m.msg_controllen;
+            pg->msg_flags = m.msg_flags;
+        }
+    }
+    return result;
+} //socket_message
+
+#endif //ARMOS_HOST_SOCKETS
+
+static int64_t host_writev( int fd, const vector<iovec> & vecs, size_t total, int64_t offset ) // offset -1: current position
+{
+#ifdef _WIN32
+    const void * p = ( 1 == vecs.size() ) ? vecs[ 0 ].iov_base : 0;
+    vector<uint8_t> gathered;
+    if ( 1 != vecs.size() )
+    {
+        gathered.resize( total );
+        size_t done = 0;
+        for ( size_t i = 0; i < vecs.size(); i++ )
+        {
+            memcpy( gathered.data() + done, vecs[ i ].iov_base, vecs[ i ].iov_len );
+            done += vecs[ i ].iov_len;
+        }
+        p = gathered.data();
+    }
+
+    if ( -1 != offset )
+        return host_pwrite( fd, p, total, (uint64_t) offset );
+    if ( 1 == fd || 2 == fd )
+        return WinWrite( fd, (const uint8_t *) p, (int) total );
+    return _write( fd, p, (unsigned) total );
+#else
+    if ( -1 != offset )
+    {
+        if ( 1 == vecs.size() )
+            return pwrite( fd, vecs[ 0 ].iov_base, vecs[ 0 ].iov_len, (off_t) offset );
+        return pwritev( fd, vecs.data(), (int) vecs.size(), (off_t) offset );
+    }
+    return writev( fd, vecs.data(), (int) vecs.size() );
+#endif
+} //host_writev
+
+static int64_t host_readv( int fd, const vector<iovec> & vecs, size_t total, int64_t offset ) // offset -1: current position
+{
+#ifdef _WIN32
+    if ( 1 == vecs.size() )
+    {
+        if ( -1 != offset )
+            return host_pread( fd, vecs[ 0 ].iov_base, total, (uint64_t) offset );
+        return _read( fd, vecs[ 0 ].iov_base, (unsigned) total );
+    }
+
+    vector<uint8_t> scattered( total );
+    int64_t result = ( -1 != offset ) ? host_pread( fd, scattered.data(), total, (uint64_t) offset ) : _read( fd, scattered.data(), (unsigned) total );
+    size_t done = 0;
+    for ( size_t i = 0; ( i < vecs.size() ) && ( (int64_t) done < result ); i++ )
+    {
+        size_t len = get_min( vecs[ i ].iov_len, (size_t) ( result - done ) );
+        memcpy( vecs[ i ].iov_base, scattered.data() + done, len );
+        done += len;
+    }
+    return result;
+#else
+    if ( -1 != offset )
+    {
+        if ( 1 == vecs.size() )
+            return pread( fd, vecs[ 0 ].iov_base, vecs[ 0 ].iov_len, (off_t) offset );
+        return preadv( fd, vecs.data(), (int) vecs.size(), (off_t) offset );
+    }
+    return readv( fd, vecs.data(), (int) vecs.size() );
+#endif
+} //host_readv
+
+#endif // !defined( OLDGCC ) && !defined( __mc68000__ )
+
+#ifdef ARMOS
+
+// guest RAM is reserved up front and committed as the app uses it. the image, vdso, arguments, stack, and aux records
+// are committed at load along with the brk heap as high as it has been. brk and the mmap arena commit as they grow
+
+static bool commit_fixed_regions()
+{
+    return g_process->vm_memory.commit( 0, (size_t) g_process->highwater_brk ) &&
+           g_process->vm_memory.commit( (size_t) g_process->bottom_of_stack, (size_t) ( g_process->mmap_offset - g_process->bottom_of_stack ) );
+} //commit_fixed_regions
+
+static bool commit_mmap_range( void * context, uint64_t address, uint64_t length )
+{
+    EmulatedProcess * process = (EmulatedProcess *) context;
+    return process->vm_memory.commit( (size_t) ( address - process->base_address ), (size_t) length );
+} //commit_mmap_range
+
+static void discard_mmap_range( void * context, uint64_t address, uint64_t length )
+{
+    EmulatedProcess * process = (EmulatedProcess *) context;
+    process->vm_memory.discard( (size_t) ( address - process->base_address ), (size_t) length );
+} //discard_mmap_range
+
+// -snap and -restore. a snapshot is the cpu, the memory layout, the mmap arena's allocations, and every page of guest
+// memory that isn't zero. pages are 4k-aligned in the file so a restore can map them copy-on-write instead of reading
+// them. host state like open descriptors isn't captured, so the snapshot should be taken before the app opens files.
+// the file is in host byte order, like the trace ring.
+
+struct SnapshotHeader
+{
+    char magic[ 8 ];                // "armsnap1"
+    uint64_t header_size;           // sizeof( SnapshotHeader ) in the build that wrote it
+    uint64_t image_size;            // of the app, so a rebuilt app isn't resumed with stale memory
+    uint64_t image_mtime;
+    uint64_t base_address;
+    uint64_t memory_size;
+    uint64_t brk_offset;
+    uint64_t highwater_brk;
+    uint64_t end_of_data;
+    uint64_t bottom_of_stack;
+    uint64_t top_of_stack;
+    uint64_t mmap_offset;
+    uint64_t mmap_commit;
+    uint64_t stack_commit;
+    uint64_t arg_data_offset;
+    uint64_t mmap_state_count;      // uint64_t values from CMMap::save() that follow the header
+    uint64_t page_run_count;        // ( first page, page count ) pairs that follow the mmap state
+    uint64_t pages_offset;          // 4k-aligned file offset of the data for the first page run
+    Arm64::ArchState state;
+};
+
+static const char g_snapshot_magic[ 8 ] = { 'a', 'r', 'm', 's', 'n', 'a', 'p', '1' };
+static const char * g_snapshot_path = 0;             // -snap: where to write the snapshot. cleared once it's written
+static const char * g_snapshot_app = 0;              // the app, whose size and time are recorded in the snapshot
+
+static bool image_identity( const char * app, uint64_t & size, uint64_t & mtime )
+{
+    struct stat st;
+    if ( 0 != stat( app, &st ) )
+        return false;
+
+    size = (uint64_t) st.st_size;
+    mtime = (uint64_t) st.st_mtime;
+    return true;
+} //image_identity
+
+static bool page_is_zero( const uint8_t * p )
+{
+    const uint64_t * p64 = (const uint64_t *) p;
+    for ( size_t i = 0; i < 4096 / sizeof( uint64_t ); i++ )
+        if ( 0 != p64[ i ] )
+            return false;
+    return true;
+} //page_is_zero
+
+static bool write_snapshot( CPUClass & cpu, uint64_t resume_pc )
+{
+    const char * path = g_snapshot_path;
+    g_snapshot_path = 0; // one snapshot per run
+
+    {
+        lock_guard<mutex> lock( g_process->thread_mutex );
+        if ( !g_process->threads.empty() )
+        {
+            printf( "can't write snapshot %s: the app has started threads\n", path );
+            return false;
+        }
+    }
+
+    if ( !g_process->file_mappings.empty() )
+    {
+        printf( "can't write snapshot %s: the app has mapped files\n", path );
+        return false;
+    }
+
+    SnapshotHeader h;
+    memset( &h, 0, sizeof( h ) );
+    memcpy( h.magic, g_snapshot_magic, sizeof( h.magic ) );
+    h.header_size = sizeof( h );
+    if ( !image_identity( g_snapshot_app, h.image_size, h.image_mtime ) )
+    {
+        printf( "can't write snapshot %s: can't find the app %s\n", path, g_snapshot_app );
+        return false;
+    }
+
+    h.base_address = g_process->base_address;
+    h.memory_size = g_process->vm_memory.size();
+    h.brk_offset = g_process->brk_offset;
+    h.highwater_brk = g_process->highwater_brk;
+    h.end_of_data = g_process->end_of_data;
+    h.bottom_of_stack = g_process->bottom_of_stack;
+    h.top_of_stack = g_process->top_of_stack;
+    h.mmap_offset = g_process->mmap_offset;
+    h.mmap_commit = g_process->mmap_commit;
+    h.stack_commit = g_process->stack_commit;
+    h.arg_data_offset = g_process->arg_data_offset;
+    cpu.save_state( h.state );
+    h.state.pc = resume_pc;
+
+    vector<uint64_t> mmap_state;
+    g_process->mmap_arena.save( mmap_state );
+    h.mmap_state_count = mmap_state.size();
+
+    // only committed memory can hold data. reading untouched pages maps the host's shared zero page, so the scan
+    // doesn't cost RAM. committed ranges are page-rounded like the reservation
+
+    vector<uint64_t> runs;
+    uint64_t data_pages = 0;
+    const map<size_t, size_t> & ranges = g_process->vm_memory.committed_ranges();
+    for ( map<size_t, size_t>::const_iterator it = ranges.begin(); it != ranges.end(); it++ )
+    {
+        uint64_t last = ( it->first + it->second ) / 4096;
+        for ( uint64_t page = it->first / 4096; page < last; page++ )
+        {
+            if ( page_is_zero( g_process->vm_memory.data() + page * 4096 ) )
+                continue;
+
+            if ( !runs.empty() && ( ( runs[ runs.size() - 2 ] + runs.back() ) == page ) )
+                runs.back()++;
+            else
+            {
+                runs.push_back( page );
+                runs.push_back( 1 );
+            }
+            data_pages++;
+        }
+    }
+
+    h.page_run_count = runs.size() / 2;
+    h.pages_offset = round_up( (uint64_t) ( sizeof( h ) + ( mmap_state.size() + runs.size() ) * sizeof( uint64_t ) ), (uint64_t) 4096 );
+
+    FILE * fp = fopen( path, "wb" );
+    if ( 0 == fp )
+    {
+        printf( "can't create snapshot %s, error %d\n", path, errno );
+        return false;
+    }
+
+    static const uint8_t zeroes[ 4096 ] = {0};
+    uint64_t header_bytes = sizeof( h ) + ( mmap_state.size() + runs.size() ) * sizeof( uint64_t );
+    bool ok = ( 1 == fwrite( &h, sizeof( h ), 1, fp ) ) &&
+              ( mmap_state.size() == fwrite( mmap_state.data(), sizeof( uint64_t ), mmap_state.size(), fp ) ) &&
+              ( runs.size() == fwrite( runs.data(), sizeof( uint64_t ), runs.size(), fp ) ) &&
+              ( ( h.pages_offset == header_bytes ) || ( 1 == fwrite( zeroes, (size_t) ( h.pages_offset - header_bytes ), 1, fp ) ) );
+
+    for ( size_t i = 0; ok && ( i < runs.size() ); i += 2 )
+        ok = ( runs[ i + 1 ] == fwrite( g_process->vm_memory.data() + runs[ i ] * 4096, 4096, (size_t) runs[ i + 1 ], fp ) );
+
+    ok = ( 0 == fclose( fp ) ) && ok;
+    if ( !ok )
+    {
+        printf( "can't write snapshot %s, error %d\n", path, errno );
+        remove( path );
+        return false;
+    }
+
+    tracer.Trace( "wrote snapshot %s resuming at pc %llx: %llu pages in %llu runs, %zu mmap allocations\n", path, resume_pc,
+                  data_pages, h.page_run_count, ( mmap_state.size() - 2 ) / 2 );
+    return true;
+} //write_snapshot
+
+void emulator_breakpoint( CPUClass & cpu )
+{
+    if ( 0 != g_snapshot_path )
+        write_snapshot( cpu, cpu.pc );
+} //emulator_breakpoint
+
+// -f runs common C library routines, found by symbol, as host code on guest memory. each takes its arguments in
+// x0..x2, leaves its result in x0, and returns to x30 like the guest routine would. they work on bytes, so guest data
+// needs no conversion on big-endian hosts. a call that reaches outside guest memory is declined so the guest's own
+// code runs and faults as usual
+
+enum HostRoutine { hr_memcpy = 0, hr_memmove, hr_memset, hr_memcmp, hr_strlen, hr_strchr, hr_count };
+static const char * g_host_routine_names[ hr_count ] = { "memcpy", "memmove", "memset", "memcmp", "strlen", "strchr" };
+static bool g_host_routines = false;                        // -f
+static atomic<uint64_t> g_host_routine_calls[ hr_count ];   // for -p
+
+static bool guest_range( CPUClass & cpu, uint64_t address, uint64_t length )
+{
+    // is all of [address, address + length) in guest memory? written so huge lengths can't wrap
+
+    return ( address >= cpu.base ) && ( length <= cpu.mem_size ) && ( ( address - cpu.base ) <= ( cpu.mem_size - length ) );
+} //guest_range
+
+static bool guest_string_length( CPUClass & cpu, uint64_t address, uint64_t & length )
+{
+    // false if the string isn't terminated before the end of guest memory
+
+    if ( !guest_range( cpu, address, 1 ) )
+        return false;
+
+    const uint8_t * p = cpu.getmem( address );
+    const uint8_t * pnull = (const uint8_t *) memchr( p, 0, (size_t) ( cpu.mem_size - ( address - cpu.base ) ) );
+    if ( 0 == pnull )
+        return false;
+
+    length = (uint64_t) ( pnull - p );
+    return true;
+} //guest_string_length
+
+bool emulator_intercept( CPUClass & cpu, uint32_t routine )
+{
+    uint64_t a0 = cpu.regs[ 0 ];
+    uint64_t a1 = cpu.regs[ 1 ];
+    uint64_t a2 = cpu.regs[ 2 ];
+    uint64_t result = 0;
+
+    switch ( routine )
+    {
+        case hr_memcpy: // glibc's memcpy allows overlap like memmove, so apps that get away with it still work
+        case hr_memmove:
+        {
+            if ( !guest_range( cpu, a0, a2 ) || !guest_range( cpu, a1, a2 ) )
+                return false;
+            if ( 0 != a2 )
+            {
+                cpu.check_code_write( a0, a2 );
+                memmove( cpu.getmem( a0 ), cpu.getmem( a1 ), (size_t) a2 );
+            }
+            result = a0;
+            break;
+        }
+        case hr_memset:
+        {
+            if ( !guest_range( cpu, a0, a2 ) )
+                return false;
+            if ( 0 != a2 )
+            {
+                cpu.check_code_write( a0, a2 );
+                memset( cpu.getmem( a0 ), (uint8_t) a1, (size_t) a2 );
+            }
+            result = a0;
+            break;
+        }
+        case hr_memcmp:
+        {
+            if ( !guest_range( cpu, a0, a2 ) || !guest_range( cpu, a1, a2 ) )
+                return false;
+            int r = ( 0 == a2 ) ? 0 : memcmp( cpu.getmem( a0 ), cpu.getmem( a1 ), (size_t) a2 );
+            result = (uint32_t) ( ( r < 0 ) ? -1 : ( r > 0 ) ? 1 : 0 ); // an int in w0, as glibc returns it
+            break;
+        }
+        case hr_strlen:
+        {
+            if ( !guest_string_length( cpu, a0, result ) )
+                return false;
+            break;
+        }
+        case hr_strchr:
+        {
+            uint64_t length;
+            if ( !guest_string_length( cpu, a0, length ) )
+                return false;
+
+            uint8_t c = (uint8_t) a1;
+            if ( 0 == c )
+                result = a0 + length; // the terminator
+            else
+            {
+                const uint8_t * p = cpu.getmem( a0 );
+                const uint8_t * pfound = (const uint8_t *) memchr( p, c, (size_t) length );
+                result = ( 0 == pfound ) ? 0 : a0 + (uint64_t) ( pfound - p );
+            }
+            break;
+        }
+        default:
+            return false;
+    }
+
+    g_host_routine_calls[ routine ].fetch_add( 1, memory_order_relaxed );
+    cpu.regs[ 0 ] = result;
+    cpu.pc = cpu.regs[ 30 ];
+    return true;
+} //emulator_intercept
+
+static bool host_routine_matches( const char * name, const char * routine )
+{
+    // the routine itself or one of glibc's variants like __memcpy_generic and __strlen_asimd. not the fortified
+    // __memcpy_chk and friends, which take an extra destination size and abort if it's too small
+
+    if ( !strcmp( name, routine ) )
+        return true;
+
+    size_t len = strlen( routine );
+    return ( '_' == name[ 0 ] ) && ( '_' == name[ 1 ] ) && !strncmp( name + 2, routine, len ) && ( '_' == name[ len + 2 ] ) &&
+           ( 0 != name[ len + 3 ] ) && strcmp( name + len + 3, "chk" );
+} //host_routine_matches
+
+static void ensure_symbols();
+
+static void enable_host_routines( CPUClass & cpu )
+{
+    // only STT_FUNC symbols. glibc's memcpy, strlen, etc. are STT_GNU_IFUNC resolvers that return the variant to call
+
+    const uint8_t stt_func = 2;
+    ensure_symbols();
+
+    vector<uint64_t> addresses;
+    vector<uint32_t> routines;
+    for ( size_t i = 0; i < g_process->symbols.size(); i++ )
+    {
+        if ( stt_func != ( g_process->symbols[ i ].info & 0xf ) )
+            continue;
+
+        const char * name = & g_process->string_table[ g_process->symbols[ i ].name ];
+        for ( uint32_t r = 0; r < hr_count; r++ )
+        {
+            if ( host_routine_matches( name, g_host_routine_names[ r ] ) )
+            {
+                tracer.Trace( "  %s at %llx runs as host %s\n", name, g_process->symbols[ i ].value, g_host_routine_names[ r ] );
+                addresses.push_back( g_process->symbols[ i ].value );
+                routines.push_back( r );
+                break;
+            }
+        }
+    }
+
+    tracer.Trace( "%zu library routines run as host code\n", addresses.size() );
+    cpu.set_intercepts( addresses.data(), routines.data(), (uint32_t) addresses.size() );
+} //enable_host_routines
+
+static void show_host_routine_calls()
+{
+    char ac[ 100 ];
+    for ( uint32_t r = 0; r < hr_count; r++ )
+    {
+        char label[ 40 ];
+        snprintf( label, sizeof( label ), "host %s calls:", g_host_routine_names[ r ] );
+        printf( "%-22s %15s\n", label, CDJLTrace::RenderNumberWithCommas( g_host_routine_calls[ r ].load(), ac ) );
+    }
+} //show_host_routine_calls
+
+// apps look for clock_gettime() and gettimeofday() in the kernel's vdso, found through the AT_SYSINFO_EHDR aux
+// record, and call them rather than making syscalls. armos' vdso is one page after the image with a minimal shared
+// object: enough dynamic section, hash table, and symbols for glibc, musl, and Go to find the routines. they read
+// clocks with mrs of S3_3_C15_C0_<clock>, which the cpu answers from emulator_clock() without leaving run(). other
+// clocks, time zones, and clock reads that fail (all ones) make the syscall like the kernel's vdso does
+
+static const uint64_t vdso_size = 4096;
+
+static const uint32_t vdso_code[] =
+{
+    // __kernel_clock_gettime( clockid_t w0, struct timespec * x1 ). CLOCK_MONOTONIC is checked first
+
+    0x7100041f, 0x54000161, 0xd53bf022,                         // cmp w0, #1; b.ne other; mrs x2, S3_3_C15_C0_1
+    0xb100045f, 0x540001a0,                                     // split: cmn x2, #1; b.eq syscall
+    0xd2994003, 0xf2a77343, 0x9ac30844, 0x9b038885,             // x3 = 1000000000; x4 = x2 / x3; x5 = x2 - x4 * x3
+    0xa9001424, 0xd2800000, 0xd65f03c0,                         // stp x4, x5, [x1]; mov x0, #0; ret
+    0x71001c1f, 0x54000088, 0x100000c9, 0x8b204d29, 0xd61f0120, // other: cmp w0, #7; b.hi syscall; adr x9, reads; add x9, x9, w0, uxtw #3; br x9
+    0xd2800e28, 0xd4000001, 0xd65f03c0,                         // syscall: mov x8, #113 (clock_gettime); svc #0; ret
+    0xd53bf002, 0x17ffffee, 0xd53bf022, 0x17ffffec,             // reads: mrs x2, S3_3_C15_C0_<clock>; b split, for clocks 0..7
+    0xd53bf042, 0x17ffffea, 0xd53bf062, 0x17ffffe8,
+    0xd53bf082, 0x17ffffe6, 0xd53bf0a2, 0x17ffffe4,
+    0xd53bf0c2, 0x17ffffe2, 0xd53bf0e2, 0x17ffffe0,
+
+    // __kernel_gettimeofday( struct timeval * x0, struct timezone * x1 )
+
+    0xb50001c1, 0xb4000160, 0xd53bf002,                         // cbnz x1, syscall; cbz x0, done; mrs x2, S3_3_C15_C0_0
+    0xb100045f, 0x54000140, 0xd2807d03, 0x9ac30842,             // cmn x2, #1; b.eq syscall; x2 /= 1000
+    0xd2884803, 0xf2a001e3, 0x9ac30844, 0x9b038885, 0xa9001404, // x3 = 1000000; x4 = x2 / x3; x5 = x2 - x4 * x3; stp x4, x5, [x0]
+    0xd2800000, 0xd65f03c0,                                     // done: mov x0, #0; ret
+    0xd2801528, 0xd4000001, 0xd65f03c0,                         // syscall: mov x8, #169 (gettimeofday); svc #0; ret
+};
+
+static void build_vdso( uint8_t * pvdso )
+{
+    // the page is zero. from the start: elf header, PT_LOAD and PT_DYNAMIC headers, dynamic section, hash table,
+    // symbols, strings, and code. it's linked at address 0, so every address in it is an offset in the page
+
+    static const char * names[] = { "__kernel_clock_gettime", "__kernel_gettimeofday" };
+    static const uint32_t starts[] = { 0, 36, (uint32_t) _countof( vdso_code ) }; // in vdso_code[]
+    const uint32_t symbol_count = 1 + _countof( names ); // symbol 0 is the undefined symbol
+    const uint32_t dynamic_count = 7;
+
+    uint64_t dynamic_offset = sizeof( ElfHeader64 ) + 2 * sizeof( ElfProgramHeader64 );
+    uint64_t hash_offset = dynamic_offset + dynamic_count * 2 * sizeof( uint64_t );
+    uint64_t symbol_offset = round_up( hash_offset + ( 3 + symbol_count ) * sizeof( uint32_t ), (uint64_t) 8 );
+    uint64_t string_offset = symbol_offset + symbol_count * sizeof( ElfSymbol64 );
+
+    // strings: empty, the soname, then the symbol names
+
+    static const char soname[] = "linux-vdso.so.1";
+    uint32_t string_bytes = 1 + sizeof( soname );
+    for ( uint32_t i = 0; i < _countof( names ); i++ )
+        string_bytes += 1 + (uint32_t) strlen( names[ i ] );
+
+    uint64_t code_offset = round_up( string_offset + string_bytes, (uint64_t) 16 );
+    assert( ( code_offset + sizeof( vdso_code ) ) <= vdso_size );
+    for ( size_t i = 0; i < _countof( vdso_code ); i++ )
+        ( (uint32_t *) ( pvdso + code_offset ) )[ i ] = swap_endian32( vdso_code[ i ] );
+
+    char * pstrings = (char *) pvdso + string_offset;
+    strcpy( pstrings + 1, soname );
+    uint32_t name_offset = 1 + sizeof( soname );
+
+    ElfSymbol64 * psym = (ElfSymbol64 *) ( pvdso + symbol_offset );
+    for ( uint32_t i = 0; i < _countof( names ); i++ )
+    {
+        ElfSymbol64 & sym = psym[ 1 + i ];
+        sym.name = name_offset;
+        sym.info = 0x12; // STB_GLOBAL, STT_FUNC
+        sym.shndx = 1;   // there are no section headers, but the loaders skip symbols with SHN_UNDEF
+        sym.value = code_offset + starts[ i ] * sizeof( uint32_t );
+        sym.size = ( starts[ i + 1 ] - starts[ i ] ) * sizeof( uint32_t );
+        sym.swap_endianness();
+        strcpy( pstrings + name_offset, names[ i ] );
+        name_offset += 1 + (uint32_t) strlen( names[ i ] );
+    }
+
+    // one hash bucket chains all the symbols. nothing needs the names hashed
+
+    uint32_t * phash = (uint32_t *) ( pvdso + hash_offset );
+    phash[ 0 ] = swap_endian32( 1 );                        // nbucket
+    phash[ 1 ] = swap_endian32( symbol_count );             // nchain
+    phash[ 2 ] = swap_endian32( 1 );                        // bucket[ 0 ]
+    for ( uint32_t i = 1; i < symbol_count; i++ )
+        phash[ 3 + i ] = swap_endian32( ( i + 1 ) % symbol_count ); // chain[ i ]. chain[ 0 ] is 0
+
+    static const uint64_t dynamic_tags[ dynamic_count ] = { 4, 5, 6, 10, 11, 14, 0 }; // DT_HASH, STRTAB, SYMTAB, STRSZ, SYMENT, SONAME, NULL
+    uint64_t dynamic_values[ dynamic_count ] = { hash_offset, string_offset, symbol_offset, string_bytes, sizeof( ElfSymbol64 ), 1, 0 };
+    uint64_t * pdynamic = (uint64_t *) ( pvdso + dynamic_offset );
+    for ( uint32_t i = 0; i < dynamic_count; i++ )
+    {
+        pdynamic[ 2 * i ] = swap_endian64( dynamic_tags[ i ] );
+        pdynamic[ 2 * i + 1 ] = swap_endian64( dynamic_values[ i ] );
+    }
+
+    ElfProgramHeader64 * pheads = (ElfProgramHeader64 *) ( pvdso + sizeof( ElfHeader64 ) );
+    pheads[ 0 ].type = 1; // PT_LOAD
+    pheads[ 0 ].flags = 5; // PF_R | PF_X
+    pheads[ 0 ].file_size = vdso_size;
+    pheads[ 0 ].memory_size = vdso_size;
+    pheads[ 0 ].alignment = vdso_size;
+    pheads[ 1 ].type = 2; // PT_DYNAMIC
+    pheads[ 1 ].flags = 4; // PF_R
+    pheads[ 1 ].offset_in_image = dynamic_offset;
+    pheads[ 1 ].virtual_address = dynamic_offset;
+    pheads[ 1 ].physical_address = dynamic_offset;
+    pheads[ 1 ].file_size = dynamic_count * 2 * sizeof( uint64_t );
+    pheads[ 1 ].memory_size = pheads[ 1 ].file_size;
+    pheads[ 1 ].alignment = 8;
+    pheads[ 0 ].swap_endianness();
+    pheads[ 1 ].swap_endianness();
+
+    ElfHeader64 * phead = (ElfHeader64 *) pvdso;
+    memcpy( &phead->magic, "\177ELF", 4 );
+    phead->bit_width = 2;          // 64-bit
+    phead->endianness = 1;         // little-endian
+    phead->elf_version = 1;
+    phead->type = 3;               // ET_DYN
+    phead->machine = 0xb7;         // aarch64
+    phead->version = 1;
+    phead->program_header_table = sizeof( ElfHeader64 );
+    phead->header_size = sizeof( ElfHeader64 );
+    phead->program_header_table_size = sizeof( ElfProgramHeader64 );
+    phead->program_header_table_entries = 2;
+    phead->section_header_table_size = 64;
+    phead->swap_endianness();
+} //build_vdso
+
+// -cache keeps the main thread's predecoded blocks in DIR between runs, one file per image named for a hash of its
+// PT_LOAD segments. a warm start imports the blocks rather than decoding again. a file that's stale, damaged, or from
+// another build is ignored and replaced. files are touched when used and the least recently used are removed once
+// the directory holds more than the limit
+
+struct TranslationCacheHeader
+{
+    char magic[ 8 ];
+    uint64_t image_hash;
+    uint64_t data_hash;            // catches damage that would still import
+};
+
+static const char g_cache_magic[ 8 ] = { 'a', 'r', 'm', 'o', 's', 'p', 'd', 'c' };
+static const char * g_cache_dir = 0;                       // -cache: directory of predecoded blocks
+static uint64_t g_cache_limit = 64 * 1024 * 1024;          // -cache: total bytes of files kept in the directory
+static uint32_t g_cache_loaded_blocks = 0;                 // blocks imported at startup, so unchanged caches aren't rewritten
+static const char * g_aot_output = 0;                      // -aot: translate the app ahead of time to this file, then exit
+static const char * g_aot_input = 0;                       // -j: start with the translations in this file
+
+static uint64_t hash_image_segments( const vector<ElfProgramHeader64> & headers )
+{
+    // where each PT_LOAD segment goes and its bytes as loaded
+
+    uint64_t h = fnv1a_basis;
+    for ( size_t i = 0; i < headers.size(); i++ )
+    {
+        const ElfProgramHeader64 & head = headers[ i ];
+        if ( ( 1 != head.type ) || ( 0 == head.file_size ) || ( 0 == head.physical_address ) )
+            continue;
+
+        uint64_t layout[ 2 ] = { head.physical_address, head.file_size };
+        h = fnv1a( layout, sizeof( layout ), h );
+        h = fnv1a( g_process->vm_memory.data() + head.physical_address - g_process->base_address, (size_t) head.file_size, h );
+    }
+    return h;
+} //hash_image_segments
+
+static uint64_t translation_code_limit()
+{
+    // the vdso page follows the image, so blocks in its clock routines are kept too
+
+    return ( 0 != g_process->vdso_address ) ? ( g_process->vdso_address + vdso_size ) : g_process->image_end;
+} //translation_code_limit
+
+static void translation_cache_path( char * path, size_t len )
+{
+    snprintf( path, len, "%s/armos-%016llx.pdc", g_cache_dir, (unsigned long long) g_process->image_hash );
+} //translation_cache_path
+
+static int ends_with( const char * str, const char * end );
+#ifndef _WIN32
+static bool map_file_range( int fd, uint64_t offset, uint64_t size, MappedFileRange & range );
+#endif
+
+static bool read_translations( CPUClass & cpu, const char * path )
+{
+    // false if path doesn't exist or isn't translations of this image made by this build
+
+    FILE * fp = fopen( path, "rb" );
+    if ( 0 == fp )
+    {
+        tracer.Trace( "no translations in %s\n", path );
+        return false;
+    }
+
+    CFile file( fp );
+    fseek( fp, 0, SEEK_END );
+    long size = ftell( fp );
+    fseek( fp, 0, SEEK_SET );
+    TranslationCacheHeader h;
+    if ( ( size < (long) sizeof( h ) ) || ( 1 != fread( &h, sizeof( h ), 1, fp ) ) ||
+         ( 0 != memcmp( h.magic, g_cache_magic, sizeof( h.magic ) ) ) || ( g_process->image_hash != h.image_hash ) )
+    {
+        tracer.Trace( "translations in %s aren't for this image\n", path );
+        return false;
+    }
+
+    // blocks are updated as they run (chains and counts), so import copies them out of the read-only view
+
+    bool imported = false;
+#ifdef _WIN32
+    vector<uint8_t> data( (size_t) size - sizeof( h ) );
+    if ( ( data.size() == fread( data.data(), 1, data.size(), fp ) ) && ( h.data_hash == fnv1a( data.data(), data.size() ) ) )
+        imported = cpu.import_predecode( data.data(), data.size(), g_process->base_address, translation_code_limit() );
+#else
+    MappedFileRange view;
+    if ( map_file_range( fileno( fp ), sizeof( h ), (uint64_t) size - sizeof( h ), view ) )
+    {
+        if ( h.data_hash == fnv1a( view.data, view.size ) )
+            imported = cpu.import_predecode( view.data, view.size, g_process->base_address, translation_code_limit() );
+        munmap( view.base, view.length );
+    }
+#endif
+
+    if ( !imported )
+        tracer.Trace( "translations in %s are from another build or damaged\n", path );
+    else
+        tracer.Trace( "imported %u predecoded blocks from %s\n", cpu.predecoded_blocks(), path );
+    return imported;
+} //read_translations
+
+static void load_translation_cache( CPUClass & cpu )
+{
+    char path[ EMULATOR_MAX_PATH ];
+    translation_cache_path( path, sizeof( path ) );
+    if ( !read_translations( cpu, path ) )
+        return;
+
+    g_cache_loaded_blocks = cpu.predecoded_blocks();
+#ifdef _WIN32
+    _utime( path, 0 );
+#else
+    utime( path, 0 );
+#endif
+} //load_translation_cache
+
+struct CacheFileInfo
+{
+    string path;
+    uint64_t size;
+    uint64_t mtime;
+    bool operator < ( const CacheFileInfo & other ) const { return mtime < other.mtime; }
+};
+
+static void prune_translation_cache()
+{
+    vector<CacheFileInfo> files;
+#ifdef _WIN32
+    char path[ EMULATOR_MAX_PATH ];
+    snprintf( path, sizeof( path ), "%s/armos-*.pdc", g_cache_dir );
+    WIN32_FIND_DATAA fd;
+    HANDLE hFind = FindFirstFileA( path, &fd );
+    if ( INVALID_HANDLE_VALUE != hFind )
+    {
+        do
+        {
+            CacheFileInfo info;
+            info.path = string( g_cache_dir ) + "/" + fd.cFileName;
+            files.push_back( info );
+        } while ( FindNextFileA( hFind, &fd ) );
+        FindClose( hFind );
+    }
+#else
+    DIR * dir = opendir( g_cache_dir );
+    if ( 0 == dir )
+        return;
+
+    struct dirent * pent;
+    while ( 0 != ( pent = readdir( dir ) ) )
+    {
+        if ( !strncmp( pent->d_name, "armos-", 6 ) && ends_with( pent->d_name, ".pdc" ) )
+        {
+            CacheFileInfo info;
+            info.path = string( g_cache_dir ) + "/" + pent->d_name;
+            files.push_back( info );
+        }
+    }
+    closedir( dir );
+#endif
+
+    uint64_t total = 0;
+    for ( size_t i = 0; i < files.size(); i++ )
+    {
+        struct stat st;
+        files[ i ].size = 0;
+        files[ i ].mtime = 0;
+        if ( 0 == stat( files[ i ].path.c_str(), &st ) )
+        {
+            files[ i ].size = (uint64_t) st.st_size;
+            files[ i ].mtime = (uint64_t) st.st_mtime;
+        }
+        total += files[ i ].size;
+    }
+
+    sort( files.begin(), files.end() );
+    for ( size_t i = 0; ( i < files.size() ) && ( total > g_cache_limit ); i++ )
+    {
+        tracer.Trace( "removing least recently used translation cache %s\n", files[ i ].path.c_str() );
+        if ( 0 == remove( files[ i ].path.c_str() ) )
+            total -= files[ i ].size;
+    }
+} //prune_translation_cache
+
+static bool write_translations( CPUClass & cpu, const char * path, bool include_jit )
+{
+    // the file is renamed into place so runs of the same app at once never see it half written
+
+    vector<uint8_t> data;
+    if ( !cpu.export_predecode( data, g_process->base_address, translation_code_limit(), include_jit ) )
+    {
+        tracer.Trace( "predecoded blocks aren't all from the image as loaded, so they aren't written\n" );
+        return false;
+    }
+
+    char temp_path[ EMULATOR_MAX_PATH ];
+#ifdef _WIN32
+    snprintf( temp_path, sizeof( temp_path ), "%s.%lu", path, (unsigned long) GetCurrentProcessId() );
+#else
+    snprintf( temp_path, sizeof( temp_path ), "%s.%ld", path, (long) getpid() );
+#endif
+
+    FILE * fp = fopen( temp_path, "wb" );
+    if ( 0 == fp )
+    {
+        tracer.Trace( "can't create translations file %s, error %d\n", temp_path, errno );
+        return false;
+    }
+
+    TranslationCacheHeader h;
+    memcpy( h.magic, g_cache_magic, sizeof( h.magic ) );
+    h.image_hash = g_process->image_hash;
+    h.data_hash = fnv1a( data.data(), data.size() );
+    bool ok = ( 1 == fwrite( &h, sizeof( h ), 1, fp ) ) && ( data.size() == fwrite( data.data(), 1, data.size(), fp ) );
+    ok = ( 0 == fclose( fp ) ) && ok;
+
+#ifdef _WIN32
+    ok = ok && MoveFileExA( temp_path, path, MOVEFILE_REPLACE_EXISTING );
+#else
+    ok = ok && ( 0 == rename( temp_path, path ) );
+#endif
+    if ( !ok )
+    {
+        tracer.Trace( "can't write translations to %s\n", path );
+        remove( temp_path );
+        return false;
+    }
+
+    tracer.Trace( "wrote %u predecoded blocks to %s\n", cpu.predecoded_blocks(), path );
+    return true;
+} //write_translations
+
+static void save_translation_cache( CPUClass & cpu )
+{
+    // only when this run decoded more than it started with
+
+    if ( cpu.predecoded_blocks() <= g_cache_loaded_blocks )
+        return;
+
+    char path[ EMULATOR_MAX_PATH ];
+    translation_cache_path( path, sizeof( path ) );
+    if ( write_translations( cpu, path, false ) )
+        prune_translation_cache();
+} //save_translation_cache
+
+static bool translate_ahead_of_time( CPUClass & cpu )
+{
+    // -aot walks the code reachable from the entry point and every function symbol, so only targets of indirect
+    // branches the walk can't see are left for the jit to translate when they get hot
+
+    const uint8_t stt_func = 2;
+    const uint8_t stt_gnu_ifunc = 10;
+    ensure_symbols();
+
+    vector<uint64_t> starts;
+    starts.push_back( g_process->execution_address );
+    for ( size_t i = 0; i < g_process->symbols.size(); i++ )
+    {
+        uint8_t type = g_process->symbols[ i ].info & 0xf;
+        if ( ( stt_func == type ) || ( stt_gnu_ifunc == type ) )
+            starts.push_back( g_process->symbols[ i ].value );
+    }
+
+    uint32_t blocks = cpu.translate_ahead( starts.data(), (uint32_t) starts.size(), g_process->code_start, g_process->code_end );
+    if ( !write_translations( cpu, g_aot_output, true ) )
+    {
+        printf( "can't write translations to %s\n", g_aot_output );
+        return false;
+    }
+
+    printf( "%u blocks from %zu entry points translated to %s\n", blocks, starts.size(), g_aot_output );
+    return true;
+} //translate_ahead_of_time
+
+static vector<string> split_app_arguments( const char * app, const char * app_args )
+{
+    // the app then its space-separated arguments, like load_image() reads the command line
+
+    vector<string> args( 1, app );
+    const char * pargs = app_args;
+    while ( *pargs )
+    {
+        while ( ' ' == *pargs )
+            pargs++;
+        if ( 0 == *pargs )
+            break;
+
+        const char * space = strchr( pargs, ' ' );
+        if ( 0 == space )
+            space = pargs + strlen( pargs );
+        args.push_back( string( pargs, space - pargs ) );
+        pargs = space;
+    }
+    return args;
+} //split_app_arguments
+
+static bool rewrite_app_arguments( const vector<string> & new_args )
+{
+    // the argv array sits just above argc at the initial stack pointer and is followed by the environment array.
+    // the array's position depends on the count, so only the strings can change. they're rewritten in place
+
+    uint64_t * pstack = (uint64_t *) ( g_process->vm_memory.data() + ( g_process->top_of_stack - g_process->base_address ) );
+    uint64_t app_argc = swap_endian64( pstack[ 0 ] );
+    uint64_t * pargv = pstack + 1;
+    uint64_t * penv = pargv + app_argc + 1;
+
+    if ( new_args.size() != app_argc )
+    {
+        printf( "the app was started with %llu arguments including itself; it must be resumed with the same count\n", app_argc );
+        return false;
+    }
+
+    vector<string> env;
+    for ( uint64_t * pe = penv; 0 != *pe; pe++ )
+        env.push_back( (const char *) g_process->vm_memory.data() + ( swap_endian64( *pe ) - g_process->base_address ) );
+
+    char * parea = (char *) g_process->vm_memory.data() + g_process->arg_data_offset;
+    memset( parea, 0, g_arg_data_commit );
+    size_t used = 0;
+    for ( size_t i = 0; i < ( new_args.size() + env.size() ); i++ )
+    {
+        const char * pstr = ( i < new_args.size() ) ? new_args[ i ].c_str() : env[ i - new_args.size() ].c_str();
+        size_t len = strlen( pstr ) + 1;
+        if ( ( used + len ) > g_arg_data_commit )
+        {
+            printf( "the arguments don't fit in the %llu bytes %s reserves for them\n", (uint64_t) g_arg_data_commit, APP_NAME );
+            return false;
+        }
+
+        memcpy( parea + used, pstr, len );
+        uint64_t address = swap_endian64( g_process->base_address + g_process->arg_data_offset + used );
+        if ( i < new_args.size() )
+            pargv[ i ] = address;
+        else
+            penv[ i - new_args.size() ] = address;
+        used += len;
+    }
+
+    return true;
+} //rewrite_app_arguments
+
+static bool restore_snapshot( const char * path, const char * app, const char * app_args, Arm64::ArchState & state )
+{
+    // like load_image, this sets up memory and the layout globals for the cpu. state is where the cpu resumes
+
+    FILE * fp = fopen( path, "rb" );
+    if ( 0 == fp )
+    {
+        printf( "can't open snapshot %s\n", path );
+        return false;
+    }
+
+    CFile file( fp );
+    SnapshotHeader h;
+    if ( ( 1 != fread( &h, sizeof( h ), 1, fp ) ) || ( 0 != memcmp( h.magic, g_snapshot_magic, sizeof( h.magic ) ) ) ||
+         ( sizeof( h ) != h.header_size ) )
+    {
+        printf( "%s isn't a snapshot written by this build of %s\n", path, APP_NAME );
+        return false;
+    }
+
+    uint64_t image_size = 0, image_mtime = 0;
+    if ( !image_identity( app, image_size, image_mtime ) || ( image_size != h.image_size ) || ( image_mtime != h.image_mtime ) )
+    {
+        printf( "snapshot %s was taken of a different build of %s\n", path, app );
+        return false;
+    }
+
+    vector<uint64_t> mmap_state( (size_t) h.mmap_state_count );
+    vector<uint64_t> runs( (size_t) h.page_run_count * 2 );
+    if ( ( mmap_state.size() != fread( mmap_state.data(), sizeof( uint64_t ), mmap_state.size(), fp ) ) ||
+         ( runs.size() != fread( runs.data(), sizeof( uint64_t ), runs.size(), fp ) ) )
+    {
+        printf( "snapshot %s is truncated\n", path );
+        return false;
+    }
+
+    g_process->base_address = h.base_address;
+    g_process->brk_offset = h.brk_offset;
+    g_process->highwater_brk = h.highwater_brk;
+    g_process->end_of_data = h.end_of_data;
+    g_process->bottom_of_stack = h.bottom_of_stack;
+    g_process->top_of_stack = h.top_of_stack;
+    g_process->mmap_offset = h.mmap_offset;
+    g_process->mmap_commit = h.mmap_commit;
+    g_process->stack_commit = h.stack_commit;
+    g_process->arg_data_offset = h.arg_data_offset;
+    g_process->execution_address = h.state.pc;
+
+    g_process->vm_memory.request_large_pages( g_large_pages );
+    g_process->vm_memory.request_commit_on_demand( true );
+    g_process->vm_memory.resize( h.memory_size );
+    if ( ( g_process->vm_memory.size() != h.memory_size ) || !commit_fixed_regions() )
+        usage( "can't allocate memory for the app" );
+
+    g_process->mmap_arena.initialize( g_process->base_address + g_process->mmap_offset, g_process->mmap_commit, g_process->vm_memory.data() - g_process->base_address );
+    g_process->mmap_arena.set_commit( commit_mmap_range, discard_mmap_range, g_process );
+    if ( !g_process->mmap_arena.load( mmap_state ) )
+    {
+        printf( "snapshot %s has an invalid mmap arena\n", path );
+        return false;
+    }
+
+    int fd = fileno( fp );
+    uint64_t file_offset = h.pages_offset;
+    for ( size_t i = 0; i < runs.size(); i += 2 )
+    {
+        uint64_t offset = runs[ i ] * 4096;
+        uint64_t length = runs[ i + 1 ] * 4096;
+        if ( ( offset >= g_process->vm_memory.size() ) || ( length > ( round_up( (uint64_t) g_process->vm_memory.size(), (uint64_t) 4096 ) - offset ) ) )
+        {
+            printf( "snapshot %s has pages outside of memory\n", path );
+            return false;
+        }
+
+        if ( !g_process->vm_memory.commit( (size_t) offset, (size_t) length ) )
+            usage( "can't allocate memory for the app" );
+
+        if ( !g_process->vm_memory.can_map_files() || !g_process->vm_memory.map_file( (size_t) offset, (size_t) length, fd, file_offset, false, true ) )
+        {
+            if ( (int64_t) length != host_pread( fd, g_process->vm_memory.data() + offset, (size_t) length, file_offset ) )
+            {
+                printf( "snapshot %s is truncated\n", path );
+                return false;
+            }
+        }
+        file_offset += length;
+    }
+
+    if ( !rewrite_app_arguments( split_app_arguments( app, app_args ) ) )
+        return false;
+
+    state = h.state;
+    tracer.Trace( "restored snapshot %s at pc %llx: %llu page runs\n", path, h.state.pc, h.page_run_count );
+    return true;
+} //restore_snapshot
+
+// -record and -replay. the log has each syscall's result and the guest memory it wrote, in the order each thread
+// made them. a replay answers syscalls from the log without calling the host, so timing the emulator isn't swayed
+// by files, the console, clocks, or random numbers. calls that change the emulator's own state (memory, threads,
+// futexes, exit) aren't logged and run during a replay too, except that a file-backed mmap gets the file's contents
+// from the log. the vdso's clock reads are logged like syscalls. a forked child runs only when recording; in a
+// replay the parent gets its recorded pid and exit status. the file is in host byte order, like snapshots.
+
+struct SyscallLogHeader
+{
+    char magic[ 8 ];                // "armsys01"
+    uint64_t image_size;            // of the app, so a log isn't replayed against a different build of it
+    uint64_t image_mtime;
+};
+
+struct SyscallLogRecord             // followed by buffer_count SyscallLogBuffers, each followed by its data
+{
+    uint32_t tid;
+    uint32_t syscall_id;
+    uint64_t result;                // x0 after the call
+    uint32_t buffer_count;
+    uint32_t data_size;             // bytes of buffers after the record
+};
+
+struct SyscallLogBuffer
+{
+    uint64_t address;
+    uint64_t length;
+};
+
+struct ReplayThread
+{
+    vector<size_t> records;         // offsets in g_replay_log
+    size_t next;
+    ReplayThread() : next( 0 ) {}
+};
+
+static const char g_syscall_log_magic[ 8 ] = { 'a', 'r', 'm', 's', 'y', 's', '0', '1' };
+static const uint32_t logged_clock_read = 0xffffffff;   // the syscall id of emulator_clock() reads
+static vector<uint8_t> g_replay_log;                 // -replay: the whole log, read before the app starts
+static map<uint32_t, ReplayThread> g_replay_threads; // by tid
+
+static bool syscall_runs_live( CPUClass & cpu, uint64_t syscall_id )
+{
+    switch ( syscall_id )
+    {
+        case emulator_sys_exit:
+        case emulator_sys_snapshot:
+        case emulator_sys_run_nested:
+        case emulator_sys_trace_instructions:
+        case emulator_sys_counters:
+        case SYS_exit:
+        case SYS_exit_group:
+        case SYS_tgkill:
+        case SYS_brk:
+        case SYS_mmap:
+        case SYS_munmap:
+        case SYS_mremap:
+        case SYS_mprotect:
+        case SYS_madvise:
+        case SYS_msync:
+        case SYS_futex:
+        case SYS_execve:
+        case SYS_set_tid_address:
+        case SYS_set_robust_list:
+        case SYS_rseq:
+        case SYS_rt_sigprocmask:
+        case SYS_sigaction:
+        case SYS_sched_yield:
+        case SYS_signalstack:
+            return true;
+        case SYS_clone:
+            return !clone_forks( ACCESS_REG( REG_ARG0 ) );
+        case SYS_clone3:
+            return !clone_forks( swap_endian64( * (uint64_t *) cpu.getmem( ACCESS_REG( REG_ARG0 ) ) ) );
+    }
+    return false;
+} //syscall_runs_live
+
+static void add_output( vector<SyscallLogBuffer> & outputs, uint64_t address, uint64_t length )
+{
+    if ( ( 0 == address ) || ( 0 == length ) )
+        return;
+
+    SyscallLogBuffer b = { address, length };
+    outputs.push_back( b );
+} //add_output
+
+static void add_iovec_outputs( CPUClass & cpu, vector<SyscallLogBuffer> & outputs, uint64_t address, uint64_t count, uint64_t bytes )
+{
+    const guest_iovec * pvec = (const guest_iovec *) cpu.getmem( address );
+    for ( uint64_t i = 0; ( i < count ) && ( 0 != bytes ); i++ )
+    {
+        uint64_t len = get_min( bytes, (uint64_t) swap_endian_reg( pvec[ i ].iov_len ) );
+        add_output( outputs, swap_endian_reg( pvec[ i ].iov_base ), len );
+        bytes -= len;
+    }
+} //add_iovec_outputs
+
+static uint32_t guest_length( CPUClass & cpu, uint64_t address, uint32_t limit ) // a socklen_t the syscall wrote
+{
+    return ( 0 == address ) ? 0 : get_min( limit, swap_endian32( * (uint32_t *) cpu.getmem( address ) ) );
+} //guest_length
+
+static void syscall_outputs( CPUClass & cpu, uint64_t syscall_id, const uint64_t * a, int64_t result, vector<SyscallLogBuffer> & outputs )
+{
+    // the guest memory a successful syscall wrote, given its arguments as they were when it was made
+
+    if ( result < 0 )
+        return;
+
+    switch ( syscall_id )
+    {
+        case SYS_read:
+        case SYS_pread64:
+        case SYS_getdents64:
+        case emulator_sys_getdents:
+        case emulator_sys_readlink:
+            add_output( outputs, a[ 1 ], result );
+            break;
+        case SYS_getrandom:
+            add_output( outputs, a[ 0 ], result );
+            break;
+        case SYS_readlinkat:
+        case SYS_sched_getaffinity:
+            add_output( outputs, a[ 2 ], result );
+            break;
+        case SYS_readv:
+        case SYS_preadv:
+            add_iovec_outputs( cpu, outputs, a[ 1 ], a[ 2 ], result );
+            break;
+        case SYS_newfstat:
+            add_output( outputs, a[ 1 ], sizeof( struct stat_linux_syscall ) );
+            break;
+        case SYS_newfstatat:
+            add_output( outputs, a[ 2 ], sizeof( struct stat_linux_syscall ) );
+            break;
+        case SYS_statx:
+            add_output( outputs, a[ 4 ], sizeof( struct statx_linux_syscall ) );
+            break;
+        case SYS_clock_gettime:
+            add_output( outputs, a[ 1 ], sizeof( struct timespec_syscall ) );
+            break;
+        case SYS_clock_nanosleep:
+            add_output( outputs, a[ 3 ], sizeof( struct timespec_syscall ) );
+            break;
+        case SYS_gettimeofday:
+            add_output( outputs, a[ 0 ], sizeof( struct linux_timeval ) );
+            break;
+        case SYS_times:
+            add_output( outputs, a[ 0 ], sizeof( struct linux_tms_syscall ) );
+            break;
+        case SYS_getrusage:
+            add_output( outputs, a[ 1 ], sizeof( struct linux_rusage_syscall ) );
+            break;
+        case SYS_wait4:
+            add_output( outputs, a[ 1 ], 4 );
+            add_output( outputs, a[ 3 ], sizeof( struct linux_rusage_syscall ) );
+            break;
+        case emulator_sys_time:
+        case emulator_sys__llseek:
+            add_output( outputs, ( emulator_sys_time == syscall_id ) ? a[ 0 ] : a[ 3 ], 8 );
+            break;
+        case emulator_sys_get_datetime:
+            add_output( outputs, a[ 0 ], strlen( (const char *) cpu.getmem( a[ 0 ] ) ) + 1 );
+            break;
+        case SYS_getcwd:
+            add_output( outputs, a[ 0 ], strlen( (const char *) cpu.getmem( a[ 0 ] ) ) + 1 );
+            break;
+        case SYS_sysinfo:
+            add_output( outputs, a[ 0 ], 112 ); // Arm64 Linux's struct sysinfo
+            break;
+        case SYS_uname:
+            add_output( outputs, a[ 0 ], sizeof( struct utsname_syscall ) );
+            break;
+        case SYS_ioctl:
+            if ( ( 0x5401 == ( a[ 1 ] & 0xffff ) ) || ( 0x5408 == ( a[ 1 ] & 0xffff ) ) ) // TCGETS
+                add_output( outputs, a[ 2 ], sizeof( struct local_kernel_termios ) );
+            break;
+        case SYS_ppoll_time32:
+            add_output( outputs, a[ 0 ], a[ 1 ] * sizeof( struct pollfd_syscall ) );
+            break;
+        case SYS_pselect6: // the read, write, and except fd_sets, then the timeout
+        {
+            uint64_t set_bytes = ( ( a[ 0 ] & 0x7fffffff ) + 63 ) / 64 * 8;
+            for ( int i = 1; i <= 3; i++ )
+                add_output( outputs, a[ i ], set_bytes );
+            add_output( outputs, a[ 4 ], sizeof( struct timespec_syscall ) );
+            break;
+        }
+        case SYS_pipe2:
+            add_output( outputs, a[ 0 ], 8 );
+            break;
+        case SYS_clone: // a fork that sets the parent's copy of the child's pid
+            if ( a[ 0 ] & linuxCLONE_PARENT_SETTID )
+                add_output( outputs, a[ 2 ], 4 );
+            break;
+        case SYS_mmap: // a file's contents. pages past the end of the file would fault, and replays them as zeros
+            if ( !( a[ 3 ] & 0x20 ) )
+            {
+                int64_t size = host_file_size( (int) a[ 4 ] );
+                uint64_t available = ( size > (int64_t) a[ 5 ] ) ? ( (uint64_t) size - a[ 5 ] ) : 0;
+                add_output( outputs, result, get_min( round_up( a[ 1 ], (uint64_t) 4096 ), available ) );
+            }
+            break;
+#ifdef ARMOS_HOST_SOCKETS
+        case SYS_socketpair:
+            add_output( outputs, a[ 3 ], 8 );
+            break;
+        case SYS_accept:
+        case SYS_accept4:
+        case SYS_getsockname:
+        case SYS_getpeername:
+            add_output( outputs, a[ 1 ], guest_length( cpu, a[ 2 ], 128 ) );
+            add_output( outputs, a[ 2 ], 4 );
+            break;
+        case SYS_getsockopt:
+            add_output( outputs, a[ 3 ], guest_length( cpu, a[ 4 ], 256 ) );
+            add_output( outputs, a[ 4 ], 4 );
+            break;
+        case SYS_recvfrom:
+            add_output( outputs, a[ 1 ], result );
+            add_output( outputs, a[ 4 ], guest_length( cpu, a[ 5 ], 128 ) );
+            add_output( outputs, a[ 5 ], 4 );
+            break;
+        case SYS_recvmsg:
+        {
+            const guest_msghdr * pm = (const guest_msghdr *) cpu.getmem( a[ 1 ] );
+            add_output( outputs, a[ 1 ], sizeof( guest_msghdr ) );
+            add_output( outputs, pm->msg_name, get_min( pm->msg_namelen, (uint32_t) 128 ) );
+            add_output( outputs, pm->msg_control, pm->msg_controllen );
+            add_iovec_outputs( cpu, outputs, pm->msg_iov, pm->msg_iovlen, result );
+            break;
+        }
+        case SYS_epoll_pwait:
+            add_output( outputs, a[ 1 ], result * sizeof( guest_epoll_event ) );
+            break;
+        case SYS_sendfile:
+            add_output( outputs, a[ 2 ], 8 );
+            break;
+        case SYS_copy_file_range:
+        case SYS_splice:
+            add_output( outputs, a[ 1 ], 8 );
+            add_output( outputs, a[ 3 ], 8 );
+            break;
+#endif
+    }
+} //syscall_outputs
+
+static bool valid_guest_range( uint64_t address, uint64_t length )
+{
+    return ( address >= g_process->base_address ) && ( length <= g_process->vm_memory.size() ) && ( ( address - g_process->base_address ) <= ( g_process->vm_memory.size() - length ) );
+} //valid_guest_range
+
+static bool open_syscall_record( const char * path, const char * app )
+{
+    SyscallLogHeader h;
+    memcpy( h.magic, g_syscall_log_magic, sizeof( h.magic ) );
+    if ( !image_identity( app, h.image_size, h.image_mtime ) )
+        return false;
+
+    g_record_file = fopen( path, "wb" );
+    if ( 0 == g_record_file )
+        return false;
+
+    return ( 1 == fwrite( &h, sizeof( h ), 1, g_record_file ) );
+} //open_syscall_record
+
+static bool load_syscall_replay( const char * path, const char * app )
+{
+    // the log is read and indexed up front so the replay does no host I/O
+
+    FILE * fp = fopen( path, "rb" );
+    if ( 0 == fp )
+        return false;
+
+    fseek( fp, 0, SEEK_END );
+    long size = ftell( fp );
+    fseek( fp, 0, SEEK_SET );
+    bool ok = ( size >= (long) sizeof( SyscallLogHeader ) );
+    if ( ok )
+    {
+        g_replay_log.resize( (size_t) size );
+        ok = ( 1 == fread( g_replay_log.data(), (size_t) size, 1, fp ) );
+    }
+    fclose( fp );
+    if ( !ok )
+        return false;
+
+    SyscallLogHeader h;
+    memcpy( &h, g_replay_log.data(), sizeof( h ) );
+    uint64_t image_size = 0, image_mtime = 0;
+    if ( memcmp( h.magic, g_syscall_log_magic, sizeof( h.magic ) ) || !image_identity( app, image_size, image_mtime ) ||
+         ( image_size != h.image_size ) || ( image_mtime != h.image_mtime ) )
+    {
+        printf( "%s isn't a syscall log recorded for this app\n", path );
+        return false;
+    }
+
+    size_t offset = sizeof( h );
+    while ( offset < g_replay_log.size() )
+    {
+        SyscallLogRecord r;
+        if ( ( g_replay_log.size() - offset ) < sizeof( r ) )
+            return false;
+        memcpy( &r, g_replay_log.data() + offset, sizeof( r ) );
+        if ( ( g_replay_log.size() - offset - sizeof( r ) ) < r.data_size )
+            return false;
+        g_replay_threads[ r.tid ].records.push_back( offset );
+        offset += sizeof( r ) + r.data_size;
+    }
+
+    tracer.Trace( "replaying %s: %zu threads, %zu bytes\n", path, g_replay_threads.size(), g_replay_log.size() );
+    return true;
+} //load_syscall_replay
+
+static const uint8_t * next_replay_record( uint64_t syscall_id )
+{
+    // the calling thread's next record if it's for syscall_id, or 0 if the replay has gone astray
+
+    ReplayThread & t = g_replay_threads[ g_tid ];
+    if ( t.next >= t.records.size() )
+        return 0;
+
+    const uint8_t * p = g_replay_log.data() + t.records[ t.next ];
+    SyscallLogRecord r;
+    memcpy( &r, p, sizeof( r ) );
+    if ( r.syscall_id != syscall_id )
+        return 0;
+
+    t.next++;
+    return p;
+} //next_replay_record
+
+static bool recording()
+{
+#ifndef _WIN32
+    if ( g_forked ) // a forked child's syscalls aren't part of the parent's log
+        return false;
+#endif
+    return ( 0 != g_record_file );
+} //recording
+
+static void record_clock_read( uint64_t value )
+{
+    lock_guard<mutex> lock( g_process->syscall_mutex );
+    SyscallLogRecord r = { g_tid, logged_clock_read, value, 0, 0 };
+    if ( recording() )
+        fwrite( &r, sizeof( r ), 1, g_record_file );
+} //record_clock_read
+
+static bool replay_clock_read( uint64_t & value )
+{
+    lock_guard<mutex> lock( g_process->syscall_mutex );
+    const uint8_t * p = next_replay_record( logged_clock_read );
+    if ( 0 == p )
+    {
+        tracer.Trace( "the -replay log has no clock read here; using the host's clock\n" );
+        return false;
+    }
+
+    SyscallLogRecord r;
+    memcpy( &r, p, sizeof( r ) );
+    value = r.result;
+    return true;
+} //replay_clock_read
+
+class SyscallLog
+{
+    // made at the start of each syscall. with -replay it answers the syscall or lets it run live; with -record its
+    // destructor logs the result
+
+    private:
+        CPUClass & cpu;
+        uint64_t syscall_id;
+        uint64_t args[ 6 ];
+        bool live;                      // decided before the call, since clone's flags are in x0 until it returns
+        bool replayed;
+        const uint8_t * pmmap_record;   // a live file-backed mmap in a replay gets its contents from here
+
+    public:
+        SyscallLog( CPUClass & c, uint64_t id ) : cpu( c ), syscall_id( id ), live( true ), replayed( false ), pmmap_record( 0 )
+        {
+            if ( ( 0 == g_record_file ) && g_replay_log.empty() )
+                return;
+
+            for ( int i = 0; i < 6; i++ )
+                args[ i ] = ACCESS_REG( REG_ARG0 + i );
+            live = syscall_runs_live( cpu, syscall_id );
+
+            if ( !g_replay_log.empty() )
+                replay();
+        }
+
+        ~SyscallLog()
+        {
+            if ( 0 != pmmap_record )
+                finish_mmap();
+            else if ( recording() && !replayed )
+                record();
+        }
+
+        bool answered() const { return replayed; }
+
+    private:
+        bool file_mmap() const { return ( SYS_mmap == syscall_id ) && !( args[ 3 ] & 0x20 ); }
+
+        void replay()
+        {
+            if ( live && !file_mmap() )
+                return;
+
+            const uint8_t * p = next_replay_record( syscall_id );
+            if ( 0 == p )
+                emulator_hard_termination( cpu, "the app made a syscall the -replay log doesn't have next:", syscall_id );
+
+            SyscallLogRecord r;
+            memcpy( &r, p, sizeof( r ) );
+            if ( live )
+            {
+                if ( (int64_t) r.result >= 0 ) // it succeeded when recorded. a mapping past the file's end has no buffer
+                {
+                    ACCESS_REG( REG_ARG3 ) |= 0x20; // MAP_ANONYMOUS. the file's contents are in the log
+                    ACCESS_REG( REG_ARG4 ) = (REG_TYPE) -1;
+                    pmmap_record = p;
+                }
+                return;
+            }
+
+            write_buffers( p );
+            ACCESS_REG( REG_RESULT ) = (REG_TYPE) r.result;
+            replayed = true;
+        }
+
+        void write_buffers( const uint8_t * p )
+        {
+            SyscallLogRecord r;
+            memcpy( &r, p, sizeof( r ) );
+            p += sizeof( r );
+            for ( uint32_t i = 0; i < r.buffer_count; i++ )
+            {
+                SyscallLogBuffer b;
+                memcpy( &b, p, sizeof( b ) );
+                p += sizeof( b );
+                if ( !valid_guest_range( b.address, b.length ) )
+                    emulator_hard_termination( cpu, "the -replay log writes outside guest memory at:", b.address );
+                memcpy( cpu.getmem( b.address ), p, (size_t) b.length );
+                p += b.length;
+            }
+        }
+
+        void finish_mmap()
+        {
+            SyscallLogRecord r;
+            memcpy( &r, pmmap_record, sizeof( r ) );
+            if ( ACCESS_REG( REG_RESULT ) != r.result )
+                emulator_hard_termination( cpu, "mmap returned a different address than the -replay log has:", ACCESS_REG( REG_RESULT ) );
+
+            ACCESS_REG( REG_ARG3 ) = args[ 3 ];
+            ACCESS_REG( REG_ARG4 ) = args[ 4 ];
+            write_buffers( pmmap_record );
+        }
+
+        void record()
+        {
+            if ( live && !file_mmap() )
+                return;
+
+            int64_t result = (int64_t) ACCESS_REG( REG_RESULT );
+            vector<SyscallLogBuffer> outputs;
+            syscall_outputs( cpu, syscall_id, args, result, outputs );
+
+            SyscallLogRecord r = { g_tid, (uint32_t) syscall_id, (uint64_t) result, (uint32_t) outputs.size(), 0 };
+            for ( size_t i = 0; i < outputs.size(); i++ )
+                r.data_size += (uint32_t) ( sizeof( SyscallLogBuffer ) + outputs[ i ].length );
+
+            fwrite( &r, sizeof( r ), 1, g_record_file );
+            for ( size_t i = 0; i < outputs.size(); i++ )
+            {
+                fwrite( &outputs[ i ], sizeof( SyscallLogBuffer ), 1, g_record_file );
+                fwrite( cpu.getmem( outputs[ i ].address ), (size_t) outputs[ i ].length, 1, g_record_file );
+            }
+        }
+};
+
+#ifndef _WIN32
+
+// -serve: a job server on a unix domain socket. each connection is one job, described by text lines ending with an
+// empty line:
+//     arg X       the app then its arguments, one per line
+//     env N=V     an environment variable for the app
+//     cwd D       directory to run in
+//     stdin F     file for the app's standard input. likewise stdout F and stderr F
+// every job runs in a forked copy of the server, so its address space, descriptors, and globals are thrown away when
+// it exits rather than being reset. the copy reads the request, so a slow client doesn't hold up other jobs. with -p
+// the job sends back "instructions N" and "elapsed_ms N" lines. the last line is always "exit N"; N is 128 plus the
+// signal number if the job was killed.
+// if the server is started with an app, the app runs until it makes the emulator_sys_snapshot syscall. each job then
+// continues from there with its own argument strings, sharing the server's initialized memory and predecoded code.
+
+struct ServerJob
+{
+    string app;
+    vector<string> args;            // after the app, each as given so they can have spaces
+    vector<string> env;
+    string cwd;
+    string stdin_path;
+    string stdout_path;
+    string stderr_path;
+};
+
+static const char * g_serve_path = 0;                // -serve: the socket to listen on
+static ServerJob g_job;                              // in a job process, what it was asked to run
+static int g_job_socket = -1;                        // in a job process, the connection to report statistics on
+static uint64_t g_job_base_instructions = 0;         // instructions the server ran before forking the job
+static high_resolution_clock::time_point g_job_start;
+static int g_child_pipe[ 2 ] = { -1, -1 };           // written by the SIGCHLD handler to wake the server's poll
+
+static void server_child_exited( int )
+{
+    int e = errno;
+    char c = 0;
+    if ( write( g_child_pipe[ 1 ], &c, 1 ) ) {} // the byte only wakes poll; a full pipe is already awake
+    errno = e;
+} //server_child_exited
+
+static bool read_server_job( int s, ServerJob & job )
+{
+    string request;
+    char buf[ 4096 ];
+    while ( string::npos == request.find( "\n\n" ) )
+    {
+        ssize_t len = read( s, buf, sizeof( buf ) );
+        if ( len <= 0 || request.size() > 65536 )
+            return false;
+        request.append( buf, (size_t) len );
+    }
+
+    size_t start = 0;
+    for ( size_t end = request.find( '\n' ); end != string::npos && end > start; start = end + 1, end = request.find( '\n', start ) )
+    {
+        string line = request.substr( start, end - start );
+        size_t space = line.find( ' ' );
+        string key = line.substr( 0, space );
+        string value = ( string::npos == space ) ? string() : line.substr( space + 1 );
+
+        if ( "arg" == key )
+        {
+            if ( job.app.empty() )
+                job.app = value;
+            else
+                job.args.push_back( value );
+        }
+        else if ( "env" == key )
+            job.env.push_back( value );
+        else if ( "cwd" == key )
+            job.cwd = value;
+        else if ( "stdin" == key )
+            job.stdin_path = value;
+        else if ( "stdout" == key )
+            job.stdout_path = value;
+        else if ( "stderr" == key )
+            job.stderr_path = value;
+        else
+            return false;
+    }
+
+    // the strings go in the same space as the command line's, so they have execve's limits
+
+    size_t arg_bytes = job.app.size() + 1;
+    for ( size_t i = 0; i < job.args.size(); i++ )
+        arg_bytes += job.args[ i ].size() + 1;
+
+    return !job.app.empty() && ( job.args.size() < 40 ) && ( ( arg_bytes + 16 ) <= g_arg_data_commit );
+} //read_server_job
+
+static bool redirect_job_file( int fd, const string & path, int flags )
+{
+    if ( path.empty() )
+        return true;
+
+    int f = open( path.c_str(), flags, 0666 );
+    if ( -1 == f )
+        return false;
+
+    bool ok = ( -1 != dup2( f, fd ) );
+    close( f );
+    return ok;
+} //redirect_job_file
+
+static void send_job_line( int s, const char * name, long long value )
+{
+    char line[ 64 ];
+    int len = snprintf( line, sizeof( line ), "%s %lld\n", name, value );
+    if ( write( s, line, (size_t) len ) ) {} // the client may have gone away
+} //send_job_line
+
+static void serve_jobs( CPUClass * pcpu )
+{
+    // returns only in a job's process. pcpu is the app the server was started with, or 0
+
+    if ( 0 != pcpu )
+    {
+        lock_guard<mutex> lock( g_process->thread_mutex );
+        if ( !g_process->threads.empty() )
+        {
+            printf( "can't serve jobs: the app has started threads\n" );
+            exit( 1 );
+        }
+    }
+
+    int listener = socket( AF_UNIX, SOCK_STREAM, 0 );
+    struct sockaddr_un addr;
+    memset( &addr, 0, sizeof( addr ) );
+    addr.sun_family = AF_UNIX;
+    if ( ( -1 == listener ) || ( strlen( g_serve_path ) >= sizeof( addr.sun_path ) ) )
+    {
+        printf( "can't create socket %s\n", g_serve_path );
+        exit( 1 );
+    }
+
+    strcpy( addr.sun_path, g_serve_path );
+    unlink( g_serve_path ); // left behind by an earlier server
+    if ( ( 0 != ::bind( listener, (struct sockaddr *) &addr, sizeof( addr ) ) ) || ( 0 != listen( listener, 64 ) ) ||
+         ( 0 != pipe( g_child_pipe ) ) )
+    {
+        printf( "can't listen on socket %s, error %d\n", g_serve_path, errno );
+        exit( 1 );
+    }
+
+    fcntl( g_child_pipe[ 0 ], F_SETFL, O_NONBLOCK );
+    fcntl( g_child_pipe[ 1 ], F_SETFL, O_NONBLOCK );
+    signal( SIGCHLD, server_child_exited );
+    signal( SIGPIPE, SIG_IGN ); // clients that disconnect early shouldn't end the server
+    tracer.Trace( "serving jobs on %s\n", g_serve_path );
+
+    map<pid_t, int> jobs; // running job -> its connection
+
+    for ( ;; )
+    {
+        struct pollfd fds[ 2 ] = { { listener, POLLIN, 0 }, { g_child_pipe[ 0 ], POLLIN, 0 } };
+        if ( -1 == poll( fds, 2, -1 ) )
+            continue; // EINTR from SIGCHLD
+
+        if ( fds[ 1 ].revents & POLLIN )
+        {
+            char drain[ 64 ];
+            while ( read( g_child_pipe[ 0 ], drain, sizeof( drain ) ) > 0 )
+                continue;
+        }
+
+        int status = 0;
+        pid_t pid;
+        while ( ( pid = waitpid( -1, &status, WNOHANG ) ) > 0 )
+        {
+            map<pid_t, int>::iterator it = jobs.find( pid );
+            if ( it == jobs.end() )
+                continue;
+
+            int code = WIFEXITED( status ) ? WEXITSTATUS( status ) : WIFSIGNALED( status ) ? ( 128 + WTERMSIG( status ) ) : 1;
+            send_job_line( it->second, "exit", code );
+            close( it->second );
+            jobs.erase( it );
+        }
+
+        if ( 0 == ( fds[ 0 ].revents & POLLIN ) )
+            continue;
+
+        int s = accept( listener, 0, 0 );
+        if ( -1 == s )
+            continue;
+
+        fflush( stdout ); // so buffered output isn't written by the job too
+        pid = fork();
+        if ( 0 == pid )
+        {
+            signal( SIGCHLD, SIG_DFL );
+            g_serve_path = 0; // a job's own marker syscall doesn't start another server
+            close( listener );
+            close( g_child_pipe[ 0 ] );
+            close( g_child_pipe[ 1 ] );
+            for ( map<pid_t, int>::iterator it = jobs.begin(); it != jobs.end(); it++ )
+                close( it->second );
+
+            ServerJob job;
+            if ( !read_server_job( s, job ) )
+            {
+                if ( write( s, "error bad request\n", 18 ) ) {}
+                _exit( 1 );
+            }
+
+            g_job = job;
+            g_process->app_env = job.env;
+            g_job_socket = s;
+            g_job_start = high_resolution_clock::now();
+            g_job_base_instructions = ( 0 != pcpu ) ? pcpu->cycles : 0;
+
+            if ( ( !job.cwd.empty() && ( 0 != chdir( job.cwd.c_str() ) ) ) ||
+                 !redirect_job_file( 0, job.stdin_path, O_RDONLY ) ||
+                 !redirect_job_file( 1, job.stdout_path, O_WRONLY | O_CREAT | O_TRUNC ) ||
+                 !redirect_job_file( 2, job.stderr_path, O_WRONLY | O_CREAT | O_TRUNC ) )
+            {
+                if ( write( s, "error can't set up the job's directory or files\n", 48 ) ) {}
+                _exit( 1 );
+            }
+
+            vector<string> argv( 1, job.app );
+            argv.insert( argv.end(), job.args.begin(), job.args.end() );
+            if ( ( 0 != pcpu ) && !rewrite_app_arguments( argv ) )
+            {
+                fflush( stdout );
+                _exit( 1 );
+            }
+            return;
+        }
+
+        if ( -1 == pid )
+        {
+            send_job_line( s, "exit", 1 );
+            close( s );
+        }
+        else
+            jobs[ pid ] = s;
+    }
+} //serve_jobs
+
+static void report_job( bool show_performance, uint64_t instructions )
+{
+    // the exit code follows from the server once this process is gone
+
+    if ( ( -1 == g_job_socket ) || !show_performance )
+        return;
+
+    high_resolution_clock::time_point now = high_resolution_clock::now();
+    send_job_line( g_job_socket, "instructions", (long long) instructions );
+    send_job_line( g_job_socket, "elapsed_ms", (long long) duration_cast<std::chrono::milliseconds>( now - g_job_start ).count() );
+} //report_job
+
+#endif //_WIN32
+
+#endif //ARMOS
+
+static bool g_syscall_timing = false;
+static uint64_t g_stat_cache_ms = 0;                       // -statcache: how long metadata is kept. 0 for no cache
+
+#if !defined( OLDGCC ) && !defined( __mc68000__ )
+
+static bool stat_cache_key( int dirfd, const char * path, int flags, char kind, string & key )
+{
+    // absolute paths and paths relative to the current directory are cached; chdir clears the cache. on Windows the
+    // directory argument is ignored, but the descriptor matters for stdin, stdout, stderr, and the fake descriptors
+
+    if ( ( 0 == g_stat_cache_ms ) || ( 0 == path[ 0 ] ) )
+        return false;
+#ifndef _WIN32
+    if ( ( '/' != path[ 0 ] ) && ( AT_FDCWD != dirfd ) )
+        return false;
+#endif
+
+    char ac[ 40 ];
+    snprintf( ac, sizeof( ac ), "%c%d,%x,", kind, dirfd, flags );
+    key = ac;
+    key += path;
+    return true;
+} //stat_cache_key
+
+static StatCacheEntry * stat_cache_lookup( const string & key )
+{
+    map<string, StatCacheEntry>::iterator it = g_process->stat_cache.find( key );
+    if ( it == g_process->stat_cache.end() )
+        return 0;
+
+    if ( steady_clock::now() >= it->second.expires )
+    {
+        g_process->stat_cache.erase( it );
+        return 0;
+    }
+
+    tracer.Trace( "  stat cache hit for '%s', result %d\n", key.c_str(), it->second.result );
+    g_process->stat_cache_hit = true;
+    return & it->second;
+} //stat_cache_lookup
+
+static StatCacheEntry & stat_cache_add( const string & key, int result )
+{
+    StatCacheEntry & e = g_process->stat_cache[ key ];
+    e.expires = steady_clock::now() + milliseconds( g_stat_cache_ms );
+    e.result = result;
+    e.error = ( 0 == result ) ? 0 : errno;
+    return e;
+} //stat_cache_add
+
+static void stat_cache_clear()
+{
+    if ( !g_process->stat_cache.empty() )
+    {
+        tracer.Trace( "  clearing %zd stat cache entries\n", g_process->stat_cache.size() );
+        g_process->stat_cache.clear();
+    }
+} //stat_cache_clear
+
+static bool syscall_changes_metadata( CPUClass & cpu, REG_TYPE id )
+{
+    // the calls that can make stat cache entries stale. writes to stdout and stderr don't
+
+    if ( SYS_write == id || SYS_writev == id || SYS_pwrite64 == id || SYS_pwritev == id || SYS_sendfile == id )
+        return ( ACCESS_REG( REG_ARG0 ) > 2 );
+    if ( SYS_copy_file_range == id || SYS_splice == id )
+        return true;
+
+    if ( SYS_open == id || SYS_openat == id )
+    {
+        int flags = translate_open_flags( (int) ACCESS_REG( ( SYS_open == id ) ? REG_ARG1 : REG_ARG2 ) );
+        return ( 0 != ( flags & ( O_WRONLY | O_RDWR | O_CREAT | O_TRUNC ) ) );
+    }
+
+    return ( SYS_chdir == id || SYS_mkdir == id || SYS_mkdirat == id || SYS_rmdir == id || SYS_unlink == id ||
+             SYS_unlinkat == id || SYS_renameat == id || SYS_renameat2 == id );
+} //syscall_changes_metadata
+
+#ifdef _WIN32
+
+static int cached_pstat_windows( int descriptor, struct stat_linux_syscall * pstat, const char * path )
+{
+    string key;
+    bool cacheable = stat_cache_key( descriptor, path, 0, 's', key );
+    if ( cacheable )
+    {
+        StatCacheEntry * pentry = stat_cache_lookup( key );
+        if ( 0 != pentry )
+        {
+            * pstat = pentry->st;
+            errno = pentry->error;
+            return pentry->result;
+        }
+    }
+
+    int result = fill_pstat_windows( descriptor, pstat, path );
+    if ( cacheable )
+        stat_cache_add( key, result ).st = * pstat;
+    return result;
+} //cached_pstat_windows
+
+#else
+
+static int cached_fstatat( int dirfd, const char * path, struct stat * pstat, int flags )
+{
+    string key;
+    bool cacheable = stat_cache_key( dirfd, path, flags, 's', key );
+    if ( cacheable )
+    {
+        StatCacheEntry * pentry = stat_cache_lookup( key );
+        if ( 0 != pentry )
+        {
+            * pstat = pentry->st;
+            errno = pentry->error;
+            return pentry->result;
+        }
+    }
+
+    int result = fstatat( dirfd, path, pstat, flags );
+    if ( cacheable )
+        stat_cache_add( key, result ).st = * pstat;
+    return result;
+} //cached_fstatat
+
+#endif
+
+static int cached_faccessat( int dirfd, const char * path, int mode )
+{
+    string key;
+    bool cacheable = stat_cache_key( dirfd, path, mode, 'a', key );
+    if ( cacheable )
+    {
+        StatCacheEntry * pentry = stat_cache_lookup( key );
+        if ( 0 != pentry )
+        {
+            errno = pentry->error;
+            return pentry->result;
+        }
+    }
+
+#ifdef _WIN32
+    struct stat_linux_syscall local_stat;
+    int result = fill_pstat_windows( -1, & local_stat, path ); // existence is all that's checked on Windows
+#else
+    int result = faccessat( dirfd, path, mode, 0 );
+#endif
+    if ( cacheable )
+        stat_cache_add( key, result );
+    return result;
+} //cached_faccessat
+
+#else // the old compilers have no cache
+
+#define cached_fstatat fstatat
+#define cached_faccessat( dirfd, path, mode ) faccessat( dirfd, path, mode, 0 )
+
+#endif
+
+static bool syscall_moves_bytes( REG_TYPE id )
+{
+    return ( SYS_read == id || SYS_write == id || SYS_readv == id || SYS_writev == id ||
+             SYS_pread64 == id || SYS_pwrite64 == id || SYS_preadv == id || SYS_pwritev == id );
+} //syscall_moves_bytes
+
+static void record_syscall( CPUClass & cpu, REG_TYPE id, steady_clock::time_point tStart )
+{
+    uint64_t ns = (uint64_t) duration_cast<nanoseconds>( steady_clock::now() - tStart ).count();
+    SyscallStats & s = g_process->syscall_stats[ (uint32_t) id ];
+    s.calls++;
+    s.total_ns += ns;
+    s.max_ns = get_max( s.max_ns, ns );
+#if !defined( OLDGCC ) && !defined( __mc68000__ )
+    if ( g_process->stat_cache_hit )
+    {
+        s.cache_hits++;
+        g_process->stat_cache_hit = false;
+    }
+#endif
+
+#ifndef SPARCOS // sparc returns positive errno values, so the result can't be told from a byte count
+    SIGNED_REG_TYPE result = (SIGNED_REG_TYPE) ACCESS_REG( REG_RESULT );
+    if ( syscall_moves_bytes( id ) && ( result > 0 ) )
+        s.bytes += (uint64_t) result;
+#endif
+} //record_syscall
+
+static bool syscall_stats_compare( const pair<uint32_t, SyscallStats> & a, const pair<uint32_t, SyscallStats> & b )
+{
+    return a.second.total_ns > b.second.total_ns;
+} //syscall_stats_compare
+
+static void show_syscall_stats()
+{
+    if ( g_process->syscall_stats.empty() )
+        return;
+
+    vector<pair<uint32_t, SyscallStats>> sorted( g_process->syscall_stats.begin(), g_process->syscall_stats.end() );
+    sort( sorted.begin(), sorted.end(), syscall_stats_compare );
+
+    // with -statcache, a last column has the share of each syscall's calls the cache answered
+
+    char calls[ 100 ], total[ 100 ], mean[ 100 ], max[ 100 ], bytes[ 100 ], hits[ 100 ];
+    printf( "%-22s %11s %13s %11s %13s %15s%s\n", "syscall", "calls", "total us", "mean ns", "max us", "bytes",
+            ( 0 != g_stat_cache_ms ) ? "   cache hits" : "" );
+    for ( size_t i = 0; i < sorted.size(); i++ )
+    {
+        const SyscallStats & s = sorted[ i ].second;
+        if ( syscall_moves_bytes( sorted[ i ].first ) )
+            CDJLTrace::RenderNumberWithCommas( s.bytes, bytes );
+        else
+            bytes[ 0 ] = 0;
+
+        hits[ 0 ] = 0;
+        if ( 0 != s.cache_hits )
+            snprintf( hits, sizeof( hits ), " %11.1f%%", 100.0 * (double) s.cache_hits / (double) s.calls );
+
+        printf( "%-22s %11s %13s %11s %13s %15s%s\n", lookup_syscall( sorted[ i ].first ),
+                CDJLTrace::RenderNumberWithCommas( s.calls, calls ),
+                CDJLTrace::RenderNumberWithCommas( s.total_ns / 1000, total ),
+                CDJLTrace::RenderNumberWithCommas( s.total_ns / s.calls, mean ),
+                CDJLTrace::RenderNumberWithCommas( s.max_ns / 1000, max ), bytes, hits );
+    }
+} //show_syscall_stats
+
+static void print_json_string( const char * p )
+{
+    putchar( '"' );
+    for ( ; *p; p++ )
+    {
+        if ( ( '"' == *p ) || ( '\\' == *p ) )
+            printf( "\\%c", *p );
+        else if ( (unsigned char) *p < ' ' )
+            printf( "\\u%04x", (unsigned char) *p );
+        else
+            putchar( *p );
+    }
+    putchar( '"' );
+} //print_json_string
+
+static void show_performance_json( const char * app, int64_t ms, uint64_t instructions, int exit_code, uint64_t jit_blocks )
+{
+    // -p:json. one line so scripts can find it after the app's output
+
+    printf( "{\"emulator\":\"%s\",\"host\":\"%s\",\"app\":", APP_NAME, target_platform() );
+    print_json_string( app );
+    printf( ",\"elapsed_ms\":%lld,\"instructions\":%llu,\"mips\":%.2f,\"exit_code\":%d,\"jit_blocks\":%llu,\"brk_peak\":%llu,\"mmap_peak\":%llu,\"syscalls\":[",
+            (long long) ms, (unsigned long long) instructions, ( 0 == ms ) ? 0.0 : ( (double) instructions / ( (double) ms * 1000.0 ) ),
+            exit_code, (unsigned long long) jit_blocks, (unsigned long long) ( g_process->highwater_brk - g_process->end_of_data ),
+            (unsigned long long) g_process->mmap_arena.peak_usage() );
+
+    vector<pair<uint32_t, SyscallStats>> sorted( g_process->syscall_stats.begin(), g_process->syscall_stats.end() );
+    sort( sorted.begin(), sorted.end(), syscall_stats_compare );
+    for ( size_t i = 0; i < sorted.size(); i++ )
+    {
+        const SyscallStats & st = sorted[ i ].second;
+        printf( "%s{\"name\":\"%s\",\"calls\":%llu,\"total_ns\":%llu,\"max_ns\":%llu,\"bytes\":%llu,\"cache_hits\":%llu}", ( 0 == i ) ? "" : ",",
+                lookup_syscall( sorted[ i ].first ), (unsigned long long) st.calls, (unsigned long long) st.total_ns,
+                (unsigned long long) st.max_ns, (unsigned long long) st.bytes, (unsigned long long) st.cache_hits );
+    }
+    printf( "]}\n" );
+} //show_performance_json
+
+// the syscalls guests make most often have small handlers indexed by syscall number. with tracing off they run
+// before the switch in emulator_invoke_svc. they return false to leave unusual cases to the switch, which traces
+// everything and shares their code where it can
+
+#ifdef ARMOS
+struct HeldSyscallLock // lets embedded_fault release the lock of a syscall that faults
+{
+    SyscallLock * previous;
+    HeldSyscallLock( SyscallLock & lock ) : previous( g_held_syscall_lock ) { g_held_syscall_lock = &lock; }
+    ~HeldSyscallLock() { g_held_syscall_lock = previous; }
+};
+#else
+struct SyscallLock {}; // the other emulators are single-threaded, so BLOCKING_CALL has nothing to release
+#endif
+
+typedef bool ( * FastSyscall )( CPUClass & cpu, SyscallLock & syscall_lock );
+
+static bool syscall_read( CPUClass & cpu, SyscallLock & syscall_lock )
+{
+    // stdin and the emulator's special descriptors are left to the switch
+
+    int descriptor = (int) ACCESS_REG( REG_ARG0 );
+    if ( 0 == descriptor || timebaseFrequencyDescriptor == descriptor || osreleaseDescriptor == descriptor )
+        return false;
+
+    int result;
+    BLOCKING_CALL( result = read( descriptor, cpu.getmem( ACCESS_REG( REG_ARG1 ) ), (uint32_t) ACCESS_REG( REG_ARG2 ) ) ); // pipes and sockets wait for data
+    update_result_errno( cpu, result );
+    return true;
+} //syscall_read
+
+static bool syscall_write( CPUClass & cpu, SyscallLock & syscall_lock )
+{
+    int descriptor = (int) ACCESS_REG( REG_ARG0 );
+    if ( 0 == descriptor ) // stdin
+        return false;
+
+    uint8_t * p = (uint8_t *) cpu.getmem( ACCESS_REG( REG_ARG1 ) );
+    REG_TYPE count = ACCESS_REG( REG_ARG2 );
+    size_t written;
+#ifdef _WIN32
+    if ( 1 == descriptor || 2 == descriptor ) // stdout / stderr
+        written = WinWrite( descriptor, p, (int) count );
+    else
+#endif
+    BLOCKING_CALL( written = write( descriptor, p, (int) count ) );
+    update_result_errno( cpu, (REG_TYPE) written );
+    return true;
+} //syscall_write
+
+static int host_clock_gettime( clockid_t cid, uint64_t & sec, uint64_t & nsec )
+{
+    #ifdef __APPLE__ // Linux vs MacOS
+        if ( 1 == cid )
+            cid = CLOCK_REALTIME;
+        else if ( 5 == cid )
+            cid = CLOCK_REALTIME;
+    #endif
+
+#ifdef _WIN32
+    struct timespec_syscall local_ts = { 0 };
+    int result = msc_clock_gettime( cid, & local_ts );
+#else
+    struct timespec local_ts; // this varies in size from platform to platform
+    int result = clock_gettime( cid, & local_ts );
+#endif
+
+    sec = local_ts.tv_sec;
+    nsec = local_ts.tv_nsec;
+    return result;
+} //host_clock_gettime
+
+#ifdef ARMOS
+uint64_t emulator_clock( uint32_t clock_id )
+{
+    // the vdso's clock_gettime() and gettimeofday() read the clock here, so they match the syscalls. when the
+    // host clock fails this is all ones, and the vdso makes the syscall so the app gets the error
+
+    uint64_t value = 0;
+    if ( !g_replay_log.empty() && replay_clock_read( value ) )
+        return value;
+
+    uint64_t sec = 0, nsec = 0;
+    if ( 0 == host_clock_gettime( (clockid_t) clock_id, sec, nsec ) )
+        value = ( sec * 1000000000 ) + nsec;
+    else
+        value = ~ (uint64_t) 0;
+    if ( 0 != g_record_file )
+        record_clock_read( value );
+    return value;
+} //emulator_clock
+
+// apps read these with mrs of PMEVCNTR<counter>_EL0 or with emulator_sys_counters, which also gives the calling
+// thread's retired instructions as PMCCNTR_EL0 does. instruction counts don't depend on the host or on -j, so
+// benchmarks can measure a region by them rather than by time
+
+enum EmulatorCounter { counter_syscalls = 0, counter_brk_bytes, counter_mmap_bytes, counter_count };
+
+static uint64_t process_counter( uint32_t counter ) // with syscall_mutex held
+{
+    if ( counter_syscalls == counter )
+        return g_process->syscall_count;
+    if ( counter_brk_bytes == counter )
+        return g_process->brk_offset - g_process->end_of_data;
+    if ( counter_mmap_bytes == counter )
+        return g_process->mmap_arena.usage();
+    return 0;
+} //process_counter
+
+uint64_t emulator_counter( uint32_t counter )
+{
+    lock_guard<mutex> lock( g_process->syscall_mutex ); // other threads may be in brk or mmap
+    return process_counter( counter );
+} //emulator_counter
+#endif
+
+static bool syscall_clock_gettime( CPUClass & cpu, SyscallLock & syscall_lock )
+{
+    uint64_t sec = 0, nsec = 0;
+    int result = host_clock_gettime( (clockid_t) ACCESS_REG( REG_ARG0 ), sec, nsec );
+
+    struct timespec_syscall * ptimespec = (struct timespec_syscall *) cpu.getmem( ACCESS_REG( REG_ARG1 ) );
+    ptimespec->tv_sec = sec;
+    ptimespec->tv_nsec = nsec;
+    ptimespec->swap_endianness();
+
+    tracer.Trace( "  tv_sec %llx, tv_nsec %llx\n", ptimespec->tv_sec, (uint64_t) ptimespec->tv_nsec );
+    update_result_errno( cpu, result );
+    return true;
+} //syscall_clock_gettime
+
+static bool syscall_brk( CPUClass & cpu, SyscallLock & syscall_lock )
+{
+    REG_TYPE original = g_process->brk_offset;
+    REG_TYPE ask = ACCESS_REG( REG_ARG0 );
+    if ( 0 == ask )
+        ACCESS_REG( REG_RESULT ) = cpu.get_vm_address( g_process->brk_offset );
+    else
+    {
+        REG_TYPE ask_offset = ask - g_process->base_address;
+        tracer.Trace( "  ask_offset %llx, g_end_of_data %llx, bottom_of_stack %llx\n", (uint64_t) ask_offset, (uint64_t) g_process->end_of_data, (uint64_t) g_process->bottom_of_stack );
+
+#ifdef ARMOS
+        if ( ask_offset >= g_process->end_of_data && ask_offset < g_process->bottom_of_stack && g_process->vm_memory.commit( (size_t) g_process->end_of_data, (size_t) ( ask_offset - g_process->end_of_data ) ) )
+#else
+        if ( ask_offset >= g_process->end_of_data && ask_offset < g_process->bottom_of_stack )
+#endif
+        {
+            g_process->brk_offset = cpu.getoffset( ask );
+            if ( g_process->brk_offset > g_process->highwater_brk )
+                g_process->highwater_brk = g_process->brk_offset;
+#if defined( X64OS ) || defined( X32OS ) // as far as I can tell x32 and x64 are the only platforms that requires the ask to be in the result on return
+            ACCESS_REG( REG_RESULT ) = ask;
+#endif
+        }
+        else
+        {
+            tracer.Trace( "  allocation request was too large, failing it by returning current brk\n" );
+            ACCESS_REG( REG_RESULT ) = cpu.get_vm_address( g_process->brk_offset );
+        }
+    }
+
+    tracer.Trace( "  SYS_brk. ask %llx, current brk %llx, new brk %llx, result in return register %llx\n",
+                  (uint64_t) ask, (uint64_t) original, (uint64_t) g_process->brk_offset, (uint64_t) ACCESS_REG( REG_RESULT ) );
+    return true;
+} //syscall_brk
+
+#ifdef ARMOS
+static bool syscall_futex( CPUClass & cpu, SyscallLock & syscall_lock )
+{
+    if ( !cpu.is_address_valid( ACCESS_REG( REG_ARG0 ) ) ) // sometimes it's malformed on arm64. not sure why yet.
+    {
+        tracer.Trace( "futex pointer in reg 0 is malformed\n" );
+        ACCESS_REG( REG_RESULT ) = 0;
+        return true;
+    }
+
+    uint64_t address = ACCESS_REG( REG_ARG0 );
+    int futex_op = (int) ACCESS_REG( REG_ARG1 ) & 0x7f; // strip the private and clock_realtime flags
+    bool realtime = ( 0 != ( ACCESS_REG( REG_ARG1 ) & 256 ) );
+    uint32_t value = (uint32_t) ACCESS_REG( REG_ARG2 );
+    int64_t result;
+
+    tracer.Trace( "  futex address %llx, futex_op %d, val %d\n", address, futex_op, value );
+
+    if ( 0 == futex_op || 9 == futex_op ) // FUTEX_WAIT, FUTEX_WAIT_BITSET
+    {
+        uint32_t bitset = ( 9 == futex_op ) ? (uint32_t) ACCESS_REG( REG_ARG5 ) : 0xffffffff;
+        steady_clock::time_point deadline;
+        bool timed = ( 0 != ACCESS_REG( REG_ARG3 ) );
+
+        if ( timed )
+        {
+            struct timespec_syscall ts = * (struct timespec_syscall *) cpu.getmem( ACCESS_REG( REG_ARG3 ) );
+            int64_t ns = (int64_t) swap_endian64( ts.tv_sec ) * 1000000000 + (int64_t) swap_endian64( ts.tv_nsec );
+            if ( 9 == futex_op ) // bitset waits have an absolute timeout
+                ns -= guest_clock_ns( realtime ? CLOCK_REALTIME : CLOCK_MONOTONIC );
+            deadline = steady_clock::now() + nanoseconds( ns );
+        }
+
+        if ( 0 == bitset )
+            result = -linuxEINVAL;
+        else
+            BLOCKING_CALL( result = futex_wait( cpu, address, value, bitset, timed ? &deadline : 0 ) );
+    }
+    else if ( 1 == futex_op || 10 == futex_op ) // FUTEX_WAKE, FUTEX_WAKE_BITSET
+        result = futex_wake( address, value, ( 10 == futex_op ) ? (uint32_t) ACCESS_REG( REG_ARG5 ) : 0xffffffff );
+    else if ( 3 == futex_op || 4 == futex_op ) // FUTEX_REQUEUE, FUTEX_CMP_REQUEUE. the timeout argument is the requeue count
+        result = futex_requeue( cpu, address, value, (uint32_t) ACCESS_REG( REG_ARG3 ), ACCESS_REG( REG_ARG4 ),
+                                4 == futex_op, (uint32_t) ACCESS_REG( REG_ARG5 ) );
+    else
+    {
+        tracer.Trace( "  unsupported futex op %d\n", futex_op );
+        result = -linuxENOSYS;
+    }
+
+    tracer.Trace( "  futex result %lld\n", result );
+    ACCESS_REG( REG_RESULT ) = (REG_TYPE) result;
+    return true;
+} //syscall_futex
+#endif
+
+struct FastSyscallTable
+{
+    FastSyscall handlers[ 256 ];
+
+    FastSyscallTable()
+    {
+        memset( handlers, 0, sizeof( handlers ) );
+        handlers[ SYS_read ] = syscall_read;
+        handlers[ SYS_write ] = syscall_write;
+        handlers[ SYS_clock_gettime ] = syscall_clock_gettime;
+        handlers[ SYS_brk ] = syscall_brk;
+#ifdef ARMOS
+        handlers[ SYS_futex ] = syscall_futex;
+#endif
+    }
+};
+
+static FastSyscallTable g_fast_syscalls;
+
+#if defined( _WIN32 ) || !defined( OLDGCC )
+
+static int read_directory_entry( DirEnumeration & e )
+{
+    // loads the next host entry into e.name and e.type unless one is pending. 1 for an entry, 0 at the end, or -1
+
+    if ( e.pending )
+        return 1;
+    if ( e.done )
+        return 0;
+
+#ifdef _WIN32
+    WIN32_FIND_DATAA fd = {0};
+
+    if ( INVALID_HANDLE_VALUE == e.find )
+    {
+        // large fetch has the file system return many entries per call rather than one
+
+        tracer.Trace( "findfirstfileex call, pattern '%s'\n", e.pattern.c_str() );
+        e.find = FindFirstFileExA( e.pattern.c_str(), FindExInfoBasic, &fd, FindExSearchNameMatch, 0, FIND_FIRST_EX_LARGE_FETCH );
+        if ( INVALID_HANDLE_VALUE == e.find )
+        {
+            tracer.Trace( "find first failed error %d\n", GetLastError() );
+            errno = EINVAL;
+            return -1;
+        }
+    }
+    else if ( !FindNextFileA( e.find, &fd ) )
+    {
+        tracer.Trace( "  out of next files\n" );
+        e.done = true;
+        return 0;
+    }
+
+    e.name = fd.cFileName;
+    if ( ( FILE_ATTRIBUTE_DIRECTORY & fd.dwFileAttributes ) && ( FILE_ATTRIBUTE_REPARSE_POINT & fd.dwFileAttributes ) && is_dir_symbolic_link( fd.cFileName ) )
+        e.type = 10; // DT_LNK
+    else if ( FILE_ATTRIBUTE_DIRECTORY & fd.dwFileAttributes )
+        e.type = 4; // DT_DIR
+    else
+        e.type = 8; // DT_REG
+#else
+    struct dirent * pent = readdir( e.dir );
+    if ( 0 == pent )
+    {
+        tracer.Trace( "  readdir returned 0, so there are no more files in the enumeration\n" );
+        e.done = true;
+        return 0;
+    }
+
+    e.name = pent->d_name;
+    e.type = pent->d_type;
+#endif
+
+    e.pending = true;
+    return 1;
+} //read_directory_entry
+
+static int fill_directory_entries( DirEnumeration & e, uint8_t * pentries, size_t count, bool dirent64 )
+{
+    // packs as many linux_dirent64 (or old linux_dirent) records as fit. bytes written, 0 at the end, or -1
+
+    size_t used = 0;
+    for ( ;; )
+    {
+        int status = read_directory_entry( e );
+        if ( status < 0 )
+            return ( 0 == used ) ? -1 : (int) used;
+        if ( 0 == status )
+            break;
+
+        size_t len = e.name.length();
+        size_t reclen;
+        if ( dirent64 )
+            reclen = round_up( offsetof( struct linux_dirent64_syscall, d_name ) + len + 1, (size_t) 8 );
+        else
+            reclen = offsetof( struct linux_dirent_syscall, d_name ) + len + 1 + 1; // null termination on the string + file type
+
+        if ( reclen > ( count - used ) )
+        {
+            if ( 0 != used )
+                break; // the entry stays pending for the next call
+
+            tracer.Trace( "  buffer of %zd bytes is too small for '%s'\n", count, e.name.c_str() );
+            errno = EINVAL;
+            return -1;
+        }
+
+        e.position++;
+        if ( dirent64 )
+        {
+            struct linux_dirent64_syscall * pcur = (struct linux_dirent64_syscall *) ( pentries + used );
+            pcur->d_ino = 100; // fake
+            pcur->d_off = e.position;
+            pcur->d_reclen = (uint16_t) reclen;
+            pcur->d_type = e.type;
+            memcpy( pcur->d_name, e.name.c_str(), len + 1 );
+            tracer.Trace( "  wrote '%s' into the entry. d_reclen %d, d_off %d, d_type %#x\n", pcur->d_name, (int) pcur->d_reclen, (int) pcur->d_off, pcur->d_type );
+            pcur->swap_endianness();
+        }
+        else
+        {
+            struct linux_dirent_syscall * pcur = (struct linux_dirent_syscall *) ( pentries + used );
+            pcur->d_ino = 100; // fake
+            pcur->d_off = (uint32_t) e.position;
+            pcur->d_reclen = (uint16_t) reclen;
+            pcur->settype( e.type );
+            memcpy( pcur->d_name, e.name.c_str(), len + 1 );
+            tracer.Trace( "  wrote '%s' into the entry. d_reclen %d, d_off %d, d_type %#x\n", pcur->d_name, (int) pcur->d_reclen, (int) pcur->d_off, pcur->gettype() );
+            pcur->swap_endianness();
+        }
+
+        e.pending = false;
+        used += reclen;
+    }
+
+    return (int) used;
+} //fill_directory_entries
+
+static void seek_directory( DirEnumeration & e, uint64_t position )
+{
+    // d_off values are entry counts, so seekdir() and rewinddir() restart the enumeration and skip ahead
+
+#ifdef _WIN32
+    if ( INVALID_HANDLE_VALUE != e.find )
+    {
+        FindClose( e.find );
+        e.find = INVALID_HANDLE_VALUE;
+    }
+#else
+    rewinddir( e.dir );
+#endif
+
+    e.position = 0;
+    e.pending = false;
+    e.done = false;
+
+    while ( ( e.position < position ) && ( 1 == read_directory_entry( e ) ) )
+    {
+        e.position++;
+        e.pending = false;
+    }
+} //seek_directory
+
+static void close_directory( DirEnumeration & e )
+{
+#ifdef _WIN32
+    if ( INVALID_HANDLE_VALUE != e.find )
+        FindClose( e.find );
+#else
+    closedir( e.dir ); // this closes the descriptor too
+#endif
+} //close_directory
+
+#endif
+
+#ifdef _WIN32
+
+static int open_directory( map<REG_TYPE, DirEnumeration> & enumerations, const char * path )
+{
+    // returns a fake descriptor for a directory opened with O_DIRECTORY. the enumeration starts on the first getdents
+
+    REG_TYPE descriptor = findFirstDescriptor;
+    while ( 0 != enumerations.count( descriptor ) )
+        descriptor++;
+
+    DirEnumeration & e = enumerations[ descriptor ];
+    e.pattern = path;
+    if ( '\\' != e.pattern.back() )
+        e.pattern += "\\";
+    e.pattern += "*.*";
+    tracer.Trace( "  directory '%s' is fake descriptor %d\n", path, (int) descriptor );
+    return (int) descriptor;
+} //open_directory
+
+#endif
+
+#ifdef ARMOS
+
+// armos running under armos, as with runall.sh nested, would emulate the emulator. instead the inner armos passes
+// its app to the outer one with emulator_sys_run_nested, which runs it as an embedded guest on the calling thread.
+// the app's instructions are then emulated once however deep the nesting goes
+
+const uint64_t nested_jit = 1;
+const uint64_t nested_host_routines = 2;
+
+struct NestedRun                   // emulator_sys_run_nested's argument, in the inner armos' memory
+{
+    uint64_t app;                  // image path
+    uint64_t app_args;             // space-separated, like armos' command line
+    uint64_t stack_bytes;
+    uint64_t brk_bytes;
+    uint64_t mmap_bytes;
+    uint64_t flags;                // nested_*
+    uint64_t fault;                // buffer for why the app faulted, if it did
+    uint64_t fault_size;
+    int64_t exit_code;             // these two are set by the outer armos
+    uint64_t handled;              // 1 once the app has run; older armos builds leave it 0
+    uint64_t env;                  // null-terminated NAME=value pointers, or 0. last so older outer builds ignore it
+
+    void swap_endianness()
+    {
+        app = swap_endian64( app );
+        app_args = swap_endian64( app_args );
+        stack_bytes = swap_endian64( stack_bytes );
+        brk_bytes = swap_endian64( brk_bytes );
+        mmap_bytes = swap_endian64( mmap_bytes );
+        flags = swap_endian64( flags );
+        fault = swap_endian64( fault );
+        fault_size = swap_endian64( fault_size );
+        exit_code = swap_endian64( exit_code );
+        handled = swap_endian64( handled );
+        env = swap_endian64( env );
+    }
+};
+
+static void run_nested_app( CPUClass & cpu, NestedRun & run, SyscallLock & syscall_lock )
+{
+    const char * app = (const char *) cpu.getmem( run.app );
+    const char * app_args = ( 0 == run.app_args ) ? "" : (const char *) cpu.getmem( run.app_args );
+    vector<string> env;
+    read_guest_strings( cpu, run.env, env );
+    tracer.Trace( "  running nested app %s with arguments '%s' and %zu environment variables\n", app, app_args, env.size() );
+
+    vector<uint8_t> image;
+    FILE * fp = fopen( app, "rb" );
+    if ( 0 != fp )
+    {
+        CFile file( fp );
+        int64_t size = portable_filelen( fp );
+        if ( size > 0 )
+        {
+            image.resize( (size_t) size );
+            if ( 1 != fread( image.data(), image.size(), 1, fp ) )
+                image.clear();
+        }
+    }
+
+    uint32_t tid = g_tid; // the guest's run() uses this host thread
+    uint64_t clear_child_tid = g_clear_child_tid;
+
+    ArmosGuest guest;
+    guest.set_memory_limits( run.stack_bytes, run.brk_bytes, run.mmap_bytes );
+    ArmosGuest::RunResult result = ArmosGuest::run_fault;
+    if ( guest.load( image.data(), image.size(), app, app_args, env ) )
+    {
+        if ( run.flags & nested_jit )
+            guest.cpu()->enable_jit( true );
+        if ( run.flags & nested_host_routines )
+            enable_host_routines( * guest.cpu() );
+        BLOCKING_CALL( result = guest.run() ); // the outer app's other threads can make syscalls meanwhile
+    }
+
+    g_tid = tid;
+    g_clear_child_tid = clear_child_tid;
+    g_process->thread_instructions += guest.instructions(); // so -p counts them
+
+    run.exit_code = ( ArmosGuest::run_exited == result ) ? guest.exit_code() : 1;
+    if ( ( ArmosGuest::run_exited != result ) && ( 0 != run.fault ) && ( 0 != run.fault_size ) )
+    {
+        char * pfault = (char *) cpu.getmem( run.fault );
+        strncpy( pfault, guest.fault_message(), (size_t) run.fault_size );
+        pfault[ run.fault_size - 1 ] = 0;
+    }
+    run.handled = 1;
+    tracer.Trace( "  nested app exit code %lld, %llu instructions\n", run.exit_code, guest.instructions() );
+} //run_nested_app
+
+#endif //ARMOS
+
+// this is called when the arm64 app has an svc #0 instruction or a RISC-V 64 app has an ecall instruction
+// https://thevivekpandey.github.io/posts/2017-09-25-linux-system-calls.html
+
+#pragma warning(disable: 4189) // unreferenced local variable
+
+void emulator_invoke_svc( CPUClass & cpu )
+{
+#if defined( _WIN32 ) || !defined( OLDGCC )
+    map<REG_TYPE, DirEnumeration> & g_dirEnumerations = g_process->dir_enumerations;
+#endif
+#ifdef _WIN32
+    char acPath[ EMULATOR_MAX_PATH ];
+#endif
+
+    REG_TYPE syscall_id = ACCESS_REG( REG_SYSCALL );
+
+#ifdef ARMOS
+    SyscallLock syscall_lock( g_process->syscall_mutex );
+    HeldSyscallLock held_lock( syscall_lock );
+    g_process->syscall_count++;
+
+    if ( ( 0 != g_process->syscall_hook ) && g_process->syscall_hook( g_process->syscall_hook_context, cpu, syscall_id ) )
+        return;
+#else
+    SyscallLock syscall_lock;
+#endif
+
+#ifdef SPARCOS
+    cpu.setflag_c( 0 ); // Linux on Sparc uses the carry flag in addition to the result register to indicate success/failure
+    syscall_id = MapSparcToRiscV( syscall_id );
+    tracer.Trace( "mapped sparc syscall %u to %u\n", ACCESS_REG( REG_SYSCALL ), syscall_id );
+    if ( 0 == syscall_id )
+    {
+        printf( "unable to find a Sparc mapping for syscall %u\n", ACCESS_REG( REG_SYSCALL ) );
+        tracer.Trace( "unable to find a Sparc mapping for syscall %u\n", ACCESS_REG( REG_SYSCALL ) );
+    }
+#elif defined( X64OS )
+    syscall_id = MapX64ToRiscV( syscall_id );
+    tracer.Trace( "mapped x64 syscall %llu to %llu\n", ACCESS_REG( REG_SYSCALL ), syscall_id );
+    if ( 0 == syscall_id )
+    {
+        printf( "unable to find an X64 mapping for syscall %llu\n", ACCESS_REG( REG_SYSCALL ) );
+        tracer.Trace( "unable to find an X64 mapping for syscall %llu\n", ACCESS_REG( REG_SYSCALL ) );
+    }
+#elif defined( X32OS )
+    syscall_id = MapX32ToRiscV( syscall_id );
+    tracer.Trace( "mapped x32 syscall %u to %u\n", ACCESS_REG( REG_SYSCALL ), syscall_id );
+    if ( 0 == syscall_id )
+    {
+        printf( "unable to find an X32 mapping for syscall %u\n", ACCESS_REG( REG_SYSCALL ) );
+        tracer.Trace( "unable to find an X32 mapping for syscall %u\n", ACCESS_REG( REG_SYSCALL ) );
+    }
+#endif
+
+    steady_clock::time_point tSyscallStart;
+    if ( g_syscall_timing )
+        tSyscallStart = steady_clock::now();
+
+#ifdef ARMOS
+    SyscallLog syscall_log( cpu, syscall_id );
+    if ( syscall_log.answered() )
+    {
+        if ( g_syscall_timing )
+            record_syscall( cpu, syscall_id, tSyscallStart );
+        return;
+    }
+#endif
+
+#if !defined( OLDGCC ) && !defined( __mc68000__ )
+    if ( !g_process->stat_cache.empty() && syscall_changes_metadata( cpu, syscall_id ) )
+        stat_cache_clear();
+#endif
+
+    // the hot syscalls skip the switch unless they're being traced
+
+    if ( !tracer.IsEnabled() )
+    {
+        if ( ( syscall_id < _countof( g_fast_syscalls.handlers ) ) && ( 0 != g_fast_syscalls.handlers[ syscall_id ] ) &&
+             g_fast_syscalls.handlers[ syscall_id ]( cpu, syscall_lock ) )
+        {
+            if ( g_syscall_timing )
+                record_syscall( cpu, syscall_id, tSyscallStart );
+            return;
+        }
+    }
+    else // Linux syscalls support up to 6 arguments
+#if defined( M68 ) || defined( SPARCOS ) || defined( X32OS )
+        tracer.Trace( "syscall %s %x = %d, arg0 %x, arg1 %x, arg2 %x, arg3 %x, arg4 %x, arg5 %x\n",
+                      lookup_syscall( syscall_id ), syscall_id, syscall_id,
+                      ACCESS_REG( REG_ARG0 ), ACCESS_REG( REG_ARG1 ), ACCESS_REG( REG_ARG2 ), ACCESS_REG( REG_ARG3 ),
+                      ACCESS_REG( REG_ARG4 ), ACCESS_REG( REG_ARG5 ) );
+#else
+        tracer.Trace( "syscall %s %llx = %lld, arg0 %llx, arg1 %llx, arg2 %llx, arg3 %llx, arg4 %llx, arg5 %llx\n",
+                      lookup_syscall( (uint32_t) syscall_id ), syscall_id, syscall_id,
+                      ACCESS_REG( REG_ARG0 ), ACCESS_REG( REG_ARG1 ), ACCESS_REG( REG_ARG2 ), ACCESS_REG( REG_ARG3 ),
+                      ACCESS_REG( REG_ARG4 ), ACCESS_REG( REG_ARG5 ) );
+#endif
+
+    switch ( syscall_id )
+    {
+        case emulator_sys_exit: // exit
+        case SYS_exit:
+        case SYS_exit_group:
+        case SYS_tgkill:
+        {
+#ifdef ARMOS
+            if ( SYS_exit == syscall_id && ( 1 != g_tid ) ) // just this thread
+            {
+                tracer.Trace( "  thread %u exit code %d\n", g_tid, (int) ACCESS_REG( REG_ARG0 ) );
+                cpu.end_emulation();
+                break;
+            }
+
+            if ( SYS_exit == syscall_id ) // main's exit doesn't end other threads
+                cpu.end_emulation();
+            else
+                end_all_threads();
+#else
+            g_process->terminate = true;
+            cpu.end_emulation();
+#endif
+            g_process->exit_code = (int) ACCESS_REG( REG_ARG0 );
+            tracer.Trace( "  emulated app exit code %d\n", g_process->exit_code );
+            update_result_errno( cpu, 0 );
+            break;
+        }
+#if defined( X32OS )
+        case emulator_sys_ugetrlimit:
+        {
+            errno = EINVAL;
+            update_result_errno( cpu, -1 );
+            break;
         }
         case emulator_sys_set_thread_area:
         {
@@ -2079,7 +6427,7 @@ void emulator_invoke_svc( CPUClass & cpu )
                 cpu.reg_gs() = pud->base_addr;
             }
             pud->swap_endianness();
-            memcpy( & g_user_desc, pud, sizeof( *pud ) );
+            memcpy( & g_process->user_desc, pud, sizeof( *pud ) );
 
             update_result_errno( cpu, 0 );
             break;
@@ -2088,7 +6436,7 @@ void emulator_invoke_svc( CPUClass & cpu )
         case emulator_sys_get_thread_area:
         {
             struct linux_user_desc * pud = (linux_user_desc *) cpu.getmem( ACCESS_REG( REG_ARG0 ) );
-            memcpy( pud, & g_user_desc, sizeof( *pud ) );
+            memcpy( pud, & g_process->user_desc, sizeof( *pud ) );
             update_result_errno( cpu, 0 );
             break;
         }
@@ -2121,6 +6469,41 @@ void emulator_invoke_svc( CPUClass & cpu )
             update_result_errno( cpu, 0 );
             break;
         }
+        case emulator_sys_snapshot:
+        {
+            update_result_errno( cpu, 0 ); // before the snapshot, so the restored app also sees success
+#ifdef ARMOS
+            if ( 0 != g_snapshot_path )
+                write_snapshot( cpu, cpu.pc + 4 ); // resume after the svc
+#ifndef _WIN32
+            if ( 0 != g_serve_path )
+                serve_jobs( &cpu ); // returns in each job's process
+#endif
+#endif
+            break;
+        }
+#ifdef ARMOS
+        case emulator_sys_run_nested:
+        {
+            NestedRun * prun = (NestedRun *) cpu.getmem( ACCESS_REG( REG_ARG0 ) );
+            NestedRun run = * prun;
+            run.swap_endianness();
+            run_nested_app( cpu, run, syscall_lock );
+            run.swap_endianness();
+            * prun = run;
+            update_result_errno( cpu, 0 );
+            break;
+        }
+        case emulator_sys_counters: // a0 is an array of a1 uint64_t: instructions, then each EmulatorCounter
+        {
+            uint64_t count = get_min( (uint64_t) ACCESS_REG( REG_ARG1 ), (uint64_t) counter_count + 1 );
+            for ( uint64_t i = 0; i < count; i++ )
+                cpu.setui64( ACCESS_REG( REG_ARG0 ) + i * 8, ( 0 == i ) ? cpu.cycles : process_counter( (uint32_t) ( i - 1 ) ) );
+            tracer.Trace( "  wrote %llu counters\n", count );
+            update_result_errno( cpu, (int64_t) count );
+            break;
+        }
+#endif
         case emulator_sys_print_int64:
         {
             printf( REG_FORMAT, ACCESS_REG( REG_ARG0 ) );
@@ -2223,6 +6606,39 @@ void emulator_invoke_svc( CPUClass & cpu )
             int fd = (int) ACCESS_REG( REG_ARG0 );
             int op = (int) ACCESS_REG( REG_ARG1 );
 
+#if defined( ARMOS ) && !defined( _WIN32 )
+            // descriptors and their close-on-exec flags are the host's, and matter once apps fork and exec
+
+            if ( 0 == op || 1030 == op ) // F_DUPFD, F_DUPFD_CLOEXEC
+            {
+                int result = fcntl( fd, ( 0 == op ) ? F_DUPFD : F_DUPFD_CLOEXEC, (int) ACCESS_REG( REG_ARG2 ) );
+                update_result_errno( cpu, result );
+                break;
+            }
+            if ( 1 == op || 2 == op ) // F_GETFD, F_SETFD. FD_CLOEXEC is 1 everywhere
+            {
+                int result = ( 1 == op ) ? fcntl( fd, F_GETFD ) : fcntl( fd, F_SETFD, (int) ACCESS_REG( REG_ARG2 ) & FD_CLOEXEC );
+                update_result_errno( cpu, result );
+                break;
+            }
+            if ( 3 == op ) // F_GETFL
+            {
+                int result = fcntl( fd, F_GETFL );
+                if ( -1 != result )
+                    result = translate_status_flags( result, false );
+                update_result_errno
+( cpu, result );
+                break;
+            }
+            if ( 4 == op ) // F_SETFL
+            {
+                int flags = translate_status_flags( (int) ACCESS_REG( REG_ARG2 ), true );
+                tracer.Trace( "  F_SETFL of fd %d: %#x, host %#x\n", fd, (int) ACCESS_REG( REG_ARG2 ), flags );
+                update_result_errno( cpu, fcntl( fd, F_SETFL, flags ) );
+                break;
+            }
+#endif
+
             if ( 1 == op ) // F_GETFD
                 ACCESS_REG( REG_RESULT ) = 1; // FD_CLOEXEC
             else if ( 3 == op )
@@ -2254,7 +6670,7 @@ void emulator_invoke_svc( CPUClass & cpu )
 
             uint64_t ms = local_request.tv_sec * 1000 + local_request.tv_nsec / 1000000;
             tracer.Trace( "  nanosleep sec %llu, nsec %llu == %llu ms\n", (uint64_t) local_request.tv_sec, (uint64_t) local_request.tv_nsec, ms );
-            sleep_ms( ms ); // ignore remain argument because there are no signals to wake the thread
+            BLOCKING_CALL( sleep_ms( ms ) ); // ignore remain argument because there are no signals to wake the thread
             update_result_errno( cpu, 0 );
             break;
         }
@@ -2266,13 +6682,36 @@ void emulator_invoke_svc( CPUClass & cpu )
         }
         case SYS_sched_getaffinity:
         {
+#ifdef ARMOS
+            // report one cpu per host core, since guest threads run on host threads
+
+            uint64_t cpusetsize = ACCESS_REG( REG_ARG1 );
+            uint32_t cores = get_max( 1u, thread::hardware_concurrency() );
+            uint64_t mask_bytes = ( ( cores + 63 ) / 64 ) * 8;
+            if ( cpusetsize < mask_bytes )
+            {
+                ACCESS_REG( REG_RESULT ) = (REG_TYPE) -linuxEINVAL;
+                break;
+            }
+
+            uint8_t * pmask = (uint8_t *) cpu.getmem( ACCESS_REG( REG_ARG2 ) );
+            memset( pmask, 0, mask_bytes );
+            for ( uint32_t i = 0; i < cores; i++ )
+                pmask[ i / 8 ] |= ( 1 << ( i % 8 ) );
+            tracer.Trace( "  getaffinity, %u cores\n", cores );
+            update_result_errno( cpu, mask_bytes );
+#else
             tracer.Trace( "  getaffinity, EPERM %d\n", EPERM );
             update_result_errno( cpu, EPERM );
+#endif
             break;
         }
         case SYS_sched_yield:
         {
-            // always succeeds on Linux, even though nothing happens here.
+            // always succeeds on Linux
+#ifdef ARMOS
+            BLOCKING_CALL( this_thread::yield() );
+#endif
             update_result_errno( cpu, 0 );
             break;
         }
@@ -2411,6 +6850,23 @@ void emulator_invoke_svc( CPUClass & cpu )
             int offset = (int) ACCESS_REG( REG_ARG1 );
             int origin = (int) ACCESS_REG( REG_ARG2 );
 
+#if defined( _WIN32 ) || !defined( OLDGCC )
+            map<REG_TYPE, DirEnumeration>::iterator it = g_dirEnumerations.find( descriptor );
+            if ( it != g_dirEnumerations.end() )
+            {
+                if ( ( SEEK_SET != origin ) || ( offset < 0 ) )
+                {
+                    errno = EINVAL;
+                    update_result_errno( cpu, -1 );
+                    break;
+                }
+
+                seek_directory( it->second, offset );
+                update_result_errno( cpu, (int) it->second.position );
+                break;
+            }
+#endif
+
             long result = lseek( descriptor, offset, origin );
             update_result_errno( cpu, result );
             break;
@@ -2422,24 +6878,13 @@ void emulator_invoke_svc( CPUClass & cpu )
             uint32_t buffer_size = (uint32_t) ACCESS_REG( REG_ARG2 );
             tracer.Trace( "  syscall command SYS_read. descriptor %d, buffer_size %u, buffer %llx\n", descriptor, buffer_size, ACCESS_REG( REG_ARG1 ) );
 
-            if ( 0 == descriptor ) //&& 1 == buffer_size )
+            if ( 0 == descriptor )
             {
-#ifdef _WIN32
-                int r = g_consoleConfig.linux_getch();
-#else
-                int r = g_consoleConfig.portable_getch();
-#endif
-                if ( EOF == r )
-                {
-                    ACCESS_REG( REG_RESULT ) = 0;
-                    tracer.Trace( "  getch reached the end of file on stdin\n" );
-                }
-                else
-                {
-                    * (char *) buffer = (char) r;
-                    ACCESS_REG( REG_RESULT ) = 1;
-                    tracer.Trace( "  getch read character %u == '%c'\n", (uint8_t) r, printable( (uint8_t) r ) );
-                }
+                int r;
+                BLOCKING_CALL( r = read_stdin( buffer, buffer_size ) );
+                if ( r > 0 )
+                    tracer.TraceBinaryData( (uint8_t *) buffer, (int) get_min( (int) 0x100, r ), 4 );
+                update_result_errno( cpu, r );
                 break;
             }
             else if ( timebaseFrequencyDescriptor == descriptor && buffer_size >= 8 )
@@ -2457,7 +6902,8 @@ void emulator_invoke_svc( CPUClass & cpu )
                 break;
             }
 
-            int result = read( descriptor, buffer, buffer_size );
+            int result;
+            BLOCKING_CALL( result = read( descriptor, buffer, buffer_size ) );
             if ( result > 0 )
                 tracer.TraceBinaryData( (uint8_t *) buffer, (int) get_min( (int) 0x100, result ), 4 );
             update_result_errno( cpu, result );
@@ -2484,14 +6930,7 @@ void emulator_invoke_svc( CPUClass & cpu )
                     tracer.Trace( "  writing '%.*s'\n", (int) count, p );
 
                 tracer.TraceBinaryData( p, (uint32_t) count, 4 );
-                size_t written;
-#ifdef _WIN32
-                if ( 1 == descriptor || 2 == descriptor ) // stdout / stderr
-                    written = WinWrite( descriptor, p, (int) count );
-                else
-#endif
-                written = write( descriptor, p, (int) count );
-                update_result_errno( cpu, (REG_TYPE) written );
+                syscall_write( cpu, syscall_lock );
             }
             break;
         }
@@ -2515,260 +6954,70 @@ void emulator_invoke_svc( CPUClass & cpu )
             strcpy( acPath, pname );
             slash_to_backslash( acPath );
 
-            bool opendir = is_o_directory_set( original_flags );
-            int descriptor;
-            tracer.Trace( "  opendir: %u\n", opendir );
-            DWORD attr = GetFileAttributesA( acPath );
-            if ( opendir && ( INVALID_FILE_ATTRIBUTES != attr ) && ( attr & FILE_ATTRIBUTE_DIRECTORY ) )
-            {
-                if ( INVALID_HANDLE_VALUE != g_hFindFirst )
-                {
-                    FindClose( g_hFindFirst );
-                    g_hFindFirst = INVALID_HANDLE_VALUE;
-                }
-                strcpy( g_acFindFirstPattern, acPath );
-                size_t len = strlen( g_acFindFirstPattern );
-                if ( '\\' != g_acFindFirstPattern[ len - 1 ] )
-                    strcat( g_acFindFirstPattern, "\\" );
-                strcat( g_acFindFirstPattern, "*.*" );
-                descriptor = findFirstDescriptor;
-            }
-            else
-            {
-#ifdef M68
-                if ( is_o_creat_set( original_flags ) )
-                    mode = _S_IREAD | _S_IWRITE; // __mc68000__ passes user-related flags that conflict with these flags
-#endif //M68
-                descriptor = _open( pname, flags, mode );
-            }
-#else // !_WIN32
-
-            const char * pfilename = pname;
-
-            if ( ! is_o_creat_set( original_flags ) )
-                mode = 0; // mode is only defined if O_CREAT or O_TMPFILE are specified, and O_TMPFILE isn't defined for most platforms
-
-            int descriptor = open( pfilename, flags, mode );
-#endif //_WIN32
-
-            tracer.Trace( "  result of open: descriptor: %d, mode %#x\n", descriptor, mode );
-            update_result_errno( cpu, descriptor );
-            break;
-        }
-        case SYS_close:
-        {
-            int descriptor = (int) ACCESS_REG( REG_ARG0 );
-            tracer.Trace( "  syscall command SYS_close %d\n", descriptor );
-
-            if ( descriptor >= 0 && descriptor <= 2 )
-            {
-                // built-in handle stdin, stdout, stderr -- ignore
-                ACCESS_REG( REG_RESULT ) = 0;
-            }
-            else
-            {
-                int result = 0;
-#ifdef _WIN32
-                if ( findFirstDescriptor == descriptor )
-                {
-                    if ( INVALID_HANDLE_VALUE != g_hFindFirst )
-                    {
-                        FindClose( g_hFindFirst );
-                        g_hFindFirst = INVALID_HANDLE_VALUE;
-                        g_acFindFirstPattern[ 0 ] = 0;
-                    }
-                    update_result_errno( cpu, 0 );
-                    break;
-                }
-                else if ( timebaseFrequencyDescriptor == descriptor || osreleaseDescriptor == descriptor )
-                {
-                    update_result_errno( cpu, 0 );
-                    break;
-                }
-                else
-#else
-    #if !defined( OLDGCC )
-                if ( g_FindFirstDescriptor == descriptor )
-                {
-                    if ( 0 != g_FindFirst )
-                    {
-                        closedir( g_FindFirst );
-                        g_FindFirst = 0;
-                    }
-                    g_FindFirstDescriptor = -1;
-                    update_result_errno( cpu, 0 );
-                    break;
-                }
-    #endif
-#endif
-                result = close( descriptor );
-                update_result_errno( cpu, result );
-            }
-            break;
-        }
-        case emulator_sys_getdents:
-        {
-            int result = 0;
-            REG_TYPE descriptor = ACCESS_REG( REG_ARG0 );
-            uint8_t * pentries = (uint8_t *) cpu.getmem( ACCESS_REG( REG_ARG1 ) );
-            REG_TYPE count = ACCESS_REG( REG_ARG2 );
-            tracer.Trace( "  pentries: %p, count %u\n", pentries, (uint32_t) count );
-            struct linux_dirent_syscall * pcur = (struct linux_dirent_syscall *) pentries;
-            memset( pentries, 0, count );
-
-#ifdef _WIN32
-            if ( ( findFirstDescriptor != descriptor ) || ( 0 == g_acFindFirstPattern[ 0 ] ) )
-            {
-                tracer.Trace( "  getdents on unexpected descriptor or FindFirst (%p) not open\n", g_hFindFirst );
-                errno = EBADF;
-                update_result_errno( cpu, -1 );
-                break;
-            }
-
-            WIN32_FIND_DATAA fd = {0};
-
-            if ( INVALID_HANDLE_VALUE == g_hFindFirst )
-            {
-                tracer.Trace( "findfirstfilea call, pattern '%s'\n", g_acFindFirstPattern );
-                g_hFindFirst = FindFirstFileA( g_acFindFirstPattern, &fd );
-                if ( INVALID_HANDLE_VALUE != g_hFindFirst )
-                {
-                    tracer.Trace( "  successfully opened FindFirst for pattern '%s'\n", g_acFindFirstPattern );
-
-                    size_t len = strlen( fd.cFileName );
-                    if ( ( count < sizeof( struct linux_dirent_syscall ) ) || ( len > ( count - sizeof( struct linux_dirent_syscall ) ) ) )
-                    {
-                        errno = EINVAL;
-                        result = -1;
-                    }
-                    else
-                    {
-                        pcur->d_ino = 100; // fake
-                        tracer.Trace( "  len: %zd, sizeof struct %zd\n", len, sizeof( struct linux_dirent_syscall ) );
-                        size_t dname_off = offsetof( struct linux_dirent_syscall, d_name );
-                        pcur->d_reclen = (uint16_t) ( dname_off + len + 1 + 1 ); // null termination on the string + file type
-                        pcur->d_off = pcur->d_reclen;
-                        strcpy( pcur->d_name, fd.cFileName );
-
-                        if ( ( FILE_ATTRIBUTE_DIRECTORY & fd.dwFileAttributes ) && ( FILE_ATTRIBUTE_REPARSE_POINT & fd.dwFileAttributes ) && is_dir_symbolic_link( fd.cFileName ) )
-                            pcur->settype( 10 ); // DT_LNK
-                        else if ( FILE_ATTRIBUTE_DIRECTORY & fd.dwFileAttributes )
-                            pcur->settype( 4 ); // DT_DIR
-                        else
-                            pcur->settype( 8 ); // DT_REG
-
-                        tracer.Trace( "  wrote '%s' into the entry. d_reclen %d, d_off %d, d_type %d\n", pcur->d_name, pcur->d_reclen, pcur->d_off, pcur->gettype() );
-                        result = pcur->d_reclen;
-                        pcur->swap_endianness();
-                    }
-                }
-                else
-                {
-                    tracer.Trace( "find first failed error %d\n", GetLastError() );
-                    errno = EINVAL;
-                    result = -1;
-                }
-            }
+            bool opendir = is_o_directory_set( original_flags );
+            int descriptor;
+            tracer.Trace( "  opendir: %u\n", opendir );
+            DWORD attr = GetFileAttributesA( acPath );
+            if ( opendir && ( INVALID_FILE_ATTRIBUTES != attr ) && ( attr & FILE_ATTRIBUTE_DIRECTORY ) )
+                descriptor = open_directory( g_dirEnumerations, acPath );
             else
             {
-                // find next here
+#ifdef M68
+                if ( is_o_creat_set( original_flags ) )
+                    mode = _S_IREAD | _S_IWRITE; // __mc68000__ passes user-related flags that conflict with these flags
+#endif //M68
+                descriptor = _open( pname, flags, mode );
+            }
+#else // !_WIN32
 
-                BOOL found = FindNextFileA( g_hFindFirst, &fd );
-                if ( found )
-                {
-                    size_t len = strlen( fd.cFileName );
-                    if ( ( count < sizeof( struct linux_dirent_syscall ) ) || ( len > ( count - sizeof( struct linux_dirent_syscall ) ) ) )
-                    {
-                        errno = ENOENT;
-                        result = -1;
-                    }
-                    else
-                    {
-                        pcur->d_ino = 100; // fake
-                        tracer.Trace( "  len: %zd, sizeof struct %zd\n", len, sizeof( struct linux_dirent_syscall ) );
-                        size_t dname_off = offsetof( struct linux_dirent_syscall, d_name );
-                        pcur->d_reclen = (uint16_t) ( dname_off + len + 1 + 1 );
-                        pcur->d_off = pcur->d_reclen;
-                        strcpy( pcur->d_name, fd.cFileName );
-
-                        if ( ( FILE_ATTRIBUTE_DIRECTORY & fd.dwFileAttributes ) && ( FILE_ATTRIBUTE_REPARSE_POINT & fd.dwFileAttributes ) && is_dir_symbolic_link( fd.cFileName ) )
-                            pcur->settype( 10 ); // DT_LNK
-                        else if ( FILE_ATTRIBUTE_DIRECTORY & fd.dwFileAttributes )
-                            pcur->settype( 4 ); // DT_DIR
-                        else
-                            pcur->settype( 8 ); // DT_REG
+            const char * pfilename = pname;
 
-                        tracer.Trace( "  wrote '%s' into the entry. d_reclen %d, d_off %d, d_type %d\n", pcur->d_name, pcur->d_reclen, pcur->d_off, pcur->gettype() );
-                        tracer.TraceBinaryData( (uint8_t *) pcur, pcur->d_reclen, 4 );
-                        result = pcur->d_reclen;
-                        pcur->swap_endianness();
-                    }
-                }
-                else
-                {
-                    tracer.Trace( "  out of next files\n" );
-                    FindClose( g_hFindFirst );
-                    g_hFindFirst = INVALID_HANDLE_VALUE;
-                    g_acFindFirstPattern[ 0 ] = 0;
-                    result = 0; // nothing left
-                }
-            }
-#else
-        #if !defined( OLDGCC )
-            tracer.Trace( "  g_FindFirstDescriptor: %d, g_FindFirst: %p\n", g_FindFirstDescriptor, g_FindFirst );
+            if ( ! is_o_creat_set( original_flags ) )
+                mode = 0; // mode is only defined if O_CREAT or O_TMPFILE are specified, and O_TMPFILE isn't defined for most platforms
 
-            if ( -1 == g_FindFirstDescriptor )
-            {
-                g_FindFirstDescriptor = descriptor;
-                g_FindFirst = fdopendir( descriptor );
-            }
+            int descriptor = open( pfilename, flags, mode );
+#endif //_WIN32
+
+            tracer.Trace( "  result of open: descriptor: %d, mode %#x\n", descriptor, mode );
+            update_result_errno( cpu, descriptor );
+            break;
+        }
+        case SYS_close:
+        {
+            int descriptor = (int) ACCESS_REG( REG_ARG0 );
+            tracer.Trace( "  syscall command SYS_close %d\n", descriptor );
 
-            if ( 0 == g_FindFirst )
+            if ( descriptor >= 0 && descriptor <= 2 )
             {
-                errno = EBADF;
-                g_FindFirstDescriptor = -1;
-                update_result_errno( cpu, -1 );
-                break;
+                // built-in handle stdin, stdout, stderr -- ignore
+                ACCESS_REG( REG_RESULT ) = 0;
             }
-
-            struct dirent * pent = readdir( g_FindFirst );
-            if ( 0 != pent )
+            else
             {
-                tracer.Trace( "  readdir returned '%s'\n", pent->d_name );
-                size_t len = strlen( pent->d_name );
-                if ( ( count < sizeof( struct linux_dirent_syscall ) ) || ( len > ( count - sizeof( struct linux_dirent_syscall ) ) ) )
+                int result = 0;
+#if defined( _WIN32 ) || !defined( OLDGCC )
+                map<REG_TYPE, DirEnumeration>::iterator it = g_dirEnumerations.find( descriptor );
+                if ( it != g_dirEnumerations.end() )
                 {
-                    errno = EINVAL;
-                    result = -1;
+                    close_directory( it->second );
+                    g_dirEnumerations.erase( it );
+                    update_result_errno( cpu, 0 );
+                    break;
                 }
-                else
+#endif
+#ifdef _WIN32
+                if ( timebaseFrequencyDescriptor == descriptor || osreleaseDescriptor == descriptor )
                 {
-                    pcur->d_ino = 100; // fake
-                    tracer.Trace( "  len: %d, sizeof struct %d\n", (int) len, (int) sizeof( struct linux_dirent_syscall ) );
-                    size_t dname_off = offsetof( struct linux_dirent_syscall, d_name );
-                    tracer.Trace( "  d_name offset in the struct: %d\n", (int) dname_off );
-                    pcur->d_reclen = dname_off + len + 1 + 1;
-                    tracer.Trace( "  reclen in the struct: %d\n", (int) pcur->d_reclen );
-                    pcur->d_off = pcur->d_reclen;
-                    strcpy( pcur->d_name, pent->d_name );
-                    pcur->settype( pent->d_type );
-
-                    tracer.Trace( "  wrote '%s' into the entry. d_reclen %d, d_off %d, d_type %#x\n", pcur->d_name, (int) pcur->d_reclen, (int) pcur->d_off, pcur->gettype() );
-                    tracer.TraceBinaryData( (uint8_t *) pcur, pcur->d_reclen, 4 );
-                    result = pcur->d_reclen;
-                    pcur->swap_endianness();
+                    update_result_errno( cpu, 0 );
+                    break;
                 }
-            }
-            else
-            {
-                tracer.Trace( "  readdir returned 0, so there are no more files in the enumeration\n" );
-                result = 0;
-            }
-    #endif
 #endif
-            update_result_errno( cpu, result );
+                result = close( descriptor );
+                update_result_errno( cpu, result );
+            }
             break;
         }
+        case emulator_sys_getdents:
         case SYS_getdents64:
         {
             int result = 0;
@@ -2776,7 +7025,6 @@ void emulator_invoke_svc( CPUClass & cpu )
             uint8_t * pentries = (uint8_t *) cpu.getmem( ACCESS_REG( REG_ARG1 ) );
             REG_TYPE count = ACCESS_REG( REG_ARG2 );
             tracer.Trace( "  pentries: %p, count %u, descriptor %p\n", pentries, (uint32_t) count, descriptor );
-            struct linux_dirent64_syscall * pcur = (struct linux_dirent64_syscall *) pentries;
             memset( pentries, 0, count );
 
             if ( 0 == count ) // glibc does this on amd64. it's a success case
@@ -2785,186 +7033,39 @@ void emulator_invoke_svc( CPUClass & cpu )
                 break;
             }
 
-#ifdef _WIN32
-            if ( ( findFirstDescriptor != descriptor ) || ( 0 == g_acFindFirstPattern[ 0 ] ) )
+#if defined( _WIN32 ) || !defined( OLDGCC )
+            map<REG_TYPE, DirEnumeration>::iterator it = g_dirEnumerations.find( descriptor );
+            if ( it == g_dirEnumerations.end() )
             {
-                tracer.Trace( "  getdents on unexpected descriptor or FindFirst (%p) not open\n", g_hFindFirst );
+#ifdef _WIN32
+                tracer.Trace( "  getdents on unexpected descriptor\n" );
                 errno = EBADF;
                 update_result_errno( cpu, -1 );
                 break;
-            }
-
-            WIN32_FIND_DATAA fd = {0};
-
-            if ( INVALID_HANDLE_VALUE == g_hFindFirst )
-            {
-                tracer.Trace( "findfirstfilea call, pattern '%s'\n", g_acFindFirstPattern );
-                g_hFindFirst = FindFirstFileA( g_acFindFirstPattern, &fd );
-                if ( INVALID_HANDLE_VALUE != g_hFindFirst )
-                {
-                    tracer.Trace( "  successfully opened FindFirst for pattern '%s'\n", g_acFindFirstPattern );
-
-                    size_t len = strlen( fd.cFileName );
-                    if ( ( count < sizeof( struct linux_dirent64_syscall ) ) || ( len > ( count - sizeof( struct linux_dirent64_syscall ) ) ) )
-                    {
-                        errno = EINVAL;
-                        result = -1;
-                    }
-                    else
-                    {
-                        pcur->d_ino = 100; // fake
-                        tracer.Trace( "  len: %zd, sizeof struct %zd\n", len, sizeof( struct linux_dirent64_syscall ) );
-                        size_t dname_off = offsetof( struct linux_dirent64_syscall, d_name );
-                        pcur->d_reclen = (uint16_t) ( dname_off + len + 1 );
-                        pcur->d_off = pcur->d_reclen;
-                        strcpy( pcur->d_name, fd.cFileName );
-
-                        if ( ( FILE_ATTRIBUTE_DIRECTORY & fd.dwFileAttributes ) && ( FILE_ATTRIBUTE_REPARSE_POINT & fd.dwFileAttributes ) && is_dir_symbolic_link( fd.cFileName ) )
-                            pcur->d_type = 10; // DT_LNK
-                        else if ( FILE_ATTRIBUTE_DIRECTORY & fd.dwFileAttributes )
-                            pcur->d_type = 4; // DT_DIR
-                        else
-                            pcur->d_type = 8; // DT_REG
-
-                        tracer.Trace( "  wrote '%s' into the entry. d_reclen %d, d_off %d, d_type %d\n", pcur->d_name, pcur->d_reclen, pcur->d_off, pcur->d_type );
-                        result = pcur->d_reclen;
-                        pcur->swap_endianness();
-                    }
-                }
-                else
-                {
-                    tracer.Trace( "find first failed error %d\n", GetLastError() );
-                    errno = EINVAL;
-                    result = -1;
-                }
-            }
-            else
-            {
-                // find next here
-
-                BOOL found = FindNextFileA( g_hFindFirst, &fd );
-                if ( found )
-                {
-                    size_t len = strlen( fd.cFileName );
-                    if ( ( count < sizeof( struct linux_dirent64_syscall ) ) || ( len > ( count - sizeof( struct linux_dirent64_syscall ) ) ) )
-                    {
-                        errno = ENOENT;
-                        result = -1;
-                    }
-                    else
-                    {
-                        pcur->d_ino = 100; // fake
-                        tracer.Trace( "  len: %zd, sizeof struct %zd\n", len, sizeof( struct linux_dirent64_syscall ) );
-                        size_t dname_off = offsetof( struct linux_dirent64_syscall, d_name );
-                        pcur->d_reclen = (uint16_t) ( dname_off + len + 1 );
-                        pcur->d_off = pcur->d_reclen;
-                        strcpy( pcur->d_name, fd.cFileName );
-
-                        if ( ( FILE_ATTRIBUTE_DIRECTORY & fd.dwFileAttributes ) && ( FILE_ATTRIBUTE_REPARSE_POINT & fd.dwFileAttributes ) && is_dir_symbolic_link( fd.cFileName ) )
-                            pcur->d_type = 10; // DT_LNK
-                        else if ( FILE_ATTRIBUTE_DIRECTORY & fd.dwFileAttributes )
-                            pcur->d_type = 4; // DT_DIR
-                        else
-                            pcur->d_type = 8; // DT_REG
-
-                        tracer.Trace( "  wrote '%s' into the entry. d_reclen %d, d_off %d, d_type %d\n", pcur->d_name, pcur->d_reclen, pcur->d_off, pcur->d_type );
-                        result = pcur->d_reclen;
-                    }
-                }
-                else
+#else
+                DIR * dir = fdopendir( (int) descriptor );
+                if ( 0 == dir )
                 {
-                    tracer.Trace( "  out of next files\n" );
-                    FindClose( g_hFindFirst );
-                    g_hFindFirst = INVALID_HANDLE_VALUE;
-                    g_acFindFirstPattern[ 0 ] = 0;
-                    result = 0; // nothing left
+                    tracer.Trace( "  fdopendir failed, errno %d\n", errno );
+                    errno = EBADF;
+                    update_result_errno( cpu, -1 );
+                    break;
                 }
-            }
-#else
-        #if !defined( OLDGCC )
-            tracer.Trace( "  g_FindFirstDescriptor: %d, g_FindFirst: %p, descriptor: %p\n", g_FindFirstDescriptor, g_FindFirst, descriptor );
 
-            if ( -1 == g_FindFirstDescriptor )
-            {
-                g_FindFirstDescriptor = descriptor;
-                g_FindFirst = fdopendir( descriptor );
-            }
-
-            if ( 0 == g_FindFirst )
-            {
-                tracer.Trace( "  no g_FindFirst\n" );
-                errno = EBADF;
-                g_FindFirstDescriptor = -1;
-                update_result_errno( cpu, -1 );
-                break;
+                it = g_dirEnumerations.insert( make_pair( descriptor, DirEnumeration() ) ).first;
+                it->second.dir = dir;
+#endif
             }
 
-            struct dirent * pent = readdir( g_FindFirst );
-            if ( 0 != pent )
-            {
-                tracer.Trace( "  readdir returned '%s'\n", pent->d_name );
-                size_t len = strlen( pent->d_name );
-                if ( ( count < sizeof( struct linux_dirent64_syscall ) ) || ( len > ( count - sizeof( struct linux_dirent64_syscall ) ) ) )
-                {
-                    errno = EINVAL;
-                    result = -1;
-                }
-                else
-                {
-                    pcur->d_ino = 100; // fake
-                    tracer.Trace( "  len: %d, sizeof struct %d\n", (int) len, (int) sizeof( struct linux_dirent64_syscall ) );
-                    size_t dname_off = offsetof( struct linux_dirent64_syscall, d_name );
-                    tracer.Trace( "  d_name offset in the struct: %d\n", (int) dname_off );
-                    pcur->d_reclen = dname_off + len + 1;
-                    tracer.Trace( "  reclen in the struct: %d\n", (int) pcur->d_reclen );
-                    pcur->d_off = pcur->d_reclen;
-                    strcpy( pcur->d_name, pent->d_name );
-                    pcur->d_type = pent->d_type;
-
-                    tracer.Trace( "  wrote '%s' into the entry. d_reclen %d, d_off %d, d_type %#x\n", pcur->d_name, (int) pcur->d_reclen, (int) pcur->d_off, pcur->d_type );
-                    result = pcur->d_reclen;
-                    pcur->swap_endianness();
-                }
-            }
-            else
-            {
-                tracer.Trace( "  readdir returned 0, so there are no more files in the enumeration\n" );
-                result = 0;
-            }
-        #endif
+            result = fill_directory_entries( it->second, pentries, (size_t) count, SYS_getdents64 == syscall_id );
+            tracer.Trace( "  getdents returning %d bytes, %llu entries so far\n", result, it->second.position );
 #endif
             update_result_errno( cpu, result );
             break;
         }
         case SYS_brk:
         {
-            REG_TYPE original = g_brk_offset;
-            REG_TYPE ask = ACCESS_REG( REG_ARG0 );
-            if ( 0 == ask )
-                ACCESS_REG( REG_RESULT ) = cpu.get_vm_address( g_brk_offset );
-            else
-            {
-                REG_TYPE ask_offset = ask - g_base_address;
-                tracer.Trace( "  ask_offset %llx, g_end_of_data %llx, bottom_of_stack %llx\n", (uint64_t) ask_offset, (uint64_t) g_end_of_data, (uint64_t) g_bottom_of_stack );
-
-                if ( ask_offset >= g_end_of_data && ask_offset < g_bottom_of_stack )
-                {
-                    g_brk_offset = cpu.getoffset( ask );
-                    if ( g_brk_offset > g_highwater_brk )
-                        g_highwater_brk = g_brk_offset;
-#if defined( X64OS ) || defined( X32OS ) // as far as I can tell x32 and x64 are the only platforms that requires the ask to be in the result on return
-                    ACCESS_REG( REG_RESULT ) = ask;
-#endif
-                }
-                else
-                {
-                    tracer.Trace( "  allocation request was too large, failing it by returning current brk\n" );
-                    ACCESS_REG( REG_RESULT ) = cpu.get_vm_address( g_brk_offset );
-                }
-            }
-
-            tracer.Trace( "  SYS_brk. ask %llx, current brk %llx, new brk %llx, result in return register %llx\n",
-                          (uint64_t) ask, (uint64_t) original, (uint64_t) g_brk_offset, (uint64_t) ACCESS_REG( REG_RESULT ) );
+            syscall_brk( cpu, syscall_lock );
             break;
         }
         case SYS_munmap:
@@ -2973,7 +7074,10 @@ void emulator_invoke_svc( CPUClass & cpu )
             REG_TYPE length = ACCESS_REG( REG_ARG1 );
             length = round_up( length, (REG_TYPE) 4096 );
 
-            bool ok = g_mmap.free( address, length );
+#if !defined( OLDGCC ) && !defined( __mc68000__ )
+            release_file_mappings( address, length );
+#endif
+            bool ok = g_process->mmap_arena.free( address, length );
             if ( ok )
                 update_result_errno( cpu, 0 );
             else
@@ -3001,7 +7105,23 @@ void emulator_invoke_svc( CPUClass & cpu )
 
             // flags: MREMAP_MAYMOVE = 1, MREMAP_FIXED = 2, MREMAP_DONTUNMAP = 3. Ignore them all
 
-            SIGNED_REG_TYPE result = (SIGNED_REG_TYPE) g_mmap.resize( address, old_length, new_length, ( 1 == flags ) );
+#if !defined( OLDGCC ) && !defined( __mc68000__ )
+            if ( is_file_mapped( address, old_length ) )
+            {
+                // file mappings can shrink but they can't grow or move since the file would no longer back them
+
+                if ( new_length > old_length )
+                {
+                    tracer.Trace( "  can't grow a file mapping\n" );
+                    errno = ENOMEM;
+                    update_result_errno( cpu, -1 );
+                    break;
+                }
+                release_file_mappings( address + new_length, old_length - new_length );
+            }
+#endif
+
+            SIGNED_REG_TYPE result = (SIGNED_REG_TYPE) g_process->mmap_arena.resize( address, old_length, new_length, ( 1 == flags ) );
             if ( 0 != result )
                 update_result_errno( cpu, result );
             else
@@ -3014,12 +7134,117 @@ void emulator_invoke_svc( CPUClass & cpu )
         }
         case SYS_clone:
         {
+#ifdef ARMOS
+            // arm64 argument order: flags, stack, parent_tid, tls, child_tid
+
+            int64_t result = clone_thread( cpu, ACCESS_REG( REG_ARG0 ), ACCESS_REG( REG_ARG1 ), ACCESS_REG( REG_ARG2 ),
+                                           ACCESS_REG( REG_ARG4 ), ACCESS_REG( REG_ARG3 ) );
+            ACCESS_REG( REG_RESULT ) = (REG_TYPE) result;
+#else
             // can't create a new process or thread with this emulator
 
             errno = EACCES;
             update_result_errno( cpu, -1 );
+#endif
+            break;
+        }
+#ifdef ARMOS
+        case SYS_clone3:
+        {
+            struct linux_clone_args_syscall args;
+            uint64_t size = ACCESS_REG( REG_ARG1 );
+            if ( size < 64 ) // CLONE_ARGS_SIZE_VER0
+            {
+                ACCESS_REG( REG_RESULT ) = (REG_TYPE) -linuxEINVAL;
+                break;
+            }
+
+            memset( &args, 0, sizeof( args ) );
+            memcpy( &args, cpu.getmem( ACCESS_REG( REG_ARG0 ) ), get_min( size, (uint64_t) sizeof( args ) ) );
+            args.swap_endianness();
+
+            uint64_t stack = ( 0 == args.stack ) ? 0 : ( args.stack + args.stack_size ); // clone3 passes the low end
+            int64_t result = clone_thread( cpu, args.flags, stack, args.parent_tid, args.child_tid, args.tls );
+            ACCESS_REG( REG_RESULT ) = (REG_TYPE) result;
+            break;
+        }
+        case SYS_execve:
+        {
+            const char * path = (const char *) cpu.getmem( ACCESS_REG( REG_ARG0 ) );
+            tracer.Trace( "  execve '%s'\n", path );
+            int result = start_exec( cpu, path, ACCESS_REG( REG_ARG1 ), ACCESS_REG( REG_ARG2 ) );
+            update_result_errno( cpu, result );
+            break;
+        }
+#ifndef _WIN32
+        case SYS_wait4:
+        {
+            pid_t pid = (pid_t) ACCESS_REG( REG_ARG0 );
+            int options = (int) ACCESS_REG( REG_ARG2 ) & 3; // WNOHANG and WUNTRACED have the same values on Linux and macOS
+            int status = 0;
+            pid_t result;
+            BLOCKING_CALL( result = waitpid( pid, &status, options ) );
+            tracer.Trace( "  wait4 pid %d options %#x result %d status %#x\n", (int) pid, options, (int) result, status );
+
+            if ( ( result > 0 ) && ( 0 != ACCESS_REG( REG_ARG1 ) ) )
+                * (uint32_t *) cpu.getmem( ACCESS_REG( REG_ARG1 ) ) = swap_endian32( (uint32_t) status );
+            if ( 0 != ACCESS_REG( REG_ARG3 ) )
+                memset( cpu.getmem( ACCESS_REG( REG_ARG3 ) ), 0, sizeof( struct linux_rusage_syscall ) );
+            update_result_errno( cpu, result );
+            break;
+        }
+        case SYS_pipe2:
+        {
+            int flags = (int) ACCESS_REG( REG_ARG1 );
+            int fds[ 2 ];
+            int result = pipe( fds );
+            if ( 0 == result )
+            {
+                for ( int i = 0; i < 2; i++ )
+                {
+                    if ( flags & 0x80000 ) // O_CLOEXEC
+                        fcntl( fds[ i ], F_SETFD, FD_CLOEXEC );
+                    if ( flags & 0x800 ) // O_NONBLOCK
+                        fcntl( fds[ i ], F_SETFL, O_NONBLOCK );
+                }
+
+                uint32_t * pfds = (uint32_t *) cpu.getmem( ACCESS_REG( REG_ARG0 ) );
+                pfds[ 0 ] = swap_endian32( (uint32_t) fds[ 0 ] );
+                pfds[ 1 ] = swap_endian32( (uint32_t) fds[ 1 ] );
+                tracer.Trace( "  pipe2 descriptors %d and %d\n", fds[ 0 ], fds[ 1 ] );
+            }
+            update_result_errno( cpu, result );
+            break;
+        }
+        case SYS_dup:
+        {
+            int result = dup( (int) ACCESS_REG( REG_ARG0 ) );
+            update_result_errno( cpu, result );
+            break;
+        }
+        case SYS_dup3:
+        {
+            int oldfd = (int) ACCESS_REG( REG_ARG0 );
+            int newfd = (int) ACCESS_REG( REG_ARG1 );
+            int result = -1;
+            if ( oldfd == newfd )
+                errno = EINVAL;
+            else
+            {
+                result = dup2( oldfd, newfd );
+                if ( ( -1 != result ) && ( ACCESS_REG( REG_ARG2 ) & 0x80000 ) ) // O_CLOEXEC
+                    fcntl( result, F_SETFD, FD_CLOEXEC );
+            }
+            update_result_errno( cpu, result );
+            break;
+        }
+        case SYS_getppid:
+        {
+            ACCESS_REG( REG_RESULT ) = getppid();
             break;
         }
+#endif
+#endif
         case emulator_sys_rand: // rand64. returns an unsigned random number in a0
         {
             tracer.Trace( "  syscall command generate random number\n" );
@@ -3049,8 +7274,7 @@ void emulator_invoke_svc( CPUClass & cpu )
         case SYS_mmap:
         {
             // The gnu c runtime is ok with this failing -- it just allocates memory instead probably assuming it's an embedded system.
-            // Same for the gnu runtime with Rust.
-            // But golang actually needs this to succeed and return the requested address and this code doesn't support that.
+            // Same for the gnu runtime with Rust. golang needs MAP_FIXED and address hints to work.
 
             REG_TYPE addr = ACCESS_REG( REG_ARG0 );
             size_t length = ACCESS_REG( REG_ARG1 );
@@ -3067,33 +7291,87 @@ void emulator_invoke_svc( CPUClass & cpu )
                 length = round_up( length, (size_t) 4096 );
             }
 
-            if ( 0 == addr )
+            // 1 == MAP_SHARED, 2 == MAP_PRIVATE, 3 == MAP_SHARED_VALIDATE, 0x20 == MAP_ANONYMOUS, 0x100 == MAP_FIXED,
+            // 0x100000 == MAP_FIXED_NOREPLACE. shared anonymous memory is the same as private where armos can't fork.
+
+            bool shared = ( 2 != ( flags & 3 ) );
+            bool anonymous = ( 0 != ( flags & 0x20 ) );
+            bool fixed = ( 0 != ( flags & 0x100 ) );
+            bool noreplace = ( 0 != ( flags & 0x100000 ) );
+            int error = ENOMEM;
+            REG_TYPE result = 0;
+
+            if ( ( 0 == ( flags & 3 ) ) || ( 0 == length ) || ( 0 != ( offset & 0xfff ) ) || ( ( fixed || noreplace ) && ( 0 != ( addr & 0xfff ) ) ) )
+                error = EINVAL;
+#if defined( OLDGCC ) || defined( __mc68000__ )
+            else if ( !anonymous )
+                tracer.Trace( "  error: file-backed mmap isn't supported\n" );
+#endif
+            else if ( !anonymous && ( fd < 0 ) )
+                error = EBADF;
+            else if ( noreplace && !g_process->mmap_arena.is_free( addr, length ) )
+                error = EEXIST;
+            else if ( fixed || noreplace )
             {
-                if ( 0 == ( length & 0xfff ) )
-                {
-                    // 2 == MAP_PRIVATE, 0x20 == MAP_ANONYMOUS, 0x100 = MAP_FIXED
+#if !defined( OLDGCC ) && !defined( __mc68000__ )
+                release_file_mappings( addr, length );
+#endif
+                result = g_process->mmap_arena.allocate_fixed( addr, length );
+            }
+            else
+            {
+                if ( ( 0 != addr ) && ( 0 == ( addr & 0xfff ) ) && g_process->mmap_arena.is_free( addr, length ) ) // honor hints when possible
+                    result = g_process->mmap_arena.allocate_fixed( addr, length );
+                if ( 0 == result )
+                    result = g_process->mmap_arena.allocate( length );
+            }
 
-                    if ( ( 0 == ( 0x100 & flags ) ) && ( 0x22 == ( 0x22 & flags ) ) )
-                    {
-                        SIGNED_REG_TYPE result = (SIGNED_REG_TYPE) g_mmap.allocate( length );
-                        if ( 0 != result )
-                        {
-                            update_result_errno( cpu, result );
-                            break;
-                        }
-                    }
-                    else
-                        tracer.Trace( "  error: mmap flags %#x aren't supported\n", flags );
-                }
-                else
-                    tracer.Trace( "  error mmap length isn't 4k-page-aligned\n" );
+#if !defined( OLDGCC ) && !defined( __mc68000__ )
+            if ( ( 0 != result ) && !anonymous && !map_file_into_memory( result, length, fd, offset, shared, ( 0 != ( prot & 2 ) ) ) )
+            {
+                error = errno;
+                g_process->mmap_arena.free( result, length );
+                result = 0;
+            }
+#endif
+#if defined( ARMOS ) && !defined( _WIN32 )
+            if ( ( 0 != result ) && anonymous && shared && !map_shared_memory( result, length ) )
+            {
+                error = errno;
+                g_process->mmap_arena.free( result, length );
+                result = 0;
+            }
+#endif
+
+            if ( 0 != result )
+            {
+                update_result_errno( cpu, result );
+                break;
+            }
+
+            tracer.Trace( "  mmap failed, error %d\n", error );
+            errno = error;
+            update_result_errno( cpu, -1 );
+            break;
+        }
+        case SYS_msync:
+        {
+            REG_TYPE address = ACCESS_REG( REG_ARG0 );
+            REG_TYPE length = round_up( ACCESS_REG( REG_ARG1 ), (REG_TYPE) 4096 );
+            int flags = (int) ACCESS_REG( REG_ARG2 ); // 1 == MS_ASYNC, 2 == MS_INVALIDATE, 4 == MS_SYNC
+            tracer.Trace( "  msync address %llx, length %llu, flags %#x\n", address, length, flags );
+
+            if ( 0 != ( address & 0xfff ) )
+            {
+                errno = EINVAL;
+                update_result_errno( cpu, -1 );
+                break;
             }
-            else
-                tracer.Trace( "  mmap allocation at specific address isn't supported\n" );
 
-            tracer.Trace( "  mmap failed\n" );
-            errno = ENOMEM;
-            update_result_errno( cpu, -1 );
+#if !defined( OLDGCC ) && !defined( __mc68000__ )
+            sync_file_mappings( address, length, ( 0 != ( flags & 4 ) ) );
+#endif
+            update_result_errno( cpu, 0 );
             break;
         }
 #if !defined(OLDGCC) // the syscalls below aren't invoked from the old g++ compiler and runtime
@@ -3141,19 +7419,7 @@ void emulator_invoke_svc( CPUClass & cpu )
 
             DWORD attr = GetFileAttributesA( acPath );
             if ( opendir && ( INVALID_FILE_ATTRIBUTES != attr ) && ( attr & FILE_ATTRIBUTE_DIRECTORY ) )
-            {
-                if ( INVALID_HANDLE_VALUE != g_hFindFirst )
-                {
-                    FindClose( g_hFindFirst );
-                    g_hFindFirst = INVALID_HANDLE_VALUE;
-                }
-                strcpy( g_acFindFirstPattern, acPath );
-                size_t len = strlen( g_acFindFirstPattern );
-                if ( '\\' != g_acFindFirstPattern[ len - 1 ] )
-                    strcat( g_acFindFirstPattern, "\\" );
-                strcat( g_acFindFirstPattern, "*.*" );
-                descriptor = findFirstDescriptor;
-            }
+                descriptor = open_directory( g_dirEnumerations, acPath );
             else
             {
 #ifdef M68
@@ -3203,7 +7469,7 @@ void emulator_invoke_svc( CPUClass & cpu )
 #ifdef _WIN32
             // ignore the folder argument on Windows
             struct stat_linux_syscall local_stat = {0};
-            result = fill_pstat_windows( descriptor, & local_stat, path );
+            result = cached_pstat_windows( descriptor, & local_stat, path );
             if ( 0 == result )
             {
                 #ifdef X64OS
@@ -3265,9 +7531,9 @@ void emulator_invoke_svc( CPUClass & cpu )
                 if ( 0 == path[ 0 ] )
                     result = fstat( descriptor, & local_stat );
                 else
-                    result = fstatat( descriptor, path, & local_stat, flags );
+                    result = cached_fstatat( descriptor, path, & local_stat, flags );
             #else //__APPLE__
-                result = fstatat( descriptor, path, & local_stat, flags );
+                result = cached_fstatat( descriptor, path, & local_stat, flags );
             #endif //__APPLE__
 
             if ( 0 == result )
@@ -3587,6 +7853,9 @@ void emulator_invoke_svc( CPUClass & cpu )
         }
         case SYS_futex:
         {
+#ifdef ARMOS
+            syscall_futex( cpu, syscall_lock );
+#else
             if ( !cpu.is_address_valid( ACCESS_REG( REG_ARG0 ) ) ) // sometimes it's malformed on arm64. not sure why yet.
             {
                 tracer.Trace( "futex pointer in reg 0 is malformed\n" );
@@ -3611,63 +7880,98 @@ void emulator_invoke_svc( CPUClass & cpu )
                 ACCESS_REG( REG_RESULT ) = 0;
             else
                 ACCESS_REG( REG_RESULT ) = (REG_TYPE) -1; // fail this until/unless there is a real-world use
+#endif //ARMOS
             break;
         }
 #if !defined( M68 ) && !defined( __mc68000__ )// lots of 64/32 interop issues with this
+        case SYS_readv:
         case SYS_writev:
+        case SYS_preadv:
+        case SYS_pwritev:
         {
             int descriptor = (int) ACCESS_REG( REG_ARG0 );
-            const struct iovec * pvec = (const struct iovec *) cpu.getmem( ACCESS_REG( REG_ARG1 ) );
-            if ( 1 == descriptor || 2 == descriptor )
-#ifdef M68
-                tracer.Trace( "  desc %d: writing '%.*s'\n", descriptor, pvec->iov_len, cpu.getmem( 0xffffffff & (REG_TYPE) pvec->iov_base ) );
-#else
-                tracer.Trace( "  desc %d: writing '%.*s'\n", descriptor, pvec->iov_len, cpu.getmem( (REG_TYPE) (uint64_t) pvec->iov_base ) );
-#endif
+            REG_TYPE count = ACCESS_REG( REG_ARG2 );
+            bool writing = ( SYS_writev == syscall_id || SYS_pwritev == syscall_id );
+            bool positional = ( SYS_preadv == syscall_id || SYS_pwritev == syscall_id );
+            int64_t offset = -1;
+            if ( positional )
+                offset = ( 8 == sizeof( REG_TYPE ) ) ? (int64_t) ACCESS_REG( REG_ARG3 ) : (int64_t) ( (uint64_t) ACCESS_REG( REG_ARG3 ) | ( (uint64_t) ACCESS_REG( REG_ARG4 ) << 32 ) );
+            tracer.Trace( "  syscall command %s. descriptor %d, %llu iovecs, offset %lld\n", lookup_syscall( (uint32_t) syscall_id ), descriptor, (uint64_t) count, offset );
+
+            if ( ( count > 1024 ) || ( positional && ( offset < 0 ) ) ) // 1024 is UIO_MAXIOV
+            {
+                errno = EINVAL;
+                update_result_errno( cpu, (REG_TYPE) -1 );
+                break;
+            }
 
-            REG_TYPE result = 0;
+            vector<iovec> vecs;
+            size_t total = translate_iovecs( cpu, ACCESS_REG( REG_ARG1 ), count, vecs );
+            int64_t result = 0;
 
-#ifdef _WIN32
-            if ( descriptor <= 2 )
-                result = (REG_TYPE) WinWrite( descriptor, cpu.getmem( (REG_TYPE) (uint64_t) pvec->iov_base ), (unsigned) (uint64_t) pvec->iov_len );
+            if ( writing )
+            {
+                if ( 1 == descriptor || 2 == descriptor )
+                    for ( size_t i = 0; i < vecs.size(); i++ )
+                        tracer.Trace( "  desc %d: writing '%.*s'\n", descriptor, (int) vecs[ i ].iov_len, (const char *) vecs[ i ].iov_base );
+
+                result = host_writev( descriptor, vecs, total, offset );
+            }
+            else if ( 0 == descriptor && !positional )
+            {
+                // stdin goes through the console layer for line-end handling, so only the first non-empty element is filled
+
+                for ( size_t i = 0; i < vecs.size(); i++ )
+                {
+                    if ( 0 != vecs[ i ].iov_len )
+                    {
+                        int r;
+                        BLOCKING_CALL( r = read_stdin( vecs[ i ].iov_base, (uint32_t) vecs[ i ].iov_len ) );
+                        result = r;
+                        break;
+                    }
+                }
+            }
             else
-                result = (REG_TYPE) write( descriptor, cpu.getmem( (REG_TYPE) (uint64_t) pvec->iov_base ), (unsigned) (uint64_t) pvec->iov_len );
-#else //_WIN32
-            struct iovec vec_local;
-            vec_local.iov_base = cpu.getmem( (uint64_t) pvec->iov_base );
-            vec_local.iov_len = pvec->iov_len;
-            tracer.Trace( "  write length: %u to descriptor %d at addr %p\n", pvec->iov_len, descriptor, vec_local.iov_base );
-            result = writev( descriptor, &vec_local, ACCESS_REG( REG_ARG2 ) );
-#endif //_WIN32
-            update_result_errno( cpu, result );
+                result = host_readv( descriptor, vecs, total, offset );
+
+            tracer.Trace( "  %s %lld of %zu bytes\n", writing ? "wrote" : "read", result, total );
+            update_result_errno( cpu, (REG_TYPE) result );
             break;
         }
-#endif //M68
-        case SYS_clock_gettime:
+        case SYS_pread64:
+        case SYS_pwrite64:
         {
-            clockid_t cid = (clockid_t) ACCESS_REG( REG_ARG0 );
-            #ifdef __APPLE__ // Linux vs MacOS
-                if ( 1 == cid )
-                    cid = CLOCK_REALTIME;
-                else if ( 5 == cid )
-                    cid = CLOCK_REALTIME;
-            #endif
+            int descriptor = (int) ACCESS_REG( REG_ARG0 );
+            size_t count = (size_t) ACCESS_REG( REG_ARG2 );
+            void * buffer = ( 0 == count ) ? 0 : cpu.getmem( ACCESS_REG( REG_ARG1 ) );
+            int64_t offset = (int64_t) ACCESS_REG( REG_ARG3 );
+            tracer.Trace( "  syscall command %s. descriptor %d, count %zu, offset %lld\n", lookup_syscall( (uint32_t) syscall_id ), descriptor, count, offset );
 
-#ifdef _WIN32
-            struct timespec_syscall local_ts = { 0 };
-            int result = msc_clock_gettime( cid, & local_ts );
-#else
-            struct timespec local_ts; // this varies in size from platform to platform
-            int result = clock_gettime( cid, & local_ts );
-#endif
+            if ( offset < 0 )
+            {
+                errno = EINVAL;
+                update_result_errno( cpu, (REG_TYPE) -1 );
+                break;
+            }
 
-            struct timespec_syscall * ptimespec = (struct timespec_syscall *) cpu.getmem( ACCESS_REG( REG_ARG1 ) );
-            ptimespec->tv_sec = local_ts.tv_sec;
-            ptimespec->tv_nsec = local_ts.tv_nsec;
-            ptimespec->swap_endianness();
+            int64_t result;
+            if ( SYS_pwrite64 == syscall_id )
+                result = host_pwrite( descriptor, buffer, count, (uint64_t) offset );
+            else
+            {
+                result = host_pread( descriptor, buffer, count, (uint64_t) offset );
+                if ( result > 0 )
+                    tracer.TraceBinaryData( (uint8_t *) buffer, (int) get_min( (int64_t) 0x100, result ), 4 );
+            }
 
-            tracer.Trace( "  tv_sec %llx, tv_nsec %llx\n", ptimespec->tv_sec, (uint64_t) ptimespec->tv_nsec );
-            update_result_errno( cpu, result );
+            update_result_errno( cpu, (REG_TYPE) result );
+            break;
+        }
+#endif //M68
+        case SYS_clock_gettime:
+        {
+            syscall_clock_gettime( cpu, syscall_lock );
             break;
         }
         case SYS_fsync:
@@ -3795,7 +8099,11 @@ void emulator_invoke_svc( CPUClass & cpu )
         }
         case SYS_gettid:
         {
+#ifdef ARMOS
+            ACCESS_REG( REG_RESULT ) = g_tid;
+#else
             ACCESS_REG( REG_RESULT ) = 1;
+#endif
             break;
         }
         case emulator_sys_rename:
@@ -3877,7 +8185,7 @@ void emulator_invoke_svc( CPUClass & cpu )
             char ac[ EMULATOR_MAX_PATH ];
             strcpy( ac, pathname );
             slash_to_backslash( ac );
-            result = fill_pstat_windows( ( dirfd > 0 ) ? dirfd : -1, & local_stat, ac );
+            result = cached_pstat_windows( ( dirfd > 0 ) ? dirfd : -1, & local_stat, ac );
             if ( 0 == result )
             {
                 tracer.Trace( "  result in local stat_linux_syscall, offset of mode %u, mode: %#x\n", offsetof( struct stat_linux_syscall, st_mode ), local_stat.st_mode );
@@ -4011,10 +8319,10 @@ void emulator_invoke_svc( CPUClass & cpu )
             if ( 0 == pathname[ 0 ] )
                 result = fstat( dirfd, & local_stat );
             else
-                result = fstatat( dirfd, pathname, & local_stat, flags );
+                result = cached_fstatat( dirfd, pathname, & local_stat, flags );
 #else
             tracer.Trace( "  statx calling fstatat with dirfd %d, flags %#x\n", dirfd, flags );
-            result = fstatat( dirfd, pathname, & local_stat, flags );
+            result = cached_fstatat( dirfd, pathname, & local_stat, flags );
 #endif // __APPLE__
             if ( 0 == result )
             {
@@ -4165,7 +8473,13 @@ void emulator_invoke_svc( CPUClass & cpu )
         }
         case SYS_riscv_flush_icache :
         {
-            assert( false ); // no arm64 equivalent
+#ifdef ARMOS
+            // arm64 apps use ic ivau instead, but honor the request if one shows up
+            uint64_t start = ACCESS_REG( REG_ARG0 );
+            uint64_t end = ACCESS_REG( REG_ARG1 );
+            if ( end > start )
+                cpu.invalidate_code( start, end - start );
+#endif
             ACCESS_REG( REG_RESULT ) = 0;
             break;
         }
@@ -4194,17 +8508,235 @@ void emulator_invoke_svc( CPUClass & cpu )
         {
             struct pollfd_syscall * pfds = (struct pollfd_syscall *) cpu.getmem( ACCESS_REG( REG_ARG0 ) );
             int nfds = (int) ACCESS_REG( REG_ARG1 );
-            struct timespec_syscall * pts = (struct timespec_syscall *) cpu.getmem( ACCESS_REG( REG_ARG2 ) );
+            struct timespec_syscall * pts = (struct timespec_syscall *) ( ( 0 == ACCESS_REG( REG_ARG2 ) ) ? 0 : cpu.getmem( ACCESS_REG( REG_ARG2 ) ) );
             int * psigmask = (int *) ( ( 0 == ACCESS_REG( REG_ARG3 ) ) ? 0 : cpu.getmem( ACCESS_REG( REG_ARG3 ) ) );
 
             tracer.Trace( "  count of file descriptors: %d\n", nfds );
             for ( int i = 0; i < nfds; i++ )
                 tracer.Trace( "    fd %d: %d\n", i, pfds[ i ].fd );
 
+#ifdef ARMOS_HOST_SOCKETS
+            // pollfd matches the host's. apps don't get signals, so the mask doesn't matter
+
+            struct timespec timeout;
+            if ( 0 != pts )
+            {
+                timeout.tv_sec = (time_t) swap_endian64( pts->tv_sec );
+                timeout.tv_nsec = (long) swap_endian64( pts->tv_nsec );
+            }
+            int result;
+            BLOCKING_CALL( result = ppoll( (struct pollfd *) pfds, (nfds_t) nfds, ( 0 != pts ) ? &timeout : 0, 0 ) );
+            update_result_errno( cpu, result );
+#else
             // lie and say no I/O is ready
             ACCESS_REG( REG_RESULT ) = 0;
+#endif
+            break;
+        }
+#ifdef ARMOS_HOST_SOCKETS
+        // sockets are host descriptors. addresses, options, and data are used in place in guest memory; only
+        // structures with pointers are translated
+
+        case SYS_socket:
+        case SYS_socketpair:
+        {
+            int domain = (int) ACCESS_REG( REG_ARG0 );
+            int type = (int) ACCESS_REG( REG_ARG1 );
+            int protocol = (int) ACCESS_REG( REG_ARG2 );
+            ignore_sigpipe();
+            int result = ( SYS_socket == syscall_id ) ? socket( domain, type, protocol ) :
+                                                         socketpair( domain, type, protocol, (int *) cpu.getmem( ACCESS_REG( REG_ARG3 ) ) );
+            tracer.Trace( "  %s domain %d type %#x protocol %d result %d\n", lookup_syscall( (uint32_t) syscall_id ), domain, type, protocol, result );
+            update_result_errno( cpu, result );
+            break;
+        }
+        case SYS_bind:
+        case SYS_connect:
+        {
+            int fd = (int) ACCESS_REG( REG_ARG0 );
+            const struct sockaddr * addr = (const struct sockaddr *) guest_pointer( cpu, ACCESS_REG( REG_ARG1 ) );
+            socklen_t len = (socklen_t) ACCESS_REG( REG_ARG2 );
+            int result;
+            if ( SYS_bind == syscall_id )
+                result = bind( fd, addr, len );
+            else
+                BLOCKING_CALL( result = connect( fd, addr, len ) );
+            update_result_errno( cpu, result );
+            break;
+        }
+        case SYS_listen:
+        {
+            int result = listen( (int) ACCESS_REG( REG_ARG0 ), (int) ACCESS_REG( REG_ARG1 ) );
+            update_result_errno( cpu, result );
+            break;
+        }
+        case SYS_accept:
+        case SYS_accept4:
+        {
+            int fd = (int) ACCESS_REG( REG_ARG0 );
+            struct sockaddr * addr = (struct sockaddr *) guest_pointer( cpu, ACCESS_REG( REG_ARG1 ) );
+            socklen_t * plen = (socklen_t *) guest_pointer( cpu, ACCESS_REG( REG_ARG2 ) );
+            int flags = ( SYS_accept4 == syscall_id ) ? (int) ACCESS_REG( REG_ARG3 ) : 0;
+            int result;
+            BLOCKING_CALL( result = accept4( fd, addr, plen, flags ) );
+            tracer.Trace( "  accept on fd %d flags %#x result %d\n", fd, flags, result );
+            update_result_errno( cpu, result );
+            break;
+        }
+        case SYS_getsockname:
+        case SYS_getpeername:
+        {
+            int fd = (int) ACCESS_REG( REG_ARG0 );
+            struct sockaddr * addr = (struct sockaddr *) guest_pointer( cpu, ACCESS_REG( REG_ARG1 ) );
+            socklen_t * plen = (socklen_t *) guest_pointer( cpu, ACCESS_REG( REG_ARG2 ) );
+            int result = ( SYS_getsockname == syscall_id ) ? getsockname( fd, addr, plen ) : getpeername( fd, addr, plen );
+            update_result_errno( cpu, result );
+            break;
+        }
+        case SYS_sendto:
+        case SYS_recvfrom:
+        {
+            int fd = (int) ACCESS_REG( REG_ARG0 );
+            void * buffer = guest_pointer( cpu, ACCESS_REG( REG_ARG1 ) );
+            size_t len = (size_t) ACCESS_REG( REG_ARG2 );
+            int flags = (int) ACCESS_REG( REG_ARG3 );
+            struct sockaddr * addr = (struct sockaddr *) guest_pointer( cpu, ACCESS_REG( REG_ARG4 ) );
+            ssize_t result;
+            if ( SYS_sendto == syscall_id )
+                BLOCKING_CALL( result = sendto( fd, buffer, len, flags, addr, (socklen_t) ACCESS_REG( REG_ARG5 ) ) )
+            else
+                BLOCKING_CALL( result = recvfrom( fd, buffer, len, flags, addr, (socklen_t *) guest_pointer( cpu, ACCESS_REG( REG_ARG5 ) ) ) );
+            tracer.Trace( "  %s fd %d len %zu flags %#x result %zd\n", lookup_syscall( (uint32_t) syscall_id ), fd, len, flags, result );
+            update_result_errno( cpu, result );
+            break;
+        }
+        case SYS_sendmsg:
+        case SYS_recvmsg:
+        {
+            int64_t result = socket_message( cpu, (int) ACCESS_REG( REG_ARG0 ), ACCESS_REG( REG_ARG1 ), (int) ACCESS_REG( REG_ARG2 ),
+                                             SYS_sendmsg == syscall_id, syscall_lock );
+            update_result_errno( cpu, result );
+            break;
+        }
+        case SYS_setsockopt:
+        case SYS_getsockopt:
+        {
+            int fd = (int) ACCESS_REG( REG_ARG0 );
+            int level = (int) ACCESS_REG( REG_ARG1 );
+            int name = (int) ACCESS_REG( REG_ARG2 );
+            void * value = guest_pointer( cpu, ACCESS_REG( REG_ARG3 ) );
+            int result = ( SYS_setsockopt == syscall_id ) ? setsockopt( fd, level, name, value, (socklen_t) ACCESS_REG( REG_ARG4 ) ) :
+                                                            getsockopt( fd, level, name, value, (socklen_t *) guest_pointer( cpu, ACCESS_REG( REG_ARG4 ) ) );
+            tracer.Trace( "  %s fd %d level %d name %d result %d\n", lookup_syscall( (uint32_t) syscall_id ), fd, level, name, result );
+            update_result_errno( cpu, result );
+            break;
+        }
+        case SYS_shutdown:
+        {
+            int result = shutdown( (int) ACCESS_REG( REG_ARG0 ), (int) ACCESS_REG( REG_ARG1 ) );
+            update_result_errno( cpu, result );
+            break;
+        }
+        case SYS_epoll_create1:
+        {
+            int result = epoll_create1( (int) ACCESS_REG( REG_ARG0 ) );
+            update_result_errno( cpu, result );
+            break;
+        }
+        case SYS_epoll_ctl:
+        {
+            struct epoll_event e;
+            memset( &e, 0, sizeof( e ) );
+            const guest_epoll_event * pg = (const guest_epoll_event *) guest_pointer( cpu, ACCESS_REG( REG_ARG3 ) );
+            if ( 0 != pg )
+            {
+                e.events = pg->events;
+                e.data.u64 = pg->data;
+            }
+            int result = epoll_ctl( (int) ACCESS_REG( REG_ARG0 ), (int) ACCESS_REG( REG_ARG1 ), (int) ACCESS_REG( REG_ARG2 ), ( 0 != pg ) ? &e : 0 );
+            update_result_errno( cpu, result );
+            break;
+        }
+        case SYS_epoll_pwait:
+        {
+            // like ppoll, the signal mask is ignored
+
+            int maxevents = (int) ACCESS_REG( REG_ARG2 );
+            if ( maxevents <= 0 )
+            {
+                errno = EINVAL;
+                update_result_errno( cpu, -1 );
+                break;
+            }
+
+            vector<struct epoll_event> events( get_min( maxevents, 1024 ) ); // fewer than asked for is fine; the rest wait for the next call
+            int result;
+            BLOCKING_CALL( result = epoll_wait( (int) ACCESS_REG( REG_ARG0 ), events.data(), (int) events.size(), (int) ACCESS_REG( REG_ARG3 ) ) );
+            guest_epoll_event * pg = (guest_epoll_event *) cpu.getmem( ACCESS_REG( REG_ARG1 ) );
+            for ( int i = 0; i < result; i++ )
+            {
+                pg[ i ].events = events[ i ].events;
+                pg[ i ].data = events[ i ].data.u64;
+            }
+            update_result_errno( cpu, result );
+            break;
+        }
+        case SYS_sendfile:
+        {
+            ssize_t result;
+            BLOCKING_CALL( result = sendfile( (int) ACCESS_REG( REG_ARG0 ), (int) ACCESS_REG( REG_ARG1 ), (off_t *) guest_pointer( cpu, ACCESS_REG( REG_ARG2 ) ),
+                                              (size_t) ACCESS_REG( REG_ARG3 ) ) );
+            tracer.Trace( "  sendfile from fd %d to fd %d: %zd bytes\n", (int) ACCESS_REG( REG_ARG1 ), (int) ACCESS_REG( REG_ARG0 ), result );
+            update_result_errno( cpu, result );
+            break;
+        }
+        case SYS_copy_file_range:
+        {
+            ssize_t result;
+            BLOCKING_CALL( result = copy_file_range( (int) ACCESS_REG( REG_ARG0 ), (loff_t *) guest_pointer( cpu, ACCESS_REG( REG_ARG1 ) ),
+                                                     (int) ACCESS_REG( REG_ARG2 ), (loff_t *) guest_pointer( cpu, ACCESS_REG( REG_ARG3 ) ),
+                                                     (size_t) ACCESS_REG( REG_ARG4 ), (unsigned int) ACCESS_REG( REG_ARG5 ) ) );
+            tracer.Trace( "  copy_file_range from fd %d to fd %d: %zd bytes\n", (int) ACCESS_REG( REG_ARG0 ), (int) ACCESS_REG( REG_ARG2 ), result );
+            update_result_errno( cpu, result );
+            break;
+        }
+        case SYS_splice:
+        {
+            ssize_t result;
+            BLOCKING_CALL( result = splice( (int) ACCESS_REG( REG_ARG0 ), (loff_t *) guest_pointer( cpu, ACCESS_REG( REG_ARG1 ) ),
+                                            (int) ACCESS_REG( REG_ARG2 ), (loff_t *) guest_pointer( cpu, ACCESS_REG( REG_ARG3 ) ),
+                                            (size_t) ACCESS_REG( REG_ARG4 ), (unsigned int) ACCESS_REG( REG_ARG5 ) ) );
+            update_result_errno( cpu, result );
+            break;
+        }
+#elif defined( ARMOS )
+        case SYS_socket:
+        case SYS_socketpair:
+        case SYS_bind:
+        case SYS_connect:
+        case SYS_listen:
+        case SYS_accept:
+        case SYS_accept4:
+        case SYS_getsockname:
+        case SYS_getpeername:
+        case SYS_sendto:
+        case SYS_recvfrom:
+        case SYS_sendmsg:
+        case SYS_recvmsg:
+        case SYS_setsockopt:
+        case SYS_getsockopt:
+        case SYS_shutdown:
+        case SYS_epoll_create1:
+        case SYS_epoll_ctl:
+        case SYS_epoll_pwait:
+        case SYS_sendfile:
+        case SYS_copy_file_range:
+        case SYS_splice:
+        {
+            ACCESS_REG( REG_RESULT ) = (REG_TYPE) -linuxENOSYS; // this host's socket structures differ from Arm64 Linux's
             break;
         }
+#endif //ARMOS_HOST_SOCKETS
         case emulator_sys_readlink:
         {
             // shift the arguments over to make room for dirfd then fall through to readlinkat
@@ -4390,7 +8922,12 @@ void emulator_invoke_svc( CPUClass & cpu )
         }
         case SYS_set_tid_address:
         {
+#ifdef ARMOS
+            g_clear_child_tid = ACCESS_REG( REG_ARG0 );
+            ACCESS_REG( REG_RESULT ) = g_tid;
+#else
             ACCESS_REG( REG_RESULT ) = 1;
+#endif
             break;
         }
         case SYS_madvise:
@@ -4407,11 +8944,17 @@ void emulator_invoke_svc( CPUClass & cpu )
 #endif // !defined(OLDGCC)
         case SYS_faccessat:
         {
+            int dirfd = (int) ACCESS_REG( REG_ARG0 );
             const char * pathname = (const char *) cpu.getmem( ACCESS_REG( REG_ARG1 ) );
-            tracer.Trace( "  faccessat failing for path %s\n", pathname );
+            int mode = (int) ACCESS_REG( REG_ARG2 ); // F_OK, R_OK, W_OK, and X_OK match on all the hosts
+            tracer.Trace( "  faccessat dirfd %d, path %s, mode %#x\n", dirfd, pathname, mode );
 
-            errno = 2; // not found
-            update_result_errno( cpu, -1 );
+#ifdef __APPLE__
+            if ( -100 == dirfd ) // current directory
+                dirfd = AT_FDCWD;
+#endif
+            int result = cached_faccessat( dirfd, pathname, mode );
+            update_result_errno( cpu, result );
             break;
         }
         case SYS_getuid:
@@ -4439,6 +8982,9 @@ void emulator_invoke_svc( CPUClass & cpu )
             //ACCESS_REG( REG_RESULT ] = -1;
         }
     }
+
+    if ( g_syscall_timing )
+        record_syscall( cpu, syscall_id, tSyscallStart );
 } //emulator_invoke_svc
 
 #ifdef SPARCOS
@@ -4525,10 +9071,10 @@ void emulator_invoke_68k_trap15( m68000 & cpu )
     {
         case 0: // exit
         {
-            g_terminate = true;
+            g_process->terminate = true;
             cpu.end_emulation();
-            g_exit_code = (int) ACCESS_REG( 0 );
-            tracer.Trace( "  emulated app exit code %d\n", g_exit_code );
+            g_process->exit_code = (int) ACCESS_REG( 0 );
+            tracer.Trace( "  emulated app exit code %d\n", g_process->exit_code );
             break;
         }
         case 1: // putch
@@ -4579,6 +9125,15 @@ static const char * sparc_register_names[ 32 ] =
 
 void emulator_hard_termination( CPUClass & cpu, const char *pcerr, uint64_t error_value )
 {
+#ifdef ARMOS
+    if ( g_process->embedded )
+    {
+        char acFault[ 200 ];
+        snprintf( acFault, sizeof( acFault ), "fatal error: %s %llx at pc %llx", pcerr, (unsigned long long) error_value, (unsigned long long) cpu.pc );
+        embedded_fault( acFault );
+    }
+#endif
+
     g_consoleConfig.RestoreConsole( false );
 
     printf( "hard termination!!!\n" );
@@ -4606,8 +9161,8 @@ void emulator_hard_termination( CPUClass & cpu, const char *pcerr, uint64_t erro
         printf( "pc: %llx\n", (uint64_t) REG_PC );
     }
 
-    tracer.Trace( "address space %llx to %llx\n", (uint64_t) g_base_address, (uint64_t) g_base_address + memory.size() );
-    printf( "address space %llx to %llx\n", (uint64_t) g_base_address, (uint64_t) g_base_address + memory.size() );
+    tracer.Trace( "address space %llx to %llx\n", (uint64_t) g_process->base_address, (uint64_t) g_process->base_address + g_process->vm_memory.size() );
+    printf( "address space %llx to %llx\n", (uint64_t) g_process->base_address, (uint64_t) g_process->base_address + g_process->vm_memory.size() );
 
     tracer.Trace( "  " );
     printf( "  " );
@@ -4719,6 +9274,8 @@ void emulator_hard_termination( CPUClass & cpu, const char *pcerr, uint64_t erro
     cpu.trace_instructions( true );
 #ifdef ARMOS
     cpu.trace_vregs();
+    if ( cpu.write_trace_ring( RING_NAME ) )
+        printf( "the trace ring was written to %s; render it with -d:%s\n", RING_NAME, RING_NAME );
 #elif defined( SPARCOS )
     cpu.trace_fregs();
 #endif
@@ -4733,6 +9290,80 @@ void emulator_hard_termination( CPUClass & cpu, const char *pcerr, uint64_t erro
     exit( 1 );
 } //emulator_hard_termination
 
+#ifdef ARMOS
+
+// release builds don't check guest addresses on each load and store. guest memory is surrounded by guard pages
+// instead, and faults there are reported with the same diagnostic the debug build's checks produce. uncommitted
+// memory between the brk heap and the stack and above the mmap arena's high-water mark faults the same way.
+
+static thread_local CPUClass * g_fault_cpu = 0; // the cpu running on this thread when a guard page fault happens
+
+static void report_guard_fault( void * p )
+{
+    CPUClass & cpu = * g_fault_cpu;
+    uint64_t address = cpu.host_to_vm_address( p );
+    if ( (uint8_t *) p < g_process->vm_memory.data() )
+        emulator_hard_termination( cpu, "memory reference prior to address space:", address );
+    if ( (uint8_t *) p < ( g_process->vm_memory.data() + g_process->vm_memory.size() ) )
+        emulator_hard_termination( cpu, "memory reference to unallocated memory:", address );
+    emulator_hard_termination( cpu, "memory reference beyond address space:", address );
+} //report_guard_fault
+
+#ifdef _WIN32
+
+static LONG WINAPI guard_fault_handler( PEXCEPTION_POINTERS pinfo )
+{
+    PEXCEPTION_RECORD prec = pinfo->ExceptionRecord;
+    if ( ( EXCEPTION_ACCESS_VIOLATION == prec->ExceptionCode ) && ( prec->NumberParameters >= 2 ) && ( 0 != g_fault_cpu ) )
+    {
+        void * p = (void *) prec->ExceptionInformation[ 1 ];
+        if ( g_process->vm_memory.is_guard( p ) )
+            report_guard_fault( p );
+    }
+
+    return EXCEPTION_CONTINUE_SEARCH;
+} //guard_fault_handler
+
+static void install_guard_fault_handler( CPUClass * pcpu )
+{
+    g_fault_cpu = pcpu;
+    static bool installed = false;
+    if ( !installed && ( ( 0 != g_process->vm_memory.guard_size() ) || g_process->vm_memory.commits_on_demand() ) )
+        installed = ( 0 != AddVectoredExceptionHandler( 1, guard_fault_handler ) );
+} //install_guard_fault_handler
+
+#else
+
+static void guard_fault_handler( int sig, siginfo_t * info, void * context )
+{
+    if ( ( 0 != g_fault_cpu ) && g_process->vm_memory.is_guard( info->si_addr ) )
+        report_guard_fault( info->si_addr );
+
+    // not a guest access. with the default action restored, the faulting instruction crashes as usual. the handler
+    // stays installed for guest accesses since embedded apps' faults return rather than ending the host process
+
+    signal( sig, SIG_DFL );
+} //guard_fault_handler
+
+static void install_guard_fault_handler( CPUClass * pcpu )
+{
+    g_fault_cpu = pcpu;
+    if ( ( 0 == g_process->vm_memory.guard_size() ) && !g_process->vm_memory.commits_on_demand() )
+        return;
+
+    struct sigaction sa;
+    memset( &sa, 0, sizeof( sa ) );
+    sa.sa_sigaction = guard_fault_handler;
+    sa.sa_flags = SA_SIGINFO;
+    sigemptyset( &sa.sa_mask );
+    sigaction( SIGSEGV, &sa, 0 );
+    sigaction( SIGBUS, &sa, 0 ); // macOS reports PROT_NONE accesses as SIGBUS
+} //install_guard_fault_handler
+
+#endif //_WIN32
+
+#endif //ARMOS
+
 #if defined( M68 )
 
 const char * bdos_functions[] =
@@ -4991,10 +9622,6 @@ static int symbol_find_compare( const void * a, const void * b )
 
 #endif // M68 || SPARCOS || X32OS
 
-vector<char> g_string_table;      // strings in the elf image
-vector<ElfSymbol64> g_symbols;    // symbols in the elf image
-vector<ElfSymbol32> g_symbols32;  // symbols in the elf image
-
 // returns the best guess for a symbol name for the address
 
 #if defined( M68 ) || defined( SPARCOS ) || defined( X32OS )
@@ -5011,12 +9638,12 @@ const char * emulator_symbol_lookup( uint64_t address, uint64_t & offset )
 
 const char * emulator_symbol_lookup( uint32_t address, uint32_t & offset )
 {
-    if ( address < g_base_address || address > ( g_base_address + memory.size() ) )
+    if ( address < g_process->base_address || address > ( g_process->base_address + g_process->vm_memory.size() ) )
         return "";
 
     // if no elf symbols, try CP/M symbols
 
-    if ( 0 == g_symbols32.size() )
+    if ( 0 == g_process->symbols32.size() )
     {
 #ifdef M68
         if ( 0 != g_cpmSymbols.size() )
@@ -5038,12 +9665,12 @@ const char * emulator_symbol_lookup( uint32_t address, uint32_t & offset )
     ElfSymbol32 key = {0};
     key.value = address;
 
-    ElfSymbol32 * psym = (ElfSymbol32 *) my_bsearch( &key, g_symbols32.data(), g_symbols32.size(), sizeof( key ), symbol_find_compare32 );
+    ElfSymbol32 * psym = (ElfSymbol32 *) my_bsearch( &key, g_process->symbols32.data(), g_process->symbols32.size(), sizeof( key ), symbol_find_compare32 );
 
     if ( 0 != psym )
     {
         offset = address - psym->value;
-        return & g_string_table[ psym->name ];
+        return & g_process->string_table[ psym->name ];
     }
 
     offset = 0;
@@ -5062,39 +9689,140 @@ static int symbol_compare32( const void * a, const void * b )
     return -1;
 } //symbol_compare32
 
-#else // M68 || SPARCOS || X32OS
+#else // M68 || SPARCOS || X32OS
+
+static void ensure_symbols();
+
+const char * emulator_symbol_lookup( uint64_t address, uint64_t & offset )
+{
+    if ( address < g_process->base_address || address > ( g_process->base_address + g_process->vm_memory.size() ) )
+        return "";
+
+    ensure_symbols();
+
+    ElfSymbol64 key = {0};
+    key.value = address;
+
+    ElfSymbol64 * psym = (ElfSymbol64 *) my_bsearch( &key, g_process->symbols.data(), g_process->symbols.size(), sizeof( key ), symbol_find_compare );
+
+    if ( 0 != psym )
+    {
+        offset = address - psym->value;
+        return & g_process->string_table[ psym->name ];
+    }
+
+    offset = 0;
+    return "";
+} //emulator_symbol_lookup
+
+static int symbol_compare( const void * a, const void * b )
+{
+    ElfSymbol64 * pa = (ElfSymbol64 *) a;
+    ElfSymbol64 * pb = (ElfSymbol64 *) b;
+
+    if ( pa->value > pb->value )
+        return 1;
+    if ( pa->value == pb->value )
+        return 0;
+    return -1;
+} //symbol_compare
+
+// void out and sort the symbols read from the elf image. image_end is just past the loaded segments.
+// list traces them, which only makes sense while the image is loading
+
+static void prepare_symbols( uint64_t image_end, bool list )
+{
+    // void out the entries that don't have symbol names or have mangled names that start with $
+
+    for ( size_t se = 0; se < g_process->symbols.size(); se++ )
+    {
+        g_process->symbols[se].swap_endianness();
+
+        if ( ( 0 == g_process->symbols[se].name ) || ( '$' == g_process->string_table[ g_process->symbols[se].name ] ) )
+            g_process->symbols[se].value = 0;
+    }
+
+    // use known qsort so traces are consistent across platforms because qsort implementations for ties differ
+
+    my_qsort( g_process->symbols.data(), g_process->symbols.size(), sizeof( ElfSymbol64 ), symbol_compare );
+
+    // remove symbols that don't look like they have a valid addresses (rust binaries have tens of thousands of these)
+
+    size_t to_erase = 0;
+    for ( size_t se = 0; se < g_process->symbols.size(); se++ )
+    {
+        if ( g_process->symbols[ se ].value < g_process->base_address )
+            to_erase++;
+        else
+            break;
+    }
+
+    if ( to_erase > 0 )
+        g_process->symbols.erase( g_process->symbols.begin(), g_process->symbols.begin() + to_erase );
+
+    // set the size of each symbol if it's not already set
+
+    for ( size_t se = 0; se < g_process->symbols.size(); se++ )
+    {
+        if ( 0 == g_process->symbols[se].size )
+        {
+            if ( se < ( g_process->symbols.size() - 1 ) )
+                g_process->symbols[se].size = g_process->symbols[ se + 1 ].value - g_process->symbols[ se ].value;
+            else
+                g_process->symbols[se].size = image_end - g_process->symbols[ se ].value;
+        }
+    }
+
+    if ( !list )
+        return;
+
+    tracer.Trace( "elf image has %u usable symbols:\n", (unsigned) g_process->symbols.size() );
+    tracer.Trace( "             address              size  name\n" );
 
-const char * emulator_symbol_lookup( uint64_t address, uint64_t & offset )
-{
-    if ( address < g_base_address || address > ( g_base_address + memory.size() ) )
-        return "";
+    for ( size_t se = 0; se < g_process->symbols.size(); se++ )
+        tracer.Trace( "    %16llx  %16llx  %s\n", g_process->symbols[ se ].value, g_process->symbols[ se ].size, & g_process->string_table[ g_process->symbols[ se ].name ] );
+} //prepare_symbols
 
-    ElfSymbol64 key = {0};
-    key.value = address;
+#if defined( ARMOS ) && !defined( _WIN32 )
 
-    ElfSymbol64 * psym = (ElfSymbol64 *) my_bsearch( &key, g_symbols.data(), g_symbols.size(), sizeof( key ), symbol_find_compare );
+// when tracing is off the symbol and string tables are mapped at load but only read and sorted when a symbol is first
+// needed. Rust and Go binaries have tens of thousands of symbols that most runs never look up
 
-    if ( 0 != psym )
-    {
-        offset = address - psym->value;
-        return & g_string_table[ psym->name ];
-    }
+static bool map_file_range( int fd, uint64_t offset, uint64_t size, MappedFileRange & range )
+{
+    uint64_t page = (uint64_t) sysconf( _SC_PAGESIZE );
+    uint64_t start = offset & ~( page - 1 );
+    range.length = (size_t) ( size + ( offset - start ) );
+    range.base = mmap( 0, range.length, PROT_READ, MAP_PRIVATE, fd, (off_t) start );
+    if ( MAP_FAILED == range.base )
+        return false;
 
-    offset = 0;
-    return "";
-} //emulator_symbol_lookup
+    range.data = (const uint8_t *) range.base + ( offset - start );
+    range.size = (size_t) size;
+    return true;
+} //map_file_range
 
-static int symbol_compare( const void * a, const void * b )
+#endif
+
+static void ensure_symbols()
 {
-    ElfSymbol64 * pa = (ElfSymbol64 *) a;
-    ElfSymbol64 * pb = (ElfSymbol64 *) b;
+#if defined( ARMOS ) && !defined( _WIN32 )
+    if ( !g_process->symbols_pending.load( memory_order_acquire ) )
+        return;
 
-    if ( pa->value > pb->value )
-        return 1;
-    if ( pa->value == pb->value )
-        return 0;
-    return -1;
-} //symbol_compare
+    lock_guard<mutex> lock( g_process->symbols_mutex );
+    if ( g_process->symbols_pending.load( memory_order_relaxed ) )
+    {
+        g_process->string_table.assign( (const char *) g_process->string_view.data, (const char *) g_process->string_view.data + g_process->string_view.size );
+        g_process->symbols.resize( g_process->symbol_view.size / sizeof( ElfSymbol64 ) );
+        memcpy( g_process->symbols.data(), g_process->symbol_view.data, g_process->symbols.size() * sizeof( ElfSymbol64 ) );
+        munmap( g_process->symbol_view.base, g_process->symbol_view.length );
+        munmap( g_process->string_view.base, g_process->string_view.length );
+        prepare_symbols( g_process->symbols_image_end, false );
+        g_process->symbols_pending.store( false, memory_order_release );
+    }
+#endif
+} //ensure_symbols
 
 #endif //M68
 
@@ -5379,7 +10107,7 @@ struct FCBCPM68K // file control block for cp/m
 
     void Trace( bool justArg = false ) // justArg is the first 16 bytes at app startup
     {
-        tracer.Trace( "  FCB at address %04x:\n", (uint32_t) ( (uint8_t * ) this - memory.data() ) );
+        tracer.Trace( "  FCB at address %04x:\n", (uint32_t) ( (uint8_t * ) this - g_process->vm_memory.data() ) );
         tracer.Trace( "    drive:    %#x == %c\n", dr, ( 0 == dr ) ? 'A' : 'A' + dr - 1 );
         tracer.Trace( "    filename: '%c%c%c%c%c%c%c%c'\n", 0x7f & f[0], 0x7f & f[1], 0x7f & f[2], 0x7f & f[3],
                                                             0x7f & f[4], 0x7f & f[5], 0x7f & f[6], 0x7f & f[7] );
@@ -5571,7 +10299,7 @@ bool handle_relocations_cpm( FILE * fp, HeaderCPM68K & head, uint32_t text_base,
 {
     if ( 0 == head.relocation_flag ) // 0 means they exist
     {
-        uint16_t * pimage = (uint16_t *) ( memory.data() + text_base );
+        uint16_t * pimage = (uint16_t *) ( g_process->vm_memory.data() + text_base );
         uint32_t relocation_words = ( head.cb_text + head.cb_data ) / 2;
         vector<uint16_t> relocations;
         relocations.resize( relocation_words );
@@ -5679,10 +10407,10 @@ bool load59_cpm68k( FILE *fp, uint32_t lowestAddress, uint32_t highestAddress, u
     uint32_t image_size = head.cb_text + head.cb_data + head.cb_bss;
     basePage = lowestAddress;
     stackPointer = highestAddress & 0xfffffffe; // make sure it's 2-byte aligned
-    BasePageCPM * pbasepage = (BasePageCPM *) ( memory.data() + basePage );
+    BasePageCPM * pbasepage = (BasePageCPM *) ( g_process->vm_memory.data() + basePage );
 
     fseek( fp, (long) sizeof( head ), SEEK_SET );
-    read = fread( memory.data() + text_base, head.cb_text + head.cb_data, 1, fp );
+    read = fread( g_process->vm_memory.data() + text_base, head.cb_text + head.cb_data, 1, fp );
     if ( 1 != read )
     {
         printf( "can't read text and data segments of cp/m 68k image file\n" );
@@ -5726,10 +10454,10 @@ bool load59_cpm68k( FILE *fp, uint32_t lowestAddress, uint32_t highestAddress, u
     tracer.Trace( "  <code from the .68k file>\n" );
     tracer.Trace( "  initial pc execution_addess + start of code         %x\n", text_base );
     tracer.Trace( "  start of base page:                                 %x\n", basePage );
-    tracer.Trace( "  start of the address space:                         %x\n", g_base_address );
+    tracer.Trace( "  start of the address space:                         %x\n", g_process->base_address );
 
     tracer.Trace( "first 512 bytes starting at base page:\n" );
-    tracer.TraceBinaryData( memory.data() + basePage, 512, 8 );
+    tracer.TraceBinaryData( g_process->vm_memory.data() + basePage, 512, 8 );
 
     return true;
 } //load59_cpm68k
@@ -5742,7 +10470,7 @@ bool load_cpm68k( const char * acApp, const char * acAppArgs )
     ConsoleConfiguration::ConvertRedirectedLFToCR( true );
 
     // if this is being called from the bdos chain call, reset global data structures.
-    memory.resize( 0 );
+    g_process->vm_memory.resize( 0 );
     g_cpmSymbols.resize( 0 );
 
     FILE * fp = fopen( acApp, "rb" );
@@ -5787,25 +10515,25 @@ bool load_cpm68k( const char * acApp, const char * acAppArgs )
         memory_size &= ~3;
     }
 
-    g_end_of_data = memory_size;
-    g_brk_offset = memory_size;
-    g_highwater_brk = memory_size;
-    memory_size += g_brk_commit;
+    g_process->end_of_data = memory_size;
+    g_process->brk_offset = memory_size;
+    g_process->highwater_brk = memory_size;
+    memory_size += g_process->brk_commit;
 
-    g_bottom_of_stack = memory_size;
-    memory_size += g_stack_commit;
+    g_process->bottom_of_stack = memory_size;
+    memory_size += g_process->stack_commit;
 
-    memory.resize( memory_size );
-    memset( memory.data(), 0, memory.size() );
+    g_process->vm_memory.resize( memory_size );
+    memset( g_process->vm_memory.data(), 0, g_process->vm_memory.size() );
 
     // put the supervisor stack pointer in the first 4 bytes of RAM.
-    * (uint32_t *) memory.data() = swap_endian32( 1024 ); // arbitrary, but above the vector table and below the typical cp/m 68k base page (where f83 loads)
+    * (uint32_t *) g_process->vm_memory.data() = swap_endian32( 1024 ); // arbitrary, but above the vector table and below the typical cp/m 68k base page (where f83 loads)
 
-    g_base_address = 0;
+    g_process->base_address = 0;
     uint32_t base_page = text_base - 0x100; // where the base page (256 bytes) resides
-    BasePageCPM * pbasepage = (BasePageCPM *) ( memory.data() + base_page );
-    g_execution_address = text_base;
-    g_top_of_stack = (REG_TYPE) g_bottom_of_stack + g_stack_commit;
+    BasePageCPM * pbasepage = (BasePageCPM *) ( g_process->vm_memory.data() + base_page );
+    g_process->execution_address = text_base;
+    g_process->top_of_stack = (REG_TYPE) g_process->bottom_of_stack + g_process->stack_commit;
     pbasepage->reserved[ 1 ] = 0x22; // move.l d0, d1.  return code. at at offset 0x26 in the base page (not a cp/m standard)
     pbasepage->reserved[ 2 ] = 0x00;
     pbasepage->reserved[ 3 ] = 0x70; // moveq #93, d0   linux exit function
@@ -5814,16 +10542,16 @@ bool load_cpm68k( const char * acApp, const char * acAppArgs )
     pbasepage->reserved[ 6 ] = 0x40;
 
     // per the cp/m 68k spec there must be two 32-bit values at the top of the stack for base address and return location at app completion
-    g_top_of_stack -= 8;
-    uint32_t * preturn_address = (uint32_t *) & memory[ g_top_of_stack ];
-    uint32_t * pbase_page_address = (uint32_t *) & memory[ g_top_of_stack + 4 ];
+    g_process->top_of_stack -= 8;
+    uint32_t * preturn_address = (uint32_t *) & g_process->vm_memory[ g_process->top_of_stack ];
+    uint32_t * pbase_page_address = (uint32_t *) & g_process->vm_memory[ g_process->top_of_stack + 4 ];
     *preturn_address = swap_endian32( base_page + 0x26 );
     *pbase_page_address = swap_endian32( base_page );
-    tracer.Trace( "memory at top of stack address %#x:\n", g_top_of_stack );
-    tracer.TraceBinaryData( & memory[ g_top_of_stack ], 8, 4 );
+    tracer.Trace( "memory at top of stack address %#x:\n", g_process->top_of_stack );
+    tracer.TraceBinaryData( & g_process->vm_memory[ g_process->top_of_stack ], 8, 4 );
 
     fseek( fp, (long) sizeof( head ), SEEK_SET );
-    read = fread( memory.data() + text_base, head.cb_text + head.cb_data, 1, fp );
+    read = fread( g_process->vm_memory.data() + text_base, head.cb_text + head.cb_data, 1, fp );
     if ( 1 != read )
     {
         printf( "can't read text and data segments of cp/m 68k image file: %s\n", acApp );
@@ -5915,16 +10643,16 @@ bool load_cpm68k( const char * acApp, const char * acAppArgs )
     // malloc / brk in the C runtime for DR C use some of these values
 
     pbasepage->lowest_tpa = 0;
-    pbasepage->highest_tpa = swap_endian32( g_base_address + memory_size - 1 );
+    pbasepage->highest_tpa = swap_endian32( g_process->base_address + memory_size - 1 );
     pbasepage->start_text = swap_endian32( text_base );
     pbasepage->cb_text = swap_endian32( head.cb_text );
     pbasepage->start_data = swap_endian32( text_base + head.cb_text );
     pbasepage->cb_data = swap_endian32( head.cb_data );
     pbasepage->start_bss = swap_endian32( text_base + head.cb_text + head.cb_data );
     pbasepage->cb_bss = swap_endian32( head.cb_bss );
-    pbasepage->cb_after_bss = swap_endian32( g_brk_commit );
+    pbasepage->cb_after_bss = swap_endian32( g_process->brk_commit );
 
-    g_DMA = memory.data() + text_base - 0x80; // midway through the base page
+    g_DMA = g_process->vm_memory.data() + text_base - 0x80; // midway through the base page
     uint32_t data_base = text_base; // + head.cb_text; with 0x601a all bases belong to text_base
     uint32_t bss_base = text_base; // data_base + head.cb_data;
 
@@ -5937,30 +10665,30 @@ bool load_cpm68k( const char * acApp, const char * acAppArgs )
     pbasepage->Trace();
 
     tracer.Trace( "memory map from highest to lowest addresses:\n" );
-    tracer.Trace( "  first byte beyond allocated memory:                 %x\n", g_base_address + memory_size );
-    tracer.Trace( "  actual top of stack:                                %x\n", g_top_of_stack + 8 );
-    tracer.Trace( "  initial stack pointer g_top_of_stack:               %x\n", g_top_of_stack );
-    REG_TYPE stack_bytes = g_stack_commit;
+    tracer.Trace( "  first byte beyond allocated memory:                 %x\n", g_process->base_address + memory_size );
+    tracer.Trace( "  actual top of stack:                                %x\n", g_process->top_of_stack + 8 );
+    tracer.Trace( "  initial stack pointer g_top_of_stack:               %x\n", g_process->top_of_stack );
+    REG_TYPE stack_bytes = g_process->stack_commit;
     tracer.Trace( "  <stack>                                             (%d == %x bytes)\n", stack_bytes, stack_bytes );
-    tracer.Trace( "  last byte stack can use (g_bottom_of_stack):        %x\n", g_base_address + g_bottom_of_stack );
-    tracer.Trace( "  <unallocated space between brk and the stack>       (%d == %llx bytes)\n", g_brk_commit, g_brk_commit );
-    tracer.Trace( "  end_of_bss / current brk:                           %x\n", g_base_address + g_end_of_data );
+    tracer.Trace( "  last byte stack can use (g_bottom_of_stack):        %x\n", g_process->base_address + g_process->bottom_of_stack );
+    tracer.Trace( "  <unallocated space between brk and the stack>       (%d == %llx bytes)\n", g_process->brk_commit, g_process->brk_commit );
+    tracer.Trace( "  end_of_bss / current brk:                           %x\n", g_process->base_address + g_process->end_of_data );
     tracer.Trace( "  <uninitialized bss data>\n" );
-    tracer.Trace( "  start of bss segment:                               %x\n", g_execution_address + head.cb_text + head.cb_data );
+    tracer.Trace( "  start of bss segment:                               %x\n", g_process->execution_address + head.cb_text + head.cb_data );
     tracer.Trace( "  <initialized data from the .68k file>\n" );
-    tracer.Trace( "  start of data segment:                              %x\n", g_execution_address + head.cb_text );
+    tracer.Trace( "  start of data segment:                              %x\n", g_process->execution_address + head.cb_text );
     tracer.Trace( "  <code from the .68k file>\n" );
-    tracer.Trace( "  initial pc execution_addess + start of code         %x\n", g_execution_address );
-    tracer.Trace( "  default DMA address:                                %x\n", (uint32_t) ( g_DMA - memory.data() ) );
+    tracer.Trace( "  initial pc execution_addess + start of code         %x\n", g_process->execution_address );
+    tracer.Trace( "  default DMA address:                                %x\n", (uint32_t) ( g_DMA - g_process->vm_memory.data() ) );
     tracer.Trace( "  start of base page:                                 %x\n", base_page );
-    tracer.Trace( "  start of the address space:                         %x\n", g_base_address );
+    tracer.Trace( "  start of the address space:                         %x\n", g_process->base_address );
 
-    tracer.Trace( "vm memory first byte beyond:     %p\n", memory.data() + memory_size );
-    tracer.Trace( "vm memory start:                 %p\n", memory.data() );
+    tracer.Trace( "vm memory first byte beyond:     %p\n", g_process->vm_memory.data() + memory_size );
+    tracer.Trace( "vm memory start:                 %p\n", g_process->vm_memory.data() );
     tracer.Trace( "memory_size:                     %#x == %d\n", memory_size, memory_size );
 
     tracer.Trace( "first 512 bytes starting at base page:\n" );
-    tracer.TraceBinaryData( memory.data() + base_page, 512, 8 );
+    tracer.TraceBinaryData( g_process->vm_memory.data() + base_page, 512, 8 );
 
     return true;
 } //load_cpm68k
@@ -6372,10 +11100,10 @@ void emulator_invoke_68k_trap3( m68000 & cpu ) // bios
         case 0: // cold boot
         case 1: // warm boot
         {
-            g_terminate = true;
+            g_process->terminate = true;
             cpu.end_emulation();
-            g_exit_code = (int) ACCESS_REG( REG_ARG0 ); // not part of the cp/m 68k spec but it seems handy
-            tracer.Trace( "  emulated app exit code %d\n", g_exit_code );
+            g_process->exit_code = (int) ACCESS_REG( REG_ARG0 ); // not part of the cp/m 68k spec but it seems handy
+            tracer.Trace( "  emulated app exit code %d\n", g_process->exit_code );
             break;
         }
         case 2: // console status (check for console character ready)
@@ -6457,10 +11185,10 @@ void emulator_invoke_68k_trap2( m68000 & cpu ) // bdos
     {
         case 0: // system reset; exit the app
         {
-            g_terminate = true;
+            g_process->terminate = true;
             cpu.end_emulation();
-            g_exit_code = (int) ACCESS_REG( REG_ARG0 ); // not part of the cp/m 68k spec but it seems handy
-            tracer.Trace( "  emulated app exit code %d\n", g_exit_code );
+            g_process->exit_code = (int) ACCESS_REG( REG_ARG0 ); // not part of the cp/m 68k spec but it seems handy
+            tracer.Trace( "  emulated app exit code %d\n", g_process->exit_code );
             break;
         }
         case 1: // console input. echo input to console
@@ -6556,8 +11284,8 @@ void emulator_invoke_68k_trap2( m68000 & cpu ) // bdos
                 {
                     tracer.Trace( "  bdos read console buffer read a ^c at the first position, so it's terminating the app\n" );
                     cpu.end_emulation();
-                    g_terminate = true;
-                    g_exit_code = 1;
+                    g_process->terminate = true;
+                    g_process->exit_code = 1;
                     break;
                 }
 
@@ -6867,7 +11595,7 @@ void emulator_invoke_68k_trap2( m68000 & cpu ) // bdos
 
                     uint32_t file_size = portable_filelen( fp );
                     uint32_t curr = pfcb->GetSequentialOffset();
-                    uint16_t dmaOffset = (uint16_t) ( g_DMA - memory.data() );
+                    uint16_t dmaOffset = (uint16_t) ( g_DMA - g_process->vm_memory.data() );
                     tracer.Trace( "  file size: %#x = %u, current %#x = %u, dma %#x = %u\n",
                                   file_size, file_size, curr, curr, dmaOffset, dmaOffset );
 
@@ -6920,7 +11648,7 @@ void emulator_invoke_68k_trap2( m68000 & cpu ) // bdos
                 {
                     uint32_t file_size = portable_filelen( fp );
                     uint32_t curr = pfcb->GetSequentialOffset();
-                    uint16_t dmaOffset = (uint16_t) ( g_DMA - memory.data() );
+                    uint16_t dmaOffset = (uint16_t) ( g_DMA - g_process->vm_memory.data() );
                     tracer.Trace( "  writing at offset %#x = %u, file size is %#x = %u, dma %#x = %u\n",
                                   curr, curr, file_size, file_size, dmaOffset, dmaOffset );
                     fseek( fp, curr, SEEK_SET );
@@ -7015,7 +11743,7 @@ void emulator_invoke_68k_trap2( m68000 & cpu ) // bdos
         case 26: // set the dma address (128 byte buffer for doing I/O)
         {
             tracer.Trace( "  updating DMA address; D %u = %#x\n", ACCESS_REG( REG_ARG0 ), ACCESS_REG( REG_ARG0 ) );
-            g_DMA = memory.data() + ACCESS_REG( REG_ARG0 );
+            g_DMA = g_process->vm_memory.data() + ACCESS_REG( REG_ARG0 );
             break;
         }
         case 29: // get read-only vector: return bitmap of read-only drives
@@ -7184,7 +11912,7 @@ void emulator_invoke_68k_trap2( m68000 & cpu ) // bdos
             if ( load_cpm68k( acApp, acAppArgs ) )
             {
                 tracer.Trace( "loaded chained app successfully\n" );
-                cpu.reset( memory, g_base_address, g_execution_address, g_stack_commit, g_top_of_stack );
+                cpu.reset( g_process->vm_memory, g_process->base_address, g_process->execution_address, g_process->stack_commit, g_process->top_of_stack );
             }
             else
             {
@@ -7294,11 +12022,11 @@ void emulator_invoke_68k_trap2( m68000 & cpu ) // bdos
             // otherwise, set the current code to the value in DE (mapped to 68k registers)
 
             if ( 0xffff == ACCESS_REG( REG_ARG0 ) )
-                ACCESS_REG( REG_RESULT ) = g_exit_code;
+                ACCESS_REG( REG_RESULT ) = g_process->exit_code;
             else
             {
-                g_exit_code = ACCESS_REG( REG_ARG0 ) >> 16;
-                tracer.Trace( "  app exit code set to %u\n", g_exit_code );
+                g_process->exit_code = ACCESS_REG( REG_ARG0 ) >> 16;
+                tracer.Trace( "  app exit code set to %u\n", g_process->exit_code );
             }
             break;
         }
@@ -7356,7 +12084,7 @@ static bool load_image32( FILE * fp, const char * pimage, const char * app_args
     tracer.Trace( "  section offset: %u == %x\n", ehead.section_header_table, ehead.section_header_table );
     tracer.Trace( "  section with section names: %u == %x\n", ehead.section_with_section_names, ehead.section_with_section_names );
     tracer.Trace( "  flags: %x\n", ehead.flags );
-    g_execution_address = ehead.entry_point;
+    g_process->execution_address = ehead.entry_point;
 
     // determine how much RAM to allocate
 
@@ -7393,18 +12121,18 @@ static bool load_image32( FILE * fp, const char * pimage, const char * app_args
         if ( just_past > memory_size )
             memory_size = just_past;
 
-        if ( ( 0 != head.physical_address ) && ( ( 0 == g_base_address ) || g_base_address > head.physical_address ) )
-            g_base_address = head.physical_address;
+        if ( ( 0 != head.physical_address ) && ( ( 0 == g_process->base_address ) || g_process->base_address > head.physical_address ) )
+            g_process->base_address = head.physical_address;
     }
 
     // if it won't waste much RAM, start the address space at 0 so low addresses can be used for things like trap vectors
 
-    REG_TYPE elf_base_address = g_base_address;
+    REG_TYPE elf_base_address = g_process->base_address;
 
-    if ( g_base_address < 0x20000 ) // sparc v8 binaries load by default at 0x10000 using stock tools
-        g_base_address = 0;
+    if ( g_process->base_address < 0x20000 ) // sparc v8 binaries load by default at 0x10000 using stock tools
+        g_process->base_address = 0;
 
-    memory_size -= g_base_address;
+    memory_size -= g_process->base_address;
     tracer.Trace( "memory_size of content to load from elf file: %x\n", memory_size );
 
     // first load the string table(s)
@@ -7436,14 +12164,14 @@ static bool load_image32( FILE * fp, const char * pimage, const char * app_args
             }
             else
             {
-                g_string_table.resize( head.size );
+                g_process->string_table.resize( head.size );
                 fseek( fp, (long) head.offset, SEEK_SET );
-                read = fread( g_string_table.data(), head.size, 1, fp );
+                read = fread( g_process->string_table.data(), head.size, 1, fp );
                 if ( 1 != read )
                     usage( "can't read string table\n" );
 
                 tracer.Trace( "main string table:\n" );
-                tracer.TraceBinaryData( (uint8_t *) g_string_table.data(), (uint32_t) head.size, 4 );
+                tracer.TraceBinaryData( (uint8_t *) g_process->string_table.data(), (uint32_t) head.size, 4 );
             }
         }
     }
@@ -7485,9 +12213,9 @@ static bool load_image32( FILE * fp, const char * pimage, const char * app_args
 
         if ( 2 == head.type )
         {
-            g_symbols32.resize( head.size / sizeof( ElfSymbol32 ) );
+            g_process->symbols32.resize( head.size / sizeof( ElfSymbol32 ) );
             fseek( fp, (long) head.offset, SEEK_SET );
-            read = fread( g_symbols32.data(), 1, head.size, fp );
+            read = fread( g_process->symbols32.data(), 1, head.size, fp );
             if ( 0 == read )
                 usage( "can't read symbol table\n" );
         }
@@ -7495,68 +12223,68 @@ static bool load_image32( FILE * fp, const char * pimage, const char * app_args
 
     // void out the entries that don't have symbol names or have mangled names that start with $
 
-    for ( size_t se = 0; se < g_symbols32.size(); se++ )
+    for ( size_t se = 0; se < g_process->symbols32.size(); se++ )
     {
-        g_symbols32[se].swap_endianness();
+        g_process->symbols32[se].swap_endianness();
 
-        if ( ( 0 == g_symbols32[se].name ) || ( '$' == g_string_table[ g_symbols32[se].name ] ) )
-            g_symbols32[se].value = 0;
+        if ( ( 0 == g_process->symbols32[se].name ) || ( '$' == g_process->string_table[ g_process->symbols32[se].name ] ) )
+            g_process->symbols32[se].value = 0;
     }
 
     // use known my_qsort so traces are consistent across platforms because qsort implementations for duplicate values differ
 
     tracer.Trace( "sorting symbol entries\n" );
-    my_qsort( g_symbols32.data(), g_symbols32.size(), sizeof( ElfSymbol32 ), symbol_compare32 );
+    my_qsort( g_process->symbols32.data(), g_process->symbols32.size(), sizeof( ElfSymbol32 ), symbol_compare32 );
 
     // remove symbols that don't look like they have a valid addresses (rust binaries have tens of thousands of these)
 
     size_t to_erase = 0;
-    for ( size_t se = 0; se < g_symbols32.size(); se++ )
+    for ( size_t se = 0; se < g_process->symbols32.size(); se++ )
     {
-        if ( g_symbols32[ se ].value < elf_base_address )
+        if ( g_process->symbols32[ se ].value < elf_base_address )
             to_erase++;
         else
             break;
     }
 
     if ( to_erase > 0 )
-        g_symbols32.erase( g_symbols32.begin(), g_symbols32.begin() + to_erase );
+        g_process->symbols32.erase( g_process->symbols32.begin(), g_process->symbols32.begin() + to_erase );
 
     // set the size of each symbol if it's not already set
 
-    for ( size_t se = 0; se < g_symbols32.size(); se++ )
+    for ( size_t se = 0; se < g_process->symbols32.size(); se++ )
     {
-        if ( 0 == g_symbols32[se].size )
+        if ( 0 == g_process->symbols32[se].size )
         {
-            if ( se < ( g_symbols32.size() - 1 ) )
-                g_symbols32[se].size = g_symbols32[ se + 1 ].value - g_symbols32[ se ].value;
+            if ( se < ( g_process->symbols32.size() - 1 ) )
+                g_process->symbols32[se].size = g_process->symbols32[ se + 1 ].value - g_process->symbols32[ se ].value;
             else
-                g_symbols32[se].size = g_base_address + memory_size - g_symbols32[ se ].value;
+                g_process->symbols32[se].size = g_process->base_address + memory_size - g_process->symbols32[ se ].value;
         }
     }
 
-    tracer.Trace( "elf image has %u usable symbols:\n", (unsigned) g_symbols32.size() );
+    tracer.Trace( "elf image has %u usable symbols:\n", (unsigned) g_process->symbols32.size() );
     tracer.Trace( "     address      size  name\n" );
 
-    for ( size_t se = 0; se < g_symbols32.size(); se++ )
-        tracer.Trace( "    %8x  %8x  %s\n", g_symbols32[ se ].value, g_symbols32[ se ].size, & g_string_table[ g_symbols32[ se ].name ] );
+    for ( size_t se = 0; se < g_process->symbols32.size(); se++ )
+        tracer.Trace( "    %8x  %8x  %s\n", g_process->symbols32[ se ].value, g_process->symbols32[ se ].size, & g_process->string_table[ g_process->symbols32[ se ].name ] );
 
     // memory map from high to low addresses:
     //     <end of allocated memory>
     //     (memory for mmap fulfillment)
-    //     g_mmap_offset
-    //     (wasted space so g_mmap_offset is 4k-aligned)
+    //     mmap_offset
+    //     (wasted space so mmap_offset is 4k-aligned)
     //     arg_data_offset -- actual arg and env, etc. values pointed to by Linux start data
     //     Linux start data on the stack (see details below)
-    //     g_top_of_stack
-    //     g_bottom_of_stack
+    //     top_of_stack
+    //     bottom_of_stack
     //     (unallocated space between brk and the bottom of the stack)
-    //     g_brk_offset with uninitialized RAM (just after arg_data_offset initially)
-    //     g_end_of_data
+    //     brk_offset with uninitialized RAM (just after arg_data_offset initially)
+    //     end_of_data
     //     uninitalized data bss (size read from the .elf file)
     //     initialized data (size & data read from the .elf file)
     //     code (read from the .elf file)
-    //     g_base_address (offset read from the .elf file).
+    //     base_address (offset read from the .elf file).
 
     if ( memory_size & 0xf )
     {
@@ -7564,26 +12292,26 @@ static bool load_image32( FILE * fp, const char * pimage, const char * app_args
         memory_size &= ~0xf;
     }
 
-    g_end_of_data = memory_size;
-    g_brk_offset = memory_size;
-    g_highwater_brk = memory_size;
-    memory_size += g_brk_commit;
+    g_process->end_of_data = memory_size;
+    g_process->brk_offset = memory_size;
+    g_process->highwater_brk = memory_size;
+    memory_size += g_process->brk_commit;
 
-    g_bottom_of_stack = memory_size;
-    memory_size += g_stack_commit;
+    g_process->bottom_of_stack = memory_size;
+    memory_size += g_process->stack_commit;
     REG_TYPE top_of_aux = memory_size;
 
     REG_TYPE arg_data_offset = memory_size;
     memory_size += g_arg_data_commit;
 
     memory_size = round_up( memory_size, (REG_TYPE) 4096 ); // mmap should hand out 4k-aligned pages
-    g_mmap_offset = memory_size;
-    memory_size += g_mmap_commit;
+    g_process->mmap_offset = memory_size;
+    memory_size += g_process->mmap_commit;
 
-    memory.resize( memory_size );
-    memset( memory.data(), 0, memory_size );
+    g_process->vm_memory.resize( memory_size );
+    memset( g_process->vm_memory.data(), 0, memory_size );
 
-    g_mmap.initialize( g_base_address + g_mmap_offset, g_mmap_commit, memory.data() - g_base_address );
+    g_process->mmap_arena.initialize( g_process->base_address + g_process->mmap_offset, g_process->mmap_commit, g_process->vm_memory.data() - g_process->base_address );
 
     // load the program into RAM
 
@@ -7602,7 +12330,7 @@ static bool load_image32( FILE * fp, const char * pimage, const char * app_args
         if ( 0 != head.file_size && 1 == head.type )
         {
             fseek( fp, (long) head.offset_in_image, SEEK_SET );
-            read = fread( memory.data() + head.physical_address - g_base_address, 1, head.file_size, fp );
+            read = fread( g_process->vm_memory.data() + head.physical_address - g_process->base_address, 1, head.file_size, fp );
             if ( 0 == read )
                 usage( "can't read image" );
 
@@ -7610,21 +12338,21 @@ static bool load_image32( FILE * fp, const char * pimage, const char * app_args
 
             tracer.Trace( "  read type %s: %x bytes into physical address %x - %x then uninitialized to %x \n", head.show_type(), head.file_size,
                           head.physical_address, head.physical_address + head.file_size - 1, head.physical_address + head.memory_size - 1 );
-            tracer.TraceBinaryData( memory.data() + head.physical_address - g_base_address, get_min( (uint32_t) head.file_size, (uint32_t) 128 ), 4 );
+            tracer.TraceBinaryData( g_process->vm_memory.data() + head.physical_address - g_process->base_address, get_min( (uint32_t) head.file_size, (uint32_t) 128 ), 4 );
         }
     }
 
     // if the base address is 0 we need a supervisor stack configured at address 0.
 
-    if ( 0 == g_base_address )
-        * (uint32_t *) memory.data() = swap_endian32( elf_base_address ); // arbitrary, but probably safe here between the vector table and app
+    if ( 0 == g_process->base_address )
+        * (uint32_t *) g_process->vm_memory.data() = swap_endian32( elf_base_address ); // arbitrary, but probably safe here between the vector table and app
 
     // write the command-line arguments into the vm memory in a place where _start can find them.
     // there's an array of pointers to the args followed by the arg strings at offset arg_data_offset.
 
     const uint32_t max_args = 40;
     REG_TYPE aargs[ max_args ]; // vm pointers to each arguments
-    char * buffer_args = (char *) ( memory.data() + arg_data_offset );
+    char * buffer_args = (char *) ( g_process->vm_memory.data() + arg_data_offset );
     size_t image_len = strlen( pimage );
     vector<char> full_command( 2 + image_len + strlen( app_args ) );
     strcpy( full_command.data(), pimage );
@@ -7647,8 +12375,8 @@ static bool load_image32( FILE * fp, const char * pimage, const char * app_args
 
         REG_TYPE offset = (REG_TYPE) ( pargs - buffer_args );
         tracer.Trace( "offset %x\n", offset );
-        aargs[ app_argc ] = swap_endian32( offset + g_base_address + arg_data_offset );
-        tracer.Trace( "  argument %d is '%s', at vm address %llx\n", app_argc, pargs, (uint64_t) offset + g_base_address + arg_data_offset );
+        aargs[ app_argc ] = swap_endian32( offset + g_process->base_address + arg_data_offset );
+        tracer.Trace( "  argument %d is '%s', at vm address %llx\n", app_argc, pargs, (uint64_t) offset + g_process->base_address + arg_data_offset );
 
         app_argc++;
         pargs += strlen( pargs );
@@ -7662,7 +12390,7 @@ static bool load_image32( FILE * fp, const char * pimage, const char * app_args
     char * penv_data = (char *) ( buffer_args + env_offset );
     strcpy( penv_data, "OS=" );
     strcat( penv_data, APP_NAME );
-    REG_TYPE env_os_address = (REG_TYPE) ( penv_data - (char *) memory.data() ) + g_base_address;
+    REG_TYPE env_os_address = (REG_TYPE) ( penv_data - (char *) g_process->vm_memory.data() ) + g_process->base_address;
     tracer.Trace( "env_os_address %x\n", env_os_address );
     REG_TYPE env_count = 1;
     REG_TYPE env_tz_address = 0;
@@ -7686,7 +12414,7 @@ static bool load_image32( FILE * fp, const char * pimage, const char * app_args
         if ( 0 != acName[ 0 ] )
         {
             char * ptz_data = penv_data + 1 + strlen( penv_data );
-            env_tz_address = (REG_TYPE) ( ptz_data - (char *) memory.data() ) + g_base_address;
+            env_tz_address = (REG_TYPE) ( ptz_data - (char *) g_process->vm_memory.data() ) + g_process->base_address;
             tracer.Trace( "env_tz_address %x\n", env_tz_address );
             strcpy( ptz_data, "TZ=" );
 
@@ -7712,7 +12440,7 @@ static bool load_image32( FILE * fp, const char * pimage, const char * app_args
 #endif
 
     tracer.Trace( "args_len %d, penv_data %p\n", args_len, penv_data );
-    tracer.TraceBinaryData( (uint8_t *) ( memory.data() + arg_data_offset ), g_arg_data_commit + 0x20, 4 ); // +20 to inspect for bugs
+    tracer.TraceBinaryData( (uint8_t *) ( g_process->vm_memory.data() + arg_data_offset ), g_arg_data_commit + 0x20, 4 ); // +20 to inspect for bugs
 
     // put the Linux startup info at the top of the stack. this consists of (from high to low):
     //   two 8-byte random numbers used for stack and pointer guards
@@ -7727,13 +12455,13 @@ static bool load_image32( FILE * fp, const char * pimage, const char * app_args
     //   argc  <<<==== sp should point here when the entrypoint (likely _start) is invoked
 
     tracer.Trace( "top of aux: %x\n", top_of_aux );
-    REG_TYPE * pstack = (REG_TYPE *) ( memory.data() + top_of_aux );
+    REG_TYPE * pstack = (REG_TYPE *) ( g_process->vm_memory.data() + top_of_aux );
 
     pstack--;
     *pstack = (REG_TYPE) rand64();
     pstack--;
     *pstack = (REG_TYPE) rand64();
-    REG_TYPE prandom = g_base_address + memory_size - ( 2 * sizeof( REG_TYPE ) );
+    REG_TYPE prandom = g_process->base_address + top_of_aux - ( 2 * sizeof( REG_TYPE ) );
 
     // ensure that after all of this the stack is 16-byte aligned
 
@@ -7741,7 +12469,7 @@ static bool load_image32( FILE * fp, const char * pimage, const char * app_args
         pstack--;
 
     pstack -= ( 10 * sizeof( AuxProcessStart32 ) ); // for 10 aux records
-    REG_TYPE aux_data_offset = (REG_TYPE) ( (uint8_t *) pstack - memory.data() );
+    REG_TYPE aux_data_offset = (REG_TYPE) ( (uint8_t *) pstack - g_process->vm_memory.data() );
     AuxProcessStart32 * paux = (AuxProcessStart32 *) pstack;
     paux[0].a_type = 25; // AT_RANDOM
     paux[0].a_un.a_val = prandom;
@@ -7750,7 +12478,7 @@ static bool load_image32( FILE * fp, const char * pimage, const char * app_args
     paux[1].a_un.a_val = 4096;
     paux[1].swap_endianness();
     paux[2].a_type = 16; // AT_HWCAP
-    paux[2].a_un.a_val = 0xa01; // ARM64 bits for fp(0), atomics(8), cpuid(11)
+    paux[2].a_un.a_val = 0xbf9; // ARM64 bits for fp(0), aes(3), pmull(4), sha1(5), sha2(6), crc32(7), atomics(8), fphp(9), cpuid(11)
     paux[2].swap_endianness();
     paux[3].a_type = 26; // AT_HWCAP2
     paux[3].a_un.a_val = 0;
@@ -7786,7 +12514,7 @@ static bool load_image32( FILE * fp, const char * pimage, const char * app_args
     }
 
     // point to the OS= environment variable location
-    *pstack = swap_endian32( env_os_address ); // (REG_TYPE) ( env_offset + arg_data_offset + g_base_address + max_args * sizeof( REG_TYPE ) );
+    *pstack = swap_endian32( env_os_address ); // (REG_TYPE) ( env_offset + arg_data_offset + base_address + max_args * sizeof( REG_TYPE ) );
     tracer.Trace( "the OS environment argument is at VM address %lx\n", swap_endian32( *pstack ) );
 
     pstack--; // the last argv is 0 to indicate the end
@@ -7797,50 +12525,50 @@ static bool load_image32( FILE * fp, const char * pimage, const char * app_args
         *pstack = aargs[ iarg ];
     }
 
-    REG_TYPE first_argv_at = (REG_TYPE) ( ( (uint8_t *) pstack - memory.data() ) + g_base_address );
+    REG_TYPE first_argv_at = (REG_TYPE) ( ( (uint8_t *) pstack - g_process->vm_memory.data() ) + g_process->base_address );
     tracer.Trace( "first argv value (app name) is at %lx\n", first_argv_at );
     pstack--;
     *pstack = swap_endian32( app_argc );
 
-    g_top_of_stack = (REG_TYPE) ( ( (uint8_t *) pstack - memory.data() ) + g_base_address );
+    g_process->top_of_stack = (REG_TYPE) ( ( (uint8_t *) pstack - g_process->vm_memory.data() ) + g_process->base_address );
 #ifdef SPARCOS
     // linux on sparc v8 reserves one register frame of space between argc and the actual top of the stack for the trap handler
-    g_top_of_stack -= 64;
+    g_process->top_of_stack -= 64;
 #endif
 
-    REG_TYPE aux_data_size = top_of_aux - (REG_TYPE) ( (uint8_t *) pstack - memory.data() );
+    REG_TYPE aux_data_size = top_of_aux - (REG_TYPE) ( (uint8_t *) pstack - g_process->vm_memory.data() );
     tracer.Trace( "stack at start (beginning with argc) -- %u bytes at address %p:\n", aux_data_size, pstack );
     tracer.TraceBinaryData( (uint8_t *) pstack, (uint32_t) aux_data_size, 2 );
 
     tracer.Trace( "memory map from highest to lowest addresses:\n" );
-    tracer.Trace( "  first byte beyond allocated memory:                 %lx\n", g_base_address + memory_size );
-    tracer.Trace( "  <mmap arena>                                        (%ld = %lx bytes)\n", g_mmap_commit, g_mmap_commit );
-    tracer.Trace( "  mmap start adddress:                                %lx\n", g_base_address + g_mmap_offset );
+    tracer.Trace( "  first byte beyond allocated memory:                 %lx\n", g_process->base_address + memory_size );
+    tracer.Trace( "  <mmap arena>                                        (%ld = %lx bytes)\n", g_process->mmap_commit, g_process->mmap_commit );
+    tracer.Trace( "  mmap start adddress:                                %lx\n", g_process->base_address + g_process->mmap_offset );
     tracer.Trace( "  <filler to align to 4k-page for mmap allocations>\n" );
 
     tracer.Trace( "  <argv data, pointed to by argv array below>         (%ld == %lx bytes)\n", g_arg_data_commit, g_arg_data_commit );
-    tracer.Trace( "  start of argv data:                                 %lx\n", g_base_address + arg_data_offset );
+    tracer.Trace( "  start of argv data:                                 %lx\n", g_process->base_address + arg_data_offset );
 
-    tracer.Trace( "  start of aux data:                                  %lx\n", g_base_address + aux_data_offset );
+    tracer.Trace( "  start of aux data:                                  %lx\n", g_process->base_address + aux_data_offset );
     tracer.Trace( "  <random, alignment, aux recs, env, argv>            (%ld == %lx bytes)\n", aux_data_size, aux_data_size );
-    tracer.Trace( "  initial stack pointer g_top_of_stack:               %lx\n", g_top_of_stack );
-    REG_TYPE stack_bytes = g_stack_commit - aux_data_size;
+    tracer.Trace( "  initial stack pointer g_top_of_stack:               %lx\n", g_process->top_of_stack );
+    REG_TYPE stack_bytes = g_process->stack_commit - aux_data_size;
     tracer.Trace( "  <stack>                                             (%ld == %lx bytes)\n", stack_bytes, stack_bytes );
-    tracer.Trace( "  last byte stack can use (g_bottom_of_stack):        %lx\n", g_base_address + g_bottom_of_stack );
-    tracer.Trace( "  <unallocated space between brk and the stack>       (%ld == %lx bytes)\n", g_brk_commit, g_brk_commit );
-    tracer.Trace( "  end_of_data / current brk:                          %lx\n", g_base_address + g_end_of_data );
-    REG_TYPE uninitialized_bytes = g_end_of_data - first_uninitialized_data;
+    tracer.Trace( "  last byte stack can use (g_bottom_of_stack):        %lx\n", g_process->base_address + g_process->bottom_of_stack );
+    tracer.Trace( "  <unallocated space between brk and the stack>       (%ld == %lx bytes)\n", g_process->brk_commit, g_process->brk_commit );
+    tracer.Trace( "  end_of_data / current brk:                          %lx\n", g_process->base_address + g_process->end_of_data );
+    REG_TYPE uninitialized_bytes = g_process->end_of_data - first_uninitialized_data;
     tracer.Trace( "  <uninitialized data per the .elf file>              (%ld == %lx bytes)\n", uninitialized_bytes, uninitialized_bytes );
     tracer.Trace( "  first byte of uninitialized data:                   %lx\n", first_uninitialized_data );
     tracer.Trace( "  <initialized data from the .elf file>\n" );
     tracer.Trace( "  <code from the .elf file>\n" );
-    tracer.Trace( "  initial pc execution_addess:                        %lx\n", g_execution_address );
+    tracer.Trace( "  initial pc execution_addess:                        %lx\n", g_process->execution_address );
     tracer.Trace( "  <code per the .elf file>\n" );
     tracer.Trace( "  start of the address space per the .elf file:       %lx\n", elf_base_address );
-    tracer.Trace( "  start of the address space actual:                  %lx\n", g_base_address );
+    tracer.Trace( "  start of the address space actual:                  %lx\n", g_process->base_address );
 
-    tracer.Trace( "vm memory first byte beyond:     %p\n", memory.data() + memory_size );
-    tracer.Trace( "vm memory start:                 %p\n", memory.data() );
+    tracer.Trace( "vm memory first byte beyond:     %p\n", g_process->vm_memory.data() + memory_size );
+    tracer.Trace( "vm memory start:                 %p\n", g_process->vm_memory.data() );
     tracer.Trace( "memory_size:                     %lx == %ld\n", memory_size, memory_size );
 
     return true;
@@ -7888,14 +12616,14 @@ static bool load_68000_hex( const char * pimage )
                 ac[ 3 ] = acLine[ 7 ];
                 ac[ 4 ] = 0;
                 uint32_t address = strtoul( ac, 0, 16 );
-                memory.resize( address + length );
+                g_process->vm_memory.resize( address + length );
                 for ( uint32_t i = 0; i < length; i++ )
                 {
                     ac[ 0 ] = acLine[ 8 + i * 2 ];
                     ac[ 1 ] = acLine[ 8 + i * 2 + 1 ];
                     ac[ 2 ] = 0;
                     uint8_t v = (uint8_t) strtoul( ac, 0, 16 );
-                    memory[ address + i ] = v;
+                    g_process->vm_memory[ address + i ] = v;
                 }
             }
             else if ( '9' == acLine[1] )
@@ -7905,14 +12633,14 @@ static bool load_68000_hex( const char * pimage )
                 ac[ 2 ] = acLine[ 6 ];
                 ac[ 3 ] = acLine[ 7 ];
                 ac[ 4 ] = 0;
-                g_execution_address = strtoul( ac, 0, 16 );
+                g_process->execution_address = strtoul( ac, 0, 16 );
             }
             else
                 usage( "motorola hex input file format variation not supported" );
         }
     } while ( !feof( fp ) );
 
-    REG_TYPE memory_size = (REG_TYPE) memory.size();
+    REG_TYPE memory_size = (REG_TYPE) g_process->vm_memory.size();
 
     if ( memory_size & 0xf )
     {
@@ -7920,44 +12648,44 @@ static bool load_68000_hex( const char * pimage )
         memory_size &= ~0xf;
     }
 
-    g_end_of_data = memory_size;
-    g_brk_offset = memory_size;
-    g_highwater_brk = memory_size;
-    memory_size += g_brk_commit;
+    g_process->end_of_data = memory_size;
+    g_process->brk_offset = memory_size;
+    g_process->highwater_brk = memory_size;
+    memory_size += g_process->brk_commit;
 
-    g_bottom_of_stack = memory_size;
-    memory_size += g_stack_commit;
+    g_process->bottom_of_stack = memory_size;
+    memory_size += g_process->stack_commit;
 
     memory_size = round_up( memory_size, (REG_TYPE) 4096 ); // mmap should hand out 4k-aligned pages
-    g_mmap_offset = memory_size;
-    memory_size += g_mmap_commit;
+    g_process->mmap_offset = memory_size;
+    memory_size += g_process->mmap_commit;
 
-    memory.resize( memory_size );
-    memset( memory.data() + g_brk_offset, 0, memory_size - g_brk_offset );
+    g_process->vm_memory.resize( memory_size );
+    memset( g_process->vm_memory.data() + g_process->brk_offset, 0, memory_size - g_process->brk_offset );
 
-    g_base_address = 0;
-    g_mmap.initialize( g_base_address + g_mmap_offset, g_mmap_commit, memory.data() - g_base_address );
+    g_process->base_address = 0;
+    g_process->mmap_arena.initialize( g_process->base_address + g_process->mmap_offset, g_process->mmap_commit, g_process->vm_memory.data() - g_process->base_address );
 
-    g_top_of_stack = (REG_TYPE) memory.size();
+    g_process->top_of_stack = (REG_TYPE) g_process->vm_memory.size();
 
     tracer.Trace( "memory map from highest to lowest addresses:\n" );
-    tracer.Trace( "  first byte beyond allocated memory:                 %x\n", g_base_address + memory_size );
-    tracer.Trace( "  <mmap arena>                                        (%d = %x bytes)\n", g_mmap_commit, g_mmap_commit );
-    tracer.Trace( "  mmap start adddress:                                %x\n", g_base_address + g_mmap_offset );
+    tracer.Trace( "  first byte beyond allocated memory:                 %x\n", g_process->base_address + memory_size );
+    tracer.Trace( "  <mmap arena>                                        (%d = %x bytes)\n", g_process->mmap_commit, g_process->mmap_commit );
+    tracer.Trace( "  mmap start adddress:                                %x\n", g_process->base_address + g_process->mmap_offset );
     tracer.Trace( "  <align to 4k-page for mmap allocations>\n" );
-    tracer.Trace( "  initial stack pointer g_top_of_stack:               %x\n", g_top_of_stack );
-    REG_TYPE stack_bytes = g_stack_commit;
+    tracer.Trace( "  initial stack pointer g_top_of_stack:               %x\n", g_process->top_of_stack );
+    REG_TYPE stack_bytes = g_process->stack_commit;
     tracer.Trace( "  <stack>                                             (%d == %x bytes)\n", stack_bytes, stack_bytes );
-    tracer.Trace( "  last byte stack can use (g_bottom_of_stack):        %x\n", g_base_address + g_bottom_of_stack );
-    tracer.Trace( "  <unallocated space between brk and the stack>       (%d == %llx bytes)\n", g_brk_commit, g_brk_commit );
-    tracer.Trace( "  end_of_data / current brk:                          %x\n", g_base_address + g_end_of_data );
+    tracer.Trace( "  last byte stack can use (g_bottom_of_stack):        %x\n", g_process->base_address + g_process->bottom_of_stack );
+    tracer.Trace( "  <unallocated space between brk and the stack>       (%d == %llx bytes)\n", g_process->brk_commit, g_process->brk_commit );
+    tracer.Trace( "  end_of_data / current brk:                          %x\n", g_process->base_address + g_process->end_of_data );
     tracer.Trace( "  <code + data from the .hex file>\n" );
-    tracer.Trace( "  initial pc execution_addess:                        %x\n", g_execution_address );
+    tracer.Trace( "  initial pc execution_addess:                        %x\n", g_process->execution_address );
     tracer.Trace( "  <code per the .hex file>\n" );
-    tracer.Trace( "  start of the address space:                         %x\n", g_base_address );
+    tracer.Trace( "  start of the address space:                         %x\n", g_process->base_address );
 
-    tracer.Trace( "vm memory first byte beyond:     %p\n", memory.data() + memory_size );
-    tracer.Trace( "vm memory start:                 %p\n", memory.data() );
+    tracer.Trace( "vm memory first byte beyond:     %p\n", g_process->vm_memory.data() + memory_size );
+    tracer.Trace( "vm memory start:                 %p\n", g_process->vm_memory.data() );
     tracer.Trace( "memory_size:                     %#x == %d\n", memory_size, memory_size );
 
     return true;
@@ -7967,8 +12695,54 @@ static bool load_68000_hex( const char * pimage )
 
 #endif // defined( M68 ) || defined( SPARCOS ) || defined( X32OS )
 
-static bool load_image( const char * pimage, const char * app_args )
+#ifdef ARMOS
+
+static bool map_image_segment( int fd, const vector<ElfProgramHeader64> & headers, size_t index )
+{
+    // map a PT_LOAD segment's pages copy-on-write from the file if no other segment shares them. the guest then
+    // only pays for the pages it touches rather than copying the whole image at startup
+
+    const ElfProgramHeader64 & head = headers[ index ];
+    uint64_t offset = head.physical_address - g_process->base_address;
+    if ( !g_process->vm_memory.can_map_files() || ( ( offset & 0xfff ) != ( head.offset_in_image & 0xfff ) ) )
+        return false;
+
+    int64_t file_size = host_file_size( fd );
+    if ( ( file_size < 0 ) || ( ( head.offset_in_image + head.file_size ) > (uint64_t) file_size ) )
+        return false;
+
+    uint64_t start = offset & ~0xfff;
+    uint64_t end = round_up( offset + head.file_size, (uint64_t) 4096 );
+
+    for ( size_t i = 0; i < headers.size(); i++ )
+    {
+        const ElfProgramHeader64 & other = headers[ i ];
+        if ( ( i == index ) || ( 1 != other.type ) || ( 0 == other.physical_address ) || ( 0 == other.memory_size ) )
+            continue;
+
+        uint64_t other_start = ( other.physical_address - g_process->base_address ) & ~0xfff;
+        uint64_t other_end = round_up( other.physical_address - g_process->base_address + other.memory_size, (uint64_t) 4096 );
+        if ( ( other_start < end ) && ( other_end > start ) )
+            return false;
+    }
+
+    if ( !g_process->vm_memory.map_file( (size_t) start, (size_t) ( end - start ), fd, head.offset_in_image - ( offset - start ), false, true ) )
+        return false;
+
+    // the first and last pages also hold whatever is next to the segment in the file. that must read as zero
+
+    memset( g_process->vm_memory.data() + start, 0, (size_t) ( offset - start ) );
+    memset( g_process->vm_memory.data() + offset + head.file_size, 0, (size_t) ( end - ( offset + head.file_size ) ) );
+    return true;
+} //map_image_segment
+
+#endif
+
+static bool load_image( const char * pimage, const char * app_args, FILE * fp_image = 0, const vector<string> * pargv = 0 )
 {
+    // fp_image is an already-open image the caller closes, for embedders loading from memory. pargv, for execve of
+    // an Arm64 image, is the complete argv and app_args is ignored
+
     tracer.Trace( "loading image %s\n", pimage );
 
 #ifdef M68
@@ -7979,14 +12753,14 @@ static bool load_image( const char * pimage, const char * app_args )
         return load_cpm68k( pimage, app_args );
 #endif
 
-    FILE * fp = fopen( pimage, "rb" );
+    FILE * fp = ( 0 != fp_image ) ? fp_image : fopen( pimage, "rb" );
     if ( !fp )
     {
         printf( "can't open elf image file: %s\n", pimage );
         usage();
     }
 
-    CFile file( fp );
+    CFile file( ( 0 != fp_image ) ? 0 : fp );
 
     ElfHeader64 ehead = {0};
     size_t read = fread( &ehead, sizeof ehead, 1, fp );
@@ -8034,12 +12808,13 @@ static bool load_image( const char * pimage, const char * app_args )
     tracer.Trace( "  section offset: %llu == %llx\n", ehead.section_header_table, ehead.section_header_table );
     tracer.Trace( "  section with section names: %u == %x\n", ehead.section_with_section_names, ehead.section_with_section_names );
     tracer.Trace( "  flags: %x\n", ehead.flags );
-    g_execution_address = (REG_TYPE) ehead.entry_point;
-    g_compressed_rvc = 0 != ( ehead.flags & 1 ); // 2-byte compressed RVC instructions, not 4-byte default risc-v instructions
+    g_process->execution_address = (REG_TYPE) ehead.entry_point;
+    g_process->compressed_rvc = 0 != ( ehead.flags & 1 ); // 2-byte compressed RVC instructions, not 4-byte default risc-v instructions
 
     // determine how much RAM to allocate
 
     REG_TYPE memory_size = 0;
+    vector<ElfProgramHeader64> program_headers;
 
     for ( uint16_t ph = 0; ph < ehead.program_header_table_entries; ph++ )
     {
@@ -8053,6 +12828,7 @@ static bool load_image( const char * pimage, const char * app_args )
             usage( "can't read program header" );
 
         head.swap_endianness();
+        program_headers.push_back( head );
 
         tracer.Trace( "  type: %x / %s\n", head.type, head.show_type() );
         tracer.Trace( "  offset in image: %llx\n", head.offset_in_image );
@@ -8064,6 +12840,9 @@ static bool load_image( const char * pimage, const char * app_args )
 
         if ( 2 == head.type )
         {
+#ifdef ARMOS
+            embedded_fault( "dynamic linking is not supported by this emulator. link the app with -static" );
+#endif
             printf( "dynamic linking is not supported by this emulator. link your app with -static\n" );
             exit( 1 );
         }
@@ -8072,18 +12851,20 @@ static bool load_image( const char * pimage, const char * app_args )
         if ( just_past > memory_size )
             memory_size = just_past;
 
-        if ( ( 0 != head.physical_address ) && ( ( 0 == g_base_address ) || g_base_address > head.physical_address ) )
-            g_base_address = (REG_TYPE) head.physical_address;
+        if ( ( 0 != head.physical_address ) && ( ( 0 == g_process->base_address ) || g_process->base_address > head.physical_address ) )
+            g_process->base_address = (REG_TYPE) head.physical_address;
     }
 
-    if ( 0 == g_base_address )
+    if ( 0 == g_process->base_address )
         usage( "base address of elf image is invalid; physical address required" );
 
-    memory_size -= g_base_address;
+    memory_size -= g_process->base_address;
     tracer.Trace( "memory_size of content to load from elf file: %llx\n", memory_size );
 
-    // first load the string table
+    // first load the section names string table and find the main string table
     vector<char> section_names_string_table;
+    uint64_t string_table_offset = 0, string_table_size = 0;
+    uint64_t symbol_table_offset = 0, symbol_table_size = 0;
 
     for ( uint16_t sh = 0; sh < ehead.section_header_table_entries; sh++ )
     {
@@ -8111,19 +12892,13 @@ static bool load_image( const char * pimage, const char * app_args )
             }
             else
             {
-                g_string_table.resize( head.size );
-                fseek( fp, (long) head.offset, SEEK_SET );
-                read = fread( g_string_table.data(), head.size, 1, fp );
-                if ( 1 != read )
-                    usage( "can't read string table\n" );
-
-                tracer.Trace( "main string table:\n" );
-                tracer.TraceBinaryData( (uint8_t *) g_string_table.data(), (uint32_t) head.size, 4 );
+                string_table_offset = head.offset;
+                string_table_size = head.size;
             }
         }
     }
 
-    // load the symbol data into RAM
+    // find the symbol data
 
     for ( uint16_t sh = 0; sh < ehead.section_header_table_entries; sh++ )
     {
@@ -8154,77 +12929,72 @@ static bool load_image( const char * pimage, const char * app_args )
 
         if ( 2 == head.type )
         {
-            g_symbols.resize( head.size / sizeof( ElfSymbol64 ) );
-            fseek( fp, (long) head.offset, SEEK_SET );
-            read = fread( g_symbols.data(), 1, head.size, fp );
-            if ( 0 == read )
-                usage( "can't read symbol table\n" );
+            symbol_table_offset = head.offset;
+            symbol_table_size = head.size;
         }
     }
 
-    // void out the entries that don't have symbol names or have mangled names that start with $
-
-    for ( size_t se = 0; se < g_symbols.size(); se++ )
-    {
-        g_symbols[se].swap_endianness();
-
-        if ( ( 0 == g_symbols[se].name ) || ( '$' == g_string_table[ g_symbols[se].name ] ) )
-            g_symbols[se].value = 0;
-    }
-
-    // use known qsort so traces are consistent across platforms because qsort implementations for ties differ
-
-    my_qsort( g_symbols.data(), g_symbols.size(), sizeof( ElfSymbol64 ), symbol_compare );
-
-    // remove symbols that don't look like they have a valid addresses (rust binaries have tens of thousands of these)
+    // read the symbols now if tracing will show them. otherwise they're read on first use where the host can map them
 
-    size_t to_erase = 0;
-    for ( size_t se = 0; se < g_symbols.size(); se++ )
+    bool symbols_mapped = false;
+#if defined( ARMOS ) && !defined( _WIN32 )
+    if ( !tracer.IsEnabled() && ( 0 != symbol_table_size ) && ( 0 != string_table_size ) &&
+         map_file_range( fileno( fp ), symbol_table_offset, symbol_table_size, g_process->symbol_view ) )
     {
-        if ( g_symbols[ se ].value < g_base_address )
-            to_erase++;
+        if ( map_file_range( fileno( fp ), string_table_offset, string_table_size, g_process->string_view ) )
+        {
+            g_process->symbols_image_end = g_process->base_address + memory_size;
+            g_process->symbols_pending = true;
+            symbols_mapped = true;
+        }
         else
-            break;
+            munmap( g_process->symbol_view.base, g_process->symbol_view.length );
     }
+#endif
 
-    if ( to_erase > 0 )
-        g_symbols.erase( g_symbols.begin(), g_symbols.begin() + to_erase );
-
-    // set the size of each symbol if it's not already set
-
-    for ( size_t se = 0; se < g_symbols.size(); se++ )
+    if ( !symbols_mapped )
     {
-        if ( 0 == g_symbols[se].size )
+        if ( 0 != string_table_size )
         {
-            if ( se < ( g_symbols.size() - 1 ) )
-                g_symbols[se].size = g_symbols[ se + 1 ].value - g_symbols[ se ].value;
-            else
-                g_symbols[se].size = g_base_address + memory_size - g_symbols[ se ].value;
+            g_process->string_table.resize( string_table_size );
+            fseek( fp, (long) string_table_offset, SEEK_SET );
+            read = fread( g_process->string_table.data(), string_table_size, 1, fp );
+            if ( 1 != read )
+                usage( "can't read string table\n" );
+
+            tracer.Trace( "main string table:\n" );
+            tracer.TraceBinaryData( (uint8_t *) g_process->string_table.data(), (uint32_t) string_table_size, 4 );
         }
-    }
 
-    tracer.Trace( "elf image has %u usable symbols:\n", (unsigned) g_symbols.size() );
-    tracer.Trace( "             address              size  name\n" );
+        if ( 0 != symbol_table_size )
+        {
+            g_process->symbols.resize( symbol_table_size / sizeof( ElfSymbol64 ) );
+            fseek( fp, (long) symbol_table_offset, SEEK_SET );
+            read = fread( g_process->symbols.data(), 1, g_process->symbols.size() * sizeof( ElfSymbol64 ), fp );
+            if ( 0 == read )
+                usage( "can't read symbol table\n" );
+        }
 
-    for ( size_t se = 0; se < g_symbols.size(); se++ )
-        tracer.Trace( "    %16llx  %16llx  %s\n", g_symbols[ se ].value, g_symbols[ se ].size, & g_string_table[ g_symbols[ se ].name ] );
+        prepare_symbols( g_process->base_address + memory_size, true );
+    }
 
     // memory map from high to low addresses:
     //     <end of allocated memory>
     //     (memory for mmap fulfillment)
-    //     g_mmap_offset
-    //     (wasted space so g_mmap_offset is 4k-aligned)
+    //     mmap_offset
+    //     (wasted space so mmap_offset is 4k-aligned)
     //     Linux start data on the stack (see details below)
-    //     g_top_of_stack
-    //     g_bottom_of_stack
+    //     top_of_stack
+    //     bottom_of_stack
     //     (unallocated space between brk and the bottom of the stack)
-    //     g_brk_offset with uninitialized RAM (just after arg_data_offset initially)
-    //     g_end_of_data
+    //     brk_offset with uninitialized RAM (just after arg_data_offset initially)
+    //     end_of_data
     //     arg_data_offset
+    //     vdso page (ARMOS only)
     //     uninitalized data bss (size read from the .elf file)
     //     initialized data (size & data read from the .elf file)
     //     code (read from the .elf file)
-    //     g_base_address (offset read from the .elf file).
+    //     base_address (offset read from the .elf file).
 
     // stacks by convention on arm64 and risc-v are 16-byte aligned. make sure to start aligned
 
@@ -8234,98 +13004,152 @@ static bool load_image( const char * pimage, const char * app_args )
         memory_size &= ~0xf;
     }
 
+#ifdef ARMOS
+    memory_size = round_up( g_process->base_address + memory_size, vdso_size ) - g_process->base_address;
+    g_process->vdso_address = g_process->base_address + memory_size;
+    memory_size += vdso_size;
+#endif
+
     uint64_t arg_data_offset = memory_size;
+#ifdef ARMOS
+    g_process->arg_data_offset = arg_data_offset;
+#endif
     memory_size += g_arg_data_commit;
-    g_end_of_data = memory_size;
-    g_brk_offset = memory_size;
-    g_highwater_brk = memory_size;
-    memory_size += g_brk_commit;
+    g_process->end_of_data = memory_size;
+    g_process->brk_offset = memory_size;
+    g_process->highwater_brk = memory_size;
+    memory_size += g_process->brk_commit;
 
-    g_bottom_of_stack = memory_size;
-    memory_size += g_stack_commit;
+    g_process->bottom_of_stack = memory_size;
+    memory_size += g_process->stack_commit;
 
     uint64_t top_of_aux = memory_size;
     memory_size = round_up( memory_size, (REG_TYPE) 4096 ); // mmap should hand out 4k-aligned pages
-    g_mmap_offset = memory_size;
-    memory_size += g_mmap_commit;
+    g_process->mmap_offset = memory_size;
+    memory_size += g_process->mmap_commit;
 
-    memory.resize( memory_size );
-    memset( memory.data(), 0, memory_size );
+#ifdef ARMOS
+    g_process->vm_memory.request_large_pages( g_large_pages );
+    g_process->vm_memory.request_commit_on_demand( true );
+#endif
+    g_process->vm_memory.resize( memory_size ); // new memory is zero. pages aren't touched (and so don't use RAM) until the app uses them
+    if ( g_process->vm_memory.size() != memory_size )
+        usage( "can't allocate memory for the app" );
 
-    g_mmap.initialize( g_base_address + g_mmap_offset, g_mmap_commit, memory.data() - g_base_address );
+    g_process->mmap_arena.initialize( g_process->base_address + g_process->mmap_offset, g_process->mmap_commit, g_process->vm_memory.data() - g_process->base_address );
+#ifdef ARMOS
+    if ( !commit_fixed_regions() )
+        usage( "can't allocate memory for the app" );
+    g_process->mmap_arena.set_commit( commit_mmap_range, discard_mmap_range, g_process );
+    build_vdso( g_process->vm_memory.data() + ( g_process->vdso_address - g_process->base_address ) );
+#endif
 
     // load the program into RAM
 
     uint64_t first_uninitialized_data = 0;
 
-    for ( uint16_t ph = 0; ph < ehead.program_header_table_entries; ph++ )
+    for ( size_t ph = 0; ph < program_headers.size(); ph++ )
     {
-        size_t o = ehead.program_header_table + ( ph * ehead.program_header_table_size );
-        ElfProgramHeader64 head = {0};
-        fseek( fp, (long) o, SEEK_SET );
-        read = fread( &head, 1, get_min( sizeof( head ), (size_t) ehead.program_header_table_size ), fp );
-        head.swap_endianness();
+        ElfProgramHeader64 & head = program_headers[ ph ];
 
         // head.type 1 == load. Other entries will overlap and even have physical addresses, but they are redundant
 
         if ( 0 != head.file_size && 0 != head.physical_address && 1 == head.type )
         {
-            fseek( fp, (long) head.offset_in_image, SEEK_SET );
-            read = fread( memory.data() + head.physical_address - g_base_address, 1, head.file_size, fp );
-            if ( 0 == read )
-                usage( "can't read image" );
+#ifdef ARMOS
+            if ( map_image_segment( fileno( fp ), program_headers, ph ) )
+                tracer.Trace( "  mapped the segment copy-on-write\n" );
+            else
+#endif
+            {
+                fseek( fp, (long) head.offset_in_image, SEEK_SET );
+                read = fread( g_process->vm_memory.data() + head.physical_address - g_process->base_address, 1, head.file_size, fp );
+                if ( 0 == read )
+                    usage( "can't read image" );
+            }
 
             first_uninitialized_data = get_max( head.physical_address + head.file_size, first_uninitialized_data );
+#ifdef ARMOS
+            if ( head.flags & 1 ) // PF_X
+            {
+                g_process->code_start = ( 0 == g_process->code_end ) ? head.physical_address : get_min( g_process->code_start, head.physical_address );
+                g_process->code_end = get_max( g_process->code_end, head.physical_address + head.file_size );
+            }
+#endif
 
             tracer.Trace( "  read type %s: %llx bytes into physical address %llx - %llx then uninitialized to %llx \n", head.show_type(), head.file_size,
                           head.physical_address, head.physical_address + head.file_size - 1, head.physical_address + head.memory_size - 1 );
-            tracer.TraceBinaryData( memory.data() + head.physical_address - g_base_address, get_min( (uint32_t) head.file_size, (uint32_t) 128 ), 4 );
+            tracer.TraceBinaryData( g_process->vm_memory.data() + head.physical_address - g_process->base_address, get_min( (uint32_t) head.file_size, (uint32_t) 128 ), 4 );
         }
     }
 
+#ifdef ARMOS
+    g_process->image_end = first_uninitialized_data;
+    if ( ( 0 != g_cache_dir ) || ( 0 != g_aot_output ) || ( 0 != g_aot_input ) )
+        g_process->image_hash = fnv1a( &g_process->vdso_address, sizeof( g_process->vdso_address ), hash_image_segments( program_headers ) );
+#endif
+
     // write the command-line arguments into the vm memory in a place where _start can find them.
     // there's an array of pointers to the args followed by the arg strings at offset arg_data_offset.
 
     const uint32_t max_args = 40;
     REG_TYPE aargs[ max_args ]; // vm pointers to each arguments
-    char * buffer_args = (char *) ( memory.data() + arg_data_offset );
-    size_t image_len = strlen( pimage );
-    vector<char> full_command( 2 + image_len + strlen( app_args ) );
-    strcpy( full_command.data(), pimage );
-    backslash_to_slash( full_command.data() );
-    full_command[ image_len ] = ' ';
-    strcpy( full_command.data() + image_len + 1, app_args );
-
-    strcpy( buffer_args, full_command.data() );
-    char * pargs = buffer_args;
-    size_t args_len = strlen( buffer_args );
-
+    char * buffer_args = (char *) ( g_process->vm_memory.data() + arg_data_offset );
+    size_t args_len = 0;
     uint64_t app_argc = 0;
-    while ( *pargs && app_argc < max_args )
+
+    if ( 0 != pargv ) // execve's argv, including argv[0], is used as it was given
     {
-        while ( ' ' == *pargs )
-            pargs++;
+        size_t used = 0;
+        for ( size_t i = 0; ( i < pargv->size() ) && ( app_argc < max_args ); i++ )
+        {
+            strcpy( buffer_args + used, ( *pargv )[ i ].c_str() );
+            aargs[ app_argc ] = used + g_process->base_address + arg_data_offset;
+            tracer.Trace( "  argument %llu is '%s', at vm address %llx\n", app_argc, buffer_args + used, (uint64_t) used + g_process->base_address + arg_data_offset );
+            app_argc++;
+            used += ( *pargv )[ i ].size() + 1;
+        }
+        args_len = ( 0 == used ) ? 0 : ( used - 1 );
+    }
+    else
+    {
+        size_t image_len = strlen( pimage );
+        vector<char> full_command( 2 + image_len + strlen( app_args ) );
+        strcpy( full_command.data(), pimage );
+        backslash_to_slash( full_command.data() );
+        full_command[ image_len ] = ' ';
+        strcpy( full_command.data() + image_len + 1, app_args );
 
-        char * space = strchr( pargs, ' ' );
-        if ( space )
-            *space = 0;
+        strcpy( buffer_args, full_command.data() );
+        char * pargs = buffer_args;
+        args_len = strlen( buffer_args );
 
-        uint64_t offset = pargs - buffer_args;
-        aargs[ app_argc ] = offset + g_base_address + arg_data_offset;
-        tracer.Trace( "  argument %llu is '%s', at vm address %llx\n", app_argc, pargs, (uint64_t) offset + g_base_address + arg_data_offset );
+        while ( *pargs && app_argc < max_args )
+        {
+            while ( ' ' == *pargs )
+                pargs++;
 
-        app_argc++;
-        pargs += strlen( pargs );
+            char * space = strchr( pargs, ' ' );
+            if ( space )
+                *space = 0;
 
-        if ( space )
-            pargs++;
+            uint64_t offset = pargs - buffer_args;
+            aargs[ app_argc ] = offset + g_process->base_address + arg_data_offset;
+            tracer.Trace( "  argument %llu is '%s', at vm address %llx\n", app_argc, pargs, (uint64_t) offset + g_process->base_address + arg_data_offset );
+
+            app_argc++;
+            pargs += strlen( pargs );
+
+            if ( space )
+                pargs++;
+        }
     }
 
     uint64_t env_offset = args_len + 1;
     char * penv_data = (char *) ( buffer_args + env_offset );
     strcpy( penv_data, "OS=" );
     strcat( penv_data, APP_NAME );
-    uint64_t env_os_address = ( penv_data - (char *) memory.data() ) + g_base_address;
+    uint64_t env_os_address = ( penv_data - (char *) g_process->vm_memory.data() ) + g_process->base_address;
     uint64_t env_count = 1;
     uint64_t env_tz_address = 0;
 
@@ -8348,7 +13172,7 @@ static bool load_image( const char * pimage, const char * app_args )
         if ( 0 != acName[ 0 ] )
         {
             char * ptz_data = penv_data + 1 + strlen( penv_data );
-            env_tz_address = ( ptz_data - (char *) memory.data() ) + g_base_address;
+            env_tz_address = ( ptz_data - (char *) g_process->vm_memory.data() ) + g_process->base_address;
             strcpy( ptz_data, "TZ=" );
 
             // libc doesn't like spaces in spite of the doc saying it's OK:
@@ -8372,8 +13196,32 @@ static bool load_image( const char * pimage, const char * app_args )
     }
 #endif
 
+#ifdef ARMOS
+    // -serve jobs and embedders can add environment variables. they follow OS= and TZ= in the argument area
+
+    vector<uint64_t> job_env_addresses;
+    char * pjob_env = penv_data + strlen( penv_data ) + 1;
+    if ( 0 != env_tz_address )
+        pjob_env += strlen( pjob_env ) + 1;
+
+    for ( size_t i = 0; i < g_process->app_env.size(); i++ )
+    {
+        size_t len = g_process->app_env[ i ].size() + 1;
+        if ( ( pjob_env + len ) > ( buffer_args + g_arg_data_commit ) )
+        {
+            tracer.Trace( "no room for environment variable '%s'\n", g_process->app_env[ i ].c_str() );
+            break;
+        }
+
+        memcpy( pjob_env, g_process->app_env[ i ].c_str(), len );
+        job_env_addresses.push_back( ( pjob_env - (char *) g_process->vm_memory.data() ) + g_process->base_address );
+        pjob_env += len;
+        env_count++;
+    }
+#endif
+
     tracer.Trace( "args_len %d, penv_data %p\n", args_len, penv_data );
-    tracer.TraceBinaryData( (uint8_t *) ( memory.data() + arg_data_offset ), g_arg_data_commit + 0x20, 4 ); // +20 to inspect for bugs
+    tracer.TraceBinaryData( (uint8_t *) ( g_process->vm_memory.data() + arg_data_offset ), g_arg_data_commit + 0x20, 4 ); // +20 to inspect for bugs
 
     // put the Linux startup info at the top of the stack. this consists of (from high to low):
     //   two 8-byte random numbers used for stack and pointer guards
@@ -8387,13 +13235,13 @@ static bool load_image( const char * pimage, const char * app_args )
     //   1..n argv string pointers
     //   argc  <<<==== sp should point here when the entrypoint (likely _start) is invoked
 
-    uint64_t * pstack = (uint64_t *) ( memory.data() + top_of_aux );
+    uint64_t * pstack = (uint64_t *) ( g_process->vm_memory.data() + top_of_aux );
 
     pstack--;
     *pstack = rand64();
     pstack--;
     *pstack = rand64();
-    uint64_t prandom = g_base_address + memory_size - 16;
+    uint64_t prandom = g_process->base_address + top_of_aux - 16;
 
     // ensure that after all of this the stack is 16-byte aligned
 
@@ -8402,7 +13250,11 @@ static bool load_image( const char * pimage, const char * app_args )
 
     pstack -= 2; // the AT_NULL record will be here since memory is initialized to 0
 
+#ifdef ARMOS
+    pstack -= 18; // for 9 aux records
+#else
     pstack -= 16; // for 8 aux records
+#endif
     AuxProcessStart * paux = (AuxProcessStart *) pstack;
     paux[0].a_type = 25; // AT_RANDOM
     paux[0].a_un.a_val = prandom;
@@ -8411,7 +13263,7 @@ static bool load_image( const char * pimage, const char * app_args )
     paux[1].a_un.a_val = 4096;
     paux[1].swap_endianness();
     paux[2].a_type = 16; // AT_HWCAP
-    paux[2].a_un.a_val = 0xa01; // ARM64 bits for fp(0), atomics(8), cpuid(11)
+    paux[2].a_un.a_val = 0xbf9; // ARM64 bits for fp(0), aes(3), pmull(4), sha1(5), sha2(6), crc32(7), atomics(8), fphp(9), cpuid(11)
     paux[2].swap_endianness();
     paux[3].a_type = 26; // AT_HWCAP2
     paux[3].a_un.a_val = 0;
@@ -8428,10 +13280,23 @@ static bool load_image( const char * pimage, const char * app_args )
     paux[7].a_type = 14; // AT_EGID
     paux[7].a_un.a_val = 0x595a5449;
     paux[7].swap_endianness();
+#ifdef ARMOS
+    paux[8].a_type = 33; // AT_SYSINFO_EHDR
+    paux[8].a_un.a_val = g_process->vdso_address;
+    paux[8].swap_endianness();
+#endif
 
     pstack--; // end of environment data is 0
     pstack--; // move to where the first environment variable is
 
+#ifdef ARMOS
+    for ( size_t i = job_env_addresses.size(); i > 0; i-- )
+    {
+        *pstack = swap_endian64( job_env_addresses[ i - 1 ] );
+        pstack--;
+    }
+#endif
+
     if ( 0 != env_tz_address )
     {
         *pstack = swap_endian64( env_tz_address );
@@ -8454,40 +13319,43 @@ static bool load_image( const char * pimage, const char * app_args )
     pstack--;
     *pstack = swap_endian64( app_argc );
 
-    g_top_of_stack = (uint64_t) ( ( (uint8_t *) pstack - memory.data() ) + g_base_address );
-    uint64_t aux_data_size = top_of_aux - (uint64_t) ( (uint8_t *) pstack - memory.data() );
+    g_process->top_of_stack = (uint64_t) ( ( (uint8_t *) pstack - g_process->vm_memory.data() ) + g_process->base_address );
+    uint64_t aux_data_size = top_of_aux - (uint64_t) ( (uint8_t *) pstack - g_process->vm_memory.data() );
     tracer.Trace( "stack at start (beginning with argc) -- %llu bytes at address %p:\n", aux_data_size, pstack );
     tracer.TraceBinaryData( (uint8_t *) pstack, (uint32_t) aux_data_size, 2 );
 
     tracer.Trace( "memory map from highest to lowest addresses:\n" );
-    tracer.Trace( "  first byte beyond allocated memory:                 %llx\n", g_base_address + memory_size );
-    tracer.Trace( "  <mmap arena>                                        (%lld = %llx bytes)\n", g_mmap_commit, g_mmap_commit );
-    tracer.Trace( "  mmap start adddress:                                %llx\n", g_base_address + g_mmap_offset );
+    tracer.Trace( "  first byte beyond allocated memory:                 %llx\n", g_process->base_address + memory_size );
+    tracer.Trace( "  <mmap arena>                                        (%lld = %llx bytes)\n", g_process->mmap_commit, g_process->mmap_commit );
+    tracer.Trace( "  mmap start adddress:                                %llx\n", g_process->base_address + g_process->mmap_offset );
     tracer.Trace( "  <align to 4k-page for mmap allocations>\n" );
-    tracer.Trace( "  start of aux data:                                  %llx\n", g_top_of_stack + aux_data_size );
+    tracer.Trace( "  start of aux data:                                  %llx\n", g_process->top_of_stack + aux_data_size );
     tracer.Trace( "  <random, alignment, aux recs, env, argv>            (%lld == %llx bytes)\n", aux_data_size, aux_data_size );
-    tracer.Trace( "  initial stack pointer g_top_of_stack:               %llx\n", g_top_of_stack );
-    uint64_t stack_bytes = g_stack_commit - aux_data_size;
+    tracer.Trace( "  initial stack pointer g_top_of_stack:               %llx\n", g_process->top_of_stack );
+    uint64_t stack_bytes = g_process->stack_commit - aux_data_size;
     tracer.Trace( "  <stack>                                             (%lld == %llx bytes)\n", stack_bytes, stack_bytes );
-    tracer.Trace( "  last byte stack can use (g_bottom_of_stack):        %llx\n", g_base_address + g_bottom_of_stack );
-    tracer.Trace( "  <unallocated space between brk and the stack>       (%lld == %llx bytes)\n", g_brk_commit, g_brk_commit );
-    tracer.Trace( "  end_of_data / current brk:                          %llx\n", g_base_address + g_end_of_data );
-    uint64_t argv_bytes = g_end_of_data - arg_data_offset;
+    tracer.Trace( "  last byte stack can use (g_bottom_of_stack):        %llx\n", g_process->base_address + g_process->bottom_of_stack );
+    tracer.Trace( "  <unallocated space between brk and the stack>       (%lld == %llx bytes)\n", g_process->brk_commit, g_process->brk_commit );
+    tracer.Trace( "  end_of_data / current brk:                          %llx\n", g_process->base_address + g_process->end_of_data );
+    uint64_t argv_bytes = g_process->end_of_data - arg_data_offset;
     tracer.Trace( "  <argv data, pointed to by argv array above>         (%lld == %llx bytes)\n", argv_bytes, argv_bytes );
-    tracer.Trace( "  start of argv data:                                 %llx\n", g_base_address + arg_data_offset );
-    uint64_t uninitialized_bytes = g_base_address + arg_data_offset - first_uninitialized_data;
+    tracer.Trace( "  start of argv data:                                 %llx\n", g_process->base_address + arg_data_offset );
+#ifdef ARMOS
+    tracer.Trace( "  vdso page:                                          %llx\n", g_process->vdso_address );
+#endif
+    uint64_t uninitialized_bytes = g_process->base_address + arg_data_offset - first_uninitialized_data;
     tracer.Trace( "  <uninitialized data per the .elf file>              (%lld == %llx bytes)\n", uninitialized_bytes, uninitialized_bytes );
     tracer.Trace( "  first byte of uninitialized data:                   %llx\n", first_uninitialized_data );
     tracer.Trace( "  <initialized data from the .elf file>\n" );
     tracer.Trace( "  <code from the .elf file>\n" );
-    tracer.Trace( "  initial pc execution_addess:                        %llx\n", g_execution_address );
+    tracer.Trace( "  initial pc execution_addess:                        %llx\n", g_process->execution_address );
     tracer.Trace( "  <code per the .elf file>\n" );
-    tracer.Trace( "  start of the address space per the .elf file:       %llx\n", g_base_address );
+    tracer.Trace( "  start of the address space per the .elf file:       %llx\n", g_process->base_address );
 
-    tracer.Trace( "vm memory first byte beyond:     %p\n", memory.data() + memory_size );
-    tracer.Trace( "vm memory start:                 %p\n", memory.data() );
+    tracer.Trace( "vm memory first byte beyond:     %p\n", g_process->vm_memory.data() + memory_size );
+    tracer.Trace( "vm memory start:                 %p\n", g_process->vm_memory.data() );
     tracer.Trace( "memory_size:                     %#llx == %lld\n", memory_size, memory_size );
-    tracer.Trace( "risc-v compressed instructions:  %s\n", g_compressed_rvc ? "yes" : "no" );
+    tracer.Trace( "risc-v compressed instructions:  %s\n", g_process->compressed_rvc ? "yes" : "no" );
 
 #endif //M68
 
@@ -8525,7 +13393,7 @@ static void elf_info32( FILE * fp, bool verbose )
     printf( "  section offset: %u == %#x\n", ehead.section_header_table, ehead.section_header_table );
     printf( "  flags: %#x\n", ehead.flags );
 
-    g_execution_address = ehead.entry_point;
+    g_process->execution_address = ehead.entry_point;
     REG_TYPE memory_size = 0;
 
     printf( "program headers:\n" );
@@ -8559,12 +13427,12 @@ static void elf_info32( FILE * fp, bool verbose )
 
         if ( 0 != head.physical_address )
         {
-            if ( ( 0 == g_base_address ) || ( g_base_address > head.physical_address ) )
-                g_base_address = head.physical_address;
+            if ( ( 0 == g_process->base_address ) || ( g_process->base_address > head.physical_address ) )
+                g_process->base_address = head.physical_address;
         }
     }
 
-    memory_size -= g_base_address;
+    memory_size -= g_process->base_address;
 
     // first load the string tables
 
@@ -8671,10 +13539,10 @@ static void elf_info32( FILE * fp, bool verbose )
     printf( "global info\n" );
     printf( "  flags: %#08x\n", ehead.flags );
 
-    printf( "  vm g_base_address %llx\n", (uint64_t) g_base_address );
+    printf( "  vm g_base_address %llx\n", (uint64_t) g_process->base_address );
     printf( "  memory_size: %llx\n", (uint64_t) memory_size );
-    printf( "  g_stack_commit: %llx\n", (uint64_t) g_stack_commit );
-    printf( "  g_execution_address %llx\n", (uint64_t) g_execution_address );
+    printf( "  g_stack_commit: %llx\n", (uint64_t) g_process->stack_commit );
+    printf( "  g_execution_address %llx\n", (uint64_t) g_process->execution_address );
 } //elf_info32
 
 static void elf_info( const char * pimage, bool verbose )
@@ -8732,8 +13600,8 @@ static void elf_info( const char * pimage, bool verbose )
     printf( "  section offset: %llu == %llx\n", ehead.section_header_table, ehead.section_header_table );
     printf( "  flags: %x\n", ehead.flags );
 
-    g_execution_address = (REG_TYPE) ehead.entry_point;
-    g_compressed_rvc = 0 != ( ehead.flags & 1 ); // 2-byte compressed RVC instructions, not 4-byte default risc-v instructions
+    g_process->execution_address = (REG_TYPE) ehead.entry_point;
+    g_process->compressed_rvc = 0 != ( ehead.flags & 1 ); // 2-byte compressed RVC instructions, not 4-byte default risc-v instructions
     REG_TYPE memory_size = 0;
 
     printf( "program headers:\n" );
@@ -8767,12 +13635,12 @@ static void elf_info( const char * pimage, bool verbose )
 
         if ( 0 != head.physical_address )
         {
-            if ( ( 0 == g_base_address ) || ( g_base_address > head.physical_address ) )
-                g_base_address = (REG_TYPE) head.physical_address;
+            if ( ( 0 == g_process->base_address ) || ( g_process->base_address > head.physical_address ) )
+                g_process->base_address = (REG_TYPE) head.physical_address;
         }
     }
 
-    memory_size -= g_base_address;
+    memory_size -= g_process->base_address;
 
     // first load the string tables
 
@@ -8864,47 +13732,303 @@ static void elf_info( const char * pimage, bool verbose )
         }
         else if ( 7 == head.type && 0 != head.size && verbose ) // notes
         {
-            vector<uint8_t> notes( head.size );
-            fseek( fp, (long) head.offset, SEEK_SET );
-            read = fread( notes.data(), 1, head.size, fp );
-            if ( 0 == read )
-                usage( "can't read notes\n" );
-            tracer.PrintBinaryData( notes.data(), (uint32_t) head.size, 4 );
+            vector<uint8_t> notes( head.size );
+            fseek( fp, (long) head.offset, SEEK_SET );
+            read = fread( notes.data(), 1, head.size, fp );
+            if ( 0 == read )
+                usage( "can't read notes\n" );
+            tracer.PrintBinaryData( notes.data(), (uint32_t) head.size, 4 );
+        }
+    }
+
+    if ( 0 == g_process->base_address )
+        printf( "base address of elf image is zero; physical address required for the emulator\n" );
+
+    printf( "global info\n" );
+    printf( "  flags: %#08x\n", ehead.flags );
+    printf( "    contains 2-byte compressed RVC instructions: %s\n", g_process->compressed_rvc ? "yes" : "no" );
+    printf( "    contains 4-byte float instructions: %s\n", ( ehead.flags & 2 ) ? "yes" : "no" );
+    printf( "    contains 8-byte double instructions: %s\n", ( ehead.flags & 4 ) ? "yes" : "no" );
+    printf( "    RV TSO memory consistency: %s\n", ( ehead.flags & 0x10 ) ? "yes" : "no" );
+    printf( "    contains non-standard extensions: %s\n", ( ehead.flags & 0xff000000 ) ? "yes" : "no" );
+
+    printf( "  vm g_base_address %llx\n", (uint64_t) g_process->base_address );
+    printf( "  memory_size: %llx\n", (uint64_t) memory_size );
+    printf( "  g_stack_commit: %llx\n", (uint64_t) g_process->stack_commit );
+    printf( "  g_execution_address %llx\n", (uint64_t) g_process->execution_address );
+#endif
+} //elf_info
+
+#ifdef ARMOS
+
+static bool find_symbol_range( const char * name, uint64_t & lo, uint64_t & hi )
+{
+    ensure_symbols();
+
+    for ( size_t i = 0; i < g_process->symbols.size(); i++ )
+    {
+        if ( !strcmp( name, & g_process->string_table[ g_process->symbols[ i ].name ] ) )
+        {
+            lo = g_process->symbols[ i ].value;
+            hi = lo + g_process->symbols[ i ].size;
+            return true;
+        }
+    }
+    return false;
+} //find_symbol_range
+
+static bool find_trace_trigger( const char * trigger, uint64_t & address )
+{
+    // a hex address or a symbol name
+
+    if ( ( '0' == trigger[ 0 ] ) && ( 'x' == tolower( trigger[ 1 ] ) ) )
+    {
+        address = strtoull( trigger + 2, 0, 16 );
+        return true;
+    }
+
+    uint64_t hi;
+    return find_symbol_range( trigger, address, hi );
+} //find_trace_trigger
+
+// -tf: trace instructions only in a symbol or pc range, or an instruction count window. each -tf is a comma-separated
+// list of sym=name, pc=lo-hi (hex), after=N, and count=M, and later ones add to or replace earlier ones
+
+struct TraceFilter
+{
+    bool enabled;
+    string symbol;
+    uint64_t lo;
+    uint64_t hi;
+    uint64_t first;
+    uint64_t count;
+};
+
+static TraceFilter g_trace_filter = { false, string(), 0, 0, 0, 0 };
+
+static bool parse_trace_filter( const char * spec )
+{
+    g_trace_filter.enabled = true;
+
+    while ( 0 != *spec )
+    {
+        const char * end = strchr( spec, ',' );
+        string item( spec, ( 0 == end ) ? strlen( spec ) : ( end - spec ) );
+        spec += item.length() + ( ( 0 == end ) ? 0 : 1 );
+
+        char * pend = 0;
+        if ( !strncmp( item.c_str(), "sym=", 4 ) && ( item.length() > 4 ) )
+        {
+            g_trace_filter.symbol = item.substr( 4 );
+            g_trace_filter.lo = g_trace_filter.hi = 0;
+        }
+        else if ( !strncmp( item.c_str(), "pc=", 3 ) )
+        {
+            g_trace_filter.lo = strtoull( item.c_str() + 3, &pend, 16 );
+            if ( '-' != *pend )
+                return false;
+            g_trace_filter.hi = strtoull( pend + 1, &pend, 16 );
+            if ( ( 0 != *pend ) || ( g_trace_filter.hi <= g_trace_filter.lo ) )
+                return false;
+            g_trace_filter.symbol.clear();
+        }
+        else if ( !strncmp( item.c_str(), "after=", 6 ) )
+        {
+            g_trace_filter.first = strtoull( item.c_str() + 6, &pend, 10 );
+            if ( 0 != *pend )
+                return false;
+        }
+        else if ( !strncmp( item.c_str(), "count=", 6 ) )
+        {
+            g_trace_filter.count = strtoull( item.c_str() + 6, &pend, 10 );
+            if ( 0 != *pend )
+                return false;
+        }
+        else
+            return false;
+    }
+    return true;
+} //parse_trace_filter
+
+static bool apply_trace_filter( CPUClass & cpu )
+{
+    // the symbol is looked up in the current image, so an image run by execve is filtered by its own symbol of that
+    // name. nothing is traced if there isn't one
+
+    if ( !g_trace_filter.enabled )
+        return true;
+
+    uint64_t lo = g_trace_filter.lo;
+    uint64_t hi = g_trace_filter.hi;
+    bool found = g_trace_filter.symbol.empty() || find_symbol_range( g_trace_filter.symbol.c_str(), lo, hi );
+    if ( !found )
+        lo = hi = ~0ull;
+    cpu.set_trace_filter( lo, hi, g_trace_filter.first, g_trace_filter.count );
+    return found;
+} //apply_trace_filter
+
+static void replace_image( unique_ptr<CPUClass> & cpu, bool trace_instructions, bool predecode, bool jit )
+{
+    // execve of an Arm64 image, once the app's cpu has stopped. memory, mappings, and symbols are the new image's.
+    // descriptors without close-on-exec, syscall statistics, and the process clocks carry over
+
+    string path = g_process->exec_path;
+    vector<string> argv = g_process->exec_argv;
+    vector<string> env = g_process->exec_env;
+    tracer.Trace( "execve replacing the app with %s\n", path.c_str() );
+
+    release_file_mappings( 0, (REG_TYPE) -1 );
+
+#if !defined( _WIN32 )
+    int max_fd = (int) get_min( sysconf( _SC_OPEN_MAX ), (long) 65536 );
+    for ( int fd = 3; fd < max_fd; fd++ )
+    {
+        int flags = fcntl( fd, F_GETFD );
+        if ( ( -1 == flags ) || !( flags & FD_CLOEXEC ) )
+            continue;
+
+        map<REG_TYPE, DirEnumeration>::iterator it = g_process->dir_enumerations.find( fd );
+        if ( it != g_process->dir_enumerations.end() )
+        {
+            close_directory( it->second );
+            g_process->dir_enumerations.erase( it );
         }
+        else
+            close( fd );
     }
 
-    if ( 0 == g_base_address )
-        printf( "base address of elf image is zero; physical address required for the emulator\n" );
+    if ( g_process->symbols_pending )
+    {
+        munmap( g_process->symbol_view.base, g_process->symbol_view.length );
+        munmap( g_process->string_view.base, g_process->string_view.length );
+    }
+#endif
 
-    printf( "global info\n" );
-    printf( "  flags: %#08x\n", ehead.flags );
-    printf( "    contains 2-byte compressed RVC instructions: %s\n", g_compressed_rvc ? "yes" : "no" );
-    printf( "    contains 4-byte float instructions: %s\n", ( ehead.flags & 2 ) ? "yes" : "no" );
-    printf( "    contains 8-byte double instructions: %s\n", ( ehead.flags & 4 ) ? "yes" : "no" );
-    printf( "    RV TSO memory consistency: %s\n", ( ehead.flags & 0x10 ) ? "yes" : "no" );
-    printf( "    contains non-standard extensions: %s\n", ( ehead.flags & 0xff000000 ) ? "yes" : "no" );
+    REG_TYPE stack_commit = g_process->stack_commit;
+    REG_TYPE brk_commit = g_process->brk_commit;
+    REG_TYPE mmap_commit = g_process->mmap_commit;
+    map<uint32_t, SyscallStats> syscall_stats;
+    syscall_stats.swap( g_process->syscall_stats );
+    map<REG_TYPE, DirEnumeration> dir_enumerations;
+    dir_enumerations.swap( g_process->dir_enumerations );
+    high_resolution_clock::time_point app_start = g_process->app_start;
+    uint64_t thread_instructions = g_process->thread_instructions;
+
+    stop_profiler(); // samples are of the old image's addresses
+    g_profile_hz = 0;
+    write_branch_profile( *cpu );
+    g_branch_profile_path = 0;
+    show_memory_model();
+
+    cpu->collect_instruction_mix( g_op_counts );
+    cpu.reset();
+    g_process->~EmulatedProcess();
+    new ( g_process ) EmulatedProcess();
+
+    g_process->stack_commit = stack_commit;
+    g_process->brk_commit = brk_commit;
+    g_process->mmap_commit = mmap_commit;
+    g_process->syscall_stats.swap( syscall_stats );
+    g_process->dir_enumerations.swap( dir_enumerations );
+    g_process->app_start = app_start;
+    g_process->thread_instructions = thread_instructions;
+    g_process->app_env = env;
+
+    load_image( path.c_str(), "", 0, &argv ); // a failure here ends armos, like Linux ends a process past the point of no return
+
+    cpu.reset( new CPUClass( g_process->vm_memory, g_process->base_address, g_process->execution_address, g_process->stack_commit, g_process->top_of_stack ) );
+    cpu->trace_instructions( trace_instructions );
+    apply_trace_filter( *cpu );
+    cpu->enable_predecode( predecode );
+    cpu->enable_instruction_mix( g_show_instruction_mix );
+    cpu->enable_branch_profile( 0 != g_branch_profile_path );
+    cpu->enable_memory_tracking( g_memory_model_enabled );
+    if ( g_host_routines )
+        enable_host_routines( *cpu );
+    install_guard_fault_handler( cpu.get() );
+    g_process->main_cpu = cpu.get();
+    if ( jit )
+        cpu->enable_jit( true );
+} //replace_image
+
+#if defined( __aarch64__ ) && defined( __linux__ )
+
+static bool run_in_parent_emulator( const char * app, const char * app_args, bool jit, int & exit_code )
+{
+    // when this armos is an app of another armos, that one runs the app instead. false if there's no such parent
+
+    const char * os = getenv( "OS" );
+    if ( ( 0 == os ) || strcmp( os, APP_NAME ) )
+        return false;
+
+    static char fault[ 256 ];
+    NestedRun run;
+    memset( &run, 0, sizeof( run ) );
+    run.app = (uint64_t) app;
+    run.app_args = (uint64_t) app_args;
+    run.stack_bytes = g_process->stack_commit;
+    run.brk_bytes = g_process->brk_commit;
+    run.mmap_bytes = g_process->mmap_commit;
+    run.flags = ( jit ? nested_jit : 0 ) | ( g_host_routines ? nested_host_routines : 0 );
+    run.fault = (uint64_t) fault;
+    run.fault_size = sizeof( fault );
+
+    // what this armos would give the app after OS= and TZ=, which the outer one adds itself
+
+    vector<const char *> env;
+    for ( size_t i = 0; i < g_process->app_env.size(); i++ )
+        env.push_back( g_process->app_env[ i ].c_str() );
+    env.push_back( 0 );
+    run.env = (uint64_t) env.data();
+
+    fflush( stdout );
+    syscall( emulator_sys_run_nested, &run );
+    if ( 1 != run.handled )
+        return false;
+
+    if ( 0 != fault[ 0 ] )
+        printf( "%s: %s\n", APP_NAME, fault );
+    exit_code = (int) run.exit_code;
+    return true;
+} //run_in_parent_emulator
 
-    printf( "  vm g_base_address %llx\n", (uint64_t) g_base_address );
-    printf( "  memory_size: %llx\n", (uint64_t) memory_size );
-    printf( "  g_stack_commit: %llx\n", (uint64_t) g_stack_commit );
-    printf( "  g_execution_address %llx\n", (uint64_t) g_execution_address );
 #endif
-} //elf_info
+
+#endif //ARMOS
+
+#ifndef ARMOS_EMBED
 
 int main( int argc, char * argv[] )
 {
+#ifdef ARMOS
+    bool threads_finished = true;                        // false if guest threads were abandoned while blocked in the host
+    uint32_t ringRecords = 0;                            // -r: size of the binary trace ring
+    const char * pcRingTrigger = 0;                      // -r: dump the ring when this address or symbol executes
+    const char * pcRingDecode = 0;                       // -d: render this ring file instead of running the app
+    const char * pcSnapTrigger = 0;                      // -snap: take the snapshot when this address or symbol executes
+    const char * pcRestore = 0;                          // -restore: resume this snapshot instead of loading the app
+    const char * pcRecord = 0;                           // -record: log syscall results to this file
+    const char * pcReplay = 0;                           // -replay: answer syscalls from this log
+    static char acSnapPath[ 1024 ] = {0};
+    static char acCacheDir[ 1024 ] = {0};
+#endif
+
     try
     {
         uint16_t tst = 1;
         g_hostIsLittleEndian = ( 1 & ( * (uint8_t *) &tst ) );
 
         bool trace = false;
+        bool traceAsync = false;
         char * pcApp = 0;
         bool showPerformance = false;
+        bool performanceJson = false;                    // -p:json
         bool traceInstructions = false;
         bool elfInfo = false;
         bool verboseElfInfo = false;
         bool generateRVCTable = false;
+        bool predecode = true;
+        bool jit = false;
         static char acAppArgs[1024] = {0};
         static char acApp[1024] = {0};
 
@@ -8924,13 +14048,170 @@ int main( int argc, char * argv[] )
             {
                 char ca = (char) tolower( parg[1] );
 
+#ifdef ARMOS
+                if ( !strncmp( parg + 1, "tf:", 3 ) )
+                {
+                    if ( !parse_trace_filter( parg + 4 ) )
+                        usage( "invalid -tf trace filter" );
+                    trace = true;
+                    traceInstructions = true;
+                }
+                else
+#endif
                 if ( 't' == ca )
+                {
                     trace = true;
+                    if ( ':' == parg[2] )
+                    {
+                        if ( 'a' != tolower( parg[3] ) || 0 != parg[4] )
+                            usage( "invalid trace option" );
+                        traceAsync = true;
+                    }
+                }
                 else if ( 'i' == ca )
                     traceInstructions = true;
 #ifdef RVOS
                 else if ( 'g' == ca )
                     generateRVCTable = true;
+#endif
+#ifdef ARMOS
+                else if ( !strncmp( parg + 1, "aot:", 4 ) )
+                {
+                    if ( 0 == parg[5] )
+                        usage( "the -aot argument requires an output file" );
+
+                    g_aot_output = parg + 5;
+                }
+                else if ( !strncmp( parg + 1, "cache:", 6 ) )
+                {
+                    if ( ( 0 == parg[7] ) || ( ',' == parg[7] ) || ( strlen( parg + 7 ) >= sizeof( acCacheDir ) ) )
+                        usage( "the -cache argument requires a directory" );
+
+                    strcpy( acCacheDir, parg + 7 );
+                    char * pcomma = strchr( acCacheDir, ',' );
+                    if ( 0 != pcomma )
+                    {
+                        *pcomma = 0;
+                        uint64_t megs = strtoull( pcomma + 1, 0, 10 );
+                        if ( ( 0 == megs ) || ( megs > 1024 * 1024 ) )
+                            usage( "invalid -cache size specified" );
+                        g_cache_limit = megs * 1024 * 1024;
+                    }
+                    g_cache_dir = acCacheDir;
+                }
+                else if ( !strncmp( parg + 1, "csim", 4 ) )
+                {
+                    g_memory_model_enabled = true;
+                    if ( ':' == parg[5] )
+                    {
+                        MemoryModelConfig & c = g_memory_config;
+                        if ( ( 5 != sscanf( parg + 6, "%u,%u,%u,%u,%u", &c.l1_kb, &c.l1_ways, &c.l2_kb, &c.l2_ways, &c.tlb_entries ) ) ||
+                             !valid_cache_shape( c.l1_kb, c.l1_ways ) || !valid_cache_shape( c.l2_kb, c.l2_ways ) ||
+                             ( 0 == c.tlb_entries ) || ( c.tlb_entries > 4096 ) )
+                            usage( "invalid -csim configuration" );
+                    }
+                    else if ( 0 != parg[5] )
+                        usage( "invalid -csim option" );
+                }
+                else if ( 'c' == ca )
+                    predecode = false;
+                else if ( !strncmp( parg + 1, "fdo:", 4 ) )
+                {
+                    if ( 0 == parg[5] )
+                        usage( "the -fdo argument requires an output file" );
+
+                    g_branch_profile_path = parg + 5;
+                }
+                else if ( 'f' == ca )
+                    g_host_routines = true;
+                else if ( 'j' == ca )
+                {
+                    jit = true;
+                    if ( ':' == parg[2] )
+                    {
+                        if ( 0 == parg[3] )
+                            usage( "the -j argument requires a file written by -aot" );
+                        g_aot_input = parg + 3;
+                    }
+                    else if ( 0 != parg[2] )
+                        usage( "invalid -j option" );
+                }
+                else if ( 'x' == ca )
+                    g_show_instruction_mix = true;
+                else if ( !strncmp( parg + 1, "snap:", 5 ) )
+                {
+                    if ( ( 0 == parg[6] ) || ( strlen( parg + 6 ) >= sizeof( acSnapPath ) ) )
+                        usage( "the -snap argument requires a file" );
+
+                    strcpy( acSnapPath, parg + 6 );
+                    char * pcomma = strchr( acSnapPath, ',' );
+                    if ( 0 != pcomma )
+                    {
+                        *pcomma = 0;
+                        pcSnapTrigger = pcomma + 1;
+                    }
+                    g_snapshot_path = acSnapPath;
+                }
+                else if ( !strncmp( parg + 1, "serve:", 6 ) )
+                {
+#ifdef _WIN32
+                    usage( "-serve isn't available on Windows" );
+#else
+                    if ( 0 == parg[7] )
+                        usage( "the -serve argument requires a socket path" );
+
+                    g_serve_path = parg + 7;
+#endif
+                }
+                else if ( !strncmp( parg + 1, "restore:", 8 ) )
+                {
+                    if ( 0 == parg[9] )
+                        usage( "the -restore argument requires a snapshot file" );
+
+                    pcRestore = parg + 9;
+                }
+                else if ( !strncmp( parg + 1, "record:", 7 ) )
+                {
+                    if ( 0 == parg[8] )
+                        usage( "the -record argument requires a file" );
+
+                    pcRecord = parg + 8;
+                }
+                else if ( !strncmp( parg + 1, "replay:", 7 ) )
+                {
+                    if ( 0 == parg[8] )
+                        usage( "the -replay argument requires a syscall log" );
+
+                    pcReplay = parg + 8;
+                }
+                else if ( 'r' == ca )
+                {
+                    if ( ':' != parg[2] )
+                        usage( "the -r argument requires a value" );
+
+                    uint64_t records = strtoull( parg + 3, 0, 10 );
+                    if ( records < 1 || records > ( 1 << 24 ) )
+                        usage( "invalid trace ring size specified" );
+
+                    ringRecords = 1;
+                    while ( ringRecords < records )
+                        ringRecords <<= 1;
+
+                    const char * pcomma = strchr( parg, ',' );
+                    if ( 0 != pcomma )
+                        pcRingTrigger = pcomma + 1;
+                }
+                else if ( 'd' == ca )
+                {
+                    if ( ':' != parg[2] )
+                        usage( "the -d argument requires a ring file" );
+
+                    pcRingDecode = parg + 3;
+                }
+#endif
+#ifdef ARMOS
+                else if ( !strcmp( parg + 1, "largepages" ) )
+                    g_large_pages = true;
 #endif
                 else if ( 'h' == ca )
                 {
@@ -8938,10 +14219,10 @@ int main( int argc, char * argv[] )
                         usage( "the -h argument requires a value" );
 
                     REG_TYPE heap = (REG_TYPE) strtoull( parg + 3 , 0, 10 );
-                    if ( heap > 1024 ) // limit to a gig
+                    if ( heap > g_max_reservation_megs )
                         usage( "invalid heap size specified" );
 
-                    g_brk_commit = heap * 1024 * 1024;
+                    g_process->brk_commit = heap * 1024 * 1024;
                 }
 #ifdef _WIN32
                 else if ( 'l' == ca )
@@ -8953,15 +14234,45 @@ int main( int argc, char * argv[] )
                         usage( "the -m argument requires a value" );
 
                     REG_TYPE mmap_space = (REG_TYPE) strtoull( parg + 3 , 0, 10 );
-                    if ( mmap_space > 1024 ) // limit to a gig
+                    if ( mmap_space > g_max_reservation_megs )
                         usage( "invalid mmap size specified" );
 
-                    g_mmap_commit = mmap_space * 1024 * 1024;
+                    g_process->mmap_commit = mmap_space * 1024 * 1024;
                 }
                 else if ( 'e' == ca )
                     elfInfo = true;
+#ifdef ARMOS
+                else if ( 'P' == parg[1] ) // -p is performance information
+                {
+                    if ( ':' != parg[2] )
+                        usage( "the -P argument requires a value" );
+
+                    g_profile_hz = (uint32_t) strtoul( parg + 3, 0, 10 );
+                    if ( g_profile_hz < 1 || g_profile_hz > 100000 )
+                        usage( "invalid profile rate specified" );
+                }
+#endif
                 else if ( 'p' == ca )
+                {
                     showPerformance = true;
+                    g_syscall_timing = true;
+                    if ( !strcmp( parg + 2, ":json" ) )
+                        performanceJson = true;
+                    else if ( 0 != parg[ 2 ] )
+                        usage( "the -p argument's only option is :json" );
+                }
+                else if ( !strncmp( parg + 1, "statcache", 9 ) )
+                {
+                    g_stat_cache_ms = 500;
+                    if ( ':' == parg[10] )
+                    {
+                        g_stat_cache_ms = strtoull( parg + 11, 0, 10 );
+                        if ( g_stat_cache_ms < 1 || g_stat_cache_ms > 60000 )
+                            usage( "invalid -statcache time specified" );
+                    }
+                    else if ( 0 != parg[10] )
+                        usage( "invalid -statcache option" );
+                }
                 else if ( 's' == ca )
                 {
                     if ( ':' != parg[2] )
@@ -8971,7 +14282,7 @@ int main( int argc, char * argv[] )
                     if ( stack_space > 1024 ) // limit to a meg
                         usage( "invalid stack size specified" );
 
-                    g_stack_commit = stack_space * 1024;
+                    g_process->stack_commit = stack_space * 1024;
                 }
                 else if ( 'v' == ca )
                     verboseElfInfo = true;
@@ -8994,6 +14305,8 @@ int main( int argc, char * argv[] )
 
         tracer.Enable( trace, PREFIX_L( LOGFILE_NAME ), true );
         tracer.SetQuiet( true );
+        if ( traceAsync )
+            tracer.SetAsync( true );
         tracer.Trace( "host is little endian: %d, emulated cpu is little endian: %d\n", g_hostIsLittleEndian, CPU_IS_LITTLE_ENDIAN );
 
         g_consoleConfig.EstablishConsoleOutput( 0, 0 );
@@ -9012,6 +14325,20 @@ int main( int argc, char * argv[] )
         }
 #endif
 
+#if defined( ARMOS ) && !defined( _WIN32 )
+        if ( 0 != g_serve_path )
+        {
+            if ( ( 0 != g_snapshot_path ) || ( 0 != pcRestore ) || ( 0 != g_profile_hz ) || traceAsync || ( 0 != pcRecord ) || ( 0 != pcReplay ) )
+                usage( "-serve can't be used with -snap, -restore, -P, -t:a, -record, or -replay" );
+
+            if ( 0 == pcApp )
+            {
+                serve_jobs( 0 ); // returns in each job's process with the job to run
+                pcApp = (char *) g_job.app.c_str();
+            }
+        }
+#endif
+
         if ( 0 == pcApp )
         {
             usage( "no executable specified\n" );
@@ -9061,10 +14388,62 @@ int main( int argc, char * argv[] )
             return 0;
         }
 
+#ifdef ARMOS
+        if ( ( 0 != pcRestore ) && ( 0 != g_snapshot_path ) )
+            usage( "-snap and -restore can't be used together" );
+        if ( ( 0 != g_aot_output ) && ( !predecode || ( 0 != pcRestore ) ) )
+            usage( "-aot can't be used with -c or -restore" );
+        if ( ( 0 != g_cache_dir ) && ( ( 0 != g_aot_output ) || ( 0 != g_aot_input ) ) )
+            usage( "-cache can't be used with -aot or -j:F" );
+        if ( ( 0 != g_branch_profile_path ) && ( !predecode || ( trace && traceInstructions ) || ( 0 != ringRecords ) ) )
+            usage( "-fdo can't be used with -c, -i, or -r" );
+        if ( g_memory_model_enabled && ( jit || g_host_routines ) )
+            usage( "-csim can't be used with -j or -f" );
+        if ( ( 0 != pcRecord ) && ( 0 != pcReplay ) )
+            usage( "-record and -replay can't be used together" );
+        if ( ( 0 != pcRecord ) && !open_syscall_record( pcRecord, acApp ) )
+            usage( "can't create the -record file" );
+        if ( ( 0 != pcReplay ) && !load_syscall_replay( pcReplay, acApp ) )
+            usage( "can't read the -replay syscall log" );
+
+#if defined( __aarch64__ ) && defined( __linux__ )
+        bool nestable = !trace && !traceInstructions && predecode && !showPerformance && !g_show_instruction_mix && ( 0 == g_profile_hz ) &&
+                        ( 0 == g_branch_profile_path ) && !g_memory_model_enabled &&
+                        ( 0 == ringRecords ) && ( 0 == g_snapshot_path ) && ( 0 == pcRestore ) && ( 0 == g_serve_path ) && g_job.app.empty() &&
+                        ( 0 == g_aot_output ) && ( 0 == g_aot_input ) && ( 0 == g_cache_dir ) && !g_large_pages &&
+                        ( 0 == pcRecord ) && ( 0 == pcReplay );
+        int nestedExitCode = 0;
+        if ( nestable && run_in_parent_emulator( acApp, acAppArgs, jit, nestedExitCode ) )
+        {
+            g_consoleConfig.RestoreConsole( false );
+            return nestedExitCode;
+        }
+#endif
+
+        // a job's arguments can have spaces, so they're passed as they came rather than joined into acAppArgs
+
+        const vector<string> * pargv = 0;
+#ifndef _WIN32
+        vector<string> job_argv;
+        if ( !g_job.app.empty() )
+        {
+            job_argv.push_back( acApp );
+            job_argv.insert( job_argv.end(), g_job.args.begin(), g_job.args.end() );
+            pargv = &job_argv;
+        }
+#endif
+
+        Arm64::ArchState restoredState;
+        g_snapshot_app = acApp;
+        bool ok = ( 0 != pcRestore ) ? restore_snapshot( pcRestore, acApp, acAppArgs, restoredState ) : load_image( acApp, acAppArgs, 0, pargv );
+        if ( !ok )
+            g_process->exit_code = 1;
+#else
         bool ok = load_image( acApp, acAppArgs );
+#endif
         if ( ok )
         {
-            unique_ptr<CPUClass> cpu( new CPUClass( memory, g_base_address, g_execution_address, g_stack_commit, g_top_of_stack ) );
+            unique_ptr<CPUClass> cpu( new CPUClass( g_process->vm_memory, g_process->base_address, g_process->execution_address, g_process->stack_commit, g_process->top_of_stack ) );
 
 #if defined( SPARCOS )
             cpu->Sparc_wim() = 2; // wim bit 1 is turned on. The OS owns management of WIM. By default on reset it's set to 0xffffffff
@@ -9073,16 +14452,135 @@ int main( int argc, char * argv[] )
 #endif
 
             cpu->trace_instructions( traceInstructions );
+#ifdef ARMOS
+            if ( !apply_trace_filter( *cpu ) )
+                usage( "the -tf symbol isn't in the app" );
+            cpu->enable_predecode( predecode );
+            cpu->enable_instruction_mix( g_show_instruction_mix );
+            cpu->enable_branch_profile( 0 != g_branch_profile_path );
+            cpu->enable_memory_tracking( g_memory_model_enabled );
+
+            if ( 0 != pcRingDecode )
+            {
+                tracer.Enable( true, PREFIX_L( LOGFILE_NAME ), true );
+                tracer.SetQuiet( true );
+                uint64_t rendered = cpu->render_trace_ring( pcRingDecode );
+                if ( 0 == rendered )
+                    printf( "unable to read trace ring file %s\n", pcRingDecode );
+                else
+                    printf( "%llu instructions from %s rendered to %s\n", (unsigned long long) rendered, pcRingDecode, LOGFILE_NAME );
+                tracer.Shutdown();
+                g_consoleConfig.RestoreConsole( false );
+                return ( 0 == rendered ) ? 1 : 0;
+            }
+
+            if ( 0 != ringRecords )
+            {
+                uint64_t trigger = 0;
+                if ( ( 0 != pcRingTrigger ) && !find_trace_trigger( pcRingTrigger, trigger ) )
+                    usage( "the trace ring trigger isn't a hex address or a symbol in the app" );
+                cpu->enable_trace_ring( ringRecords, trigger, RING_NAME );
+            }
+            if ( 0 != pcRestore )
+                cpu->restore_state( restoredState );
+            else if ( 0 != pcSnapTrigger )
+            {
+                uint64_t trigger = 0;
+                if ( !find_trace_trigger( pcSnapTrigger, trigger ) )
+                    usage( "the snapshot trigger isn't a hex address or a symbol in the app" );
+                cpu->set_breakpoint( trigger );
+            }
+
+            if ( g_host_routines )
+                enable_host_routines( *cpu );
+
+            if ( 0 != g_aot_output )
+            {
+                if ( !cpu->enable_jit( true ) )
+                    printf( "the jit isn't available on this host, so only predecoded instructions are written\n" );
+                bool translated = translate_ahead_of_time( *cpu );
+                g_consoleConfig.RestoreConsole( false );
+                tracer.Shutdown();
+                return translated ? 0 : 1;
+            }
+
+            install_guard_fault_handler( cpu.get() );
+            g_process->main_cpu = cpu.get();
+            start_profiler();
+            if ( jit && !cpu->enable_jit( true ) )
+                printf( "the jit isn't available on this host; using the interpreter\n" );
+
+            // after enable_jit(), which starts with an empty cache
+
+            bool translationCache = ( 0 != g_cache_dir ) && predecode && !traceInstructions && ( 0 == ringRecords ) && ( 0 == pcRestore );
+            if ( translationCache )
+                load_translation_cache( *cpu );
+            else if ( ( 0 != g_aot_input ) && !read_translations( *cpu, g_aot_input ) )
+                printf( "can't use the translations in %s; translating as the app runs\n", g_aot_input );
+#endif
             high_resolution_clock::time_point tStart = high_resolution_clock::now();
 
             #ifdef _WIN32
-                g_tAppStart = tStart;
+                g_process->app_start = tStart;
             #endif
 
             uint64_t instructions = cpu->run();
+#ifdef ARMOS
+            while ( !g_process->exec_path.empty() )
+            {
+                if ( translationCache )
+                    save_translation_cache( *cpu );
+                replace_image( cpu, traceInstructions, predecode, jit );
+                if ( translationCache )
+                {
+                    g_cache_loaded_blocks = 0;
+                    load_translation_cache( *cpu );
+                }
+                instructions += cpu->run();
+            }
+
+#ifndef _WIN32
+            if ( g_forked ) // the app's original process reports; its children just exit
+            {
+                wait_for_threads();
+                sync_file_mappings( 0, (REG_TYPE) -1, false );
+                fflush( stdout );
+                tracer.Flush();
+                _exit( g_process->exit_code );
+            }
+#endif
+
+            threads_finished = wait_for_threads();
+            instructions += g_process->thread_instructions;
+            if ( 0 != g_record_file ) // not closed, since abandoned threads may still record
+                fflush( g_record_file );
+            stop_profiler();
+            if ( translationCache )
+                save_translation_cache( *cpu );
+#ifndef _WIN32
+            if ( -1 != g_job_socket ) // a job counts from when the server forked it
+            {
+                tStart = g_job_start;
+                instructions -= g_job_base_instructions;
+                report_job( showPerformance, instructions );
+            }
+#endif
+#endif
+#if !defined( OLDGCC ) && !defined( __mc68000__ )
+            sync_file_mappings( 0, (REG_TYPE) -1, false ); // copied MAP_SHARED data is written even if the app didn't munmap
+#endif
 
             char ac[ 100 ];
-            if ( showPerformance )
+            if ( showPerformance && performanceJson )
+            {
+                int64_t totalTime = duration_cast<std::chrono::milliseconds>( high_resolution_clock::now() - tStart ).count();
+                uint64_t jitBlocks = 0;
+#ifdef ARMOS
+                jitBlocks = cpu->jit_blocks_compiled();
+#endif
+                show_performance_json( acApp, totalTime, instructions, g_process->exit_code, jitBlocks );
+            }
+            else if ( showPerformance )
             {
                 high_resolution_clock::time_point tDone = high_resolution_clock::now();
                 int64_t totalTime = duration_cast<std::chrono::milliseconds>( tDone - tStart ).count();
@@ -9091,13 +14589,46 @@ int main( int argc, char * argv[] )
                 printf( "instructions:          %15s\n", CDJLTrace::RenderNumberWithCommas( instructions, ac ) );
                 if ( 0 != totalTime )
                     printf( "effective clock rate:  %15s\n", CDJLTrace::RenderNumberWithCommas( instructions / totalTime, ac ) );
-                printf( "app exit code:         %15d\n", g_exit_code );
+                printf( "app exit code:         %15d\n", g_process->exit_code );
+#ifdef ARMOS
+                if ( jit )
+                    printf( "jit blocks compiled:   %15s\n", CDJLTrace::RenderNumberWithCommas( cpu->jit_blocks_compiled(), ac ) );
+                if ( predecode )
+                {
+                    for ( uint32_t i = 0; i < Arm64::fi_count; i++ )
+                    {
+                        char label[ 40 ];
+                        snprintf( label, sizeof( label ), "fused %s:", Arm64::fused_idiom_name( i ) );
+                        printf( "%-22s %15s\n", label, CDJLTrace::RenderNumberWithCommas( cpu->fused_idiom_count( i ), ac ) );
+                    }
+                }
+                if ( g_host_routines )
+                    show_host_routine_calls();
+                printf( "highwater brk heap:    %15s\n", CDJLTrace::RenderNumberWithCommas( g_process->highwater_brk - g_process->end_of_data, ac ) );
+                printf( "highwater mmap arena:  %15s\n", CDJLTrace::RenderNumberWithCommas( g_process->mmap_arena.peak_usage(), ac ) );
+                printf( "committed guest RAM:   %15s\n", CDJLTrace::RenderNumberWithCommas( g_process->vm_memory.committed_bytes(), ac ) );
+                if ( g_large_pages && !g_process->vm_memory.large_pages() )
+                    printf( "large pages:           %15s\n", "not available" );
+                else if ( g_large_pages )
+                    printf( "large page bytes:      %15s\n", CDJLTrace::RenderNumberWithCommas( g_process->vm_memory.large_page_bytes(), ac ) );
+#endif
+                show_syscall_stats();
+            }
+
+#ifdef ARMOS
+            if ( g_show_instruction_mix && threads_finished ) // abandoned threads may still be using the tracer
+                show_instruction_mix( *cpu );
+            if ( threads_finished )
+            {
+                write_branch_profile( *cpu );
+                show_memory_model();
             }
+#endif
 
-            tracer.Trace( "highwater brk heap:  %15s\n", CDJLTrace::RenderNumberWithCommas( g_highwater_brk - g_end_of_data, ac ) );
-            g_mmap.trace_allocations();
-            tracer.Trace( "highwater mmap heap: %15s\n", CDJLTrace::RenderNumberWithCommas( g_mmap.peak_usage(), ac ) );
-            tracer.Trace( "app exit code: %d\n", g_exit_code );
+            tracer.Trace( "highwater brk heap:  %15s\n", CDJLTrace::RenderNumberWithCommas( g_process->highwater_brk - g_process->end_of_data, ac ) );
+            g_process->mmap_arena.trace_allocations();
+            tracer.Trace( "highwater mmap heap: %15s\n", CDJLTrace::RenderNumberWithCommas( g_process->mmap_arena.peak_usage(), ac ) );
+            tracer.Trace( "app exit code: %d\n", g_process->exit_code );
         }
     }
     catch ( bad_alloc & e )
@@ -9115,5 +14646,191 @@ int main( int argc, char * argv[] )
 
     g_consoleConfig.RestoreConsole( false );
     tracer.Shutdown();
-    return g_exit_code;
+
+#ifdef ARMOS
+    if ( !threads_finished ) // global destructors would free guest memory out from under them
+    {
+        fflush( stdout );
+        _exit( g_process->exit_code );
+    }
+#endif
+
+    return g_process->exit_code;
 } //main
+
+#endif //ARMOS_EMBED
+
+#ifdef ARMOS
+
+// the embedding API in armos_embed.hxx. each call points this host thread's g_process at the guest for its duration
+
+ArmosGuest::ArmosGuest() : process( new EmulatedProcess() ), pcpu( 0 ), executed( 0 ), started( false ), finished( false ),
+                           threads_finished( true )
+{
+    uint16_t tst = 1;
+    g_hostIsLittleEndian = ( 1 & ( * (uint8_t *) &tst ) );
+    process->embedded = true;
+} //ArmosGuest
+
+ArmosGuest::~ArmosGuest()
+{
+    if ( !threads_finished ) // abandoned threads may still be using the cpu and guest memory
+        return;
+
+    delete pcpu;
+
+#if !defined( _WIN32 )
+    if ( process->symbols_pending )
+    {
+        munmap( process->symbol_view.base, process->symbol_view.length );
+        munmap( process->string_view.base, process->string_view.length );
+    }
+#endif
+
+    for ( map<REG_TYPE, FileMapping>::iterator it = process->file_mappings.begin(); it != process->file_mappings.end(); it++ )
+        if ( -1 != it->second.fd )
+            close( it->second.fd );
+
+    delete process;
+} //~ArmosGuest
+
+void ArmosGuest::set_memory_limits( uint64_t stack_bytes, uint64_t brk_bytes, uint64_t mmap_bytes )
+{
+    process->stack_commit = round_up( stack_bytes, (uint64_t) 16 );
+    process->brk_commit = round_up( brk_bytes, (uint64_t) 4096 );
+    process->mmap_commit = round_up( mmap_bytes, (uint64_t) 4096 );
+} //set_memory_limits
+
+void ArmosGuest::set_syscall_hook( SyscallHook hook, void * context )
+{
+    process->syscall_hook = hook;
+    process->syscall_hook_context = context;
+} //set_syscall_hook
+
+int ArmosGuest::exit_code() const
+{
+    return process->exit_code;
+} //exit_code
+
+const char * ArmosGuest::fault_message() const
+{
+    return process->fault.c_str();
+} //fault_message
+
+bool ArmosGuest::load( const void * image, size_t image_size, const char * app_name, const char * app_args, const vector<string> & env )
+{
+    if ( 0 != pcpu )
+    {
+        process->fault = "an app is already loaded";
+        return false;
+    }
+
+    // load_image reads the image with stdio. it can't map segments from a memory stream, so they're copied
+
+#ifdef _WIN32
+    FILE * fp = tmpfile();
+    if ( ( 0 != fp ) && ( ( image_size != fwrite( image, 1, image_size, fp ) ) || ( 0 != fseek( fp, 0, SEEK_SET ) ) ) )
+    {
+        fclose( fp );
+        fp = 0;
+    }
+#else
+    FILE * fp = ( 0 == image_size ) ? 0 : fmemopen( (void *) image, image_size, "rb" );
+#endif
+
+    if ( 0 == fp )
+    {
+        process->fault = "the image can't be read";
+        return false;
+    }
+
+    EmulatedProcess * previous = g_process;
+    FaultJump * previous_jump = g_fault_jump;
+    g_process = process;
+    g_process->app_env = env;
+
+    bool ok = false;
+    FaultJump jump;
+    if ( 0 == FAULT_SETJMP( jump ) )
+    {
+        g_fault_jump = &jump;
+        ok = load_image( app_name, app_args, fp );
+    }
+
+    g_fault_jump = previous_jump;
+    fclose( fp );
+
+    if ( ok )
+    {
+        pcpu = new CPUClass( g_process->vm_memory, g_process->base_address, g_process->execution_address, g_process->stack_commit, g_process->top_of_stack );
+        pcpu->enable_predecode( true );
+    }
+    else if ( process->fault.empty() )
+        process->fault = "the image can't be loaded";
+
+    g_process = previous;
+    return ok;
+} //load
+
+ArmosGuest::RunResult ArmosGuest::run( uint64_t max_instructions )
+{
+    if ( 0 == pcpu )
+    {
+        if ( process->fault.empty() )
+            process->fault = "no app is loaded";
+        return run_fault;
+    }
+
+    if ( finished )
+        return process->fault.empty() ? run_exited : run_fault;
+
+    EmulatedProcess * previous = g_process;
+    FaultJump * previous_jump = g_fault_jump;
+    CPUClass * previous_fault_cpu = g_fault_cpu;
+    g_process = process;
+    g_tid = 1;
+    g_clear_child_tid = 0;
+    install_guard_fault_handler( pcpu );
+    if ( !started )
+        g_process->app_start = high_resolution_clock::now();
+    started = true;
+
+    {
+        lock_guard<mutex> lock( g_process->thread_mutex );
+        g_process->main_cpu = pcpu;
+    }
+
+    Arm64::StopReason reason = Arm64::stop_ended;
+    FaultJump jump;
+    if ( 0 == FAULT_SETJMP( jump ) )
+    {
+        g_fault_jump = &jump;
+        reason = pcpu->run( max_instructions );
+    }
+    else
+    {
+        reason = Arm64::stop_ended;
+        g_process->exit_code = 1;
+        end_all_threads();
+    }
+
+    g_fault_jump = previous_jump;
+    g_fault_cpu = previous_fault_cpu;
+
+    RunResult result = ( Arm64::stop_budget == reason ) ? run_budget : run_svc;
+    if ( Arm64::stop_ended == reason )
+    {
+        finished = true;
+        threads_finished = wait_for_threads();
+#if !defined( OLDGCC ) && !defined( __mc68000__ )
+        sync_file_mappings( 0, (REG_TYPE) -1, false );
+#endif
+        result = process->fault.empty() ? run_exited : run_fault;
+    }
+
+    executed = pcpu->cycles + g_process->thread_instructions;
+    g_process = previous;
+    return result;
+} //run
+
+#endif //ARMOS
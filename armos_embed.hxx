@@ -0,0 +1,65 @@
+#pragma once
+
+// Runs Linux Arm64 apps inside a host program. Each ArmosGuest is an emulated process with its own memory, brk and
+// mmap heaps, threads, and symbols, so many can run at once, each on its own host thread. Build armos.cxx, arm64.cxx,
+// and arm64jit.cxx with -DARMOS -DARMOS_EMBED to leave out armos' main().
+// Guests share the host's file descriptors, current directory, console, and tracer.
+//
+//     ArmosGuest guest;
+//     if ( guest.load( image, image_size, "app", "arg1 arg2", env ) && ( ArmosGuest::run_exited == guest.run() ) )
+//         printf( "exit code %d\n", guest.exit_code() );
+//
+// With an instruction budget, run() returns run_budget when the budget is used up and can be called again, from any
+// host thread, to continue. That lets a few host threads take turns running many guests. The budget applies to the
+// app's main thread; threads the app creates run on host threads of their own.
+
+#include <stdint.h>
+#include <assert.h>
+#include <string>
+#include <vector>
+
+#include "arm64.hxx"
+
+struct EmulatedProcess;
+
+class ArmosGuest
+{
+    public:
+        enum RunResult { run_exited, run_fault, run_budget, run_svc };
+
+        // called with the cpu stopped at an svc instruction before the emulator handles the syscall in x8. return true
+        // to skip the emulator, after setting x0 to the result. the pc is advanced past the svc either way. calls from
+        // an app's threads are serialized like its syscalls. a hook that can't answer right away can call
+        // cpu.yield_svc() so run() returns run_svc, and set x0 before calling run() again
+
+        typedef bool ( * SyscallHook )( void * context, Arm64 & cpu, uint64_t syscall_id );
+
+        ArmosGuest();
+        ~ArmosGuest();
+
+        void set_memory_limits( uint64_t stack_bytes, uint64_t brk_bytes, uint64_t mmap_bytes ); // before load()
+        void set_syscall_hook( SyscallHook hook, void * context );
+
+        // app_args are space-separated like armos' command line. env strings are NAME=value. false if the image
+        // can't be loaded; fault_message() has the reason
+
+        bool load( const void * image, size_t image_size, const char * app_name, const char * app_args,
+                   const std::vector<std::string> & env );
+
+        RunResult run( uint64_t max_instructions = 0 ); // until the app exits or faults, or the budget (0 for none) runs out
+        int exit_code() const;
+        const char * fault_message() const;   // why load() failed or run() returned run_fault
+        uint64_t instructions() const { return executed; }
+        Arm64 * cpu() { return pcpu; }
+
+    private:
+        EmulatedProcess * process;
+        Arm64 * pcpu;
+        uint64_t executed;
+        bool started;
+        bool finished;                        // the app exited or faulted
+        bool threads_finished;                // false if threads were abandoned still running; the process is leaked
+
+        ArmosGuest( const ArmosGuest & );
+        ArmosGuest & operator = ( const ArmosGuest & );
+};
@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+// floating point kernels that compilers vectorize with NEON at -O2 and above: saxpy, a dot product, a matrix
+// multiply, and a 3-point stencil. an iteration scale can be passed as argv[1]. results are printed so they're checked
+
+#define N 4096
+#define M 64
+
+static float xf[ N ], yf[ N ];
+static double a[ M ][ M ], b[ M ][ M ], c[ M ][ M ];
+static double s0[ N ], s1[ N ];
+
+static void saxpy( float alpha, const float * x, float * y, int n )
+{
+    for ( int i = 0; i < n; i++ )
+        y[ i ] = alpha * x[ i ] + y[ i ];
+} //saxpy
+
+static double dot( const double * x, const double * y, int n )
+{
+    double sum = 0.0;
+    for ( int i = 0; i < n; i++ )
+        sum += x[ i ] * y[ i ];
+    return sum;
+} //dot
+
+static void matmul()
+{
+    for ( int i = 0; i < M; i++ )
+        for ( int j = 0; j < M; j++ )
+            c[ i ][ j ] = 0.0;
+
+    for ( int i = 0; i < M; i++ )
+        for ( int k = 0; k < M; k++ )
+        {
+            double aik = a[ i ][ k ];
+            for ( int j = 0; j < M; j++ )
+                c[ i ][ j ] += aik * b[ k ][ j ];
+        }
+} //matmul
+
+static void stencil( const double * in, double * out, int n )
+{
+    for ( int i = 1; i < n - 1; i++ )
+        out[ i ] = 0.25 * in[ i - 1 ] + 0.5 * in[ i ] + 0.25 * in[ i + 1 ];
+} //stencil
+
+extern "C" int main( int argc, char * argv[] )
+{
+    int scale = ( argc > 1 ) ? atoi( argv[ 1 ] ) : 1;
+    if ( scale <= 0 )
+        scale = 1;
+
+    for ( int i = 0; i < N; i++ )
+    {
+        xf[ i ] = (float) ( i % 17 ) * 0.125f;
+        yf[ i ] = (float) ( i % 13 ) * 0.25f;
+        s0[ i ] = sin( (double) i * 0.01 );
+    }
+
+    for ( int i = 0; i < M; i++ )
+        for ( int j = 0; j < M; j++ )
+        {
+            a[ i ][ j ] = (double) ( ( i * j ) % 7 ) - 3.0;
+            b[ i ][ j ] = (double) ( ( i + j ) % 5 ) * 0.5;
+        }
+
+    for ( int r = 0; r < 200 * scale; r++ )
+        saxpy( 1.0001f, xf, yf, N );
+
+    double d = 0.0;
+    for ( int r = 0; r < 200 * scale; r++ )
+        d += dot( s0, s0, N );
+
+    for ( int r = 0; r < 10 * scale; r++ )
+        matmul();
+
+    for ( int r = 0; r < 100 * scale; r++ )
+    {
+        stencil( s0, s1, N );
+        stencil( s1, s0, N );
+    }
+
+    double ysum = 0.0, csum = 0.0, ssum = 0.0;
+    for ( int i = 0; i < N; i++ )
+    {
+        ysum += yf[ i ];
+        ssum += s0[ i ];
+    }
+    for ( int i = 0; i < M; i++ )
+        for ( int j = 0; j < M; j++ )
+            csum += c[ i ][ j ];
+
+    printf( "saxpy %.6e dot %.6e matmul %.6e stencil %.6e\n", ysum, d, csum, ssum );
+    printf( "fpkernel completed with great success\n" );
+    return 0;
+} //main
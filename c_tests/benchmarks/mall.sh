@@ -0,0 +1,25 @@
+#!/bin/bash
+
+# builds the benchmarks with g++ and clang at -O3 into bin and clangbin. sieve, nqueens, and ba come from
+# c_tests. CoreMark is built too if it's checked out here: git clone https://github.com/eembc/coremark
+
+mkdir bin 2>/dev/null
+mkdir clangbin 2>/dev/null
+
+for arg in memops fpkernel pairs tsyscall ../sieve ../nqueens ../ba;
+do
+    _name=$(basename $arg)
+    echo $_name
+    clang-18 -x c++ "$arg".c -o clangbin/"$_name" -O3 -static -Wno-implicit-const-int-float-conversion -fsigned-char -Wno-format -Wno-format-security -std=c++14 -lm -lstdc++ &
+    g++ "$arg".c -o bin/"$_name" -O3 -static -fsigned-char -Wno-format -Wno-format-security &
+done
+
+if [ -d coremark ]; then
+    echo coremark
+    _coremark="coremark/core_list_join.c coremark/core_main.c coremark/core_matrix.c coremark/core_state.c coremark/core_util.c coremark/posix/core_portme.c"
+    gcc -O3 -Icoremark -Icoremark/posix -DITERATIONS=1000 -DFLAGS_STR=\"-O3\" $_coremark -o bin/coremark -static &
+    clang-18 -O3 -Icoremark -Icoremark/posix -DITERATIONS=1000 -DFLAGS_STR=\"-O3\" $_coremark -o clangbin/coremark -static &
+fi
+
+echo "Waiting for all processes to complete..."
+wait
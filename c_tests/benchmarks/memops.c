@@ -0,0 +1,82 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+// measures memcpy, memset, and strlen across sizes from a few bytes to larger than typical caches. an iteration
+// scale can be passed as argv[1]. the checksum keeps the compiler from removing the work and catches wrong results
+
+static long long now_ns()
+{
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (long long) ts.tv_sec * 1000000000 + ts.tv_nsec;
+} //now_ns
+
+static void report( const char * name, size_t size, long long start, long long bytes )
+{
+    long long elapsed = now_ns() - start;
+    if ( 0 == elapsed )
+        elapsed = 1;
+    printf( "%-8s %8zu bytes %10lld MB/s\n", name, size, ( bytes * 1000 ) / elapsed );
+} //report
+
+extern "C" int main( int argc, char * argv[] )
+{
+    int scale = ( argc > 1 ) ? atoi( argv[ 1 ] ) : 1;
+    if ( scale <= 0 )
+        scale = 1;
+
+    const size_t sizes[] = { 16, 256, 4096, 65536, 1048576 };
+    const size_t largest = 1048576;
+    const long long total = 32 * 1048576; // bytes moved per size and operation
+
+    char * src = (char *) malloc( largest + 64 );
+    char * dst = (char *) malloc( largest + 64 );
+    for ( size_t i = 0; i < largest; i++ )
+        src[ i ] = (char) ( 'a' + ( i % 26 ) );
+    src[ largest ] = 0;
+
+    uint64_t checksum = 0;
+
+    for ( size_t s = 0; s < sizeof( sizes ) / sizeof( sizes[ 0 ] ); s++ )
+    {
+        size_t size = sizes[ s ];
+        long long iterations = ( total * scale ) / size;
+
+        long long start = now_ns();
+        for ( long long i = 0; i < iterations; i++ )
+        {
+            size_t offset = (size_t) ( i & 7 ); // vary the alignment
+            memcpy( dst + offset, src + ( ( i >> 3 ) & 7 ), size );
+            checksum += (unsigned char) dst[ offset + size - 1 ];
+        }
+        report( "memcpy", size, start, iterations * size );
+
+        start = now_ns();
+        for ( long long i = 0; i < iterations; i++ )
+        {
+            memset( dst + ( i & 7 ), (int) ( i & 0xff ), size );
+            checksum += (unsigned char) dst[ size / 2 ];
+        }
+        report( "memset", size, start, iterations * size );
+
+        memcpy( dst, src, size );
+        dst[ size - 1 ] = 0;
+        start = now_ns();
+        for ( long long i = 0; i < iterations; i++ )
+        {
+            dst[ size - 1 - ( i & 1 ) ] = 0; // a store so the length isn't hoisted out of the loop
+            checksum += strlen( dst );
+            dst[ size - 1 - ( i & 1 ) ] = 'x';
+        }
+        report( "strlen", size, start, iterations * size );
+    }
+
+    free( src );
+    free( dst );
+    printf( "checksum %llu\n", (unsigned long long) checksum );
+    printf( "memops completed with great success\n" );
+    return 0;
+} //main
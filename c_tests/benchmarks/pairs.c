@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+// exercises the code compilers emit ldp and stp for: saving callee-saved registers in calls, copying 16-byte
+// structs, and walking arrays of pairs. an iteration scale can be passed as argv[1]. the checksum keeps the
+// compiler from removing the work and catches wrong results
+
+struct Pair
+{
+    uint64_t a;
+    uint64_t b;
+};
+
+static long long now_ns()
+{
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (long long) ts.tv_sec * 1000000000 + ts.tv_nsec;
+} //now_ns
+
+static void report( const char * name, long long start, long long operations )
+{
+    long long elapsed = now_ns() - start;
+    if ( 0 == elapsed )
+        elapsed = 1;
+    printf( "%-10s %10lld ns per 1000 operations\n", name, ( elapsed * 1000 ) / operations );
+} //report
+
+// enough live values across the recursive calls that callee-saved registers are saved and restored in pairs
+
+__attribute__((noinline)) static uint64_t spill( uint64_t depth, uint64_t x, uint64_t y, uint64_t z )
+{
+    if ( 0 == depth )
+        return x ^ y ^ z;
+
+    uint64_t p = x * 3 + y;
+    uint64_t q = y * 5 + z;
+    uint64_t r = z * 7 + x;
+    uint64_t s = spill( depth - 1, q, r, p );
+    return s + p + q + r + depth;
+} //spill
+
+__attribute__((noinline)) static void copy_pairs( Pair * dst, const Pair * src, size_t count )
+{
+    for ( size_t i = 0; i < count; i++ )
+        dst[ i ] = src[ i ];
+} //copy_pairs
+
+__attribute__((noinline)) static uint64_t sum_pairs( const Pair * p, size_t count )
+{
+    uint64_t sum = 0;
+    for ( size_t i = 0; i < count; i++ )
+        sum += p[ i ].a * p[ i ].b;
+    return sum;
+} //sum_pairs
+
+extern "C" int main( int argc, char * argv[] )
+{
+    int scale = ( argc > 1 ) ? atoi( argv[ 1 ] ) : 1;
+    if ( scale <= 0 )
+        scale = 1;
+
+    const size_t count = 1024;
+    Pair * src = (Pair *) malloc( count * sizeof( Pair ) );
+    Pair * dst = (Pair *) malloc( count * sizeof( Pair ) );
+    if ( 0 == src || 0 == dst )
+    {
+        printf( "out of memory\n" );
+        return 1;
+    }
+
+    for ( size_t i = 0; i < count; i++ )
+    {
+        src[ i ].a = i;
+        src[ i ].b = i * 2 + 1;
+    }
+
+    uint64_t checksum = 0;
+    int calls = 20000 * scale;
+    long long start = now_ns();
+    for ( int i = 0; i < calls; i++ )
+        checksum += spill( 20, i, i + 1, i + 2 );
+    report( "calls", start, (long long) calls * 21 );
+
+    int copies = 2000 * scale;
+    start = now_ns();
+    for ( int i = 0; i < copies; i++ )
+    {
+        copy_pairs( dst, src, count );
+        src[ i % count ].a++;
+    }
+    report( "copy", start, (long long) copies * count );
+
+    start = now_ns();
+    for ( int i = 0; i < copies; i++ )
+    {
+        checksum += sum_pairs( dst, count );
+        dst[ i % count ].b++;
+    }
+    report( "sum", start, (long long) copies * count );
+
+    printf( "checksum %llu\n", (unsigned long long) checksum );
+    free( src );
+    free( dst );
+    printf( "pairs completed with great success\n" );
+    return 0;
+} //main
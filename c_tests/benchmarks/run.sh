@@ -0,0 +1,45 @@
+#!/bin/bash
+
+# runs the benchmarks under armos -p:json and appends a line of JSON for each to benchmarks.json, so results from
+# different hosts and emulator changes can be compared. the first argument is the emulator command: armos by default,
+# or e.g. "armos -j" for the jit or "../../armos" for a local build. build the benchmarks first with mall.sh and
+# ../../rust_tests/benchmarks/mall.sh
+
+_armoscmd="armos"
+if [ "$1" != "" ]; then
+    _armoscmd="$1"
+fi
+
+outputfile="benchmarks.json"
+
+run_benchmark()
+{
+    # $1 is the benchmark's name in the results. the rest is the app and its arguments
+
+    _name=$1
+    shift
+    if [ ! -f "$1" ]; then
+        return
+    fi
+
+    echo $_name
+    _json=$($_armoscmd -p:json "$@" | tail -n 1)
+    echo "$_json" | sed "s/^{/{\"benchmark\":\"$_name\",\"command\":\"$_armoscmd\",/" >>$outputfile
+}
+
+for compiler in bin clangbin;
+do
+    run_benchmark $compiler/coremark $compiler/coremark
+    run_benchmark $compiler/sieve $compiler/sieve
+    run_benchmark $compiler/nqueens $compiler/nqueens
+    run_benchmark $compiler/memops $compiler/memops
+    run_benchmark $compiler/tsyscall $compiler/tsyscall 20000
+    run_benchmark $compiler/fpkernel $compiler/fpkernel
+    run_benchmark $compiler/pairs $compiler/pairs
+    run_benchmark $compiler/ba $compiler/ba ../tp.bas
+done
+
+for arg in sieve fpkernel;
+do
+    run_benchmark rust/$arg ../../rust_tests/benchmarks/bin/$arg
+done
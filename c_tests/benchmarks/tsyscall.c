@@ -0,0 +1,77 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+// measures the round-trip cost of the syscalls apps make most often. an iteration count can be passed as argv[1]
+
+static long long now_ns()
+{
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (long long) ts.tv_sec * 1000000000 + ts.tv_nsec;
+} //now_ns
+
+static void report( const char * name, long long start, int iterations )
+{
+    long long elapsed = now_ns() - start;
+    printf( "%-16s %10lld ns per call\n", name, elapsed / iterations );
+} //report
+
+extern "C" int main( int argc, char * argv[] )
+{
+    int iterations = ( argc > 1 ) ? atoi( argv[ 1 ] ) : 100000;
+    if ( iterations <= 0 )
+        iterations = 100000;
+
+    const char * filename = "tsyscall.tmp";
+    int fd = open( filename, O_CREAT | O_RDWR | O_TRUNC, 0666 );
+    if ( -1 == fd )
+    {
+        printf( "can't create %s\n", filename );
+        return 1;
+    }
+
+    char c = 'a';
+    long long start = now_ns();
+    for ( int i = 0; i < iterations; i++ )
+        write( fd, &c, 1 );
+    report( "write 1 byte", start, iterations );
+
+    lseek( fd, 0, SEEK_SET );
+    start = now_ns();
+    for ( int i = 0; i < iterations; i++ )
+        read( fd, &c, 1 );
+    report( "read 1 byte", start, iterations );
+
+    struct timespec ts;
+    start = now_ns();
+    for ( int i = 0; i < iterations; i++ )
+        syscall( SYS_clock_gettime, CLOCK_MONOTONIC, &ts ); // not clock_gettime(), which may not make a syscall
+    report( "clock_gettime", start, iterations );
+
+    start = now_ns();
+    for ( int i = 0; i < iterations; i++ )
+        syscall( SYS_brk, 0 ); // sbrk( 0 ) is answered by the C runtime
+    report( "brk query", start, iterations );
+
+    int futex_word = 0;
+    start = now_ns();
+    for ( int i = 0; i < iterations; i++ )
+        syscall( SYS_futex, &futex_word, FUTEX_WAKE_PRIVATE, 1, 0, 0, 0 );
+    report( "futex wake", start, iterations );
+
+    start = now_ns();
+    for ( int i = 0; i < iterations; i++ )
+        syscall( SYS_getpid ); // not a fast-path syscall, for comparison
+    report( "getpid", start, iterations );
+
+    close( fd );
+    unlink( filename );
+    printf( "tsyscall completed with great success\n" );
+    return 0;
+} //main
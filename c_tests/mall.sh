@@ -3,7 +3,7 @@
 for arg in tcmp t e printint sieve simple tmuldiv tpi ts tarray tbits trw trw2 tmmap tstr \
            tdir fileops ttime tm glob tap tsimplef tphi tf ttt td terrno t_setjmp tex \
            tprintf pis mm tao ttypes nantst sleeptm tatomic lenum tregex trename \
-           nqueens ff an ba tgets fopentst targs;
+           nqueens ff an ba tgets fopentst targs tauxv tfork tsocket tnested tvdso tcrypto tlse;
 do
     echo $arg
     for optflag in 0 1 2 3 fast;
@@ -0,0 +1,35 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/auxv.h>
+
+// reads the aux records the loader passes. glibc's stack protector and pointer guard and Go's runtime read the
+// 16 bytes at AT_RANDOM before main, so they must be in mapped memory
+
+extern "C" int main( int argc, char * argv[] )
+{
+    const uint8_t * prandom = (const uint8_t *) getauxval( AT_RANDOM );
+    if ( 0 == prandom )
+    {
+        printf( "no AT_RANDOM aux record\n" );
+        return 1;
+    }
+
+    uint8_t bytes[ 16 ];
+    memcpy( bytes, prandom, sizeof( bytes ) );
+    int nonzero = 0;
+    for ( size_t i = 0; i < sizeof( bytes ); i++ )
+        if ( 0 != bytes[ i ] )
+            nonzero++;
+
+    if ( 0 == nonzero ) // 1 in 2^128
+    {
+        printf( "AT_RANDOM bytes are all zero\n" );
+        return 1;
+    }
+
+    printf( "AT_RANDOM is readable\n" );
+    printf( "page size: %lu\n", getauxval( AT_PAGESZ ) );
+    printf( "tauxv completed with great success\n" );
+    return 0;
+} //main
@@ -0,0 +1,273 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/auxv.h>
+
+// known-answer tests of the crc32, aes, pmull, sha1, and sha256 instructions. they're used through inline asm so
+// the test builds without -march flags; each routine enables the extensions for the assembler itself
+
+typedef uint32_t v128 __attribute__(( vector_size( 16 ) ));
+
+#define CRYPTO ".arch armv8-a+crc+crypto\n\t"
+
+static uint32_t crc32b( uint32_t crc, uint8_t x ) { __asm__( CRYPTO "crc32b %w0, %w0, %w1" : "+r" ( crc ) : "r" ( x ) ); return crc; }
+static uint32_t crc32h( uint32_t crc, uint16_t x ) { __asm__( CRYPTO "crc32h %w0, %w0, %w1" : "+r" ( crc ) : "r" ( x ) ); return crc; }
+static uint32_t crc32w( uint32_t crc, uint32_t x ) { __asm__( CRYPTO "crc32w %w0, %w0, %w1" : "+r" ( crc ) : "r" ( x ) ); return crc; }
+static uint32_t crc32x( uint32_t crc, uint64_t x ) { __asm__( CRYPTO "crc32x %w0, %w0, %x1" : "+r" ( crc ) : "r" ( x ) ); return crc; }
+static uint32_t crc32cb( uint32_t crc, uint8_t x ) { __asm__( CRYPTO "crc32cb %w0, %w0, %w1" : "+r" ( crc ) : "r" ( x ) ); return crc; }
+static uint32_t crc32ch( uint32_t crc, uint16_t x ) { __asm__( CRYPTO "crc32ch %w0, %w0, %w1" : "+r" ( crc ) : "r" ( x ) ); return crc; }
+static uint32_t crc32cw( uint32_t crc, uint32_t x ) { __asm__( CRYPTO "crc32cw %w0, %w0, %w1" : "+r" ( crc ) : "r" ( x ) ); return crc; }
+static uint32_t crc32cx( uint32_t crc, uint64_t x ) { __asm__( CRYPTO "crc32cx %w0, %w0, %x1" : "+r" ( crc ) : "r" ( x ) ); return crc; }
+
+static v128 aese( v128 s, v128 k ) { __asm__( CRYPTO "aese %0.16b, %1.16b" : "+w" ( s ) : "w" ( k ) ); return s; }
+static v128 aesd( v128 s, v128 k ) { __asm__( CRYPTO "aesd %0.16b, %1.16b" : "+w" ( s ) : "w" ( k ) ); return s; }
+static v128 aesmc( v128 s ) { v128 r; __asm__( CRYPTO "aesmc %0.16b, %1.16b" : "=w" ( r ) : "w" ( s ) ); return r; }
+static v128 aesimc( v128 s ) { v128 r; __asm__( CRYPTO "aesimc %0.16b, %1.16b" : "=w" ( r ) : "w" ( s ) ); return r; }
+
+static v128 pmull( v128 a, v128 b ) { v128 r; __asm__( CRYPTO "pmull %0.1q, %1.1d, %2.1d" : "=w" ( r ) : "w" ( a ), "w" ( b ) ); return r; }
+static v128 pmull2( v128 a, v128 b ) { v128 r; __asm__( CRYPTO "pmull2 %0.1q, %1.2d, %2.2d" : "=w" ( r ) : "w" ( a ), "w" ( b ) ); return r; }
+
+static v128 sha1c( v128 abcd, v128 e, v128 w ) { __asm__( CRYPTO "sha1c %q0, %s1, %2.4s" : "+w" ( abcd ) : "w" ( e ), "w" ( w ) ); return abcd; }
+static v128 sha1p( v128 abcd, v128 e, v128 w ) { __asm__( CRYPTO "sha1p %q0, %s1, %2.4s" : "+w" ( abcd ) : "w" ( e ), "w" ( w ) ); return abcd; }
+static v128 sha1m( v128 abcd, v128 e, v128 w ) { __asm__( CRYPTO "sha1m %q0, %s1, %2.4s" : "+w" ( abcd ) : "w" ( e ), "w" ( w ) ); return abcd; }
+static v128 sha1h( v128 e ) { v128 r; __asm__( CRYPTO "sha1h %s0, %s1" : "=w" ( r ) : "w" ( e ) ); return r; }
+static v128 sha1su0( v128 a, v128 b, v128 c ) { __asm__( CRYPTO "sha1su0 %0.4s, %1.4s, %2.4s" : "+w" ( a ) : "w" ( b ), "w" ( c ) ); return a; }
+static v128 sha1su1( v128 a, v128 b ) { __asm__( CRYPTO "sha1su1 %0.4s, %1.4s" : "+w" ( a ) : "w" ( b ) ); return a; }
+
+static v128 sha256h( v128 abcd, v128 efgh, v128 w ) { __asm__( CRYPTO "sha256h %q0, %q1, %2.4s" : "+w" ( abcd ) : "w" ( efgh ), "w" ( w ) ); return abcd; }
+static v128 sha256h2( v128 efgh, v128 abcd, v128 w ) { __asm__( CRYPTO "sha256h2 %q0, %q1, %2.4s" : "+w" ( efgh ) : "w" ( abcd ), "w" ( w ) ); return efgh; }
+static v128 sha256su0( v128 a, v128 b ) { __asm__( CRYPTO "sha256su0 %0.4s, %1.4s" : "+w" ( a ) : "w" ( b ) ); return a; }
+static v128 sha256su1( v128 a, v128 b, v128 c ) { __asm__( CRYPTO "sha256su1 %0.4s, %1.4s, %2.4s" : "+w" ( a ) : "w" ( b ), "w" ( c ) ); return a; }
+
+static v128 load128( const void * p ) { v128 v; memcpy( &v, p, sizeof( v ) ); return v; }
+
+static void print_bytes( const char * label, const void * p, size_t len )
+{
+    printf( "%s", label );
+    for ( size_t i = 0; i < len; i++ )
+        printf( "%02x", ( (const uint8_t *) p )[ i ] );
+    printf( "\n" );
+} //print_bytes
+
+static bool check_crc32()
+{
+    // the standard check value is the crc of "123456789". each width has to give the same result
+
+    const uint8_t * data = (const uint8_t *) "123456789";
+    uint32_t b = 0xffffffff, cb = 0xffffffff;
+    for ( int i = 0; i < 9; i++ )
+    {
+        b = crc32b( b, data[ i ] );
+        cb = crc32cb( cb, data[ i ] );
+    }
+
+    uint64_t x8;
+    memcpy( &x8, data, 8 );
+    uint32_t x = crc32b( crc32x( 0xffffffff, x8 ), data[ 8 ] );
+    uint32_t cx = crc32cb( crc32cx( 0xffffffff, x8 ), data[ 8 ] );
+
+    uint16_t h0, h1;
+    uint32_t w;
+    memcpy( &h0, data, 2 );
+    memcpy( &w, data + 2, 4 );
+    memcpy( &h1, data + 6, 2 );
+    uint32_t hw = crc32b( crc32h( crc32w( crc32h( 0xffffffff, h0 ), w ), h1 ), data[ 8 ] );
+    uint32_t chw = crc32cb( crc32ch( crc32cw( crc32ch( 0xffffffff, h0 ), w ), h1 ), data[ 8 ] );
+
+    printf( "crc32:  %08x %08x %08x\n", ~b, ~x, ~hw );
+    printf( "crc32c: %08x %08x %08x\n", ~cb, ~cx, ~chw );
+    return ( 0xcbf43926 == ~b ) && ( ~b == ~x ) && ( ~b == ~hw ) && ( 0xe3069283 == ~cb ) && ( ~cb == ~cx ) && ( ~cb == ~chw );
+} //check_crc32
+
+static bool check_aes()
+{
+    // fips-197 appendix c.1. SubWord() for the key schedule is aese with a zero key on a word in every column,
+    // since ShiftRows then has nothing to move
+
+    static const uint8_t key[ 16 ] = { 0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15 };
+    static const uint8_t plain[ 16 ] = { 0x00,0x11,0x22,0x33,0x44,0x55,0x66,0x77,0x88,0x99,0xaa,0xbb,0xcc,0xdd,0xee,0xff };
+    static const uint8_t expected[ 16 ] = { 0x69,0xc4,0xe0,0xd8,0x6a,0x7b,0x04,0x30,0xd8,0xcd,0xb7,0x80,0x70,0xb4,0xc5,0x5a };
+
+    uint32_t words[ 44 ];
+    memcpy( words, key, sizeof( key ) );
+    uint32_t rcon = 1;
+    v128 zero = { 0, 0, 0, 0 };
+    for ( int i = 4; i < 44; i++ )
+    {
+        uint32_t t = words[ i - 1 ];
+        if ( 0 == ( i % 4 ) )
+        {
+            t = ( t >> 8 ) | ( t << 24 ); // RotWord for little-endian words
+            v128 column = { t, t, t, t };
+            t = aese( column, zero )[ 0 ] ^ rcon;
+            rcon = ( rcon << 1 ) ^ ( ( rcon & 0x80 ) ? 0x11b : 0 );
+        }
+        words[ i ] = words[ i - 4 ] ^ t;
+    }
+
+    v128 round_keys[ 11 ];
+    for ( int r = 0; r < 11; r++ )
+        round_keys[ r ] = load128( words + 4 * r );
+
+    v128 s = load128( plain );
+    for ( int r = 0; r < 9; r++ )
+        s = aesmc( aese( s, round_keys[ r ] ) );
+    s = aese( s, round_keys[ 9 ] ) ^ round_keys[ 10 ];
+
+    uint8_t cipher[ 16 ];
+    memcpy( cipher, &s, sizeof( cipher ) );
+    print_bytes( "aes-128 encrypt: ", cipher, sizeof( cipher ) );
+
+    // the equivalent inverse cipher uses InvMixColumns of the middle round keys
+
+    s = aesd( s, round_keys[ 10 ] );
+    for ( int r = 9; r > 0; r-- )
+        s = aesd( aesimc( s ), aesimc( round_keys[ r ] ) );
+    s = s ^ round_keys[ 0 ];
+
+    uint8_t decrypted[ 16 ];
+    memcpy( decrypted, &s, sizeof( decrypted ) );
+    print_bytes( "aes-128 decrypt: ", decrypted, sizeof( decrypted ) );
+    return !memcmp( cipher, expected, sizeof( expected ) ) && !memcmp( decrypted, plain, sizeof( plain ) );
+} //check_aes
+
+static bool check_pmull()
+{
+    // carry-less products of the low and high halves, checked against bit-by-bit multiplication
+
+    static const uint64_t a[ 2 ] = { 0x8000000000000001ull, 0x0123456789abcdefull };
+    static const uint64_t b[ 2 ] = { 0xfedcba9876543210ull, 0xc200000000000000ull };
+    v128 va = load128( a ), vb = load128( b );
+    v128 products[ 2 ] = { pmull( va, vb ), pmull2( va, vb ) };
+
+    bool ok = true;
+    for ( int i = 0; i < 2; i++ )
+    {
+        uint64_t lo = 0, hi = 0;
+        for ( int bit = 0; bit < 64; bit++ )
+        {
+            if ( 0 == ( b[ i ] & ( 1ull << bit ) ) )
+                continue;
+            lo ^= a[ i ] << bit;
+            hi ^= ( 0 == bit ) ? 0 : ( a[ i ] >> ( 64 - bit ) );
+        }
+
+        uint64_t result[ 2 ];
+        memcpy( result, &products[ i ], sizeof( result ) );
+        printf( "%s: %016llx%016llx\n", ( 0 == i ) ? "pmull " : "pmull2", (unsigned long long) result[ 1 ], (unsigned long long) result[ 0 ] );
+        ok = ok && ( lo == result[ 0 ] ) && ( hi == result[ 1 ] );
+    }
+    return ok;
+} //check_pmull
+
+static void message_block( const char * msg, uint32_t * w )
+{
+    // one padded block for a message under 56 bytes, as big-endian words
+
+    uint8_t block[ 64 ];
+    size_t len = strlen( msg );
+    memset( block, 0, sizeof( block ) );
+    memcpy( block, msg, len );
+    block[ len ] = 0x80;
+    block[ 63 ] = (uint8_t) ( len * 8 );
+    for ( int i = 0; i < 16; i++ )
+        w[ i ] = ( (uint32_t) block[ 4 * i ] << 24 ) | ( block[ 4 * i + 1 ] << 16 ) | ( block[ 4 * i + 2 ] << 8 ) | block[ 4 * i + 3 ];
+} //message_block
+
+static bool check_hash( const char * name, const uint32_t * h, int count, const char * expected )
+{
+    char hex[ 80 ];
+    for ( int i = 0; i < count; i++ )
+        snprintf( hex + 8 * i, sizeof( hex ) - 8 * i, "%08x", h[ i ] );
+    printf( "%s(\"abc\"): %s\n", name, hex );
+    return !strcmp( hex, expected );
+} //check_hash
+
+static bool check_sha1()
+{
+    uint32_t w[ 16 ];
+    message_block( "abc", w );
+    v128 msg[ 4 ] = { load128( w ), load128( w + 4 ), load128( w + 8 ), load128( w + 12 ) };
+    static const uint32_t k[ 4 ] = { 0x5a827999, 0x6ed9eba1, 0x8f1bbcdc, 0xca62c1d6 };
+
+    uint32_t h[ 5 ] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 };
+    v128 abcd = load128( h );
+    v128 e = { h[ 4 ], 0, 0, 0 };
+    for ( int i = 0; i < 20; i++ ) // four rounds at a time
+    {
+        v128 kv = { k[ i / 5 ], k[ i / 5 ], k[ i / 5 ], k[ i / 5 ] };
+        v128 wk = msg[ i % 4 ] + kv;
+        v128 next_e = sha1h( abcd );
+        abcd = ( i < 5 ) ? sha1c( abcd, e, wk ) : ( i >= 10 && i < 15 ) ? sha1m( abcd, e, wk ) : sha1p( abcd, e, wk );
+        e = next_e;
+        if ( i < 16 )
+            msg[ i % 4 ] = sha1su1( sha1su0( msg[ i % 4 ], msg[ ( i + 1 ) % 4 ], msg[ ( i + 2 ) % 4 ] ), msg[ ( i + 3 ) % 4 ] );
+    }
+
+    for ( int i = 0; i < 4; i++ )
+        h[ i ] += abcd[ i ];
+    h[ 4 ] += e[ 0 ];
+    return check_hash( "sha1", h, 5, "a9993e364706816aba3e25717850c26c9cd0d89d" );
+} //check_sha1
+
+static bool check_sha256()
+{
+    static const uint32_t k[ 64 ] =
+    {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+    };
+
+    uint32_t w[ 16 ];
+    message_block( "abc", w );
+    v128 msg[ 4 ] = { load128( w ), load128( w + 4 ), load128( w + 8 ), load128( w + 12 ) };
+
+    uint32_t h[ 8 ] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+    v128 abcd = load128( h ), efgh = load128( h + 4 );
+    for ( int i = 0; i < 16; i++ ) // four rounds at a time
+    {
+        v128 wk = msg[ i % 4 ] + load128( k + 4 * i );
+        if ( i < 12 )
+            msg[ i % 4 ] = sha256su1( sha256su0( msg[ i % 4 ], msg[ ( i + 1 ) % 4 ] ), msg[ ( i + 2 ) % 4 ], msg[ ( i + 3 ) % 4 ] );
+        v128 previous = abcd;
+        abcd = sha256h( abcd, efgh, wk );
+        efgh = sha256h2( efgh, previous, wk );
+    }
+
+    for ( int i = 0; i < 4; i++ )
+    {
+        h[ i ] += abcd[ i ];
+        h[ 4 + i ] += efgh[ i ];
+    }
+    return check_hash( "sha256", h, 8, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" );
+} //check_sha256
+
+extern "C" int main( int argc, char * argv[] )
+{
+    // HWCAP_AES, HWCAP_PMULL, HWCAP_SHA1, HWCAP_SHA2, and HWCAP_CRC32 tell apps they can use the instructions
+
+    unsigned long hwcap = getauxval( AT_HWCAP );
+    const unsigned long wanted = ( 1 << 3 ) | ( 1 << 4 ) | ( 1 << 5 ) | ( 1 << 6 ) | ( 1 << 7 );
+    printf( "hwcaps advertise aes, pmull, sha1, sha2, and crc32: %s\n", ( wanted == ( hwcap & wanted ) ) ? "yes" : "no" );
+
+    bool ok = check_crc32();
+    ok = check_aes() && ok;
+    ok = check_pmull() && ok;
+    ok = check_sha1() && ok;
+    ok = check_sha256() && ok;
+
+    if ( !ok )
+    {
+        printf( "tcrypto failed\n" );
+        return 1;
+    }
+
+    printf( "tcrypto completed with great success\n" );
+    return 0;
+} //main
@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+// fork, exec, wait4, and pipe2. the exec'd copy of this app checks the argument vector arrives as passed, including
+// arguments with spaces and empty ones, and that close-on-exec descriptors are gone
+
+static int wait_for( pid_t pid )
+{
+    int status = 0;
+    if ( pid != wait4( pid, &status, 0, 0 ) )
+    {
+        printf( "wait4 failed, errno %d\n", errno );
+        exit( 1 );
+    }
+
+    if ( !WIFEXITED( status ) )
+    {
+        printf( "child didn't exit normally, status %#x\n", status );
+        exit( 1 );
+    }
+
+    return WEXITSTATUS( status );
+} //wait_for
+
+static int exec_child( int argc, char * argv[] )
+{
+    printf( "exec'd child has %d arguments\n", argc );
+    if ( 5 != argc )
+        return 1;
+
+    printf( "  argument 2: '%s'\n", argv[ 2 ] );
+    printf( "  argument 3: '%s'\n", argv[ 3 ] );
+    if ( strcmp( argv[ 2 ], "a b" ) || strcmp( argv[ 3 ], "" ) )
+        return 2;
+
+    int fd = atoi( argv[ 4 ] );
+    if ( -1 != fcntl( fd, F_GETFD ) || EBADF != errno )
+    {
+        printf( "close-on-exec descriptor %d is still open\n", fd );
+        return 3;
+    }
+
+    printf( "close-on-exec pipe is closed in the exec'd child\n" );
+    return 0;
+} //exec_child
+
+extern "C" int main( int argc, char * argv[] )
+{
+    if ( ( argc > 1 ) && !strcmp( argv[ 1 ], "child" ) )
+        return exec_child( argc, argv );
+
+    int fds[ 2 ];
+    if ( 0 != pipe2( fds, O_CLOEXEC ) )
+    {
+        printf( "pipe2 failed, errno %d\n", errno );
+        return 1;
+    }
+
+    fflush( stdout ); // so the child doesn't write this process's buffered output too
+    pid_t pid = fork();
+    if ( -1 == pid )
+    {
+        printf( "fork failed, errno %d\n", errno );
+        return 1;
+    }
+
+    if ( 0 == pid )
+    {
+        close( fds[ 0 ] );
+        if ( 2 != write( fds[ 1 ], "hi", 2 ) )
+            _exit( 1 );
+        _exit( 7 );
+    }
+
+    close( fds[ 1 ] );
+    char buf[ 16 ];
+    ssize_t len = read( fds[ 0 ], buf, sizeof( buf ) );
+    printf( "pipe from child: '%.*s'\n", (int) ( ( len < 0 ) ? 0 : len ), buf );
+    printf( "child exit code: %d\n", wait_for( pid ) );
+
+    // the read end is close-on-exec, so it should be gone in the exec'd child
+
+    char fd_arg[ 16 ];
+    snprintf( fd_arg, sizeof( fd_arg ), "%d", fds[ 0 ] );
+    char * child_argv[] = { argv[ 0 ], (char *) "child", (char *) "a b", (char *) "", fd_arg, 0 };
+
+    fflush( stdout );
+    pid = fork();
+    if ( 0 == pid )
+    {
+        execv( argv[ 0 ], child_argv );
+        _exit( 100 + errno );
+    }
+
+    int code = wait_for( pid );
+    printf( "exec'd child exit code: %d\n", code );
+    close( fds[ 0 ] );
+    if ( 0 != code )
+        return 1;
+
+    printf( "tfork completed with great success\n" );
+    return 0;
+} //main
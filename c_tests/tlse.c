@@ -0,0 +1,287 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/auxv.h>
+
+// the armv8.1 lse atomics: ld<op>, swp, cas, and casp at each size and with acquire and release. each result is
+// checked against the same operation done in c, and the bytes around the target must be left alone
+
+#define LSE ".arch armv8-a+lse\n\t"
+
+// ld<op> and swp: Rs is the operand and Rt gets the old value
+
+#define ATOMIC( fn, mnemonic, T, r ) \
+    static uint64_t fn( void * p, uint64_t v ) \
+    { \
+        T old, operand = (T) v; \
+        __asm__ volatile( LSE #mnemonic " %" r "1, %" r "0, [%2]" : "=&r" ( old ) : "r" ( operand ), "r" ( p ) : "memory" ); \
+        return old; \
+    }
+
+#define ATOMIC_SIZES( op, ab, ah, aw ) \
+    ATOMIC( op##_b, ab, uint8_t, "w" ) ATOMIC( op##_h, ah, uint16_t, "w" ) ATOMIC( op##_w, aw, uint32_t, "w" ) ATOMIC( op##_x, aw, uint64_t, "x" )
+
+ATOMIC_SIZES( ldadd, ldaddb, ldaddh, ldadd )
+ATOMIC_SIZES( ldclr, ldclrb, ldclrh, ldclr )
+ATOMIC_SIZES( ldeor, ldeorb, ldeorh, ldeor )
+ATOMIC_SIZES( ldset, ldsetb, ldseth, ldset )
+ATOMIC_SIZES( ldsmax, ldsmaxb, ldsmaxh, ldsmax )
+ATOMIC_SIZES( ldsmin, ldsminb, ldsminh, ldsmin )
+ATOMIC_SIZES( ldumax, ldumaxb, ldumaxh, ldumax )
+ATOMIC_SIZES( ldumin, lduminb, lduminh, ldumin )
+ATOMIC_SIZES( swp, swpb, swph, swp )
+ATOMIC_SIZES( ldadda, ldaddab, ldaddah, ldadda )
+ATOMIC_SIZES( ldaddl, ldaddlb, ldaddlh, ldaddl )
+ATOMIC_SIZES( ldaddal, ldaddalb, ldaddalh, ldaddal )
+ATOMIC_SIZES( ldclral, ldclralb, ldclralh, ldclral )
+ATOMIC_SIZES( ldeora, ldeorab, ldeorah, ldeora )
+ATOMIC_SIZES( ldsetl, ldsetlb, ldsetlh, ldsetl )
+ATOMIC_SIZES( ldsmaxal, ldsmaxalb, ldsmaxalh, ldsmaxal )
+ATOMIC_SIZES( lduminl, lduminlb, lduminlh, lduminl )
+ATOMIC_SIZES( swpa, swpab, swpah, swpa )
+ATOMIC_SIZES( swpal, swpalb, swpalh, swpal )
+
+// cas: Rs is the expected value and gets the old one. Rt is stored if they matched
+
+#define CAS( fn, mnemonic, T, r ) \
+    static uint64_t fn( void * p, uint64_t expected, uint64_t desired ) \
+    { \
+        T old = (T) expected, value = (T) desired; \
+        __asm__ volatile( LSE #mnemonic " %" r "0, %" r "1, [%2]" : "+&r" ( old ) : "r" ( value ), "r" ( p ) : "memory" ); \
+        return old; \
+    }
+
+#define CAS_SIZES( op, cb, ch, cw ) \
+    CAS( op##_b, cb, uint8_t, "w" ) CAS( op##_h, ch, uint16_t, "w" ) CAS( op##_w, cw, uint32_t, "w" ) CAS( op##_x, cw, uint64_t, "x" )
+
+CAS_SIZES( cas, casb, cash, cas )
+CAS_SIZES( casa, casab, casah, casa )
+CAS_SIZES( casl, caslb, caslh, casl )
+CAS_SIZES( casal, casalb, casalh, casal )
+
+// casp needs even register pairs, so the registers are chosen here
+
+static void caspal_x( uint64_t * p, uint64_t * expected, const uint64_t * desired )
+{
+    register uint64_t s0 __asm__( "x4" ) = expected[ 0 ];
+    register uint64_t s1 __asm__( "x5" ) = expected[ 1 ];
+    register uint64_t t0 __asm__( "x6" ) = desired[ 0 ];
+    register uint64_t t1 __asm__( "x7" ) = desired[ 1 ];
+    __asm__ volatile( LSE "caspal x4, x5, x6, x7, [%4]" : "+r" ( s0 ), "+r" ( s1 ) : "r" ( t0 ), "r" ( t1 ), "r" ( p ) : "memory" );
+    expected[ 0 ] = s0;
+    expected[ 1 ] = s1;
+} //caspal_x
+
+static void casp_w( uint32_t * p, uint32_t * expected, const uint32_t * desired )
+{
+    register uint32_t s0 __asm__( "w4" ) = expected[ 0 ];
+    register uint32_t s1 __asm__( "w5" ) = expected[ 1 ];
+    register uint32_t t0 __asm__( "w6" ) = desired[ 0 ];
+    register uint32_t t1 __asm__( "w7" ) = desired[ 1 ];
+    __asm__ volatile( LSE "casp w4, w5, w6, w7, [%4]" : "+r" ( s0 ), "+r" ( s1 ) : "r" ( t0 ), "r" ( t1 ), "r" ( p ) : "memory" );
+    expected[ 0 ] = s0;
+    expected[ 1 ] = s1;
+} //casp_w
+
+typedef uint64_t ( * atomic_fn )( void * p, uint64_t v );
+typedef uint64_t ( * cas_fn )( void * p, uint64_t expected, uint64_t desired );
+
+enum { op_add, op_clr, op_eor, op_set, op_smax, op_smin, op_umax, op_umin, op_swp };
+
+struct AtomicFamily
+{
+    const char * name;
+    int op;
+    atomic_fn fn[ 4 ]; // b, h, w, x
+};
+
+#define FAMILY( name, op ) { #name, op, { name##_b, name##_h, name##_w, name##_x } }
+
+static const AtomicFamily g_families[] =
+{
+    FAMILY( ldadd, op_add ), FAMILY( ldclr, op_clr ), FAMILY( ldeor, op_eor ), FAMILY( ldset, op_set ),
+    FAMILY( ldsmax, op_smax ), FAMILY( ldsmin, op_smin ), FAMILY( ldumax, op_umax ), FAMILY( ldumin, op_umin ),
+    FAMILY( swp, op_swp ), FAMILY( ldadda, op_add ), FAMILY( ldaddl, op_add ), FAMILY( ldaddal, op_add ),
+    FAMILY( ldclral, op_clr ), FAMILY( ldeora, op_eor ), FAMILY( ldsetl, op_set ), FAMILY( ldsmaxal, op_smax ),
+    FAMILY( lduminl, op_umin ), FAMILY( swpa, op_swp ), FAMILY( swpal, op_swp ),
+};
+
+struct CasFamily
+{
+    const char * name;
+    cas_fn fn[ 4 ];
+};
+
+#define CAS_FAMILY( name ) { #name, { name##_b, name##_h, name##_w, name##_x } }
+
+static const CasFamily g_cas_families[] =
+{
+    CAS_FAMILY( cas ), CAS_FAMILY( casa ), CAS_FAMILY( casl ), CAS_FAMILY( casal ),
+};
+
+static const uint64_t g_values[] =
+{
+    0, 1, 3, 0x7f, 0x80, 0xff, 0x7fff, 0x8000, 0x7fffffff, 0x80000000, 0x0123456789abcdefull, 0xfedcba9876543210ull,
+    0x7fffffffffffffffull, 0x8000000000000000ull, 0xffffffffffffffffull,
+};
+
+static uint64_t truncate( uint64_t v, int bytes ) { return ( 8 == bytes ) ? v : ( v & ( ( 1ull << ( 8 * bytes ) ) - 1 ) ); }
+
+static int64_t sign_extend( uint64_t v, int bytes ) { return ( 8 == bytes ) ? (int64_t) v : ( (int64_t) ( v << ( 64 - 8 * bytes ) ) >> ( 64 - 8 * bytes ) ); }
+
+static uint64_t expected_result( int op, uint64_t old, uint64_t operand, int bytes )
+{
+    switch ( op )
+    {
+        case op_add: return truncate( old + operand, bytes );
+        case op_clr: return old & ~operand;
+        case op_eor: return old ^ operand;
+        case op_set: return old | operand;
+        case op_smax: return ( sign_extend( old, bytes ) > sign_extend( operand, bytes ) ) ? old : operand;
+        case op_smin: return ( sign_extend( old, bytes ) < sign_extend( operand, bytes ) ) ? old : operand;
+        case op_umax: return ( old > operand ) ? old : operand;
+        case op_umin: return ( old < operand ) ? old : operand;
+        default: return operand;
+    }
+} //expected_result
+
+static uint8_t g_buffer[ 32 ] __attribute__(( aligned( 16 ) ));
+
+static void fill( uint64_t value, int bytes )
+{
+    // the target is at offset 8, surrounded by bytes that mustn't change
+
+    memset( g_buffer, 0xa5, sizeof( g_buffer ) );
+    memcpy( g_buffer + 8, &value, bytes );
+} //fill
+
+static bool check( uint64_t * pvalue, int bytes )
+{
+    uint64_t value = 0;
+    memcpy( &value, g_buffer + 8, bytes );
+    *pvalue = value;
+    for ( int i = 0; i < (int) sizeof( g_buffer ); i++ )
+        if ( ( ( i < 8 ) || ( i >= ( 8 + bytes ) ) ) && ( 0xa5 != g_buffer[ i ] ) )
+            return false;
+    return true;
+} //check
+
+static bool test_atomics()
+{
+    bool ok = true;
+    for ( size_t f = 0; f < sizeof( g_families ) / sizeof( g_families[ 0 ] ); f++ )
+    {
+        const AtomicFamily & family = g_families[ f ];
+        int failures = 0, checks = 0;
+        for ( int s = 0; s < 4; s++ )
+        {
+            int bytes = 1 << s;
+            for ( size_t i = 0; i < sizeof( g_values ) / sizeof( g_values[ 0 ] ); i++ )
+            {
+                for ( size_t j = 0; j < sizeof( g_values ) / sizeof( g_values[ 0 ] ); j++ )
+                {
+                    uint64_t old = truncate( g_values[ i ], bytes ), operand = truncate( g_values[ j ], bytes );
+                    fill( old, bytes );
+                    uint64_t returned = family.fn[ s ]( g_buffer + 8, operand );
+                    uint64_t stored;
+                    bool untouched = check( &stored, bytes );
+                    uint64_t expected = expected_result( family.op, old, operand, bytes );
+                    checks++;
+                    if ( !untouched || ( returned != old ) || ( stored != expected ) )
+                    {
+                        if ( failures++ < 4 )
+                            printf( "  %s size %d: old %llx operand %llx returned %llx stored %llx expected %llx\n", family.name, bytes,
+                                    (unsigned long long) old, (unsigned long long) operand, (unsigned long long) returned,
+                                    (unsigned long long) stored, (unsigned long long) expected );
+                    }
+                }
+            }
+        }
+
+        printf( "%-9s %d checks, %s\n", family.name, checks, ( 0 == failures ) ? "ok" : "FAILED" );
+        ok = ok && ( 0 == failures );
+    }
+    return ok;
+} //test_atomics
+
+static bool test_cas()
+{
+    bool ok = true;
+    for ( size_t f = 0; f < sizeof( g_cas_families ) / sizeof( g_cas_families[ 0 ] ); f++ )
+    {
+        const CasFamily & family = g_cas_families[ f ];
+        int failures = 0, checks = 0;
+        for ( int s = 0; s < 4; s++ )
+        {
+            int bytes = 1 << s;
+            for ( size_t i = 0; i < sizeof( g_values ) / sizeof( g_values[ 0 ] ); i++ )
+            {
+                // a compare that matches stores the new value; one that doesn't leaves memory alone
+
+                for ( int match = 0; match < 2; match++ )
+                {
+                    uint64_t old = truncate( g_values[ i ], bytes );
+                    uint64_t compare = match ? old : truncate( old ^ 0x41, bytes );
+                    uint64_t desired = truncate( ~old, bytes );
+                    fill( old, bytes );
+                    uint64_t returned = family.fn[ s ]( g_buffer + 8, compare, desired );
+                    uint64_t stored;
+                    bool untouched = check( &stored, bytes );
+                    checks++;
+                    if ( !untouched || ( returned != old ) || ( stored != ( match ? desired : old ) ) )
+                    {
+                        if ( failures++ < 4 )
+                            printf( "  %s size %d: old %llx compare %llx returned %llx stored %llx\n", family.name, bytes,
+                                    (unsigned long long) old, (unsigned long long) compare, (unsigned long long) returned,
+                                    (unsigned long long) stored );
+                    }
+                }
+            }
+        }
+
+        printf( "%-9s %d checks, %s\n", family.name, checks, ( 0 == failures ) ? "ok" : "FAILED" );
+        ok = ok && ( 0 == failures );
+    }
+
+    // casp compares and stores both halves of a pair at once
+
+    uint64_t pair[ 2 ] __attribute__(( aligned( 16 ) )) = { 0x1111111111111111ull, 0x2222222222222222ull };
+    uint64_t expected[ 2 ] = { 0x1111111111111111ull, 0x2222222222222222ull };
+    const uint64_t desired[ 2 ] = { 0x3333333333333333ull, 0x4444444444444444ull };
+    caspal_x( pair, expected, desired );
+    bool xok = ( 0x3333333333333333ull == pair[ 0 ] ) && ( 0x4444444444444444ull == pair[ 1 ] ) &&
+               ( 0x1111111111111111ull == expected[ 0 ] ) && ( 0x2222222222222222ull == expected[ 1 ] );
+    caspal_x( pair, expected, desired ); // no match now
+    xok = xok && ( 0x3333333333333333ull == pair[ 0 ] ) && ( 0x4444444444444444ull == expected[ 1 ] );
+
+    uint32_t wpair[ 2 ] __attribute__(( aligned( 8 ) )) = { 5, 6 };
+    uint32_t wexpected[ 2 ] = { 5, 6 };
+    const uint32_t wdesired[ 2 ] = { 7, 8 };
+    casp_w( wpair, wexpected, wdesired );
+    bool wok = ( 7 == wpair[ 0 ] ) && ( 8 == wpair[ 1 ] ) && ( 5 == wexpected[ 0 ] ) && ( 6 == wexpected[ 1 ] );
+    wexpected[ 1 ] = 9;
+    casp_w( wpair, wexpected, wdesired ); // only one half matches
+    wok = wok && ( 7 == wpair[ 0 ] ) && ( 8 == wpair[ 1 ] ) && ( 7 == wexpected[ 0 ] ) && ( 8 == wexpected[ 1 ] );
+
+    printf( "caspal    64-bit pair %s\n", xok ? "ok" : "FAILED" );
+    printf( "casp      32-bit pair %s\n", wok ? "ok" : "FAILED" );
+    return ok && xok && wok;
+} //test_cas
+
+extern "C" int main( int argc, char * argv[] )
+{
+    unsigned long hwcap = getauxval( AT_HWCAP );
+    printf( "hwcaps advertise atomics: %s\n", ( hwcap & ( 1 << 8 ) ) ? "yes" : "no" );
+
+    bool ok = test_atomics();
+    ok = test_cas() && ok;
+
+    if ( !ok )
+    {
+        printf( "tlse failed\n" );
+        return 1;
+    }
+
+    printf( "tlse completed with great success\n" );
+    return 0;
+} //main
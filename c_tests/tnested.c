@@ -0,0 +1,80 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+// calls emulator_sys_run_nested directly, the way an Arm64 build of armos hands its app to the armos running it.
+// this app runs a second copy of itself with arguments and an environment variable, then an image that doesn't exist
+
+#define emulator_sys_run_nested 0x2014
+
+struct NestedRun // matches armos.cxx
+{
+    uint64_t app;
+    uint64_t app_args;
+    uint64_t stack_bytes;
+    uint64_t brk_bytes;
+    uint64_t mmap_bytes;
+    uint64_t flags;
+    uint64_t fault;
+    uint64_t fault_size;
+    int64_t exit_code;
+    uint64_t handled;
+    uint64_t env;
+};
+
+static char fault[ 256 ];
+
+static bool run_nested( const char * app, const char * app_args, char ** env, NestedRun & run )
+{
+    memset( &run, 0, sizeof( run ) );
+    memset( fault, 0, sizeof( fault ) );
+    run.app = (uint64_t) app;
+    run.app_args = (uint64_t) app_args;
+    run.stack_bytes = 128 * 1024;
+    run.brk_bytes = 64 * 1024 * 1024;
+    run.mmap_bytes = 64 * 1024 * 1024;
+    run.fault = (uint64_t) fault;
+    run.fault_size = sizeof( fault );
+    run.env = (uint64_t) env;
+
+    fflush( stdout ); // the nested app writes to the same stdout
+    syscall( emulator_sys_run_nested, &run );
+    return ( 1 == run.handled );
+} //run_nested
+
+extern "C" int main( int argc, char * argv[] )
+{
+    if ( ( argc > 1 ) && !strcmp( argv[ 1 ], "child" ) )
+    {
+        const char * value = getenv( "TNESTED" );
+        printf( "nested app has %d arguments, second '%s', TNESTED '%s'\n", argc, ( argc > 2 ) ? argv[ 2 ] : "", value ? value : "(none)" );
+        return ( ( 3 == argc ) && value && !strcmp( value, "nested value" ) ) ? 7 : 1;
+    }
+
+    NestedRun run;
+    char * env[] = { (char *) "TNESTED=nested value", 0 };
+    if ( !run_nested( argv[ 0 ], "child second", env, run ) )
+    {
+        printf( "emulator_sys_run_nested isn't available; this test runs under armos\n" );
+        return 1;
+    }
+
+    printf( "nested app exit code %lld, fault '%s'\n", (long long) run.exit_code, fault );
+    if ( 7 != run.exit_code )
+        return 1;
+
+    if ( !run_nested( "tnested-no-such-image", "", 0, run ) )
+    {
+        printf( "a missing image wasn't handled\n" );
+        return 1;
+    }
+
+    printf( "missing image exit code %lld, fault reported: %s\n", (long long) run.exit_code, ( 0 != fault[ 0 ] ) ? "yes" : "no" );
+    if ( ( 1 != run.exit_code ) || ( 0 == fault[ 0 ] ) )
+        return 1;
+
+    printf( "tnested completed with great success\n" );
+    return 0;
+} //main
@@ -0,0 +1,144 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/epoll.h>
+#include <sys/sendfile.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+// unix and loopback tcp sockets, sendmsg and recvmsg, epoll readiness, nonblocking reads via fcntl, and sendfile
+// from a file to a socket
+
+static void check( bool ok, const char * what )
+{
+    if ( !ok )
+    {
+        printf( "%s failed, errno %d\n", what, errno );
+        exit( 1 );
+    }
+} //check
+
+static void test_socketpair()
+{
+    int sv[ 2 ];
+    check( 0 == socketpair( AF_UNIX, SOCK_STREAM, 0, sv ), "socketpair" );
+
+    char part1[] = "scatter ";
+    char part2[] = "gather";
+    struct iovec iov[ 2 ] = { { part1, strlen( part1 ) }, { part2, strlen( part2 ) } };
+    struct msghdr m;
+    memset( &m, 0, sizeof( m ) );
+    m.msg_iov = iov;
+    m.msg_iovlen = 2;
+    check( 14 == sendmsg( sv[ 0 ], &m, 0 ), "sendmsg" );
+
+    char a[ 4 ], b[ 16 ];
+    struct iovec riov[ 2 ] = { { a, sizeof( a ) }, { b, sizeof( b ) } };
+    m.msg_iov = riov;
+    ssize_t len = recvmsg( sv[ 1 ], &m, 0 );
+    check( 14 == len, "recvmsg" );
+    printf( "recvmsg: '%.4s' '%.10s'\n", a, b );
+
+    // with O_NONBLOCK set through fcntl an empty socket returns EAGAIN rather than blocking
+
+    int flags = fcntl( sv[ 1 ], F_GETFL );
+    check( -1 != flags, "F_GETFL" );
+    printf( "nonblocking before F_SETFL: %s\n", ( flags & O_NONBLOCK ) ? "yes" : "no" );
+    check( 0 == fcntl( sv[ 1 ], F_SETFL, flags | O_NONBLOCK ), "F_SETFL" );
+    flags = fcntl( sv[ 1 ], F_GETFL );
+    printf( "nonblocking after F_SETFL: %s, access mode %d\n", ( flags & O_NONBLOCK ) ? "yes" : "no", flags & O_ACCMODE );
+    check( -1 == recv( sv[ 1 ], a, sizeof( a ), 0 ) && EAGAIN == errno, "nonblocking recv" );
+    printf( "empty nonblocking recv: EAGAIN\n" );
+
+    close( sv[ 0 ] );
+    close( sv[ 1 ] );
+} //test_socketpair
+
+static void test_tcp()
+{
+    int listener = socket( AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+    check( -1 != listener, "socket" );
+
+    struct sockaddr_in addr;
+    memset( &addr, 0, sizeof( addr ) );
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+    addr.sin_port = 0; // any free port
+    check( 0 == bind( listener, (struct sockaddr *) &addr, sizeof( addr ) ), "bind" );
+    check( 0 == listen( listener, 1 ), "listen" );
+    socklen_t addr_len = sizeof( addr );
+    check( 0 == getsockname( listener, (struct sockaddr *) &addr, &addr_len ), "getsockname" );
+
+    int client = socket( AF_INET, SOCK_STREAM, 0 );
+    check( -1 != client, "client socket" );
+    check( 0 == connect( client, (struct sockaddr *) &addr, sizeof( addr ) ), "connect" );
+    int server = accept4( listener, 0, 0, SOCK_CLOEXEC );
+    check( -1 != server, "accept4" );
+
+    int ep = epoll_create1( EPOLL_CLOEXEC );
+    check( -1 != ep, "epoll_create1" );
+    struct epoll_event e;
+    memset( &e, 0, sizeof( e ) );
+    e.events = EPOLLIN;
+    e.data.u64 = 0x1234567890ull;
+    check( 0 == epoll_ctl( ep, EPOLL_CTL_ADD, server, &e ), "epoll_ctl" );
+
+    struct epoll_event ready[ 4 ];
+    printf( "epoll_wait before send: %d\n", epoll_wait( ep, ready, 4, 0 ) );
+    check( 5 == send( client, "hello", 5, 0 ), "send" );
+    int n = epoll_wait( ep, ready, 4, 5000 );
+    printf( "epoll_wait after send: %d, data %#llx, EPOLLIN %s\n", n, (unsigned long long) ready[ 0 ].data.u64,
+            ( ready[ 0 ].events & EPOLLIN ) ? "set" : "clear" );
+
+    char buf[ 16 ];
+    ssize_t len = recv( server, buf, sizeof( buf ), 0 );
+    check( 5 == len, "recv" );
+    printf( "tcp recv: '%.5s'\n", buf );
+
+    // sendfile from a file to the socket, starting at an offset and updating it
+
+    const char * path = "tsocket.txt";
+    FILE * fp = fopen( path, "w" );
+    check( 0 != fp, "fopen" );
+    fprintf( fp, "0123456789abcdef" );
+    fclose( fp );
+
+    int fd = open( path, O_RDONLY );
+    check( -1 != fd, "open" );
+    off_t offset = 4;
+    ssize_t sent = sendfile( client, fd, &offset, 8 );
+    printf( "sendfile sent %zd bytes, offset now %lld\n", sent, (long long) offset );
+    close( fd );
+    unlink( path );
+
+    size_t got = 0;
+    while ( got < 8 )
+    {
+        len = recv( server, buf + got, sizeof( buf ) - got, 0 );
+        check( len > 0, "recv of sendfile data" );
+        got += len;
+    }
+    printf( "received: '%.8s'\n", buf );
+
+    check( 0 == shutdown( client, SHUT_WR ), "shutdown" );
+    printf( "recv after shutdown: %zd\n", recv( server, buf, sizeof( buf ), 0 ) );
+
+    close( ep );
+    close( server );
+    close( client );
+    close( listener );
+} //test_tcp
+
+extern "C" int main( int argc, char * argv[] )
+{
+    test_socketpair();
+    test_tcp();
+    printf( "tsocket completed with great success\n" );
+    return 0;
+} //main
@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <elf.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/auxv.h>
+#include <sys/syscall.h>
+
+// finds clock_gettime() and gettimeofday() in the vdso named by AT_SYSINFO_EHDR, calls them directly, and checks
+// their times against the syscalls. a clock the vdso doesn't read must make the syscall and fail the same way
+
+typedef int ( * clock_gettime_t )( clockid_t id, struct timespec * ts );
+typedef int ( * gettimeofday_t )( struct timeval * tv, struct timezone * tz );
+
+static const uint8_t * g_vdso = 0;
+
+static void * vdso_symbol( const char * name )
+{
+    const Elf64_Ehdr * pehdr = (const Elf64_Ehdr *) g_vdso;
+    const Elf64_Phdr * pphdr = (const Elf64_Phdr *) ( g_vdso + pehdr->e_phoff );
+    const Elf64_Dyn * pdyn = 0;
+    uint64_t load_vaddr = 0;
+    for ( int i = 0; i < pehdr->e_phnum; i++ )
+    {
+        if ( PT_LOAD == pphdr[ i ].p_type )
+            load_vaddr = pphdr[ i ].p_vaddr - pphdr[ i ].p_offset;
+        else if ( PT_DYNAMIC == pphdr[ i ].p_type )
+            pdyn = (const Elf64_Dyn *) ( g_vdso + pphdr[ i ].p_offset );
+    }
+
+    if ( 0 == pdyn )
+        return 0;
+
+    const uint32_t * phash = 0;
+    const Elf64_Sym * psym = 0;
+    const char * pstrings = 0;
+    for ( ; DT_NULL != pdyn->d_tag; pdyn++ )
+    {
+        const uint8_t * p = g_vdso + ( pdyn->d_un.d_ptr - load_vaddr );
+        if ( DT_HASH == pdyn->d_tag )
+            phash = (const uint32_t *) p;
+        else if ( DT_SYMTAB == pdyn->d_tag )
+            psym = (const Elf64_Sym *) p;
+        else if ( DT_STRTAB == pdyn->d_tag )
+            pstrings = (const char *) p;
+    }
+
+    if ( 0 == phash || 0 == psym || 0 == pstrings )
+        return 0;
+
+    for ( uint32_t i = 1; i < phash[ 1 ]; i++ ) // nchain is the symbol count
+        if ( SHN_UNDEF != psym[ i ].st_shndx && !strcmp( pstrings + psym[ i ].st_name, name ) )
+            return (void *) ( g_vdso + ( psym[ i ].st_value - load_vaddr ) );
+
+    return 0;
+} //vdso_symbol
+
+static int64_t ns( const struct timespec & ts ) { return (int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec; }
+static int64_t us( const struct timeval & tv ) { return (int64_t) tv.tv_sec * 1000000 + tv.tv_usec; }
+
+static bool check_clock( clock_gettime_t vdso_clock_gettime, clockid_t id, const char * name, bool monotonic )
+{
+    struct timespec before, during, after;
+    if ( 0 != vdso_clock_gettime( id, & before ) ||
+         0 != syscall( SYS_clock_gettime, id, & during ) ||
+         0 != vdso_clock_gettime( id, & after ) )
+    {
+        printf( "%s: a read failed, errno %d\n", name, errno );
+        return false;
+    }
+
+    if ( before.tv_nsec < 0 || before.tv_nsec >= 1000000000 || after.tv_nsec < 0 || after.tv_nsec >= 1000000000 )
+    {
+        printf( "%s: vdso nanoseconds are out of range\n", name );
+        return false;
+    }
+
+    // coarse clocks tick every few milliseconds, and the realtime clock can be stepped, so allow a second
+
+    int64_t slack = monotonic ? 0 : 1000000000;
+    if ( ns( during ) + slack < ns( before ) || ns( after ) + slack < ns( during ) || ( ns( after ) - ns( before ) ) > 1000000000 )
+    {
+        printf( "%s: vdso %lld, syscall %lld, vdso %lld aren't in order\n", name,
+                (long long) ns( before ), (long long) ns( during ), (long long) ns( after ) );
+        return false;
+    }
+
+    printf( "%s: vdso and syscall agree\n", name );
+    return true;
+} //check_clock
+
+extern "C" int main( int argc, char * argv[] )
+{
+    g_vdso = (const uint8_t *) getauxval( AT_SYSINFO_EHDR );
+    if ( 0 == g_vdso )
+    {
+        printf( "no AT_SYSINFO_EHDR aux record\n" );
+        return 1;
+    }
+
+    // armos and the arm64 kernel use the __kernel_ names; other kernels use __vdso_
+
+    clock_gettime_t vdso_clock_gettime = (clock_gettime_t) vdso_symbol( "__kernel_clock_gettime" );
+    if ( 0 == vdso_clock_gettime )
+        vdso_clock_gettime = (clock_gettime_t) vdso_symbol( "__vdso_clock_gettime" );
+    gettimeofday_t vdso_gettimeofday = (gettimeofday_t) vdso_symbol( "__kernel_gettimeofday" );
+    if ( 0 == vdso_gettimeofday )
+        vdso_gettimeofday = (gettimeofday_t) vdso_symbol( "__vdso_gettimeofday" );
+
+    if ( 0 == vdso_clock_gettime || 0 == vdso_gettimeofday )
+    {
+        printf( "the vdso doesn't have clock_gettime and gettimeofday\n" );
+        return 1;
+    }
+
+    bool ok = check_clock( vdso_clock_gettime, CLOCK_REALTIME, "CLOCK_REALTIME", false );
+    ok = check_clock( vdso_clock_gettime, CLOCK_MONOTONIC, "CLOCK_MONOTONIC", true ) && ok;
+    ok = check_clock( vdso_clock_gettime, CLOCK_MONOTONIC_RAW, "CLOCK_MONOTONIC_RAW", true ) && ok;
+    ok = check_clock( vdso_clock_gettime, CLOCK_REALTIME_COARSE, "CLOCK_REALTIME_COARSE", false ) && ok;
+    ok = check_clock( vdso_clock_gettime, CLOCK_MONOTONIC_COARSE, "CLOCK_MONOTONIC_COARSE", true ) && ok;
+    ok = check_clock( vdso_clock_gettime, CLOCK_BOOTTIME, "CLOCK_BOOTTIME", true ) && ok;
+
+    // the vdso makes the syscall for clocks it doesn't read, so an invalid one fails like the syscall does
+
+    struct timespec ts;
+    errno = 0;
+    int vdso_result = vdso_clock_gettime( (clockid_t) 1000, & ts );
+    int vdso_errno = ( vdso_result < 0 && -vdso_result < 4096 ) ? -vdso_result : errno; // the vdso returns -errno
+    errno = 0;
+    int syscall_result = (int) syscall( SYS_clock_gettime, (clockid_t) 1000, & ts );
+    printf( "invalid clock: vdso fails %s, syscall fails %s, same error %s\n", ( 0 != vdso_result ) ? "yes" : "no",
+            ( 0 != syscall_result ) ? "yes" : "no", ( vdso_errno == errno ) ? "yes" : "no" );
+    ok = ok && ( 0 != vdso_result ) && ( 0 != syscall_result ) && ( vdso_errno == errno );
+
+    struct timeval tv_before, tv_during, tv_after;
+    if ( 0 != vdso_gettimeofday( & tv_before, 0 ) || 0 != syscall( SYS_gettimeofday, & tv_during, 0 ) ||
+         0 != vdso_gettimeofday( & tv_after, 0 ) )
+    {
+        printf( "gettimeofday: a read failed\n" );
+        return 1;
+    }
+
+    if ( tv_before.tv_usec < 0 || tv_before.tv_usec >= 1000000 ||
+         us( tv_during ) + 1000000 < us( tv_before ) || us( tv_after ) + 1000000 < us( tv_during ) )
+    {
+        printf( "gettimeofday: vdso %lld, syscall %lld, vdso %lld aren't in order\n",
+                (long long) us( tv_before ), (long long) us( tv_during ), (long long) us( tv_after ) );
+        return 1;
+    }
+
+    printf( "gettimeofday: vdso and syscall agree\n" );
+
+    // with a time zone the vdso makes the syscall
+
+    struct timezone tz;
+    printf( "gettimeofday with a time zone: %s\n", ( 0 == vdso_gettimeofday( & tv_before, & tz ) ) ? "ok" : "failed" );
+
+    if ( !ok )
+        return 1;
+
+    printf( "tvdso completed with great success\n" );
+    return 0;
+} //main
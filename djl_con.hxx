@@ -5,6 +5,8 @@ extern "C" int clock_gettime( clockid_t id, struct timespec * res );
 #endif
 
 static bool s_convert_redirected_LF_to_CR = false;
+static bool s_redirected_look_ahead_available = false; // a CR was followed by something other than LF
+static char s_redirected_look_ahead = 0;
 
 #ifdef WATCOM
 
@@ -612,16 +614,22 @@ class ConsoleConfiguration
             #endif
         } //portable_kbhit
 
+        static bool stdin_redirected()
+        {
+            static int redirected = -1; // stdin doesn't change, so only ask once
+            if ( -1 == redirected )
+                redirected = !isatty( fileno( stdin ) );
+            return ( 0 != redirected );
+        } //stdin_redirected
+
         static int redirected_getch()
         {
             assert( !isatty( fileno( stdin ) ) );
-            static bool look_ahead_available = false;
-            static char look_ahead = 0;
 
-            if ( look_ahead_available )
+            if ( s_redirected_look_ahead_available )
             {
-                look_ahead_available = false;
-                return look_ahead;
+                s_redirected_look_ahead_available = false;
+                return s_redirected_look_ahead;
             }
 
             char data;
@@ -633,13 +641,13 @@ class ConsoleConfiguration
 #ifndef _WIN32
                 if ( ( 13 == data ) && ( !feof( stdin ) ) )
                 {
-                    if ( 0 == read( 0, &look_ahead, 1 ) ) // make gcc not complain by checking return code
-                        look_ahead = 13;
+                    if ( 0 == read( 0, &s_redirected_look_ahead, 1 ) ) // make gcc not complain by checking return code
+                        s_redirected_look_ahead = 13;
 
-                    if ( 10 == look_ahead )
+                    if ( 10 == s_redirected_look_ahead )
                         data = 10;
                     else
-                        look_ahead_available = true;
+                        s_redirected_look_ahead_available = true;
                 }
 #endif
 
@@ -651,6 +659,64 @@ class ConsoleConfiguration
             return EOF;
         } //redirected_getch()
 
+        static int redirected_read( char * buf, int len )
+        {
+            // like len calls to redirected_getch, but with one host read. returns bytes read, 0 at end of file, or -1
+
+            assert( !isatty( fileno( stdin ) ) );
+            if ( len <= 0 )
+                return 0;
+
+            int count = 0;
+            if ( s_redirected_look_ahead_available )
+            {
+                s_redirected_look_ahead_available = false;
+                buf[ count++ ] = s_redirected_look_ahead;
+            }
+
+            int r = ( count < len ) ? (int) read( 0, buf + count, len - count ) : 0;
+            if ( r < 0 )
+                return ( 0 == count ) ? r : count;
+
+            int available = count + r;
+            int result = 0;
+            for ( int i = 0; i < available; i++ )
+            {
+                char data = buf[ i ];
+
+#ifndef _WIN32
+                if ( ( i >= count ) && ( 13 == data ) )
+                {
+                    if ( ( i + 1 ) < available ) // the LF of a CR/LF pair is usually in this buffer
+                    {
+                        if ( 10 == buf[ i + 1 ] )
+                        {
+                            data = 10;
+                            i++;
+                        }
+                    }
+                    else
+                    {
+                        if ( 1 == read( 0, &s_redirected_look_ahead, 1 ) )
+                        {
+                            if ( 10 == s_redirected_look_ahead )
+                                data = 10;
+                            else
+                                s_redirected_look_ahead_available = true;
+                        }
+                    }
+                }
+#endif
+
+                if ( ( i >= count ) && s_convert_redirected_LF_to_CR && ( 10 == data ) )
+                    data = 13;
+
+                buf[ result++ ] = data;
+            }
+
+            return result;
+        } //redirected_read
+
 #ifdef _WIN32
         // behave like getch() on linux -- extended characters have escape sequences
 
@@ -0,0 +1,16 @@
+#pragma once
+
+// FNV-1a, a quick non-cryptographic 64-bit hash. Pass the previous result as h to hash data in pieces
+
+#include <stdint.h>
+#include <stddef.h>
+
+static const uint64_t fnv1a_basis = 0xcbf29ce484222325ull;
+
+inline uint64_t fnv1a( const void * p, size_t len, uint64_t h = fnv1a_basis )
+{
+    const uint8_t * pb = (const uint8_t *) p;
+    for ( size_t i = 0; i < len; i++ )
+        h = ( h ^ pb[ i ] ) * 0x100000001b3ull;
+    return h;
+} //fnv1a
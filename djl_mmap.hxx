@@ -1,267 +1,418 @@
 #pragma once
 
 #include <stdint.h>
+#include <map>
+#include <set>
+#include <vector>
 
-struct MMapEntry
-{
-    uint64_t address;
-    uint64_t length;
-};
+// Allocator for the arena that backs Linux mmap calls. Allocations and free ranges are kept in balanced trees so
+// mmap, munmap, and mremap are O(log n) regardless of how many chunks an app has outstanding:
+//     allocations:  address -> length
+//     free_spans:   address -> length, for coalescing neighbors on free
+//     free_sizes:   ( length, address ), for best-fit allocation
+// When the arena is only reserved, set_commit() supplies a function that makes memory usable before it's handed out.
 
 class CMMap
 {
+    public:
+        typedef bool ( * CommitFunction )( void * context, uint64_t address, uint64_t length );
+        typedef void ( * DiscardFunction )( void * context, uint64_t address, uint64_t length ); // makes the range zero
+
     private:
-        vector<MMapEntry> entries; // sorted by address
+        typedef map<uint64_t, uint64_t> SpanMap;
+        typedef pair<uint64_t, uint64_t> SizeKey;
+
+        SpanMap allocations;
+        SpanMap free_spans;
+        set<SizeKey> free_sizes;
         uint64_t base;
         uint64_t length;
         uint64_t peak;
+        uint64_t free_bytes;       // total length of free_spans, so usage() needn't walk the allocations
+        uint64_t pristine;         // no allocation has reached this address, so memory here and above is still zero
         uint8_t * pmem;
+        CommitFunction commit;
+        DiscardFunction discard;
+        void * commit_context;
+
+        bool commit_range( uint64_t address, uint64_t l )
+        {
+            if ( ( 0 == commit ) || commit( commit_context, address, l ) )
+                return true;
+
+            tracer.Trace( "  mmap can't commit %llu bytes at %llx\n", l, address );
+            return false;
+        } //commit_range
 
-        size_t binary_search( uint64_t key )
+        void zero_range( uint64_t address, uint64_t l )
         {
-            if ( 0 == entries.size() )
-               return (size_t) -1;
-            
-            size_t low = 0;
-            size_t high = entries.size() - 1;
-            while ( low <= high )
+            // new allocations must read as zero. only memory that earlier allocations handed out can be dirty
+
+            if ( address < pristine )
             {
-                size_t mid = low + ( ( high - low ) / 2 );
-                if ( entries[ mid ].address == key )
-                    return mid;
-                if ( key < entries[ mid ].address )
-                    high = mid - 1;
+                uint64_t dirty = get_min( l, pristine - address );
+                if ( 0 != discard )
+                    discard( commit_context, address, dirty );
                 else
-                    low = mid + 1;
+                    memset( pmem + address, 0, dirty );
+            }
+            if ( ( address + l ) > pristine )
+                pristine = address + l;
+        } //zero_range
+
+        void add_free( uint64_t address, uint64_t l )
+        {
+            // coalesce with the free spans on either side
+
+            free_bytes += l;
+            SpanMap::iterator next = free_spans.lower_bound( address );
+            if ( ( next != free_spans.end() ) && ( next->first == ( address + l ) ) )
+            {
+                l += next->second;
+                free_sizes.erase( SizeKey( next->second, next->first ) );
+                free_spans.erase( next++ );
+            }
+
+            if ( next != free_spans.begin() )
+            {
+                SpanMap::iterator prev = next;
+                prev--;
+                if ( ( prev->first + prev->second ) == address )
+                {
+                    free_sizes.erase( SizeKey( prev->second, prev->first ) );
+                    address = prev->first;
+                    l += prev->second;
+                    free_spans.erase( prev );
+                }
+            }
+
+            free_spans[ address ] = l;
+            free_sizes.insert( SizeKey( l, address ) );
+        } //add_free
+
+        void take_free( SpanMap::iterator span, uint64_t address, uint64_t l )
+        {
+            // remove [address, address + l) from the free span that contains it
+
+            uint64_t span_address = span->first;
+            uint64_t span_length = span->second;
+            assert( ( address >= span_address ) && ( ( address + l ) <= ( span_address + span_length ) ) );
+
+            free_sizes.erase( SizeKey( span_length, span_address ) );
+            free_spans.erase( span );
+            free_bytes -= l;
+
+            if ( address > span_address )
+            {
+                free_spans[ span_address ] = address - span_address;
+                free_sizes.insert( SizeKey( address - span_address, span_address ) );
+            }
+
+            uint64_t tail = ( span_address + span_length ) - ( address + l );
+            if ( 0 != tail )
+            {
+                free_spans[ address + l ] = tail;
+                free_sizes.insert( SizeKey( tail, address + l ) );
             }
-            return (size_t) -1;
-        } //binary_search
+        } //take_free
 
-        void zero_entry( size_t i )
+        uint64_t allocate_span( uint64_t l )
         {
-            memset( pmem + entries[ i ].address, 0, entries[ i ].length );
-        } //zero_entry
+            // best fit: the smallest free span that's large enough, lowest address among equals
+
+            set<SizeKey>::iterator fit = free_sizes.lower_bound( SizeKey( l, 0 ) );
+            if ( fit == free_sizes.end() )
+                return 0;
+
+            uint64_t address = fit->second;
+            if ( !commit_range( address, l ) )
+                return 0;
+            take_free( free_spans.find( address ), address, l );
+            allocations[ address ] = l;
+            peak = get_max( peak, address + l - base );
+            return address;
+        } //allocate_span
 
         void validate()
         {
 #ifndef NDEBUG
-            for ( size_t i = 0; i < entries.size(); i++ )
+            uint64_t total = 0;
+            uint64_t last = base;
+            for ( SpanMap::iterator it = allocations.begin(); it != allocations.end(); it++ )
             {
-                MMapEntry & entry = entries[ i ];
-                if ( i < ( entries.size() - 1 ) )
-                {
-                    assert( entry.address < entries[ i + 1 ].address );
-                    assert( ( entry.address + entry.length ) <= entries[ i + 1 ].address );
-                }
-                else
-                    assert( ( entry.address + entry.length ) <= ( base + length ) );
+                assert( it->first >= last );
+                last = it->first + it->second;
+                total += it->second;
+            }
+            assert( last <= ( base + length ) );
+            assert( total == ( length - free_bytes ) );
+
+            last = base;
+            for ( SpanMap::iterator it = free_spans.begin(); it != free_spans.end(); it++ )
+            {
+                assert( it->first >= last );
+                assert( 0 == allocations.count( it->first ) );
+                last = it->first + it->second;
+                total += it->second;
             }
+
+            assert( free_spans.size() == free_sizes.size() );
+            assert( total == length );
 #endif
         } //validate
 
     public:
-        CMMap() : base( 0 ), length( 0 ), peak( 0 ), pmem( 0 ) {}
+        CMMap() : base( 0 ), length( 0 ), peak( 0 ), free_bytes( 0 ), pristine( 0 ), pmem( 0 ), commit( 0 ), discard( 0 ), commit_context( 0 ) {}
         ~CMMap() { validate(); }
         uint64_t peak_usage() { return peak; }
+        uint64_t usage() { return length - free_bytes; } // bytes allocated now
 
         void initialize( uint64_t b, uint64_t l, uint8_t * p )
         {
             base = b;
             length = l;
+            pristine = b;
             pmem = p;
+            allocations.clear();
+            free_spans.clear();
+            free_sizes.clear();
+            free_bytes = 0;
+            if ( 0 != l )
+                add_free( b, l );
         } //initialize
 
+        void set_commit( CommitFunction f, DiscardFunction d, void * context )
+        {
+            commit = f;
+            discard = d;
+            commit_context = context;
+        } //set_commit
+
+        // for snapshots: peak, pristine, then ( address, length ) for each allocation. load() follows an initialize()
+        // of the same arena and gives false if the allocations don't fit in it
+
+        void save( vector<uint64_t> & state )
+        {
+            state.clear();
+            state.push_back( peak );
+            state.push_back( pristine );
+            for ( SpanMap::iterator it = allocations.begin(); it != allocations.end(); it++ )
+            {
+                state.push_back( it->first );
+                state.push_back( it->second );
+            }
+        } //save
+
+        bool load( const vector<uint64_t> & state )
+        {
+            if ( ( state.size() < 2 ) || ( 0 != ( state.size() & 1 ) ) )
+                return false;
+
+            for ( size_t i = 2; i < state.size(); i += 2 )
+            {
+                uint64_t a = state[ i ];
+                uint64_t l = state[ i + 1 ];
+                if ( ( 0 == l ) || !is_free( a, l ) || !commit_range( a, l ) )
+                    return false;
+
+                SpanMap::iterator span = free_spans.upper_bound( a );
+                span--;
+                take_free( span, a, l );
+                allocations[ a ] = l;
+            }
+
+            peak = state[ 0 ];
+            pristine = state[ 1 ];
+            validate();
+            return true;
+        } //load
+
         void trace_allocations()
         {
-            if ( entries.size() )
+            if ( !tracer.IsEnabled() || allocations.empty() )
+                return;
+
+            tracer.Trace( "  app has %zu mmap allocations and %zu free spans. address, size:\n", allocations.size(), free_spans.size() );
+            uint64_t total = 0;
+            uint64_t beyond = 0;
+            size_t i = 0;
+            for ( SpanMap::iterator it = allocations.begin(); it != allocations.end(); it++, i++ )
             {
-                uint64_t beyond = 0;
-                tracer.Trace( "  app has %zu mmap allocations. address, size:\n", entries.size() );
-                uint64_t total = 0;
-                for ( size_t i = 0; i < entries.size(); i++ )
-                {
-                    MMapEntry & entry = entries[ i ];
-                    tracer.Trace( "    %zu: %llx, %llu == %llx\n", i, entry.address, entry.length, entry.length );
-                    total += entry.length;
-                    beyond = entry.address + entry.length;
-                }
-                tracer.Trace( "    total memory in use: %llu bytes spanning %llu bytes\n", total, beyond - base );
+                tracer.Trace( "    %zu: %llx, %llu == %llx\n", i, it->first, it->second, it->second );
+                total += it->second;
+                beyond = it->first + it->second;
             }
+            tracer.Trace( "    total memory in use: %llu bytes spanning %llu bytes\n", total, beyond - base );
         } //trace_allocations
 
         uint64_t allocate( uint64_t l )
         {
             assert( 0 == ( l & 0xfff ) );
-            trace_allocations();
 
-            if ( 0 == entries.size() )
+            uint64_t result = ( 0 == l ) ? 0 : allocate_span( l );
+            if ( 0 == result )
             {
-                tracer.Trace( "  adding a first mmap entry, l %llu, length %llu\n", l, length );
-                if ( l > length )
-                {
-                    tracer.Trace( "  mmap alloc request %llu larger than reserved size %llu\n", l, length );
-                    return 0;
-                }
+                tracer.Trace( "  mmap alloc request %llu can't be met\n", l );
+                return 0;
+            }
 
-                tracer.Trace( "  in mmap allocate, base %#lx\n", base );
+            zero_range( result, l );
+            tracer.Trace( "  mmap allocated %llu bytes at %llx\n", l, result );
+            trace_allocations();
+            validate();
+            return result;
+        } //allocate
 
-                MMapEntry entry = { base, l };
-                entries.push_back( entry );
-                zero_entry( 0 );
-                peak = l;
-                trace_allocations();
-                validate();
-                return base;
-            }
-            else
-            {
-                // first look for a gap large enough to work
+        bool is_free( uint64_t a, uint64_t l )
+        {
+            // is all of [a, a + l) inside the arena and unallocated?
 
-                for ( size_t i = 0; i < entries.size() - 1; i++ )
-                {
-                    MMapEntry & entry = entries[ i ];
-
-                    uint64_t gapSize = entries[ i + 1 ].address  - ( entry.address + entry.length );
-                    if ( gapSize >= l )
-                    {
-                        uint64_t result = entry.address + entry.length;
-                        MMapEntry newEntry = { result, l };
-                        entries.insert( i + 1 + entries.begin(), newEntry );
-                        tracer.Trace( "  inserted in the gap, result %llx\n", result );
-                        zero_entry( i + 1 );
-                        trace_allocations();
-                        validate();
-                        return result;
-                    }
-                }
+            SpanMap::iterator span = free_spans.upper_bound( a );
+            if ( span == free_spans.begin() )
+                return false;
+            span--;
+            return ( ( a + l ) > a ) && ( ( a + l ) <= ( span->first + span->second ) );
+        } //is_free
 
-                // add a new entry at the end if space is available
+        uint64_t allocate_fixed( uint64_t a, uint64_t l )
+        {
+            // like MAP_FIXED, anything already allocated in the range is replaced. 0 if the range isn't in the arena
 
-                tracer.Trace( "  no sufficient gap found; adding a subsequent mmap entry\n" );
+            assert( 0 == ( a & 0xfff ) && 0 == ( l & 0xfff ) );
+            if ( ( 0 == l ) || ( a < base ) || ( ( a + l ) < a ) || ( ( a + l ) > ( base + length ) ) )
+            {
+                tracer.Trace( "  mmap fixed request %llx, %llu is outside of the arena\n", a, l );
+                return 0;
+            }
 
-                MMapEntry & entry = entries[ entries.size() - 1 ];
-                uint64_t free_offset = entry.address + entry.length;
+            if ( !commit_range( a, l ) )
+                return 0;
 
-                if ( l < ( length - ( free_offset - base ) ) )
+            for ( ;; )
+            {
+                SpanMap::iterator it = allocations.lower_bound( a );
+                if ( it != allocations.begin() )
                 {
-                    MMapEntry newentry = { free_offset, l };
-                    entries.push_back( newentry );
-                    zero_entry( entries.size() - 1 );
-                    trace_allocations();
-                    validate();
-                    peak = ( free_offset - base + l );
-                    return free_offset;
+                    SpanMap::iterator prev = it;
+                    prev--;
+                    if ( ( prev->first + prev->second ) > a )
+                        it = prev;
                 }
+
+                if ( ( it == allocations.end() ) || ( it->first >= ( a + l ) ) )
+                    break;
+
+                uint64_t start = get_max( it->first, a );
+                uint64_t end = get_min( it->first + it->second, a + l );
+                free( start, end - start );
             }
 
-            tracer.Trace( "  mmap alloc request %llu can't be met\n", l );
-            return 0;
-        } //allocate
+            SpanMap::iterator span = free_spans.upper_bound( a ); // the whole range is now in one coalesced free span
+            span--;
+            take_free( span, a, l );
+            allocations[ a ] = l;
+            peak = get_max( peak, a + l - base );
+            zero_range( a, l );
+            tracer.Trace( "  mmap allocated %llu bytes at fixed address %llx\n", l, a );
+            trace_allocations();
+            validate();
+            return a;
+        } //allocate_fixed
 
         bool free( uint64_t a, uint64_t l )
         {
-            trace_allocations();
-            size_t match = binary_search( a );
-            if ( -1 != match )
-            {
-                if ( l < entries[ match ].length )
-                    entries[ match ].length = l;
-                else
-                    entries.erase( entries.begin() + match );
-                trace_allocations();
-                validate();
-            }
-            else
+            // like munmap, any page range within an allocation can be freed. what's left on either side stays allocated
+
+            SpanMap::iterator match = allocations.upper_bound( a );
+            if ( match != allocations.begin() )
+                match--;
+
+            if ( ( match == allocations.end() ) || ( a < match->first ) || ( a >= ( match->first + match->second ) ) )
             {
                 tracer.Trace( "  munmap/free can't find entry %llu to free\n", a );
                 return false;
             }
 
+            uint64_t start = match->first;
+            uint64_t end = start + match->second;
+            if ( ( 0 == l ) || ( ( a + l ) > end ) )
+                l = end - a;
+
+            if ( a > start )
+                match->second = a - start;
+            else
+                allocations.erase( match );
+
+            if ( ( a + l ) < end )
+                allocations[ a + l ] = end - ( a + l );
+
+            add_free( a, l );
+
+            trace_allocations();
+            validate();
             return true;
         } //free
 
         uint64_t resize( uint64_t a, uint64_t old_l, uint64_t new_l, bool may_move )
         {
             assert( 0 == ( new_l & 0xfff ) );
-            trace_allocations();
-            size_t match = binary_search( a );
-            if ( -1 != match )
+            SpanMap::iterator match = allocations.find( a );
+            if ( match == allocations.end() )
             {
-                if ( new_l <= old_l )
-                {
-                    tracer.Trace( "  mremap/resize entry size shrunk\n" );
-                    entries[ match ].length = new_l;
-                    validate();
-                    return entries[ match ].address;
-                }
+                tracer.Trace( "  mremap/resize can't find entry %llu to resize\n", a );
+                return 0;
+            }
 
-                // check if it can be extended in place
+            uint64_t cur_l = match->second; // the app's old_l may not be page-rounded
+            tracer.Trace( "  mremap/resize from %llu (app says %llu) to %llu\n", cur_l, old_l, new_l );
 
-                if ( ( ( match == ( entries.size() - 1 ) ) && ( ( entries[ match ].address + new_l ) <= length ) ) ||
-                       ( ( entries[ match ].address + new_l ) < entries[ match + 1 ].address ) )
+            if ( new_l <= cur_l )
+            {
+                if ( new_l < cur_l )
                 {
-                    tracer.Trace( "  mremap extending entry %zu in place from size %llu to %llu\n", match, old_l, new_l );
-                    entries[ match ].length = new_l;
-                    validate();
-                    return a;
+                    add_free( a + new_l, cur_l - new_l );
+                    match->second = new_l;
                 }
+                validate();
+                return a;
+            }
 
-                if ( may_move )
-                {
-                    // first look for a gap large enough to work
-    
-                    for ( size_t i = 0; i < entries.size() - 1; i++ )
-                    {
-                        MMapEntry & entry = entries[ i ];
-    
-                        uint64_t gapSize = entries[ i + 1 ].address  - ( entry.address + entry.length );
-                        if ( gapSize >= new_l )
-                        {
-                            uint64_t result = entry.address + entry.length;
-                            MMapEntry newEntry = { result, new_l };
-                            tracer.Trace( "  mremap inserted in gap pmem %p, dst %#llx, src %#llx, old len %lld new len %lld\n",
-                                          pmem, newEntry.address, entries[ match ].address, entries[ match ].length, new_l );
-                            memcpy( pmem + newEntry.address, pmem + entries[ match ].address, entries[ match ].length );
-                            memset( pmem + newEntry.address + entries[ match ].length, 0, new_l - entries[ match ].length );
-                            entries.insert( i + 1 + entries.begin(), newEntry );
-                            match = binary_search( a ); // it may have moved after the insert
-                            entries.erase( entries.begin() + match );
-                            trace_allocations();
-                            validate();
-                            return result;
-                        }
-                    }
-
-                    // create a new entry at the end and memcpy the old to the new
-
-                    MMapEntry & lastEntry = entries[ entries.size() - 1 ];
-                    uint64_t free_offset = lastEntry.address + lastEntry.length;
-
-                    if ( new_l < ( length - ( free_offset - base ) ) )
-                    {
-                        tracer.Trace( "  free_offset %llx, new_l %llx\n", free_offset, new_l );
-                        MMapEntry newEntry = { free_offset, new_l };
-                        entries.push_back( newEntry );
-                        tracer.Trace( "  mremap added at end pmem %p, dst %#llx, src %#llx, old len %lld\n",
-                                      pmem, newEntry.address, entries[ match ].address, entries[ match ].length );
-                        memcpy( pmem + newEntry.address, pmem + entries[ match ].address, entries[ match ].length );
-                        memset( pmem + newEntry.address + entries[ match ].length, 0, new_l - entries[ match ].length );
-                        entries.erase( entries.begin() + match );
-                        trace_allocations();
-                        validate();
-                        peak = ( free_offset - base + new_l );
-                        return free_offset;
-                    }
-
-                    tracer.Trace( "  insufficient RAM left, so giving up on resize\n" );
-                }
-                else
-                    tracer.Trace( "  can't move the address, so giving up on resize\n" );
+            // extend in place if the free span just past the allocation is large enough
+
+            uint64_t extra = new_l - cur_l;
+            SpanMap::iterator next = free_spans.find( a + cur_l );
+            if ( ( next != free_spans.end() ) && ( next->second >= extra ) && commit_range( a + cur_l, extra ) )
+            {
+                tracer.Trace( "  mremap extending entry at %llx in place\n", a );
+                take_free( next, a + cur_l, extra );
+                match->second = new_l;
+                zero_range( a + cur_l, extra );
+                peak = get_max( peak, a + new_l - base );
+                trace_allocations();
+                validate();
+                return a;
+            }
+
+            if ( !may_move )
+            {
+                tracer.Trace( "  can't move the address, so giving up on resize\n" );
+                return 0;
             }
-            else
-                tracer.Trace( "  mremap/resize can't find entry %llu to resize\n", a );
 
-            return 0;
+            uint64_t result = allocate_span( new_l );
+            if ( 0 == result )
+            {
+                tracer.Trace( "  insufficient RAM left, so giving up on resize\n" );
+                return 0;
+            }
+
+            tracer.Trace( "  mremap moving from %#llx to %#llx\n", a, result );
+            memcpy( pmem + result, pmem + a, cur_l );
+            zero_range( result + cur_l, extra );
+            allocations.erase( a );
+            add_free( a, cur_l );
+            trace_allocations();
+            validate();
+            return result;
         } //resize
 };
-
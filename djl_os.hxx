@@ -339,6 +339,14 @@ inline char printable( uint8_t x )
     inline uint32_t flip_endian32( uint32_t x ) { return __builtin_bswap32( x ); }
     inline uint16_t flip_endian16( uint16_t x ) { return __builtin_bswap16( x ); }
 
+#elif ( defined( __GNUC__ ) && defined( __mc68000__ ) )
+
+    // the shift and mask versions below take dozens of instructions on the 68000
+
+    inline uint16_t flip_endian16( uint16_t x ) { __asm__ ( "ror.w #8, %0" : "+d" ( x ) ); return x; }
+    inline uint32_t flip_endian32( uint32_t x ) { __asm__ ( "ror.w #8, %0\n\tswap %0\n\tror.w #8, %0" : "+d" ( x ) ); return x; }
+    inline uint64_t flip_endian64( uint64_t x ) { return ( (uint64_t) flip_endian32( (uint32_t) x ) << 32 ) | flip_endian32( (uint32_t) ( x >> 32 ) ); }
+
 #elif defined( _MSC_VER )
 
     inline uint64_t flip_endian64( uint64_t x ) { return _byteswap_uint64( x ); }
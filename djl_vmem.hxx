@@ -0,0 +1,553 @@
+#pragma once
+
+// Guest RAM backed by a host virtual memory reservation instead of the heap. The usable range is surrounded by
+// inaccessible guard pages so guest loads and stores that stray outside of it fault in the host rather than
+// silently reading or corrupting host memory. is_guard() lets a signal or exception handler recognize those faults.
+// The interface is the subset of vector<uint8_t> the emulator uses: data(), size(), resize(), and [].
+// Unlike vector, resize() doesn't write the new bytes. The OS supplies zero-filled pages on first touch, so large
+// address spaces cost neither startup time nor RAM until the guest uses them.
+// On POSIX hosts with 4k pages, files and shared memory can be mapped directly over parts of the usable range for the
+// guest's mmap.
+// request_large_pages() before resize() asks for 2MB host pages so random access across a large guest doesn't miss
+// the host TLB as often: the usable range is 2MB-aligned and madvised for transparent huge pages on Linux, backed by
+// superpages on Intel macOS, and allocated with MEM_LARGE_PAGES on Windows if the account may lock pages in memory.
+// Windows large pages are committed up front and leave no room for guards. Other hosts use normal pages.
+// discard() zeroes a range by handing its pages back to the OS, so reused memory costs no RAM until touched again.
+// request_commit_on_demand() before resize() leaves the usable range reserved but inaccessible until commit() makes
+// parts of it readable and writable, so a huge reservation costs neither commit charge nor page tables until the guest
+// grows into it. is_guard() is true for the uncommitted parts. Windows large pages are still committed up front, and
+// macOS superpages aren't used then since they're mapped in whole; transparent huge pages are committed on demand.
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <map>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <unistd.h>
+    #include <stdio.h>
+    #ifdef __APPLE__
+        #include <mach/vm_statistics.h>
+    #endif
+#endif
+
+class CVirtualMemory
+{
+    private:
+        uint8_t * reservation;   // start of the lower guard
+        size_t reserved;         // bytes in the reservation including both guards
+        size_t guard;            // bytes in each guard
+        uint8_t * pmem;          // usable memory just above the lower guard
+        size_t used;             // what size() returns
+        size_t capacity;         // usable bytes; size rounded up to a page or more
+        size_t touched;          // high-water mark of size. bytes beyond it are still zero from the OS
+        bool large_requested;    // try for 2MB host pages
+        bool large_obtained;     // the host accepted the request for the current reservation
+        bool lazy_requested;     // commit only what commit() asks for
+        bool lazy;               // the current reservation is committed piecemeal
+        std::map<size_t, size_t> committed; // offset -> length of the accessible parts of the usable range, coalesced
+
+        static const size_t large_page = 2 * 1024 * 1024;
+        static const size_t commit_chunk = 2 * 1024 * 1024; // a large page, so commits don't split huge pages
+
+        static size_t page_size()
+        {
+            #ifdef _WIN32
+                SYSTEM_INFO si;
+                GetSystemInfo( &si );
+                return si.dwPageSize;
+            #else
+                return (size_t) sysconf( _SC_PAGESIZE );
+            #endif
+        } //page_size
+
+        static size_t default_guard()
+        {
+            // large enough on 64-bit hosts that guest null pointers and typical overruns land in a guard.
+            // address space is precious on 32-bit hosts.
+
+            return ( sizeof( void * ) >= 8 ) ? ( 64 * 1024 * 1024 ) : ( 64 * 1024 );
+        } //default_guard
+
+        #ifdef _WIN32
+            static bool enable_lock_memory_privilege()
+            {
+                HANDLE token;
+                if ( !OpenProcessToken( GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token ) )
+                    return false;
+
+                TOKEN_PRIVILEGES tp;
+                tp.PrivilegeCount = 1;
+                tp.Privileges[ 0 ].Attributes = SE_PRIVILEGE_ENABLED;
+                bool ok = LookupPrivilegeValueA( 0, "SeLockMemoryPrivilege", &tp.Privileges[ 0 ].Luid ) &&
+                          AdjustTokenPrivileges( token, FALSE, &tp, 0, 0, 0 ) && ( ERROR_SUCCESS == GetLastError() );
+                CloseHandle( token );
+                return ok;
+            } //enable_lock_memory_privilege
+        #endif
+
+        static uint8_t * reserve_large( size_t usable )
+        {
+            // windows large pages must be reserved and committed in one call, so there are no guards
+
+            #ifdef _WIN32
+                size_t minimum = GetLargePageMinimum();
+                if ( ( 0 == minimum ) || !enable_lock_memory_privilege() )
+                    return 0;
+                usable = ( usable + minimum - 1 ) & ~( minimum - 1 );
+                return (uint8_t *) VirtualAlloc( 0, usable, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE );
+            #else
+                return 0;
+            #endif
+        } //reserve_large
+
+        static size_t large_alignment()
+        {
+            #ifdef _WIN32
+                return 0; // reserve_large() is the only way
+            #else
+                return large_page;
+            #endif
+        } //large_alignment
+
+        static bool advise_large( uint8_t * p, size_t usable, bool on_demand )
+        {
+            // p is 2MB-aligned. it's read/write unless on_demand, when it's inaccessible until commit()
+
+            #if defined( __linux__ ) && defined( MADV_HUGEPAGE )
+                (void) on_demand;
+                return 0 == madvise( p, usable, MADV_HUGEPAGE );
+            #elif defined( __APPLE__ ) && defined( VM_FLAGS_SUPERPAGE_SIZE_2MB )
+                size_t length = usable & ~( large_page - 1 );
+                if ( ( 0 == length ) || on_demand ) // superpages would make the whole range accessible
+                    return false;
+                void * pv = mmap( p, length, PROT_READ | PROT_WRITE, MAP_FIXED | MAP_PRIVATE | MAP_ANON, VM_FLAGS_SUPERPAGE_SIZE_2MB, 0 );
+                if ( MAP_FAILED != pv )
+                    return true;
+                mmap( p, length, PROT_READ | PROT_WRITE, MAP_FIXED | MAP_PRIVATE | MAP_ANON, -1, 0 );
+                return false;
+            #else
+                (void) p;
+                (void) usable;
+                (void) on_demand;
+                return false;
+            #endif
+        } //advise_large
+
+        static bool make_accessible( uint8_t * p, size_t length )
+        {
+            #ifdef _WIN32
+                return 0 != VirtualAlloc( p, length, MEM_COMMIT, PAGE_READWRITE );
+            #else
+                return 0 == mprotect( p, length, PROT_READ | PROT_WRITE );
+            #endif
+        } //make_accessible
+
+        static uint8_t * reserve( size_t total, size_t & low_guard, size_t usable, size_t align, bool accessible )
+        {
+            // total includes align bytes of slack. low_guard grows to put the usable range on an align boundary.
+            // the usable range is left inaccessible unless accessible is true
+
+            #ifdef _WIN32
+                uint8_t * p = (uint8_t *) VirtualAlloc( 0, total, MEM_RESERVE, PAGE_NOACCESS );
+                if ( 0 == p )
+                    return 0;
+                if ( accessible && !make_accessible( p + low_guard, usable ) )
+                {
+                    VirtualFree( p, 0, MEM_RELEASE );
+                    return 0;
+                }
+                return p;
+            #else
+                int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+                #ifdef MAP_NORESERVE
+                    flags |= MAP_NORESERVE;
+                #endif
+                void * pv = mmap( 0, total, PROT_NONE, flags, -1, 0 );
+                if ( MAP_FAILED == pv )
+                    return 0;
+                uint8_t * p = (uint8_t *) pv;
+                if ( 0 != align )
+                    low_guard = (size_t) ( ( ( (uintptr_t) p + low_guard + align - 1 ) & ~(uintptr_t) ( align - 1 ) ) - (uintptr_t) p );
+                if ( accessible && !make_accessible( p + low_guard, usable ) )
+                {
+                    munmap( p, total );
+                    return 0;
+                }
+                return p;
+            #endif
+        } //reserve
+
+        static void unreserve( uint8_t * p, size_t total )
+        {
+            #ifdef _WIN32
+                (void) total;
+                VirtualFree( p, 0, MEM_RELEASE );
+            #else
+                munmap( p, total );
+            #endif
+        } //unreserve
+
+        void release()
+        {
+            if ( 0 != reservation )
+                unreserve( reservation, reserved );
+
+            reservation = 0;
+            reserved = 0;
+            guard = 0;
+            pmem = 0;
+            used = 0;
+            capacity = 0;
+            touched = 0;
+            large_obtained = false;
+            lazy = false;
+            committed.clear();
+        } //release
+
+        void add_committed( size_t offset, size_t length )
+        {
+            // coalesce with the ranges on either side
+
+            size_t end = offset + length;
+            std::map<size_t, size_t>::iterator it = committed.upper_bound( offset );
+            if ( it != committed.begin() )
+            {
+                std::map<size_t, size_t>::iterator prev = it;
+                prev--;
+                if ( ( prev->first + prev->second ) >= offset )
+                    it = prev;
+            }
+
+            while ( ( it != committed.end() ) && ( it->first <= end ) )
+            {
+                offset = get_min( offset, it->first );
+                end = get_max( end, it->first + it->second );
+                committed.erase( it++ );
+            }
+
+            committed[ offset ] = end - offset;
+        } //add_committed
+
+        bool is_committed( size_t offset ) const
+        {
+            std::map<size_t, size_t>::const_iterator it = committed.upper_bound( offset );
+            if ( it == committed.begin() )
+                return false;
+            it--;
+            return offset < ( it->first + it->second );
+        } //is_committed
+
+        void zero( size_t from, size_t to ) // only committed bytes can be dirty
+        {
+            for ( std::map<size_t, size_t>::iterator it = committed.begin(); it != committed.end(); it++ )
+            {
+                size_t start = get_max( from, it->first );
+                size_t end = get_min( to, it->first + it->second );
+                if ( start < end )
+                    memset( pmem + start, 0, end - start );
+            }
+        } //zero
+
+    public:
+        CVirtualMemory() : reservation( 0 ), reserved( 0 ), guard( 0 ), pmem( 0 ), used( 0 ), capacity( 0 ), touched( 0 ),
+                           large_requested( false ), large_obtained( false ), lazy_requested( false ), lazy( false ) {}
+        ~CVirtualMemory() { release(); }
+
+        void request_large_pages( bool large ) { large_requested = large; }
+        bool large_pages() const { return large_obtained; }
+        void request_commit_on_demand( bool on_demand ) { lazy_requested = on_demand; }
+        bool commits_on_demand() const { return lazy; }
+        const std::map<size_t, size_t> & committed_ranges() const { return committed; }
+
+        size_t committed_bytes() const
+        {
+            size_t total = 0;
+            for ( std::map<size_t, size_t>::const_iterator it = committed.begin(); it != committed.end(); it++ )
+                total += it->second;
+            return total;
+        } //committed_bytes
+
+        bool commit( size_t offset, size_t length )
+        {
+            // make [offset, offset + length) readable and writable, in whole chunks. parts already committed, which
+            // may have files mapped over them, are left alone. false if the range is outside the usable range or
+            // the host is out of memory
+
+            if ( ( ( offset + length ) < offset ) || ( ( offset + length ) > capacity ) )
+                return false;
+            if ( 0 == length )
+                return true;
+
+            size_t start = offset & ~( commit_chunk - 1 );
+            size_t end = get_min( ( offset + length + commit_chunk - 1 ) & ~( commit_chunk - 1 ), capacity );
+
+            while ( start < end )
+            {
+                // skip the committed range containing start, if any, then commit the gap up to the next one
+
+                std::map<size_t, size_t>::iterator it = committed.upper_bound( start );
+                if ( it != committed.begin() )
+                {
+                    std::map<size_t, size_t>::iterator prev = it;
+                    prev--;
+                    if ( ( prev->first + prev->second ) > start )
+                    {
+                        start = prev->first + prev->second;
+                        continue;
+                    }
+                }
+
+                size_t gap_end = ( it == committed.end() ) ? end : get_min( end, it->first );
+                if ( !make_accessible( pmem + start, gap_end - start ) )
+                    return false;
+                add_committed( start, gap_end - start );
+                start = gap_end;
+            }
+
+            return true;
+        } //commit
+
+        void discard( size_t offset, size_t length )
+        {
+            // make committed [offset, offset + length) zero. whole host pages are replaced with fresh ones, so memory
+            // the guest freed and allocated again takes no RAM until it's touched. small ranges are cheaper to clear
+
+            size_t page = page_size();
+            size_t start = ( offset + page - 1 ) & ~( page - 1 );
+            size_t end = ( offset + length ) & ~( page - 1 );
+            bool replace = ( end > start ) && ( ( end - start ) >= ( 64 * 1024 ) );
+            #if defined( _WIN32 ) || defined( __APPLE__ )
+                replace = replace && !large_obtained; // windows large pages can't be decommitted, nor macos superpages split
+            #endif
+
+            if ( replace )
+            {
+                #ifdef _WIN32
+                    replace = VirtualFree( pmem + start, end - start, MEM_DECOMMIT ) && make_accessible( pmem + start, end - start );
+                #else
+                    // not madvise( MADV_DONTNEED ), which would bring back a -restore snapshot's file pages. the flags
+                    // match reserve()'s so the kernel can merge the mapping with its neighbors
+
+                    int flags = MAP_FIXED | MAP_PRIVATE | MAP_ANONYMOUS;
+                    #ifdef MAP_NORESERVE
+                        flags |= MAP_NORESERVE;
+                    #endif
+                    void * pv = mmap( pmem + start, end - start, PROT_READ | PROT_WRITE, flags, -1, 0 );
+                    replace = ( MAP_FAILED != pv );
+                    #if defined( __linux__ ) && defined( MADV_HUGEPAGE )
+                        if ( replace && large_obtained )
+                            madvise( pmem + start, end - start, MADV_HUGEPAGE );
+                    #endif
+                #endif
+            }
+
+            if ( !replace )
+            {
+                memset( pmem + offset, 0, length );
+                return;
+            }
+
+            memset( pmem + offset, 0, start - offset );
+            memset( pmem + end, 0, ( offset + length ) - end );
+        } //discard
+
+        size_t large_page_bytes() const
+        {
+            // how much of the usable range is in large pages now. linux promotes pages as they're touched and may
+            // split them under memory pressure, so this reads the mapping's AnonHugePages from /proc
+
+            if ( !large_obtained )
+                return 0;
+
+            #if defined( __linux__ )
+                FILE * fp = fopen( "/proc/self/smaps", "r" );
+                if ( 0 == fp )
+                    return 0;
+
+                size_t total = 0;
+                bool inside = false;
+                char line[ 256 ];
+                while ( fgets( line, sizeof( line ), fp ) )
+                {
+                    unsigned long long start, end;
+                    size_t kb;
+                    if ( 2 == sscanf( line, "%llx-%llx ", &start, &end ) )
+                        inside = ( start < (unsigned long long) ( pmem + capacity ) ) && ( end > (unsigned long long) pmem );
+                    else if ( inside && ( 1 == sscanf( line, "AnonHugePages: %zu kB", &kb ) ) )
+                        total += kb * 1024;
+                }
+                fclose( fp );
+                return total;
+            #else
+                return capacity;
+            #endif
+        } //large_page_bytes
+
+        uint8_t * data() { return pmem; }
+        const uint8_t * data() const { return pmem; }
+        size_t size() const { return used; }
+        uint8_t & operator[]( size_t i ) { return pmem[ i ]; }
+        size_t guard_size() const { return guard; }
+
+        bool is_guard( const void * p ) const
+        {
+            const uint8_t * pb = (const uint8_t *) p;
+            if ( ( pb < reservation ) || ( pb >= ( reservation + reserved ) ) )
+                return false;
+            if ( ( pb < pmem ) || ( pb >= ( pmem + capacity ) ) )
+                return 0 != guard;
+            return lazy && !is_committed( (size_t) ( pb - pmem ) );
+        } //is_guard
+
+        bool can_map_files() const // guest mmap offsets and lengths are only 4k-aligned
+        {
+            #ifdef _WIN32
+                return false;
+            #else
+                return ( 0 != pmem ) && ( 4096 == page_size() );
+            #endif
+        } //can_map_files
+
+        bool map_file( size_t offset, size_t length, int fd, uint64_t file_offset, bool shared, bool writable )
+        {
+            // replace [offset, offset + length) with a view of the file. false with errno set if the host refuses
+
+            #ifdef _WIN32
+                return false;
+            #else
+                // private mappings are copy-on-write, so they're always writable like the rest of guest memory
+
+                int prot = PROT_READ | ( ( writable || !shared ) ? PROT_WRITE : 0 );
+                void * p = mmap( pmem + offset, length, prot, MAP_FIXED | ( shared ? MAP_SHARED : MAP_PRIVATE ), fd, (off_t) file_offset );
+                if ( MAP_FAILED != p )
+                    return true;
+
+                int e = errno;
+                unmap_file( offset, length ); // a failed MAP_FIXED may have removed the pages that were there
+                errno = e;
+                return false;
+            #endif
+        } //map_file
+
+        bool map_shared( size_t offset, size_t length )
+        {
+            // replace [offset, offset + length) with zero-filled memory that forked children share with this process
+
+            #ifdef _WIN32
+                return false;
+            #else
+                void * p = mmap( pmem + offset, length, PROT_READ | PROT_WRITE, MAP_FIXED | MAP_SHARED | MAP_ANONYMOUS, -1, 0 );
+                if ( MAP_FAILED != p )
+                    return true;
+
+                int e = errno;
+                unmap_file( offset, length );
+                errno = e;
+                return false;
+            #endif
+        } //map_shared
+
+        void unmap_file( size_t offset, size_t length )
+        {
+            // put back zero-filled anonymous memory
+
+            #ifndef _WIN32
+                mmap( pmem + offset, length, PROT_READ | PROT_WRITE, MAP_FIXED | MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+            #endif
+        } //unmap_file
+
+        void sync_file( size_t offset, size_t length, bool wait )
+        {
+            #ifndef _WIN32
+                msync( pmem + offset, length, wait ? MS_SYNC : MS_ASYNC );
+            #endif
+        } //sync_file
+
+        bool resize( size_t n ) // like vector::resize, existing contents are kept and new bytes are zero
+        {
+            if ( n <= capacity )
+            {
+                if ( n > used ) // only bytes that were in use before a shrink need zeroing
+                    zero( get_min( used, touched ), get_min( n, touched ) );
+                used = n;
+                touched = get_max( touched, n );
+                return true;
+            }
+
+            size_t page = page_size();
+            size_t usable = ( n + page - 1 ) & ~( page - 1 );
+            size_t g = ( default_guard() + page - 1 ) & ~( page - 1 );
+            size_t low = g;
+            size_t align = 0;
+            uint8_t * p = 0;
+            bool large = false;
+            bool on_demand = lazy_requested;
+
+            if ( large_requested )
+            {
+                p = reserve_large( usable );
+                large = ( 0 != p );
+                if ( large )
+                {
+                    g = low = 0;
+                    on_demand = false; // committed by reserve_large()
+                }
+                else
+                    align = large_alignment();
+            }
+
+            if ( ( 0 == p ) && ( ( usable + 2 * g + align ) > usable ) )
+                p = reserve( usable + 2 * g + align, low, usable, align, !on_demand );
+
+            if ( 0 == p ) // there may not be room for guards on small hosts
+            {
+                g = low = align = 0;
+                p = reserve( usable, low, usable, 0, !on_demand );
+                if ( 0 == p )
+                    return false;
+            }
+
+            if ( 0 != align )
+                large = advise_large( p + low, usable, on_demand );
+
+            // existing contents move to the new reservation, committed there as they were here. if that can't be
+            // done the old reservation is kept as it was
+
+            std::map<size_t, size_t> moved;
+            for ( std::map<size_t, size_t>::iterator it = committed.begin(); it != committed.end(); it++ )
+            {
+                if ( it->first >= used )
+                    continue;
+                if ( on_demand )
+                {
+                    if ( !make_accessible( p + low + it->first, it->second ) )
+                    {
+                        unreserve( p, usable + 2 * g + align );
+                        return false;
+                    }
+                    moved[ it->first ] = it->second;
+                }
+                memcpy( p + low + it->first, pmem + it->first, get_min( it->second, used - it->first ) );
+            }
+
+            release();
+            reservation = p;
+            reserved = usable + 2 * g + align;
+            guard = g;
+            pmem = p + low;
+            used = n;
+            capacity = usable;
+            touched = n;
+            large_obtained = large;
+            lazy = on_demand;
+            if ( on_demand )
+                committed.swap( moved );
+            else
+                committed[ 0 ] = usable;
+            return true;
+        } //resize
+};
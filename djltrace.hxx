@@ -7,6 +7,8 @@
 // By default the tracing file is placed in %temp%\tracer.txt
 // Arguments to Trace() are just like printf. e.g.:
 //    tracer.Trace( "what to log with an integer argument %d and a wide string %ws\n", 10, pwcHello );
+// After Enable(), SetAsync( true ) makes traces cheap for the calling threads: each thread formats into its own
+// buffer and a background thread writes full buffers to the file. Flush() and Shutdown() write everything pending.
 //
 
 #include <stdio.h>
@@ -15,6 +17,10 @@
 #include <stdarg.h>
 #include <sys/types.h>
 #include <mutex>
+#if !defined( WATCOM ) && !defined( OLDGCC ) && !defined( __mc68000__ )
+#include <thread>
+#include <condition_variable>
+#endif
 #include <memory>
 #include <vector>
 #include <cstring>
@@ -46,6 +52,211 @@ class CDJLTrace
 #endif
         bool quiet; // no pid
         bool flush; // flush after each write
+        unsigned pid; // captured by Enable so traces don't make a system call
+
+#if !defined( WATCOM ) && !defined( OLDGCC ) && !defined( __mc68000__ )
+        // async mode. threads only contend when handing a full buffer to the writer. text from one thread stays
+        // in order, but text from different threads is interleaved a buffer at a time rather than line by line.
+        // lock order: registryMtx, then a ThreadBuffer's mtx, then queueMtx
+
+        static const size_t asyncBufferSize = 64 * 1024;
+        static const size_t asyncMaxQueued = 64; // tracing threads wait for the writer beyond this
+
+        struct ThreadBuffer
+        {
+            CDJLTrace * owner; // the tracer this thread's buffer is registered with
+            std::mutex mtx;    // only contended when another thread drains the buffer
+            vector<char> text;
+            size_t used;
+
+            ThreadBuffer() : owner( 0 ), used( 0 ) {}
+            ~ThreadBuffer() { if ( 0 != owner ) owner->RetireBuffer( this ); }
+        };
+
+        bool async;
+        bool stopping;                      // the writer exits once the queue is empty
+        size_t writing;                     // buffers the writer took from the queue and hasn't finished
+        std::thread writer;
+        std::mutex registryMtx;             // guards buffers
+        vector<ThreadBuffer *> buffers;     // threads that have traced in async mode
+        std::mutex queueMtx;                // guards queue, spares, stopping, and writing
+        std::condition_variable queued;     // signaled when there is work for the writer
+        std::condition_variable written;    // signaled when the writer finishes a batch
+        vector<vector<char>> queue;
+        vector<vector<char>> spares;        // written buffers kept for reuse
+
+        static ThreadBuffer & LocalBuffer()
+        {
+            static thread_local ThreadBuffer tb;
+            return tb;
+        } //LocalBuffer
+
+        void QueueBuffer( ThreadBuffer & tb )
+        {
+            // the caller holds tb.mtx. tb gets an empty buffer in exchange
+
+            if ( 0 != tb.used )
+            {
+                tb.text.resize( tb.used );
+                unique_lock<mutex> lock( queueMtx );
+                while ( queue.size() >= asyncMaxQueued )
+                    written.wait( lock );
+                queue.push_back( std::move( tb.text ) );
+                tb.text.clear();
+                if ( !spares.empty() )
+                {
+                    tb.text.swap( spares.back() );
+                    spares.pop_back();
+                }
+                tb.used = 0;
+                queued.notify_one();
+            }
+
+            if ( tb.text.size() < asyncBufferSize )
+                tb.text.resize( asyncBufferSize );
+        } //QueueBuffer
+
+        void AppendVA( ThreadBuffer & tb, const char * format, va_list args )
+        {
+            va_list retry;
+            va_copy( retry, args );
+            size_t available = tb.text.size() - tb.used;
+            int len = vsnprintf( tb.text.data() + tb.used, available, format, args );
+
+            if ( ( len >= 0 ) && ( (size_t) len >= available ) ) // doesn't fit; start a new buffer
+            {
+                QueueBuffer( tb );
+                if ( tb.text.size() <= (size_t) len )
+                    tb.text.resize( 1 + len );
+                len = vsnprintf( tb.text.data(), tb.text.size(), format, retry );
+            }
+
+            va_end( retry );
+            if ( len > 0 )
+                tb.used += len;
+        } //AppendVA
+
+        void Append( ThreadBuffer & tb, const char * format, ... )
+        {
+            va_list args;
+            va_start( args, format );
+            AppendVA( tb, format, args );
+            va_end( args );
+        } //Append
+
+        void WriterThread()
+        {
+            unique_lock<mutex> lock( queueMtx );
+
+            for ( ;; )
+            {
+                while ( queue.empty() && !stopping )
+                    queued.wait( lock );
+
+                if ( queue.empty() )
+                    break;
+
+                vector<vector<char>> batch;
+                batch.swap( queue );
+                writing = batch.size();
+                lock.unlock();
+
+                for ( size_t i = 0; i < batch.size(); i++ )
+                    fwrite( batch[ i ].data(), 1, batch[ i ].size(), fp );
+                if ( flush )
+                    fflush( fp );
+
+                lock.lock();
+                for ( size_t i = 0; i < batch.size() && spares.size() < 4; i++ )
+                    spares.push_back( std::move( batch[ i ] ) );
+                writing = 0;
+                written.notify_all();
+            }
+        } //WriterThread
+
+        void Drain()
+        {
+            // queue what every thread has buffered and wait until the writer has written it
+
+            {
+                lock_guard<mutex> registry( registryMtx );
+                for ( size_t i = 0; i < buffers.size(); i++ )
+                {
+                    lock_guard<mutex> lock( buffers[ i ]->mtx );
+                    QueueBuffer( * buffers[ i ] );
+                }
+            }
+
+            unique_lock<mutex> lock( queueMtx );
+            while ( !queue.empty() || ( 0 != writing ) )
+                written.wait( lock );
+        } //Drain
+
+        void StopAsync()
+        {
+            async = false;
+            Drain();
+
+            {
+                lock_guard<mutex> lock( queueMtx );
+                stopping = true;
+                queued.notify_one();
+            }
+
+            writer.join();
+        } //StopAsync
+
+        void RetireBuffer( ThreadBuffer * ptb )
+        {
+            // a thread that traced in async mode is exiting. queue whatever it has left
+
+            lock_guard<mutex> registry( registryMtx );
+            for ( size_t i = 0; i < buffers.size(); i++ )
+            {
+                if ( ptb == buffers[ i ] )
+                {
+                    buffers.erase( buffers.begin() + i );
+                    break;
+                }
+            }
+
+            lock_guard<mutex> lock( ptb->mtx );
+            if ( async )
+                QueueBuffer( *ptb );
+            ptb->owner = 0;
+        } //RetireBuffer
+#endif
+
+        bool TraceAsync( bool prefix, const char * format, va_list args )
+        {
+            // false if the trace wasn't handled and args is untouched
+
+#if !defined( WATCOM ) && !defined( OLDGCC ) && !defined( __mc68000__ )
+            if ( async )
+            {
+                ThreadBuffer & tb = LocalBuffer();
+
+                if ( 0 == tb.owner )
+                {
+                    lock_guard<mutex> registry( registryMtx );
+                    tb.owner = this;
+                    buffers.push_back( &tb );
+                }
+                else if ( this != tb.owner ) // registered with another tracer
+                    return false;
+
+                lock_guard<mutex> lock( tb.mtx );
+                if ( tb.text.size() < asyncBufferSize )
+                    tb.text.resize( asyncBufferSize );
+                if ( prefix )
+                    Append( tb, "PID %6u -- ", pid );
+                AppendVA( tb, format, args );
+                return true;
+            }
+#endif
+
+            return false;
+        } //TraceAsync
 
         static char * appendHexNibble( char * p, uint8_t val )
         {
@@ -132,7 +343,11 @@ class CDJLTrace
         } //ShowBinaryData
 
     public:
-        CDJLTrace() : fp( NULL ), quiet( false ), flush( true ) {}
+#if !defined( WATCOM ) && !defined( OLDGCC ) && !defined( __mc68000__ )
+        CDJLTrace() : fp( NULL ), quiet( false ), flush( true ), pid( 0 ), async( false ), stopping( false ), writing( 0 ) {}
+#else
+        CDJLTrace() : fp( NULL ), quiet( false ), flush( true ), pid( 0 ) {}
+#endif
 
         bool Enable( bool enable, const wchar_t * pcLogFile = NULL, bool destroyContents = false )
         {
@@ -153,6 +368,11 @@ class CDJLTrace
 
             if ( enable )
             {
+#ifdef _WIN32
+                pid = (unsigned) _getpid();
+#else
+                pid = (unsigned) getpid();
+#endif
                 const char * mode = destroyContents ? "w+t" : "a+t";
 
                 if ( NULL == pcLogFile )
@@ -190,6 +410,11 @@ class CDJLTrace
 
         void Shutdown()
         {
+#if !defined( WATCOM ) && !defined( OLDGCC ) && !defined( __mc68000__ )
+            if ( async )
+                StopAsync();
+#endif
+
             if ( NULL != fp )
             {
                 fflush( fp );
@@ -201,43 +426,119 @@ class CDJLTrace
         ~CDJLTrace()
         {
             Shutdown();
+
+#if !defined( WATCOM ) && !defined( OLDGCC ) && !defined( __mc68000__ )
+            lock_guard<mutex> registry( registryMtx ); // threads that exit later mustn't call back
+            for ( size_t i = 0; i < buffers.size(); i++ )
+                buffers[ i ]->owner = 0;
+#endif
         } //~CDJLTrace
 
         bool IsEnabled() { return ( 0 != fp ); }
 
         void SetQuiet( bool q ) { quiet = q; }
 
-        void SetFlushEachTrace( bool f ) { flush = f; }
+        bool GetQuiet() { return quiet; }
 
-        void Flush() { if ( 0 != fp ) fflush( fp ); }
+        FILE * SetFile( FILE * f ) // e.g. to capture traces. returns the previous file
+        {
+            Flush(); // pending async text belongs to the old file
+            FILE * old = fp;
+            fp = f;
+            return old;
+        } //SetFile
 
-        void Trace( const char * format, ... )
+        void SetFlushEachTrace( bool f ) { flush = f; } // in async mode, the writer flushes after each batch
+
+        bool SetAsync( bool a ) // call after Enable(). returns whether async mode is in effect
         {
-            if ( NULL != fp )
+#if !defined( WATCOM ) && !defined( OLDGCC ) && !defined( __mc68000__ )
+            if ( a && !async && ( NULL != fp ) )
+            {
+                stopping = false;
+                writing = 0;
+                writer = std::thread( &CDJLTrace::WriterThread, this );
+                async = true;
+            }
+            else if ( !a && async )
+                StopAsync();
+
+            return async;
+#else
+            return false;
+#endif
+        } //SetAsync
+
+        void Flush()
+        {
+            if ( 0 != fp )
             {
 #if !defined( WATCOM ) && !defined( OLDGCC ) && !defined( __mc68000__ )
-                lock_guard<mutex> lock( mtx );
+                if ( async )
+                    Drain();
 #endif
+                fflush( fp );
+            }
+        } //Flush
+
+#if !defined( _WIN32 ) && !defined( WATCOM ) && !defined( OLDGCC ) && !defined( __mc68000__ )
+        void BeforeFork()
+        {
+            // hold the locks across fork() so the child can't inherit one held by another thread. then call
+            // AfterFork() in the child or AfterForkParent() in the parent
+
+            Flush();
+            registryMtx.lock();
+            mtx.lock();
+        } //BeforeFork
+
+        void AfterForkParent()
+        {
+            mtx.unlock();
+            registryMtx.unlock();
+        } //AfterForkParent
+
+        void AfterFork()
+        {
+            // in the child of fork(), which has just the calling thread. the writer thread wasn't copied, so the
+            // child traces synchronously. call BeforeFork() before forking so nothing queued is lost
 
+            mtx.unlock();
+            registryMtx.unlock();
+            pid = (unsigned) getpid();
+            if ( async )
+            {
+                async = false;
+                new ( & writer ) std::thread(); // the parent's writer isn't this process's to join
+                buffers.clear();
+            }
+        } //AfterFork
+#endif
+
+        void Trace( const char * format, ... )
+        {
+            if ( NULL != fp )
+            {
                 va_list args;
                 va_start( args, format );
-                if ( !quiet )
-                    fprintf( fp, "PID %6u -- ",
-#ifdef _WIN32
-                             (unsigned) _getpid() );
-#else
-                             getpid() );
+                if ( !TraceAsync( !quiet, format, args ) )
+                {
+#if !defined( WATCOM ) && !defined( OLDGCC ) && !defined( __mc68000__ )
+                    lock_guard<mutex> lock( mtx );
 #endif
-                vfprintf( fp, format, args );
+                    if ( !quiet )
+                        fprintf( fp, "PID %6u -- ", pid );
+                    vfprintf( fp, format, args );
+                    if ( flush )
+                        fflush( fp );
+                }
                 va_end( args );
-                if ( flush )
-                    fflush( fp );
             }
         } //Trace
 
         void TraceVA( const char * format, va_list args )
         {
-            if ( NULL != fp )
+            if ( NULL != fp && !TraceAsync( false, format, args ) )
             {
                 vfprintf( fp, format, args );
                 if ( flush )
@@ -251,29 +552,35 @@ class CDJLTrace
         {
             if ( NULL != fp )
             {
-#if !defined( WATCOM ) && !defined( OLDGCC ) && !defined( __mc68000__ )
-                lock_guard<mutex> lock( mtx );
-#endif
                 va_list args;
                 va_start( args, format );
-                vfprintf( fp, format, args );
+                if ( !TraceAsync( false, format, args ) )
+                {
+#if !defined( WATCOM ) && !defined( OLDGCC ) && !defined( __mc68000__ )
+                    lock_guard<mutex> lock( mtx );
+#endif
+                    vfprintf( fp, format, args );
+                    if ( flush )
+                        fflush( fp );
+                }
                 va_end( args );
-                if ( flush )
-                    fflush( fp );
             }
         } //TraceQuiet
 
         void TraceIt( const char * format, ... )
         {
-#if !defined( WATCOM ) && !defined( OLDGCC ) && !defined( __mc68000__ )
-            lock_guard<mutex> lock( mtx );
-#endif
             va_list args;
             va_start( args, format );
-            vfprintf( fp, format, args );
+            if ( !TraceAsync( false, format, args ) )
+            {
+#if !defined( WATCOM ) && !defined( OLDGCC ) && !defined( __mc68000__ )
+                lock_guard<mutex> lock( mtx );
+#endif
+                vfprintf( fp, format, args );
+                if ( flush )
+                    fflush( fp );
+            }
             va_end( args );
-            if ( flush )
-                fflush( fp );
         } //TraceIt
 
         void TraceDebug( bool condition, const char * format, ... )
@@ -281,23 +588,20 @@ class CDJLTrace
             #ifdef DEBUG
             if ( NULL != fp && condition )
             {
-#if !defined( WATCOM ) && !defined( OLDGCC ) && !defined( __mc68000__ )
-                lock_guard<mutex> lock( mtx );
-#endif
-
                 va_list args;
                 va_start( args, format );
-                if ( !quiet )
-                    fprintf( fp, "PID %6u -- ",
-#ifdef _WIN32
-                             _getpid() );
-#else
-                             getpid() );
+                if ( !TraceAsync( !quiet, format, args ) )
+                {
+#if !defined( WATCOM ) && !defined( OLDGCC ) && !defined( __mc68000__ )
+                    lock_guard<mutex> lock( mtx );
 #endif
-                vfprintf( fp, format, args );
+                    if ( !quiet )
+                        fprintf( fp, "PID %6u -- ", pid );
+                    vfprintf( fp, format, args );
+                    if ( flush )
+                        fflush( fp );
+                }
                 va_end( args );
-                if ( flush )
-                    fflush( fp );
             }
             #else
 #if !defined( WATCOM ) && !defined( __APPLE__ ) && !defined( __clang__ ) && !defined (OLDGCC)
@@ -33,6 +33,9 @@
 #define emulator_sys_set_thread_area    0x2010 // exists for x32 and some other platforms
 #define emulator_sys_get_thread_area    0x2011 // exists for x32 and some other platforms
 #define emulator_sys_ugetrlimit         0x2012 // exists for x32 and some other platforms
+#define emulator_sys_snapshot           0x2013 // the app's initialization is done. -snap saves its state here
+#define emulator_sys_run_nested         0x2014 // an armos app asks its parent armos to run an app in its place
+#define emulator_sys_counters           0x2015 // the emulator's instruction, syscall, brk, and mmap counters
 
 // Linux syscall numbers differ by ISA. InSAne. These are RISC and ARM64, which are the same!
 // Note that there are differences between these two sets. which is correct?
@@ -43,6 +46,11 @@
 // https://gpages.juszkiewicz.com.pl/syscalls-table/syscalls.html
 
 #define SYS_getcwd 17
+#define SYS_epoll_create1 20
+#define SYS_epoll_ctl 21
+#define SYS_epoll_pwait 22
+#define SYS_dup 23
+#define SYS_dup3 24
 #define SYS_fcntl 25
 #define SYS_ioctl 29
 #define SYS_mkdirat 34
@@ -52,13 +60,21 @@
 #define SYS_chdir 49
 #define SYS_openat 56
 #define SYS_close 57
+#define SYS_pipe2 59
 #define SYS_getdents64 61
 #define SYS_lseek 62
 #define SYS_read 63
 #define SYS_write 64
+#define SYS_readv 65
 #define SYS_writev 66
+#define SYS_pread64 67
+#define SYS_pwrite64 68
+#define SYS_preadv 69
+#define SYS_pwritev 70
+#define SYS_sendfile 71
 #define SYS_pselect6 72   // or sigsuspend?
 #define SYS_ppoll_time32 73
+#define SYS_splice 76
 #define SYS_readlinkat 78
 #define SYS_newfstatat 79
 #define SYS_newfstat 80
@@ -85,26 +101,48 @@
 #define SYS_prctl 167
 #define SYS_gettimeofday 169
 #define SYS_getpid 172
+#define SYS_getppid 173
 #define SYS_getuid 174
 #define SYS_geteuid 175
 #define SYS_getgid 176
 #define SYS_getegid 177
 #define SYS_gettid 178
 #define SYS_sysinfo 179
+#define SYS_socket 198
+#define SYS_socketpair 199
+#define SYS_bind 200
+#define SYS_listen 201
+#define SYS_accept 202
+#define SYS_connect 203
+#define SYS_getsockname 204
+#define SYS_getpeername 205
+#define SYS_sendto 206
+#define SYS_recvfrom 207
+#define SYS_setsockopt 208
+#define SYS_getsockopt 209
+#define SYS_shutdown 210
+#define SYS_sendmsg 211
+#define SYS_recvmsg 212
 #define SYS_brk 214
 #define SYS_munmap 215
 #define SYS_mremap 216
 #define SYS_clone 220
+#define SYS_execve 221
 #define SYS_mmap 222
 #define SYS_mprotect 226
+#define SYS_msync 227
 #define SYS_madvise 233
+#define SYS_accept4 242
 #define SYS_riscv_flush_icache 259 // not in docs; may be riscv only
+#define SYS_wait4 260
 #define SYS_prlimit64 261
 #define SYS_renameat2 276
 #define SYS_getrandom 278
+#define SYS_copy_file_range 285
 #define SYS_statx 291
 #define SYS_rseq 293
 #define SYS_clock_gettime64 403
+#define SYS_clone3 435
 
 // open apparently undefined for riscv? the old RISC-V64 g++ compiler/runtime uses these syscalls
 
@@ -777,3 +815,27 @@ struct linux_user_desc
         limit = swap_endian32( limit );
     }
 };
+
+struct linux_clone_args_syscall // for clone3. apps may pass a smaller, older version
+{
+    uint64_t flags;
+    uint64_t pidfd;
+    uint64_t child_tid;
+    uint64_t parent_tid;
+    uint64_t exit_signal;
+    uint64_t stack;
+    uint64_t stack_size;
+    uint64_t tls;
+
+    void swap_endianness()
+    {
+        flags = swap_endian64( flags );
+        pidfd = swap_endian64( pidfd );
+        child_tid = swap_endian64( child_tid );
+        parent_tid = swap_endian64( parent_tid );
+        exit_signal = swap_endian64( exit_signal );
+        stack = swap_endian64( stack );
+        stack_size = swap_endian64( stack_size );
+        tls = swap_endian64( tls );
+    }
+};
@@ -1,4 +1,4 @@
 @echo off
-cl /DARMOS /nologo armos.cxx arm64.cxx /I. /EHsc /DDEBUG /O2 /Oi /Fa /FAs /Qpar /Zi /link /OPT:REF user32.lib
+cl /DARMOS /nologo armos.cxx arm64.cxx arm64jit.cxx /I. /EHsc /DDEBUG /O2 /Oi /Fa /FAs /Qpar /Zi /link /OPT:REF user32.lib
 
 
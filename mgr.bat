@@ -2,6 +2,6 @@
 setlocal
 
 rem compile with -O3 not -Ofast so NaN works
-g++ -O3 -ggdb -fsigned-char -D ARMOS -D _MSC_VER armos.cxx arm64.cxx -I ../djl -D NDEBUG -o armosg.exe -static
+g++ -O3 -ggdb -fsigned-char -D ARMOS -D _MSC_VER armos.cxx arm64.cxx arm64jit.cxx -I ../djl -D NDEBUG -o armosg.exe -static
 
 
@@ -1,2 +1,2 @@
-g++ -DARMOS -O3 -DNDEBUG -fsigned-char -fno-builtin -I . armos.cxx arm64.cxx -o armos
+g++ -DARMOS -O3 -DNDEBUG -fsigned-char -fno-builtin -I . armos.cxx arm64.cxx arm64jit.cxx -o armos
 # cp armos /mnt/c/users/david/onedrive/armos/bin
@@ -1,2 +1,2 @@
-g++ -DARMOS -O3 -Wno-psabi -Wno-stringop-overflow -fsigned-char -fno-builtin -I . armos.cxx arm64.cxx -o armos -static
+g++ -DARMOS -O3 -Wno-psabi -Wno-stringop-overflow -fsigned-char -fno-builtin -I . armos.cxx arm64.cxx arm64jit.cxx -o armos -static -pthread
 # cp armos /mnt/c/users/david/onedrive/armos/bin
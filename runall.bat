@@ -20,7 +20,7 @@ set _folderlist=bin0 bin1 bin2 bin3 binfast
 set _applist=tcmp t e printint sieve simple tmuldiv tpi ts tarray tbits trw trw2 ^
              tmmap tstr tdir fileops ttime tm glob tap tsimplef tphi tf ttt td terrno ^
              t_setjmp tex mm tao pis ttypes nantst sleeptm tatomic lenum ^
-             tregex trename nqueens fopentst
+             tregex trename nqueens fopentst tauxv tnested tvdso tcrypto tlse
 
 ( for %%a in (%_applist%) do (
     echo %%a
@@ -0,0 +1,403 @@
+// runs the tests in runtests.txt across all host cores and compares each test's output, instruction count, and
+// elapsed time with the baseline from an earlier run. it's a parallel alternative to runall.sh / runall.bat.
+//
+// each line of the test list is a test command, relative to the repo root. {a,b,c} expands to one test per
+// alternative, like the shell's brace expansion. # starts a comment. tests of the same app run one at a time since
+// they may share temporary files; different apps run in parallel.
+//
+// build with: g++ -O2 runtests.cxx -o runtests -pthread (Windows: cl /nologo /EHsc /O2 runtests.cxx)
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+#include "djl_hash.hxx"
+
+#ifdef _WIN32
+    #define popen _popen
+    #define pclose _pclose
+#endif
+
+using namespace std;
+using namespace std::chrono;
+
+#define BASELINE_NAME "baseline_runtests.txt"
+#define FAILURES_NAME "runtests_failures.txt"
+
+struct TestResult
+{
+    string output;          // the app's output without the -p statistics
+    uint64_t hash;
+    uint64_t instructions;  // from -p. 0 when running natively
+    uint64_t ms;            // wall time measured here
+};
+
+struct BaselineEntry
+{
+    uint64_t hash;
+    uint64_t instructions;
+    uint64_t ms;
+};
+
+static void usage( const char * perror = 0 )
+{
+    if ( 0 != perror )
+        printf( "error: %s\n", perror );
+
+    printf( "usage: runtests [-b] [-j:N] [-r:cmd] [-s] [-t:P] [list]\n" );
+    printf( "  arguments:    [list]   file with the tests to run. default: runtests.txt\n" );
+    printf( "                -b       write %s from this run rather than comparing with it\n", BASELINE_NAME );
+    printf( "                -j:N     run N tests at once. default: the number of host cores\n" );
+    printf( "                -r:cmd   run tests with this command. default: armos. -r: runs them natively\n" );
+    printf( "                         e.g. -r:\"armos -h:200 bin/armos\" runs them nested\n" );
+    printf( "                -s       exit with 1 when tests are slower, not just when their output changed\n" );
+    printf( "                -t:P     flag tests whose instruction count or time grew by more than P percent. default: 25\n" );
+    printf( "  output of tests that fail is written to %s\n", FAILURES_NAME );
+    exit( 1 );
+} //usage
+
+static string render_number( uint64_t n )
+{
+    char ac[ 32 ];
+    snprintf( ac, sizeof( ac ), "%llu", (unsigned long long) n );
+    string digits( ac ), result;
+    for ( size_t i = 0; i < digits.size(); i++ )
+    {
+        if ( ( 0 != i ) && ( 0 == ( ( digits.size() - i ) % 3 ) ) )
+            result += ',';
+        result += digits[ i ];
+    }
+    return result;
+} //render_number
+
+static string trim( const string & s )
+{
+    size_t start = 0;
+    while ( ( start < s.size() ) && isspace( (unsigned char) s[ start ] ) )
+        start++;
+    size_t end = s.size();
+    while ( ( end > start ) && isspace( (unsigned char) s[ end - 1 ] ) )
+        end--;
+    return s.substr( start, end - start );
+} //trim
+
+static void expand_braces( const string & s, vector<string> & tests )
+{
+    // the first {a,b} group is expanded and the rest are handled recursively
+
+    size_t open = s.find( '{' );
+    size_t close = ( string::npos == open ) ? string::npos : s.find( '}', open );
+    if ( string::npos == close )
+    {
+        tests.push_back( s );
+        return;
+    }
+
+    string prefix = s.substr( 0, open );
+    string suffix = s.substr( close + 1 );
+    string alternatives = s.substr( open + 1, close - open - 1 );
+    size_t start = 0;
+    for ( ;; )
+    {
+        size_t comma = alternatives.find( ',', start );
+        expand_braces( prefix + alternatives.substr( start, comma - start ) + suffix, tests );
+        if ( string::npos == comma )
+            break;
+        start = comma + 1;
+    }
+} //expand_braces
+
+static bool read_test_list( const char * path, vector<string> & tests )
+{
+    FILE * fp = fopen( path, "r" );
+    if ( !fp )
+        return false;
+
+    char line[ 1024 ];
+    while ( fgets( line, sizeof( line ), fp ) )
+    {
+        char * comment = strchr( line, '#' );
+        if ( comment )
+            *comment = 0;
+        string test = trim( line );
+        if ( !test.empty() )
+            expand_braces( test, tests );
+    }
+
+    fclose( fp );
+    return true;
+} //read_test_list
+
+static string app_of( const string & test )
+{
+    // the app's file name, which tests that might share temporary files have in common
+
+    string app = test.substr( 0, test.find( ' ' ) );
+    size_t slash = app.find_last_of( "/\\" );
+    return ( string::npos == slash ) ? app : app.substr( slash + 1 );
+} //app_of
+
+static string with_statistics( const string & runner )
+{
+    // -p goes right after the outer emulator's name, so nested runs report the outer emulator's instructions
+
+    if ( runner.empty() )
+        return runner;
+    size_t space = runner.find( ' ' );
+    if ( string::npos == space )
+        return runner + " -p";
+    return runner.substr( 0, space ) + " -p" + runner.substr( space );
+} //with_statistics
+
+static void split_statistics( const string & all, TestResult & result )
+{
+    // armos -p appends its statistics after the app's output starting with this line
+
+    const char * marker = "elapsed milliseconds:";
+    size_t stats = string::npos;
+    for ( size_t pos = all.find( marker ); string::npos != pos; pos = all.find( marker, pos + 1 ) )
+        if ( ( 0 == pos ) || ( '\n' == all[ pos - 1 ] ) )
+            stats = pos;
+
+    result.output = all.substr( 0, stats );
+    result.instructions = 0;
+    if ( string::npos != stats )
+    {
+        size_t line = all.find( "\ninstructions:", stats );
+        if ( string::npos != line )
+        {
+            for ( size_t i = line + 14; ( i < all.size() ) && ( '\n' != all[ i ] ); i++ )
+                if ( isdigit( (unsigned char) all[ i ] ) )
+                    result.instructions = result.instructions * 10 + ( all[ i ] - '0' );
+        }
+    }
+
+    result.hash = fnv1a( result.output.data(), result.output.size() );
+} //split_statistics
+
+static void run_test( const string & runner, const string & test, TestResult & result )
+{
+    string command = ( runner.empty() ? test : ( runner + " " + test ) ) + " 2>&1"; // errors are part of the output
+#ifdef _WIN32
+    for ( size_t i = 0; i < command.size(); i++ ) // the shell wants backslashes in the app's path
+        if ( '/' == command[ i ] )
+            command[ i ] = '\\';
+#endif
+
+    string all;
+    high_resolution_clock::time_point tStart = high_resolution_clock::now();
+    FILE * fp = popen( command.c_str(), "r" );
+    if ( fp )
+    {
+        char buffer[ 4096 ];
+        size_t len;
+        while ( 0 != ( len = fread( buffer, 1, sizeof( buffer ), fp ) ) )
+            all.append( buffer, len );
+        pclose( fp );
+    }
+    else
+        all = "can't run " + command + "\n";
+
+    result.ms = duration_cast<std::chrono::milliseconds>( high_resolution_clock::now() - tStart ).count();
+    split_statistics( all, result );
+} //run_test
+
+static bool read_baseline( map<string, BaselineEntry> & baseline )
+{
+    // each line is: hash instructions milliseconds test
+
+    FILE * fp = fopen( BASELINE_NAME, "r" );
+    if ( !fp )
+        return false;
+
+    char line[ 1200 ];
+    while ( fgets( line, sizeof( line ), fp ) )
+    {
+        unsigned long long hash, instructions, ms;
+        int used = 0;
+        if ( 3 == sscanf( line, "%llx %llu %llu %n", &hash, &instructions, &ms, &used ) )
+        {
+            BaselineEntry & e = baseline[ trim( line + used ) ];
+            e.hash = hash;
+            e.instructions = instructions;
+            e.ms = ms;
+        }
+    }
+
+    fclose( fp );
+    return true;
+} //read_baseline
+
+static bool grew( uint64_t now, uint64_t before, uint64_t percent, uint64_t noise )
+{
+    return ( now > ( before + noise ) ) && ( ( ( now - before ) * 100 ) > ( before * percent ) );
+} //grew
+
+int main( int argc, char * argv[] )
+{
+    const char * list = "runtests.txt";
+    string runner = "armos";
+    bool make_baseline = false;
+    bool slower_fails = false;
+    uint64_t threshold = 25;
+    unsigned jobs = thread::hardware_concurrency();
+
+    for ( int i = 1; i < argc; i++ )
+    {
+        const char * parg = argv[ i ];
+        if ( '-' == parg[ 0 ] )
+        {
+            char ca = (char) tolower( parg[ 1 ] );
+            if ( 'b' == ca )
+                make_baseline = true;
+            else if ( 'j' == ca && ':' == parg[ 2 ] )
+                jobs = (unsigned) atoi( parg + 3 );
+            else if ( 'r' == ca && ':' == parg[ 2 ] )
+                runner = parg + 3;
+            else if ( 's' == ca )
+                slower_fails = true;
+            else if ( 't' == ca && ':' == parg[ 2 ] )
+                threshold = strtoull( parg + 3, 0, 10 );
+            else
+                usage( "unknown argument" );
+        }
+        else
+            list = parg;
+    }
+
+    if ( 0 == jobs )
+        jobs = 1;
+
+    vector<string> tests;
+    if ( !read_test_list( list, tests ) )
+        usage( "can't read the test list" );
+
+    map<string, BaselineEntry> baseline;
+    if ( !make_baseline && !read_baseline( baseline ) )
+        printf( "there's no %s, so every test is new. make one on this machine with -b\n", BASELINE_NAME );
+
+    // tests are grouped by app. the groups that took longest in the baseline start first so they don't finish last
+
+    map<string, vector<size_t>> by_app;
+    for ( size_t i = 0; i < tests.size(); i++ )
+        by_app[ app_of( tests[ i ] ) ].push_back( i );
+
+    vector<pair<uint64_t, vector<size_t>>> groups;
+    for ( map<string, vector<size_t>>::iterator it = by_app.begin(); it != by_app.end(); it++ )
+    {
+        uint64_t ms = 0;
+        for ( size_t i = 0; i < it->second.size(); i++ )
+        {
+            map<string, BaselineEntry>::iterator b = baseline.find( tests[ it->second[ i ] ] );
+            if ( b != baseline.end() )
+                ms += b->second.ms;
+        }
+        groups.push_back( make_pair( ms, it->second ) );
+    }
+    stable_sort( groups.begin(), groups.end(), []( const pair<uint64_t, vector<size_t>> & a, const pair<uint64_t, vector<size_t>> & b ) { return a.first > b.first; } );
+
+    jobs = (unsigned) min( (size_t) jobs, groups.size() );
+    printf( "running %zu tests, %u at a time\n", tests.size(), jobs );
+    fflush( stdout );
+
+    string command = with_statistics( runner );
+    vector<TestResult> results( tests.size() );
+    atomic<size_t> next_group( 0 );
+    high_resolution_clock::time_point tStart = high_resolution_clock::now();
+
+    vector<thread> workers;
+    for ( unsigned w = 0; w < jobs; w++ )
+        workers.push_back( thread( [&]
+        {
+            for ( size_t g = next_group++; g < groups.size(); g = next_group++ )
+                for ( size_t i = 0; i < groups[ g ].second.size(); i++ )
+                {
+                    size_t t = groups[ g ].second[ i ];
+                    run_test( command, tests[ t ], results[ t ] );
+                }
+        } ) );
+
+    for ( size_t w = 0; w < workers.size(); w++ )
+        workers[ w ].join();
+
+    uint64_t elapsed = duration_cast<std::chrono::milliseconds>( high_resolution_clock::now() - tStart ).count();
+    uint64_t test_ms = 0;
+    for ( size_t i = 0; i < results.size(); i++ )
+        test_ms += results[ i ].ms;
+
+    if ( make_baseline )
+    {
+        FILE * fp = fopen( BASELINE_NAME, "w" );
+        if ( !fp )
+        {
+            printf( "can't write %s\n", BASELINE_NAME );
+            return 1;
+        }
+
+        for ( size_t i = 0; i < tests.size(); i++ )
+            fprintf( fp, "%016llx %llu %llu %s\n", (unsigned long long) results[ i ].hash, (unsigned long long) results[ i ].instructions,
+                     (unsigned long long) results[ i ].ms, tests[ i ].c_str() );
+        fclose( fp );
+        printf( "wrote %s with %zu tests in %s ms (%s ms of test time)\n", BASELINE_NAME, tests.size(),
+                render_number( elapsed ).c_str(), render_number( test_ms ).c_str() );
+        return 0;
+    }
+
+    size_t failed = 0, slower = 0, added = 0;
+    FILE * fp_failures = 0;
+
+    for ( size_t i = 0; i < tests.size(); i++ )
+    {
+        TestResult & r = results[ i ];
+        map<string, BaselineEntry>::iterator b = baseline.find( tests[ i ] );
+        if ( b == baseline.end() )
+        {
+            printf( "new     %s\n", tests[ i ].c_str() );
+            added++;
+            continue;
+        }
+
+        const BaselineEntry & e = b->second;
+        if ( r.hash != e.hash )
+        {
+            printf( "FAIL    %s\n", tests[ i ].c_str() );
+            failed++;
+            if ( 0 == fp_failures )
+                fp_failures = fopen( FAILURES_NAME, "w" );
+            if ( fp_failures )
+                fprintf( fp_failures, "%s\n%s", tests[ i ].c_str(), r.output.c_str() );
+        }
+
+        // instruction counts are exact. times are noisy, so small tests get some slack
+
+        bool more_instructions = ( 0 != e.instructions ) && grew( r.instructions, e.instructions, threshold, 0 );
+        bool more_time = grew( r.ms, e.ms, threshold, 50 );
+        if ( more_instructions || more_time )
+        {
+            printf( "slower  %s: instructions %s -> %s, ms %s -> %s\n", tests[ i ].c_str(), render_number( e.instructions ).c_str(),
+                    render_number( r.instructions ).c_str(), render_number( e.ms ).c_str(), render_number( r.ms ).c_str() );
+            slower++;
+        }
+    }
+
+    if ( fp_failures )
+        fclose( fp_failures );
+
+    printf( "%zu tests: %zu failed, %zu slower, %zu not in %s. %s ms elapsed, %s ms of test time\n", tests.size(), failed, slower,
+            added, BASELINE_NAME, render_number( elapsed ).c_str(), render_number( test_ms ).c_str() );
+    if ( 0 != failed )
+        printf( "the output of failed tests is in %s\n", FAILURES_NAME );
+
+    // times vary from run to run, so only changed output fails unless -s is given
+
+    return ( ( 0 == failed ) && ( !slower_fails || ( 0 == slower ) ) ) ? 0 : 1;
+} //main
@@ -0,0 +1,78 @@
+// floating point kernels like c_tests/benchmarks/fpkernel.c: saxpy, a dot product, a matrix multiply, and a stencil.
+// an iteration scale can be passed as the first argument
+
+const N: usize = 4096;
+const M: usize = 64;
+
+fn saxpy( alpha: f32, x: &[f32], y: &mut [f32] )
+{
+    for ( yi, xi ) in y.iter_mut().zip( x.iter() ) {
+        *yi = alpha * *xi + *yi;
+    }
+} //saxpy
+
+fn dot( x: &[f64], y: &[f64] ) -> f64
+{
+    x.iter().zip( y.iter() ).map( | ( a, b ) | a * b ).sum()
+} //dot
+
+fn matmul( a: &[f64], b: &[f64], c: &mut [f64] )
+{
+    for v in c.iter_mut() {
+        *v = 0.0;
+    }
+
+    for i in 0..M {
+        for k in 0..M {
+            let aik = a[ i * M + k ];
+            for j in 0..M {
+                c[ i * M + j ] += aik * b[ k * M + j ];
+            }
+        }
+    }
+} //matmul
+
+fn stencil( input: &[f64], output: &mut [f64] )
+{
+    for i in 1..input.len() - 1 {
+        output[ i ] = 0.25 * input[ i - 1 ] + 0.5 * input[ i ] + 0.25 * input[ i + 1 ];
+    }
+} //stencil
+
+fn main()
+{
+    let args: Vec<String> = std::env::args().collect();
+    let scale: usize = if args.len() > 1 { args[ 1 ].parse().unwrap_or( 1 ) } else { 1 };
+
+    let xf: Vec<f32> = ( 0..N ).map( | i | ( i % 17 ) as f32 * 0.125 ).collect();
+    let mut yf: Vec<f32> = ( 0..N ).map( | i | ( i % 13 ) as f32 * 0.25 ).collect();
+    let mut s0: Vec<f64> = ( 0..N ).map( | i | ( i as f64 * 0.01 ).sin() ).collect();
+    let mut s1 = vec![ 0.0f64; N ];
+    let a: Vec<f64> = ( 0..M * M ).map( | x | ( ( ( x / M ) * ( x % M ) ) % 7 ) as f64 - 3.0 ).collect();
+    let b: Vec<f64> = ( 0..M * M ).map( | x | ( ( ( x / M ) + ( x % M ) ) % 5 ) as f64 * 0.5 ).collect();
+    let mut c = vec![ 0.0f64; M * M ];
+
+    for _ in 0..200 * scale {
+        saxpy( 1.0001, &xf, &mut yf );
+    }
+
+    let mut d = 0.0;
+    for _ in 0..200 * scale {
+        d += dot( &s0, &s0 );
+    }
+
+    for _ in 0..10 * scale {
+        matmul( &a, &b, &mut c );
+    }
+
+    for _ in 0..100 * scale {
+        stencil( &s0, &mut s1 );
+        stencil( &s1, &mut s0 );
+    }
+
+    let ysum: f64 = yf.iter().map( | v | *v as f64 ).sum();
+    let csum: f64 = c.iter().sum();
+    let ssum: f64 = s0.iter().sum();
+    println!( "saxpy {:.6e} dot {:.6e} matmul {:.6e} stencil {:.6e}", ysum, d, csum, ssum );
+    println!( "fpkernel completed with great success" );
+} //main
@@ -0,0 +1,11 @@
+#!/bin/bash
+
+# builds the Rust benchmarks at opt-level 3 into bin. c_tests/benchmarks/run.sh runs them
+
+mkdir bin 2>/dev/null
+
+for arg in sieve fpkernel;
+do
+    echo $arg
+    rustc --edition 2021 --out-dir bin -C overflow-checks=off -C opt-level=3 -C target-feature=+crt-static "$arg".rs
+done
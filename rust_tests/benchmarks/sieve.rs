@@ -0,0 +1,35 @@
+// the Byte sieve like c_tests/sieve.c, but with more passes so it runs long enough to time.
+// the pass count can be passed as the first argument
+
+const SIZE: usize = 8190;
+
+fn main()
+{
+    let args: Vec<String> = std::env::args().collect();
+    let passes: usize = if args.len() > 1 { args[ 1 ].parse().unwrap_or( 1000 ) } else { 1000 };
+
+    let mut flags = vec![ true; SIZE + 1 ];
+    let mut count = 0;
+
+    for _ in 0..passes {
+        count = 0;
+        for f in flags.iter_mut() {
+            *f = true;
+        }
+
+        for i in 0..=SIZE {
+            if flags[ i ] {
+                let prime = i + i + 3;
+                let mut k = i + prime;
+                while k <= SIZE {
+                    flags[ k ] = false;
+                    k += prime;
+                }
+                count += 1;
+            }
+        }
+    }
+
+    println!( "{} primes", count );
+    println!( "sieve completed with great success" );
+} //main